@@ -0,0 +1,121 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ADSBSpatialGrid.h"
+
+#include <QtPositioning/QGeoCoordinate>
+#include <QtPositioning/QGeoRectangle>
+
+#include <cmath>
+
+ADSBSpatialGrid::ADSBSpatialGrid(double cellSizeDegrees)
+    : _cellSize(cellSizeDegrees)
+    , _rows(static_cast<int>(std::ceil(180.0 / cellSizeDegrees)))
+    , _columns(static_cast<int>(std::ceil(360.0 / cellSizeDegrees)))
+{
+
+}
+
+int ADSBSpatialGrid::_row(double latitude) const
+{
+    return qBound(0, static_cast<int>(std::floor((latitude + 90.0) / _cellSize)), _rows - 1);
+}
+
+int ADSBSpatialGrid::_column(double longitude) const
+{
+    return qBound(0, static_cast<int>(std::floor((longitude + 180.0) / _cellSize)), _columns - 1);
+}
+
+void ADSBSpatialGrid::update(uint32_t icaoAddress, const QGeoCoordinate &coordinate)
+{
+    const int key = _key(_row(coordinate.latitude()), _column(coordinate.longitude()));
+
+    const auto it = _cellOf.find(icaoAddress);
+    if (it != _cellOf.end()) {
+        if (it.value() == key) {
+            return;
+        }
+        const auto cell = _cells.find(it.value());
+        (void) cell.value().removeOne(icaoAddress);
+        if (cell.value().isEmpty()) {
+            (void) _cells.erase(cell);
+        }
+        it.value() = key;
+    } else {
+        (void) _cellOf.insert(icaoAddress, key);
+    }
+
+    _cells[key].append(icaoAddress);
+}
+
+void ADSBSpatialGrid::remove(uint32_t icaoAddress)
+{
+    const auto it = _cellOf.constFind(icaoAddress);
+    if (it == _cellOf.constEnd()) {
+        return;
+    }
+
+    const auto cell = _cells.find(it.value());
+    (void) cell.value().removeOne(icaoAddress);
+    if (cell.value().isEmpty()) {
+        (void) _cells.erase(cell);
+    }
+    (void) _cellOf.erase(it);
+}
+
+void ADSBSpatialGrid::clear()
+{
+    _cells.clear();
+    _cellOf.clear();
+}
+
+void ADSBSpatialGrid::query(const QGeoRectangle &region, QList<uint32_t> &icaoAddresses) const
+{
+    if (!region.isValid() || _cells.isEmpty()) {
+        return;
+    }
+
+    const int firstRow = _row(region.bottomLeft().latitude());
+    const int lastRow = _row(region.topRight().latitude());
+    const int firstColumn = _column(region.topLeft().longitude());
+    const int lastColumn = _column(region.bottomRight().longitude());
+
+    if (region.topLeft().longitude() > region.bottomRight().longitude()) {
+        // Crosses the antimeridian
+        _appendCells(firstRow, lastRow, firstColumn, _columns - 1, icaoAddresses);
+        _appendCells(firstRow, lastRow, 0, lastColumn, icaoAddresses);
+    } else {
+        _appendCells(firstRow, lastRow, firstColumn, lastColumn, icaoAddresses);
+    }
+}
+
+void ADSBSpatialGrid::_appendCells(int firstRow, int lastRow, int firstColumn, int lastColumn, QList<uint32_t> &icaoAddresses) const
+{
+    // Large regions cover more cells than there are occupied ones
+    const qsizetype regionCells = static_cast<qsizetype>(lastRow - firstRow + 1) * (lastColumn - firstColumn + 1);
+    if (regionCells > _cells.count()) {
+        for (auto it = _cells.constBegin(); it != _cells.constEnd(); ++it) {
+            const int row = it.key() / _columns;
+            const int column = it.key() % _columns;
+            if ((row >= firstRow) && (row <= lastRow) && (column >= firstColumn) && (column <= lastColumn)) {
+                icaoAddresses.append(it.value());
+            }
+        }
+        return;
+    }
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            const auto it = _cells.constFind(_key(row, column));
+            if (it != _cells.constEnd()) {
+                icaoAddresses.append(it.value());
+            }
+        }
+    }
+}
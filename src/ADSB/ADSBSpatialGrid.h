@@ -0,0 +1,47 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+
+class QGeoCoordinate;
+class QGeoRectangle;
+
+/// Buckets aircraft by ICAO address into fixed size latitude/longitude cells so the ones
+/// inside a region can be found without looking at every aircraft.
+class ADSBSpatialGrid
+{
+public:
+    explicit ADSBSpatialGrid(double cellSizeDegrees = 1.0);
+
+    /// Adds an aircraft or moves it to the cell of its new position
+    void update(uint32_t icaoAddress, const QGeoCoordinate &coordinate);
+    void remove(uint32_t icaoAddress);
+    void clear();
+
+    /// Appends all aircraft in cells overlapping @p region, which may span the antimeridian.
+    /// Aircraft near the border of the region can be outside of it.
+    void query(const QGeoRectangle &region, QList<uint32_t> &icaoAddresses) const;
+
+    qsizetype count() const { return _cellOf.count(); }
+
+private:
+    int _row(double latitude) const;
+    int _column(double longitude) const;
+    int _key(int row, int column) const { return (row * _columns) + column; }
+    void _appendCells(int firstRow, int lastRow, int firstColumn, int lastColumn, QList<uint32_t> &icaoAddresses) const;
+
+    double _cellSize = 1.0;
+    int _rows = 0;
+    int _columns = 0;
+    QHash<int, QList<uint32_t>> _cells;
+    QHash<uint32_t, int> _cellOf;
+};
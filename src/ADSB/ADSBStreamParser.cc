@@ -0,0 +1,506 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ADSBStreamParser.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QtMath>
+
+#include <array>
+#include <cmath>
+
+QGC_LOGGING_CATEGORY(ADSBStreamParserLog, "ADSB.ADSBStreamParser")
+
+namespace {
+    constexpr double kFeetToMeters = 0.3048;
+    constexpr double kKnotsToMetersPerSecond = 0.514444;
+    constexpr double kFeetPerMinuteToMetersPerSecond = 0.00508;
+
+    constexpr uint32_t kModeSPolynomial = 0xFFF409;
+
+    constexpr std::array<uint32_t, 256> makeModeSCrcTable()
+    {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t byte = 0; byte < 256; byte++) {
+            uint32_t crc = byte << 16;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x800000) ? ((crc << 1) ^ kModeSPolynomial) : (crc << 1);
+            }
+            table[byte] = crc & 0xFFFFFF;
+        }
+        return table;
+    }
+
+    constexpr std::array<uint32_t, 256> kModeSCrcTable = makeModeSCrcTable();
+
+    /// Field of the 56 bit ME block, bits are numbered 1..56 from the most significant one as in DO-260B
+    inline uint32_t meField(uint64_t me, int firstBit, int bitCount)
+    {
+        return static_cast<uint32_t>((me >> (56 - (firstBit + bitCount - 1))) & ((1ULL << bitCount) - 1));
+    }
+
+    /// Number of CPR longitude zones for a latitude
+    int cprNL(double lat)
+    {
+        lat = std::fabs(lat);
+        if (lat < 1e-9) {
+            return 59;
+        } else if (lat > 87.0) {
+            return 1;
+        } else if (lat == 87.0) {
+            return 2;
+        }
+
+        constexpr double nz = 15.0;
+        const double a = 1.0 - std::cos(M_PI / (2.0 * nz));
+        const double b = std::cos(qDegreesToRadians(lat));
+        return static_cast<int>(std::floor(2.0 * M_PI / std::acos(1.0 - (a / (b * b)))));
+    }
+
+    /// Modulo which is always positive
+    inline double cprMod(double a, double b)
+    {
+        const double result = std::fmod(a, b);
+        return (result < 0) ? (result + b) : result;
+    }
+
+    /// Globally unambiguous airborne position from an even and an odd frame
+    bool cprGlobalDecode(int latEven, int lonEven, int latOdd, int lonOdd, bool oddIsNewest, double &lat, double &lon)
+    {
+        constexpr double scale = 131072.0;  // 2^17
+        constexpr double dLatEven = 360.0 / 60.0;
+        constexpr double dLatOdd = 360.0 / 59.0;
+
+        const double yzEven = latEven / scale;
+        const double yzOdd = latOdd / scale;
+        const double xzEven = lonEven / scale;
+        const double xzOdd = lonOdd / scale;
+
+        const double j = std::floor((59.0 * yzEven) - (60.0 * yzOdd) + 0.5);
+        double rlatEven = dLatEven * (cprMod(j, 60.0) + yzEven);
+        double rlatOdd = dLatOdd * (cprMod(j, 59.0) + yzOdd);
+        if (rlatEven >= 270.0) {
+            rlatEven -= 360.0;
+        }
+        if (rlatOdd >= 270.0) {
+            rlatOdd -= 360.0;
+        }
+
+        if ((rlatEven < -90.0) || (rlatEven > 90.0) || (rlatOdd < -90.0) || (rlatOdd > 90.0)) {
+            return false;
+        }
+
+        // Both frames have to lie in the same longitude zone
+        const int nl = cprNL(rlatEven);
+        if (nl != cprNL(rlatOdd)) {
+            return false;
+        }
+
+        const double m = std::floor((xzEven * (nl - 1)) - (xzOdd * nl) + 0.5);
+        if (oddIsNewest) {
+            const int ni = qMax(nl - 1, 1);
+            lat = rlatOdd;
+            lon = (360.0 / ni) * (cprMod(m, ni) + xzOdd);
+        } else {
+            const int ni = qMax(nl, 1);
+            lat = rlatEven;
+            lon = (360.0 / ni) * (cprMod(m, ni) + xzEven);
+        }
+
+        if (lon >= 180.0) {
+            lon -= 360.0;
+        }
+
+        return true;
+    }
+
+    /// Altitude in feet from the 12 bit AC field of an airborne position, only 25 ft increments are supported
+    bool decodeAltitude(uint32_t altitudeCode, int &altitudeFeet)
+    {
+        constexpr uint32_t qBit = 0x010;
+        if (!(altitudeCode & qBit)) {
+            return false;
+        }
+
+        const uint32_t n = ((altitudeCode & 0xFE0) >> 1) | (altitudeCode & 0x00F);
+        altitudeFeet = (static_cast<int>(n) * 25) - 1000;
+        return true;
+    }
+
+    /// SBS-1 lines have 22 comma separated fields
+    constexpr int kSbsMaxFields = 22;
+
+    int splitSbsFields(QByteArrayView line, std::array<QByteArrayView, kSbsMaxFields> &fields)
+    {
+        int count = 0;
+        qsizetype start = 0;
+        while (count < kSbsMaxFields) {
+            const qsizetype comma = line.indexOf(',', start);
+            if (comma < 0) {
+                fields[count++] = line.sliced(start);
+                break;
+            }
+            fields[count++] = line.sliced(start, comma - start);
+            start = comma + 1;
+        }
+        return count;
+    }
+}
+
+ADSBStreamParser::ADSBStreamParser()
+{
+    _clock.start();
+}
+
+void ADSBStreamParser::clear()
+{
+    _cpr.clear();
+}
+
+qsizetype ADSBStreamParser::parse(QByteArrayView data, QList<ADSB::VehicleInfo_t> &updates)
+{
+    qsizetype pos = 0;
+    while (pos < data.size()) {
+        if (static_cast<uint8_t>(data.at(pos)) == kBeastEscape) {
+            const qsizetype consumed = _parseBeastFrame(data.sliced(pos), updates);
+            if (consumed == 0) {
+                break;
+            }
+            pos += consumed;
+            continue;
+        }
+
+        // SBS-1 text, a Beast escape also ends the line to resynchronize on binary streams
+        qsizetype end = pos;
+        while ((end < data.size()) && (data.at(end) != '\n') && (static_cast<uint8_t>(data.at(end)) != kBeastEscape)) {
+            end++;
+        }
+
+        if (end == data.size()) {
+            if ((end - pos) > kMaxLineLength) {
+                qCDebug(ADSBStreamParserLog) << "Dropping" << (end - pos) << "bytes without line terminator";
+                pos = end;
+            }
+            break;
+        }
+
+        if (data.at(end) == '\n') {
+            QByteArrayView line = data.sliced(pos, end - pos);
+            if (line.endsWith('\r')) {
+                line.chop(1);
+            }
+
+            ADSB::VehicleInfo_t vehicleInfo;
+            if (parseSbsLine(line, vehicleInfo)) {
+                updates.append(vehicleInfo);
+            }
+            _messageCount++;
+            pos = end + 1;
+        } else {
+            pos = end;
+        }
+    }
+
+    return pos;
+}
+
+qsizetype ADSBStreamParser::_parseBeastFrame(QByteArrayView data, QList<ADSB::VehicleInfo_t> &updates)
+{
+    if (data.size() < 2) {
+        return 0;
+    }
+
+    int messageBytes = 0;
+    switch (data.at(1)) {
+    case '1':
+        messageBytes = 2;   // Mode A/C
+        break;
+    case '2':
+        messageBytes = 7;   // Mode S short
+        break;
+    case '3':
+        messageBytes = kModeSLongBytes;
+        break;
+    default:
+        // Not a frame start (or a doubled escape out of sync), skip the escape byte
+        return 1;
+    }
+
+    // 6 byte timestamp, 1 byte signal level, message. Every 0x1A in there is doubled.
+    constexpr int headerBytes = 7;
+    std::array<uint8_t, headerBytes + kModeSLongBytes> frame{};
+    const int frameBytes = headerBytes + messageBytes;
+
+    qsizetype pos = 2;
+    for (int i = 0; i < frameBytes; i++) {
+        if (pos >= data.size()) {
+            return 0;
+        }
+        const uint8_t byte = static_cast<uint8_t>(data.at(pos));
+        if (byte == kBeastEscape) {
+            if ((pos + 1) >= data.size()) {
+                return 0;
+            }
+            if (static_cast<uint8_t>(data.at(pos + 1)) != kBeastEscape) {
+                // Start of the next frame, this one is truncated
+                return pos;
+            }
+            pos++;
+        }
+        frame[i] = byte;
+        pos++;
+    }
+
+    _messageCount++;
+
+    if (messageBytes == kModeSLongBytes) {
+        ADSB::VehicleInfo_t vehicleInfo;
+        if (parseModeS(frame.data() + headerBytes, vehicleInfo)) {
+            updates.append(vehicleInfo);
+        }
+    }
+
+    return pos;
+}
+
+uint32_t ADSBStreamParser::modeSChecksum(const uint8_t *message, int bytes)
+{
+    uint32_t crc = 0;
+    for (int i = 0; i < (bytes - 3); i++) {
+        crc = ((crc << 8) ^ kModeSCrcTable[((crc >> 16) ^ message[i]) & 0xFF]) & 0xFFFFFF;
+    }
+
+    const uint32_t parity = (static_cast<uint32_t>(message[bytes - 3]) << 16) | (static_cast<uint32_t>(message[bytes - 2]) << 8) | message[bytes - 1];
+    return crc ^ parity;
+}
+
+bool ADSBStreamParser::parseModeS(const uint8_t *message, ADSB::VehicleInfo_t &vehicleInfo)
+{
+    const uint8_t df = message[0] >> 3;
+    const uint8_t ca = message[0] & 0x07;
+    // DF17 from transponders, DF18 with an ICAO address from non-transponder devices. Other formats
+    // have the address folded into the parity and need a list of known aircraft to be trusted.
+    if ((df != 17) && !((df == 18) && (ca == 0))) {
+        return false;
+    }
+
+    if (modeSChecksum(message, kModeSLongBytes) != 0) {
+        return false;
+    }
+
+    const uint32_t icaoAddress = (static_cast<uint32_t>(message[1]) << 16) | (static_cast<uint32_t>(message[2]) << 8) | message[3];
+
+    uint64_t me = 0;
+    for (int i = 4; i < 11; i++) {
+        me = (me << 8) | message[i];
+    }
+    const uint32_t typeCode = meField(me, 1, 5);
+
+    vehicleInfo.icaoAddress = icaoAddress;
+
+    if ((typeCode >= 1) && (typeCode <= 4)) {
+        static constexpr char charset[] = "#ABCDEFGHIJKLMNOPQRSTUVWXYZ##### ###############0123456789######";
+        char callsign[8];
+        for (int i = 0; i < 8; i++) {
+            callsign[i] = charset[meField(me, 9 + (i * 6), 6)];
+        }
+
+        int length = 8;
+        while ((length > 0) && ((callsign[length - 1] == ' ') || (callsign[length - 1] == '#'))) {
+            length--;
+        }
+        if (length == 0) {
+            return false;
+        }
+
+        vehicleInfo.callsign = QString::fromLatin1(callsign, length);
+        vehicleInfo.availableFlags = ADSB::CallsignAvailable;
+        return true;
+    }
+
+    if ((typeCode >= 9) && (typeCode <= 18)) {
+        int altitudeFeet = 0;
+        if (decodeAltitude(meField(me, 9, 12), altitudeFeet)) {
+            vehicleInfo.location.setAltitude(altitudeFeet * kFeetToMeters);
+            vehicleInfo.baro = true;
+            vehicleInfo.availableFlags |= ADSB::AltitudeAvailable;
+        }
+
+        const bool odd = meField(me, 22, 1);
+        const qint64 now = _clock.elapsed();
+
+        CprState &state = _cpr[icaoAddress];
+        CprFrame &frame = odd ? state.odd : state.even;
+        frame.lat = static_cast<int>(meField(me, 23, 17));
+        frame.lon = static_cast<int>(meField(me, 40, 17));
+        frame.timeMs = now;
+
+        const CprFrame &other = odd ? state.even : state.odd;
+        if ((other.timeMs >= 0) && ((now - other.timeMs) <= kMaxCprPairAgeMs)) {
+            double lat = 0.;
+            double lon = 0.;
+            if (cprGlobalDecode(state.even.lat, state.even.lon, state.odd.lat, state.odd.lon, odd, lat, lon)) {
+                vehicleInfo.location.setLatitude(lat);
+                vehicleInfo.location.setLongitude(lon);
+                vehicleInfo.availableFlags |= ADSB::LocationAvailable;
+            }
+        }
+
+        return (vehicleInfo.availableFlags != ADSB::AvailableInfoTypes());
+    }
+
+    if (typeCode == 19) {
+        const uint32_t subType = meField(me, 6, 3);
+        if ((subType != 1) && (subType != 2)) {
+            // Airspeed subtypes need a heading source, not used
+            return false;
+        }
+
+        const uint32_t vew = meField(me, 15, 10);
+        const uint32_t vns = meField(me, 26, 10);
+        if ((vew != 0) && (vns != 0)) {
+            const int multiplier = (subType == 2) ? 4 : 1;
+            const double east = (meField(me, 14, 1) ? -1.0 : 1.0) * static_cast<double>(vew - 1) * multiplier;
+            const double north = (meField(me, 25, 1) ? -1.0 : 1.0) * static_cast<double>(vns - 1) * multiplier;
+
+            double heading = qRadiansToDegrees(std::atan2(east, north));
+            if (heading < 0.0) {
+                heading += 360.0;
+            }
+
+            vehicleInfo.heading = heading;
+            vehicleInfo.velocity = std::hypot(east, north) * kKnotsToMetersPerSecond;
+            vehicleInfo.availableFlags |= ADSB::HeadingAvailable | ADSB::VelocityAvailable;
+        }
+
+        const uint32_t verticalRate = meField(me, 38, 9);
+        if (verticalRate != 0) {
+            const double feetPerMinute = (meField(me, 37, 1) ? -1.0 : 1.0) * static_cast<double>(verticalRate - 1) * 64.0;
+            vehicleInfo.verticalVel = feetPerMinute * kFeetPerMinuteToMetersPerSecond;
+            vehicleInfo.availableFlags |= ADSB::VerticalVelAvailable;
+        }
+
+        return (vehicleInfo.availableFlags != ADSB::AvailableInfoTypes());
+    }
+
+    return false;
+}
+
+bool ADSBStreamParser::parseSbsLine(QByteArrayView line, ADSB::VehicleInfo_t &vehicleInfo)
+{
+    if ((line.size() <= 4) || !line.startsWith("MSG")) {
+        return false;
+    }
+
+    const char typeChar = line.at(4);
+    if ((typeChar < '0') || (typeChar > '9')) {
+        return false;
+    }
+    const int msgType = typeChar - '0';
+
+    // Skip unsupported message types to avoid parsing
+    if ((msgType == ADSB::SurfacePosition) || (msgType > ADSB::SurveillanceId)) {
+        return false;
+    }
+
+    std::array<QByteArrayView, kSbsMaxFields> values;
+    const int valueCount = splitSbsFields(line, values);
+    if (valueCount <= 4) {
+        return false;
+    }
+
+    bool icaoOk = false;
+    const uint32_t icaoAddress = values[4].toUInt(&icaoOk, 16);
+    if (!icaoOk) {
+        return false;
+    }
+
+    vehicleInfo.icaoAddress = icaoAddress;
+
+    switch (msgType) {
+    case ADSB::IdentificationAndCategory:
+    case ADSB::SurveillanceAltitude:
+    case ADSB::SurveillanceId: {
+        if (valueCount <= 10) {
+            return false;
+        }
+
+        const QByteArrayView callsign = values[10].trimmed();
+        if (callsign.isEmpty()) {
+            return false;
+        }
+
+        vehicleInfo.callsign = QString::fromLatin1(callsign);
+        vehicleInfo.availableFlags = ADSB::CallsignAvailable;
+        return true;
+    }
+    case ADSB::AirbornePosition: {
+        if (valueCount <= 19) {
+            return false;
+        }
+
+        // Altitude is either Barometric - based on pressure, in ft
+        // or HAE - as reported by GPS - based on WGS84 Ellipsoid, in ft
+        // If altitude ends with H, we have HAE
+        // There's a slight difference between Barometric alt and HAE, but it would require
+        // knowledge about Geoid shape in particular Lat, Lon. It's not worth complicating the code
+        QByteArrayView altitudeStr = values[11];
+        if (altitudeStr.endsWith('H')) {
+            altitudeStr.chop(1);
+        }
+
+        bool altOk, latOk, lonOk, alertOk;
+        const int modeCAltitude = altitudeStr.toInt(&altOk);
+        const double lat = values[14].toDouble(&latOk);
+        const double lon = values[15].toDouble(&lonOk);
+        const int alert = values[19].toInt(&alertOk);
+
+        if (!altOk || !latOk || !lonOk || !alertOk) {
+            return false;
+        }
+
+        if (qFuzzyIsNull(lat) && qFuzzyIsNull(lon)) {
+            return false;
+        }
+
+        vehicleInfo.location = QGeoCoordinate(lat, lon, modeCAltitude * kFeetToMeters);
+        vehicleInfo.alert = (alert == 1);
+        vehicleInfo.availableFlags = ADSB::LocationAvailable | ADSB::AltitudeAvailable | ADSB::AlertAvailable;
+        return true;
+    }
+    case ADSB::AirborneVelocity: {
+        if (valueCount <= 13) {
+            return false;
+        }
+
+        bool headingOk = false, speedOk = false;
+        const double heading = values[13].toDouble(&headingOk);
+        const double speedKnots = values[12].toDouble(&speedOk);
+        if (!headingOk || !speedOk) {
+            return false;
+        }
+
+        vehicleInfo.heading = heading;
+        vehicleInfo.velocity = speedKnots * kKnotsToMetersPerSecond;
+        vehicleInfo.availableFlags = ADSB::HeadingAvailable | ADSB::VelocityAvailable;
+
+        if (valueCount > 16) {
+            bool vertOk = false;
+            const double verticalRate = values[16].toDouble(&vertOk);
+            if (vertOk) {
+                vehicleInfo.verticalVel = verticalRate * kFeetPerMinuteToMetersPerSecond;
+                vehicleInfo.availableFlags |= ADSB::VerticalVelAvailable;
+            }
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
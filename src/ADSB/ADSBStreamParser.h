@@ -0,0 +1,77 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QByteArrayView>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+
+#include "ADSB.h"
+
+Q_DECLARE_LOGGING_CATEGORY(ADSBStreamParserLog)
+
+/// Incremental parser for the output of ADS-B receivers such as dump1090 or readsb.
+///
+/// Accepts SBS-1 BaseStation text (port 30003) and the binary Beast format (port 30005) on the same stream,
+/// the format is recognized per message. Fields are tokenized in place, nothing is allocated per message
+/// except for callsigns. For Beast, DF17/DF18 extended squitters with a valid CRC are decoded: identification,
+/// airborne position (CPR pairs are resolved per aircraft) and airborne velocity.
+class ADSBStreamParser
+{
+public:
+    ADSBStreamParser();
+
+    /// Parses all complete messages at the start of @p data and appends the resulting updates.
+    ///     @return Number of bytes consumed, the remainder is an incomplete message
+    qsizetype parse(QByteArrayView data, QList<ADSB::VehicleInfo_t> &updates);
+
+    /// Parses a single SBS-1 line without line terminator.
+    ///     @return true if @p vehicleInfo was filled in
+    static bool parseSbsLine(QByteArrayView line, ADSB::VehicleInfo_t &vehicleInfo);
+
+    /// Decodes a 112 bit Mode S message.
+    ///     @return true if @p vehicleInfo was filled in
+    bool parseModeS(const uint8_t *message, ADSB::VehicleInfo_t &vehicleInfo);
+
+    /// Resets the CPR state kept per aircraft
+    void clear();
+
+    quint64 messageCount() const { return _messageCount; }
+
+    static constexpr uint8_t kBeastEscape = 0x1A;
+    static constexpr int kModeSLongBytes = 14;
+
+    /// CRC-24 of a Mode S message, 0 for a valid extended squitter
+    static uint32_t modeSChecksum(const uint8_t *message, int bytes);
+
+private:
+    /// @return Bytes consumed, 0 if the frame is incomplete
+    qsizetype _parseBeastFrame(QByteArrayView data, QList<ADSB::VehicleInfo_t> &updates);
+
+    struct CprFrame {
+        int lat = 0;
+        int lon = 0;
+        qint64 timeMs = -1;
+    };
+
+    struct CprState {
+        CprFrame even;
+        CprFrame odd;
+    };
+
+    QHash<uint32_t, CprState> _cpr;
+    QElapsedTimer _clock;
+    quint64 _messageCount = 0;
+
+    static constexpr qsizetype kMaxLineLength = 512;
+    static constexpr qint64 kMaxCprPairAgeMs = 10000;
+};
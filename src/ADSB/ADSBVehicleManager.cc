@@ -14,12 +14,19 @@
 #include "ADSBTCPLink.h"
 #include "ADSBVehicle.h"
 #include "QmlObjectListModel.h"
+#include "MultiVehicleManager.h"
+#include "Vehicle.h"
 #include "QGCLoggingCategory.h"
 
 #include <QtCore/QApplicationStatic>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+#include <QtCore/QtMath>
 #include <QtCore/QTimer>
 #include <qassert.h>
 
+#include <cmath>
+
 QGC_LOGGING_CATEGORY(ADSBVehicleManagerLog, "ADSB.ADSBVehicleManager")
 
 Q_APPLICATION_STATIC(ADSBVehicleManager, _adsbVehicleManager, SettingsManager::instance()->adsbVehicleManagerSettings());
@@ -28,16 +35,23 @@ ADSBVehicleManager::ADSBVehicleManager(ADSBVehicleManagerSettings *settings, QOb
     : QObject(parent)
     , _adsbSettings(settings)
     , _adsbVehicleCleanupTimer(new QTimer(this))
+    , _updateTimer(new QTimer(this))
     , _adsbVehicles(new QmlObjectListModel(this))
 {
     // qCDebug(ADSBVehicleManagerLog) << Q_FUNC_INFO << this;
 
     (void) qRegisterMetaType<ADSB::VehicleInfo_t>("ADSB::VehicleInfo_t");
+    (void) qRegisterMetaType<QList<ADSB::VehicleInfo_t>>("QList<ADSB::VehicleInfo_t>");
 
     _adsbVehicleCleanupTimer->setSingleShot(false);
     _adsbVehicleCleanupTimer->setInterval(1000);
     (void) connect(_adsbVehicleCleanupTimer, &QTimer::timeout, this, &ADSBVehicleManager::_cleanupStaleVehicles);
 
+    // Started by the first update after a flush, so an idle manager does not wake up
+    _updateTimer->setSingleShot(true);
+    _updateTimer->setInterval(kUpdateIntervalMs);
+    (void) connect(_updateTimer, &QTimer::timeout, this, &ADSBVehicleManager::_processPendingUpdates);
+
     Fact* const adsbEnabled = _adsbSettings->adsbServerConnectEnabled();
     Fact* const hostAddress = _adsbSettings->adsbServerHostAddress();
     Fact* const port = _adsbSettings->adsbServerPort();
@@ -57,6 +71,16 @@ ADSBVehicleManager::ADSBVehicleManager(ADSBVehicleManagerSettings *settings, QOb
 
 ADSBVehicleManager::~ADSBVehicleManager()
 {
+    if (_adsbTcpLink) {
+        _adsbTcpLink->deleteLater();
+        _adsbTcpLink = nullptr;
+    }
+
+    if (_linkThread) {
+        _linkThread->quit();
+        (void) _linkThread->wait();
+    }
+
     // qCDebug(ADSBVehicleManagerLog) << Q_FUNC_INFO << this;
 }
 
@@ -146,17 +170,195 @@ void ADSBVehicleManager::_handleADSBVehicle(const mavlink_message_t &message)
 
 void ADSBVehicleManager::adsbVehicleUpdate(const ADSB::VehicleInfo_t &vehicleInfo)
 {
-    const uint32_t icaoAddress = vehicleInfo.icaoAddress;
-    if (_adsbICAOMap.contains(icaoAddress)) {
-        _adsbICAOMap[icaoAddress]->update(vehicleInfo);
+    _queueUpdate(vehicleInfo);
+}
+
+void ADSBVehicleManager::adsbVehicleUpdates(const QList<ADSB::VehicleInfo_t> &vehicleInfos)
+{
+    for (const ADSB::VehicleInfo_t &vehicleInfo : vehicleInfos) {
+        _queueUpdate(vehicleInfo);
+    }
+}
+
+void ADSBVehicleManager::_queueUpdate(const ADSB::VehicleInfo_t &vehicleInfo)
+{
+    const auto it = _pendingUpdates.find(vehicleInfo.icaoAddress);
+    if (it == _pendingUpdates.end()) {
+        (void) _pendingUpdates.insert(vehicleInfo.icaoAddress, vehicleInfo);
+    } else {
+        _mergeUpdate(it.value(), vehicleInfo);
+    }
+
+    if (!_updateTimer->isActive()) {
+        _updateTimer->start();
+    }
+}
+
+void ADSBVehicleManager::_mergeUpdate(ADSB::VehicleInfo_t &target, const ADSB::VehicleInfo_t &update)
+{
+    const ADSB::AvailableInfoTypes flags = update.availableFlags;
+
+    if (flags & ADSB::LocationAvailable) {
+        target.location.setLatitude(update.location.latitude());
+        target.location.setLongitude(update.location.longitude());
+    }
+    if (flags & ADSB::AltitudeAvailable) {
+        target.location.setAltitude(update.location.altitude());
+    }
+    if (flags & ADSB::HeadingAvailable) {
+        target.heading = update.heading;
+    }
+    if (flags & ADSB::VelocityAvailable) {
+        target.velocity = update.velocity;
+    }
+    if (flags & ADSB::CallsignAvailable) {
+        target.callsign = update.callsign;
+    }
+    if (flags & ADSB::SquawkAvailable) {
+        target.squawk = update.squawk;
+    }
+    if (flags & ADSB::VerticalVelAvailable) {
+        target.verticalVel = update.verticalVel;
+    }
+    if (flags & ADSB::AlertAvailable) {
+        target.alert = update.alert;
+    }
+
+    target.availableFlags |= flags;
+    target.lastContact = update.lastContact;
+    target.simulated = update.simulated;
+    target.baro = target.baro || update.baro;
+}
+
+void ADSBVehicleManager::_processPendingUpdates()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const qsizetype updateCount = _pendingUpdates.count();
+    for (auto it = _pendingUpdates.cbegin(); it != _pendingUpdates.cend(); ++it) {
+        const ADSB::VehicleInfo_t &vehicleInfo = it.value();
+        const uint32_t icaoAddress = it.key();
+
+        ADSBVehicle *adsbVehicle = _adsbICAOMap.value(icaoAddress, nullptr);
+        if (adsbVehicle) {
+            adsbVehicle->update(vehicleInfo);
+        } else if (vehicleInfo.availableFlags & ADSB::LocationAvailable) {
+            adsbVehicle = new ADSBVehicle(vehicleInfo, this);
+            (void) _adsbICAOMap.insert(icaoAddress, adsbVehicle);
+            qCDebug(ADSBVehicleManagerLog) << "Added" << QString::number(icaoAddress);
+        } else {
+            continue;
+        }
+
+        if (vehicleInfo.availableFlags & ADSB::LocationAvailable) {
+            _grid.update(icaoAddress, adsbVehicle->coordinate());
+        }
+    }
+    _pendingUpdates.clear();
+
+    _updateDisplayedVehicles();
+
+    qCDebug(ADSBVehicleManagerLog) << "Applied" << updateCount << "updates for" << _adsbICAOMap.count() << "aircraft,"
+                                   << _adsbVehicles->count() << "displayed in" << timer.nsecsElapsed() / 1000 << "us";
+}
+
+void ADSBVehicleManager::setViewport(const QGeoRectangle &viewport)
+{
+    if (viewport == _viewport) {
         return;
     }
 
-    if (vehicleInfo.availableFlags & ADSB::LocationAvailable) {
-        ADSBVehicle* const adsbVehicle = new ADSBVehicle(vehicleInfo, this);
-        _adsbICAOMap[icaoAddress] = adsbVehicle;
-        _adsbVehicles->append(adsbVehicle);
-        qCDebug(ADSBVehicleManagerLog) << "Added" << QString::number(adsbVehicle->icaoAddress());
+    _viewport = viewport;
+
+    if (!_updateTimer->isActive()) {
+        _updateTimer->start();
+    }
+}
+
+QList<QGeoRectangle> ADSBVehicleManager::_regionsOfInterest() const
+{
+    QList<QGeoRectangle> regions;
+
+    if (_viewport.isValid()) {
+        const double marginLat = _viewport.height() * kViewportMargin;
+        const double marginLon = _viewport.width() * kViewportMargin;
+        QGeoRectangle region = _viewport;
+        if ((_viewport.width() + (2 * marginLon)) >= 360.) {
+            region.setTopLeft(QGeoCoordinate(qMin(90., _viewport.topLeft().latitude() + marginLat), -180.));
+            region.setBottomRight(QGeoCoordinate(qMax(-90., _viewport.bottomRight().latitude() - marginLat), 180.));
+        } else {
+            region.setHeight(qMin(180., _viewport.height() + (2 * marginLat)));
+            region.setWidth(_viewport.width() + (2 * marginLon));
+        }
+        regions.append(region);
+    }
+
+    Vehicle *const activeVehicle = MultiVehicleManager::instance()->activeVehicle();
+    if (activeVehicle) {
+        const QGeoCoordinate center = activeVehicle->coordinate();
+        if (center.isValid()) {
+            constexpr double metersPerDegree = 111320.;
+            const double height = 2. * kVehicleRegionRadiusMeters / metersPerDegree;
+            const double width = qMin(360., height / qMax(0.01, std::cos(qDegreesToRadians(center.latitude()))));
+            regions.append(QGeoRectangle(center, width, qMin(180., height)));
+        }
+    }
+
+    return regions;
+}
+
+void ADSBVehicleManager::_updateDisplayedVehicles()
+{
+    const QList<QGeoRectangle> regions = _regionsOfInterest();
+
+    QSet<uint32_t> visible;
+    if (regions.isEmpty()) {
+        // Nothing to restrict to, show everything
+        visible.reserve(_adsbICAOMap.count());
+        for (auto it = _adsbICAOMap.cbegin(); it != _adsbICAOMap.cend(); ++it) {
+            (void) visible.insert(it.key());
+        }
+    } else {
+        QList<uint32_t> candidates;
+        for (const QGeoRectangle &region : regions) {
+            candidates.clear();
+            _grid.query(region, candidates);
+            for (const uint32_t icaoAddress : std::as_const(candidates)) {
+                const ADSBVehicle *const adsbVehicle = _adsbICAOMap.value(icaoAddress, nullptr);
+                if (adsbVehicle && region.contains(adsbVehicle->coordinate())) {
+                    (void) visible.insert(icaoAddress);
+                }
+            }
+        }
+    }
+
+    // Remove aircraft which left the regions of interest, each run of adjacent rows goes out as a single removal
+    QObjectList remaining;
+    remaining.reserve(_adsbVehicles->count());
+    for (int i = 0; i < _adsbVehicles->count(); i++) {
+        const ADSBVehicle *const adsbVehicle = _adsbVehicles->value<ADSBVehicle*>(i);
+        if (visible.contains(adsbVehicle->icaoAddress())) {
+            remaining.append(_adsbVehicles->get(i));
+        }
+    }
+    if (remaining.count() != _adsbVehicles->count()) {
+        (void) _adsbVehicles->syncObjectList(remaining);
+    }
+
+    _displayed.intersect(visible);
+
+    // Add aircraft which entered, as one insertion
+    QList<QObject*> additions;
+    for (const uint32_t icaoAddress : std::as_const(visible)) {
+        if (!_displayed.contains(icaoAddress)) {
+            additions.append(_adsbICAOMap.value(icaoAddress));
+            (void) _displayed.insert(icaoAddress);
+        }
+    }
+
+    if (!additions.isEmpty()) {
+        _adsbVehicles->append(additions);
     }
 }
 
@@ -164,43 +366,67 @@ void ADSBVehicleManager::_start(const QString &hostAddress, quint16 port)
 {
     Q_ASSERT(!_adsbTcpLink);
 
-    ADSBTCPLink *adsbTcpLink = new ADSBTCPLink(QHostAddress(hostAddress), port, this);
-    if (!adsbTcpLink->init()) {
-        delete adsbTcpLink;
-        adsbTcpLink = nullptr;
+    const QHostAddress address(hostAddress);
+    if (address.isNull()) {
         qCWarning(ADSBVehicleManagerLog) << "Failed to Initialize TCP Link at:" << hostAddress << port;
         return;
     }
 
+    if (!_linkThread) {
+        _linkThread = new QThread(this);
+        _linkThread->setObjectName(QStringLiteral("ADSBTCPLink"));
+        _linkThread->start();
+    }
+
+    // Parsing happens on the link thread, the GUI thread only sees batches of updates
+    ADSBTCPLink *const adsbTcpLink = new ADSBTCPLink(address, port);
+    adsbTcpLink->moveToThread(_linkThread);
+
     _adsbTcpLink = adsbTcpLink;
-    (void) connect(_adsbTcpLink, &ADSBTCPLink::adsbVehicleUpdate, this, &ADSBVehicleManager::adsbVehicleUpdate, Qt::AutoConnection);
-    (void) connect(_adsbTcpLink, &ADSBTCPLink::errorOccurred, this, &ADSBVehicleManager::_linkError, Qt::AutoConnection);
+    (void) connect(_adsbTcpLink, &ADSBTCPLink::adsbVehicleUpdates, this, &ADSBVehicleManager::adsbVehicleUpdates, Qt::QueuedConnection);
+    (void) connect(_adsbTcpLink, &ADSBTCPLink::errorOccurred, this, &ADSBVehicleManager::_linkError, Qt::QueuedConnection);
+    (void) QMetaObject::invokeMethod(_adsbTcpLink, [adsbTcpLink]() { (void) adsbTcpLink->init(); }, Qt::QueuedConnection);
 
     _adsbVehicleCleanupTimer->start();
 }
 
 void ADSBVehicleManager::_stop()
 {
-    Q_CHECK_PTR(_adsbTcpLink);
-    _adsbTcpLink->deleteLater();
-    _adsbTcpLink = nullptr;
+    if (_adsbTcpLink) {
+        _adsbTcpLink->deleteLater();
+        _adsbTcpLink = nullptr;
+    }
 
     _adsbVehicleCleanupTimer->stop();
-
-    _adsbVehicles->clearAndDeleteContents();
+    _updateTimer->stop();
+
+    _pendingUpdates.clear();
+    _displayed.clear();
+    _grid.clear();
+    _adsbVehicles->clear();
+    for (ADSBVehicle *const adsbVehicle : std::as_const(_adsbICAOMap)) {
+        adsbVehicle->deleteLater();
+    }
     _adsbICAOMap.clear();
 }
 
 void ADSBVehicleManager::_cleanupStaleVehicles()
 {
-    for (qsizetype i = _adsbVehicles->count() - 1; i >= 0; i--) {
-        ADSBVehicle* const adsbVehicle = _adsbVehicles->value<ADSBVehicle*>(i);
-        if (adsbVehicle->expired()) {
-            qCDebug(ADSBVehicleManagerLog) << "Expired" << QString::number(adsbVehicle->icaoAddress());
-            (void) _adsbVehicles->removeAt(i);
-            (void) _adsbICAOMap.remove(adsbVehicle->icaoAddress());
-            adsbVehicle->deleteLater();
+    QList<uint32_t> expired;
+    for (auto it = _adsbICAOMap.cbegin(); it != _adsbICAOMap.cend(); ++it) {
+        if (it.value()->expired()) {
+            expired.append(it.key());
+        }
+    }
+
+    for (const uint32_t icaoAddress : std::as_const(expired)) {
+        qCDebug(ADSBVehicleManagerLog) << "Expired" << QString::number(icaoAddress);
+        ADSBVehicle *const adsbVehicle = _adsbICAOMap.take(icaoAddress);
+        if (_displayed.remove(icaoAddress)) {
+            (void) _adsbVehicles->removeOne(adsbVehicle);
         }
+        _grid.remove(icaoAddress);
+        adsbVehicle->deleteLater();
     }
 }
 
@@ -9,10 +9,14 @@
 
 #pragma once
 
+#include <QtCore/QHash>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QObject>
+#include <QtCore/QSet>
+#include <QtPositioning/QGeoRectangle>
 
 #include "ADSB.h"
+#include "ADSBSpatialGrid.h"
 #include "MAVLinkLib.h"
 
 Q_DECLARE_LOGGING_CATEGORY(ADSBVehicleManagerLog)
@@ -20,9 +24,14 @@ Q_DECLARE_LOGGING_CATEGORY(ADSBVehicleManagerLog)
 class ADSBTCPLink;
 class ADSBVehicle;
 class QmlObjectListModel;
+class QThread;
 class QTimer;
 class ADSBVehicleManagerSettings;
 
+/// Keeps track of all aircraft reported by the ADS-B server and by vehicles.
+///
+/// Updates are merged per aircraft and applied at a fixed rate. Only aircraft inside the
+/// map viewport or around the active vehicle are put into the adsbVehicles model.
 class ADSBVehicleManager : public QObject
 {
     Q_OBJECT
@@ -30,6 +39,8 @@ class ADSBVehicleManager : public QObject
 
     Q_PROPERTY(const QmlObjectListModel *adsbVehicles READ adsbVehicles CONSTANT)
 
+    friend class ADSBTest;
+
 public:
     explicit ADSBVehicleManager(ADSBVehicleManagerSettings *settings, QObject *parent = nullptr);
     ~ADSBVehicleManager();
@@ -38,12 +49,20 @@ class ADSBVehicleManager : public QObject
 
     const QmlObjectListModel *adsbVehicles() const { return _adsbVehicles; }
 
+    /// Number of aircraft known, including the ones not in adsbVehicles
+    qsizetype trackedCount() const { return _adsbICAOMap.count(); }
+
     void mavlinkMessageReceived(const mavlink_message_t &message);
 
+    /// Sets the region shown by the map. An invalid region shows all aircraft.
+    Q_INVOKABLE void setViewport(const QGeoRectangle &viewport);
+
 public slots:
     void adsbVehicleUpdate(const ADSB::VehicleInfo_t &vehicleInfo);
+    void adsbVehicleUpdates(const QList<ADSB::VehicleInfo_t> &vehicleInfos);
 
 private slots:
+    void _processPendingUpdates();
     void _cleanupStaleVehicles();
     void _linkError(const QString &errorMsg, bool stopped = false);
 
@@ -51,13 +70,28 @@ private slots:
     void _start(const QString &hostAddress, quint16 port);
     void _stop();
     void _handleADSBVehicle(const mavlink_message_t &message);
+    void _queueUpdate(const ADSB::VehicleInfo_t &vehicleInfo);
+    /// Brings the model in line with the aircraft inside the regions of interest
+    void _updateDisplayedVehicles();
+    QList<QGeoRectangle> _regionsOfInterest() const;
+    static void _mergeUpdate(ADSB::VehicleInfo_t &target, const ADSB::VehicleInfo_t &update);
 
     ADSBVehicleManagerSettings *_adsbSettings = nullptr;
     QTimer *_adsbVehicleCleanupTimer = nullptr;
+    QTimer *_updateTimer = nullptr;
     QmlObjectListModel *_adsbVehicles = nullptr;
 
-    QMap<uint32_t, ADSBVehicle*> _adsbICAOMap;
+    QHash<uint32_t, ADSBVehicle*> _adsbICAOMap;     ///< All known aircraft
+    QHash<uint32_t, ADSB::VehicleInfo_t> _pendingUpdates;
+    QSet<uint32_t> _displayed;                      ///< Aircraft in _adsbVehicles
+    ADSBSpatialGrid _grid;
+    QGeoRectangle _viewport;
+
     ADSBTCPLink *_adsbTcpLink = nullptr;
+    QThread *_linkThread = nullptr;
 
     static constexpr uint8_t kMaxTimeSinceLastSeen = 15;
+    static constexpr int kUpdateIntervalMs = 200;               ///< Rate at which updates reach the model
+    static constexpr double kVehicleRegionRadiusMeters = 50000.;
+    static constexpr double kViewportMargin = 0.25;             ///< Fraction of the viewport added on every side
 };
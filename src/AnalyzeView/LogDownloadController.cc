@@ -239,94 +239,124 @@ void LogDownloadController::_logData(uint32_t ofs, uint16_t id, uint8_t count, c
         return;
     }
 
-    bool result = false;
-    if (ofs <= _downloadData->entry->size()) {
-        const uint32_t chunk = ofs / LogDownloadData::kChunkSize;
-        // qCDebug(LogDownloadControllerLog) << "Received data - Offset:" << ofs << "Chunk:" << chunk;
-        if (chunk != _downloadData->current_chunk) {
-            qCWarning(LogDownloadControllerLog) << "Ignored packet for out of order chunk actual:expected" << chunk << _downloadData->current_chunk;
-            return;
+    const uint32_t size = _downloadData->entry->size();
+    if (ofs >= size) {
+        if (count > 0) {
+            qCWarning(LogDownloadControllerLog) << "Received log offset greater than expected";
         }
+        return;
+    }
 
-        const uint16_t bin = (ofs - (chunk * LogDownloadData::kChunkSize)) / MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
-        if (bin >= _downloadData->chunk_table.size()) {
-            qCWarning(LogDownloadControllerLog) << "Out of range bin received";
-        } else {
-            _downloadData->chunk_table.setBit(bin);
-        }
+    if (count == 0) {
+        return;
+    }
 
-        if (_downloadData->file.pos() != ofs) {
-            if (!_downloadData->file.seek(ofs)) {
-                qCWarning(LogDownloadControllerLog) << "Error while seeking log file offset";
-                return;
-            }
+    // Data is accepted for any offset in the file, in any order. The first packet belonging to the
+    // outstanding request gives a round trip time sample, unless the request was a retry (Karn's rule).
+    const uint32_t bin = ofs / MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
+    if (!_downloadData->request_answered && (bin >= _downloadData->request_start_bin) && (bin < _downloadData->request_end_bin)) {
+        _downloadData->request_answered = true;
+        if (_downloadData->request_tries == 1) {
+            _rttEstimator.addSample(_downloadData->request_timer.elapsed());
         }
+    }
 
-        if (_downloadData->file.write(reinterpret_cast<const char*>(data), count)) {
-            _downloadData->written += count;
-            _downloadData->rate_bytes += count;
-            _updateDataRate();
-
-            result = true;
-            _retries = 0;
-
-            _timer->start(kTimeOutMs);
-            if (_logComplete()) {
-                _downloadData->entry->setStatus(tr("Downloaded"));
-                _receivedAllData();
-            } else if (_chunkComplete()) {
-                _downloadData->advanceChunk();
-                _requestLogData(_downloadData->ID,
-                                _downloadData->current_chunk * LogDownloadData::kChunkSize,
-                                _downloadData->chunk_table.size() * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
-            } else if ((bin < (_downloadData->chunk_table.size() - 1)) && _downloadData->chunk_table.at(bin + 1)) {
-                // Likely to be grabbing fragments and got to the end of a gap
-                _findMissingData();
-            }
-        } else {
-            qCWarning(LogDownloadControllerLog) << "Error while writing log file chunk";
-        }
-    } else {
-        qCWarning(LogDownloadControllerLog) << "Received log offset greater than expected";
+    if (!_downloadData->setBinReceived(bin)) {
+        // Duplicate or stale data, the timer takes care of anything still missing
+        return;
     }
 
-    if (!result) {
+    // qCDebug(LogDownloadControllerLog) << "Received data - Offset:" << ofs << "Bin:" << bin;
+    if (!_downloadData->write(ofs, data, qMin(static_cast<uint32_t>(count), size - ofs))) {
         _downloadData->entry->setStatus(tr("Error"));
+        return;
+    }
+    _updateDataRate();
+
+    const bool requestEndReached = (bin >= _downloadData->request_start_bin) && (bin < _downloadData->request_end_bin) && (bin == (_downloadData->request_end_bin - 1));
+    if (_downloadData->complete() || requestEndReached) {
+        // Either done or the vehicle has sent the last bin of the requested range, no need to wait for the timeout
+        _findMissingData();
+    } else {
+        _timer->start(_rttEstimator.timeoutMSecs(kTimeOutMs, kMinTimeOutMs, kMaxTimeOutMs));
     }
 }
 
 void LogDownloadController::_findMissingData()
 {
-    if (_logComplete()) {
+    if (_downloadData->complete()) {
+        _timer->stop();
+        if (_downloadData->flush()) {
+            _downloadData->entry->setStatus(tr("Downloaded"));
+        } else {
+            _downloadData->entry->setStatus(tr("Error"));
+        }
         _receivedAllData();
         return;
     }
 
-    if (_chunkComplete()) {
-        _downloadData->advanceChunk();
-    }
-
-    _retries++;
+    // Request the first gap, extended across runs of already received bins which are short enough that
+    // receiving them again costs less than a separate round trip for the gap that follows.
+    const uint32_t numBins = static_cast<uint32_t>(_downloadData->bin_table.size());
+    const uint32_t mergeBins = _gapMergeBins();
+    const uint32_t start = _downloadData->first_missing_bin;
+    uint32_t end = start;
+    while (end < numBins) {
+        if (!_downloadData->bin_table.testBit(end)) {
+            end++;
+            continue;
+        }
 
-    _updateDataRate();
+        uint32_t next = end;
+        while ((next < numBins) && _downloadData->bin_table.testBit(next) && ((next - end) <= mergeBins)) {
+            next++;
+        }
 
-    uint16_t start = 0, end = 0;
-    const int size = _downloadData->chunk_table.size();
-    for (; start < size; start++) {
-        if (!_downloadData->chunk_table.testBit(start)) {
+        if ((next == numBins) || _downloadData->bin_table.testBit(next)) {
             break;
         }
+
+        end = next;
     }
 
-    for (end = start; end < size; end++) {
-        if (_downloadData->chunk_table.testBit(end)) {
-            break;
+    if (_downloadData->request_answered || (start != _downloadData->request_start_bin)) {
+        _downloadData->request_tries = 0;
+    }
+    if (_downloadData->request_tries > kMaxDataRetries) {
+        qCWarning(LogDownloadControllerLog) << "No log data after" << kMaxDataRetries << "retries - Offset:" << (start * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
+        _timer->stop();
+        _downloadData->entry->setStatus(tr("Error"));
+        if (_downloadData->file.exists()) {
+            (void) _downloadData->file.remove();
         }
+        _downloadData.reset();
+        _requestLogEnd();
+        _resetSelection();
+        _setDownloading(false);
+        return;
     }
+    _downloadData->request_tries++;
+    _downloadData->request_start_bin = start;
+    _downloadData->request_end_bin = end;
+    _downloadData->request_answered = false;
+    _downloadData->request_timer.start();
+
+    _updateDataRate();
 
-    const uint32_t pos = (_downloadData->current_chunk * LogDownloadData::kChunkSize) + (start * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
-    const uint32_t len = (end - start) * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
-    _requestLogData(_downloadData->ID, pos, len, _retries);
+    const uint32_t pos = start * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
+    const uint32_t len = qMin((end - start) * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN, _downloadData->entry->size() - pos);
+    _requestLogData(_downloadData->ID, pos, len, _downloadData->request_tries - 1);
+    _timer->start(_rttEstimator.backoffTimeoutMSecs(_downloadData->request_tries, kTimeOutMs, kMinTimeOutMs, kMaxTimeOutMs));
+}
+
+uint32_t LogDownloadController::_gapMergeBins() const
+{
+    if (!_rttEstimator.hasSamples() || (_downloadData->rate_avg <= 0.)) {
+        return 0;
+    }
+
+    const qreal binsPerRtt = (_rttEstimator.srttMSecs() / 1000.0) * _downloadData->rate_avg / MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
+    return qMin(static_cast<uint32_t>(binsPerRtt), kMaxGapMergeBins);
 }
 
 void LogDownloadController::_updateDataRate()
@@ -346,22 +376,12 @@ void LogDownloadController::_updateDataRate()
     _downloadData->elapsed.start();
 }
 
-bool LogDownloadController::_chunkComplete() const
-{
-    return _downloadData->chunkEquals(true);
-}
-
-bool LogDownloadController::_logComplete() const
-{
-    return (_chunkComplete() && ((_downloadData->current_chunk + 1) == _downloadData->numChunks()));
-}
-
 void LogDownloadController::_receivedAllData()
 {
     _timer->stop();
     if (_prepareLogDownload()) {
-        _requestLogData(_downloadData->ID, 0, _downloadData->chunk_table.size() * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
-        _timer->start(kTimeOutMs);
+        // The first request covers the whole file, gaps left by lost packets are filled in afterwards
+        _findMissingData();
     } else {
         _resetSelection();
         _setDownloading(false);
@@ -415,8 +435,7 @@ bool LogDownloadController::_prepareLogDownload()
     } else if (!_downloadData->file.resize(entry->size())) {
         qCWarning(LogDownloadControllerLog) << "Failed to allocate space for log file:" <<  _downloadData->filename;
     } else {
-        _downloadData->current_chunk = 0;
-        _downloadData->chunk_table = QBitArray(_downloadData->chunkBins(), false);
+        _downloadData->bin_table = QBitArray(_downloadData->numBins(), false);
         _downloadData->elapsed.start();
         result = true;
     }
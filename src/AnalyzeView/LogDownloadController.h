@@ -13,6 +13,8 @@
 #include <QtCore/QObject>
 #include <QtQmlIntegration/QtQmlIntegration>
 
+#include "RttEstimator.h"
+
 Q_DECLARE_LOGGING_CATEGORY(LogDownloadControllerLog)
 
 struct LogDownloadData;
@@ -61,9 +63,9 @@ private slots:
     bool _getRequestingList() const { return _requestingLogEntries; }
     bool _getDownloadingLogs() const { return _downloadingLogs; }
 
-    bool _chunkComplete() const;
     bool _entriesComplete() const;
-    bool _logComplete() const;
+    /// @return Number of already received bins a gap request may span so that nearby gaps are fetched by one request
+    uint32_t _gapMergeBins() const;
     bool _prepareLogDownload();
     void _downloadToDirectory(const QString &dir);
     void _findMissingData();
@@ -88,10 +90,15 @@ private slots:
     int _apmOffset = 0;
     int _retries = 0;
     std::unique_ptr<LogDownloadData> _downloadData;
+    RttEstimator _rttEstimator;     ///< Round trip time from LOG_REQUEST_DATA to first LOG_DATA, persists across downloads
     QString _downloadPath;
     Vehicle *_vehicle = nullptr;
 
     static constexpr uint32_t kTimeOutMs = 500;
+    static constexpr uint32_t kMinTimeOutMs = 50;
+    static constexpr uint32_t kMaxTimeOutMs = 5000;
+    static constexpr uint32_t kMaxGapMergeBins = 64;
+    static constexpr int kMaxDataRetries = 10;       ///< Retries of a request without any data before the download fails
     static constexpr uint32_t kGUIRateMs = 17; ///< 1000ms / 60fps
     static constexpr uint32_t kRequestLogListTimeoutMs = 5000;
 };
@@ -27,27 +27,68 @@ LogDownloadData::~LogDownloadData()
     // qCDebug(LogEntryLog) << Q_FUNC_INFO << this;
 }
 
-void LogDownloadData::advanceChunk()
+uint32_t LogDownloadData::numBins() const
 {
-    ++current_chunk;
-    chunk_table = QBitArray(chunkBins(), false);
+    const qreal num = static_cast<qreal>(entry->size()) / static_cast<qreal>(MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
+    return qCeil(num);
 }
 
-uint32_t LogDownloadData::chunkBins() const
+bool LogDownloadData::setBinReceived(uint32_t bin)
 {
-    const qreal num = static_cast<qreal>((entry->size() - (current_chunk * kChunkSize))) / static_cast<qreal>(MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
-    return qMin(static_cast<uint32_t>(qCeil(num)), kTableBins);
+    if (bin_table.testBit(bin)) {
+        return false;
+    }
+
+    bin_table.setBit(bin);
+    bins_received++;
+
+    while ((first_missing_bin < static_cast<uint32_t>(bin_table.size())) && bin_table.testBit(first_missing_bin)) {
+        first_missing_bin++;
+    }
+
+    return true;
 }
 
-uint32_t LogDownloadData::numChunks() const
+bool LogDownloadData::write(uint32_t ofs, const uint8_t *data, uint32_t count)
 {
-    const qreal num = static_cast<qreal>(entry->size()) / static_cast<qreal>(kChunkSize);
-    return qCeil(num);
+    if (!write_buffer.isEmpty() && (ofs != (write_offset + static_cast<uint32_t>(write_buffer.size())))) {
+        if (!flush()) {
+            return false;
+        }
+    }
+
+    if (write_buffer.isEmpty()) {
+        write_offset = ofs;
+    }
+
+    (void) write_buffer.append(reinterpret_cast<const char*>(data), count);
+    written += count;
+    rate_bytes += count;
+
+    if (static_cast<uint32_t>(write_buffer.size()) >= kWriteBufferSize) {
+        return flush();
+    }
+
+    return true;
 }
 
-bool LogDownloadData::chunkEquals(const bool val) const
+bool LogDownloadData::flush()
 {
-    return (chunk_table == QBitArray(chunk_table.size(), val));
+    if (write_buffer.isEmpty()) {
+        return true;
+    }
+
+    bool result = true;
+    if ((file.pos() != write_offset) && !file.seek(write_offset)) {
+        qCWarning(LogEntryLog) << "Error while seeking log file offset" << write_offset;
+        result = false;
+    } else if (file.write(write_buffer) != write_buffer.size()) {
+        qCWarning(LogEntryLog) << "Error while writing log file" << file.errorString();
+        result = false;
+    }
+
+    write_buffer.clear();
+    return result;
 }
 
 /*===========================================================================*/
@@ -28,31 +28,48 @@ struct LogDownloadData
     explicit LogDownloadData(QGCLogEntry * const entry);
     ~LogDownloadData();
 
-    void advanceChunk();
+    /// The number of MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN bins in the file
+    uint32_t numBins() const;
 
-    /// The number of MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN bins in the current chunk
-    uint32_t chunkBins() const;
+    /// True if every bin in the file has been received
+    bool complete() const { return (bins_received == static_cast<uint32_t>(bin_table.size())); }
 
-    /// The number of kChunkSize chunks in the file
-    uint32_t numChunks() const;
+    /// Marks bin as received
+    /// @return false: bin had already been received
+    bool setBinReceived(uint32_t bin);
 
-    /// True if all bins in the chunk have been set to val
-    bool chunkEquals(const bool val) const;
+    /// Queues count bytes of data for writing at file offset ofs. Contiguous data is coalesced
+    /// and written in one go once kWriteBufferSize is reached or the next offset is out of sequence.
+    /// @return false: write to file failed
+    bool write(uint32_t ofs, const uint8_t *data, uint32_t count);
+
+    /// Writes out any buffered data
+    /// @return false: write to file failed
+    bool flush();
 
     uint ID = 0;
     QGCLogEntry *const entry = nullptr;
 
-    QBitArray chunk_table;
-    uint32_t current_chunk = 0;
+    QBitArray bin_table;                ///< One bit per bin in the whole file
+    uint32_t bins_received = 0;
+    uint32_t first_missing_bin = 0;     ///< No bins before this one are missing
+
+    uint32_t request_start_bin = 0;     ///< First bin of the outstanding LOG_REQUEST_DATA
+    uint32_t request_end_bin = 0;       ///< One past the last bin of the outstanding LOG_REQUEST_DATA
+    bool request_answered = false;      ///< Data has arrived for the outstanding request
+    int request_tries = 0;              ///< Number of times the outstanding range has been requested
+    QElapsedTimer request_timer;        ///< Time since the outstanding request was sent
+
     QFile file;
     QString filename;
+    QByteArray write_buffer;
+    uint32_t write_offset = 0;          ///< File offset of the first byte in write_buffer
     uint written = 0;
     size_t rate_bytes = 0;
     qreal rate_avg = 0.;
     QElapsedTimer elapsed;
 
-    static constexpr uint32_t kTableBins = 512;
-    static constexpr uint32_t kChunkSize = kTableBins * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
+    static constexpr uint32_t kWriteBufferSize = 64 * 1024;
 };
 
 /*===========================================================================*/
@@ -2190,19 +2190,27 @@ void VehicleCameraControl::_ftpDownloadComplete(const QString& fileName, const Q
 
     disconnect(_vehicle->ftpManager(), &FTPManager::downloadComplete, this, &VehicleCameraControl::_ftpDownloadComplete);
 
-    QString outputFileName = fileName;
+    QFile xmlFile(fileName);
 
     if (fileName.endsWith(".lzma", Qt::CaseInsensitive) || fileName.endsWith(".xz", Qt::CaseInsensitive)) {
-        outputFileName = fileName.left(fileName.lastIndexOf("."));
-        if (QGCLZMA::inflateLZMAFile(fileName, outputFileName)) {
-            QFile(fileName).remove();
-        } else {
+        // Decompress straight to memory, the decompressed definition is never needed on disk
+        QByteArray bytes;
+        bool inflated = false;
+        if (xmlFile.open(QIODevice::ReadOnly)) {
+            inflated = QGCLZMA::inflateLZMA(xmlFile.readAll(), bytes);
+            xmlFile.close();
+        }
+        (void) xmlFile.remove();
+
+        if (!inflated) {
             qCWarning(CameraControlLog) << "Inflate of compressed xml failed" << fileName;
-            outputFileName.clear();
+            return;
         }
-    }
 
-    QFile xmlFile(outputFileName);
+        _cached = true;
+        emit dataReady(bytes);
+        return;
+    }
 
     if (!xmlFile.exists()) {
         qCDebug(CameraControlLog) << "No camera definition file present after ftp download completed";
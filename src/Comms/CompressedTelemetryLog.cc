@@ -0,0 +1,482 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "CompressedTelemetryLog.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+
+#include <zlib.h>
+
+QGC_LOGGING_CATEGORY(CompressedTelemetryLogLog, "Comms.CompressedTelemetryLog")
+
+namespace {
+
+void _putU32(char *dst, quint32 value) { qToLittleEndian<quint32>(value, dst); }
+void _putU64(char *dst, quint64 value) { qToLittleEndian<quint64>(value, dst); }
+quint32 _getU32(const char *src) { return qFromLittleEndian<quint32>(src); }
+quint64 _getU64(const char *src) { return qFromLittleEndian<quint64>(src); }
+
+}
+
+bool CompressedTelemetryLog::isCompressedLog(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    return (file.read(magicSize) == QByteArray(fileMagic, magicSize));
+}
+
+/*===========================================================================*/
+
+TelemetryLogWriter::TelemetryLogWriter(QObject *parent)
+    : QObject(parent)
+{
+    // qCDebug(CompressedTelemetryLogLog) << Q_FUNC_INFO << this;
+}
+
+TelemetryLogWriter::~TelemetryLogWriter()
+{
+    close();
+
+    // qCDebug(CompressedTelemetryLogLog) << Q_FUNC_INFO << this;
+}
+
+bool TelemetryLogWriter::open(const QString &fileName, bool compressed)
+{
+    close();
+
+    _compressed = compressed;
+    _index.clear();
+    _uncompressedOffset = 0;
+    _bytesWritten = 0;
+    _error = false;
+
+    _file = new QFile(fileName, this);
+    if (!_file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(CompressedTelemetryLogLog) << "Failed to open" << fileName << _file->errorString();
+        delete _file;
+        _file = nullptr;
+        _error = true;
+        return false;
+    }
+
+    if (_compressed) {
+        char header[CompressedTelemetryLog::fileHeaderSize];
+        memcpy(header, CompressedTelemetryLog::fileMagic, CompressedTelemetryLog::magicSize);
+        _putU32(header + 8, CompressedTelemetryLog::version);
+        _putU32(header + 12, 0);
+        if (!_writeBytes(header, sizeof(header))) {
+            return false;
+        }
+    }
+
+    qCDebug(CompressedTelemetryLogLog) << "Opened" << fileName << "compressed:" << _compressed;
+    return true;
+}
+
+void TelemetryLogWriter::write(const QByteArray &records, quint64 firstTimestampUSecs, quint64 lastTimestampUSecs)
+{
+    if (!_file || _error || records.isEmpty()) {
+        return;
+    }
+
+    if (_compressed) {
+        (void) _writeCompressedBlock(records, firstTimestampUSecs, lastTimestampUSecs);
+    } else {
+        (void) _writeBytes(records.constData(), records.size());
+    }
+}
+
+void TelemetryLogWriter::close()
+{
+    if (!_file) {
+        return;
+    }
+
+    if (_compressed && !_error) {
+        (void) _writeIndex();
+    }
+
+    _file->close();
+    delete _file;
+    _file = nullptr;
+    _index.clear();
+    _compressBuffer.clear();
+}
+
+bool TelemetryLogWriter::_writeBytes(const char *data, qint64 length)
+{
+    if (_file->write(data, length) != length) {
+        qCWarning(CompressedTelemetryLogLog) << "Write failed" << _file->errorString();
+        _error = true;
+        return false;
+    }
+
+    _bytesWritten.fetch_add(length, std::memory_order_relaxed);
+    return true;
+}
+
+bool TelemetryLogWriter::_writeCompressedBlock(const QByteArray &records, quint64 firstTimestampUSecs, quint64 lastTimestampUSecs)
+{
+    uLongf compressedSize = compressBound(static_cast<uLong>(records.size()));
+    if (_compressBuffer.size() < static_cast<qsizetype>(CompressedTelemetryLog::blockHeaderSize + compressedSize)) {
+        _compressBuffer.resize(CompressedTelemetryLog::blockHeaderSize + compressedSize);
+    }
+
+    Bytef *const dest = reinterpret_cast<Bytef*>(_compressBuffer.data() + CompressedTelemetryLog::blockHeaderSize);
+    const int result = compress2(dest, &compressedSize, reinterpret_cast<const Bytef*>(records.constData()), static_cast<uLong>(records.size()), Z_DEFAULT_COMPRESSION);
+    if (result != Z_OK) {
+        qCWarning(CompressedTelemetryLogLog) << "compress2 failed" << result;
+        _error = true;
+        return false;
+    }
+
+    char *const header = _compressBuffer.data();
+    _putU32(header, CompressedTelemetryLog::blockMagic);
+    _putU32(header + 4, static_cast<quint32>(compressedSize));
+    _putU32(header + 8, static_cast<quint32>(records.size()));
+    _putU64(header + 12, firstTimestampUSecs);
+    _putU64(header + 20, lastTimestampUSecs);
+
+    CompressedTelemetryLog::BlockInfo info;
+    info.fileOffset = _file->pos();
+    info.compressedSize = static_cast<quint32>(compressedSize);
+    info.uncompressedSize = static_cast<quint32>(records.size());
+    info.uncompressedOffset = _uncompressedOffset;
+    info.firstTimestampUSecs = firstTimestampUSecs;
+    info.lastTimestampUSecs = lastTimestampUSecs;
+
+    if (!_writeBytes(_compressBuffer.constData(), CompressedTelemetryLog::blockHeaderSize + compressedSize)) {
+        return false;
+    }
+
+    _index.append(info);
+    _uncompressedOffset += records.size();
+    return true;
+}
+
+bool TelemetryLogWriter::_writeIndex()
+{
+    const qint64 indexOffset = _file->pos();
+
+    QByteArray index(_index.size() * CompressedTelemetryLog::indexEntrySize + CompressedTelemetryLog::footerSize, Qt::Uninitialized);
+    char *entry = index.data();
+    for (const CompressedTelemetryLog::BlockInfo &info : std::as_const(_index)) {
+        _putU64(entry, static_cast<quint64>(info.fileOffset));
+        _putU32(entry + 8, info.compressedSize);
+        _putU32(entry + 12, info.uncompressedSize);
+        _putU64(entry + 16, info.firstTimestampUSecs);
+        _putU64(entry + 24, info.lastTimestampUSecs);
+        entry += CompressedTelemetryLog::indexEntrySize;
+    }
+
+    _putU64(entry, static_cast<quint64>(indexOffset));
+    _putU32(entry + 8, static_cast<quint32>(_index.size()));
+    memcpy(entry + 12, CompressedTelemetryLog::footerMagic, CompressedTelemetryLog::magicSize);
+
+    return _writeBytes(index.constData(), index.size());
+}
+
+/*===========================================================================*/
+
+CompressedTelemetryLogDevice::CompressedTelemetryLogDevice(const QString &fileName, QObject *parent)
+    : QIODevice(parent)
+    , _file(fileName)
+{
+    // qCDebug(CompressedTelemetryLogLog) << Q_FUNC_INFO << this;
+}
+
+CompressedTelemetryLogDevice::~CompressedTelemetryLogDevice()
+{
+    close();
+
+    // qCDebug(CompressedTelemetryLogLog) << Q_FUNC_INFO << this;
+}
+
+bool CompressedTelemetryLogDevice::open(OpenMode mode)
+{
+    if ((mode & QIODevice::WriteOnly) || !(mode & QIODevice::ReadOnly)) {
+        setErrorString(tr("Compressed telemetry logs can only be opened for reading"));
+        return false;
+    }
+
+    if (!_file.open(QIODevice::ReadOnly)) {
+        setErrorString(_file.errorString());
+        return false;
+    }
+
+    const QByteArray header = _file.read(CompressedTelemetryLog::fileHeaderSize);
+    if ((header.size() != CompressedTelemetryLog::fileHeaderSize) || !header.startsWith(QByteArray(CompressedTelemetryLog::fileMagic, CompressedTelemetryLog::magicSize))) {
+        setErrorString(tr("Not a compressed telemetry log"));
+        _file.close();
+        return false;
+    }
+
+    const quint32 version = _getU32(header.constData() + 8);
+    if (version != CompressedTelemetryLog::version) {
+        setErrorString(tr("Unsupported compressed telemetry log version %1").arg(version));
+        _file.close();
+        return false;
+    }
+
+    if (!_readIndex()) {
+        qCDebug(CompressedTelemetryLogLog) << "Block index missing, rebuilding" << _file.fileName();
+        if (!_rebuildIndex()) {
+            setErrorString(tr("Compressed telemetry log is corrupt"));
+            _file.close();
+            return false;
+        }
+    }
+
+    _uncompressedSize = 0;
+    for (CompressedTelemetryLog::BlockInfo &info : _blocks) {
+        info.uncompressedOffset = _uncompressedSize;
+        _uncompressedSize += info.uncompressedSize;
+    }
+
+    _readPos = 0;
+    _currentBlock = -1;
+    _currentBlockData.clear();
+
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void CompressedTelemetryLogDevice::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    QIODevice::close();
+    _file.close();
+    _blocks.clear();
+    _uncompressedSize = 0;
+    _readPos = 0;
+    _currentBlock = -1;
+    _currentBlockData.clear();
+}
+
+bool CompressedTelemetryLogDevice::seek(qint64 pos)
+{
+    if ((pos < 0) || (pos > _uncompressedSize)) {
+        return false;
+    }
+
+    if (!QIODevice::seek(pos)) {
+        return false;
+    }
+
+    _readPos = pos;
+    return true;
+}
+
+quint64 CompressedTelemetryLogDevice::firstTimestampUSecs() const
+{
+    return _blocks.isEmpty() ? 0 : _blocks.first().firstTimestampUSecs;
+}
+
+quint64 CompressedTelemetryLogDevice::lastTimestampUSecs() const
+{
+    return _blocks.isEmpty() ? 0 : _blocks.last().lastTimestampUSecs;
+}
+
+bool CompressedTelemetryLogDevice::seekToTimestamp(quint64 timestampUSecs)
+{
+    if (_blocks.isEmpty()) {
+        return false;
+    }
+
+    // Last block which starts at or before the requested time
+    const auto it = std::upper_bound(_blocks.cbegin(), _blocks.cend(), timestampUSecs,
+        [](quint64 value, const CompressedTelemetryLog::BlockInfo &info) {
+            return value < info.firstTimestampUSecs;
+        });
+    const qsizetype blockIndex = (it == _blocks.cbegin()) ? 0 : (std::distance(_blocks.cbegin(), it) - 1);
+
+    return seek(_blocks[blockIndex].uncompressedOffset);
+}
+
+qint64 CompressedTelemetryLogDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 totalRead = 0;
+
+    while ((totalRead < maxSize) && (_readPos < _uncompressedSize)) {
+        const int blockIndex = _blockForPosition(_readPos);
+        if ((blockIndex < 0) || !_loadBlock(blockIndex)) {
+            return (totalRead > 0) ? totalRead : -1;
+        }
+
+        const CompressedTelemetryLog::BlockInfo &info = _blocks[blockIndex];
+        const qint64 blockPos = _readPos - info.uncompressedOffset;
+        const qint64 count = qMin(maxSize - totalRead, static_cast<qint64>(info.uncompressedSize) - blockPos);
+
+        memcpy(data + totalRead, _currentBlockData.constData() + blockPos, count);
+        totalRead += count;
+        _readPos += count;
+    }
+
+    return totalRead;
+}
+
+qint64 CompressedTelemetryLogDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data); Q_UNUSED(maxSize);
+
+    return -1;
+}
+
+bool CompressedTelemetryLogDevice::_readIndex()
+{
+    const qint64 fileSize = _file.size();
+    if (fileSize < (CompressedTelemetryLog::fileHeaderSize + CompressedTelemetryLog::footerSize)) {
+        return false;
+    }
+
+    if (!_file.seek(fileSize - CompressedTelemetryLog::footerSize)) {
+        return false;
+    }
+
+    const QByteArray footer = _file.read(CompressedTelemetryLog::footerSize);
+    if ((footer.size() != CompressedTelemetryLog::footerSize) ||
+            (footer.mid(12) != QByteArray(CompressedTelemetryLog::footerMagic, CompressedTelemetryLog::magicSize))) {
+        return false;
+    }
+
+    const qint64 indexOffset = static_cast<qint64>(_getU64(footer.constData()));
+    const quint32 blockCount = _getU32(footer.constData() + 8);
+    const qint64 indexSize = static_cast<qint64>(blockCount) * CompressedTelemetryLog::indexEntrySize;
+    if ((indexOffset < CompressedTelemetryLog::fileHeaderSize) || ((indexOffset + indexSize + CompressedTelemetryLog::footerSize) != fileSize)) {
+        return false;
+    }
+
+    if (!_file.seek(indexOffset)) {
+        return false;
+    }
+
+    const QByteArray index = _file.read(indexSize);
+    if (index.size() != indexSize) {
+        return false;
+    }
+
+    _blocks.clear();
+    _blocks.reserve(blockCount);
+    const char *entry = index.constData();
+    for (quint32 i = 0; i < blockCount; i++) {
+        CompressedTelemetryLog::BlockInfo info;
+        info.fileOffset = static_cast<qint64>(_getU64(entry));
+        info.compressedSize = _getU32(entry + 8);
+        info.uncompressedSize = _getU32(entry + 12);
+        info.firstTimestampUSecs = _getU64(entry + 16);
+        info.lastTimestampUSecs = _getU64(entry + 24);
+        if ((info.fileOffset + CompressedTelemetryLog::blockHeaderSize + info.compressedSize) > indexOffset) {
+            _blocks.clear();
+            return false;
+        }
+        _blocks.append(info);
+        entry += CompressedTelemetryLog::indexEntrySize;
+    }
+
+    return true;
+}
+
+bool CompressedTelemetryLogDevice::_rebuildIndex()
+{
+    _blocks.clear();
+
+    const qint64 fileSize = _file.size();
+    qint64 offset = CompressedTelemetryLog::fileHeaderSize;
+
+    while ((offset + CompressedTelemetryLog::blockHeaderSize) <= fileSize) {
+        if (!_file.seek(offset)) {
+            break;
+        }
+
+        const QByteArray header = _file.read(CompressedTelemetryLog::blockHeaderSize);
+        if ((header.size() != CompressedTelemetryLog::blockHeaderSize) || (_getU32(header.constData()) != CompressedTelemetryLog::blockMagic)) {
+            break;
+        }
+
+        CompressedTelemetryLog::BlockInfo info;
+        info.fileOffset = offset;
+        info.compressedSize = _getU32(header.constData() + 4);
+        info.uncompressedSize = _getU32(header.constData() + 8);
+        info.firstTimestampUSecs = _getU64(header.constData() + 12);
+        info.lastTimestampUSecs = _getU64(header.constData() + 20);
+
+        const qint64 nextOffset = offset + CompressedTelemetryLog::blockHeaderSize + info.compressedSize;
+        if (nextOffset > fileSize) {
+            // Partially written final block
+            break;
+        }
+
+        _blocks.append(info);
+        offset = nextOffset;
+    }
+
+    qCDebug(CompressedTelemetryLogLog) << "Recovered" << _blocks.count() << "blocks";
+
+    // A log which was closed before any data was written is still valid
+    return true;
+}
+
+int CompressedTelemetryLogDevice::_blockForPosition(qint64 pos) const
+{
+    if ((_currentBlock >= 0) && (pos >= _blocks[_currentBlock].uncompressedOffset) &&
+            (pos < (_blocks[_currentBlock].uncompressedOffset + _blocks[_currentBlock].uncompressedSize))) {
+        return _currentBlock;
+    }
+
+    const auto it = std::upper_bound(_blocks.cbegin(), _blocks.cend(), pos,
+        [](qint64 value, const CompressedTelemetryLog::BlockInfo &info) {
+            return value < info.uncompressedOffset;
+        });
+    if (it == _blocks.cbegin()) {
+        return -1;
+    }
+
+    return static_cast<int>(std::distance(_blocks.cbegin(), it) - 1);
+}
+
+bool CompressedTelemetryLogDevice::_loadBlock(int blockIndex)
+{
+    if (blockIndex == _currentBlock) {
+        return true;
+    }
+
+    const CompressedTelemetryLog::BlockInfo &info = _blocks[blockIndex];
+    if (!_file.seek(info.fileOffset + CompressedTelemetryLog::blockHeaderSize)) {
+        setErrorString(_file.errorString());
+        return false;
+    }
+
+    const QByteArray compressed = _file.read(info.compressedSize);
+    if (compressed.size() != static_cast<qsizetype>(info.compressedSize)) {
+        setErrorString(tr("Unexpected end of compressed telemetry log"));
+        return false;
+    }
+
+    _currentBlockData.resize(info.uncompressedSize);
+    uLongf destLength = info.uncompressedSize;
+    const int result = uncompress(reinterpret_cast<Bytef*>(_currentBlockData.data()), &destLength,
+                                  reinterpret_cast<const Bytef*>(compressed.constData()), static_cast<uLong>(compressed.size()));
+    if ((result != Z_OK) || (destLength != info.uncompressedSize)) {
+        qCWarning(CompressedTelemetryLogLog) << "Block decompression failed" << blockIndex << result;
+        setErrorString(tr("Compressed telemetry log block %1 is corrupt").arg(blockIndex));
+        _currentBlock = -1;
+        return false;
+    }
+
+    _currentBlock = blockIndex;
+    return true;
+}
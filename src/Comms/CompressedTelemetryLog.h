@@ -0,0 +1,144 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QIODevice>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QObject>
+
+#include <atomic>
+
+Q_DECLARE_LOGGING_CATEGORY(CompressedTelemetryLogLog)
+
+/// Compressed telemetry log format (.tlogz)
+///
+/// The uncompressed content is exactly a standard .tlog stream (big endian usec timestamp followed by a
+/// mavlink packet). It is split at record boundaries into blocks which are zlib compressed individually.
+/// All values are little endian.
+///
+///     File header:    "QGCTLOGZ", uint32 version, uint32 reserved
+///     Block:          uint32 "QZB1", uint32 compressed size, uint32 uncompressed size,
+///                     uint64 first timestamp, uint64 last timestamp, compressed data
+///     Index:          one entry per block - uint64 file offset, uint32 compressed size, uint32 uncompressed size,
+///                     uint64 first timestamp, uint64 last timestamp
+///     Footer:         uint64 index offset, uint32 block count, "QGCTLIDX"
+///
+/// The index allows random access by time without reading the whole file. If the index is missing, for
+/// example because QGC crashed while logging, it is rebuilt by walking the block headers.
+namespace CompressedTelemetryLog
+{
+    struct BlockInfo {
+        qint64  fileOffset          = 0;    ///< Offset of the block header
+        quint32 compressedSize      = 0;
+        quint32 uncompressedSize    = 0;
+        qint64  uncompressedOffset  = 0;    ///< Offset of the block data within the uncompressed stream
+        quint64 firstTimestampUSecs = 0;
+        quint64 lastTimestampUSecs  = 0;
+    };
+
+    /// @return true: File starts with the compressed telemetry log header
+    bool isCompressedLog(const QString &fileName);
+
+    constexpr const char fileMagic[] = "QGCTLOGZ";
+    constexpr const char footerMagic[] = "QGCTLIDX";
+    constexpr quint32 blockMagic = 0x31425A51;  ///< "QZB1"
+    constexpr quint32 version = 1;
+    constexpr int magicSize = 8;
+    constexpr int fileHeaderSize = magicSize + 4 + 4;
+    constexpr int blockHeaderSize = 4 + 4 + 4 + 8 + 8;
+    constexpr int indexEntrySize = 8 + 4 + 4 + 8 + 8;
+    constexpr int footerSize = 8 + 4 + magicSize;
+    constexpr int blockSize = 64 * 1024;        ///< Target uncompressed size of a block
+}
+
+/*===========================================================================*/
+
+/// Writes telemetry logs from a background thread. Data is handed over in batches, either written as is
+/// (.tlog) or as compressed blocks (.tlogz).
+class TelemetryLogWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TelemetryLogWriter(QObject *parent = nullptr);
+    ~TelemetryLogWriter();
+
+    /// Thread safe
+    qint64 bytesWritten() const { return _bytesWritten.load(std::memory_order_relaxed); }
+    bool error() const { return _error.load(std::memory_order_relaxed); }
+
+public slots:
+    bool open(const QString &fileName, bool compressed);
+
+    /// Writes a batch of complete log records
+    void write(const QByteArray &records, quint64 firstTimestampUSecs, quint64 lastTimestampUSecs);
+
+    /// Writes the block index (compressed logs only) and closes the file
+    void close();
+
+private:
+    bool _writeBytes(const char *data, qint64 length);
+    bool _writeCompressedBlock(const QByteArray &records, quint64 firstTimestampUSecs, quint64 lastTimestampUSecs);
+    bool _writeIndex();
+
+    QFile *_file = nullptr;
+    bool _compressed = false;
+    QList<CompressedTelemetryLog::BlockInfo> _index;
+    qint64 _uncompressedOffset = 0;
+    QByteArray _compressBuffer;
+    std::atomic<qint64> _bytesWritten = 0;
+    std::atomic<bool> _error = false;
+};
+
+/*===========================================================================*/
+
+/// Read only, random access view of the uncompressed stream of a compressed telemetry log. This allows the
+/// log to be consumed exactly like a plain .tlog QFile.
+class CompressedTelemetryLogDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit CompressedTelemetryLogDevice(const QString &fileName, QObject *parent = nullptr);
+    ~CompressedTelemetryLogDevice();
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return false; }
+    qint64 size() const override { return _uncompressedSize; }
+    bool seek(qint64 pos) override;
+
+    const QList<CompressedTelemetryLog::BlockInfo> &blocks() const { return _blocks; }
+    quint64 firstTimestampUSecs() const;
+    quint64 lastTimestampUSecs() const;
+
+    /// Moves to the start of the block which contains the specified time. Blocks always start with a record.
+    bool seekToTimestamp(quint64 timestampUSecs);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    bool _readIndex();
+    bool _rebuildIndex();
+    int _blockForPosition(qint64 pos) const;
+    bool _loadBlock(int blockIndex);
+
+    QFile _file;
+    QList<CompressedTelemetryLog::BlockInfo> _blocks;
+    qint64 _uncompressedSize = 0;
+    qint64 _readPos = 0;
+    int _currentBlock = -1;
+    QByteArray _currentBlockData;
+};
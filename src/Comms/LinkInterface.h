@@ -13,6 +13,7 @@
 #include <QtQmlIntegration/QtQmlIntegration>
 
 #include "LinkConfiguration.h"
+#include "RttEstimator.h"
 
 class LinkManager;
 
@@ -47,6 +48,9 @@ class LinkInterface : public QObject
     bool initMavlinkSigning();
     void setSigningSignatureFailure(bool failure);
 
+    /// Round trip time estimate for MAV_CMD/COMMAND_ACK exchanges over this link. Only to be used from the main thread.
+    RttEstimator &commandRttEstimator() { return _commandRttEstimator; }
+
 signals:
     void bytesReceived(LinkInterface *link, const QByteArray &data);
     void bytesSent(LinkInterface *link, const QByteArray &data);
@@ -80,6 +84,7 @@ private slots:
     bool _decodedFirstMavlinkPacket = false;
     int _vehicleReferenceCount = 0;
     bool _signingSignatureFailure = false;
+    RttEstimator _commandRttEstimator;
 };
 
 typedef std::shared_ptr<LinkInterface> SharedLinkInterfacePtr;
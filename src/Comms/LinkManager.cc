@@ -27,6 +27,7 @@
 
 #ifndef QGC_NO_SERIAL_LINK
 #include "SerialLink.h"
+#include "SerialPortWatcher.h"
 #include "GPSManager.h"
 #include "PositionManager.h"
 #include "UdpIODevice.h"
@@ -63,6 +64,7 @@ LinkManager::LinkManager(QObject *parent)
     , _qmlConfigurations(new QmlObjectListModel(this))
 #ifndef QGC_NO_SERIAL_LINK
     , _nmeaSocket(new UdpIODevice(this))
+    , _serialPortWatcher(new SerialPortWatcher(this))
 #endif
 {
     qCDebug(LinkManagerLog) << this;
@@ -91,6 +93,26 @@ void LinkManager::init()
     if (!qgcApp()->runningUnitTests()) {
         (void) connect(_portListTimer, &QTimer::timeout, this, &LinkManager::_updateAutoConnectLinks);
         _portListTimer->start(_autoconnectUpdateTimerMSecs); // timeout must be long enough to get past bootloader on second pass
+
+#ifndef QGC_NO_SERIAL_LINK
+        // Serial ports are only re-enumerated when the watcher reports a hotplug event (or when it can't and we have to poll)
+        (void) connect(_serialPortWatcher, &SerialPortWatcher::portsChanged, this, &LinkManager::_serialPortsChanged);
+        if (!_serialPortWatcher->start()) {
+            qCDebug(LinkManagerLog) << "Serial port hotplug events not available, polling for serial ports";
+        }
+
+        const QList<Fact*> serialAutoConnectFacts = {
+            _autoConnectSettings->autoConnectPixhawk(),
+            _autoConnectSettings->autoConnectSiKRadio(),
+            _autoConnectSettings->autoConnectLibrePilot(),
+            _autoConnectSettings->autoConnectRTKGPS(),
+            _autoConnectSettings->autoConnectNmeaPort(),
+            _autoConnectSettings->autoConnectNmeaBaud(),
+        };
+        for (Fact *const fact : serialAutoConnectFacts) {
+            (void) connect(fact, &Fact::rawValueChanged, this, [this]() { _serialPortsDirty = true; });
+        }
+#endif
     }
 }
 
@@ -229,6 +251,13 @@ void LinkManager::_linkDisconnected()
 
     link->_freeMavlinkChannel();
 
+#ifndef QGC_NO_SERIAL_LINK
+    // An auto-connected port which is still plugged in should be picked up again
+    if (qobject_cast<const SerialLink*>(link)) {
+        _serialPortsDirty = true;
+    }
+#endif
+
     for (auto it = _rgLinks.begin(); it != _rgLinks.end(); ++it) {
         if (it->get() == link) {
             qCDebug(LinkManagerLog) << Q_FUNC_INFO << it->get()->linkConfiguration()->name() << it->use_count();
@@ -517,7 +546,10 @@ void LinkManager::_updateAutoConnectLinks()
     }
 
 #ifndef QGC_NO_SERIAL_LINK
-    _addSerialAutoConnectLink();
+    // Ports on the wait list need further passes to get past the bootloader delay
+    if (_serialPortsDirty || !_autoconnectPortWaitList.isEmpty() || !_serialPortWatcher->isEventDriven()) {
+        _addSerialAutoConnectLink();
+    }
 #endif
 }
 
@@ -800,8 +832,24 @@ void LinkManager::_filterCompositePorts(QList<QGCSerialPortInfo> &portList)
     }
 }
 
+void LinkManager::_serialPortsChanged()
+{
+    qCDebug(LinkManagerLog) << "Serial ports changed";
+
+    _serialPortsDirty = true;
+
+    _updateSerialPorts();
+    emit commPortsChanged();
+    emit commPortStringsChanged();
+
+    // React immediately rather than waiting for the next timer pass
+    _updateAutoConnectLinks();
+}
+
 void LinkManager::_addSerialAutoConnectLink()
 {
+    _serialPortsDirty = false;
+
     QList<QGCSerialPortInfo> portList;
 #ifdef Q_OS_ANDROID
     // Android builds only support a single serial connection. Repeatedly calling availablePorts after that one serial
@@ -859,8 +907,9 @@ void LinkManager::_addSerialAutoConnectLink()
             }
 
             if (portInfo.isBootloader()) {
-                // Don't connect to bootloader
+                // Don't connect to bootloader. Not all boards re-enumerate when the bootloader exits, so keep checking.
                 qCDebug(LinkManagerLog) << "Waiting for bootloader to finish" << portInfo.systemLocation();
+                _serialPortsDirty = true;
                 continue;
             }
             if (_portAlreadyConnected(portInfo.systemLocation()) || (_autoConnectRTKPort == portInfo.systemLocation())) {
@@ -31,6 +31,7 @@ class MAVLinkProtocol;
 class QmlObjectListModel;
 class QTimer;
 class SerialLink;
+class SerialPortWatcher;
 class UDPConfiguration;
 class UdpIODevice;
 
@@ -188,10 +189,13 @@ private slots:
     void _updateSerialPorts();
     bool _allowAutoConnectToBoard(QGCSerialPortInfo::BoardType_t boardType) const;
     void _addSerialAutoConnectLink();
+    void _serialPortsChanged();
     bool _portAlreadyConnected(const QString &portName) const;
     void _filterCompositePorts(QList<QGCSerialPortInfo> &portList);
 
     UdpIODevice *_nmeaSocket = nullptr;
+    SerialPortWatcher *_serialPortWatcher = nullptr;
+    bool _serialPortsDirty = true;                 ///< true: serial ports must be re-enumerated on next autoconnect pass
     QMap<QString, int> _autoconnectPortWaitList;   ///< key: QGCSerialPortInfo::systemLocation, value: wait count
     QList<SerialLink*> _activeLinkCheckList;       ///< List of links we are waiting for a vehicle to show up on
     QStringList _commPortList;
@@ -8,6 +8,7 @@
  ****************************************************************************/
 
 #include "LogReplayLink.h"
+#include "CompressedTelemetryLog.h"
 #include "LinkManager.h"
 #include "MAVLinkProtocol.h"
 #include "MultiVehicleManager.h"
@@ -152,7 +153,11 @@ void LogReplayWorker::play()
     LinkManager::instance()->setConnectionsSuspended(tr("Connect not allowed during Flight Data replay."));
     MAVLinkProtocol::instance()->suspendLogForReplay(true);
 
-    if (_logFile.atEnd()) {
+    if (!_logFile) {
+        return;
+    }
+
+    if (_logFile->atEnd()) {
         _resetPlaybackToBeginning();
     }
 
@@ -190,10 +195,41 @@ void LogReplayWorker::movePlayhead(qreal percentComplete)
         }
     }
 
+    if (!_logFile || !_logFile->isOpen()) {
+        return;
+    }
+
     percentComplete = qBound(0., percentComplete, 100.);
     const qreal percentCompleteMult = percentComplete / 100.0;
-    const qint64 newFilePos = static_cast<qint64>(percentCompleteMult * static_cast<qreal>(_logFile.size()));
-    if (!_logFile.seek(newFilePos)) {
+
+    CompressedTelemetryLogDevice *const compressedLog = qobject_cast<CompressedTelemetryLogDevice*>(_logFile);
+    if (compressedLog) {
+        // Compressed logs carry a time index so we can go straight to the right block
+        const quint64 desiredTimeUSecs = _logStartTimeUSecs + static_cast<quint64>(percentCompleteMult * _logDurationUSecs);
+        if (!compressedLog->seekToTimestamp(desiredTimeUSecs)) {
+            emit errorOccurred(tr("Unable to seek to new position"));
+            return;
+        }
+
+        mavlink_reset_channel_status(_mavlinkChannel);
+        _logCurrentTimeUSecs = _parseTimestamp(_logFile->read(kTimestamp));
+
+        QByteArray bytes;
+        while ((_logCurrentTimeUSecs < desiredTimeUSecs) && !_logFile->atEnd()) {
+            const quint64 nextTimeUSecs = _readNextMavlinkMessage(bytes);
+            if (nextTimeUSecs == 0) {
+                break;
+            }
+            _logCurrentTimeUSecs = nextTimeUSecs;
+        }
+
+        _signalCurrentLogTimeSecs();
+        emit playbackPercentCompleteChanged((static_cast<qreal>(_logCurrentTimeUSecs - _logStartTimeUSecs) / _logDurationUSecs) * 100);
+        return;
+    }
+
+    const qint64 newFilePos = static_cast<qint64>(percentCompleteMult * static_cast<qreal>(_logFile->size()));
+    if (!_logFile->seek(newFilePos)) {
         emit errorOccurred(tr("Unable to seek to new position"));
         return;
     }
@@ -202,10 +238,10 @@ void LogReplayWorker::movePlayhead(qreal percentComplete)
     _logCurrentTimeUSecs = _seekToNextMavlinkMessage(dummy);
 
     qreal newRelativeTimeUSecs = static_cast<qreal>(_logCurrentTimeUSecs - _logStartTimeUSecs);
-    const qreal baudRate = _logFile.size() / static_cast<qreal>(_logDurationUSecs) / 1e6;
+    const qreal baudRate = _logFile->size() / static_cast<qreal>(_logDurationUSecs) / 1e6;
     const qreal desiredTimeUSecs = percentCompleteMult * _logDurationUSecs;
     const qint64 offset = (newRelativeTimeUSecs - desiredTimeUSecs) * baudRate;
-    if (!_logFile.seek(_logFile.pos() + offset)) {
+    if (!_logFile->seek(_logFile->pos() + offset)) {
         emit errorOccurred(tr("Unable to seek to new position"));
         return;
     }
@@ -220,9 +256,9 @@ void LogReplayWorker::movePlayhead(qreal percentComplete)
 
 void LogReplayWorker::_resetPlaybackToBeginning()
 {
-    if (_logFile.isOpen()) {
-        if (!_logFile.reset()) {
-            qCWarning(LogReplayLinkLog) << "failed to reset log file:" << _logFile.error() << _logFile.errorString();
+    if (_logFile && _logFile->isOpen()) {
+        if (!_logFile->reset()) {
+            qCWarning(LogReplayLinkLog) << "failed to reset log file:" << _logFile->errorString();
         }
     }
 
@@ -236,12 +272,12 @@ void LogReplayWorker::_readNextLogEntry()
     int timeToNextExecutionMSecs = 0;
     while (timeToNextExecutionMSecs < 3) {
         QByteArray bytes;
-        bytes.reserve(_logFile.bytesAvailable());
+        bytes.reserve(_logFile->bytesAvailable());
         const qint64 nextTimeUSecs = _readNextMavlinkMessage(bytes);
         emit dataReceived(bytes);
         emit playbackPercentCompleteChanged((static_cast<float>(_logCurrentTimeUSecs - _logStartTimeUSecs) / static_cast<float>(_logDurationUSecs)) * 100);
 
-        if (_logFile.atEnd()) {
+        if (_logFile->atEnd()) {
             pause();
             emit playbackAtEnd();
             return;
@@ -267,16 +303,22 @@ void LogReplayWorker::_signalCurrentLogTimeSecs()
 
 bool LogReplayWorker::_loadLogFile()
 {
-    if (_logFile.isOpen()) {
-        _logFile.close();
+    if (_logFile && _logFile->isOpen()) {
+        _logFile->close();
         emit errorOccurred(tr("Attempt to load new log while log being played"));
         return false;
     }
 
     const QString logFilename = _logReplayConfig->logFilename();
-    _logFile.setFileName(logFilename);
-    if (!_logFile.open(QFile::ReadOnly)) {
-        emit errorOccurred(tr("Unable to open log file: '%1', error: %2").arg(logFilename, _logFile.errorString()));
+    delete _logFile;
+    if (CompressedTelemetryLog::isCompressedLog(logFilename)) {
+        _logFile = new CompressedTelemetryLogDevice(logFilename, this);
+    } else {
+        _logFile = new QFile(logFilename, this);
+    }
+
+    if (!_logFile->open(QIODevice::ReadOnly)) {
+        emit errorOccurred(tr("Unable to open log file: '%1', error: %2").arg(logFilename, _logFile->errorString()));
         return false;
     }
 
@@ -284,10 +326,11 @@ bool LogReplayWorker::_loadLogFile()
     logFileInfo.setFile(logFilename);
     _logFileSize = logFileInfo.size();
 
-    const quint64 startTimeUSecs = _parseTimestamp(_logFile.read(kTimestamp));
-    const quint64 endTimeUSecs = _findLastTimestamp();
+    const quint64 startTimeUSecs = _parseTimestamp(_logFile->read(kTimestamp));
+    const CompressedTelemetryLogDevice *const compressedLog = qobject_cast<const CompressedTelemetryLogDevice*>(_logFile);
+    const quint64 endTimeUSecs = compressedLog ? compressedLog->lastTimestampUSecs() : _findLastTimestamp();
     if (endTimeUSecs <= startTimeUSecs) {
-        _logFile.close();
+        _logFile->close();
         emit errorOccurred(tr("The log file '%1' is corrupt or empty.").arg(logFilename));
         return false;
     }
@@ -297,8 +340,8 @@ bool LogReplayWorker::_loadLogFile()
     _logDurationUSecs = endTimeUSecs - startTimeUSecs;
     _logCurrentTimeUSecs = startTimeUSecs;
 
-    if (!_logFile.reset()) {
-        qCWarning(LogReplayLinkLog) << "failed to reset log file:" << _logFile.error() << _logFile.errorString();
+    if (!_logFile->reset()) {
+        qCWarning(LogReplayLinkLog) << "failed to reset log file:" << _logFile->errorString();
     }
 
     const quint64 logDurationSecondsTotal = _logDurationUSecs / 1000000;
@@ -323,7 +366,7 @@ quint64 LogReplayWorker::_readNextMavlinkMessage(QByteArray &bytes)
     bytes.clear();
 
     char nextByte;
-    while (_logFile.getChar(&nextByte)) {
+    while (_logFile->getChar(&nextByte)) {
         mavlink_message_t message{};
         mavlink_status_t status{};
         const bool messageFound = mavlink_parse_char(_mavlinkChannel, nextByte, &message, &status);
@@ -334,7 +377,7 @@ quint64 LogReplayWorker::_readNextMavlinkMessage(QByteArray &bytes)
         (void) bytes.append(nextByte);
 
         if (messageFound) {
-            const QByteArray rawTime = _logFile.read(kTimestamp);
+            const QByteArray rawTime = _logFile->read(kTimestamp);
             return _parseTimestamp(rawTime);
         }
     }
@@ -348,21 +391,21 @@ quint64 LogReplayWorker::_seekToNextMavlinkMessage(mavlink_message_t &nextMsg)
 
     qint64 messageStartPos = -1;
     char nextByte;
-    while (_logFile.getChar(&nextByte)) {
+    while (_logFile->getChar(&nextByte)) {
         mavlink_status_t status{};
         const bool messageFound = mavlink_parse_char(_mavlinkChannel, nextByte, &nextMsg, &status);
 
         if (status.parse_state == MAVLINK_PARSE_STATE_GOT_STX) {
-            messageStartPos = _logFile.pos() - 1;
+            messageStartPos = _logFile->pos() - 1;
         }
 
         if (messageFound && (messageStartPos != -1)) {
-            if (!_logFile.seek(messageStartPos - kTimestamp)) {
-                qCWarning(LogReplayLinkLog) << "Failed to seek next message:" << _logFile.error() << _logFile.errorString();
+            if (!_logFile->seek(messageStartPos - kTimestamp)) {
+                qCWarning(LogReplayLinkLog) << "Failed to seek next message:" << _logFile->errorString();
                 break;
             }
 
-            const QByteArray rawTime = _logFile.read(kTimestamp);
+            const QByteArray rawTime = _logFile->read(kTimestamp);
             return _parseTimestamp(rawTime);
         }
     }
@@ -372,20 +415,20 @@ quint64 LogReplayWorker::_seekToNextMavlinkMessage(mavlink_message_t &nextMsg)
 
 quint64 LogReplayWorker::_findLastTimestamp()
 {
-    if (!_logFile.reset()) {
-        qCWarning(LogReplayLinkLog) << "failed to reset log file:" << _logFile.error() << _logFile.errorString();
+    if (!_logFile->reset()) {
+        qCWarning(LogReplayLinkLog) << "failed to reset log file:" << _logFile->errorString();
     }
 
     mavlink_reset_channel_status(_mavlinkChannel);
 
     quint64 lastTimestamp = 0;
 
-    while (_logFile.bytesAvailable() > kTimestamp) {
-        lastTimestamp = _parseTimestamp(_logFile.read(kTimestamp));
+    while (_logFile->bytesAvailable() > kTimestamp) {
+        lastTimestamp = _parseTimestamp(_logFile->read(kTimestamp));
 
         bool endOfMessage = false;
         char nextByte;
-        while (!endOfMessage && _logFile.getChar(&nextByte)) {
+        while (!endOfMessage && _logFile->getChar(&nextByte)) {
             mavlink_message_t msg{};
             mavlink_status_t status{};
             endOfMessage = mavlink_parse_char(_mavlinkChannel, nextByte, &msg, &status);
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <QtCore/QFile>
+#include <QtCore/QIODevice>
 #include <QtCore/QLoggingCategory>
 #include <QtQmlIntegration/QtQmlIntegration>
 
@@ -115,7 +116,7 @@ private slots:
     quint64 _playbackStartTimeMSecs = 0;
     quint64 _playbackStartLogTimeUSecs = 0;
 
-    QFile _logFile;
+    QIODevice *_logFile = nullptr;  ///< QFile for .tlog, CompressedTelemetryLogDevice for .tlogz
     quint64 _logFileSize = 0;
 
     static constexpr size_t kTimestamp = sizeof(quint64);
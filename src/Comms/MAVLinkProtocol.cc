@@ -8,6 +8,7 @@
  ****************************************************************************/
 
 #include "MAVLinkProtocol.h"
+#include "CompressedTelemetryLog.h"
 #include "LinkManager.h"
 #include "MultiVehicleManager.h"
 #include "QGCApplication.h"
@@ -24,6 +25,7 @@
 #include <QtCore/QMetaType>
 #include <QtCore/QSettings>
 #include <QtCore/QStandardPaths>
+#include <QtCore/QThread>
 
 QGC_LOGGING_CATEGORY(MAVLinkProtocolLog, "Comms.MAVLinkProtocol")
 
@@ -40,6 +42,15 @@ MAVLinkProtocol::~MAVLinkProtocol()
 {
     _closeLogFile();
 
+    if (_logWriterThread) {
+        _logWriterThread->quit();
+        if (!_logWriterThread->wait()) {
+            qCWarning(MAVLinkProtocolLog) << "Failed to wait for log writer thread to close";
+        }
+        delete _logWriter;
+        _logWriter = nullptr;
+    }
+
     qCDebug(MAVLinkProtocolLog) << this;
 }
 
@@ -83,23 +94,12 @@ void MAVLinkProtocol::logSentBytes(const LinkInterface *link, const QByteArray &
 {
     Q_UNUSED(link);
 
-    if (_logSuspendError || _logSuspendReplay || !_tempLogFile->isOpen()) {
+    if (_logSuspendError || _logSuspendReplay || !_logging) {
         return;
     }
 
     const quint64 time = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() * 1000);
-    uint8_t bytes_time[sizeof(quint64)]{};
-    qToBigEndian(time, bytes_time);
-
-    QByteArray logData = data;
-    QByteArray timeData = QByteArray::fromRawData(reinterpret_cast<const char*>(bytes_time), sizeof(bytes_time));
-    (void) logData.prepend(timeData);
-    if (_tempLogFile->write(logData) != logData.length()) {
-        const QString message = QStringLiteral("MAVLink Logging failed. Could not write to file %1, logging disabled.").arg(_tempLogFile->fileName());
-        qgcApp()->showAppMessage(message, getName());
-        _stopLogging();
-        _logSuspendError = true;
-    }
+    _writeLogRecord(time, data.constData(), data.size());
 }
 
 void MAVLinkProtocol::receiveBytes(LinkInterface *link, const QByteArray &data)
@@ -224,19 +224,11 @@ void MAVLinkProtocol::_forwardSupport(const mavlink_message_t &message)
 
 void MAVLinkProtocol::_logData(LinkInterface *link, const mavlink_message_t &message)
 {
-    if (!_logSuspendError && !_logSuspendReplay && _tempLogFile->isOpen()) {
+    if (!_logSuspendError && !_logSuspendReplay && _logging) {
         const quint64 timestamp = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() * 1000);
-        uint8_t buf[MAVLINK_MAX_PACKET_LEN + sizeof(timestamp)]{};
-        qToBigEndian(timestamp, buf);
-
-        const qsizetype len = mavlink_msg_to_send_buffer(buf + sizeof(timestamp), &message) + sizeof(timestamp);
-        const QByteArray log_data(reinterpret_cast<const char*>(buf), len);
-        if (_tempLogFile->write(log_data) != len) {
-            const QString message = QStringLiteral("MAVLink Logging failed. Could not write to file %1, logging disabled.").arg(_tempLogFile->fileName());
-            qgcApp()->showAppMessage(message, getName());
-            _stopLogging();
-            _logSuspendError = true;
-        }
+        uint8_t buf[MAVLINK_MAX_PACKET_LEN]{};
+        const uint16_t len = mavlink_msg_to_send_buffer(buf, &message);
+        _writeLogRecord(timestamp, reinterpret_cast<const char*>(buf), len);
 
         if ((message.msgid == MAVLINK_MSG_ID_HEARTBEAT) && !_vehicleWasArmed) {
             if (mavlink_msg_heartbeat_get_base_mode(&message) & MAV_MODE_FLAG_DECODE_POSITION_SAFETY) {
@@ -289,19 +281,72 @@ bool MAVLinkProtocol::_updateStatus(LinkInterface *link, const SharedLinkInterfa
     return true;
 }
 
+void MAVLinkProtocol::_writeLogRecord(quint64 timestampUSecs, const char *data, qsizetype length)
+{
+    if (_logWriter->error()) {
+        _logWriteFailed();
+        return;
+    }
+
+    if (_logBuffer.isEmpty()) {
+        _logBufferFirstTimestamp = timestampUSecs;
+        _logBufferTimer.start();
+    }
+
+    uint8_t bytes_time[sizeof(quint64)]{};
+    qToBigEndian(timestampUSecs, bytes_time);
+    (void) _logBuffer.append(reinterpret_cast<const char*>(bytes_time), sizeof(bytes_time));
+    (void) _logBuffer.append(data, length);
+    _logBufferLastTimestamp = timestampUSecs;
+
+    if ((_logBuffer.size() >= CompressedTelemetryLog::blockSize) || (_logBufferTimer.elapsed() >= _logFlushIntervalMSecs)) {
+        _flushLogBuffer();
+    }
+}
+
+void MAVLinkProtocol::_flushLogBuffer()
+{
+    if (_logBuffer.isEmpty()) {
+        return;
+    }
+
+    _logBytesQueued += _logBuffer.size();
+
+    TelemetryLogWriter *const writer = _logWriter;
+    const quint64 firstTimestamp = _logBufferFirstTimestamp;
+    const quint64 lastTimestamp = _logBufferLastTimestamp;
+    (void) QMetaObject::invokeMethod(_logWriter, [writer, records = std::exchange(_logBuffer, QByteArray()), firstTimestamp, lastTimestamp]() {
+        writer->write(records, firstTimestamp, lastTimestamp);
+    }, Qt::QueuedConnection);
+
+    _logBuffer.reserve(CompressedTelemetryLog::blockSize + MAVLINK_MAX_PACKET_LEN + sizeof(quint64));
+}
+
+void MAVLinkProtocol::_logWriteFailed()
+{
+    const QString message = QStringLiteral("MAVLink Logging failed. Could not write to file %1, logging disabled.").arg(_tempLogFile->fileName());
+    qgcApp()->showAppMessage(message, getName());
+    _stopLogging();
+    _logSuspendError = true;
+}
+
 bool MAVLinkProtocol::_closeLogFile()
 {
-    if (!_tempLogFile->isOpen()) {
+    if (!_logging) {
         return false;
     }
 
-    if (_tempLogFile->size() == 0) {
-        (void) _tempLogFile->remove();
+    _flushLogBuffer();
+    _logging = false;
+
+    // Waits for all queued writes to complete
+    (void) QMetaObject::invokeMethod(_logWriter, &TelemetryLogWriter::close, Qt::BlockingQueuedConnection);
+
+    if (_logBytesQueued == 0) {
+        (void) QFile::remove(_tempLogFile->fileName());
         return false;
     }
 
-    (void) _tempLogFile->flush();
-    _tempLogFile->close();
     return true;
 }
 
@@ -322,7 +367,7 @@ void MAVLinkProtocol::_startLogging()
     }
 #endif
 
-    if (_tempLogFile->isOpen()) {
+    if (_logging) {
         return;
     }
 
@@ -330,14 +375,40 @@ void MAVLinkProtocol::_startLogging()
         return;
     }
 
-    if (!_tempLogFile->open()) {
+    // The temp file is only opened to reserve a unique name, the writer thread owns the actual file
+    const bool reserved = _tempLogFile->open();
+    _tempLogFile->close();
+
+    if (!_logWriter) {
+        _logWriter = new TelemetryLogWriter();
+        _logWriterThread = new QThread(this);
+        _logWriterThread->setObjectName(QStringLiteral("TelemetryLogWriter"));
+        _logWriter->moveToThread(_logWriterThread);
+        _logWriterThread->start();
+    }
+
+    bool opened = false;
+    if (reserved) {
+        TelemetryLogWriter *const writer = _logWriter;
+        const QString fileName = _tempLogFile->fileName();
+        const bool compressed = SettingsManager::instance()->mavlinkSettings()->telemetrySaveCompressed()->rawValue().toBool();
+        (void) QMetaObject::invokeMethod(_logWriter, [writer, fileName, compressed]() {
+            return writer->open(fileName, compressed);
+        }, Qt::BlockingQueuedConnection, &opened);
+    }
+
+    if (!opened) {
         const QString message = QStringLiteral("Opening Flight Data file for writing failed. Unable to write to %1. Please choose a different file location.").arg(_tempLogFile->fileName());
         qgcApp()->showAppMessage(message, getName());
-        _closeLogFile();
+        (void) QFile::remove(_tempLogFile->fileName());
         _logSuspendError = true;
         return;
     }
 
+    _logging = true;
+    _logBytesQueued = 0;
+    _logBuffer.clear();
+
     qCDebug(MAVLinkProtocolLog) << "Temp log" << _tempLogFile->fileName();
     (void) _checkTelemetrySavePath();
 
@@ -346,7 +417,7 @@ void MAVLinkProtocol::_startLogging()
 
 void MAVLinkProtocol::_stopLogging()
 {
-    if (_tempLogFile->isOpen() && _closeLogFile()) {
+    if (_closeLogFile()) {
         auto appSettings = SettingsManager::instance()->appSettings();
         auto mavlinkSettings = SettingsManager::instance()->mavlinkSettings();
         if ((_vehicleWasArmed || mavlinkSettings->telemetrySaveNotArmed()->rawValue().toBool()) &&
@@ -402,11 +473,12 @@ void MAVLinkProtocol::_saveTelemetryLog(const QString &tempLogfile)
 
         const QString nameFormat("%1%2.%3");
         const QString dtFormat("yyyy-MM-dd hh-mm-ss");
+        const QString extension = CompressedTelemetryLog::isCompressedLog(tempLogfile) ? AppSettings::compressedTelemetryFileExtension : AppSettings::telemetryFileExtension;
 
         int tryIndex = 1;
-        QString saveFileName = nameFormat.arg(QDateTime::currentDateTime().toString(dtFormat), QString(), AppSettings::telemetryFileExtension);
+        QString saveFileName = nameFormat.arg(QDateTime::currentDateTime().toString(dtFormat), QString(), extension);
         while (saveDir.exists(saveFileName)) {
-            saveFileName = nameFormat.arg(QDateTime::currentDateTime().toString(dtFormat), QStringLiteral(".%1").arg(tryIndex++), AppSettings::telemetryFileExtension);
+            saveFileName = nameFormat.arg(QDateTime::currentDateTime().toString(dtFormat), QStringLiteral(".%1").arg(tryIndex++), extension);
         }
 
         const QString saveFilePath = saveDir.absoluteFilePath(saveFileName);
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QObject>
 #include <QtCore/QString>
@@ -18,6 +19,8 @@
 #include "MAVLinkLib.h"
 
 class QGCTemporaryFile;
+class QThread;
+class TelemetryLogWriter;
 
 Q_DECLARE_LOGGING_CATEGORY(MAVLinkProtocolLog)
 
@@ -99,6 +102,9 @@ private slots:
 private:
     void _logData(LinkInterface *link, const mavlink_message_t &message);
     bool _closeLogFile();
+    void _writeLogRecord(quint64 timestampUSecs, const char *data, qsizetype length);
+    void _flushLogBuffer();
+    void _logWriteFailed();
     void _startLogging();
     void _stopLogging();
 
@@ -112,7 +118,15 @@ private slots:
     void _saveTelemetryLog(const QString &tempLogfile);
     bool _checkTelemetrySavePath();
 
-    QGCTemporaryFile * const _tempLogFile = nullptr;
+    QGCTemporaryFile * const _tempLogFile = nullptr;   ///< Only used to reserve a unique temp file name
+    TelemetryLogWriter *_logWriter = nullptr;           ///< Writes the log from _logWriterThread
+    QThread *_logWriterThread = nullptr;
+    bool _logging = false;                              ///< true: Temp log file is open for writing
+    QByteArray _logBuffer;                              ///< Records waiting to be handed over to the writer
+    quint64 _logBufferFirstTimestamp = 0;
+    quint64 _logBufferLastTimestamp = 0;
+    QElapsedTimer _logBufferTimer;
+    qint64 _logBytesQueued = 0;                         ///< Total bytes handed over to the writer for the current log
 
     bool _logSuspendError = false;  ///< true: Logging suspended due to error
     bool _logSuspendReplay = false; ///< true: Logging suspended due to replay
@@ -129,6 +143,7 @@ private slots:
 
     static constexpr const char *_tempLogFileTemplate = "FlightDataXXXXXX"; ///< Template for temporary log file
     static constexpr const char *_logFileExtension = "mavlink";             ///< Extension for log files
+    static constexpr int _logFlushIntervalMSecs = 1000;                     ///< Maximum time records are held before being written
 
     static constexpr uint8_t kMaxCompId = MAV_COMPONENT_ENUM_END - 1;
 };
@@ -25,6 +25,8 @@ MockConfiguration::MockConfiguration(const MockConfiguration *copy, QObject *par
     , _sendStatusText(copy->sendStatusText())
     , _incrementVehicleId(copy->incrementVehicleId())
     , _failureMode(copy->failureMode())
+    , _telemetryLoad(copy->telemetryLoad())
+    , _telemetryLoadVehicleCount(copy->telemetryLoadVehicleCount())
 {
     // qCDebug(MockConfigurationLog) << Q_FUNC_INFO << this;
 }
@@ -47,6 +49,8 @@ void MockConfiguration::copyFrom(const LinkConfiguration *source)
     setSendStatusText(mockLinkSource->sendStatusText());
     setIncrementVehicleId(mockLinkSource->incrementVehicleId());
     setFailureMode(mockLinkSource->failureMode());
+    setTelemetryLoad(mockLinkSource->telemetryLoad());
+    setTelemetryLoadVehicleCount(mockLinkSource->telemetryLoadVehicleCount());
 }
 
 void MockConfiguration::loadSettings(QSettings &settings, const QString &root)
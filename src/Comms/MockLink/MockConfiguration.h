@@ -12,6 +12,7 @@
 #include "LinkConfiguration.h"
 
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QMap>
 #include "MAVLinkLib.h"
 
 Q_DECLARE_LOGGING_CATEGORY(MockConfigurationLog)
@@ -65,6 +66,14 @@ class MockConfiguration : public LinkConfiguration
     FailureMode_t failureMode() const { return _failureMode; }
     void setFailureMode(FailureMode_t failureMode) { _failureMode = failureMode; }
 
+    /// Additional telemetry streamed by every vehicle on the link to generate load, message id to rate in Hz.
+    /// See MockLink::telemetryLoadMessageIds for the supported messages.
+    QMap<uint32_t, int> telemetryLoad() const { return _telemetryLoad; }
+    void setTelemetryLoad(const QMap<uint32_t, int> &telemetryLoad) { _telemetryLoad = telemetryLoad; }
+    /// Number of telemetry only vehicles sharing the link with the main vehicle. They send heartbeats and the telemetry load.
+    int telemetryLoadVehicleCount() const { return _telemetryLoadVehicleCount; }
+    void setTelemetryLoadVehicleCount(int count) { _telemetryLoadVehicleCount = count; }
+
 signals:
     void firmwareChanged();
     void vehicleChanged();
@@ -79,6 +88,8 @@ class MockConfiguration : public LinkConfiguration
     bool _incrementVehicleId = true;
     uint16_t _boardVendorId = 0;
     uint16_t _boardProductId = 0;
+    QMap<uint32_t, int> _telemetryLoad;
+    int _telemetryLoadVehicleCount = 0;
 
     static constexpr const char *_firmwareTypeKey = "FirmwareType";
     static constexpr const char *_vehicleTypeKey = "VehicleType";
@@ -21,6 +21,9 @@
 #include <QtCore/QTemporaryFile>
 #include <QtCore/QThread>
 #include <QtCore/QTimer>
+#include <QtCore/QtMath>
+
+#include <chrono>
 
 QGC_LOGGING_CATEGORY(MockLinkLog, "Comms.MockLink.MockLink")
 QGC_LOGGING_CATEGORY(MockLinkVerboseLog, "Comms.MockLink.MockLink:verbose")
@@ -86,6 +89,19 @@ MockLink::MockLink(SharedLinkConfigurationPtr &config, QObject *parent)
     _loadParams();
     _runningTime.start();
 
+    const QMap<uint32_t, int> telemetryLoad = _mockConfig->telemetryLoad();
+    for (auto it = telemetryLoad.constBegin(); it != telemetryLoad.constEnd(); ++it) {
+        if (!telemetryLoadMessageIds().contains(it.key())) {
+            qCWarning(MockLinkLog) << "Unsupported telemetry load message id" << it.key();
+            continue;
+        }
+        _telemetryLoadStreams.append({ it.key(), it.value(), 0 });
+    }
+    _telemetryLoadSystemIds.append(_vehicleSystemId);
+    for (int i = 0; i < _mockConfig->telemetryLoadVehicleCount(); i++) {
+        _telemetryLoadSystemIds.append(static_cast<uint8_t>(_nextVehicleSystemId++));
+    }
+
     _workerThread = new QThread(this);
     _worker = new MockLinkWorker(this);
     _worker->moveToThread(_workerThread);
@@ -148,6 +164,7 @@ void MockLink::run1HzTasks()
     _sendVibration();
     _sendBatteryStatus();
     _sendSysStatus();
+    _sendTelemetryLoadHeartbeats();
     _sendADSBVehicles();
     if (_vehicleType != MAV_TYPE_SUBMARINE) {
         _sendRemoteIDArmStatus();
@@ -212,6 +229,7 @@ void MockLink::run500HzTasks()
         _paramRequestListWorker();
         _logDownloadWorker();
         _availableModesWorker();
+        _telemetryLoadWorker();
     }
 }
 
@@ -650,6 +668,10 @@ void MockLink::_handleIncomingMavlinkBytes(const uint8_t *bytes, int cBytes)
 
 void MockLink::_handleIncomingMavlinkMsg(const mavlink_message_t &msg)
 {
+    if (_isForTelemetryOnlyVehicle(msg)) {
+        return;
+    }
+
     if (_missionItemHandler->handleMessage(msg)) {
         return;
     }
@@ -1559,6 +1581,192 @@ MockLink *MockLink::startAPMArduRoverMockLink(bool sendStatusText, MockConfigura
     return _startMockLinkWorker(QStringLiteral("ArduRover MockLink"), MAV_AUTOPILOT_ARDUPILOTMEGA, MAV_TYPE_GROUND_ROVER, sendStatusText, failureMode);
 }
 
+MockLink *MockLink::startTelemetryLoadMockLink(int vehicleCount, const QMap<uint32_t, int> &telemetryLoad)
+{
+    MockConfiguration *const mockConfig = new MockConfiguration(QStringLiteral("Telemetry Load MockLink %1").arg(_nextVehicleSystemId));
+
+    mockConfig->setFirmwareType(MAV_AUTOPILOT_PX4);
+    // MAV_TYPE_GENERIC vehicles skip the initial connect sequence when running unit tests
+    mockConfig->setVehicleType(MAV_TYPE_GENERIC);
+    mockConfig->setTelemetryLoad(telemetryLoad);
+    mockConfig->setTelemetryLoadVehicleCount(qMax(0, vehicleCount - 1));
+
+    return _startMockLink(mockConfig);
+}
+
+QList<uint32_t> MockLink::telemetryLoadMessageIds()
+{
+    static const QList<uint32_t> messageIds = {
+        MAVLINK_MSG_ID_ATTITUDE,
+        MAVLINK_MSG_ID_GLOBAL_POSITION_INT,
+        MAVLINK_MSG_ID_GPS_RAW_INT,
+        MAVLINK_MSG_ID_VFR_HUD,
+        MAVLINK_MSG_ID_HIGHRES_IMU,
+    };
+
+    return messageIds;
+}
+
+quint64 MockLink::telemetryLoadTimestampUSecs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void MockLink::_telemetryLoadWorker()
+{
+    if (_telemetryLoadStreams.isEmpty()) {
+        return;
+    }
+
+    if (!_telemetryLoadTimer.isValid()) {
+        _telemetryLoadTimer.start();
+    }
+
+    const quint64 elapsedMSecs = static_cast<quint64>(_telemetryLoadTimer.elapsed());
+    for (TelemetryLoadStream_t &stream : _telemetryLoadStreams) {
+        // Send everything which is due so the configured rate holds even when the timer fires late
+        const quint64 due = (elapsedMSecs * static_cast<quint64>(stream.rateHz)) / 1000;
+        for (; stream.sent < due; stream.sent++) {
+            for (int i = 0; i < _telemetryLoadSystemIds.count(); i++) {
+                _sendTelemetryLoadMessage(stream.msgId, _telemetryLoadSystemIds[i], i);
+            }
+        }
+    }
+}
+
+void MockLink::_sendTelemetryLoadHeartbeats()
+{
+    // The main vehicle sends its own heartbeat
+    for (int i = 1; i < _telemetryLoadSystemIds.count(); i++) {
+        mavlink_message_t msg{};
+        (void) mavlink_msg_heartbeat_pack_chan(
+            _telemetryLoadSystemIds[i],
+            _vehicleComponentId,
+            mavlinkChannel(),
+            &msg,
+            _vehicleType,       // MAV_TYPE
+            _firmwareType,      // MAV_AUTOPILOT
+            _mavBaseMode,       // MAV_MODE
+            _mavCustomMode,     // custom mode
+            _mavState           // MAV_STATE
+        );
+        respondWithMavlinkMessage(msg);
+    }
+}
+
+void MockLink::_sendTelemetryLoadMessage(uint32_t msgId, uint8_t systemId, int vehicleIndex)
+{
+    // Values keep changing so every message results in Fact updates
+    const uint32_t timeBootMSecs = static_cast<uint32_t>(_runningTime.elapsed());
+    const double phase = (timeBootMSecs / 1000.0) + vehicleIndex;
+    const double latitude = _vehicleLatitude + (vehicleIndex * 0.0001) + (qSin(phase) * 0.0001);
+    const double longitude = _vehicleLongitude + (qCos(phase) * 0.0001);
+    const double altitudeAMSL = _defaultVehicleHomeAltitude + 10.0 + qSin(phase);
+    const float yaw = static_cast<float>(qSin(phase * 0.1) * M_PI);
+
+    mavlink_message_t msg{};
+    switch (msgId) {
+    case MAVLINK_MSG_ID_ATTITUDE:
+        (void) mavlink_msg_attitude_pack_chan(
+            systemId,
+            _vehicleComponentId,
+            mavlinkChannel(),
+            &msg,
+            timeBootMSecs,
+            static_cast<float>(qSin(phase) * 0.2),  // roll
+            static_cast<float>(qCos(phase) * 0.2),  // pitch
+            yaw,
+            0.f, 0.f, 0.f                           // rollspeed, pitchspeed, yawspeed
+        );
+        break;
+    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+        (void) mavlink_msg_global_position_int_pack_chan(
+            systemId,
+            _vehicleComponentId,
+            mavlinkChannel(),
+            &msg,
+            timeBootMSecs,
+            static_cast<int32_t>(latitude * 1E7),
+            static_cast<int32_t>(longitude * 1E7),
+            static_cast<int32_t>(altitudeAMSL * 1000),
+            static_cast<int32_t>((altitudeAMSL - _defaultVehicleHomeAltitude) * 1000),
+            static_cast<int16_t>(qSin(phase) * 100), static_cast<int16_t>(qCos(phase) * 100), 0,   // vx, vy, vz
+            static_cast<uint16_t>(qRadiansToDegrees(yaw + M_PI) * 100)
+        );
+        break;
+    case MAVLINK_MSG_ID_GPS_RAW_INT:
+        (void) mavlink_msg_gps_raw_int_pack_chan(
+            systemId,
+            _vehicleComponentId,
+            mavlinkChannel(),
+            &msg,
+            static_cast<uint64_t>(timeBootMSecs) * 1000,
+            GPS_FIX_TYPE_3D_FIX,
+            static_cast<int32_t>(latitude * 1E7),
+            static_cast<int32_t>(longitude * 1E7),
+            static_cast<int32_t>(altitudeAMSL * 1000),
+            3 * 100,                                // hdop
+            3 * 100,                                // vdop
+            UINT16_MAX,                             // velocity not known
+            UINT16_MAX,                             // course over ground not known
+            static_cast<uint8_t>(8 + ((timeBootMSecs / 1000) % 4)),    // satellites visible
+            0, 0, 0, 0, 0,                          // alt_ellipsoid, h_acc, v_acc, vel_acc, hdg_acc
+            65535                                   // Yaw not provided
+        );
+        break;
+    case MAVLINK_MSG_ID_VFR_HUD:
+        (void) mavlink_msg_vfr_hud_pack_chan(
+            systemId,
+            _vehicleComponentId,
+            mavlinkChannel(),
+            &msg,
+            static_cast<float>(10 + qSin(phase)),   // airspeed
+            static_cast<float>(10 + qCos(phase)),   // groundspeed
+            static_cast<int16_t>(qRadiansToDegrees(yaw + M_PI)),
+            50,                                     // throttle
+            static_cast<float>(altitudeAMSL),
+            static_cast<float>(qCos(phase))         // climb
+        );
+        break;
+    case MAVLINK_MSG_ID_HIGHRES_IMU:
+        (void) mavlink_msg_highres_imu_pack_chan(
+            systemId,
+            _vehicleComponentId,
+            mavlinkChannel(),
+            &msg,
+            telemetryLoadTimestampUSecs(),
+            0.f, 0.f, -9.81f,                       // acc
+            static_cast<float>(qSin(phase)), 0.f, 0.f,  // gyro
+            0.2f, 0.f, 0.4f,                        // mag
+            1013.f, 0.f,                            // abs_pressure, diff_pressure
+            static_cast<float>(altitudeAMSL),       // pressure_alt
+            20.f,                                   // temperature
+            UINT16_MAX,                             // fields_updated
+            0                                       // id
+        );
+        break;
+    default:
+        return;
+    }
+
+    respondWithMavlinkMessage(msg);
+}
+
+bool MockLink::_isForTelemetryOnlyVehicle(const mavlink_message_t &msg) const
+{
+    if (_telemetryLoadSystemIds.count() < 2) {
+        return false;
+    }
+
+    const mavlink_msg_entry_t *const entry = mavlink_get_msg_entry(msg.msgid);
+    if (!entry || !(entry->flags & MAV_MSG_ENTRY_FLAG_HAVE_TARGET_SYSTEM)) {
+        return false;
+    }
+
+    const uint8_t targetSystem = _MAV_RETURN_uint8_t(&msg, entry->target_system_ofs);
+    return ((targetSystem != _vehicleSystemId) && _telemetryLoadSystemIds.contains(targetSystem));
+}
+
 void MockLink::_sendRCChannels()
 {
     mavlink_message_t msg{};
@@ -1673,12 +1881,14 @@ void MockLink::_handleLogRequestData(const mavlink_message_t &msg)
         return;
     }
 
+    _logDownloadRequestCount++;
+
     if (request.ofs > (_logDownloadFileSize - 1)) {
         qCWarning(MockLinkLog) << "_handleLogRequestData offset past end of file request.ofs:size" << request.ofs << _logDownloadFileSize;
         return;
     }
 
-    // This will trigger _logDownloadWorker to send data
+    // A new request replaces the one in progress, same as the firmware. This will trigger _logDownloadWorker to send data.
     _logDownloadCurrentOffset = request.ofs;
     if (request.ofs + request.count > _logDownloadFileSize) {
         request.count = _logDownloadFileSize - request.ofs;
@@ -1689,6 +1899,10 @@ void MockLink::_handleLogRequestData(const mavlink_message_t &msg)
 void MockLink::_logDownloadWorker()
 {
     if (_logDownloadBytesRemaining == 0) {
+        if (_logDownloadHeldMsgValid) {
+            _logDownloadHeldMsgValid = false;
+            respondWithMavlinkMessage(_logDownloadHeldMsg);
+        }
         return;
     }
 
@@ -1717,7 +1931,19 @@ void MockLink::_logDownloadWorker()
         bytesToRead,
         &buffer[0]
     );
-    respondWithMavlinkMessage(responseMsg);
+
+    if (_logDownloadRandom.generateDouble() < _logDownloadPacketLoss) {
+        qCDebug(MockLinkLog) << "_logDownloadWorker dropping packet" << _logDownloadCurrentOffset;
+    } else if (!_logDownloadHeldMsgValid && (_logDownloadRandom.generateDouble() < _logDownloadReorder)) {
+        _logDownloadHeldMsg = responseMsg;
+        _logDownloadHeldMsgValid = true;
+    } else {
+        respondWithMavlinkMessage(responseMsg);
+        if (_logDownloadHeldMsgValid) {
+            _logDownloadHeldMsgValid = false;
+            respondWithMavlinkMessage(_logDownloadHeldMsg);
+        }
+    }
 
     _logDownloadCurrentOffset += bytesToRead;
     _logDownloadBytesRemaining -= bytesToRead;
@@ -19,6 +19,7 @@
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QMap>
 #include <QtCore/QMutex>
+#include <QtCore/QRandomGenerator>
 #include <QtPositioning/QGeoCoordinate>
 
 class MockLinkFTP;
@@ -81,6 +82,16 @@ class MockLink : public LinkInterface
     /// Returns the filename for the simulated log file. Only available after a download is requested.
     QString logDownloadFile() const { return _logDownloadFilename; }
 
+    /// Sets the size of the simulated log file. Must be called before the log list is requested.
+    void setLogDownloadFileSize(uint32_t size) { _logDownloadFileSize = size; }
+
+    /// Drops the packetLoss fraction of LOG_DATA packets and sends the reorder fraction after the packet following them.
+    /// Both are reproducible from run to run.
+    void setLogDownloadErrors(double packetLoss, double reorder) { _logDownloadPacketLoss = packetLoss; _logDownloadReorder = reorder; }
+
+    /// @return Number of LOG_REQUEST_DATA messages received
+    int logDownloadRequestCount() const { return _logDownloadRequestCount; }
+
     void clearReceivedMavCommandCounts() { _receivedMavCommandCountMap.clear(); }
     int receivedMavCommandCount(MAV_CMD command) const { return _receivedMavCommandCountMap[command]; }
 
@@ -100,6 +111,17 @@ class MockLink : public LinkInterface
     static MockLink *startAPMArduSubMockLink(bool sendStatusText, MockConfiguration::FailureMode_t failureMode = MockConfiguration::FailNone);
     static MockLink *startAPMArduRoverMockLink(bool sendStatusText, MockConfiguration::FailureMode_t failureMode = MockConfiguration::FailNone);
 
+    /// Starts a link carrying vehicleCount vehicles which all stream telemetryLoad (message id to rate in Hz).
+    /// The vehicles skip the initial connect sequence so only steady state telemetry is generated.
+    static MockLink *startTelemetryLoadMockLink(int vehicleCount, const QMap<uint32_t, int> &telemetryLoad);
+
+    /// @return Message ids supported by MockConfiguration::telemetryLoad
+    static QList<uint32_t> telemetryLoadMessageIds();
+
+    /// Microseconds on a clock shared by all threads. HIGHRES_IMU telemetry load messages carry their send time
+    /// in time_usec so the receive latency can be measured.
+    static quint64 telemetryLoadTimestampUSecs();
+
     // Special commands for testing Vehicle::sendMavCommandWithHandler
     static constexpr MAV_CMD MAV_CMD_MOCKLINK_ALWAYS_RESULT_ACCEPTED = MAV_CMD_USER_1;
     static constexpr MAV_CMD MAV_CMD_MOCKLINK_ALWAYS_RESULT_FAILED = MAV_CMD_USER_2;
@@ -193,6 +215,11 @@ private slots:
     void _paramRequestListWorker();
     void _logDownloadWorker();
     void _availableModesWorker();
+    void _telemetryLoadWorker();
+    void _sendTelemetryLoadHeartbeats();
+    void _sendTelemetryLoadMessage(uint32_t msgId, uint8_t systemId, int vehicleIndex);
+    /// @return true: msg targets one of the telemetry only vehicles, which do not respond to anything
+    bool _isForTelemetryOnlyVehicle(const mavlink_message_t &msg) const;
     void _sendAvailableMode(uint8_t modeIndexOneBased);
     int  _availableModesCount() const;
     void _moveADSBVehicle(int vehicleIndex);
@@ -259,6 +286,22 @@ private slots:
     QString _logDownloadFilename;                       ///< Filename for log download which is in progress
     uint32_t _logDownloadCurrentOffset = 0;             ///< Current offset we are sending from
     uint32_t _logDownloadBytesRemaining = 0;            ///< Number of bytes still to send, 0 = send inactive
+    uint32_t _logDownloadFileSize = 1000;               ///< Size of simulated log file
+    double _logDownloadPacketLoss = 0.0;
+    double _logDownloadReorder = 0.0;
+    QRandomGenerator _logDownloadRandom{42};            ///< Fixed seed so lossy downloads see the same errors on every run
+    mavlink_message_t _logDownloadHeldMsg{};            ///< Packet being held back to send out of order
+    bool _logDownloadHeldMsgValid = false;
+    int _logDownloadRequestCount = 0;
+
+    struct TelemetryLoadStream_t {
+        uint32_t msgId = 0;
+        int rateHz = 0;
+        quint64 sent = 0;                               ///< Messages sent so far by each vehicle
+    };
+    QList<TelemetryLoadStream_t> _telemetryLoadStreams;
+    QList<uint8_t> _telemetryLoadSystemIds;             ///< Main vehicle followed by the telemetry only vehicles
+    QElapsedTimer _telemetryLoadTimer;
 
     bool _sendGimbalManagerStatusNow = false;
     bool _sendGimbalDeviceAttitudeStatusNow = false;
@@ -292,7 +335,6 @@ private slots:
     static constexpr uint8_t _vehicleComponentId = MAV_COMP_ID_AUTOPILOT1;
 
     static constexpr uint16_t _logDownloadLogId = 0;        ///< Id of siumulated log file
-    static constexpr uint32_t _logDownloadFileSize = 1000;  ///< Size of simulated log file
 
     static constexpr bool _mavlinkStarted = true;
 
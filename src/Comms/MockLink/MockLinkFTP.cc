@@ -9,9 +9,15 @@
 
 #include "MockLinkFTP.h"
 #include "MockLink.h"
+#include "QGC.h"
 #include "QGCLoggingCategory.h"
 #include "QGCTemporaryFile.h"
 
+#include <QtCore/QBuffer>
+#include <QtCore/QFile>
+#include <QtCore/QTimer>
+#include <QtCore/QtEndian>
+
 QGC_LOGGING_CATEGORY(MockLinkFTPLog, "Comms.MockLink.MockLinkFTP")
 
 MockLinkFTP::MockLinkFTP(uint8_t systemIdServer, uint8_t componentIdServer, MockLink *mockLink)
@@ -26,6 +32,10 @@ MockLinkFTP::MockLinkFTP(uint8_t systemIdServer, uint8_t componentIdServer, Mock
 MockLinkFTP::~MockLinkFTP()
 {
     // qCDebug(MockLinkFTPLog) << Q_FUNC_INFO << this;
+
+    for (const uint8_t sessionId : _sessions.keys()) {
+        _closeSession(sessionId);
+    }
 }
 
 void MockLinkFTP::ensureNullTemination(MavlinkFTP::Request *request)
@@ -109,45 +119,35 @@ void MockLinkFTP::_openCommand(uint8_t senderSystemId, uint8_t senderComponentId
     Q_ASSERT(cchPath != sizeof(request->data));
     Q_UNUSED(cchPath); // Fix initialized-but-not-referenced warning on release builds
 
-    _currentFile.close();
-
-    QString tmpFilename;
-    const QString sizePrefix = sizeFilenamePrefix;
-    if (path.startsWith(sizePrefix)) {
-        const QString sizeString = path.right(path.length() - sizePrefix.length());
-        tmpFilename = _createTestTempFile(sizeString.toInt());
-    } else if (path == "/general.json") {
-        tmpFilename = QStringLiteral(":MockLink/General.MetaData.json");
-    } else if (path == "/general.json.xz") {
-        tmpFilename = QStringLiteral(":MockLink/General.MetaData.json.xz");
-    } else if (path == "/parameter.json") {
-        tmpFilename = QStringLiteral(":MockLink/Parameter.MetaData.json");
-    } else if (path == "/parameter.json.xz") {
-        tmpFilename = QStringLiteral(":MockLink/Parameter.MetaData.json.xz");
-    } else if (_BinParamFileEnabled && (path == "@PARAM/param.pck")) {
-        tmpFilename = ":MockLink/Arduplane.params.ftp.bin";
+    const uint8_t sessionId = _allocateSession();
+    if (sessionId == 0) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrNoSessionsAvailable, outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
+        return;
     }
 
-    if (!tmpFilename.isEmpty()) {
-        _currentFile.setFileName(tmpFilename);
-        if (!_currentFile.open(QIODevice::ReadOnly)) {
-            _sendNakErrno(senderSystemId, senderComponentId, _currentFile.error(), outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
-            return;
-        }
-    } else {
+    Session_t session;
+    session.device = _openFile(path, session.removeOnClose);
+    if (!session.device) {
         _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFailFileNotFound, outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
         return;
     }
+    if (!session.device->isOpen()) {
+        const QFile *const file = qobject_cast<QFile*>(session.device);
+        _sendNakErrno(senderSystemId, senderComponentId, file ? file->error() : QFile::OpenError, outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
+        delete session.device;
+        return;
+    }
+    _sessions[sessionId] = session;
 
     response.hdr.opcode = MavlinkFTP::kRspAck;
     response.hdr.req_opcode = MavlinkFTP::kCmdOpenFileRO;
-    response.hdr.session = _sessionId;
+    response.hdr.session = sessionId;
 
     // Data contains file length
     response.hdr.size = sizeof(uint32_t);
 
     // Ardupilot sends constant wrong file size for parameter file due to dynamic on the fly generation
-    response.openFileLength = ((path == "@PARAM/param.pck") ? qPow(1024, 2) : _currentFile.size());
+    response.openFileLength = ((path == "@PARAM/param.pck") ? qPow(1024, 2) : session.device->size());
 
     _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
 }
@@ -157,7 +157,8 @@ void MockLinkFTP::_readCommand(uint8_t senderSystemId, uint8_t senderComponentId
     MavlinkFTP::Request	response{};
     const uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
 
-    if (request->hdr.session != _sessionId) {
+    QIODevice *const device = _sessions.value(request->hdr.session).device;
+    if (!device) {
         _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrInvalidSession, outgoingSeqNumber, MavlinkFTP::kCmdReadFile);
         return;
     }
@@ -177,20 +178,20 @@ void MockLinkFTP::_readCommand(uint8_t senderSystemId, uint8_t senderComponentId
         }
     }
 
-    if (readOffset >= _currentFile.size()) {
-        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrEOF, outgoingSeqNumber, MavlinkFTP::kCmdReadFile);
+    if (readOffset >= device->size()) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrEOF, outgoingSeqNumber, MavlinkFTP::kCmdReadFile, request->hdr.session);
         return;
     }
 
-    const uint8_t cBytesToRead = static_cast<uint8_t>(qMin(static_cast<qint64>(sizeof(response.data)), _currentFile.size() - readOffset));
-    (void) _currentFile.seek(readOffset);
-    const QByteArray bytes = _currentFile.read(cBytesToRead);
+    const uint8_t cBytesToRead = static_cast<uint8_t>(qMin(static_cast<qint64>(sizeof(response.data)), device->size() - readOffset));
+    (void) device->seek(readOffset);
+    const QByteArray bytes = device->read(cBytesToRead);
     (void) memcpy(response.data, bytes.constData(), cBytesToRead);
 
     // We should always have written something, otherwise there is something wrong with the code above
     Q_ASSERT(cBytesToRead);
 
-    response.hdr.session = _sessionId;
+    response.hdr.session = request->hdr.session;
     response.hdr.size = cBytesToRead;
     response.hdr.offset = request->hdr.offset;
     response.hdr.opcode = MavlinkFTP::kRspAck;
@@ -204,7 +205,8 @@ void MockLinkFTP::_burstReadCommand(uint8_t senderSystemId, uint8_t senderCompon
     MavlinkFTP::Request response{};
     uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
 
-    if (request->hdr.session != _sessionId) {
+    QIODevice *const device = _sessions.value(request->hdr.session).device;
+    if (!device) {
         _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFail, outgoingSeqNumber, MavlinkFTP::kCmdBurstReadFile);
         return;
     }
@@ -213,16 +215,16 @@ void MockLinkFTP::_burstReadCommand(uint8_t senderSystemId, uint8_t senderCompon
     int burstCount = 1;
     uint32_t burstOffset = request->hdr.offset;
 
-    while ((burstOffset < _currentFile.size()) && (burstCount++ < burstMax)) {
-        _currentFile.seek(burstOffset);
+    while ((burstOffset < device->size()) && (burstCount++ < burstMax)) {
+        (void) device->seek(burstOffset);
 
-        const uint8_t cBytes = static_cast<uint8_t>(qMin(static_cast<qint64>(sizeof(response.data)), _currentFile.size() - burstOffset));
-        const QByteArray bytes = _currentFile.read(cBytes);
+        const uint8_t cBytes = static_cast<uint8_t>(qMin(static_cast<qint64>(sizeof(response.data)), device->size() - burstOffset));
+        const QByteArray bytes = device->read(cBytes);
         Q_ASSERT(cBytes); // We should always have written something, otherwise there is something wrong with the code above
 
         (void) memcpy(response.data, bytes.constData(), cBytes);
 
-        response.hdr.session = _sessionId;
+        response.hdr.session = request->hdr.session;
         response.hdr.size = cBytes;
         response.hdr.offset = burstOffset;
         response.hdr.opcode = MavlinkFTP::kRspAck;
@@ -235,9 +237,9 @@ void MockLinkFTP::_burstReadCommand(uint8_t senderSystemId, uint8_t senderCompon
         burstOffset += cBytes;
     }
 
-    if (burstOffset >= _currentFile.size()) {
+    if (burstOffset >= device->size()) {
         // Burst is fully complete
-        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrEOF, outgoingSeqNumber, MavlinkFTP::kCmdBurstReadFile);
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrEOF, outgoingSeqNumber, MavlinkFTP::kCmdBurstReadFile, request->hdr.session);
     }
 }
 
@@ -245,12 +247,13 @@ void MockLinkFTP::_terminateCommand(uint8_t senderSystemId, uint8_t senderCompon
 {
     const uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
 
-    if (request->hdr.session != _sessionId) {
-        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrInvalidSession, outgoingSeqNumber, MavlinkFTP::kCmdTerminateSession);
+    if (!_sessions.contains(request->hdr.session)) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrInvalidSession, outgoingSeqNumber, MavlinkFTP::kCmdTerminateSession, request->hdr.session);
         return;
     }
 
-    _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, MavlinkFTP::kCmdTerminateSession);
+    _closeSession(request->hdr.session);
+    _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, MavlinkFTP::kCmdTerminateSession, request->hdr.session);
 
     emit terminateCommandReceived();
 }
@@ -259,13 +262,214 @@ void MockLinkFTP::_resetCommand(uint8_t senderSystemId, uint8_t senderComponentI
 {
     const uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
 
-    _currentFile.close();
-    _currentFile.remove();
+    for (const uint8_t sessionId : _sessions.keys()) {
+        _closeSession(sessionId);
+    }
     _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, MavlinkFTP::kCmdResetSessions);
 
     emit resetCommandReceived();
 }
 
+void MockLinkFTP::_createCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request *request, uint16_t seqNumber)
+{
+    ensureNullTemination(request);
+    const QString path = reinterpret_cast<char*>(request->data);
+
+    const uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
+
+    if (_files.contains(path)) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFailFileExists, outgoingSeqNumber, MavlinkFTP::kCmdCreateFile);
+        return;
+    }
+
+    const uint8_t sessionId = _allocateSession();
+    if (sessionId == 0) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrNoSessionsAvailable, outgoingSeqNumber, MavlinkFTP::kCmdCreateFile);
+        return;
+    }
+
+    Session_t session;
+    session.writePath = path;
+    _sessions[sessionId] = session;
+    _files[path] = QByteArray();
+
+    _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, MavlinkFTP::kCmdCreateFile, sessionId);
+}
+
+void MockLinkFTP::_writeCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request *request, uint16_t seqNumber)
+{
+    MavlinkFTP::Request response{};
+    const uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
+
+    const QString writePath = _sessions.value(request->hdr.session).writePath;
+    if (writePath.isEmpty()) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrInvalidSession, outgoingSeqNumber, MavlinkFTP::kCmdWriteFile);
+        return;
+    }
+
+    const uint32_t writeOffset = request->hdr.offset;
+    const uint8_t cBytesToWrite = request->hdr.size;
+
+    // Writes may arrive out of order, anything not written yet reads as zero
+    QByteArray &contents = _files[writePath];
+    const qsizetype writeEnd = static_cast<qsizetype>(writeOffset) + cBytesToWrite;
+    if (contents.size() < writeEnd) {
+        (void) contents.append(QByteArray(writeEnd - contents.size(), '\0'));
+    }
+    (void) contents.replace(writeOffset, cBytesToWrite, reinterpret_cast<const char*>(request->data), cBytesToWrite);
+
+    response.hdr.opcode = MavlinkFTP::kRspAck;
+    response.hdr.req_opcode = MavlinkFTP::kCmdWriteFile;
+    response.hdr.session = request->hdr.session;
+    response.hdr.offset = writeOffset;
+    response.hdr.size = sizeof(uint32_t);
+    response.writeFileLength = cBytesToWrite;
+
+    _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
+}
+
+void MockLinkFTP::_removeCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request *request, uint16_t seqNumber)
+{
+    ensureNullTemination(request);
+    const QString path = reinterpret_cast<char*>(request->data);
+
+    const uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
+
+    if (!_files.remove(path)) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFailFileNotFound, outgoingSeqNumber, MavlinkFTP::kCmdRemoveFile);
+        return;
+    }
+
+    _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, MavlinkFTP::kCmdRemoveFile);
+}
+
+void MockLinkFTP::_createDirectoryCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request *request, uint16_t seqNumber)
+{
+    ensureNullTemination(request);
+    const QString path = reinterpret_cast<char*>(request->data);
+
+    const uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
+
+    if (_directories.contains(path)) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFailFileExists, outgoingSeqNumber, MavlinkFTP::kCmdCreateDirectory);
+        return;
+    }
+
+    (void) _directories.insert(path);
+    _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, MavlinkFTP::kCmdCreateDirectory);
+}
+
+void MockLinkFTP::_calcFileCRC32Command(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request *request, uint16_t seqNumber)
+{
+    MavlinkFTP::Request response{};
+    ensureNullTemination(request);
+    const QString path = reinterpret_cast<char*>(request->data);
+
+    const uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
+
+    bool removeOnClose = false;
+    QIODevice *const device = _openFile(path, removeOnClose);
+    if (!device) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFailFileNotFound, outgoingSeqNumber, MavlinkFTP::kCmdCalcFileCRC32);
+        return;
+    }
+
+    const QByteArray contents = device->readAll();
+    if (removeOnClose) {
+        (void) static_cast<QFile*>(device)->remove();
+    }
+    delete device;
+
+    const quint32 crc32 = QGC::crc32(reinterpret_cast<const quint8*>(contents.constData()), static_cast<unsigned>(contents.size()), 0);
+
+    response.hdr.opcode = MavlinkFTP::kRspAck;
+    response.hdr.req_opcode = MavlinkFTP::kCmdCalcFileCRC32;
+    response.hdr.size = sizeof(uint32_t);
+    qToLittleEndian<quint32>(crc32, response.data);
+
+    _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
+}
+
+QIODevice *MockLinkFTP::_openFile(const QString &path, bool &removeOnClose)
+{
+    removeOnClose = false;
+
+    if (_files.contains(path)) {
+        QBuffer *const buffer = new QBuffer(this);
+        buffer->setData(_files.value(path));
+        (void) buffer->open(QIODevice::ReadOnly);
+        return buffer;
+    }
+
+    QString tmpFilename;
+    const QString sizePrefix = sizeFilenamePrefix;
+    if (path.startsWith(sizePrefix)) {
+        const QString sizeString = path.right(path.length() - sizePrefix.length());
+        tmpFilename = _createTestTempFile(sizeString.toInt());
+        removeOnClose = true;
+    } else if (path == "/general.json") {
+        tmpFilename = QStringLiteral(":MockLink/General.MetaData.json");
+    } else if (path == "/general.json.xz") {
+        tmpFilename = QStringLiteral(":MockLink/General.MetaData.json.xz");
+    } else if (path == "/parameter.json") {
+        tmpFilename = QStringLiteral(":MockLink/Parameter.MetaData.json");
+    } else if (path == "/parameter.json.xz") {
+        tmpFilename = QStringLiteral(":MockLink/Parameter.MetaData.json.xz");
+    } else if (_BinParamFileEnabled && (path == "@PARAM/param.pck")) {
+        tmpFilename = ":MockLink/Arduplane.params.ftp.bin";
+    }
+
+    if (tmpFilename.isEmpty()) {
+        return nullptr;
+    }
+
+    QFile *const file = new QFile(tmpFilename, this);
+    (void) file->open(QIODevice::ReadOnly);
+    return file;
+}
+
+uint8_t MockLinkFTP::_allocateSession() const
+{
+    if (_sessions.count() >= _maxSessions) {
+        return 0;
+    }
+
+    uint8_t sessionId = 1;
+    while (_sessions.contains(sessionId)) {
+        sessionId++;
+    }
+
+    return sessionId;
+}
+
+void MockLinkFTP::_closeSession(uint8_t sessionId)
+{
+    const Session_t session = _sessions.take(sessionId);
+    if (!session.device) {
+        return;
+    }
+
+    session.device->close();
+    if (session.removeOnClose) {
+        (void) static_cast<QFile*>(session.device)->remove();
+    }
+    delete session.device;
+}
+
+bool MockLinkFTP::_dropPacket(uint8_t opcode)
+{
+    if (_packetLoss <= 0.0) {
+        return false;
+    }
+
+    // Opening a session can't be retried safely: a lost response leaves a session open which the client doesn't know about
+    if ((opcode == MavlinkFTP::kCmdOpenFileRO) || (opcode == MavlinkFTP::kCmdCreateFile) || (opcode == MavlinkFTP::kCmdResetSessions)) {
+        return false;
+    }
+
+    return (_random.generateDouble() < _packetLoss);
+}
+
 void MockLinkFTP::mavlinkMessageReceived(const mavlink_message_t &message)
 {
     if (message.msgid != MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL) {
@@ -279,16 +483,33 @@ void MockLinkFTP::mavlinkMessageReceived(const mavlink_message_t &message)
         return;
     }
 
-    MavlinkFTP::Request *request = reinterpret_cast<MavlinkFTP::Request*>(&requestFTP.payload[0]);
+    const MavlinkFTP::Request *const request = reinterpret_cast<const MavlinkFTP::Request*>(&requestFTP.payload[0]);
+    if (_dropPacket(request->hdr.opcode)) {
+        qCDebug(MockLinkFTPLog) << "MockLinkFTP: Random drop of incoming packet";
+        return;
+    }
 
-    // kCmdOpenFileRO and kCmdResetSessions don't support retry so we can't drop those
-    if (_randomDropsEnabled && (request->hdr.opcode != MavlinkFTP::kCmdOpenFileRO) && (request->hdr.opcode != MavlinkFTP::kCmdResetSessions)) {
-        if ((rand() % 5) == 0) {
-            qCDebug(MockLinkFTPLog) << "MockLinkFTP: Random drop of incoming packet";
-            return;
-        }
+    if (_latencyMSecs <= 0) {
+        _processRequest(message);
+        return;
     }
 
+    // Timers with the same interval fire in order, so requests are still handled in the order they arrived
+    _requestsInFlight++;
+    _maxRequestsInFlight = qMax(_maxRequestsInFlight, _requestsInFlight);
+    QTimer::singleShot(_latencyMSecs, this, [this, message]() {
+        _requestsInFlight--;
+        _processRequest(message);
+    });
+}
+
+void MockLinkFTP::_processRequest(const mavlink_message_t &message)
+{
+    mavlink_file_transfer_protocol_t requestFTP{};
+    mavlink_msg_file_transfer_protocol_decode(&message, &requestFTP);
+
+    MavlinkFTP::Request *const request = reinterpret_cast<MavlinkFTP::Request*>(&requestFTP.payload[0]);
+
     if (_lastReplyValid && (request->hdr.seqNumber == (_lastReplySequence - 1))) {
         // This is the same request as the one we replied to last. It means the (n)ack got lost, and the GCS
         // resent the request
@@ -340,6 +561,21 @@ void MockLinkFTP::mavlinkMessageReceived(const mavlink_message_t &message)
     case MavlinkFTP::kCmdResetSessions:
         _resetCommand(message.sysid, message.compid, incomingSeqNumber);
         break;
+    case MavlinkFTP::kCmdCreateFile:
+        _createCommand(message.sysid, message.compid, request, incomingSeqNumber);
+        break;
+    case MavlinkFTP::kCmdWriteFile:
+        _writeCommand(message.sysid, message.compid, request, incomingSeqNumber);
+        break;
+    case MavlinkFTP::kCmdRemoveFile:
+        _removeCommand(message.sysid, message.compid, request, incomingSeqNumber);
+        break;
+    case MavlinkFTP::kCmdCreateDirectory:
+        _createDirectoryCommand(message.sysid, message.compid, request, incomingSeqNumber);
+        break;
+    case MavlinkFTP::kCmdCalcFileCRC32:
+        _calcFileCRC32Command(message.sysid, message.compid, request, incomingSeqNumber);
+        break;
     default:
         // nack for all NYI opcodes
         _sendNak(message.sysid, message.compid, MavlinkFTP::kErrUnknownCommand, outgoingSeqNumber, static_cast<MavlinkFTP::OpCode_t>(request->hdr.opcode));
@@ -347,38 +583,38 @@ void MockLinkFTP::mavlinkMessageReceived(const mavlink_message_t &message)
     }
 }
 
-void MockLinkFTP::_sendAck(uint8_t targetSystemId, uint8_t targetComponentId, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpcode)
+void MockLinkFTP::_sendAck(uint8_t targetSystemId, uint8_t targetComponentId, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpcode, uint8_t session)
 {
     MavlinkFTP::Request ackResponse{};
 
     ackResponse.hdr.opcode = MavlinkFTP::kRspAck;
     ackResponse.hdr.req_opcode = reqOpcode;
-    ackResponse.hdr.session = _sessionId;
+    ackResponse.hdr.session = session;
     ackResponse.hdr.size = 0;
 
     _sendResponse(targetSystemId, targetComponentId, &ackResponse, seqNumber);
 }
 
-void MockLinkFTP::_sendNak(uint8_t targetSystemId, uint8_t targetComponentId, MavlinkFTP::ErrorCode_t error, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpcode)
+void MockLinkFTP::_sendNak(uint8_t targetSystemId, uint8_t targetComponentId, MavlinkFTP::ErrorCode_t error, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpcode, uint8_t session)
 {
     MavlinkFTP::Request nakResponse{};
 
     nakResponse.hdr.opcode = MavlinkFTP::kRspNak;
     nakResponse.hdr.req_opcode = reqOpcode;
-    nakResponse.hdr.session = _sessionId;
+    nakResponse.hdr.session = session;
     nakResponse.hdr.size = 1;
     nakResponse.data[0] = error;
 
     _sendResponse(targetSystemId, targetComponentId, &nakResponse, seqNumber);
 }
 
-void MockLinkFTP::_sendNakErrno(uint8_t targetSystemId, uint8_t targetComponentId, uint8_t nakErrno, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpcode)
+void MockLinkFTP::_sendNakErrno(uint8_t targetSystemId, uint8_t targetComponentId, uint8_t nakErrno, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpcode, uint8_t session)
 {
     MavlinkFTP::Request nakResponse{};
 
     nakResponse.hdr.opcode = MavlinkFTP::kRspNak;
     nakResponse.hdr.req_opcode = reqOpcode;
-    nakResponse.hdr.session = _sessionId;
+    nakResponse.hdr.session = session;
     nakResponse.hdr.size = 2;
     nakResponse.data[0] = MavlinkFTP::kErrFailErrno;
     nakResponse.data[1] = nakErrno;
@@ -404,12 +640,9 @@ void MockLinkFTP::_sendResponse(uint8_t targetSystemId, uint8_t targetComponentI
         reinterpret_cast<uint8_t*>(request) // Payload
     );
 
-    // kCmdOpenFileRO and kCmdResetSessions don't support retry so we can't drop those
-    if (_randomDropsEnabled && (request->hdr.req_opcode != MavlinkFTP::kCmdOpenFileRO) && (request->hdr.req_opcode != MavlinkFTP::kCmdResetSessions)) {
-        if ((rand() % 5) == 0) {
-            qCDebug(MockLinkFTPLog) << "MockLinkFTP: Random drop of outgoing packet";
-            return;
-        }
+    if (_dropPacket(request->hdr.req_opcode)) {
+        qCDebug(MockLinkFTPLog) << "MockLinkFTP: Random drop of outgoing packet";
+        return;
     }
 
     _mockLink->respondWithMavlinkMessage(_lastReply);
@@ -9,9 +9,12 @@
 
 #pragma once
 
-#include <QtCore/QFile>
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QObject>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QSet>
 #include <QtCore/QStringList>
 
 #include "MAVLinkFTP.h"
@@ -19,6 +22,7 @@
 Q_DECLARE_LOGGING_CATEGORY(MockLinkFTPLog)
 
 class MockLink;
+class QIODevice;
 
 /// Mock implementation of Mavlink FTP server.
 class MockLinkFTP : public QObject
@@ -36,9 +40,27 @@ class MockLinkFTP : public QObject
     /// Called to handle an FTP message
     void mavlinkMessageReceived(const mavlink_message_t &message);
 
-    void enableRandromDrops(bool enable) { _randomDropsEnabled = enable; }
+    void enableRandromDrops(bool enable) { setPacketLoss(enable ? 0.2 : 0.0); }
     void enableBinParamFile(bool enable) { _BinParamFileEnabled = enable; }
 
+    /// Drops the given fraction of incoming and outgoing packets. Drops are reproducible from run to run.
+    void setPacketLoss(double packetLoss) { _packetLoss = packetLoss; }
+
+    /// Delays handling of incoming requests to simulate the round trip time of a slow link
+    void setLatency(int msecs) { _latencyMSecs = msecs; }
+
+    /// @return Largest number of requests which were waiting for the link latency at the same time
+    int maxRequestsInFlight() const { return _maxRequestsInFlight; }
+
+    /// Sets the number of sessions which can be open at the same time (PX4 and ArduPilot support one)
+    void setMaxSessions(int maxSessions) { _maxSessions = maxSessions; }
+
+    /// Files created through kCmdCreateFile live in memory. Downloads of the same path are served from there.
+    QByteArray file(const QString &path) const { return _files.value(path); }
+    bool fileExists(const QString &path) const { return _files.contains(path); }
+    void setFile(const QString &path, const QByteArray &contents) { _files[path] = contents; }
+    bool directoryExists(const QString &path) const { return _directories.contains(path); }
+
     /// By calling setErrorMode with one of these modes you can cause the server to simulate an error.
     enum ErrorMode_t {
         errModeNone,                        ///< No error, respond correctly
@@ -77,10 +99,17 @@ class MockLinkFTP : public QObject
     void resetCommandReceived();
 
 private:
+    struct Session_t {
+        QIODevice *device = nullptr;    ///< File being read, nullptr for write sessions
+        QString writePath;              ///< Entry of _files being written
+        bool removeOnClose = false;     ///< device is a temporary file created for the session
+    };
+
+    void _processRequest(const mavlink_message_t &message);
     /// Sends an Ack
-    void _sendAck(uint8_t targetSystemId, uint8_t targetComponentId, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpCode);
-    void _sendNak(uint8_t targetSystemId, uint8_t targetComponentId, MavlinkFTP::ErrorCode_t error, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpCode);
-    void _sendNakErrno(uint8_t targetSystemId, uint8_t targetComponentId, uint8_t nakErrno, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpCode);
+    void _sendAck(uint8_t targetSystemId, uint8_t targetComponentId, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpCode, uint8_t session = 0);
+    void _sendNak(uint8_t targetSystemId, uint8_t targetComponentId, MavlinkFTP::ErrorCode_t error, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpCode, uint8_t session = 0);
+    void _sendNakErrno(uint8_t targetSystemId, uint8_t targetComponentId, uint8_t nakErrno, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpCode, uint8_t session = 0);
     /// Emits a Request through the messageReceived signal.
     void _sendResponse(uint8_t targetSystemId, uint8_t targetComponentId, MavlinkFTP::Request *request, uint16_t seqNumber);
     /// Handles List command requests. Only supports root folder paths.
@@ -91,6 +120,19 @@ class MockLinkFTP : public QObject
     void _burstReadCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request *request, uint16_t seqNumber);
     void _terminateCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request *request, uint16_t seqNumber);
     void _resetCommand(uint8_t senderSystemId, uint8_t senderComponentId, uint16_t seqNumber);
+    void _createCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request *request, uint16_t seqNumber);
+    void _writeCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request *request, uint16_t seqNumber);
+    void _removeCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request *request, uint16_t seqNumber);
+    void _createDirectoryCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request *request, uint16_t seqNumber);
+    void _calcFileCRC32Command(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request *request, uint16_t seqNumber);
+    /// Opens the file at path for reading, either from _files or one of the canned files
+    /// @return nullptr if the file does not exist, device is not open if opening failed
+    QIODevice *_openFile(const QString &path, bool &removeOnClose);
+    /// @return Id of a free session, 0 if all are in use
+    uint8_t _allocateSession() const;
+    void _closeSession(uint8_t sessionId);
+    /// @return true: packet should be dropped to simulate packet loss
+    bool _dropPacket(uint8_t opcode);
     /// Generates the next sequence number given an incoming sequence number. Handles generating
     /// bad sequence numbers when errModeBadSequence is set.
     uint16_t _nextSeqNumber(uint16_t seqNumber) const;
@@ -105,13 +147,18 @@ class MockLinkFTP : public QObject
 
     bool _BinParamFileEnabled = false;
     bool _lastReplyValid = false;
-    bool _randomDropsEnabled = false;
+    double _packetLoss = 0.0;
+    QRandomGenerator _random{42};               ///< Fixed seed so lossy tests see the same drops on every run
+    int _latencyMSecs = 0;
+    int _requestsInFlight = 0;
+    int _maxRequestsInFlight = 0;
+    int _maxSessions = 1;
     ErrorMode_t _errMode = errModeNone;         ///< Currently set error mode, as specified by setErrorMode
     mavlink_message_t _lastReply{};
-    QFile _currentFile;
+    QHash<uint8_t, Session_t> _sessions;        ///< Open sessions by session id
+    QHash<QString, QByteArray> _files;          ///< Files created by the client
+    QSet<QString> _directories;                 ///< Directories created by the client
     QStringList _fileList;                      ///< List of files returned by List command
     uint16_t _lastReplySequence = 0;
-
-    static constexpr uint8_t _sessionId = 1;    ///< We only support a single fixed session
 };
 
@@ -0,0 +1,54 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "RttEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+void RttEstimator::addSample(qint64 rttMSecs)
+{
+    const double rtt = static_cast<double>(std::max<qint64>(rttMSecs, 0));
+
+    if (_sampleCount == 0) {
+        _srtt = rtt;
+        _rttVar = rtt / 2.0;
+    } else {
+        // RTTVAR must be updated using the previous SRTT
+        _rttVar = ((1.0 - _beta) * _rttVar) + (_beta * std::fabs(_srtt - rtt));
+        _srtt = ((1.0 - _alpha) * _srtt) + (_alpha * rtt);
+    }
+
+    _sampleCount++;
+}
+
+int RttEstimator::timeoutMSecs(int defaultMSecs, int minMSecs, int maxMSecs) const
+{
+    if (_sampleCount == 0) {
+        return defaultMSecs;
+    }
+
+    const double rto = _srtt + std::max<double>(_clockGranularityMSecs, _k * _rttVar);
+    return std::clamp(static_cast<int>(std::ceil(rto)), minMSecs, maxMSecs);
+}
+
+int RttEstimator::backoffTimeoutMSecs(int tryCount, int defaultMSecs, int minMSecs, int maxMSecs) const
+{
+    if (_sampleCount == 0) {
+        // Nothing known about the link yet, keep the fixed default spacing
+        return defaultMSecs;
+    }
+
+    qint64 timeout = timeoutMSecs(defaultMSecs, minMSecs, maxMSecs);
+    for (int i = 1; (i < tryCount) && (timeout < maxMSecs); i++) {
+        timeout *= 2;
+    }
+
+    return static_cast<int>(std::min<qint64>(timeout, maxMSecs));
+}
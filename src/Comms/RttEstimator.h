@@ -0,0 +1,47 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QtTypes>
+
+/// Smoothed round trip time estimator using the TCP retransmission timer algorithm (RFC 6298).
+///     Samples must only be taken from requests which were not retransmitted (Karn's algorithm),
+///     otherwise it is not known which transmission the response belongs to.
+class RttEstimator
+{
+public:
+    /// Adds a round trip time measurement
+    void addSample(qint64 rttMSecs);
+
+    void reset() { *this = RttEstimator(); }
+
+    /// @return Retransmission timeout for the first transmission of a request, clamped to [minMSecs, maxMSecs].
+    ///         defaultMSecs is returned until the first sample has been taken.
+    int timeoutMSecs(int defaultMSecs, int minMSecs, int maxMSecs) const;
+
+    /// @return Retransmission timeout for the specified (1 based) try, doubling for each retransmission.
+    ///         defaultMSecs is returned for every try until the first sample has been taken.
+    int backoffTimeoutMSecs(int tryCount, int defaultMSecs, int minMSecs, int maxMSecs) const;
+
+    bool hasSamples() const { return _sampleCount > 0; }
+    int sampleCount() const { return _sampleCount; }
+    double srttMSecs() const { return _srtt; }
+    double rttVarMSecs() const { return _rttVar; }
+
+private:
+    double _srtt = 0;
+    double _rttVar = 0;
+    int _sampleCount = 0;
+
+    static constexpr double _alpha = 1.0 / 8.0;
+    static constexpr double _beta = 1.0 / 4.0;
+    static constexpr int _k = 4;
+    static constexpr int _clockGranularityMSecs = 10;
+};
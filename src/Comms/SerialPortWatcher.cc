@@ -0,0 +1,155 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "SerialPortWatcher.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QTimer>
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    #define QGC_SERIAL_INOTIFY
+    #include <cerrno>
+    #include <cstring>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+QGC_LOGGING_CATEGORY(SerialPortWatcherLog, "Comms.SerialPortWatcher")
+
+SerialPortWatcher::SerialPortWatcher(QObject *parent)
+    : QObject(parent)
+    , _debounceTimer(new QTimer(this))
+{
+    // qCDebug(SerialPortWatcherLog) << Q_FUNC_INFO << this;
+
+    _debounceTimer->setSingleShot(true);
+    _debounceTimer->setInterval(_debounceMSecs);
+    (void) connect(_debounceTimer, &QTimer::timeout, this, &SerialPortWatcher::portsChanged);
+}
+
+SerialPortWatcher::~SerialPortWatcher()
+{
+    stop();
+
+    // qCDebug(SerialPortWatcherLog) << Q_FUNC_INFO << this;
+}
+
+bool SerialPortWatcher::start()
+{
+    if (_eventDriven) {
+        return true;
+    }
+
+#ifdef QGC_SERIAL_INOTIFY
+    _inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_inotifyFd < 0) {
+        qCWarning(SerialPortWatcherLog) << "inotify_init1 failed, falling back to polling:" << strerror(errno);
+        return false;
+    }
+
+    _watchDescriptor = inotify_add_watch(_inotifyFd, "/dev", IN_CREATE | IN_DELETE | IN_ATTRIB);
+    if (_watchDescriptor < 0) {
+        qCWarning(SerialPortWatcherLog) << "inotify_add_watch(/dev) failed, falling back to polling:" << strerror(errno);
+        (void) ::close(_inotifyFd);
+        _inotifyFd = -1;
+        return false;
+    }
+
+    _notifier = new QSocketNotifier(_inotifyFd, QSocketNotifier::Read, this);
+    (void) connect(_notifier, &QSocketNotifier::activated, this, &SerialPortWatcher::_readEvents);
+
+    _eventDriven = true;
+    qCDebug(SerialPortWatcherLog) << "Watching /dev for serial device changes";
+#endif
+
+    return _eventDriven;
+}
+
+void SerialPortWatcher::stop()
+{
+    _debounceTimer->stop();
+    _eventDriven = false;
+
+#ifdef QGC_SERIAL_INOTIFY
+    if (_notifier) {
+        _notifier->setEnabled(false);
+        _notifier->deleteLater();
+        _notifier = nullptr;
+    }
+
+    if (_inotifyFd >= 0) {
+        if (_watchDescriptor >= 0) {
+            (void) inotify_rm_watch(_inotifyFd, _watchDescriptor);
+            _watchDescriptor = -1;
+        }
+        (void) ::close(_inotifyFd);
+        _inotifyFd = -1;
+    }
+#endif
+}
+
+void SerialPortWatcher::_readEvents()
+{
+#ifdef QGC_SERIAL_INOTIFY
+    alignas(struct inotify_event) char buffer[4096];
+    bool serialChange = false;
+
+    while (true) {
+        const ssize_t length = ::read(_inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            // EAGAIN: queue drained
+            break;
+        }
+
+        for (const char *ptr = buffer; ptr < (buffer + length);) {
+            const struct inotify_event *const event = reinterpret_cast<const struct inotify_event*>(ptr);
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost, we can't tell what changed so assume everything did
+                serialChange = true;
+            } else if ((event->len > 0) && _isSerialDeviceName(event->name)) {
+                qCDebug(SerialPortWatcherLog) << "Device event" << Qt::hex << event->mask << event->name;
+                serialChange = true;
+            }
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    if (serialChange) {
+        _debounceTimer->start();
+    }
+#endif
+}
+
+/// Only device nodes which QSerialPortInfo would enumerate are of interest. Everything else which
+/// comes and goes in /dev (disks, input devices, pty's, ...) is ignored.
+bool SerialPortWatcher::_isSerialDeviceName(const char *name)
+{
+    static constexpr const char *prefixes[] = {
+        "ttyACM",
+        "ttyUSB",
+        "ttyAMA",
+        "ttyTHS",
+        "ttyS",
+        "rfcomm",
+        "ttyGS",
+        "ttyMI",
+        "ttymxc",
+        "ttyO",
+        "ttySAC",
+    };
+
+    for (const char *prefix : prefixes) {
+        if (qstrncmp(name, prefix, qstrlen(prefix)) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,60 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QObject>
+#include <QtCore/QtSystemDetection>
+
+Q_DECLARE_LOGGING_CATEGORY(SerialPortWatcherLog)
+
+class QSocketNotifier;
+class QTimer;
+
+/// Notifies when serial devices are added to or removed from the system.
+///     On desktop Linux this is driven by inotify events on /dev, so callers only need to enumerate
+///     ports (QGCSerialPortInfo::availablePorts) when something actually changed. On all other platforms,
+///     or if the inotify watch could not be set up, isEventDriven() returns false and callers must fall
+///     back to polling.
+class SerialPortWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SerialPortWatcher(QObject *parent = nullptr);
+    ~SerialPortWatcher();
+
+    /// Starts watching for device changes
+    ///     @return true: Events will be signalled through portsChanged, false: caller must poll
+    bool start();
+    void stop();
+
+    /// @return true: portsChanged is emitted for hotplug events, false: caller must poll
+    bool isEventDriven() const { return _eventDriven; }
+
+signals:
+    /// Emitted (debounced) after one or more serial device nodes were added or removed
+    void portsChanged();
+
+private slots:
+    void _readEvents();
+
+private:
+    static bool _isSerialDeviceName(const char *name);
+
+    QTimer *_debounceTimer = nullptr;
+    QSocketNotifier *_notifier = nullptr;
+    int _inotifyFd = -1;
+    int _watchDescriptor = -1;
+    bool _eventDriven = false;
+
+    /// udev creates several nodes/symlinks per device, coalesce them into a single notification
+    static constexpr int _debounceMSecs = 100;
+};
@@ -73,14 +73,23 @@ FlightMap {
         }
     }
 
+    // Only ADS-B traffic around the visible part of the map is put into the model
+    function _updateAdsbViewport() {
+        QGroundControl.adsbVehicleManager.setViewport(_root.visibleRegion.boundingGeoRectangle())
+    }
+
     onZoomLevelChanged: {
         if (_saveZoomLevelSetting) {
             QGroundControl.flightMapZoom = _root.zoomLevel
         }
+        _updateAdsbViewport()
     }
     onCenterChanged: {
         QGroundControl.flightMapPosition = _root.center
+        _updateAdsbViewport()
     }
+    onWidthChanged:     _updateAdsbViewport()
+    onHeightChanged:    _updateAdsbViewport()
 
     // We track whether the user has panned or not to correctly handle automatic map positioning
     onMapPanStart:  _disableVehicleTracking = true
@@ -268,6 +277,7 @@ FlightMap {
             function onPointAdded(coordinate) { trajectoryPolyline.addCoordinate(coordinate) }
             function onUpdateLastPoint(coordinate) { trajectoryPolyline.replaceCoordinate(trajectoryPolyline.pathLength() - 1, coordinate) }
             function onPointsCleared() { trajectoryPolyline.path = [] }
+            function onPathReplaced() { trajectoryPolyline.path = _activeVehicle.trajectoryPoints.list() }
         }
     }
 
@@ -10,17 +10,23 @@
 #include "ImageProtocolManager.h"
 #include "QGCLoggingCategory.h"
 
+#include <QtConcurrent/QtConcurrentRun>
+
 QGC_LOGGING_CATEGORY(ImageProtocolManagerLog, "MAVLink.ImageProtocolManager")
 
 ImageProtocolManager::ImageProtocolManager(QObject *parent)
     : QObject(parent)
 {
     // qCDebug(ImageProtocolManagerLog) << Q_FUNC_INFO << this;
+
+    (void) connect(&_decodeWatcher, &QFutureWatcher<QImage>::finished, this, &ImageProtocolManager::_decodeFinished);
 }
 
 ImageProtocolManager::~ImageProtocolManager()
 {
     // qCDebug(ImageProtocolManagerLog) << Q_FUNC_INFO << this;
+
+    _decodeWatcher.waitForFinished();
 }
 
 bool ImageProtocolManager::requestImage(uint8_t system_id, uint8_t component_id, uint8_t chan, mavlink_message_t &message)
@@ -53,11 +59,30 @@ void ImageProtocolManager::mavlinkMessageReceived(const mavlink_message_t &messa
     case MAVLINK_MSG_ID_DATA_TRANSMISSION_HANDSHAKE:
     {
         if (_imageHandshake.packets > 0) {
-            qCWarning(ImageProtocolManagerLog) << "DATA_TRANSMISSION_HANDSHAKE: Previous image transmission incomplete.";
+            qCWarning(ImageProtocolManagerLog) << "DATA_TRANSMISSION_HANDSHAKE: Previous image transmission incomplete." << _packetsReceived << "of" << _imageHandshake.packets << "packets received";
+        }
+        _resetTransfer();
+
+        mavlink_data_transmission_handshake_t handshake;
+        mavlink_msg_data_transmission_handshake_decode(&message, &handshake);
+        qCDebug(ImageProtocolManagerLog) << QStringLiteral("DATA_TRANSMISSION_HANDSHAKE: type(%1) width(%2) height (%3) size(%4) packets(%5) payload(%6)")
+            .arg(handshake.type).arg(handshake.width).arg(handshake.height).arg(handshake.size).arg(handshake.packets).arg(handshake.payload);
+
+        if (handshake.packets == 0) {
+            break;
+        }
+        if ((handshake.payload == 0) || (handshake.payload > MAVLINK_MSG_ENCAPSULATED_DATA_FIELD_DATA_LEN)) {
+            qCWarning(ImageProtocolManagerLog) << "DATA_TRANSMISSION_HANDSHAKE: invalid payload size" << handshake.payload;
+            break;
         }
-        _imageBytes.clear();
-        mavlink_msg_data_transmission_handshake_decode(&message, &_imageHandshake);
-        qCDebug(ImageProtocolManagerLog) << QStringLiteral("DATA_TRANSMISSION_HANDSHAKE: type(%1) width(%2) height (%3)").arg(_imageHandshake.type).arg(_imageHandshake.width).arg(_imageHandshake.height);
+        if ((handshake.size == 0) || (handshake.size > kMaxImageSize) || (handshake.size > (static_cast<uint32_t>(handshake.packets) * handshake.payload))) {
+            qCWarning(ImageProtocolManagerLog) << "DATA_TRANSMISSION_HANDSHAKE: invalid image size" << handshake.size << "for" << handshake.packets << "packets of" << handshake.payload;
+            break;
+        }
+
+        _imageHandshake = handshake;
+        _imageBytes = QByteArray(static_cast<qsizetype>(handshake.size), Qt::Uninitialized);
+        _receivedPackets.resize(handshake.packets);
         break;
     }
     case MAVLINK_MSG_ID_ENCAPSULATED_DATA:
@@ -70,25 +95,29 @@ void ImageProtocolManager::mavlinkMessageReceived(const mavlink_message_t &messa
         mavlink_encapsulated_data_t encapsulatedData;
         mavlink_msg_encapsulated_data_decode(&message, &encapsulatedData);
 
-        uint32_t bytePosition = encapsulatedData.seqnr * _imageHandshake.payload;
-        if (bytePosition >= _imageHandshake.size) {
-            qCWarning(ImageProtocolManagerLog) << "ENCAPSULATED_DATA: seqnr is past end of image size. seqnr:" << encapsulatedData.seqnr << "_imageHandshake.size:" << _imageHandshake.size;
+        if (encapsulatedData.seqnr >= _imageHandshake.packets) {
+            qCWarning(ImageProtocolManagerLog) << "ENCAPSULATED_DATA: seqnr is past end of image. seqnr:" << encapsulatedData.seqnr << "_imageHandshake.packets:" << _imageHandshake.packets;
+            break;
+        }
+        if (_receivedPackets.testBit(encapsulatedData.seqnr)) {
+            // Retransmission, the data is already in place
+            qCDebug(ImageProtocolManagerLog) << "ENCAPSULATED_DATA: duplicate seqnr" << encapsulatedData.seqnr;
             break;
         }
 
-        for (uint8_t i = 0; i < _imageHandshake.payload; i++) {
-            _imageBytes[bytePosition] = encapsulatedData.data[i];
-            bytePosition++;
+        // The last packet is usually only partially used
+        const uint32_t bytePosition = static_cast<uint32_t>(encapsulatedData.seqnr) * _imageHandshake.payload;
+        if (bytePosition < _imageHandshake.size) {
+            const uint32_t bytes = qMin<uint32_t>(_imageHandshake.payload, _imageHandshake.size - bytePosition);
+            (void) memcpy(_imageBytes.data() + bytePosition, encapsulatedData.data, bytes);
         }
+        _receivedPackets.setBit(encapsulatedData.seqnr);
+        _packetsReceived++;
 
-        // We use the packets field to track completion
-        _imageHandshake.packets--;
-        if (_imageHandshake.packets == 0) {
+        if (_packetsReceived == _imageHandshake.packets) {
             // We have all the packets
-            emit imageReady(_getImage());
-
-            _flowImageIndex++;
-            emit flowImageIndexChanged(_flowImageIndex);
+            _startDecode(_imageBytes, _imageHandshake);
+            _resetTransfer();
         }
         break;
     }
@@ -97,32 +126,63 @@ void ImageProtocolManager::mavlinkMessageReceived(const mavlink_message_t &messa
     }
 }
 
-QImage ImageProtocolManager::_getImage()
+void ImageProtocolManager::_resetTransfer()
 {
-    QImage image;
+    _imageHandshake = mavlink_data_transmission_handshake_t{0};
+    _imageBytes.clear();
+    _receivedPackets.clear();
+    _packetsReceived = 0;
+}
 
-    if (_imageBytes.isEmpty()) {
-        qCWarning(ImageProtocolManagerLog) << Q_FUNC_INFO << "Called when no image available";
-        return image;
+void ImageProtocolManager::_startDecode(const QByteArray &imageBytes, const mavlink_data_transmission_handshake_t &handshake)
+{
+    if (_decodeWatcher.isRunning()) {
+        // Only the newest image matters, replace whatever was waiting
+        if (!_queuedImageBytes.isEmpty()) {
+            qCDebug(ImageProtocolManagerLog) << "Decoder busy, dropping queued image";
+        }
+        _queuedImageBytes = imageBytes;
+        _queuedHandshake = handshake;
+        return;
     }
 
-    if (_imageHandshake.packets > 0) {
-        qCWarning(ImageProtocolManagerLog) << Q_FUNC_INFO << "Called when image is imcomplete. _imageHandshake.packets:" << _imageHandshake.packets;
-        return image;
+    _decodeWatcher.setFuture(QtConcurrent::run(&ImageProtocolManager::_decodeImage, imageBytes, handshake));
+}
+
+void ImageProtocolManager::_decodeFinished()
+{
+    const QImage image = _decodeWatcher.result();
+
+    if (!_queuedImageBytes.isEmpty()) {
+        const QByteArray imageBytes = std::exchange(_queuedImageBytes, QByteArray());
+        _startDecode(imageBytes, _queuedHandshake);
     }
 
-    switch (_imageHandshake.type) {
+    emit imageReady(image);
+
+    _flowImageIndex++;
+    emit flowImageIndexChanged(_flowImageIndex);
+}
+
+QImage ImageProtocolManager::_decodeImage(const QByteArray &imageBytes, const mavlink_data_transmission_handshake_t &handshake)
+{
+    QImage image;
+
+    switch (handshake.type) {
     case MAVLINK_DATA_STREAM_IMG_RAW8U:
     case MAVLINK_DATA_STREAM_IMG_RAW32U:
     {
-        // Construct PGM header
-        const QString header = QStringLiteral("P5\n%1 %2\n255\n").arg(_imageHandshake.width).arg(_imageHandshake.height);
-
-        QByteArray tempImage(header.toStdString().c_str(), header.length());
-        (void) tempImage.append(_imageBytes);
+        // One byte per pixel, copied straight into a grayscale image instead of going through the PGM loader
+        const int width = handshake.width;
+        const int height = handshake.height;
+        if ((width <= 0) || (height <= 0) || (imageBytes.size() < (static_cast<qsizetype>(width) * height))) {
+            qCWarning(ImageProtocolManagerLog) << Q_FUNC_INFO << "IMG_RAW8U image too small for" << width << "x" << height << ":" << imageBytes.size();
+            break;
+        }
 
-        if (!image.loadFromData(tempImage, "PGM")) {
-            qCWarning(ImageProtocolManagerLog) << Q_FUNC_INFO << "IMG_RAW8U QImage::loadFromData failed";
+        image = QImage(width, height, QImage::Format_Grayscale8);
+        for (int row = 0; row < height; row++) {
+            (void) memcpy(image.scanLine(row), imageBytes.constData() + (static_cast<qsizetype>(row) * width), static_cast<size_t>(width));
         }
         break;
     }
@@ -130,13 +190,13 @@ QImage ImageProtocolManager::_getImage()
     case MAVLINK_DATA_STREAM_IMG_JPEG:
     case MAVLINK_DATA_STREAM_IMG_PGM:
     case MAVLINK_DATA_STREAM_IMG_PNG:
-        if (!image.loadFromData(_imageBytes)) {
+        if (!image.loadFromData(imageBytes)) {
             qCWarning(ImageProtocolManagerLog) << Q_FUNC_INFO << "Known header QImage::loadFromData failed";
         }
         break;
 
     default:
-        qCWarning(ImageProtocolManagerLog) << Q_FUNC_INFO << "Unsupported image type:" << _imageHandshake.type;
+        qCWarning(ImageProtocolManagerLog) << Q_FUNC_INFO << "Unsupported image type:" << handshake.type;
         break;
     }
 
@@ -11,7 +11,9 @@
 
 #include "MAVLinkLib.h"
 
+#include <QtCore/QBitArray>
 #include <QtCore/QByteArray>
+#include <QtCore/QFutureWatcher>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QObject>
 #include <QtGui/QImage>
@@ -20,6 +22,9 @@ Q_DECLARE_LOGGING_CATEGORY(ImageProtocolManagerLog)
 
 /// Supports the Mavlink image transmission protocol (https://mavlink.io/en/services/image_transmission.html).
 /// Mainly used by optical flow cameras.
+/// Packets are written straight into a buffer sized from the handshake and may arrive in any order or more than
+/// once. Completed images are decoded on a worker thread; if images complete faster than they can be decoded only
+/// the most recent one is kept waiting.
 class ImageProtocolManager : public QObject
 {
     Q_OBJECT
@@ -40,10 +45,23 @@ class ImageProtocolManager : public QObject
 public slots:
     void mavlinkMessageReceived(const mavlink_message_t &message);
 
+private slots:
+    void _decodeFinished();
+
 private:
-    QImage _getImage();
+    void _resetTransfer();
+    void _startDecode(const QByteArray &imageBytes, const mavlink_data_transmission_handshake_t &handshake);
+    static QImage _decodeImage(const QByteArray &imageBytes, const mavlink_data_transmission_handshake_t &handshake);
 
     mavlink_data_transmission_handshake_t _imageHandshake{0};
     QByteArray _imageBytes;
+    QBitArray _receivedPackets;
+    uint32_t _packetsReceived = 0;
     uint32_t _flowImageIndex = 0;
+
+    QFutureWatcher<QImage> _decodeWatcher;
+    QByteArray _queuedImageBytes;
+    mavlink_data_transmission_handshake_t _queuedHandshake{0};
+
+    static constexpr uint32_t kMaxImageSize = 16 * 1024 * 1024;
 };
@@ -28,7 +28,7 @@ Rectangle {
     QGCFileDialog {
         id: filePicker
         title: qsTr("Select Telemetery Log")
-        nameFilters: [ qsTr("Telemetry Logs (*.%1)").arg(_logFileExtension), qsTr("All Files (*)") ]
+        nameFilters: [ qsTr("Telemetry Logs (*.%1 *.%2)").arg(_logFileExtension).arg(_compressedLogFileExtension), qsTr("All Files (*)") ]
         folder: QGroundControl.settingsManager.appSettings.telemetrySavePath
         onAcceptedForLoad: (file) => {
             controller.link = QGroundControl.linkManager.startLogReplay(file)
@@ -36,6 +36,7 @@ Rectangle {
         }
 
         property string _logFileExtension: QGroundControl.settingsManager.appSettings.telemetryFileExtension
+        property string _compressedLogFileExtension: QGroundControl.settingsManager.appSettings.compressedTelemetryFileExtension
     }
 
     LogReplayLinkController {
@@ -104,6 +104,23 @@ void ParameterTableModel::insert(int row, Fact* fact)
     emit rowCountChanged(rowCount());
 }
 
+void ParameterTableModel::setFacts(const QList<Fact*>& facts)
+{
+    beginResetModel();
+    _tableData.clear();
+    _tableData.reserve(facts.count());
+    for (Fact* fact: facts) {
+        ColumnData colData(_tableViewColCount, QString());
+        colData[NameColumn] = fact->name();
+        colData[ValueColumn] = QVariant::fromValue(fact);
+        colData[DescriptionColumn] = fact->shortDescription();
+        _tableData.append(colData);
+    }
+    endResetModel();
+
+    emit rowCountChanged(rowCount());
+}
+
 void ParameterTableModel::beginReset()
 {
     if (_externalBeginResetModel) {
@@ -133,6 +150,134 @@ Fact* ParameterTableModel::factAt(int row) const
 }
 
 
+void ParameterSearchIndex::build(const QList<Fact*>& facts)
+{
+    clear();
+
+    _entries.reserve(facts.count());
+    for (Fact* fact: facts) {
+        Entry entry;
+        entry.fact              = fact;
+        entry.name              = fact->name();
+        entry.shortDescription  = fact->shortDescription();
+        entry.longDescription   = fact->longDescription();
+        entry.folded            = QStringLiteral("%1\n%2\n%3").arg(entry.name, entry.shortDescription, entry.longDescription).toCaseFolded();
+        _entries.append(entry);
+    }
+}
+
+void ParameterSearchIndex::clear()
+{
+    _entries.clear();
+    _lastTerms.clear();
+    _lastMatches.clear();
+    _lastValid = false;
+}
+
+bool ParameterSearchIndex::_isLiteral(const QString& term)
+{
+    static const QString metaCharacters = QStringLiteral("\\^$.|?*+()[]{}");
+
+    for (const QChar c: term) {
+        if (metaCharacters.contains(c) || (c == QLatin1Char('\n'))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ParameterSearchIndex::_matches(const Entry& entry, const Term& term)
+{
+    if (term.literal) {
+        return entry.folded.contains(term.folded);
+    }
+
+    if (term.regex.isValid()) {
+        return entry.name.contains(term.regex) || entry.shortDescription.contains(term.regex) || entry.longDescription.contains(term.regex);
+    }
+
+    // A half typed regex such as "BATT[" is matched literally instead of matching every parameter
+    return entry.name.contains(term.text, Qt::CaseInsensitive) ||
+            entry.shortDescription.contains(term.text, Qt::CaseInsensitive) ||
+            entry.longDescription.contains(term.text, Qt::CaseInsensitive);
+}
+
+bool ParameterSearchIndex::_narrows(const QStringList& terms) const
+{
+    if (!_lastValid || (terms.count() < _lastTerms.count())) {
+        return false;
+    }
+
+    // Every previous term must still be there, either unchanged or extended as a literal
+    for (int i=0; i<_lastTerms.count(); i++) {
+        const QString& previous = _lastTerms[i];
+        const QString& term = terms[i];
+        if (term == previous) {
+            continue;
+        }
+        if (!_isLiteral(previous) || !_isLiteral(term) || !term.toCaseFolded().contains(previous.toCaseFolded())) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QList<Fact*> ParameterSearchIndex::search(const QStringList& terms)
+{
+    QList<Term> compiled;
+    compiled.reserve(terms.count());
+    for (const QString& text: terms) {
+        Term term;
+        term.text = text;
+        term.literal = _isLiteral(text);
+        if (term.literal) {
+            term.folded = text.toCaseFolded();
+        } else {
+            term.regex = QRegularExpression(text, QRegularExpression::CaseInsensitiveOption);
+        }
+        compiled.append(term);
+    }
+
+    const bool narrow = _narrows(terms);
+
+    QList<int> matches;
+    const auto consider = [this, &compiled, &matches](int index) {
+        const Entry& entry = _entries[index];
+        for (const Term& term: compiled) {
+            if (!_matches(entry, term)) {
+                return;
+            }
+        }
+        matches.append(index);
+    };
+
+    if (narrow) {
+        matches.reserve(_lastMatches.count());
+        for (int index: std::as_const(_lastMatches)) {
+            consider(index);
+        }
+    } else {
+        matches.reserve(_entries.count());
+        for (int index=0; index<_entries.count(); index++) {
+            consider(index);
+        }
+    }
+
+    _lastTerms = terms;
+    _lastMatches = matches;
+    _lastValid = true;
+
+    QList<Fact*> facts;
+    facts.reserve(matches.count());
+    for (int index: std::as_const(matches)) {
+        facts.append(_entries[index].fact);
+    }
+
+    return facts;
+}
+
 ParameterEditorGroup::ParameterEditorGroup(QObject* parent) 
     : QObject(parent) 
 { 
@@ -146,6 +291,7 @@ ParameterEditorController::ParameterEditorController(QObject *parent)
     // qCDebug(ParameterEditorControllerLog) << Q_FUNC_INFO << this;
 
     _buildLists();
+    _buildSearchIndex();
 
     _searchTimer.setSingleShot(true);
     _searchTimer.setInterval(300);
@@ -246,8 +392,26 @@ void ParameterEditorController::_buildLists(void)
     }
 }
 
+void ParameterEditorController::_buildSearchIndex()
+{
+    const int compId = _vehicle->defaultComponentId();
+
+    QList<Fact*> facts;
+    for (const QString& paraName: _parameterMgr->parameterNames(compId)) {
+        facts.append(_parameterMgr->getParameter(compId, paraName));
+    }
+    _searchIndex.build(facts);
+
+    qCDebug(ParameterEditorControllerLog) << "Search index built for" << _searchIndex.count() << "parameters";
+}
+
 void ParameterEditorController::_factAdded(int compId, Fact* fact)
 {
+    if (compId == _vehicle->defaultComponentId()) {
+        // Rebuilt on the next search
+        _searchIndex.clear();
+    }
+
     bool                        inserted = false;
     ParameterEditorCategory*    category = nullptr;
 
@@ -485,45 +649,16 @@ void ParameterEditorController::_performSearch(void)
         setCurrentCategory(category);
         _searchParameters.clear();
     } else {
-        QVector<QRegularExpression> regexList;
-        regexList.reserve(rgSearchStrings.size());
-        for (const QString &searchItem : rgSearchStrings) {
-            QRegularExpression re(searchItem, QRegularExpression::CaseInsensitiveOption);
-            regexList.append(re.isValid() ? re : QRegularExpression());
+        if (_searchIndex.isEmpty()) {
+            _buildSearchIndex();
         }
 
-        _searchParameters.beginReset();
-        _searchParameters.clear();
-
-        for (const QString &paraName: _parameterMgr->parameterNames(_vehicle->defaultComponentId())) {
-            Fact* fact = _parameterMgr->getParameter(_vehicle->defaultComponentId(), paraName);
-            bool matched = _shouldShow(fact);
-            // All of the search items must match in order for the parameter to be added to the list
-            if (matched) {
-                for (int i = 0; i < rgSearchStrings.size(); ++i) {
-                    const QRegularExpression &re = regexList.at(i);
-                    if (re.isValid()) {
-                        if (!fact->name().contains(re) &&
-                                !fact->shortDescription().contains(re) &&
-                                !fact->longDescription().contains(re)) {
-                            matched = false;
-                        }
-                    } else {
-                        const QString &searchItem = rgSearchStrings.at(i);
-                        if (!fact->name().contains(searchItem, Qt::CaseInsensitive) &&
-                                !fact->shortDescription().contains(searchItem, Qt::CaseInsensitive) &&
-                                !fact->longDescription().contains(searchItem, Qt::CaseInsensitive)) {
-                            matched = false;
-                        }                    
-                    }
-                }
-            }
-            if (matched) {
-                _searchParameters.append(fact);
-            }
+        // All of the search items must match in order for the parameter to be added to the list
+        QList<Fact*> facts = _searchIndex.search(rgSearchStrings);
+        if (_showModifiedOnly) {
+            facts.removeIf([this](Fact* fact) { return !_shouldShow(fact); });
         }
-
-        _searchParameters.endReset();
+        _searchParameters.setFacts(facts);
 
         if (_parameters != &_searchParameters) {
             _parameters = &_searchParameters;
@@ -11,6 +11,7 @@
 
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QObject>
+#include <QtCore/QRegularExpression>
 #include <QtQmlIntegration/QtQmlIntegration>
 
 #include "FactPanelController.h"
@@ -45,6 +46,7 @@ class ParameterTableModel : public QAbstractTableModel
     
     void append      (Fact* fact);
     void insert      (int row, Fact* fact);
+    void setFacts    (const QList<Fact*>& facts);  ///< Replaces the contents with a single model reset
     void clear       ();
     void beginReset  ();
     void endReset    ();
@@ -65,6 +67,49 @@ class ParameterTableModel : public QAbstractTableModel
     bool                _externalBeginResetModel = false;
 };
 
+/// Search index over parameter names and descriptions, built once from the parameter list.
+///
+/// Terms without regular expression syntax are matched as case insensitive substrings against text which was
+/// case folded when the index was built. When the new terms can only match a subset of the previous search
+/// (a character was appended to a term, or a term was added), only the previous matches are scanned again.
+/// Other terms are matched as case insensitive regular expressions, as the editor always did.
+class ParameterSearchIndex
+{
+public:
+    void build      (const QList<Fact*>& facts);
+    void clear      ();
+    bool isEmpty    () const { return _entries.isEmpty(); }
+    int  count      () const { return _entries.count(); }
+
+    /// @return Facts matching all of the terms, in index order. No terms matches everything.
+    QList<Fact*> search(const QStringList& terms);
+
+private:
+    struct Entry {
+        Fact*   fact = nullptr;
+        QString name;
+        QString shortDescription;
+        QString longDescription;
+        QString folded;     ///< Case folded name, short and long description separated by newlines
+    };
+
+    struct Term {
+        bool                literal = true;
+        QString             folded;
+        QString             text;
+        QRegularExpression  regex;
+    };
+
+    static bool _isLiteral  (const QString& term);
+    static bool _matches    (const Entry& entry, const Term& term);
+    bool        _narrows    (const QStringList& terms) const;
+
+    QList<Entry>    _entries;
+    QStringList     _lastTerms;
+    QList<int>      _lastMatches;
+    bool            _lastValid = false;
+};
+
 class ParameterEditorGroup : public QObject
 {
     Q_OBJECT
@@ -183,6 +228,7 @@ private slots:
 private:
     bool _shouldShow(Fact *fact) const;
     void _performSearch();
+    void _buildSearchIndex();
 
 private:
     ParameterManager*           _parameterMgr           = nullptr;
@@ -197,6 +243,7 @@ private slots:
     QmlObjectListModel          _categories;
     QmlObjectListModel          _diffList;
     ParameterTableModel         _searchParameters;
+    ParameterSearchIndex        _searchIndex;
     QAbstractTableModel*        _parameters             = nullptr;
     QMap<QString, ParameterEditorCategory*> _mapCategoryName2Category;
 };
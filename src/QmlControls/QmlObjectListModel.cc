@@ -11,10 +11,23 @@
 #include "QGCLoggingCategory.h"
 
 #include <QtCore/QDebug>
+#include <QtCore/QSet>
 #include <QtQml/QQmlEngine>
 
+#include <algorithm>
+
 QGC_LOGGING_CATEGORY(QmlObjectListModelLog, "API.QmlObjectListModel")
 
+namespace {
+
+const QMetaMethod& childDirtyChangedSlot()
+{
+    static const QMetaMethod slot = QmlObjectListModel::staticMetaObject.method(QmlObjectListModel::staticMetaObject.indexOfSlot("_childDirtyChanged(bool)"));
+    return slot;
+}
+
+} // namespace
+
 QmlObjectListModel::QmlObjectListModel(QObject* parent)
     : QAbstractListModel        (parent)
     , _dirty                    (false)
@@ -112,9 +125,7 @@ bool QmlObjectListModel::removeRows(int position, int rows, const QModelIndex& p
     }
     
     beginRemoveRows(QModelIndex(), position, position + rows - 1);
-    for (int row=0; row<rows; row++) {
-        _objectList.removeAt(position);
-    }
+    _objectList.remove(position, rows);
     endRemoveRows();
     
     _signalCountChangedIfNotNested();
@@ -124,18 +135,27 @@ bool QmlObjectListModel::removeRows(int position, int rows, const QModelIndex& p
 
 void QmlObjectListModel::move(int from, int to)
 {
-    if(0 <= from && from < count() && 0 <= to && to < count() && from != to) {
-        // Workaround to allow move item to the bottom. Done according to
-        // beginMoveRows() documentation and implementation specificity:
-        // https://doc.qt.io/qt-5/qabstractitemmodel.html#beginMoveRows
-        // (see 3rd picture explanation there)
-        if(from == to - 1) {
-            to = from++;
-        }
-        beginMoveRows(QModelIndex(), from, from, QModelIndex(), to);
-        _objectList.move(from, to);
-        endMoveRows();
+    moveRange(from, 1, to);
+}
+
+void QmlObjectListModel::moveRange(int from, int count, int to)
+{
+    if (count <= 0 || from < 0 || from + count > _objectList.count() || to < 0 || to + count > _objectList.count() || from == to) {
+        return;
+    }
+
+    // beginMoveRows() takes the row the items are moved in front of, in terms of the list before the move
+    // https://doc.qt.io/qt-6/qabstractitemmodel.html#beginMoveRows
+    const int destinationChild = (to > from) ? to + count : to;
+    QObject* const previousFirst = _objectList.first();
+    beginMoveRows(QModelIndex(), from, from + count - 1, QModelIndex(), destinationChild);
+    if (to > from) {
+        std::rotate(_objectList.begin() + from, _objectList.begin() + from + count, _objectList.begin() + to + count);
+    } else {
+        std::rotate(_objectList.begin() + to, _objectList.begin() + from, _objectList.begin() + from + count);
     }
+    endMoveRows();
+    _firstItemChanged(previousFirst);
 }
 
 QObject* QmlObjectListModel::operator[](int index)
@@ -164,35 +184,50 @@ void QmlObjectListModel::clear()
 QObject* QmlObjectListModel::removeAt(int i)
 {
     QObject* removedObject = _objectList[i];
-    if(removedObject) {
-        // Look for a dirtyChanged signal on the object
-        if (_objectList[i]->metaObject()->indexOfSignal(QMetaObject::normalizedSignature("dirtyChanged(bool)").constData()) != -1) {
-            if (!_skipDirtyFirstItem || i != 0) {
-                QObject::disconnect(_objectList[i], SIGNAL(dirtyChanged(bool)), this, SLOT(_childDirtyChanged(bool)));
-            }
-        }
-    }
+    QObject* const previousFirst = _objectList.first();
+    _disconnectDirtyChanged(removedObject, i);
     removeRows(i, 1);
+    _firstItemChanged(previousFirst);
     setDirty(true);
     return removedObject;
 }
 
+QObjectList QmlObjectListModel::removeRange(int i, int count)
+{
+    if (i < 0 || count < 0 || i + count > _objectList.count()) {
+        qCWarning(QmlObjectListModelLog) << "Invalid range - index:count:listCount" << i << count << _objectList.count() << this;
+        return QObjectList();
+    }
+    if (count == 0) {
+        return QObjectList();
+    }
+
+    const QObjectList removedObjects = _objectList.mid(i, count);
+    QObject* const previousFirst = _objectList.first();
+    for (int j=0; j<count; j++) {
+        _disconnectDirtyChanged(removedObjects[j], i + j);
+    }
+    removeRows(i, count);
+    _firstItemChanged(previousFirst);
+    setDirty(true);
+    return removedObjects;
+}
+
 void QmlObjectListModel::insert(int i, QObject* object)
 {
     if (i < 0 || i > _objectList.count()) {
         qCWarning(QmlObjectListModelLog) << "Invalid index - index:count" << i << _objectList.count() << this;
     }
+    QObject* const previousFirst = _objectList.value(0);
     if(object) {
         QQmlEngine::setObjectOwnership(object, QQmlEngine::CppOwnership);
-        // Look for a dirtyChanged signal on the object
-        if (object->metaObject()->indexOfSignal(QMetaObject::normalizedSignature("dirtyChanged(bool)").constData()) != -1) {
-            if (!_skipDirtyFirstItem || i != 0) {
-                QObject::connect(object, SIGNAL(dirtyChanged(bool)), this, SLOT(_childDirtyChanged(bool)));
-            }
-        }
+        _connectDirtyChanged(object, i);
     }
+    beginInsertRows(QModelIndex(), i, i);
     _objectList.insert(i, object);
-    insertRows(i, 1);
+    endInsertRows();
+    _firstItemChanged(previousFirst);
+    _signalCountChangedIfNotNested();
     setDirty(true);
 }
 
@@ -201,23 +236,23 @@ void QmlObjectListModel::insert(int i, QList<QObject*> objects)
     if (i < 0 || i > _objectList.count()) {
         qCWarning(QmlObjectListModelLog) << "Invalid index - index:count" << i << _objectList.count() << this;
     }
+    if (objects.isEmpty()) {
+        return;
+    }
 
-    int j = i;
-    for (QObject* object: objects) {
-        QQmlEngine::setObjectOwnership(object, QQmlEngine::CppOwnership);
-
-        // Look for a dirtyChanged signal on the object
-        if (object->metaObject()->indexOfSignal(QMetaObject::normalizedSignature("dirtyChanged(bool)").constData()) != -1) {
-            if (!_skipDirtyFirstItem || j != 0) {
-                QObject::connect(object, SIGNAL(dirtyChanged(bool)), this, SLOT(_childDirtyChanged(bool)));
-            }
-        }
-
-        _objectList.insert(j, object);
-        j++;
+    QObject* const previousFirst = _objectList.value(0);
+    for (int j=0; j<objects.count(); j++) {
+        QQmlEngine::setObjectOwnership(objects[j], QQmlEngine::CppOwnership);
+        _connectDirtyChanged(objects[j], i + j);
     }
 
-    insertRows(i, objects.count());
+    // Shift the existing objects once for the whole range instead of once per object
+    beginInsertRows(QModelIndex(), i, i + objects.count() - 1);
+    _objectList.insert(i, objects.count(), nullptr);
+    std::copy(objects.cbegin(), objects.cend(), _objectList.begin() + i);
+    endInsertRows();
+    _firstItemChanged(previousFirst);
+    _signalCountChangedIfNotNested();
 
     setDirty(true);
 }
@@ -241,6 +276,81 @@ QObjectList QmlObjectListModel::swapObjectList(const QObjectList& newlist)
     return oldlist;
 }
 
+QObjectList QmlObjectListModel::syncObjectList(const QObjectList& newlist)
+{
+    const int oldCount = _objectList.count();
+    QObject* const previousFirst = _objectList.value(0);
+    const QSet<QObject*> newObjects(newlist.cbegin(), newlist.cend());
+
+    // Remove the objects which are not in the new list. Working from the end keeps the indices of the runs still to be
+    // removed valid.
+    QObjectList removedObjects;
+    int end = _objectList.count();
+    while (end > 0) {
+        if (newObjects.contains(_objectList[end - 1])) {
+            end--;
+            continue;
+        }
+
+        int start = end - 1;
+        while (start > 0 && !newObjects.contains(_objectList[start - 1])) {
+            start--;
+        }
+        for (int j=start; j<end; j++) {
+            _disconnectDirtyChanged(_objectList[j], j);
+            removedObjects.append(_objectList[j]);
+        }
+
+        beginRemoveRows(QModelIndex(), start, end - 1);
+        _objectList.remove(start, end - start);
+        endRemoveRows();
+        end = start;
+    }
+
+    // Everything left is in the new list. Walk the new list, the rows before index always match it. An object which is
+    // out of place is moved up together with any objects following it in both lists, and objects which are not in the
+    // list yet are inserted as a run.
+    const QSet<QObject*> currentObjects(_objectList.cbegin(), _objectList.cend());
+    int index = 0;
+    while (index < newlist.count()) {
+        if (index < _objectList.count() && _objectList[index] == newlist[index]) {
+            index++;
+        } else if (currentObjects.contains(newlist[index])) {
+            const int from = _objectList.indexOf(newlist[index], index + 1);
+            int count = 1;
+            while (from + count < _objectList.count() && index + count < newlist.count() && _objectList[from + count] == newlist[index + count]) {
+                count++;
+            }
+            moveRange(from, count, index);
+            index += count;
+        } else {
+            int runEnd = index + 1;
+            while (runEnd < newlist.count() && !currentObjects.contains(newlist[runEnd])) {
+                runEnd++;
+            }
+            for (int j=index; j<runEnd; j++) {
+                QQmlEngine::setObjectOwnership(newlist[j], QQmlEngine::CppOwnership);
+                _connectDirtyChanged(newlist[j], j);
+            }
+
+            beginInsertRows(QModelIndex(), index, runEnd - 1);
+            _objectList.insert(index, runEnd - index, nullptr);
+            std::copy(newlist.cbegin() + index, newlist.cbegin() + runEnd, _objectList.begin() + index);
+            endInsertRows();
+            index = runEnd;
+        }
+    }
+
+    // Removals can shift an object into the first row without a move
+    _firstItemChanged(previousFirst);
+
+    if (_objectList.count() != oldCount) {
+        _signalCountChangedIfNotNested();
+    }
+
+    return removedObjects;
+}
+
 int QmlObjectListModel::count() const
 {
     return rowCount();
@@ -317,3 +427,62 @@ void QmlObjectListModel::_signalCountChangedIfNotNested()
         emit countChanged(count());
     }
 }
+
+QMetaMethod QmlObjectListModel::_dirtyChangedSignal(const QObject* object)
+{
+    // Looking the signal up by name is slow compared to everything else done per object, so it is only done once per type
+    const QMetaObject* metaObject = object->metaObject();
+    auto it = _dirtyChangedSignals.constFind(metaObject);
+    if (it == _dirtyChangedSignals.constEnd()) {
+        const int signalIndex = metaObject->indexOfSignal("dirtyChanged(bool)");
+        it = _dirtyChangedSignals.insert(metaObject, (signalIndex != -1) ? metaObject->method(signalIndex) : QMetaMethod());
+    }
+    return it.value();
+}
+
+void QmlObjectListModel::_connectDirtyChanged(QObject* object, int index)
+{
+    // Look for a dirtyChanged signal on the object
+    if (object && (!_skipDirtyFirstItem || index != 0)) {
+        const QMetaMethod dirtyChangedSignal = _dirtyChangedSignal(object);
+        if (dirtyChangedSignal.isValid()) {
+            QObject::connect(object, dirtyChangedSignal, this, childDirtyChangedSlot());
+        }
+    }
+}
+
+void QmlObjectListModel::_firstItemChanged(QObject* previousFirst)
+{
+    if (!_skipDirtyFirstItem) {
+        return;
+    }
+    QObject* const first = _objectList.value(0);
+    if (first == previousFirst) {
+        return;
+    }
+
+    // Connections follow the objects when rows shift or move, so swap them over to the new first item. Unique
+    // connections make repeated calls for the same change harmless.
+    if (previousFirst && _objectList.contains(previousFirst)) {
+        const QMetaMethod dirtyChangedSignal = _dirtyChangedSignal(previousFirst);
+        if (dirtyChangedSignal.isValid()) {
+            QObject::connect(previousFirst, dirtyChangedSignal, this, childDirtyChangedSlot(), Qt::UniqueConnection);
+        }
+    }
+    if (first) {
+        const QMetaMethod dirtyChangedSignal = _dirtyChangedSignal(first);
+        if (dirtyChangedSignal.isValid()) {
+            QObject::disconnect(first, dirtyChangedSignal, this, childDirtyChangedSlot());
+        }
+    }
+}
+
+void QmlObjectListModel::_disconnectDirtyChanged(QObject* object, int index)
+{
+    if (object && (!_skipDirtyFirstItem || index != 0)) {
+        const QMetaMethod dirtyChangedSignal = _dirtyChangedSignal(object);
+        if (dirtyChangedSignal.isValid()) {
+            QObject::disconnect(object, dirtyChangedSignal, this, childDirtyChangedSlot());
+        }
+    }
+}
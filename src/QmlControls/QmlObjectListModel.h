@@ -11,7 +11,9 @@
 #pragma once
 
 #include <QtCore/QAbstractListModel>
+#include <QtCore/QHash>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QMetaMethod>
 #include <QtQmlIntegration/QtQmlIntegration>
 
 Q_DECLARE_LOGGING_CATEGORY(QmlObjectListModelLog)
@@ -21,6 +23,9 @@ class QmlObjectListModel : public QAbstractListModel
     Q_OBJECT
     QML_ELEMENT
     QML_UNCREATABLE("")
+
+    friend class QmlObjectListModelTest;
+
 public:
     QmlObjectListModel(QObject* parent = nullptr);
     ~QmlObjectListModel() override;
@@ -46,6 +51,7 @@ class QmlObjectListModel : public QAbstractListModel
     QObjectList swapObjectList      (const QObjectList& newlist);
     void        clear               ();
     QObject*    removeAt            (int i);
+    QObjectList removeRange         (int i, int count);
     QObject*    removeOne           (const QObject* object) { return removeAt(indexOf(object)); }
     void        insert              (int i, QObject* object);
     void        insert              (int i, QList<QObject*> objects);
@@ -55,6 +61,15 @@ class QmlObjectListModel : public QAbstractListModel
     /// Moves an item to a new position
     void move(int from, int to);
 
+    /// Moves count items starting at from such that the first of them ends up at index to, as a single row move
+    void moveRange(int from, int count, int to);
+
+    /// Replaces the contents of the list with newlist. Unlike swapObjectList, which resets the model, only the row
+    /// removals, insertions and moves needed to get from the current list to newlist are signalled. Each run of
+    /// adjacent rows is a single signal. Objects must not appear more than once in either list.
+    ///     @return Objects which were in the list but are not in newlist
+    QObjectList syncObjectList      (const QObjectList& newlist);
+
     QObject*    operator[]          (int i);
     const QObject* operator[]       (int i) const;
     template<class T> T value       (int index) const { return qobject_cast<T>(_objectList[index]); }
@@ -80,6 +95,10 @@ private slots:
     
 private:
     void _signalCountChangedIfNotNested();
+    void _connectDirtyChanged       (QObject* object, int index);
+    void _disconnectDirtyChanged    (QObject* object, int index);
+    void _firstItemChanged          (QObject* previousFirst);   ///< Moves the skipped dirtyChanged connection to the new first item
+    QMetaMethod _dirtyChangedSignal (const QObject* object);
     
     // Overrides from QAbstractListModel
     int         rowCount    (const QModelIndex & parent = QModelIndex()) const override;
@@ -95,6 +114,8 @@ private slots:
     bool _dirty;
     bool _skipDirtyFirstItem;
     uint _resetModelNestingCount = 0;
+
+    QHash<const QMetaObject*, QMetaMethod> _dirtyChangedSignals;   ///< Invalid method for types without dirtyChanged(bool)
         
     static constexpr int ObjectRole = Qt::UserRole;
     static constexpr int TextRole = Qt::UserRole + 1;
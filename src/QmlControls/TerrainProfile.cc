@@ -17,6 +17,8 @@
 
 #include <QtQuick/QSGFlatColorMaterial>
 
+#include <cmath>
+
 QGC_LOGGING_CATEGORY(TerrainProfileLog, "Terrain.TerrainProfile")
 
 TerrainProfile::TerrainProfile(QQuickItem* parent)
@@ -75,39 +77,72 @@ void TerrainProfile::_createGeometry(QSGGeometryNode*& geometryNode, QSGGeometry
     geometryNode->setGeometry(geometry);
 }
 
-void TerrainProfile::_updateSegmentCounts(FlightPathSegment* segment, int& cFlightProfileSegments, int& cTerrainProfilePoints, int& cMissingTerrainSegments, int& cTerrainCollisionSegments, double& minTerrainHeight, double& maxTerrainHeight)
+double TerrainProfile::_lodMeters(void) const
 {
-    if (_shouldAddFlightProfileSegment(segment)) {
-        if (segment->segmentType() == FlightPathSegment::SegmentTypeTerrainFrame) {
-            // We show a full above terrain profile for flight segment
-            cFlightProfileSegments += segment->amslTerrainHeights().count() - 1;
-        } else {
-            cFlightProfileSegments++;
-        }
+    if (!(_pixelsPerMeter > 0) || !qIsFinite(_pixelsPerMeter)) {
+        return 0;
     }
 
-    if (_shouldAddMissingTerrainSegment(segment)) {
-        cMissingTerrainSegments += 1;
-    } else {
-        cTerrainProfilePoints += segment->amslTerrainHeights().count();
-        for (int i=0; i<segment->amslTerrainHeights().count(); i++) {
-            minTerrainHeight = std::fmin(minTerrainHeight, segment->amslTerrainHeights()[i].value<double>());
-            maxTerrainHeight = std::fmax(maxTerrainHeight, segment->amslTerrainHeights()[i].value<double>());
-        }
+    // Terrain is decimated into buckets one to two pixels wide. Rounding the bucket size up to a power of two keeps the
+    // cached segment geometry valid across the small changes in total mission distance which come with most edits.
+    return std::exp2(std::ceil(std::log2(1.0 / _pixelsPerMeter)));
+}
+
+QList<QPointF> TerrainProfile::_decimate(const QList<QPointF>& samples, double lodMeters)
+{
+    if (samples.count() <= 2 || lodMeters <= 0) {
+        return samples;
     }
-    if (segment->terrainCollision()) {
-        cTerrainCollisionSegments++;
+
+    // Keep the lowest and highest sample within each bucket, in their original order, so peaks and valleys survive.
+    // The first and last samples are always kept so adjacent segments still join up.
+    QList<QPointF> decimated;
+    decimated.reserve(qMin(samples.count(), (static_cast<qsizetype>(samples.last().x() / lodMeters) + 2) * 2));
+    decimated.append(samples.first());
+
+    const int lastIndex = samples.count() - 1;
+    int index = 1;
+    while (index < lastIndex) {
+        const double bucket = std::floor(samples[index].x() / lodMeters);
+        int minIndex = index;
+        int maxIndex = index;
+        for (index++; index < lastIndex && std::floor(samples[index].x() / lodMeters) == bucket; index++) {
+            if (samples[index].y() < samples[minIndex].y()) {
+                minIndex = index;
+            }
+            if (samples[index].y() > samples[maxIndex].y()) {
+                maxIndex = index;
+            }
+        }
+
+        decimated.append(samples[qMin(minIndex, maxIndex)]);
+        if (minIndex != maxIndex) {
+            decimated.append(samples[qMax(minIndex, maxIndex)]);
+        }
     }
+
+    decimated.append(samples.last());
+    return decimated;
 }
 
-void TerrainProfile::_addTerrainProfileSegment(FlightPathSegment* segment, double currentDistance, double amslAltRange, QSGGeometry::Point2D* terrainVertices, int& terrainProfileVertexIndex)
+void TerrainProfile::_tessellateSegment(FlightPathSegment* segment, double lodMeters, SegmentGeometry& segmentGeometry)
 {
+    const QVariantList& amslTerrainHeights = segment->amslTerrainHeights();
+
+    segmentGeometry = SegmentGeometry();
+    segmentGeometry.totalDistance   = segment->totalDistance();
+    segmentGeometry.lodMeters       = lodMeters;
+    segmentGeometry.missingTerrain  = _shouldAddMissingTerrainSegment(segment);
+    segmentGeometry.dirty           = false;
+
+    QList<QPointF> terrainSamples;
+    terrainSamples.reserve(amslTerrainHeights.count());
     double terrainDistance = 0;
-    for (int heightIndex=0; heightIndex<segment->amslTerrainHeights().count(); heightIndex++) {
+    for (int heightIndex=0; heightIndex<amslTerrainHeights.count(); heightIndex++) {
         // Move along the x axis which is distance
         if (heightIndex == 0) {
             // The first point in the segment is at the position of the last point. So nothing to do here.
-        } else if (heightIndex == segment->amslTerrainHeights().count() - 2) {
+        } else if (heightIndex == amslTerrainHeights.count() - 2) {
             // The distance between the last two heights differs with each terrain query
             terrainDistance += segment->finalDistanceBetween();
         } else {
@@ -115,102 +150,76 @@ void TerrainProfile::_addTerrainProfileSegment(FlightPathSegment* segment, doubl
             terrainDistance += segment->distanceBetween();
         }
 
-        // Move along the y axis which is a view or terrain height as a percentage between the min/max AMSL altitude for all segments
-        double amslTerrainHeight    = segment->amslTerrainHeights()[heightIndex].value<double>();
-        double terrainHeightPercent = (amslTerrainHeight - _minAMSLAlt) / amslAltRange;
-
-        float x = (currentDistance + terrainDistance) * _pixelsPerMeter;
-        float y = height() - (terrainHeightPercent * height());
-        terrainVertices[terrainProfileVertexIndex++].set(x, y);
+        const double amslTerrainHeight = amslTerrainHeights[heightIndex].value<double>();
+        segmentGeometry.minTerrainHeight = std::fmin(segmentGeometry.minTerrainHeight, amslTerrainHeight);
+        segmentGeometry.maxTerrainHeight = std::fmax(segmentGeometry.maxTerrainHeight, amslTerrainHeight);
+        terrainSamples.append(QPointF(terrainDistance, amslTerrainHeight));
     }
-}
+    segmentGeometry.terrainProfile = _decimate(terrainSamples, lodMeters);
 
-void TerrainProfile::_addMissingTerrainSegment(FlightPathSegment* segment, double currentDistance, QSGGeometry::Point2D* missingTerrainVertices, int& missingterrainProfileVertexIndex)
-{
-    if (_shouldAddMissingTerrainSegment(segment)) {
-        float x = currentDistance * _pixelsPerMeter;
-        float y = height();
-        missingTerrainVertices[missingterrainProfileVertexIndex++].set(x, y);
-        missingTerrainVertices[missingterrainProfileVertexIndex++].set(x + (segment->totalDistance() * _pixelsPerMeter), y);
+    if (_shouldAddFlightProfileSegment(segment)) {
+        if (segment->segmentType() == FlightPathSegment::SegmentTypeTerrainFrame) {
+            // We show a full above terrain profile for flight segment
+            const QPointF distanceToSurface(0, segment->coord1AMSLAlt() - amslTerrainHeights.first().value<double>());
+            segmentGeometry.flightProfile.reserve((segmentGeometry.terrainProfile.count() - 1) * 2);
+            for (int i=1; i<segmentGeometry.terrainProfile.count(); i++) {
+                segmentGeometry.flightProfile.append(segmentGeometry.terrainProfile[i - 1] + distanceToSurface);
+                segmentGeometry.flightProfile.append(segmentGeometry.terrainProfile[i] + distanceToSurface);
+            }
+        } else {
+            segmentGeometry.flightProfile.append(QPointF(0,                             segment->coord1AMSLAlt()));
+            segmentGeometry.flightProfile.append(QPointF(segmentGeometry.totalDistance, segment->coord2AMSLAlt()));
+        }
     }
-}
 
-void TerrainProfile::_addTerrainCollisionSegment(FlightPathSegment* segment, double currentDistance, double amslAltRange, QSGGeometry::Point2D* terrainCollisionVertices, int& terrainCollisionVertexIndex)
-{
     if (segment->terrainCollision()) {
-        double amslCoord1Height =       segment->coord1AMSLAlt();
-        double amslCoord2Height =       segment->coord2AMSLAlt();
-        double coord1HeightPercent =    (amslCoord1Height - _minAMSLAlt) / amslAltRange;
-        double coord2HeightPercent =    (amslCoord2Height - _minAMSLAlt) / amslAltRange;
-
-        float x = currentDistance * _pixelsPerMeter;
-        float y = height() - (coord1HeightPercent * height());
-
-        terrainCollisionVertices[terrainCollisionVertexIndex++].set(x, y);
-
-        x += segment->totalDistance() * _pixelsPerMeter;
-        y = height() - (coord2HeightPercent * height());
-
-        terrainCollisionVertices[terrainCollisionVertexIndex++].set(x, y);
+        segmentGeometry.terrainCollision.append(QPointF(0,                              segment->coord1AMSLAlt()));
+        segmentGeometry.terrainCollision.append(QPointF(segmentGeometry.totalDistance,  segment->coord2AMSLAlt()));
     }
 }
 
-void TerrainProfile::_addFlightProfileSegment(FlightPathSegment* segment, double currentDistance, double amslAltRange, QSGGeometry::Point2D* flightProfileVertices, int& flightProfileVertexIndex)
+TerrainProfile::SegmentGeometry& TerrainProfile::_segmentGeometry(FlightPathSegment* segment, double lodMeters)
 {
-    if (!_shouldAddFlightProfileSegment(segment)) {
-        return;
+    auto it = _segmentGeometryCache.find(segment);
+    if (it == _segmentGeometryCache.end()) {
+        it = _segmentGeometryCache.insert(segment, SegmentGeometry());
+
+        // Anything which changes the shape of the segment requires it to be re-tessellated
+        auto invalidate = [this, segment]() { _invalidateSegment(segment); };
+        connect(segment, &FlightPathSegment::amslTerrainHeightsChanged,     this, invalidate);
+        connect(segment, &FlightPathSegment::distanceBetweenChanged,        this, invalidate);
+        connect(segment, &FlightPathSegment::finalDistanceBetweenChanged,   this, invalidate);
+        connect(segment, &FlightPathSegment::totalDistanceChanged,          this, invalidate);
+        connect(segment, &FlightPathSegment::coord1AMSLAltChanged,          this, invalidate);
+        connect(segment, &FlightPathSegment::coord2AMSLAltChanged,          this, invalidate);
+        connect(segment, &FlightPathSegment::terrainCollisionChanged,       this, invalidate);
+        connect(segment, &QObject::destroyed,                               this, [this, segment]() { _segmentGeometryCache.remove(segment); });
     }
 
-    if (segment->segmentType() == FlightPathSegment::SegmentTypeTerrainFrame) {
-        double terrainDistance = 0;
-        double distanceToSurface = segment->coord1AMSLAlt() - segment->amslTerrainHeights().first().value<double>();
-        for (int heightIndex=0; heightIndex<segment->amslTerrainHeights().count(); heightIndex++) {
-            // Move along the x axis which is distance
-            if (heightIndex == 0) {
-                // The first point in the segment is at the position of the last point. So nothing to do here.
-            } else if (heightIndex == segment->amslTerrainHeights().count() - 2) {
-                // The distance between the last two heights differs with each terrain query
-                terrainDistance += segment->finalDistanceBetween();
-            } else {
-                // The distance between all terrain heights except for the last is the same
-                terrainDistance += segment->distanceBetween();
-            }
-
-            if (heightIndex > 1) {
-                // Add first coord of segment
-                auto previousVertex = flightProfileVertices[flightProfileVertexIndex-1];
-                flightProfileVertices[flightProfileVertexIndex++].set(previousVertex.x, previousVertex.y);
-            }
-
-            // Add second coord of segment (or very first one)
-            double amslTerrainHeight    = segment->amslTerrainHeights()[heightIndex].value<double>() + distanceToSurface;
-            double terrainHeightPercent = (amslTerrainHeight - _minAMSLAlt) / amslAltRange;
-
-            float x = (currentDistance + terrainDistance) * _pixelsPerMeter;
-            float y = height() - (terrainHeightPercent * height());
-            flightProfileVertices[flightProfileVertexIndex++].set(x, y);
-
-        }
-    } else {
-        double amslCoord1Height =       segment->coord1AMSLAlt();
-        double amslCoord2Height =       segment->coord2AMSLAlt();
-        double coord1HeightPercent =    (amslCoord1Height - _minAMSLAlt) / amslAltRange;
-        double coord2HeightPercent =    (amslCoord2Height - _minAMSLAlt) / amslAltRange;
-
-        float x = currentDistance * _pixelsPerMeter;
-        float y = height() - (coord1HeightPercent * height());
-
-        flightProfileVertices[flightProfileVertexIndex++].set(x, y);
+    if (it->dirty || (it->lodMeters != lodMeters)) {
+        _tessellateSegment(segment, lodMeters, *it);
+        _tessellatedSegments++;
+    }
 
-        x += segment->totalDistance() * _pixelsPerMeter;
-        y = height() - (coord2HeightPercent * height());
+    return *it;
+}
 
-        flightProfileVertices[flightProfileVertexIndex++].set(x, y);
+void TerrainProfile::_invalidateSegment(FlightPathSegment* segment)
+{
+    auto it = _segmentGeometryCache.find(segment);
+    if (it != _segmentGeometryCache.end()) {
+        it->dirty = true;
     }
+    emit _updateSignal();
 }
 
 QSGNode* TerrainProfile::updatePaintNode(QSGNode* oldNode, QQuickItem::UpdatePaintNodeData* /*updatePaintNodeData*/)
 {
+    struct SegmentPlacement {
+        FlightPathSegment*  segment;
+        double              distance;
+    };
+
     QSGNode*        rootNode =                  static_cast<QSGNode *>(oldNode);
     QSGGeometry*    terrainProfileGeometry =    nullptr;
     QSGGeometry*    missingTerrainGeometry =    nullptr;
@@ -218,33 +227,54 @@ QSGNode* TerrainProfile::updatePaintNode(QSGNode* oldNode, QQuickItem::UpdatePai
     QSGGeometry*    terrainCollisionGeometry =  nullptr;
     int             cTerrainProfilePoints =     0;
     int             cMissingTerrainSegments =   0;
-    int             cFlightProfileSegments =    0;
-    int             cTerrainCollisionSegments = 0;
+    int             cFlightProfilePoints =      0;
+    int             cTerrainCollisionPoints =   0;
     double          minTerrainHeight =          qQNaN();
     double          maxTerrainHeight =          qQNaN();
+    double          currentDistance =           0;
 
-    // First we need to determine:
-    //  - how many terrain profile vertices we need
-    //  - how many missing terrain segments there are
-    //  - how many flight profile segments we need
-    //  - how many terrain collision segments there are
-    //  - what is the total distance so we can calculate pixels per meter
+    _pixelsPerMeter         = _visibleWidth / _missionController->missionTotalDistance();
+    _tessellatedSegments    = 0;
+
+    const double lodMeters = _lodMeters();
+
+    // First we walk the flight path to determine where each segment starts. Segments which have changed since the last
+    // update (or were tessellated for a different level of detail) are re-tessellated, all others come from the cache.
+    // The cached geometry tells us:
+    //  - how many vertices we need for each node
+    //  - the min/max terrain height
+    QList<SegmentPlacement> placements;
+    auto addSegment = [&](FlightPathSegment* segment) {
+        const SegmentGeometry& segmentGeometry = _segmentGeometry(segment, lodMeters);
+
+        cTerrainProfilePoints   += segmentGeometry.terrainProfile.count();
+        cMissingTerrainSegments += segmentGeometry.missingTerrain ? 1 : 0;
+        cFlightProfilePoints    += segmentGeometry.flightProfile.count();
+        cTerrainCollisionPoints += segmentGeometry.terrainCollision.count();
+        minTerrainHeight        = std::fmin(minTerrainHeight, segmentGeometry.minTerrainHeight);
+        maxTerrainHeight        = std::fmax(maxTerrainHeight, segmentGeometry.maxTerrainHeight);
+
+        placements.append({ segment, currentDistance });
+        currentDistance += segment->totalDistance();
+    };
 
     for (int viIndex=0; viIndex<_visualItems->count(); viIndex++) {
         VisualMissionItem*  visualItem =    _visualItems->value<VisualMissionItem*>(viIndex);
         ComplexMissionItem* complexItem =   _visualItems->value<ComplexMissionItem*>(viIndex);
 
-        if (visualItem->simpleFlightPathSegment()) {
-            FlightPathSegment* segment = visualItem->simpleFlightPathSegment();
-            _updateSegmentCounts(segment, cFlightProfileSegments, cTerrainProfilePoints, cMissingTerrainSegments, cTerrainCollisionSegments, minTerrainHeight, maxTerrainHeight);
-        }
-
         if (complexItem) {
-            for (int segmentIndex=0; segmentIndex<complexItem->flightPathSegments()->count(); segmentIndex++) {
-                FlightPathSegment* segment = complexItem->flightPathSegments()->value<FlightPathSegment*>(segmentIndex);
-                _updateSegmentCounts(segment, cFlightProfileSegments, cTerrainProfilePoints, cMissingTerrainSegments, cTerrainCollisionSegments, minTerrainHeight, maxTerrainHeight);
+            if (complexItem->flightPathSegments()->count() == 0) {
+                currentDistance += complexItem->complexDistance();
+            } else {
+                for (int segmentIndex=0; segmentIndex<complexItem->flightPathSegments()->count(); segmentIndex++) {
+                    addSegment(complexItem->flightPathSegments()->value<FlightPathSegment*>(segmentIndex));
+                }
             }
         }
+
+        if (visualItem->simpleFlightPathSegment()) {
+            addSegment(visualItem->simpleFlightPathSegment());
+        }
     }
 
     // The profile view min/max is setup to include a full terrain profile as well as the flight path segments.
@@ -263,10 +293,8 @@ QSGNode* TerrainProfile::updatePaintNode(QSGNode* oldNode, QQuickItem::UpdatePai
 
     static int counter = 0;
     qCDebug(TerrainProfileLog) << "missionController min/max" << _missionController->minAMSLAltitude() << _missionController->maxAMSLAltitude();
-    qCDebug(TerrainProfileLog) << QStringLiteral("updatePaintNode counter:%1 cFlightProfileSegments:%2 cTerrainProfilePoints:%3 cMissingTerrainSegments:%4 cTerrainCollisionSegments:%5 _minAMSLAlt:%6 _maxAMSLAlt:%7 maxTerrainHeight:%8")
-                                  .arg(counter++).arg(cFlightProfileSegments).arg(cTerrainProfilePoints).arg(cMissingTerrainSegments).arg(cTerrainCollisionSegments).arg(_minAMSLAlt).arg(_maxAMSLAlt).arg(maxTerrainHeight);
-
-    _pixelsPerMeter = _visibleWidth / _missionController->missionTotalDistance();
+    qCDebug(TerrainProfileLog) << QStringLiteral("updatePaintNode counter:%1 cFlightProfilePoints:%2 cTerrainProfilePoints:%3 cMissingTerrainSegments:%4 cTerrainCollisionPoints:%5 _minAMSLAlt:%6 _maxAMSLAlt:%7 maxTerrainHeight:%8 lodMeters:%9 tessellatedSegments:%10")
+                                  .arg(counter++).arg(cFlightProfilePoints).arg(cTerrainProfilePoints).arg(cMissingTerrainSegments).arg(cTerrainCollisionPoints).arg(_minAMSLAlt).arg(_maxAMSLAlt).arg(maxTerrainHeight).arg(lodMeters).arg(_tessellatedSegments);
 
     // Instantiate nodes
     if (!rootNode) {
@@ -302,55 +330,41 @@ QSGNode* TerrainProfile::updatePaintNode(QSGNode* oldNode, QQuickItem::UpdatePai
 
     node = rootNode->childAtIndex(2);
     flightProfileGeometry = static_cast<QSGGeometryNode*>(node)->geometry();
-    flightProfileGeometry->allocate(cFlightProfileSegments * 2);
+    flightProfileGeometry->allocate(cFlightProfilePoints);
     node->markDirty(QSGNode::DirtyGeometry);
 
     node = rootNode->childAtIndex(3);
     terrainCollisionGeometry = static_cast<QSGGeometryNode*>(node)->geometry();
-    terrainCollisionGeometry->allocate(cTerrainCollisionSegments * 2);
+    terrainCollisionGeometry->allocate(cTerrainCollisionPoints);
     node->markDirty(QSGNode::DirtyGeometry);
 
-    int                     flightProfileVertexIndex =          0;
-    int                     terrainProfileVertexIndex =         0;
-    int                     missingterrainProfileVertexIndex =  0;
-    int                     terrainCollisionVertexIndex =       0;
-    double                  currentDistance =                   0;
-    QSGGeometry::Point2D*   flightProfileVertices =             flightProfileGeometry->vertexDataAsPoint2D();
-    QSGGeometry::Point2D*   terrainProfileVertices =            terrainProfileGeometry->vertexDataAsPoint2D();
-    QSGGeometry::Point2D*   missingTerrainVertices =            missingTerrainGeometry->vertexDataAsPoint2D();
-    QSGGeometry::Point2D*   terrainCollisionVertices =          terrainCollisionGeometry->vertexDataAsPoint2D();
-
-    // This step places the vertices for display into the nodes
-    for (int viIndex=0; viIndex<_visualItems->count(); viIndex++) {
-        VisualMissionItem*  visualItem =    _visualItems->value<VisualMissionItem*>(viIndex);
-        ComplexMissionItem* complexItem =   _visualItems->value<ComplexMissionItem*>(viIndex);
-
-        if (complexItem) {
-            if (complexItem->flightPathSegments()->count() == 0) {
-                currentDistance += complexItem->complexDistance();
-            } else {
-                for (int segmentIndex=0; segmentIndex<complexItem->flightPathSegments()->count(); segmentIndex++) {
-                    FlightPathSegment* segment = complexItem->flightPathSegments()->value<FlightPathSegment*>(segmentIndex);
-
-                    _addFlightProfileSegment    (segment, currentDistance, amslAltRange,    flightProfileVertices,      flightProfileVertexIndex);
-                    _addTerrainProfileSegment   (segment, currentDistance, amslAltRange,    terrainProfileVertices,     terrainProfileVertexIndex);
-                    _addMissingTerrainSegment   (segment, currentDistance,                  missingTerrainVertices,     missingterrainProfileVertexIndex);
-                    _addTerrainCollisionSegment (segment, currentDistance, amslAltRange,    terrainCollisionVertices,   terrainCollisionVertexIndex);
-
-                    currentDistance += segment->totalDistance();
-                }
-            }
+    QSGGeometry::Point2D*   flightProfileVertices =     flightProfileGeometry->vertexDataAsPoint2D();
+    QSGGeometry::Point2D*   terrainProfileVertices =    terrainProfileGeometry->vertexDataAsPoint2D();
+    QSGGeometry::Point2D*   missingTerrainVertices =    missingTerrainGeometry->vertexDataAsPoint2D();
+    QSGGeometry::Point2D*   terrainCollisionVertices =  terrainCollisionGeometry->vertexDataAsPoint2D();
+
+    // This step places the cached vertices for display into the nodes. The x axis is distance, the y axis is the
+    // AMSL height as a percentage between the min/max AMSL altitude for all segments.
+    const double itemHeight = height();
+    auto addVertices = [&](const QList<QPointF>& points, double distance, QSGGeometry::Point2D*& vertices) {
+        for (const QPointF& point: points) {
+            float x = (distance + point.x()) * _pixelsPerMeter;
+            float y = itemHeight - (((point.y() - _minAMSLAlt) / amslAltRange) * itemHeight);
+            (vertices++)->set(x, y);
         }
+    };
 
-        if (visualItem->simpleFlightPathSegment()) {
-            FlightPathSegment* segment = visualItem->simpleFlightPathSegment();
+    for (const SegmentPlacement& placement: std::as_const(placements)) {
+        const SegmentGeometry& segmentGeometry = _segmentGeometryCache.constFind(placement.segment).value();
 
-            _addFlightProfileSegment    (segment, currentDistance, amslAltRange,    flightProfileVertices,      flightProfileVertexIndex);
-            _addTerrainProfileSegment   (segment, currentDistance, amslAltRange,    terrainProfileVertices,     terrainProfileVertexIndex);
-            _addMissingTerrainSegment   (segment, currentDistance,                  missingTerrainVertices,     missingterrainProfileVertexIndex);
-            _addTerrainCollisionSegment (segment, currentDistance, amslAltRange,    terrainCollisionVertices,   terrainCollisionVertexIndex);
+        addVertices(segmentGeometry.flightProfile,      placement.distance, flightProfileVertices);
+        addVertices(segmentGeometry.terrainProfile,     placement.distance, terrainProfileVertices);
+        addVertices(segmentGeometry.terrainCollision,   placement.distance, terrainCollisionVertices);
 
-            currentDistance += segment->totalDistance();
+        if (segmentGeometry.missingTerrain) {
+            float x = placement.distance * _pixelsPerMeter;
+            (missingTerrainVertices++)->set(x, itemHeight);
+            (missingTerrainVertices++)->set(x + (segmentGeometry.totalDistance * _pixelsPerMeter), itemHeight);
         }
     }
 
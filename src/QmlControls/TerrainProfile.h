@@ -9,7 +9,10 @@
 
 #pragma once
 
+#include <QtCore/QHash>
+#include <QtCore/QList>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QPointF>
 #include <QtQuick/QQuickItem>
 #include <QtQuick/QSGGeometryNode>
 #include <QtQuick/QSGGeometry>
@@ -28,6 +31,8 @@ class TerrainProfile : public QQuickItem
     Q_OBJECT
     QML_ELEMENT
 
+    friend class TerrainProfileTest;
+
 public:
     TerrainProfile(QQuickItem *parent = nullptr);
 
@@ -59,21 +64,40 @@ private slots:
     void _newVisualItems            (void);
 
 private:
+    /// Tessellated vertices for a single flight path segment. Positions are stored as meters along the segment (x) and AMSL
+    /// meters (y) so the cache stays valid when the overall profile scale changes. Only rebuilt when the segment changes or
+    /// the level of detail changes.
+    struct SegmentGeometry {
+        QList<QPointF>  terrainProfile;                 ///< Line strip, decimated to the level of detail
+        QList<QPointF>  flightProfile;                  ///< Line pairs
+        QList<QPointF>  terrainCollision;               ///< Line pairs
+        double          totalDistance =     0;
+        double          minTerrainHeight =  qQNaN();
+        double          maxTerrainHeight =  qQNaN();
+        double          lodMeters =         -1;
+        bool            missingTerrain =    false;
+        bool            dirty =             true;
+    };
+
     void    _createGeometry                 (QSGGeometryNode*& geometryNode, QSGGeometry*& geometry, QSGGeometry::DrawingMode drawingMode, const QColor& color);
-    void    _updateSegmentCounts            (FlightPathSegment* segment, int& cFlightProfileSegments, int& cTerrainPoints, int& cMissingTerrainSegments, int& cTerrainCollisionSegments, double& minTerrainHeight, double& maxTerrainHeight);
-    void    _addTerrainProfileSegment       (FlightPathSegment* segment, double currentDistance, double amslAltRange, QSGGeometry::Point2D* terrainProfileVertices, int& terrainVertexIndex);
-    void    _addMissingTerrainSegment       (FlightPathSegment* segment, double currentDistance, QSGGeometry::Point2D* missingTerrainVertices, int& missingTerrainVertexIndex);
-    void    _addTerrainCollisionSegment     (FlightPathSegment* segment, double currentDistance, double amslAltRange, QSGGeometry::Point2D* terrainCollisionVertices, int& terrainCollisionVertexIndex);
-    void    _addFlightProfileSegment        (FlightPathSegment* segment, double currentDistance, double amslAltRange, QSGGeometry::Point2D* flightProfileVertices, int& flightProfileVertexIndex);
+    SegmentGeometry& _segmentGeometry       (FlightPathSegment* segment, double lodMeters);
+    void    _tessellateSegment              (FlightPathSegment* segment, double lodMeters, SegmentGeometry& segmentGeometry);
+    void    _invalidateSegment              (FlightPathSegment* segment);
+    double  _lodMeters                      (void) const;
     bool    _shouldAddFlightProfileSegment  (FlightPathSegment* segment);
     bool    _shouldAddMissingTerrainSegment (FlightPathSegment* segment);
 
+    static QList<QPointF> _decimate         (const QList<QPointF>& samples, double lodMeters);
+
     MissionController*  _missionController =    nullptr;
     QmlObjectListModel* _visualItems =          nullptr;
     double              _visibleWidth =         0;
     double              _pixelsPerMeter =       0;
     double              _minAMSLAlt =           0;
     double              _maxAMSLAlt =           0;
+    int                 _tessellatedSegments =  0;  ///< Number of segments re-tessellated by the last updatePaintNode
+
+    QHash<FlightPathSegment*, SegmentGeometry> _segmentGeometryCache;
 
     static const int _lineWidth =       7;
 
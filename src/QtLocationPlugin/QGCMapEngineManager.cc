@@ -385,6 +385,7 @@ bool QGCMapEngineManager::importSets(const QString &path)
         task->deleteLater();
         return false;
     }
+    _importTask = task;
 
     return true;
 }
@@ -420,14 +421,26 @@ bool QGCMapEngineManager::exportSets(const QString &path)
         task->deleteLater();
         return false;
     }
+    _exportTask = task;
 
     return true;
 }
 
+void QGCMapEngineManager::cancelImportExport()
+{
+    if (_importTask) {
+        _importTask->cancel();
+    }
+    if (_exportTask) {
+        _exportTask->cancel();
+    }
+}
+
 void QGCMapEngineManager::_actionCompleted()
 {
     const ImportAction oldState = _importAction;
-    setImportAction(ImportAction::ActionDone);
+    const bool canceled = (_importTask && _importTask->canceled()) || (_exportTask && _exportTask->canceled());
+    setImportAction(canceled ? ImportAction::ActionNone : ImportAction::ActionDone);
 
     if (oldState == ImportAction::ActionImporting) {
         loadTileSets();
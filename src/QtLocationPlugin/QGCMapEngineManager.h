@@ -10,6 +10,7 @@
 #pragma once
 
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QPointer>
 #include <QtQmlIntegration/QtQmlIntegration>
 
 #include "QGCTileSet.h"
@@ -56,6 +57,7 @@ class QGCMapEngineManager : public QObject
     Q_ENUM(ImportAction)
 
     Q_INVOKABLE bool exportSets(const QString &path = QString());
+    Q_INVOKABLE void cancelImportExport();
     Q_INVOKABLE bool findName(const QString &name) const;
     Q_INVOKABLE bool importSets(const QString &path = QString());
     Q_INVOKABLE QString getUniqueName() const;
@@ -116,6 +118,8 @@ private slots:
 
 private:
     QmlObjectListModel *_tileSets = nullptr;
+    QPointer<QGCImportTileTask> _importTask;
+    QPointer<QGCExportTileTask> _exportTask;
     QGCTileSet _imageSet;
     QGCTileSet _elevationSet;
     ImportAction _importAction = ImportAction::ActionNone;
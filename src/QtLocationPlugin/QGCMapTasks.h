@@ -334,6 +334,10 @@ class QGCExportTileTask : public QGCMapTask
     QList<QGCCachedTileSet*> sets() const { return m_sets; }
     QString path() const { return m_path; }
 
+    /// May be called from any thread, the export stops after the batch in progress and removes the partial file
+    void cancel() { m_canceled = true; }
+    bool canceled() const { return m_canceled; }
+
     void setExportCompleted()
     {
         emit actionCompleted();
@@ -351,6 +355,7 @@ class QGCExportTileTask : public QGCMapTask
 private:
     const QList<QGCCachedTileSet*> m_sets;
     const QString m_path;
+    std::atomic_bool m_canceled = false;
 };
 
 //-----------------------------------------------------------------------------
@@ -371,6 +376,10 @@ class QGCImportTileTask : public QGCMapTask
     bool replace() const { return m_replace; }
     int progress() const { return m_progress; }
 
+    /// May be called from any thread, the import stops after the batch in progress and nothing is imported
+    void cancel() { m_canceled = true; }
+    bool canceled() const { return m_canceled; }
+
     void setImportCompleted()
     {
         emit actionCompleted();
@@ -390,6 +399,7 @@ class QGCImportTileTask : public QGCMapTask
     const QString m_path;
     const bool m_replace = false;
     int m_progress = 0;
+    std::atomic_bool m_canceled = false;
 };
 
 //-----------------------------------------------------------------------------
@@ -15,6 +15,7 @@
 #include <QtCore/QSettings>
 #include <QtSql/QSqlDatabase>
 #include <QtSql/QSqlQuery>
+#include <QtSql/QSqlRecord>
 #include <QtSql/QSqlError>
 
 #include "QGCCachedTileSet.h"
@@ -279,11 +280,12 @@ void QGCCacheWorker::_getTile(QGCMapTask* mtask)
 
     QGCFetchTileTask *task = static_cast<QGCFetchTileTask*>(mtask);
     QSqlQuery query(*_db);
-    const QString s = QStringLiteral("SELECT tile, format, type FROM Tiles WHERE hash = \"%1\"").arg(task->hash());
+    const QString s = QStringLiteral("SELECT tile, format, type, tileID FROM Tiles WHERE hash = \"%1\"").arg(task->hash());
     if (query.exec(s) && query.next()) {
         const QByteArray &arrray = query.value(0).toByteArray();
         const QString &format = query.value(1).toString();
         const QString &type = query.value(2).toString();
+        (void) _accessedTiles.insert(query.value(3).toULongLong());
         qCDebug(QGCTileCacheWorkerLog) << "(Found in DB) HASH:" << task->hash();
         QGCCacheTile *tile = new QGCCacheTile(task->hash(), arrray, format, type);
         task->setTileFetched(tile);
@@ -388,19 +390,17 @@ void QGCCacheWorker::_updateSetTotals(QGCCachedTileSet *set)
 
 void QGCCacheWorker::_updateTotals()
 {
+    _updateTileAccess();
+
+    // CacheTotals is kept up to date by triggers, see _createCacheTotals
     QSqlQuery query(*_db);
-    QString s = QStringLiteral("SELECT COUNT(size), SUM(size) FROM Tiles");
-    qCDebug(QGCTileCacheWorkerLog) << s;
-    if (query.exec(s) && query.next()) {
+    if (query.exec("SELECT totalCount, totalSize, defaultCount, defaultSize FROM CacheTotals") && query.next()) {
         _totalCount = query.value(0).toUInt();
-        _totalSize  = query.value(1).toULongLong();
-    }
-
-    s = QStringLiteral("SELECT COUNT(size), SUM(size) FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A join SetTiles B on A.tileID = B.tileID WHERE B.setID = %1 GROUP by A.tileID HAVING COUNT(A.tileID) = 1)").arg(_getDefaultTileSet());
-    qCDebug(QGCTileCacheWorkerLog) << s;
-    if (query.exec(s) && query.next()) {
-        _defaultCount = query.value(0).toUInt();
-        _defaultSize = query.value(1).toULongLong();
+        _totalSize = query.value(1).toULongLong();
+        _defaultCount = query.value(2).toUInt();
+        _defaultSize = query.value(3).toULongLong();
+    } else {
+        qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (read CacheTotals):" << query.lastError().text();
     }
 
     emit updateTotals(_totalCount, _totalSize, _defaultCount, _defaultSize);
@@ -562,26 +562,32 @@ void QGCCacheWorker::_pruneCache(QGCMapTask *mtask)
     }
 
     QGCPruneCacheTask *task = static_cast<QGCPruneCacheTask*>(mtask);
+    _updateTileAccess();
+
+    // Walk the tiles in the default set only, least recently used first, until enough space would be freed.
     QSqlQuery query(*_db);
-    // Select tiles in default set only, sorted by oldest.
-    QString s = QStringLiteral("SELECT tileID, size, hash FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A join SetTiles B on A.tileID = B.tileID WHERE B.setID = %1 GROUP by A.tileID HAVING COUNT(A.tileID) = 1) ORDER BY DATE ASC LIMIT 128").arg(_getDefaultTileSet());
-    if (!query.exec(s)) {
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT size FROM DefaultTiles ORDER BY accessed ASC, tileID ASC")) {
+        qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (select tiles to prune):" << query.lastError().text();
+        task->setPruned();
         return;
     }
 
-    QList<quint64> tlist;
-    qint64 amount = static_cast<qint64>(task->amount());
-    while (query.next() && (amount >= 0)) {
-        tlist << query.value(0).toULongLong();
-        amount -= query.value(1).toULongLong();
-        qCDebug(QGCTileCacheWorkerLog) << "HASH:" << query.value(2).toString();
+    quint64 pruneCount = 0;
+    quint64 pruneSize = 0;
+    while ((pruneSize < task->amount()) && query.next()) {
+        pruneSize += query.value(0).toULongLong();
+        pruneCount++;
     }
+    query.finish();
 
-    while (!tlist.isEmpty()) {
-        s = QStringLiteral("DELETE FROM Tiles WHERE tileID = %1").arg(tlist[0]);
-        tlist.removeFirst();
-        if (!query.exec(s)) {
-            break;
+    // Evict them all with one statement, the triggers take care of SetTiles and the totals
+    if (pruneCount > 0) {
+        const QString s = QStringLiteral("DELETE FROM Tiles WHERE tileID IN (SELECT tileID FROM DefaultTiles ORDER BY accessed ASC, tileID ASC LIMIT %1)").arg(pruneCount);
+        if (query.exec(s)) {
+            qCDebug(QGCTileCacheWorkerLog) << "Pruned" << pruneCount << "tiles," << pruneSize << "bytes";
+        } else {
+            qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (prune tiles):" << query.lastError().text();
         }
     }
 
@@ -644,6 +650,11 @@ void QGCCacheWorker::_resetCacheDatabase(QGCMapTask *mtask)
     (void) query.exec(s);
     s = QStringLiteral("DROP TABLE TilesDownload");
     (void) query.exec(s);
+    s = QStringLiteral("DROP TABLE DefaultTiles");
+    (void) query.exec(s);
+    s = QStringLiteral("DROP TABLE CacheTotals");
+    (void) query.exec(s);
+    _accessedTiles.clear();
     _valid = _createDB(*_db);
     task->setResetCompleted();
 }
@@ -669,158 +680,126 @@ void QGCCacheWorker::_importSets(QGCMapTask *mtask)
             _connectDB();
         }
         task->setProgress(100);
-    } else {
-        // Open imported set
-        QSqlDatabase *dbImport = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kExportSession));
-        dbImport->setDatabaseName(task->path());
-        dbImport->setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-        if (dbImport->open()) {
-            QSqlQuery query(*dbImport);
-            // Prepare progress report
-            quint64 tileCount = 0;
-            int lastProgress = -1;
-            QString s = QStringLiteral("SELECT COUNT(tileID) FROM Tiles");
-            if (query.exec(s) && query.next()) {
-                // Total number of tiles in imported database
-                tileCount  = query.value(0).toULongLong();
-            }
+        task->setImportCompleted();
+        return;
+    }
+
+    if (!_attachDatabase(task->path(), kImportSchema)) {
+        task->setError("Error opening import database");
+        task->setImportCompleted();
+        return;
+    }
+
+    QSqlQuery query(*_db);
+    // Prepare progress report
+    quint64 tileCount = 0;
+    if (query.exec(QStringLiteral("SELECT COUNT(tileID) FROM %1.SetTiles").arg(kImportSchema)) && query.next()) {
+        // Total number of set memberships in imported database
+        tileCount = query.value(0).toULongLong();
+    }
 
-            if (tileCount > 0) {
-                // Iterate Tile Sets
-                s = QStringLiteral("SELECT * FROM TileSets ORDER BY defaultSet DESC, name ASC");
-                if (query.exec(s)) {
-                    quint64 currentCount = 0;
-                    while (query.next()) {
-                        QString name = query.value("name").toString();
-                        const quint64 setID = query.value("setID").toULongLong();
-                        const QString mapType = query.value("typeStr").toString();
-                        const double topleftLat = query.value("topleftLat").toDouble();
-                        const double topleftLon = query.value("topleftLon").toDouble();
-                        const double bottomRightLat = query.value("bottomRightLat").toDouble();
-                        const double bottomRightLon = query.value("bottomRightLon").toDouble();
-                        const int minZoom = query.value("minZoom").toInt();
-                        const int maxZoom = query.value("maxZoom").toInt();
-                        const int type = query.value("type").toInt();
-                        const quint32 numTiles = query.value("numTiles").toUInt();
-                        const int defaultSet = query.value("defaultSet").toInt();
-                        quint64 insertSetID = _getDefaultTileSet();
-                        // If not default set, create new one
-                        if (defaultSet == 0) {
-                            // Check if we have this tile set already
-                            if (_findTileSetID(name, insertSetID)) {
-                                int testCount = 0;
-                                // Set with this name already exists. Make name unique.
-                                while (true) {
-                                    const QString testName = QString::asprintf("%s %02d", name.toLatin1().constData(), ++testCount);
-                                    if (!_findTileSetID(testName, insertSetID) || (testCount > 99)) {
-                                        name = testName;
-                                        break;
-                                    }
-                                }
-                            }
-                            // Create new set
-                            QSqlQuery cQuery(*_db);
-                            (void) cQuery.prepare("INSERT INTO TileSets("
-                                "name, typeStr, topleftLat, topleftLon, bottomRightLat, bottomRightLon, minZoom, maxZoom, type, numTiles, defaultSet, date"
-                                ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-                            cQuery.addBindValue(name);
-                            cQuery.addBindValue(mapType);
-                            cQuery.addBindValue(topleftLat);
-                            cQuery.addBindValue(topleftLon);
-                            cQuery.addBindValue(bottomRightLat);
-                            cQuery.addBindValue(bottomRightLon);
-                            cQuery.addBindValue(minZoom);
-                            cQuery.addBindValue(maxZoom);
-                            cQuery.addBindValue(type);
-                            cQuery.addBindValue(numTiles);
-                            cQuery.addBindValue(defaultSet);
-                            cQuery.addBindValue(QDateTime::currentSecsSinceEpoch());
-                            if (!cQuery.exec()) {
-                                task->setError("Error adding imported tile set to database");
-                                break;
-                            } else {
-                                // Get just created (auto-incremented) setID
-                                insertSetID = cQuery.lastInsertId().toULongLong();
-                            }
-                        }
-
-                        // Find set tiles
-                        QSqlQuery cQuery(*_db);
-                        QSqlQuery subQuery(*dbImport);
-                        const QString sb = QStringLiteral("SELECT * FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A JOIN SetTiles B ON A.tileID = B.tileID WHERE B.setID = %1 GROUP BY A.tileID HAVING COUNT(A.tileID) = 1)").arg(setID);
-                        if (subQuery.exec(sb)) {
-                            quint64 tilesFound = 0;
-                            quint64 tilesSaved = 0;
-                            (void) _db->transaction();
-                            while (subQuery.next()) {
-                                tilesFound++;
-                                const QString hash = subQuery.value("hash").toString();
-                                const QString format = subQuery.value("format").toString();
-                                const QByteArray img = subQuery.value("tile").toByteArray();
-                                const int type = subQuery.value("type").toInt();
-                                // Save tile
-                                (void) cQuery.prepare("INSERT INTO Tiles(hash, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)");
-                                cQuery.addBindValue(hash);
-                                cQuery.addBindValue(format);
-                                cQuery.addBindValue(img);
-                                cQuery.addBindValue(img.size());
-                                cQuery.addBindValue(type);
-                                cQuery.addBindValue(QDateTime::currentSecsSinceEpoch());
-                                if (cQuery.exec()) {
-                                    tilesSaved++;
-                                    const quint64 importTileID = cQuery.lastInsertId().toULongLong();
-                                    const QString s2 = QStringLiteral("INSERT INTO SetTiles(tileID, setID) VALUES(%1, %2)").arg(importTileID).arg(insertSetID);
-                                    (void) cQuery.prepare(s2);
-                                    (void) cQuery.exec();
-                                    currentCount++;
-                                    if (tileCount > 0) {
-                                        const int progress = static_cast<int>((static_cast<double>(currentCount) / static_cast<double>(tileCount)) * 100.0);
-                                        // Avoid calling this if (int) progress hasn't changed.
-                                        if (lastProgress != progress) {
-                                            lastProgress = progress;
-                                            task->setProgress(progress);
-                                        }
-                                    }
-                                }
-                            }
-
-                            (void) _db->commit();
-                            if (tilesSaved > 0) {
-                                // Update tile count (if any added)
-                                s = QStringLiteral("SELECT COUNT(size) FROM Tiles A INNER JOIN SetTiles B on A.tileID = B.tileID WHERE B.setID = %1").arg(insertSetID);
-                                if (cQuery.exec(s) && cQuery.next()) {
-                                    const quint64 count = cQuery.value(0).toULongLong();
-                                    s = QStringLiteral("UPDATE TileSets SET numTiles = %1 WHERE setID = %2").arg(count).arg(insertSetID);
-                                    (void) cQuery.exec(s);
-                                }
-                            }
-
-                            const qint64 uniqueTiles = tilesFound - tilesSaved;
-                            if (static_cast<quint64>(uniqueTiles) < tileCount) {
-                                tileCount -= uniqueTiles;
-                            } else {
-                                tileCount = 0;
-                            }
-
-                            // If there was nothing new in this set, remove it.
-                            if ((tilesSaved == 0) && (defaultSet == 0)) {
-                                qCDebug(QGCTileCacheWorkerLog) << "No unique tiles in" << name << "Removing it.";
-                                _deleteTileSet(insertSetID);
-                            }
-                        }
+    QList<QSqlRecord> importSets;
+    if (query.exec(QStringLiteral("SELECT * FROM %1.TileSets ORDER BY defaultSet DESC, name ASC").arg(kImportSchema))) {
+        while (query.next()) {
+            importSets.append(query.record());
+        }
+    }
+    query.finish();
+
+    if (tileCount == 0) {
+        task->setError(importSets.isEmpty() ? "No tile set in database" : "No unique tiles in imported database");
+        _detachDatabase(kImportSchema);
+        task->setImportCompleted();
+        return;
+    }
+
+    // Everything is imported in one transaction so a canceled or failed import leaves the cache untouched
+    quint64 currentCount = 0;
+    int lastProgress = -1;
+    const auto progress = [task, tileCount, &currentCount, &lastProgress](quint64 count) {
+        currentCount += count;
+        const int percentage = static_cast<int>((static_cast<double>(currentCount) / static_cast<double>(tileCount)) * 100.0);
+        // Avoid calling this if (int) progress hasn't changed.
+        if (lastProgress != percentage) {
+            lastProgress = percentage;
+            task->setProgress(percentage);
+        }
+        return !task->canceled();
+    };
+
+    bool ok = _db->transaction();
+    quint64 tilesSaved = 0;
+    int setsCreated = 0;
+    for (const QSqlRecord &record : std::as_const(importSets)) {
+        QString name = record.value("name").toString();
+        const int defaultSet = record.value("defaultSet").toInt();
+        quint64 insertSetID = _getDefaultTileSet();
+        // If not default set, create new one
+        if (defaultSet == 0) {
+            // Check if we have this tile set already
+            if (_findTileSetID(name, insertSetID)) {
+                int testCount = 0;
+                // Set with this name already exists. Make name unique.
+                while (true) {
+                    const QString testName = QString::asprintf("%s %02d", name.toLatin1().constData(), ++testCount);
+                    if (!_findTileSetID(testName, insertSetID) || (testCount > 99)) {
+                        name = testName;
+                        break;
                     }
-                } else {
-                    task->setError("No tile set in database");
                 }
             }
-            delete dbImport;
-            QSqlDatabase::removeDatabase(kExportSession);
-            if (tileCount == 0) {
-                task->setError("No unique tiles in imported database");
+            // Create new set
+            QSqlQuery cQuery(*_db);
+            (void) cQuery.prepare("INSERT INTO TileSets("
+                "name, typeStr, topleftLat, topleftLon, bottomRightLat, bottomRightLon, minZoom, maxZoom, type, numTiles, defaultSet, date"
+                ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+            cQuery.addBindValue(name);
+            cQuery.addBindValue(record.value("typeStr"));
+            cQuery.addBindValue(record.value("topleftLat"));
+            cQuery.addBindValue(record.value("topleftLon"));
+            cQuery.addBindValue(record.value("bottomRightLat"));
+            cQuery.addBindValue(record.value("bottomRightLon"));
+            cQuery.addBindValue(record.value("minZoom"));
+            cQuery.addBindValue(record.value("maxZoom"));
+            cQuery.addBindValue(record.value("type"));
+            cQuery.addBindValue(record.value("numTiles"));
+            cQuery.addBindValue(defaultSet);
+            cQuery.addBindValue(QDateTime::currentSecsSinceEpoch());
+            if (!cQuery.exec()) {
+                task->setError("Error adding imported tile set to database");
+                ok = false;
+                break;
             }
-        } else {
-            task->setError("Error opening import database");
+            // Get just created (auto-incremented) setID
+            insertSetID = cQuery.lastInsertId().toULongLong();
+            setsCreated++;
         }
+
+        const qint64 saved = _copySetTiles(kImportSchema, record.value("setID").toULongLong(), QStringLiteral("main"), insertSetID, progress);
+        if (saved < 0) {
+            if (!task->canceled()) {
+                task->setError("Error importing tiles");
+            }
+            ok = false;
+            break;
+        }
+        tilesSaved += saved;
+
+        // Update tile count
+        const QString s = QStringLiteral("UPDATE TileSets SET numTiles = (SELECT COUNT(tileID) FROM SetTiles WHERE setID = %1) WHERE setID = %1").arg(insertSetID);
+        (void) query.exec(s);
+    }
+
+    if (ok) {
+        (void) _db->commit();
+    } else {
+        (void) _db->rollback();
+        qCDebug(QGCTileCacheWorkerLog) << "Import" << (task->canceled() ? "canceled" : "failed");
+    }
+    _detachDatabase(kImportSchema);
+
+    if (ok && (tilesSaved == 0) && (setsCreated == 0)) {
+        task->setError("No unique tiles in imported database");
     }
     task->setImportCompleted();
 }
@@ -835,109 +814,188 @@ void QGCCacheWorker::_exportSets(QGCMapTask *mtask)
     // Delete target if it exists
     (void) QFile::remove(task->path());
     // Create exported database
-    QScopedPointer<QSqlDatabase> dbExport(new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kExportSession)));
-    dbExport->setDatabaseName(task->path());
-    dbExport->setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-    if (dbExport->open()) {
-        if (_createDB(*dbExport, false)) {
-            // Prepare progress report
-            quint64 tileCount = 0;
-            quint64 currentCount = 0;
-            for (int i = 0; i < task->sets().count(); i++) {
-                const QGCCachedTileSet *set = task->sets().at(i);
-                // Default set has no unique tiles
-                if (set->defaultSet()) {
-                    tileCount += set->totalTileCount();
-                } else {
-                    tileCount += set->uniqueTileCount();
-                }
-            }
-
-            if (tileCount == 0) {
-                tileCount = 1;
+    bool created = false;
+    {
+        QScopedPointer<QSqlDatabase> dbExport(new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kExportSession)));
+        dbExport->setDatabaseName(task->path());
+        dbExport->setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
+        if (dbExport->open()) {
+            created = _createDB(*dbExport, false);
+            if (!created) {
+                task->setError("Error creating export database");
             }
+            dbExport->close();
+        } else {
+            qCCritical(QGCTileCacheWorkerLog) << "Map Cache SQL error (create export database):" << dbExport->lastError();
+            task->setError("Error opening export database");
+        }
+    }
+    QSqlDatabase::removeDatabase(kExportSession);
 
-            // Iterate sets to save
-            for (int i = 0; i < task->sets().count(); i++) {
-                const QGCCachedTileSet *set = task->sets().at(i);
-                // Create Tile Exported Set
-                QSqlQuery exportQuery(*dbExport);
-                (void) exportQuery.prepare("INSERT INTO TileSets("
-                    "name, typeStr, topleftLat, topleftLon, bottomRightLat, bottomRightLon, minZoom, maxZoom, type, numTiles, defaultSet, date"
-                    ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-                exportQuery.addBindValue(set->name());
-                exportQuery.addBindValue(set->mapTypeStr());
-                exportQuery.addBindValue(set->topleftLat());
-                exportQuery.addBindValue(set->topleftLon());
-                exportQuery.addBindValue(set->bottomRightLat());
-                exportQuery.addBindValue(set->bottomRightLon());
-                exportQuery.addBindValue(set->minZoom());
-                exportQuery.addBindValue(set->maxZoom());
-                exportQuery.addBindValue(UrlFactory::getQtMapIdFromProviderType(set->type()));
-                exportQuery.addBindValue(set->totalTileCount());
-                exportQuery.addBindValue(set->defaultSet());
-                exportQuery.addBindValue(QDateTime::currentSecsSinceEpoch());
-                if (!exportQuery.exec()) {
-                    task->setError("Error adding tile set to exported database");
-                    break;
-                }
-
-                // Get just created (auto-incremented) setID
-                const quint64 exportSetID = exportQuery.lastInsertId().toULongLong();
-                // Find set tiles
-                QString s = QStringLiteral("SELECT * FROM SetTiles WHERE setID = %1").arg(set->id());
-                QSqlQuery query(*_db);
-                if (!query.exec(s)) {
-                    continue;
-                }
+    if (!created || !_attachDatabase(task->path(), kExportSchema)) {
+        if (created) {
+            task->setError("Error opening export database");
+        }
+        task->setExportCompleted();
+        return;
+    }
 
-                (void) dbExport->transaction();
-                while (query.next()) {
-                    const quint64 tileID = query.value("tileID").toULongLong();
-                    // Get tile
-                    s = QStringLiteral("SELECT * FROM Tiles WHERE tileID = \"%1\"").arg(tileID);
-                    QSqlQuery subQuery(*_db);
-                    if (!subQuery.exec(s) || !subQuery.next()) {
-                        continue;
-                    }
+    // Prepare progress report
+    QSqlQuery query(*_db);
+    QStringList setIDs;
+    for (const QGCCachedTileSet *set : task->sets()) {
+        setIDs.append(QString::number(set->id()));
+    }
+    quint64 tileCount = 0;
+    if (query.exec(QStringLiteral("SELECT COUNT(tileID) FROM SetTiles WHERE setID IN (%1)").arg(setIDs.join(','))) && query.next()) {
+        tileCount = query.value(0).toULongLong();
+    }
+    if (tileCount == 0) {
+        tileCount = 1;
+    }
 
-                    const QString hash = subQuery.value("hash").toString();
-                    const QString format = subQuery.value("format").toString();
-                    const QByteArray img = subQuery.value("tile").toByteArray();
-                    const int type = subQuery.value("type").toInt();
-                    // Save tile
-                    (void) exportQuery.prepare("INSERT INTO Tiles(hash, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)");
-                    exportQuery.addBindValue(hash);
-                    exportQuery.addBindValue(format);
-                    exportQuery.addBindValue(img);
-                    exportQuery.addBindValue(img.size());
-                    exportQuery.addBindValue(type);
-                    exportQuery.addBindValue(QDateTime::currentSecsSinceEpoch());
-                    if (!exportQuery.exec()) {
-                        continue;
-                    }
+    quint64 currentCount = 0;
+    const auto progress = [task, tileCount, &currentCount](quint64 count) {
+        currentCount += count;
+        task->setProgress(static_cast<int>((static_cast<double>(currentCount) / static_cast<double>(tileCount)) * 100.0));
+        return !task->canceled();
+    };
+
+    // Iterate sets to save
+    bool ok = _db->transaction();
+    for (const QGCCachedTileSet *set : task->sets()) {
+        // Create Tile Exported Set
+        (void) query.prepare(QStringLiteral("INSERT INTO %1.TileSets("
+            "name, typeStr, topleftLat, topleftLon, bottomRightLat, bottomRightLon, minZoom, maxZoom, type, numTiles, defaultSet, date"
+            ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)").arg(kExportSchema));
+        query.addBindValue(set->name());
+        query.addBindValue(set->mapTypeStr());
+        query.addBindValue(set->topleftLat());
+        query.addBindValue(set->topleftLon());
+        query.addBindValue(set->bottomRightLat());
+        query.addBindValue(set->bottomRightLon());
+        query.addBindValue(set->minZoom());
+        query.addBindValue(set->maxZoom());
+        query.addBindValue(UrlFactory::getQtMapIdFromProviderType(set->type()));
+        query.addBindValue(set->totalTileCount());
+        query.addBindValue(set->defaultSet());
+        query.addBindValue(QDateTime::currentSecsSinceEpoch());
+        if (!query.exec()) {
+            task->setError("Error adding tile set to exported database");
+            ok = false;
+            break;
+        }
 
-                    const quint64 exportTileID = exportQuery.lastInsertId().toULongLong();
-                    s = QStringLiteral("INSERT INTO SetTiles(tileID, setID) VALUES(%1, %2)").arg(exportTileID).arg(exportSetID);
-                    (void) exportQuery.prepare(s);
-                    (void) exportQuery.exec();
-                    currentCount++;
-                    task->setProgress(static_cast<int>((static_cast<double>(currentCount) / static_cast<double>(tileCount)) * 100.0));
-                }
-                (void) dbExport->commit();
+        // Get just created (auto-incremented) setID
+        const quint64 exportSetID = query.lastInsertId().toULongLong();
+        if (_copySetTiles(QStringLiteral("main"), set->id(), kExportSchema, exportSetID, progress) < 0) {
+            if (!task->canceled()) {
+                task->setError("Error adding tiles to exported database");
             }
-        } else {
-            task->setError("Error creating export database");
+            ok = false;
+            break;
         }
+    }
+
+    if (ok) {
+        (void) _db->commit();
     } else {
-        qCCritical(QGCTileCacheWorkerLog) << "Map Cache SQL error (create export database):" << dbExport->lastError();
-        task->setError("Error opening export database");
+        (void) _db->rollback();
+    }
+    _detachDatabase(kExportSchema);
+
+    if (task->canceled()) {
+        qCDebug(QGCTileCacheWorkerLog) << "Export canceled";
+        (void) QFile::remove(task->path());
     }
-    dbExport.reset();
-    QSqlDatabase::removeDatabase(kExportSession);
     task->setExportCompleted();
 }
 
+bool QGCCacheWorker::_attachDatabase(const QString &path, const QString &schema)
+{
+    QSqlQuery query(*_db);
+    (void) query.prepare(QStringLiteral("ATTACH DATABASE ? AS %1").arg(schema));
+    query.addBindValue(path);
+    if (!query.exec()) {
+        qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (attach" << path << "):" << query.lastError().text();
+        return false;
+    }
+
+    return true;
+}
+
+void QGCCacheWorker::_detachDatabase(const QString &schema)
+{
+    QSqlQuery query(*_db);
+    (void) query.exec(QStringLiteral("DROP TABLE IF EXISTS temp.CopyTiles"));
+    if (!query.exec(QStringLiteral("DETACH DATABASE %1").arg(schema))) {
+        qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (detach" << schema << "):" << query.lastError().text();
+    }
+}
+
+qint64 QGCCacheWorker::_copySetTiles(const QString &sourceSchema, quint64 sourceSetID, const QString &targetSchema, quint64 targetSetID, const std::function<bool(quint64)> &progress)
+{
+    QSqlQuery query(*_db);
+    // The tile ids of the set are gathered once so batches are simple primary key ranges, whatever indexes the source has
+    if (!query.exec("CREATE TEMP TABLE IF NOT EXISTS CopyTiles (tileID INTEGER PRIMARY KEY NOT NULL)") ||
+        !query.exec("DELETE FROM temp.CopyTiles") ||
+        !query.exec(QStringLiteral("INSERT OR IGNORE INTO temp.CopyTiles(tileID) SELECT tileID FROM %1.SetTiles WHERE setID = %2").arg(sourceSchema).arg(sourceSetID))) {
+        qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (gather set tiles):" << query.lastError().text();
+        return -1;
+    }
+
+    // Tiles already in the target, by hash, are not copied again but still added to the set
+    QSqlQuery tilesQuery(*_db);
+    (void) tilesQuery.prepare(QStringLiteral(
+        "INSERT OR IGNORE INTO %1.Tiles(hash, format, tile, size, type, date) "
+        "SELECT T.hash, T.format, T.tile, T.size, T.type, %3 FROM temp.CopyTiles C JOIN %2.Tiles T ON T.tileID = C.tileID "
+        "WHERE C.tileID > ? AND C.tileID <= ?").arg(targetSchema, sourceSchema).arg(QDateTime::currentSecsSinceEpoch()));
+    QSqlQuery setTilesQuery(*_db);
+    (void) setTilesQuery.prepare(QStringLiteral(
+        "INSERT INTO %1.SetTiles(tileID, setID) "
+        "SELECT D.tileID, %3 FROM temp.CopyTiles C JOIN %2.Tiles T ON T.tileID = C.tileID JOIN %1.Tiles D ON D.hash = T.hash "
+        "WHERE C.tileID > ? AND C.tileID <= ? "
+        "AND NOT EXISTS (SELECT 1 FROM %1.SetTiles S WHERE S.tileID = D.tileID AND S.setID = %3)").arg(targetSchema, sourceSchema).arg(targetSetID));
+
+    qint64 tilesSaved = 0;
+    quint64 lastTileID = 0;
+    while (true) {
+        const QString s = QStringLiteral("SELECT MAX(tileID), COUNT(tileID) FROM (SELECT tileID FROM temp.CopyTiles WHERE tileID > %1 ORDER BY tileID LIMIT %2)").arg(lastTileID).arg(kCopyBatchSize);
+        if (!query.exec(s) || !query.next()) {
+            qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (next tile batch):" << query.lastError().text();
+            return -1;
+        }
+
+        const quint64 batchCount = query.value(1).toULongLong();
+        if (batchCount == 0) {
+            break;
+        }
+        const quint64 batchLastTileID = query.value(0).toULongLong();
+
+        tilesQuery.bindValue(0, lastTileID);
+        tilesQuery.bindValue(1, batchLastTileID);
+        if (!tilesQuery.exec()) {
+            qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (copy tiles):" << tilesQuery.lastError().text();
+            return -1;
+        }
+        tilesSaved += tilesQuery.numRowsAffected();
+
+        setTilesQuery.bindValue(0, lastTileID);
+        setTilesQuery.bindValue(1, batchLastTileID);
+        if (!setTilesQuery.exec()) {
+            qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (copy set tiles):" << setTilesQuery.lastError().text();
+            return -1;
+        }
+
+        lastTileID = batchLastTileID;
+        if (!progress(batchCount)) {
+            return -1;
+        }
+    }
+
+    return tilesSaved;
+}
+
 bool QGCCacheWorker::_testTask(QGCMapTask *mtask)
 {
     if (!_valid) {
@@ -1055,6 +1113,10 @@ bool QGCCacheWorker::_createDB(QSqlDatabase &db, bool createDefault)
         }
     }
 
+    if (res) {
+        res = _createCacheTotals(db);
+    }
+
     if (!res) {
         (void) QFile::remove(_databasePath);
     }
@@ -1062,8 +1124,120 @@ bool QGCCacheWorker::_createDB(QSqlDatabase &db, bool createDefault)
     return res;
 }
 
+bool QGCCacheWorker::_createCacheTotals(QSqlDatabase &db)
+{
+    // Databases created before CacheTotals existed get their totals computed once here
+    const bool rebuild = !db.tables().contains(QStringLiteral("CacheTotals"));
+
+    static const QStringList statements = {
+        // Single row of running totals for the whole cache and for the tiles only found in the default set
+        "CREATE TABLE IF NOT EXISTS CacheTotals ("
+        "id INTEGER PRIMARY KEY CHECK (id = 0), "
+        "totalCount INTEGER DEFAULT 0, "
+        "totalSize INTEGER DEFAULT 0, "
+        "defaultCount INTEGER DEFAULT 0, "
+        "defaultSize INTEGER DEFAULT 0)",
+        // Tiles only found in the default set, these are the ones which can be pruned
+        "CREATE TABLE IF NOT EXISTS DefaultTiles ("
+        "tileID INTEGER PRIMARY KEY NOT NULL, "
+        "size INTEGER DEFAULT 0, "
+        "accessed INTEGER DEFAULT 0)",
+        "CREATE INDEX IF NOT EXISTS DefaultTilesAccessed ON DefaultTiles ( accessed )",
+        "CREATE INDEX IF NOT EXISTS SetTilesTile ON SetTiles ( tileID )",
+        "CREATE INDEX IF NOT EXISTS SetTilesSet ON SetTiles ( setID, tileID )",
+        "CREATE TRIGGER IF NOT EXISTS TilesInsertTotals AFTER INSERT ON Tiles BEGIN "
+        "UPDATE CacheTotals SET totalCount = totalCount + 1, totalSize = totalSize + IFNULL(NEW.size, 0); "
+        "END",
+        // SetTiles rows of a deleted tile would otherwise be picked up by a new tile reusing its tileID
+        "CREATE TRIGGER IF NOT EXISTS TilesDeleteTotals AFTER DELETE ON Tiles BEGIN "
+        "UPDATE CacheTotals SET totalCount = totalCount - 1, totalSize = totalSize - IFNULL(OLD.size, 0); "
+        "DELETE FROM DefaultTiles WHERE tileID = OLD.tileID; "
+        "DELETE FROM SetTiles WHERE tileID = OLD.tileID; "
+        "END",
+        // A tile is only in DefaultTiles while the default set is the one set referencing it
+        "CREATE TRIGGER IF NOT EXISTS SetTilesInsertDefault AFTER INSERT ON SetTiles BEGIN "
+        "DELETE FROM DefaultTiles WHERE tileID = NEW.tileID; "
+        "INSERT INTO DefaultTiles(tileID, size, accessed) "
+        "SELECT tileID, IFNULL(size, 0), date FROM Tiles WHERE tileID = NEW.tileID "
+        "AND NEW.setID = (SELECT setID FROM TileSets WHERE defaultSet = 1) "
+        "AND (SELECT COUNT(*) FROM SetTiles WHERE tileID = NEW.tileID) = 1; "
+        "END",
+        "CREATE TRIGGER IF NOT EXISTS SetTilesDeleteDefault AFTER DELETE ON SetTiles BEGIN "
+        "DELETE FROM DefaultTiles WHERE tileID = OLD.tileID AND NOT EXISTS (SELECT 1 FROM SetTiles WHERE tileID = OLD.tileID); "
+        "INSERT OR IGNORE INTO DefaultTiles(tileID, size, accessed) "
+        "SELECT T.tileID, IFNULL(T.size, 0), T.date FROM Tiles T JOIN SetTiles S ON S.tileID = T.tileID "
+        "WHERE T.tileID = OLD.tileID AND S.setID = (SELECT setID FROM TileSets WHERE defaultSet = 1) "
+        "AND (SELECT COUNT(*) FROM SetTiles WHERE tileID = OLD.tileID) = 1; "
+        "END",
+        "CREATE TRIGGER IF NOT EXISTS DefaultTilesInsertTotals AFTER INSERT ON DefaultTiles BEGIN "
+        "UPDATE CacheTotals SET defaultCount = defaultCount + 1, defaultSize = defaultSize + NEW.size; "
+        "END",
+        "CREATE TRIGGER IF NOT EXISTS DefaultTilesDeleteTotals AFTER DELETE ON DefaultTiles BEGIN "
+        "UPDATE CacheTotals SET defaultCount = defaultCount - 1, defaultSize = defaultSize - OLD.size; "
+        "END",
+    };
+
+    static const QStringList rebuildStatements = {
+        "DELETE FROM SetTiles WHERE tileID NOT IN (SELECT tileID FROM Tiles)",
+        "DELETE FROM DefaultTiles",
+        "DELETE FROM CacheTotals",
+        "INSERT INTO CacheTotals(id, totalCount, totalSize) SELECT 0, COUNT(tileID), IFNULL(SUM(size), 0) FROM Tiles",
+        // The DefaultTiles triggers fill in the default totals
+        "INSERT INTO DefaultTiles(tileID, size, accessed) "
+        "SELECT T.tileID, IFNULL(T.size, 0), T.date FROM Tiles T JOIN SetTiles S ON S.tileID = T.tileID "
+        "GROUP BY T.tileID HAVING COUNT(S.setID) = 1 AND MAX(S.setID) = (SELECT setID FROM TileSets WHERE defaultSet = 1)",
+    };
+
+    QSqlQuery query(db);
+    (void) db.transaction();
+    for (const QString &statement : statements) {
+        if (!query.exec(statement)) {
+            qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (create CacheTotals):" << query.lastError().text();
+            (void) db.rollback();
+            return false;
+        }
+    }
+
+    if (rebuild) {
+        qCDebug(QGCTileCacheWorkerLog) << "Computing cache totals";
+        for (const QString &statement : rebuildStatements) {
+            if (!query.exec(statement)) {
+                qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (rebuild CacheTotals):" << query.lastError().text();
+                (void) db.rollback();
+                return false;
+            }
+        }
+    }
+
+    return db.commit();
+}
+
+void QGCCacheWorker::_updateTileAccess()
+{
+    if (_accessedTiles.isEmpty()) {
+        return;
+    }
+
+    // Access order is written in batches so a tile fetch doesn't cost a write
+    QSqlQuery query(*_db);
+    (void) query.prepare("UPDATE DefaultTiles SET accessed = ? WHERE tileID = ?");
+    const qint64 accessed = QDateTime::currentSecsSinceEpoch();
+    (void) _db->transaction();
+    for (const quint64 tileID : std::as_const(_accessedTiles)) {
+        query.addBindValue(accessed);
+        query.addBindValue(tileID);
+        if (!query.exec()) {
+            qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (update tile access):" << query.lastError().text();
+            break;
+        }
+    }
+    (void) _db->commit();
+    _accessedTiles.clear();
+}
+
 void QGCCacheWorker::_disconnectDB()
 {
+    _accessedTiles.clear();
     if (_db) {
         _db.reset();
         QSqlDatabase::removeDatabase(kSession);
@@ -13,21 +13,31 @@
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QMutex>
 #include <QtCore/QQueue>
+#include <QtCore/QSet>
 #include <QtCore/QString>
 #include <QtCore/QThread>
 #include <QtCore/QWaitCondition>
 #include <QtCore/QElapsedTimer>
 
+#include <functional>
+
 Q_DECLARE_LOGGING_CATEGORY(QGCTileCacheWorkerLog)
 
 class QGCMapTask;
 class QGCCachedTileSet;
 class QSqlDatabase;
+class QGCTileCacheBenchmark;
+class QGCTileCacheTestHelper;
+class QGCTileCacheWorkerTest;
 
 class QGCCacheWorker : public QThread
 {
     Q_OBJECT
 
+    friend class QGCTileCacheBenchmark;
+    friend class QGCTileCacheTestHelper;
+    friend class QGCTileCacheWorkerTest;
+
 public:
     explicit QGCCacheWorker(QObject *parent = nullptr);
     ~QGCCacheWorker();
@@ -64,6 +74,8 @@ public slots:
     bool _connectDB();
     void _disconnectDB();
     bool _createDB(QSqlDatabase &db, bool createDefault = true);
+    /// Creates the CacheTotals/DefaultTiles tables and the triggers keeping them current
+    bool _createCacheTotals(QSqlDatabase &db);
     bool _findTileSetID(const QString &name, quint64 &setID);
     bool _init();
     quint64 _findTile(const QString &hash);
@@ -72,6 +84,14 @@ public slots:
     void _deleteTileSet(quint64 id);
     void _updateSetTotals(QGCCachedTileSet *set);
     void _updateTotals();
+    /// Writes the access time of the tiles fetched since the last call
+    void _updateTileAccess();
+    bool _attachDatabase(const QString &path, const QString &schema);
+    void _detachDatabase(const QString &schema);
+    /// Copies the tiles of a set to a set in another attached database in batches, tiles are deduplicated by hash.
+    /// progress is called after each batch with the number of tiles in it and returns false to cancel.
+    /// @return Number of tiles added to the target database, -1 on error or cancel
+    qint64 _copySetTiles(const QString &sourceSchema, quint64 sourceSetID, const QString &targetSchema, quint64 targetSetID, const std::function<bool(quint64)> &progress);
 
     std::shared_ptr<QSqlDatabase> _db = nullptr;
     QMutex _taskQueueMutex;
@@ -83,6 +103,7 @@ public slots:
     quint64 _defaultSet = UINT64_MAX;
     quint64 _defaultSize = 0;
     quint64 _totalSize = 0;
+    QSet<quint64> _accessedTiles;
     QElapsedTimer _updateTimer;
     int _updateTimeout = kShortTimeout;
     std::atomic_bool _failed = false;
@@ -90,6 +111,9 @@ public slots:
 
     static constexpr const char *kSession = "QGeoTileWorkerSession";
     static constexpr const char *kExportSession = "QGeoTileExportSession";
+    static constexpr QLatin1StringView kImportSchema{"ImportDB"};
+    static constexpr QLatin1StringView kExportSchema{"ExportDB"};
+    static constexpr int kCopyBatchSize = 2000;
     static constexpr int kShortTimeout = 2;
     static constexpr int kLongTimeout = 5;
 };
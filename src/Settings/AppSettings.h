@@ -76,6 +76,7 @@ class AppSettings : public SettingsGroup
     Q_PROPERTY(QString waypointsFileExtension   MEMBER waypointsFileExtension   CONSTANT)
     Q_PROPERTY(QString parameterFileExtension   MEMBER parameterFileExtension   CONSTANT)
     Q_PROPERTY(QString telemetryFileExtension   MEMBER telemetryFileExtension   CONSTANT)
+    Q_PROPERTY(QString compressedTelemetryFileExtension MEMBER compressedTelemetryFileExtension CONSTANT)
     Q_PROPERTY(QString kmlFileExtension         MEMBER kmlFileExtension         CONSTANT)
     Q_PROPERTY(QString shpFileExtension         MEMBER shpFileExtension         CONSTANT)
     Q_PROPERTY(QString logFileExtension         MEMBER logFileExtension         CONSTANT)
@@ -106,6 +107,7 @@ class AppSettings : public SettingsGroup
     static constexpr const char* fenceFileExtension =       "fence";
     static constexpr const char* rallyPointFileExtension =  "rally";
     static constexpr const char* telemetryFileExtension =   "tlog";
+    static constexpr const char* compressedTelemetryFileExtension = "tlogz";
     static constexpr const char* kmlFileExtension =         "kml";
     static constexpr const char* shpFileExtension =         "shp";
     static constexpr const char* logFileExtension =         "ulg";
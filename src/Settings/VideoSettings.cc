@@ -85,6 +85,8 @@ DECLARE_SETTINGSFACT(VideoSettings, maxVideoSize)
 DECLARE_SETTINGSFACT(VideoSettings, enableStorageLimit)
 DECLARE_SETTINGSFACT(VideoSettings, streamEnabled)
 DECLARE_SETTINGSFACT(VideoSettings, disableWhenDisarmed)
+DECLARE_SETTINGSFACT(VideoSettings, logLatencyStats)
+DECLARE_SETTINGSFACT(VideoSettings, preRecordSeconds)
 
 DECLARE_SETTINGSFACT_NO_FUNC(VideoSettings, videoSource)
 {
@@ -38,10 +38,11 @@ RowLayout {
     QGCFileDialog {
         id: filePicker
         title: qsTr("Select Telemetery Log")
-        nameFilters: [ qsTr("Telemetry Logs (*.%1)").arg(_logFileExtension), qsTr("All Files (*)") ]
+        nameFilters: [ qsTr("Telemetry Logs (*.%1 *.%2)").arg(_logFileExtension).arg(_compressedLogFileExtension), qsTr("All Files (*)") ]
         folder: QGroundControl.settingsManager.appSettings.telemetrySavePath
 
         property string _logFileExtension: QGroundControl.settingsManager.appSettings.telemetryFileExtension
+        property string _compressedLogFileExtension: QGroundControl.settingsManager.appSettings.compressedTelemetryFileExtension
 
         onAcceptedForLoad: (file) => {
             logField.text = file
@@ -157,6 +157,10 @@ Item {
                     to:             100
                     value:          _mapEngineManager.actionProgress
                 }
+                QGCButton {
+                    text:       qsTr("Cancel")
+                    onClicked:  _mapEngineManager.cancelImportExport()
+                }
             }
         }
 
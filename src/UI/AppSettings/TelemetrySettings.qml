@@ -135,6 +135,15 @@ SettingsPage {
             property Fact _telemetrySaveNotArmed: _mavlinkSettings.telemetrySaveNotArmed
         }
 
+        FactCheckBoxSlider {
+            Layout.fillWidth:   true
+            text:               qsTr("Compress saved logs")
+            fact:               _telemetrySaveCompressed
+            visible:            fact.visible
+            enabled:            _mavlinkSettings.telemetrySave.rawValue
+            property Fact _telemetrySaveCompressed: _mavlinkSettings.telemetrySaveCompressed
+        }
+
         FactCheckBoxSlider {
             Layout.fillWidth:   true
             text:               qsTr("Save CSV log of telemetry data")
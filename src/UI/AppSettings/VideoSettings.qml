@@ -106,6 +106,13 @@ SettingsPage {
             visible:            !_videoAutoStreamConfig && _isStreamSource && fact.visible && _isGST
         }
 
+        FactCheckBoxSlider {
+            Layout.fillWidth:   true
+            text:               qsTr("Log Latency Statistics")
+            fact:               _videoSettings.logLatencyStats
+            visible:            _isStreamSource && fact.visible && _isGST
+        }
+
         LabelledFactComboBox {
             Layout.fillWidth:   true
             label:              fact.shortDescription
@@ -126,6 +133,13 @@ SettingsPage {
             visible:            _videoSettings.recordingFormat.visible
         }
 
+        LabelledFactTextField {
+            Layout.fillWidth:   true
+            label:              qsTr("Pre-Event Recording")
+            fact:               _videoSettings.preRecordSeconds
+            visible:            _isGST && fact.visible
+        }
+
         FactCheckBoxSlider {
             Layout.fillWidth:   true
             text:               qsTr("Auto-Delete Saved Recordings")
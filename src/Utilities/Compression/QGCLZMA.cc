@@ -10,6 +10,7 @@
 #include "QGCLZMA.h"
 #include "QGCLoggingCategory.h"
 
+#include <QtCore/QBuffer>
 #include <QtCore/QFile>
 
 #include <mutex>
@@ -20,6 +21,11 @@ QGC_LOGGING_CATEGORY(QGCLZMALog, "Utilities.Compression.QGCLZMA")
 
 namespace QGCLZMA {
 
+namespace {
+    constexpr qsizetype kInputChunkSize = 64 * 1024;
+    constexpr qsizetype kOutputChunkSize = 64 * 1024;
+}
+
 bool inflateLZMAFile(const QString &lzmaFilename, const QString &decompressedFilename)
 {
     QFile inputFile(lzmaFilename);
@@ -34,6 +40,22 @@ bool inflateLZMAFile(const QString &lzmaFilename, const QString &decompressedFil
         return false;
     }
 
+    return inflateLZMA(&inputFile, [&outputFile](const char *data, qsizetype size) {
+        if (outputFile.write(data, size) != size) {
+            qCWarning(QGCLZMALog) << "output file write failed:" << outputFile.fileName() << outputFile.errorString();
+            return false;
+        }
+        return true;
+    });
+}
+
+bool inflateLZMA(QIODevice *input, const DataSink &sink)
+{
+    if (!input || !input->isReadable()) {
+        qCWarning(QGCLZMALog) << "input device not readable";
+        return false;
+    }
+
     static std::once_flag crc_init_flag;
     std::call_once(crc_init_flag, []() {
         xz_crc32_init();
@@ -46,31 +68,35 @@ bool inflateLZMAFile(const QString &lzmaFilename, const QString &decompressedFil
         return false;
     }
 
-    constexpr int buf_size = 4 * 1024;
-    uint8_t in[buf_size];
-    uint8_t out[buf_size];
+    QByteArray in(kInputChunkSize, Qt::Uninitialized);
+    QByteArray out(kOutputChunkSize, Qt::Uninitialized);
 
     xz_buf b;
-    b.in = in;
+    b.in = reinterpret_cast<const uint8_t*>(in.constData());
     b.in_pos = 0;
     b.in_size = 0;
-    b.out = out;
+    b.out = reinterpret_cast<uint8_t*>(out.data());
     b.out_pos = 0;
-    b.out_size = buf_size;
+    b.out_size = static_cast<size_t>(out.size());
 
+    bool success = false;
     while (true) {
         if (b.in_pos == b.in_size) {
-            b.in_size = static_cast<size_t>(inputFile.read((char*)in, sizeof(in)));
+            const qint64 bytesRead = input->read(in.data(), in.size());
+            if (bytesRead < 0) {
+                qCWarning(QGCLZMALog) << "input read failed:" << input->errorString();
+                break;
+            }
+            b.in_size = static_cast<size_t>(bytesRead);
             b.in_pos = 0;
         }
 
-        xz_ret ret = xz_dec_run(s, &b);
+        const xz_ret ret = xz_dec_run(s, &b);
 
-        if (b.out_pos == sizeof(out)) {
-            const size_t cBytesWritten = static_cast<size_t>(outputFile.write((char*)out, static_cast<int>(b.out_pos)));
-            if (cBytesWritten != b.out_pos) {
-                qCWarning(QGCLZMALog) << "output file write failed:" << outputFile.fileName() << outputFile.errorString();
-                goto error;
+        if (b.out_pos == b.out_size) {
+            if (!sink(out.constData(), static_cast<qsizetype>(b.out_pos))) {
+                qCDebug(QGCLZMALog) << "inflate aborted by sink";
+                break;
             }
 
             b.out_pos = 0;
@@ -85,45 +111,62 @@ bool inflateLZMAFile(const QString &lzmaFilename, const QString &decompressedFil
             continue;
         }
 
-        const size_t cBytesWritten = static_cast<size_t>(outputFile.write((char*)out, static_cast<int>(b.out_pos)));
-        if (cBytesWritten != b.out_pos) {
-            qCWarning(QGCLZMALog) << "output file write failed:" << outputFile.fileName() << outputFile.errorString();
-            goto error;
+        if ((b.out_pos > 0) && !sink(out.constData(), static_cast<qsizetype>(b.out_pos))) {
+            qCDebug(QGCLZMALog) << "inflate aborted by sink";
+            break;
         }
 
         switch (ret) {
         case XZ_STREAM_END:
-            xz_dec_end(s);
-            return true;
+            success = true;
+            break;
         case XZ_MEM_ERROR:
             qCWarning(QGCLZMALog) << "Memory allocation failed";
-            goto error;
+            break;
         case XZ_MEMLIMIT_ERROR:
             qCWarning(QGCLZMALog) << "Memory usage limit reached";
-            goto error;
+            break;
         case XZ_FORMAT_ERROR:
             qCWarning(QGCLZMALog) << "Not a .xz file";
-            goto error;
+            break;
         case XZ_OPTIONS_ERROR:
             qCWarning(QGCLZMALog) << "Unsupported options in the .xz headers";
-            goto error;
+            break;
         case XZ_DATA_ERROR:
         case XZ_BUF_ERROR:
             qCWarning(QGCLZMALog) << "File is corrupt";
-            goto error;
+            break;
         default:
             qCWarning(QGCLZMALog) << "Bug!";
-            goto error;
+            break;
         }
+        break;
     }
 
     xz_dec_end(s);
-    return true;
+    return success;
+}
 
-error:
-    xz_dec_end(s);
-    return false;
+bool inflateLZMA(const QByteArray &lzmaData, QByteArray &decompressedData)
+{
+    decompressedData.clear();
+
+    QBuffer buffer;
+    buffer.setData(lzmaData);
+    if (!buffer.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const bool success = inflateLZMA(&buffer, [&decompressedData](const char *data, qsizetype size) {
+        (void) decompressedData.append(data, size);
+        return true;
+    });
+
+    if (!success) {
+        decompressedData.clear();
+    }
 
+    return success;
 }
 
 } // namespace QGCLZMA
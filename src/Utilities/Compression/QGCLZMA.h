@@ -9,14 +9,35 @@
 
 #pragma once
 
+#include <QtCore/QByteArray>
 #include <QtCore/QString>
 #include <QtCore/QLoggingCategory>
 
+#include <functional>
+
+class QIODevice;
+
 Q_DECLARE_LOGGING_CATEGORY(QGCLZMALog)
 
 namespace QGCLZMA {
+    /// Receives decompressed output one chunk at a time. Data is only valid for the duration of the call.
+    /// @return false to abort decompression
+    using DataSink = std::function<bool(const char *data, qsizetype size)>;
+
     /// Decompresses the specified file to the specified directory
     ///     @param lzmaFilename         Fully qualified path to lzma file
     ///     @param decompressedFilename Fully qualified path to for file to decompress to
     bool inflateLZMAFile(const QString &lzmaFilename, const QString &decompressedFilename);
+
+    /// Decompresses an xz stream read from an open device, passing the output to sink in chunks
+    ///     @param input    Device positioned at the start of the xz data
+    ///     @param sink     Receives decompressed chunks
+    /// @return bool Success
+    bool inflateLZMA(QIODevice *input, const DataSink &sink);
+
+    /// Decompresses xz data held in memory
+    ///     @param lzmaData             Compressed data
+    ///     @param decompressedData     Decompressed output, replaces any existing contents
+    /// @return bool Success
+    bool inflateLZMA(const QByteArray &lzmaData, QByteArray &decompressedData);
 } // namespace QGCLZMA
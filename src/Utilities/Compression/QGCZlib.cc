@@ -10,6 +10,7 @@
 #include "QGCZlib.h"
 #include "QGCLoggingCategory.h"
 
+#include <QtCore/QBuffer>
 #include <QtCore/QFile>
 
 #include <zlib.h>
@@ -19,6 +20,11 @@ QGC_LOGGING_CATEGORY(QGCZlibLog, "Utilities.Compression.QGCZlib")
 namespace QGCZlib
 {
 
+namespace {
+    constexpr qsizetype kInputChunkSize = 64 * 1024;
+    constexpr qsizetype kOutputChunkSize = 64 * 1024;
+}
+
 bool inflateGzipFile(const QString &gzippedFileName, const QString &decompressedFilename)
 {
     QFile inputFile(gzippedFileName);
@@ -30,63 +36,68 @@ bool inflateGzipFile(const QString &gzippedFileName, const QString &decompressed
     QFile outputFile(decompressedFilename);
     if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
         qCWarning(QGCZlibLog) << "open output file failed" << outputFile.fileName() << outputFile.errorString();
-        inputFile.close();
         return false;
     }
 
-    z_stream strm;
-    strm.zalloc = nullptr;
-    strm.zfree = nullptr;
-    strm.opaque = nullptr;
-    strm.avail_in = 0;
-    strm.next_in = nullptr;
+    return inflateGzip(&inputFile, [&outputFile](const char *data, qsizetype size) {
+        if (outputFile.write(data, size) != size) {
+            qCWarning(QGCZlibLog) << "output file write failed:" << outputFile.fileName() << outputFile.errorString();
+            return false;
+        }
+        return true;
+    });
+}
 
+bool inflateGzip(QIODevice *input, const DataSink &sink)
+{
+    if (!input || !input->isReadable()) {
+        qCWarning(QGCZlibLog) << "input device not readable";
+        return false;
+    }
+
+    z_stream strm{};
     int ret = inflateInit2(&strm, 16 + MAX_WBITS);
     if (ret != Z_OK) {
         qCWarning(QGCZlibLog) << "inflateInit2 failed:" << ret;
-        inputFile.close();
-        outputFile.close();
         return false;
     }
 
-    constexpr int cBuffer = 1024 * 5;
-    unsigned char inputBuffer[cBuffer];
-    unsigned char outputBuffer[cBuffer];
+    QByteArray inputBuffer(kInputChunkSize, Qt::Uninitialized);
+    QByteArray outputBuffer(kOutputChunkSize, Qt::Uninitialized);
+
     do {
-        strm.avail_in = static_cast<unsigned>(inputFile.read(reinterpret_cast<char*>(inputBuffer), cBuffer));
-        if (strm.avail_in == 0) {
+        const qint64 bytesRead = input->read(inputBuffer.data(), inputBuffer.size());
+        if (bytesRead < 0) {
+            qCWarning(QGCZlibLog) << "input read failed:" << input->errorString();
+            break;
+        }
+        if (bytesRead == 0) {
             break;
         }
-        strm.next_in = inputBuffer;
+        strm.avail_in = static_cast<uInt>(bytesRead);
+        strm.next_in = reinterpret_cast<Bytef*>(inputBuffer.data());
 
         do {
-            strm.avail_out = cBuffer;
-            strm.next_out = outputBuffer;
+            strm.avail_out = static_cast<uInt>(outputBuffer.size());
+            strm.next_out = reinterpret_cast<Bytef*>(outputBuffer.data());
 
             ret = inflate(&strm, Z_NO_FLUSH);
-            if (ret == Z_STREAM_ERROR || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) {
+            if (ret == Z_STREAM_ERROR || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_NEED_DICT) {
                 qCWarning(QGCZlibLog) << "inflate failed:" << ret;
-                inflateEnd(&strm);
-                inputFile.close();
-                outputFile.close();
+                (void) inflateEnd(&strm);
                 return false;
             }
 
-            const unsigned cBytesInflated = cBuffer - strm.avail_out;
-            if (outputFile.write(reinterpret_cast<char*>(outputBuffer), cBytesInflated) != cBytesInflated) {
-                qCWarning(QGCZlibLog) << "output file write failed:" << outputFile.fileName() << outputFile.errorString();
-                inflateEnd(&strm);
-                inputFile.close();
-                outputFile.close();
+            const qsizetype bytesInflated = outputBuffer.size() - strm.avail_out;
+            if ((bytesInflated > 0) && !sink(outputBuffer.constData(), bytesInflated)) {
+                qCDebug(QGCZlibLog) << "inflate aborted by sink";
+                (void) inflateEnd(&strm);
                 return false;
             }
-        } while (strm.avail_out == 0);
-
+        } while ((strm.avail_out == 0) && (ret != Z_STREAM_END));
     } while (ret != Z_STREAM_END);
 
-    inflateEnd(&strm);
-    inputFile.close();
-    outputFile.close();
+    (void) inflateEnd(&strm);
 
     if (ret != Z_STREAM_END) {
         qCWarning(QGCZlibLog) << "inflate did not reach stream end:" << ret;
@@ -96,4 +107,35 @@ bool inflateGzipFile(const QString &gzippedFileName, const QString &decompressed
     return true;
 }
 
+bool inflateGzip(const QByteArray &gzippedData, QByteArray &decompressedData)
+{
+    decompressedData.clear();
+
+    QBuffer buffer;
+    buffer.setData(gzippedData);
+    if (!buffer.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // gzip stores the uncompressed size modulo 2^32 in the last four bytes, use it as a reservation hint
+    if (gzippedData.size() >= 18) {
+        const uchar *const trailer = reinterpret_cast<const uchar*>(gzippedData.constData() + gzippedData.size() - 4);
+        const quint32 sizeHint = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (static_cast<quint32>(trailer[3]) << 24);
+        if (sizeHint <= (64 * gzippedData.size())) {
+            decompressedData.reserve(sizeHint);
+        }
+    }
+
+    const bool success = inflateGzip(&buffer, [&decompressedData](const char *data, qsizetype size) {
+        (void) decompressedData.append(data, size);
+        return true;
+    });
+
+    if (!success) {
+        decompressedData.clear();
+    }
+
+    return success;
+}
+
 } // namespace QGCZlib
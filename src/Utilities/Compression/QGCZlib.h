@@ -9,16 +9,37 @@
 
 #pragma once
 
+#include <QtCore/QByteArray>
 #include <QtCore/QString>
 #include <QtCore/QLoggingCategory>
 
+#include <functional>
+
+class QIODevice;
+
 Q_DECLARE_LOGGING_CATEGORY(QGCZlibLog)
 
 namespace QGCZlib
 {
+    /// Receives decompressed output one chunk at a time. Data is only valid for the duration of the call.
+    /// @return false to abort decompression
+    using DataSink = std::function<bool(const char *data, qsizetype size)>;
+
     /// Decompresses the specified file to the specified directory
     ///     @param gzippedFileName      Fully qualified path to gzip file
     ///     @param decompressedFilename Fully qualified path to for file to decompress to
     /// @return bool Success
     bool inflateGzipFile(const QString &gzippedFileName, const QString &decompressedFilename);
+
+    /// Decompresses a gzip stream read from an open device, passing the output to sink in chunks
+    ///     @param input    Device positioned at the start of the gzip data
+    ///     @param sink     Receives decompressed chunks
+    /// @return bool Success
+    bool inflateGzip(QIODevice *input, const DataSink &sink);
+
+    /// Decompresses gzip data held in memory
+    ///     @param gzippedData          Compressed data
+    ///     @param decompressedData     Decompressed output, replaces any existing contents
+    /// @return bool Success
+    bool inflateGzip(const QByteArray &gzippedData, QByteArray &decompressedData);
 }
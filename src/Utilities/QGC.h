@@ -19,5 +19,6 @@ namespace QGC
     /// Returns true if the two values are equal or close. Correctly handles 0 and NaN values.
     bool fuzzyCompare(double value1, double value2);
 
+    /// CRC-32 of @p len bytes continuing from @p state, see QGCCRC32
     quint32 crc32(const quint8 *src, unsigned len, unsigned state);
 }
@@ -0,0 +1,348 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCCRC32.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QtEndian>
+
+#include <array>
+
+#if defined(Q_PROCESSOR_X86_64)
+    #define QGC_CRC32_CLMUL
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+    #if (defined(_MSC_VER) && !defined(__clang__)) || (defined(__PCLMUL__) && defined(__SSE4_1__))
+        #define QGC_CRC32_CLMUL_TARGET
+    #else
+        #define QGC_CRC32_CLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+    #endif
+#elif defined(Q_PROCESSOR_ARM_64) && defined(__ARM_FEATURE_CRC32)
+    // Only when the toolchain targets armv8.1-a or +crc (always the case on Apple silicon)
+    #define QGC_CRC32_ARM
+    #include <arm_acle.h>
+#endif
+
+QGC_LOGGING_CATEGORY(QGCCRC32Log, "Utilities.QGCCRC32")
+
+namespace {
+
+using CRCTables = std::array<std::array<quint32, 256>, 16>;
+
+/// _tables[n][b] is the CRC of byte b followed by n zero bytes
+constexpr CRCTables _makeTables()
+{
+    CRCTables tables{};
+
+    for (quint32 i = 0; i < 256; i++) {
+        quint32 crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (0xEDB88320 ^ (crc >> 1)) : (crc >> 1);
+        }
+        tables[0][i] = crc;
+    }
+
+    for (size_t slice = 1; slice < tables.size(); slice++) {
+        for (size_t i = 0; i < 256; i++) {
+            const quint32 previous = tables[slice - 1][i];
+            tables[slice][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+        }
+    }
+
+    return tables;
+}
+
+constexpr CRCTables _tables = _makeTables();
+
+// Spot check against the classic crctab
+static_assert(_tables[0][0x01] == 0x77073096);
+static_assert(_tables[0][0x80] == 0xedb88320);
+static_assert(_tables[0][0xFF] == 0x2d02ef8d);
+
+quint32 _crcBytewise(const quint8 *src, size_t len, quint32 crc)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc = _tables[0][(crc ^ src[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+inline quint32 _sliceWord(quint32 word, size_t slice)
+{
+    return _tables[slice + 3][word & 0xFF] ^ _tables[slice + 2][(word >> 8) & 0xFF] ^ _tables[slice + 1][(word >> 16) & 0xFF] ^ _tables[slice][word >> 24];
+}
+
+quint32 _crcSlice8(const quint8 *src, size_t len, quint32 crc)
+{
+    while (len >= 8) {
+        const quint32 one = qFromLittleEndian<quint32>(src) ^ crc;
+        const quint32 two = qFromLittleEndian<quint32>(src + 4);
+        crc = _sliceWord(one, 4) ^ _sliceWord(two, 0);
+        src += 8;
+        len -= 8;
+    }
+
+    return _crcBytewise(src, len, crc);
+}
+
+quint32 _crcSlice16(const quint8 *src, size_t len, quint32 crc)
+{
+    while (len >= 16) {
+        const quint32 one = qFromLittleEndian<quint32>(src) ^ crc;
+        const quint32 two = qFromLittleEndian<quint32>(src + 4);
+        const quint32 three = qFromLittleEndian<quint32>(src + 8);
+        const quint32 four = qFromLittleEndian<quint32>(src + 12);
+        crc = _sliceWord(one, 12) ^ _sliceWord(two, 8) ^ _sliceWord(three, 4) ^ _sliceWord(four, 0);
+        src += 16;
+        len -= 16;
+    }
+
+    return _crcSlice8(src, len, crc);
+}
+
+#if defined(QGC_CRC32_CLMUL)
+
+bool _cpuHasClmul()
+{
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 1);
+    return ((info[2] & (1 << 1)) && (info[2] & (1 << 19)));
+#else
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    // PCLMULQDQ and SSE4.1
+    return ((ecx & (1 << 1)) && (ecx & (1 << 19)));
+#endif
+}
+
+/// Folds @p acc over 128 bits onto @p next
+QGC_CRC32_CLMUL_TARGET inline __m128i _foldClmul(__m128i acc, __m128i next, __m128i k)
+{
+    const __m128i low = _mm_clmulepi64_si128(acc, k, 0x00);
+    const __m128i high = _mm_clmulepi64_si128(acc, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(high, next), low);
+}
+
+/// Folds 64 byte blocks with carry-less multiplication and Barrett reduces the result to 32 bits.
+/// @param len At least 64 and a multiple of 16
+/// See "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction", Gopal et al., Intel 2009.
+/// The constants are the bit-reflected ones for polynomial 0x04C11DB7 given at the end of the paper.
+QGC_CRC32_CLMUL_TARGET quint32 _crcClmul(const quint8 *src, size_t len, quint32 crc)
+{
+    alignas(16) static constexpr quint64 k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+    alignas(16) static constexpr quint64 k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+    alignas(16) static constexpr quint64 k5k0[] = { 0x0163cd6124, 0x0000000000 };
+    alignas(16) static constexpr quint64 poly[] = { 0x01db710641, 0x01f7011641 };
+
+    __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x00));
+    __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x10));
+    __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x20));
+    __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+
+    __m128i x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+    src += 64;
+    len -= 64;
+
+    // Four independent folds of 64 bytes per iteration
+    while (len >= 64) {
+        const __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        const __m128i x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        const __m128i x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        const __m128i x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x30)));
+
+        src += 64;
+        len -= 64;
+    }
+
+    // Fold the four lanes into one
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+    x1 = _foldClmul(x1, x2, x0);
+    x1 = _foldClmul(x1, x3, x0);
+    x1 = _foldClmul(x1, x4, x0);
+
+    // Remaining blocks of 16
+    while (len >= 16) {
+        x1 = _foldClmul(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), x0);
+        src += 16;
+        len -= 16;
+    }
+
+    // Fold 128 to 64 bits
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+    x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), x0, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask32), x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return static_cast<quint32>(_mm_extract_epi32(x1, 1));
+}
+
+/// Bit-reflected folding needs at least 64 bytes
+constexpr size_t _kClmulMinimumLength = 64;
+
+quint32 _crcHardware(const quint8 *src, size_t len, quint32 crc)
+{
+    if (len >= _kClmulMinimumLength) {
+        const size_t blocks = len & ~static_cast<size_t>(15);
+        crc = _crcClmul(src, blocks, crc);
+        src += blocks;
+        len -= blocks;
+    }
+
+    return _crcSlice16(src, len, crc);
+}
+
+#elif defined(QGC_CRC32_ARM)
+
+quint32 _crcHardware(const quint8 *src, size_t len, quint32 crc)
+{
+    // The CRC32 instructions implement the same reflected polynomial and leave the register uninverted
+    while (len >= 32) {
+        crc = __crc32d(crc, qFromLittleEndian<quint64>(src));
+        crc = __crc32d(crc, qFromLittleEndian<quint64>(src + 8));
+        crc = __crc32d(crc, qFromLittleEndian<quint64>(src + 16));
+        crc = __crc32d(crc, qFromLittleEndian<quint64>(src + 24));
+        src += 32;
+        len -= 32;
+    }
+    while (len >= 8) {
+        crc = __crc32d(crc, qFromLittleEndian<quint64>(src));
+        src += 8;
+        len -= 8;
+    }
+    while (len > 0) {
+        crc = __crc32b(crc, *src++);
+        len--;
+    }
+
+    return crc;
+}
+
+#endif
+
+bool _hardwareSupported()
+{
+#if defined(QGC_CRC32_CLMUL)
+    static const bool supported = _cpuHasClmul();
+    return supported;
+#elif defined(QGC_CRC32_ARM)
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+namespace QGCCRC32
+{
+
+bool engineSupported(Engine engine)
+{
+    if (engine == Engine::Hardware) {
+        return _hardwareSupported();
+    }
+
+    return true;
+}
+
+Engine bestEngine()
+{
+    static const Engine engine = []() {
+        const Engine best = _hardwareSupported() ? Engine::Hardware : Engine::Slice16;
+        qCDebug(QGCCRC32Log) << "Using" << engineName(best) << "engine";
+        return best;
+    }();
+
+    return engine;
+}
+
+const char *engineName(Engine engine)
+{
+    switch (engine) {
+    case Engine::Bytewise:
+        return "bytewise";
+    case Engine::Slice8:
+        return "slicing-by-8";
+    case Engine::Slice16:
+        return "slicing-by-16";
+    case Engine::Hardware:
+#if defined(QGC_CRC32_CLMUL)
+        return "PCLMULQDQ";
+#elif defined(QGC_CRC32_ARM)
+        return "ARMv8 CRC32";
+#else
+        return "hardware (unavailable)";
+#endif
+    }
+
+    return "unknown";
+}
+
+quint32 compute(const quint8 *src, size_t len, quint32 state)
+{
+    return compute(src, len, state, bestEngine());
+}
+
+quint32 compute(const quint8 *src, size_t len, quint32 state, Engine engine)
+{
+    if (!src || (len == 0)) {
+        return state;
+    }
+
+    switch (engine) {
+    case Engine::Bytewise:
+        return _crcBytewise(src, len, state);
+    case Engine::Slice8:
+        return _crcSlice8(src, len, state);
+    case Engine::Hardware:
+#if defined(QGC_CRC32_CLMUL) || defined(QGC_CRC32_ARM)
+        if (_hardwareSupported()) {
+            return _crcHardware(src, len, state);
+        }
+#endif
+        break;
+    case Engine::Slice16:
+        break;
+    }
+
+    return _crcSlice16(src, len, state);
+}
+
+} // namespace QGCCRC32
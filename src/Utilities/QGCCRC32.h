@@ -0,0 +1,41 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QtTypes>
+
+Q_DECLARE_LOGGING_CATEGORY(QGCCRC32Log)
+
+/// CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320) without pre or post inversion of the register,
+/// as used by the PX4 bootloader and the parameter cache hash. All engines produce identical results.
+namespace QGCCRC32
+{
+    enum class Engine {
+        Bytewise,   ///< One table lookup per byte
+        Slice8,     ///< Slicing-by-8, 8 KB of tables
+        Slice16,    ///< Slicing-by-16, 16 KB of tables
+        Hardware,   ///< PCLMULQDQ folding on x86-64, CRC32 instructions on ARMv8
+    };
+
+    /// Updates @p state with @p len bytes using the fastest engine available on this CPU
+    quint32 compute(const quint8 *src, size_t len, quint32 state);
+
+    /// Updates @p state using a specific engine. Falls back to Slice16 if the engine is not supported.
+    quint32 compute(const quint8 *src, size_t len, quint32 state, Engine engine);
+
+    /// @return true if the engine can run on this CPU
+    bool engineSupported(Engine engine);
+
+    /// @return Engine used by compute() without an explicit engine
+    Engine bestEngine();
+
+    const char *engineName(Engine engine);
+}
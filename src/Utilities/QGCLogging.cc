@@ -15,8 +15,11 @@
 
 #include <QtConcurrent/QtConcurrentRun>
 #include <QtCore/QGlobalStatic>
-#include <QtCore/QStringListModel>
+#include <QtCore/QSaveFile>
 #include <QtCore/QTextStream>
+#include <QtCore/QThread>
+
+#include <bit>
 
 QGC_LOGGING_CATEGORY(QGCLoggingLog, "Utilities.QGCLogging")
 
@@ -40,33 +43,93 @@ static void msgHandler(QtMsgType type, const QMessageLogContext &context, const
     }
 }
 
+/*===========================================================================*/
+
+QGCLogRingBuffer::QGCLogRingBuffer(size_t capacity)
+    : _mask(std::bit_ceil(qMax<size_t>(capacity, 2)) - 1)
+    , _slots(std::make_unique<Slot[]>(_mask + 1))
+{
+    for (size_t i = 0; i <= _mask; i++) {
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool QGCLogRingBuffer::push(QString &&message)
+{
+    // Producers claim a slot by advancing _enqueuePos, the slot sequence tells whether it has been consumed
+    size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    for (;;) {
+        slot = &_slots[pos & _mask];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full
+            return false;
+        } else {
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->message = std::move(message);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    return true;
+}
+
+bool QGCLogRingBuffer::pop(QString &message)
+{
+    Slot &slot = _slots[_dequeuePos & _mask];
+    const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != (_dequeuePos + 1)) {
+        // Empty, or the producer which claimed this slot has not finished writing it
+        return false;
+    }
+
+    message = std::move(slot.message);
+    slot.message = QString();
+    slot.sequence.store(_dequeuePos + _mask + 1, std::memory_order_release);
+    _dequeuePos++;
+
+    return true;
+}
+
+/*===========================================================================*/
+
 QGCLogging *QGCLogging::instance()
 {
     return _qgcLogging();
 }
 
 QGCLogging::QGCLogging(QObject *parent)
-    : QStringListModel(parent)
+    : QAbstractListModel(parent)
+    , _ring(kRingCapacity)
 {
     qCDebug(QGCLoggingLog) << this;
 
-    _flushTimer.setInterval(kFlushIntervalMSecs);
-    _flushTimer.setSingleShot(false);
-    (void) connect(&_flushTimer, &QTimer::timeout, this, &QGCLogging::_flushToDisk);
-    _flushTimer.start();
-
-    // Connect the emitLog signal to threadsafeLog slot
-#if defined(Q_OS_ANDROID) || defined(Q_OS_IOS)
-    const Qt::ConnectionType conntype = Qt::QueuedConnection;
-#else
-    const Qt::ConnectionType conntype = Qt::AutoConnection;
-#endif
-    (void) connect(this, &QGCLogging::emitLog, this, &QGCLogging::_threadsafeLog, conntype);
+    _drainTimer.setSingleShot(true);
+    (void) connect(&_drainTimer, &QTimer::timeout, this, &QGCLogging::_drain);
 }
 
 QGCLogging::~QGCLogging()
 {
     qCDebug(QGCLoggingLog) << this;
+
+    // Whatever has not reached the console yet still goes to disk
+    QStringList remaining;
+    QString message;
+    while (_ring.pop(message)) {
+        remaining.append(message);
+    }
+    if (_diskThread && !remaining.isEmpty()) {
+        _queueDiskWrite(remaining);
+    }
+
+    _stopDiskWriter();
 }
 
 void QGCLogging::installHandler()
@@ -78,32 +141,222 @@ void QGCLogging::installHandler()
     defaultHandler = qInstallMessageHandler(msgHandler);
 }
 
+int QGCLogging::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return _rows.size();
+}
+
+QVariant QGCLogging::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (index.row() < 0) || (index.row() >= _rows.size())) {
+        return QVariant();
+    }
+
+    if ((role == Qt::DisplayRole) || (role == Qt::EditRole)) {
+        return _rows.at(index.row());
+    }
+
+    return QVariant();
+}
+
 void QGCLogging::log(const QString &message)
 {
-    // Emit the signal so threadsafeLog runs in the correct thread
-    if (!_ioError) {
-        emit emitLog(message);
+    QString copy(message);
+    if (!_ring.push(std::move(copy))) {
+        (void) _dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Only the first message after a drain posts an event to the GUI thread
+    if (!_drainScheduled.exchange(true)) {
+        (void) QMetaObject::invokeMethod(this, &QGCLogging::_scheduleDrain, Qt::QueuedConnection);
+    }
+}
+
+void QGCLogging::_scheduleDrain()
+{
+    if (_drainTimer.isActive()) {
+        return;
+    }
+
+    const qint64 elapsed = _sinceLastDrain.isValid() ? _sinceLastDrain.elapsed() : kMinDrainIntervalMSecs;
+    _drainTimer.start(static_cast<int>(qMax<qint64>(0, kMinDrainIntervalMSecs - elapsed)));
+}
+
+void QGCLogging::_drain()
+{
+    // Cleared before popping so a message pushed during the drain schedules the next one
+    _drainScheduled.store(false);
+    _sinceLastDrain.start();
+
+    QStringList messages;
+    QString message;
+    size_t count = 0;
+    while ((count < _ring.capacity()) && _ring.pop(message)) {
+        messages.append(std::move(message));
+        count++;
+    }
+
+    const quint32 dropped = _dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        messages.append(QStringLiteral("QGCLogging: %1 messages dropped, logging faster than the console can keep up").arg(dropped));
     }
+
+    if (count == _ring.capacity()) {
+        // Flooded, come back at the next frame for the rest
+        if (!_drainScheduled.exchange(true)) {
+            _scheduleDrain();
+        }
+    }
+
+    if (messages.isEmpty()) {
+        return;
+    }
+
+    _queueDiskWrite(messages);
+    _appendRows(messages);
 }
 
-void QGCLogging::_threadsafeLog(const QString &message)
+void QGCLogging::_appendRows(QStringList &messages)
 {
-    // Notify view of new row
-    const int line = rowCount();
-    (void) QStringListModel::insertRows(line, 1);
-    (void) setData(index(line, 0), message, Qt::DisplayRole);
+    if (messages.size() > kMaxLogRows) {
+        messages.remove(0, messages.size() - kMaxLogRows);
+    }
 
-    // Trim old entries to cap memory usage
-    static constexpr const int kMaxLogRows = kMaxLogFileSize / 100;
-    if (rowCount() > kMaxLogRows) {
-        const int removeCount = rowCount() - kMaxLogRows;
+    // Trim old entries to cap memory usage, in one range
+    const int removeCount = _rows.size() + messages.size() - kMaxLogRows;
+    if (removeCount > 0) {
         beginRemoveRows(QModelIndex(), 0, removeCount - 1);
-        (void) removeRows(0, removeCount);
+        _rows.remove(0, removeCount);
         endRemoveRows();
     }
 
-    // Queue for disk flush
-    _pendingDiskWrites.append(message);
+    const int first = _rows.size();
+    beginInsertRows(QModelIndex(), first, first + messages.size() - 1);
+    _rows.append(messages);
+    endInsertRows();
+}
+
+void QGCLogging::_queueDiskWrite(const QStringList &messages)
+{
+    if (_diskDisabled || _ioError) {
+        return;
+    }
+
+    // Messages logged before the application exists are held until we know whether log output is wanted
+    if (!_diskThread && qgcApp()) {
+        if (!qgcApp()->logOutput()) {
+            _diskDisabled = true;
+            QMutexLocker locker(&_diskMutex);
+            _diskBuffer.clear();
+            return;
+        }
+        _startDiskWriter();
+    }
+
+    QMutexLocker locker(&_diskMutex);
+
+    for (const QString &line : messages) {
+        _diskBuffer.append(line.toUtf8());
+        _diskBuffer.append('\n');
+    }
+
+    if (!_diskThread && (_diskBuffer.size() > kMaxLogFileSize)) {
+        _diskBuffer.remove(0, _diskBuffer.size() - kMaxLogFileSize);
+    }
+
+    if (_diskBuffer.size() >= kDiskWriteThreshold) {
+        _diskCondition.wakeOne();
+    }
+}
+
+void QGCLogging::_startDiskWriter()
+{
+    const QString saveDirPath = SettingsManager::instance()->appSettings()->crashSavePath();
+    const QDir saveDir(saveDirPath);
+    _logFilePath = saveDir.absoluteFilePath("QGCConsole.log");
+
+    _diskThread = QThread::create([this]() { _diskWriterLoop(); });
+    _diskThread->setObjectName(QStringLiteral("QGCLogging"));
+    _diskThread->start(QThread::LowPriority);
+}
+
+void QGCLogging::_stopDiskWriter()
+{
+    if (!_diskThread) {
+        return;
+    }
+
+    _diskMutex.lock();
+    _diskStop = true;
+    _diskCondition.wakeOne();
+    _diskMutex.unlock();
+
+    (void) _diskThread->wait();
+    delete _diskThread;
+    _diskThread = nullptr;
+}
+
+void QGCLogging::_diskWriterLoop()
+{
+    QMutexLocker locker(&_diskMutex);
+
+    while (true) {
+        // Batch up to kFlushIntervalMSecs worth of lines, or until enough is buffered for a large write
+        if (!_diskStop && (_diskBuffer.size() < kDiskWriteThreshold)) {
+            (void) _diskCondition.wait(&_diskMutex, kFlushIntervalMSecs);
+        }
+
+        const QByteArray pending = std::exchange(_diskBuffer, QByteArray());
+        const bool stop = _diskStop;
+        locker.unlock();
+
+        if (!pending.isEmpty() && !_ioError && (_logFile.isOpen() || _openLogFile())) {
+            // Check size before writing
+            if (_logFile.size() >= kMaxLogFileSize) {
+                _rotateLogs();
+            }
+
+            if (_logFile.isOpen() && ((_logFile.write(pending) != pending.size()) || !_logFile.flush())) {
+                _ioError = true;
+                qCWarning(QGCLoggingLog) << "Error writing to log file:" << _logFile.errorString();
+            }
+        }
+
+        if (stop) {
+            break;
+        }
+
+        locker.relock();
+    }
+
+    _logFile.close();
+}
+
+bool QGCLogging::_openLogFile()
+{
+    _logFile.setFileName(_logFilePath);
+    if (!_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        _reportDiskError(tr("Open console log output file failed %1 : %2").arg(_logFile.fileName(), _logFile.errorString()));
+        return false;
+    }
+
+    return true;
+}
+
+void QGCLogging::_reportDiskError(const QString &message)
+{
+    _ioError = true;
+
+    // showAppMessage talks to QML, so it has to run on the GUI thread
+    (void) QMetaObject::invokeMethod(this, [message]() {
+        if (qgcApp()) {
+            qgcApp()->showAppMessage(message);
+        }
+    }, Qt::QueuedConnection);
 }
 
 void QGCLogging::_rotateLogs()
@@ -140,59 +393,14 @@ void QGCLogging::_rotateLogs()
     // Re‑open a fresh log file
     _logFile.setFileName(basePath);
     if (!_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-        _ioError = true;
-        qgcApp()->showAppMessage(tr("Unable to reopen log file %1: %2").arg(_logFile.fileName(), _logFile.errorString()));
-    }
-}
-
-void QGCLogging::_flushToDisk()
-{
-    if (_pendingDiskWrites.isEmpty() || _ioError) {
-        return;
-    }
-
-    // Ensure log output enabled and file open
-    if (!_logFile.isOpen()) {
-        if (!qgcApp()->logOutput()) {
-            _pendingDiskWrites.clear();
-            return;
-        }
-
-        const QString saveDirPath = SettingsManager::instance()->appSettings()->crashSavePath();
-        const QDir saveDir(saveDirPath);
-        const QString saveFilePath = saveDir.absoluteFilePath("QGCConsole.log");
-
-        _logFile.setFileName(saveFilePath);
-        if (!_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-            _ioError = true;
-            qgcApp()->showAppMessage(tr("Open console log output file failed %1 : %2").arg(_logFile.fileName(), _logFile.errorString()));
-            return;
-        }
-    }
-
-    // Check size before writing
-    if (_logFile.size() >= kMaxLogFileSize) {
-        _rotateLogs();
-    }
-
-    // Write all pending lines
-    QTextStream out(&_logFile);
-    for (const QString &line : std::as_const(_pendingDiskWrites)) {
-        out << line << '\n';
-        if (out.status() != QTextStream::Ok) {
-            _ioError = true;
-            qCWarning(QGCLoggingLog) << "Error writing to log file:" << _logFile.errorString();
-            break;
-        }
+        _reportDiskError(tr("Unable to reopen log file %1: %2").arg(_logFile.fileName(), _logFile.errorString()));
     }
-    (void) _logFile.flush();
-    _pendingDiskWrites.clear();
 }
 
 void QGCLogging::writeMessages(const QString &destFile)
 {
     // Snapshot current logs on GUI thread
-    const QStringList logs = stringList();
+    const QStringList logs = _rows;
 
     // Run the file write in a separate thread
     (void) QtConcurrent::run([this, destFile, logs]() {
@@ -9,14 +9,49 @@
 
 #pragma once
 
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QFile>
 #include <QtCore/QLoggingCategory>
-#include <QtCore/QStringListModel>
+#include <QtCore/QMutex>
 #include <QtCore/QTimer>
+#include <QtCore/QWaitCondition>
+
+#include <atomic>
+#include <memory>
 
 Q_DECLARE_LOGGING_CATEGORY(QGCLoggingLog)
 
-class QGCLogging : public QStringListModel
+class QThread;
+
+/// Bounded multi producer, single consumer queue of log lines. Producers never block: when the
+/// queue is full the message is dropped and counted.
+class QGCLogRingBuffer
+{
+public:
+    explicit QGCLogRingBuffer(size_t capacity);
+
+    /// Thread-safe, lock-free
+    bool push(QString &&message);
+
+    /// Single consumer only
+    bool pop(QString &message);
+
+    size_t capacity() const { return _mask + 1; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        QString message;
+    };
+
+    const size_t _mask;
+    std::unique_ptr<Slot[]> _slots;
+    alignas(64) std::atomic<size_t> _enqueuePos{0};
+    alignas(64) size_t _dequeuePos = 0;
+};
+
+class QGCLogging : public QAbstractListModel
 {
     Q_OBJECT
 
@@ -33,13 +68,16 @@ class QGCLogging : public QStringListModel
     /// Write current log messages to a file asynchronously
     Q_INVOKABLE void writeMessages(const QString &destFile);
 
-    /// Enqueue a log message (thread-safe)
+    /// Enqueue a log message (thread-safe, never blocks)
     void log(const QString &message);
 
-signals:
-    /// Emitted when a log message is enqueued
-    void emitLog(const QString &message);
+    /// Snapshot of the messages shown in the console
+    QStringList stringList() const { return _rows; }
 
+    int rowCount(const QModelIndex &parent = QModelIndex()) const final;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const final;
+
+signals:
     /// Emitted when file write starts
     void writeStarted();
 
@@ -47,21 +85,46 @@ class QGCLogging : public QStringListModel
     void writeFinished(bool success);
 
 private slots:
-    /// Internal slot to append message on the GUI/main thread
-    void _threadsafeLog(const QString &message);
+    /// Starts the drain timer, honouring the maximum model update rate
+    void _scheduleDrain();
 
-    /// Periodic flush of pending log lines to disk
-    void _flushToDisk();
+    /// Moves everything queued by the producers into the model and the disk buffer, on the GUI thread
+    void _drain();
 
 private:
+    void _appendRows(QStringList &messages);
+    void _queueDiskWrite(const QStringList &messages);
+    void _startDiskWriter();
+    void _stopDiskWriter();
+
+    /// Disk thread
+    void _diskWriterLoop();
+    bool _openLogFile();
     void _rotateLogs();
-
+    void _reportDiskError(const QString &message);
+
+    QStringList _rows;
+    QGCLogRingBuffer _ring;
+    std::atomic<bool> _drainScheduled = false;
+    std::atomic<quint32> _dropped = 0;
+    QTimer _drainTimer;
+    QElapsedTimer _sinceLastDrain;
+
+    QThread *_diskThread = nullptr;
+    QMutex _diskMutex;
+    QWaitCondition _diskCondition;
+    QByteArray _diskBuffer;
+    QString _logFilePath;
+    bool _diskStop = false;
+    bool _diskDisabled = false;
     QFile _logFile;
-    QTimer _flushTimer;
-    QStringList _pendingDiskWrites;
-    bool _ioError = false;
+    std::atomic<bool> _ioError = false;
 
     static constexpr int kMaxLogFileSize = 10LL * 1024 * 1024;
+    static constexpr int kMaxLogRows = kMaxLogFileSize / 100;
     static constexpr int kMaxBackupFiles = 5;
     static constexpr int kFlushIntervalMSecs = 1000;
+    static constexpr int kDiskWriteThreshold = 256 * 1024;  ///< Wake the disk thread early once this much is buffered
+    static constexpr size_t kRingCapacity = 16384;
+    static constexpr int kMinDrainIntervalMSecs = 1000 / 30; ///< Caps console model updates at 30 Hz
 };
@@ -10,11 +10,13 @@
 #include "FTPManager.h"
 #include "MAVLinkProtocol.h"
 #include "Vehicle.h"
+#include "QGC.h"
 #include "QGCApplication.h"
 #include "QGCLoggingCategory.h"
 
 #include <QtCore/QFile>
 #include <QtCore/QDir>
+#include <QtCore/QtEndian>
 
 QGC_LOGGING_CATEGORY(FTPManagerLog, "Vehicle.FTPManager")
 
@@ -23,10 +25,18 @@ FTPManager::FTPManager(Vehicle* vehicle)
     , _vehicle  (vehicle)
 {
     _ackOrNakTimeoutTimer.setSingleShot(true);
-    // Mock link responds immediately if at all, speed up unit tests with faster timoue
-    _ackOrNakTimeoutTimer.setInterval(qgcApp()->runningUnitTests() ? 10 : _ackOrNakTimeoutMsecs);
+    if (qgcApp()->runningUnitTests()) {
+        // Mock link responds immediately if at all, speed up unit tests with faster timeouts
+        _defaultTimeoutMSecs    = 10;
+        _minTimeoutMSecs        = 10;
+        _maxTimeoutMSecs        = 100;
+    } else {
+        _defaultTimeoutMSecs    = _ackOrNakTimeoutMsecs;
+        _minTimeoutMSecs        = 100;
+        _maxTimeoutMSecs        = 5 * _ackOrNakTimeoutMsecs;
+    }
     connect(&_ackOrNakTimeoutTimer, &QTimer::timeout, this, &FTPManager::_ackOrNakTimeout);
-    
+
     // Make sure we don't have bad structure packing
     Q_ASSERT(sizeof(MavlinkFTP::RequestHeader) == 12);
 }
@@ -35,30 +45,20 @@ bool FTPManager::download(uint8_t fromCompId, const QString& fromURI, const QStr
 {
     qCDebug(FTPManagerLog) << "download fromURI:" << fromURI << "to:" << toDir << "fromCompId:" << fromCompId;
 
-    if (!_rgStateMachine.isEmpty()) {
-        qCDebug(FTPManagerLog) << "Cannot download. Already in another operation";
+    if (_downloadState.active()) {
+        qCDebug(FTPManagerLog) << "Cannot download. Already in another download";
         return false;
     }
 
-    static const StateFunctions_t rgDownloadStateMachine[] = {
-        { &FTPManager::_openFileROBegin,            &FTPManager::_openFileROAckOrNak,           &FTPManager::_openFileROTimeout },
-        { &FTPManager::_burstReadFileBegin,         &FTPManager::_burstReadFileAckOrNak,        &FTPManager::_burstReadFileTimeout },
-        { &FTPManager::_fillMissingBlocksBegin,     &FTPManager::_fillMissingBlocksAckOrNak,    &FTPManager::_fillMissingBlocksTimeout },
-        { &FTPManager::_resetSessionsBegin,         &FTPManager::_resetSessionsAckOrNak,        &FTPManager::_resetSessionsTimeout },
-        { &FTPManager::_downloadCompleteNoError,    nullptr,                                    nullptr },
-    };
-    for (size_t i=0; i<sizeof(rgDownloadStateMachine)/sizeof(rgDownloadStateMachine[0]); i++) {
-        _rgStateMachine.append(rgDownloadStateMachine[i]);
-    }
-
     _downloadState.reset();
     _downloadState.toDir.setPath(toDir);
     _downloadState.checksize = checksize;
 
-    if (!_parseURI(fromCompId, fromURI, _downloadState.fullPathOnVehicle, _ftpCompId)) {
+    if (!_parseURI(fromCompId, fromURI, _downloadState.fullPathOnVehicle, _downloadState.compId)) {
         qCWarning(FTPManagerLog) << "_parseURI failed";
         return false;
     }
+    _downloadState.uri = fromURI;
 
     // We need to strip off the file name from the fully qualified path. We can't use the usual QDir
     // routines because this path does not exist locally.
@@ -78,17 +78,94 @@ bool FTPManager::download(uint8_t fromCompId, const QString& fromURI, const QStr
 
     qCDebug(FTPManagerLog) << "_downloadState.fullPathOnVehicle:_downloadState.fileName" << _downloadState.fullPathOnVehicle << _downloadState.fileName;
 
-    _startStateMachine();
+    static const StateFunctions_t rgDownloadStateMachine[] = {
+        { &FTPManager::_openFileROBegin,            &FTPManager::_openFileROAckOrNak,           &FTPManager::_openFileROTimeout },
+        { &FTPManager::_burstReadFileBegin,         &FTPManager::_burstReadFileAckOrNak,        &FTPManager::_burstReadFileTimeout },
+        { &FTPManager::_fillMissingBlocksBegin,     &FTPManager::_fillMissingBlocksAckOrNak,    &FTPManager::_fillMissingBlocksTimeout },
+        { &FTPManager::_terminateSessionBegin,      &FTPManager::_terminateSessionAckOrNak,     &FTPManager::_terminateSessionTimeout },
+        { &FTPManager::_downloadCompleteNoError,    nullptr,                                    nullptr },
+    };
+    for (size_t i=0; i<sizeof(rgDownloadStateMachine)/sizeof(rgDownloadStateMachine[0]); i++) {
+        _downloadState.rgStateMachine.append(rgDownloadStateMachine[i]);
+    }
+
+    _startStateMachine(_downloadState);
 
     return true;
 }
 
+bool FTPManager::upload(uint8_t toCompId, const QString& localFile, const QString& toURI, bool verifyCrc)
+{
+    qCDebug(FTPManagerLog) << "upload localFile:" << localFile << "toURI:" << toURI << "toCompId:" << toCompId;
+
+    if (_uploadState.active()) {
+        qCDebug(FTPManagerLog) << "Cannot upload. Already in another upload";
+        return false;
+    }
+
+    _uploadState.reset();
+
+    _uploadState.file.setFileName(localFile);
+    if (!_uploadState.file.open(QFile::ReadOnly)) {
+        qCWarning(FTPManagerLog) << "Cannot upload. Open failed" << localFile << _uploadState.file.errorString();
+        return false;
+    }
+    if (_uploadState.file.size() > std::numeric_limits<uint32_t>::max()) {
+        qCWarning(FTPManagerLog) << "Cannot upload. File too large" << localFile;
+        _uploadState.file.close();
+        return false;
+    }
+
+    _uploadState.fileSize   = static_cast<uint32_t>(_uploadState.file.size());
+    _uploadState.verifyCrc  = verifyCrc;
+    if (_uploadState.fileSize > 0) {
+        _uploadState.rgMissingData.append({ 0, _uploadState.fileSize });
+    }
+
+    if (verifyCrc) {
+        // Calculated up front since the data is read out of order while uploading
+        while (!_uploadState.file.atEnd()) {
+            const QByteArray bytes = _uploadState.file.read(64 * 1024);
+            if (bytes.isEmpty()) {
+                break;
+            }
+            _uploadState.fileCrc32 = QGC::crc32(reinterpret_cast<const quint8*>(bytes.constData()), static_cast<unsigned>(bytes.size()), _uploadState.fileCrc32);
+        }
+    }
+
+    static const StateFunctions_t rgUploadStateMachine[] = {
+        { &FTPManager::_createFileBegin,            &FTPManager::_createFileAckOrNak,           &FTPManager::_createFileTimeout },
+        { &FTPManager::_writeFileBegin,             &FTPManager::_writeFileAckOrNak,            &FTPManager::_writeFileTimeout },
+        { &FTPManager::_terminateUploadBegin,       &FTPManager::_terminateUploadAckOrNak,      &FTPManager::_terminateUploadTimeout },
+        { &FTPManager::_verifyUploadBegin,          &FTPManager::_verifyUploadAckOrNak,         &FTPManager::_verifyUploadTimeout },
+        { &FTPManager::_uploadCompleteNoError,      nullptr,                                    nullptr },
+    };
+    static const StateFunctions_t rgUploadNoVerifyStateMachine[] = {
+        { &FTPManager::_createFileBegin,            &FTPManager::_createFileAckOrNak,           &FTPManager::_createFileTimeout },
+        { &FTPManager::_writeFileBegin,             &FTPManager::_writeFileAckOrNak,            &FTPManager::_writeFileTimeout },
+        { &FTPManager::_terminateUploadBegin,       &FTPManager::_terminateUploadAckOrNak,      &FTPManager::_terminateUploadTimeout },
+        { &FTPManager::_uploadCompleteNoError,      nullptr,                                    nullptr },
+    };
+
+    bool started;
+    if (verifyCrc) {
+        started = _startOperation(_uploadState, toCompId, toURI, rgUploadStateMachine, sizeof(rgUploadStateMachine)/sizeof(rgUploadStateMachine[0]));
+    } else {
+        started = _startOperation(_uploadState, toCompId, toURI, rgUploadNoVerifyStateMachine, sizeof(rgUploadNoVerifyStateMachine)/sizeof(rgUploadNoVerifyStateMachine[0]));
+    }
+    if (!started) {
+        _uploadState.file.close();
+    }
+
+    return started;
+}
+
 bool FTPManager::listDirectory(uint8_t fromCompId, const QString& fromURI)
 {
     qCDebug(FTPManagerLog) << "list directory fromURI:" << fromURI << "fromCompId:" << fromCompId;
 
-    if (!_rgStateMachine.isEmpty()) {
-        qCDebug(FTPManagerLog) << "Cannot list directory. Already in another operation";
+    if (_listDirectoryState.active()) {
+        qCDebug(FTPManagerLog) << "Cannot list directory. Already listing another directory";
         return false;
     }
 
@@ -96,41 +173,144 @@ bool FTPManager::listDirectory(uint8_t fromCompId, const QString& fromURI)
         { &FTPManager::_listDirectoryBegin,             &FTPManager::_listDirectoryAckOrNak,        &FTPManager::_listDirectoryTimeout },
         { &FTPManager::_listDirectoryCompleteNoError,   nullptr,                                    nullptr },
     };
-    for (size_t i=0; i<sizeof(rgStateMachine)/sizeof(rgStateMachine[0]); i++) {
-        _rgStateMachine.append(rgStateMachine[i]);
-    }
 
     _listDirectoryState.reset();
 
-    if (!_parseURI(fromCompId, fromURI, _listDirectoryState.fullPathOnVehicle, _ftpCompId)) {
+    return _startOperation(_listDirectoryState, fromCompId, fromURI, rgStateMachine, sizeof(rgStateMachine)/sizeof(rgStateMachine[0]));
+}
+
+bool FTPManager::removeFile(uint8_t compId, const QString& uri)
+{
+    qCDebug(FTPManagerLog) << "remove file uri:" << uri << "compId:" << compId;
+
+    if (_removeFileState.active()) {
+        qCDebug(FTPManagerLog) << "Cannot remove file. Already removing another file";
+        return false;
+    }
+
+    static const StateFunctions_t rgStateMachine[] = {
+        { &FTPManager::_removeFileBegin,            &FTPManager::_removeFileAckOrNak,   &FTPManager::_removeFileTimeout },
+        { &FTPManager::_removeFileCompleteNoError,  nullptr,                            nullptr },
+    };
+
+    _removeFileState.reset();
+
+    return _startOperation(_removeFileState, compId, uri, rgStateMachine, sizeof(rgStateMachine)/sizeof(rgStateMachine[0]));
+}
+
+bool FTPManager::createDirectory(uint8_t compId, const QString& uri)
+{
+    qCDebug(FTPManagerLog) << "create directory uri:" << uri << "compId:" << compId;
+
+    if (_createDirectoryState.active()) {
+        qCDebug(FTPManagerLog) << "Cannot create directory. Already creating another directory";
+        return false;
+    }
+
+    static const StateFunctions_t rgStateMachine[] = {
+        { &FTPManager::_createDirectoryBegin,           &FTPManager::_createDirectoryAckOrNak,  &FTPManager::_createDirectoryTimeout },
+        { &FTPManager::_createDirectoryCompleteNoError, nullptr,                                nullptr },
+    };
+
+    _createDirectoryState.reset();
+
+    return _startOperation(_createDirectoryState, compId, uri, rgStateMachine, sizeof(rgStateMachine)/sizeof(rgStateMachine[0]));
+}
+
+bool FTPManager::calcFileCrc32(uint8_t compId, const QString& uri)
+{
+    qCDebug(FTPManagerLog) << "calc file crc32 uri:" << uri << "compId:" << compId;
+
+    if (_calcFileCrc32State.active()) {
+        qCDebug(FTPManagerLog) << "Cannot calc file crc32. Already calculating for another file";
+        return false;
+    }
+
+    static const StateFunctions_t rgStateMachine[] = {
+        { &FTPManager::_calcFileCrc32Begin,             &FTPManager::_calcFileCrc32AckOrNak,    &FTPManager::_calcFileCrc32Timeout },
+        { &FTPManager::_calcFileCrc32CompleteNoError,   nullptr,                                nullptr },
+    };
+
+    _calcFileCrc32State.reset();
+
+    return _startOperation(_calcFileCrc32State, compId, uri, rgStateMachine, sizeof(rgStateMachine)/sizeof(rgStateMachine[0]));
+}
+
+/// Parses the uri into the operation and starts its state machine
+bool FTPManager::_startOperation(OperationState_t& operation, uint8_t compId, const QString& uri, const StateFunctions_t* rgStateMachine, size_t cStates)
+{
+    if (!_parseURI(compId, uri, operation.fullPathOnVehicle, operation.compId)) {
         qCWarning(FTPManagerLog) << "_parseURI failed";
         return false;
     }
+    operation.uri = uri;
+
+    qCDebug(FTPManagerLog) << "fullPathOnVehicle" << operation.fullPathOnVehicle;
 
-    qCDebug(FTPManagerLog) << "_listDirectoryState.fullPathOnVehicle" << _listDirectoryState.fullPathOnVehicle;
+    for (size_t i=0; i<cStates; i++) {
+        operation.rgStateMachine.append(rgStateMachine[i]);
+    }
 
-    _startStateMachine();
+    _startStateMachine(operation);
 
     return true;
 }
 
 void FTPManager::cancelDownload()
 {
+    if (!_downloadState.active()) {
+        return;
+    }
+
+    if (_downloadState.waitingForSession) {
+        _downloadComplete("Aborted");
+        return;
+    }
+
     if (!_downloadState.inProgress()) {
         return;
     }
 
-    _ackOrNakTimeoutTimer.stop();
-    _rgStateMachine.clear();
+    _cancelPendingRequests(_downloadState);
+    _downloadState.rgStateMachine.clear();
     static const StateFunctions_t rgTerminateStateMachine[] = {
         { &FTPManager::_terminateSessionBegin,  &FTPManager::_terminateSessionAckOrNak,     &FTPManager::_terminateSessionTimeout },
         { &FTPManager::_terminateComplete,      nullptr,                                    nullptr },
     };
     for (size_t i=0; i<sizeof(rgTerminateStateMachine)/sizeof(rgTerminateStateMachine[0]); i++) {
-        _rgStateMachine.append(rgTerminateStateMachine[i]);
+        _downloadState.rgStateMachine.append(rgTerminateStateMachine[i]);
     }
     _downloadState.retryCount = 0;
-    _startStateMachine();
+    _startStateMachine(_downloadState);
+}
+
+void FTPManager::cancelUpload()
+{
+    if (!_uploadState.active()) {
+        return;
+    }
+
+    if (_uploadState.waitingForSession) {
+        _uploadComplete("Aborted");
+        return;
+    }
+
+    if (!_uploadState.sessionOpen) {
+        // Same as downloads, nothing to cancel until the component has created the file
+        return;
+    }
+
+    _cancelPendingRequests(_uploadState);
+    _uploadState.rgStateMachine.clear();
+    static const StateFunctions_t rgTerminateStateMachine[] = {
+        { &FTPManager::_terminateUploadBegin,       &FTPManager::_terminateUploadAckOrNak,  &FTPManager::_terminateUploadTimeout },
+        { &FTPManager::_terminateUploadComplete,    nullptr,                                nullptr },
+    };
+    for (size_t i=0; i<sizeof(rgTerminateStateMachine)/sizeof(rgTerminateStateMachine[0]); i++) {
+        _uploadState.rgStateMachine.append(rgTerminateStateMachine[i]);
+    }
+    _uploadState.retryCount = 0;
+    _startStateMachine(_uploadState);
 }
 
 void FTPManager::_terminateSessionBegin(void)
@@ -138,36 +318,25 @@ void FTPManager::_terminateSessionBegin(void)
     MavlinkFTP::Request request{};
     request.hdr.session = _downloadState.sessionId;
     request.hdr.opcode  = MavlinkFTP::kCmdTerminateSession;
-    _sendRequestExpectAck(&request);
+    _sendRequestExpectAck(_downloadState, &request);
 }
 
-void FTPManager::_terminateSessionAckOrNak(const MavlinkFTP::Request *ackOrNak)
+void FTPManager::_terminateSessionAckOrNak(const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* /*request*/)
 {
-    MavlinkFTP::OpCode_t requestOpCode = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
-    if (requestOpCode != MavlinkFTP::kCmdTerminateSession) {
-        qCDebug(FTPManagerLog) << "_terminateSessionAckOrNak: Ack disregarding ack for incorrect requestOpCode" << MavlinkFTP::opCodeToString(requestOpCode);
-        return;
-    }
-    if (ackOrNak->hdr.seqNumber != _expectedIncomingSeqNumber) {
-        qCDebug(FTPManagerLog) << "_terminateSessionAckOrNak: Ack disregarding ack for incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-        return;
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
+        // A resent terminate is Nak'ed once the first one closed the session
+        qCDebug(FTPManagerLog) << "_terminateSessionAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
     }
 
-    _ackOrNakTimeoutTimer.stop();
-    _advanceStateMachine();
+    _downloadState.sessionOpen = false;
+    _advanceStateMachine(_downloadState);
 }
 
 void FTPManager::_terminateSessionTimeout(void)
 {
-    if (++_downloadState.retryCount > _maxRetry) {
-        qCDebug(FTPManagerLog) << QString("_terminateSessionTimeout retries exceeded");
-        _downloadComplete(tr("Download failed"));
-    } else {
-        // Try again
-        qCDebug(FTPManagerLog) << QString("_terminateSessionTimeout: retrying - retryCount(%1)").arg(_downloadState.retryCount);
-        _terminateSessionBegin();
-    }
-
+    // The file is complete at this point. The session is terminated once more without waiting for a response when the operation completes.
+    qCDebug(FTPManagerLog) << "_terminateSessionTimeout retries exceeded";
+    _advanceStateMachine(_downloadState);
 }
 
 void FTPManager::_terminateComplete(void)
@@ -175,18 +344,44 @@ void FTPManager::_terminateComplete(void)
     _downloadComplete("Aborted");
 }
 
+void FTPManager::_terminateUploadBegin(void)
+{
+    MavlinkFTP::Request request{};
+    request.hdr.session = _uploadState.sessionId;
+    request.hdr.opcode  = MavlinkFTP::kCmdTerminateSession;
+    _sendRequestExpectAck(_uploadState, &request);
+}
+
+void FTPManager::_terminateUploadAckOrNak(const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* /*request*/)
+{
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
+        qCDebug(FTPManagerLog) << "_terminateUploadAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
+    }
+
+    _uploadState.sessionOpen = false;
+    _advanceStateMachine(_uploadState);
+}
+
+void FTPManager::_terminateUploadTimeout(void)
+{
+    qCDebug(FTPManagerLog) << "_terminateUploadTimeout retries exceeded";
+    _advanceStateMachine(_uploadState);
+}
+
+void FTPManager::_terminateUploadComplete(void)
+{
+    _uploadComplete("Aborted");
+}
+
 /// Closes out a download session by writing the file and doing cleanup.
 ///     @param errorMsg Error message, empty if no error
 void FTPManager::_downloadComplete(const QString& errorMsg)
 {
     qCDebug(FTPManagerLog) << QString("_downloadComplete: errorMsg(%1)").arg(errorMsg);
-    
+
     QString downloadFilePath    = _downloadState.toDir.absoluteFilePath(_downloadState.fileName);
-    QString error               = errorMsg;
 
-    _ackOrNakTimeoutTimer.stop();
-    _rgStateMachine.clear();
-    _currentStateMachineIndex = -1;
+    _operationComplete(_downloadState);
     if (_downloadState.file.isOpen()) {
         _downloadState.file.close();
         if (!errorMsg.isEmpty()) {
@@ -197,15 +392,25 @@ void FTPManager::_downloadComplete(const QString& errorMsg)
     emit downloadComplete(downloadFilePath, errorMsg);
 }
 
+/// Closes out an upload
+///     @param errorMsg Error message, empty if no error
+void FTPManager::_uploadComplete(const QString& errorMsg)
+{
+    qCDebug(FTPManagerLog) << QString("_uploadComplete: errorMsg(%1)").arg(errorMsg);
+
+    _operationComplete(_uploadState);
+    _uploadState.file.close();
+
+    emit uploadComplete(_uploadState.uri, errorMsg);
+}
+
 /// Closes out a list directory sequence
 ///     @param errorMsg Error message, empty if no error
 void FTPManager::_listDirectoryComplete(const QString& errorMsg)
 {
     qCDebug(FTPManagerLog) << QString("_listDirectoryComplete: errorMsg(%1)").arg(errorMsg);
-    
-    _ackOrNakTimeoutTimer.stop();
-    _rgStateMachine.clear();
-    _currentStateMachineIndex = -1;
+
+    _operationComplete(_listDirectoryState);
 
     QStringList rgDirectoryList = _listDirectoryState.rgDirectoryList;
     if (!errorMsg.isEmpty()) {
@@ -215,14 +420,115 @@ void FTPManager::_listDirectoryComplete(const QString& errorMsg)
     emit listDirectoryComplete(rgDirectoryList, errorMsg);
 }
 
+void FTPManager::_removeFileComplete(const QString& errorMsg)
+{
+    qCDebug(FTPManagerLog) << QString("_removeFileComplete: errorMsg(%1)").arg(errorMsg);
+
+    _operationComplete(_removeFileState);
+
+    emit removeFileComplete(_removeFileState.uri, errorMsg);
+}
+
+void FTPManager::_createDirectoryComplete(const QString& errorMsg)
+{
+    qCDebug(FTPManagerLog) << QString("_createDirectoryComplete: errorMsg(%1)").arg(errorMsg);
+
+    _operationComplete(_createDirectoryState);
+
+    emit createDirectoryComplete(_createDirectoryState.uri, errorMsg);
+}
+
+void FTPManager::_calcFileCrc32Complete(const QString& errorMsg)
+{
+    qCDebug(FTPManagerLog) << QString("_calcFileCrc32Complete: crc32(%1) errorMsg(%2)").arg(_calcFileCrc32State.crc32, 8, 16, QChar('0')).arg(errorMsg);
+
+    _operationComplete(_calcFileCrc32State);
+
+    emit calcFileCrc32Complete(_calcFileCrc32State.uri, errorMsg.isEmpty() ? _calcFileCrc32State.crc32 : 0, errorMsg);
+}
+
+/// Cleanup shared by all operations once they are done. Transfers which were waiting for a session on the same
+/// component try again, since one may have become available.
+void FTPManager::_operationComplete(OperationState_t& operation)
+{
+    _cancelPendingRequests(operation);
+
+    if (operation.sessionOpen) {
+        // Don't leave the session open on the component when failing part way through. Nobody waits for the response.
+        MavlinkFTP::Request request{};
+        request.hdr.seqNumber   = _nextSeqNumber;
+        request.hdr.session     = operation.sessionId;
+        request.hdr.opcode      = MavlinkFTP::kCmdTerminateSession;
+        _nextSeqNumber += 2;
+        _sendRequest(operation.compId, &request);
+    }
+
+    operation.rgStateMachine.clear();
+    operation.currentStateIndex = -1;
+    operation.sessionOpen       = false;
+    operation.waitingForSession = false;
+
+    OperationState_t* const rgTransfers[] = { &_downloadState, &_uploadState };
+    for (OperationState_t* transfer: rgTransfers) {
+        if (transfer->active() && transfer->waitingForSession && (transfer->compId == operation.compId)) {
+            qCDebug(FTPManagerLog) << "_operationComplete: retrying open of transfer waiting for a session";
+            transfer->waitingForSession = false;
+            (this->*transfer->rgStateMachine[transfer->currentStateIndex].beginFn)();
+        }
+    }
+}
+
+/// Called when the component has no session left to open a file. If one of our own transfers holds a session on the
+/// same component the operation waits for it to complete.
+///     @return true: waiting, false: nothing to wait for
+bool FTPManager::_waitForSession(OperationState_t& operation)
+{
+    const OperationState_t* const rgTransfers[] = { &_downloadState, &_uploadState };
+    for (const OperationState_t* transfer: rgTransfers) {
+        if ((transfer != &operation) && transfer->active() && transfer->sessionOpen && (transfer->compId == operation.compId)) {
+            operation.waitingForSession = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// @return true: another operation is talking to the same component
+bool FTPManager::_otherOperationActive(const OperationState_t& operation) const
+{
+    const OperationState_t* const rgOperations[] = { &_downloadState, &_uploadState, &_listDirectoryState, &_removeFileState, &_createDirectoryState, &_calcFileCrc32State };
+    for (const OperationState_t* other: rgOperations) {
+        if ((other != &operation) && other->active() && (other->compId == operation.compId)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Burst packets use the sequence numbers following the burst request. A request from another operation could
+/// collide with one of them, in which case the component answers with its last reply instead of executing it.
+/// So the download reads the rest of the file with individual requests once another operation needs the component.
+void FTPManager::_abandonBurst(void)
+{
+    qCDebug(FTPManagerLog) << "_abandonBurst: continuing with read requests at offset" << _downloadState.expectedOffset;
+
+    _removePendingRequest(_downloadState.burstSeqNumber);
+    if (_downloadState.expectedOffset < _downloadState.fileSize) {
+        _downloadState.rgMissingData.append({ _downloadState.expectedOffset, _downloadState.fileSize - _downloadState.expectedOffset });
+    }
+    _nextSeqNumber += _burstSeqNumberGap;
+    _advanceStateMachine(_downloadState);
+}
+
 void FTPManager::_mavlinkMessageReceived(const mavlink_message_t& message)
 {
-    if (message.msgid != MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL ||
-            message.sysid != _vehicle->id() || message.compid != _ftpCompId) {
+    if (message.msgid != MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL || message.sysid != _vehicle->id()) {
         return;
     }
 
-    if (_currentStateMachineIndex == -1) {
+    if (_pendingRequests.isEmpty()) {
         return;
     }
 
@@ -234,40 +540,109 @@ void FTPManager::_mavlinkMessageReceived(const mavlink_message_t& message)
     if (data.target_system != qgcId) {
         return;
     }
-    
-    MavlinkFTP::Request* request = (MavlinkFTP::Request*)&data.payload[0];
 
-    // Ignore old/reordered packets (handle wrap-around properly)
-    uint16_t actualIncomingSeqNumber = request->hdr.seqNumber;
-    if ((uint16_t)((_expectedIncomingSeqNumber - 1) - actualIncomingSeqNumber) < (std::numeric_limits<uint16_t>::max()/2)) {
-        qCDebug(FTPManagerLog) << "_mavlinkMessageReceived: Received old packet seqNum expected:actual" << _expectedIncomingSeqNumber << actualIncomingSeqNumber
-                               << "hdr.opcode:hdr.req_opcode" << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(request->hdr.opcode)) <<  MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(request->hdr.req_opcode));
+    const MavlinkFTP::Request* ackOrNak = (const MavlinkFTP::Request*)&data.payload[0];
+    const uint16_t incomingSeqNumber = ackOrNak->hdr.seqNumber;
+
+    qCDebug(FTPManagerLog) << "_mavlinkMessageReceived: hdr.opcode:hdr.req_opcode:seqNumber"
+                           << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.opcode)) <<  MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode))
+                           << incomingSeqNumber;
+
+    // Keep outgoing sequence numbers past everything the component sent, so a new request is never mistaken for the resend
+    // of an old one (servers answer those from their last reply). Handles wrap-around.
+    if (static_cast<int16_t>(static_cast<uint16_t>(incomingSeqNumber + 1u - _nextSeqNumber)) > 0) {
+        _nextSeqNumber = incomingSeqNumber + 1;
+    }
 
+    if (ackOrNak->hdr.req_opcode == MavlinkFTP::kCmdBurstReadFile) {
+        // Burst packets follow the request with consecutive sequence numbers, they belong to the download if it is bursting
+        if (_downloadState.active() && (message.compid == _downloadState.compId) &&
+                (_downloadState.rgStateMachine[_downloadState.currentStateIndex].ackNakFn == &FTPManager::_burstReadFileAckOrNak)) {
+            _burstReadFileAckOrNak(ackOrNak, nullptr);
+        }
         return;
     }
 
-    qCDebug(FTPManagerLog) << "_mavlinkMessageReceived: hdr.opcode:hdr.req_opcode:seqNumber"
-                           << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(request->hdr.opcode)) <<  MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(request->hdr.req_opcode))
-                           << request->hdr.seqNumber;
+    // Everything else answers the request with the previous sequence number
+    auto it = _pendingRequests.find(static_cast<uint16_t>(incomingSeqNumber - 1));
+    if ((it == _pendingRequests.end()) || (it->operation->compId != message.compid) || (it->request.hdr.opcode != ackOrNak->hdr.req_opcode)) {
+        qCDebug(FTPManagerLog) << "_mavlinkMessageReceived: Disregarding response with no matching request in flight";
+        return;
+    }
 
-    (this->*_rgStateMachine[_currentStateMachineIndex].ackNakFn)(request);
+    const PendingRequest_t pending = it.value();
+    _removePendingRequest(it.key());
+    if (pending.tryCount == 1) {
+        // Responses to resent requests can't be timed since we don't know which transmission they answer
+        _rttEstimator.addSample(pending.sentTimer.elapsed());
+    }
+    _armAckOrNakTimeoutTimer();
+
+    OperationState_t* operation = pending.operation;
+    (this->*operation->rgStateMachine[operation->currentStateIndex].ackNakFn)(ackOrNak, &pending.request);
 }
 
-void FTPManager::_startStateMachine(void)
+void FTPManager::_startStateMachine(OperationState_t& operation)
 {
-    _currentStateMachineIndex = -1;
-    _advanceStateMachine();
+    operation.currentStateIndex = -1;
+    _advanceStateMachine(operation);
 }
 
-void FTPManager::_advanceStateMachine(void)
+void FTPManager::_advanceStateMachine(OperationState_t& operation)
 {
-    _currentStateMachineIndex++;
-    (this->*_rgStateMachine[_currentStateMachineIndex].beginFn)();
+    operation.currentStateIndex++;
+    (this->*operation.rgStateMachine[operation.currentStateIndex].beginFn)();
 }
 
+/// Resends requests whose response is overdue. Requests which are out of tries, or which can't be resent as is,
+/// are handed to the timeout function of their operation's current state.
 void FTPManager::_ackOrNakTimeout(void)
 {
-    (this->*_rgStateMachine[_currentStateMachineIndex].timeoutFn)();
+    // Handling a timeout can complete operations and send new requests, so collect the overdue requests first
+    QList<uint16_t> rgOverdue;
+    for (auto it = _pendingRequests.cbegin(); it != _pendingRequests.cend(); ++it) {
+        if (it->sentTimer.elapsed() >= it->timeoutMSecs) {
+            rgOverdue.append(it.key());
+        }
+    }
+
+    for (uint16_t seqNumber: rgOverdue) {
+        auto it = _pendingRequests.find(seqNumber);
+        if (it == _pendingRequests.end()) {
+            // Removed while handling an earlier timeout
+            continue;
+        }
+
+        if (it->retransmit && (it->tryCount < it->maxTries)) {
+            // Same sequence number, so a server which already answered resends its reply instead of executing the request again
+            _sendPendingRequest(it.value());
+            continue;
+        }
+
+        qCDebug(FTPManagerLog) << "_ackOrNakTimeout: no response opcode:seqNumber:tryCount" << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(it->request.hdr.opcode)) << seqNumber << it->tryCount;
+
+        OperationState_t* operation = it->operation;
+        _removePendingRequest(seqNumber);
+        (this->*operation->rgStateMachine[operation->currentStateIndex].timeoutFn)();
+    }
+
+    _armAckOrNakTimeoutTimer();
+}
+
+/// Arms the timeout timer for the earliest response deadline. The timer is left stopped while nothing is in flight.
+void FTPManager::_armAckOrNakTimeoutTimer(void)
+{
+    if (_pendingRequests.isEmpty()) {
+        _ackOrNakTimeoutTimer.stop();
+        return;
+    }
+
+    qint64 nextDeadlineMSecs = std::numeric_limits<qint64>::max();
+    for (const PendingRequest_t& pending: _pendingRequests) {
+        nextDeadlineMSecs = qMin(nextDeadlineMSecs, pending.timeoutMSecs - pending.sentTimer.elapsed());
+    }
+
+    _ackOrNakTimeoutTimer.start(static_cast<int>(qMax<qint64>(nextDeadlineMSecs, 0)));
 }
 
 void FTPManager::_fillRequestDataWithString(MavlinkFTP::Request* request, const QString& str)
@@ -301,7 +676,7 @@ void FTPManager::_openFileROBegin(void)
     request.hdr.offset  = 0;
     request.hdr.size    = 0;
     _fillRequestDataWithString(&request, _downloadState.fullPathOnVehicle);
-    _sendRequestExpectAck(&request);
+    _sendRequestExpectAck(_downloadState, &request);
 }
 
 void FTPManager::_openFileROTimeout(void)
@@ -310,42 +685,38 @@ void FTPManager::_openFileROTimeout(void)
     _downloadComplete(tr("Download failed"));
 }
 
-void FTPManager::_openFileROAckOrNak(const MavlinkFTP::Request* ackOrNak)
+void FTPManager::_openFileROAckOrNak(const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* /*request*/)
 {
-    MavlinkFTP::OpCode_t requestOpCode = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
-    if (requestOpCode != MavlinkFTP::kCmdOpenFileRO) {
-        qCDebug(FTPManagerLog) << "_openFileROAckOrNak: Ack disregarding ack for incorrect requestOpCode" << MavlinkFTP::opCodeToString(requestOpCode);
-        return;
-    }
-    if (ackOrNak->hdr.seqNumber != _expectedIncomingSeqNumber) {
-        qCDebug(FTPManagerLog) << "_openFileROAckOrNak: Ack disregarding ack for incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-        return;
-    }
-
-    _ackOrNakTimeoutTimer.stop();
-
     if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
         qCDebug(FTPManagerLog) << "_openFileROAckOrNak: Ack  - sessionId:openFileLength" << ackOrNak->hdr.session << ackOrNak->openFileLength;
 
+        _downloadState.sessionId    = ackOrNak->hdr.session;
+        _downloadState.sessionOpen  = true;
+
         if (ackOrNak->hdr.size != sizeof(uint32_t)) {
             qCDebug(FTPManagerLog) << "_openFileROAckOrNak: Ack ack->hdr.size != sizeof(uint32_t)" << ackOrNak->hdr.size << sizeof(uint32_t);
             _downloadComplete(tr("Download failed"));
             return;
         }
 
-        _downloadState.sessionId        = ackOrNak->hdr.session;
         _downloadState.fileSize         = ackOrNak->openFileLength;
         _downloadState.expectedOffset   = 0;
 
         _downloadState.file.setFileName(_downloadState.toDir.filePath(_downloadState.fileName));
         if (_downloadState.file.open(QFile::WriteOnly | QFile::Truncate)) {
-            _advanceStateMachine();
+            _advanceStateMachine(_downloadState);
         } else {
             qCDebug(FTPManagerLog) << "_openFileROAckOrNak: Ack _downloadState.file open failed" << _downloadState.file.errorString();
             _downloadComplete(tr("Download failed"));
         }
     } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
         qCDebug(FTPManagerLog) << "_handlOpenFileROAck: Nak -" << _errorMsgFromNak(ackOrNak);
+
+        if ((static_cast<MavlinkFTP::ErrorCode_t>(ackOrNak->data[0]) == MavlinkFTP::kErrNoSessionsAvailable) && _waitForSession(_downloadState)) {
+            qCDebug(FTPManagerLog) << "_openFileROAckOrNak: waiting for upload to release its session";
+            return;
+        }
+
         _downloadComplete(tr("Download failed") + ": " + _errorMsgFromNak(ackOrNak));
     }
 }
@@ -354,48 +725,54 @@ void FTPManager::_burstReadFileWorker(bool firstRequest)
 {
     qCDebug(FTPManagerLog) << "_burstReadFileWorker: starting burst at offset:firstRequest:retryCount" << _downloadState.expectedOffset << firstRequest << _downloadState.retryCount;
 
+    if (firstRequest) {
+        _downloadState.retryCount = 0;
+    }
+
+    // A new burst replaces the one in flight
+    auto it = _pendingRequests.constFind(_downloadState.burstSeqNumber);
+    if ((it != _pendingRequests.constEnd()) && (it->operation == &_downloadState)) {
+        _removePendingRequest(_downloadState.burstSeqNumber);
+    }
+
     MavlinkFTP::Request request{};
     request.hdr.session = _downloadState.sessionId;
     request.hdr.opcode  = MavlinkFTP::kCmdBurstReadFile;
     request.hdr.offset  = _downloadState.expectedOffset;
     request.hdr.size    = sizeof(request.data);
 
-    if (firstRequest) {
-        _downloadState.retryCount = 0;
-    } else {
-        // Must used same sequence number as previous request
-        _expectedIncomingSeqNumber -= 2;
-    }
-
-    _sendRequestExpectAck(&request);
+    // Resending the request as is would start over at the original offset, so the timeout function starts a new burst instead
+    _downloadState.burstSeqNumber       = _sendRequestExpectAck(_downloadState, &request, false /* retransmit */);
+    _downloadState.lastBurstSeqNumber   = _downloadState.burstSeqNumber;
 }
 
 void FTPManager::_burstReadFileBegin(void)
 {
+    if (_downloadState.checksize && _otherOperationActive(_downloadState)) {
+        // See _abandonBurst. Without a reliable file size the burst is the only way to find the end of the file.
+        qCDebug(FTPManagerLog) << "_burstReadFileBegin: component busy with another operation, using read requests";
+        if (_downloadState.fileSize > 0) {
+            _downloadState.rgMissingData.append({ 0, _downloadState.fileSize });
+        }
+        _advanceStateMachine(_downloadState);
+        return;
+    }
+
     _burstReadFileWorker(true /* firstRequestr */);
 }
 
-void FTPManager::_burstReadFileAckOrNak(const MavlinkFTP::Request* ackOrNak)
+void FTPManager::_burstReadFileAckOrNak(const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* /*request*/)
 {
-    MavlinkFTP::OpCode_t requestOpCode = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
-
-    if (requestOpCode != MavlinkFTP::kCmdBurstReadFile) {
-        qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: Disregarding due to incorrect requestOpCode" << MavlinkFTP::opCodeToString(requestOpCode);
-        return;
-    }
     if (ackOrNak->hdr.session != _downloadState.sessionId) {
         qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: Disregarding due to incorrect session id actual:expected" << ackOrNak->hdr.session << _downloadState.sessionId;
         return;
     }
-
-    _ackOrNakTimeoutTimer.stop();
+    if (static_cast<int16_t>(static_cast<uint16_t>(ackOrNak->hdr.seqNumber - _downloadState.lastBurstSeqNumber)) <= 0) {
+        qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: Disregarding old packet actual:last" << ackOrNak->hdr.seqNumber << _downloadState.lastBurstSeqNumber;
+        return;
+    }
 
     if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
-        if (ackOrNak->hdr.seqNumber < _expectedIncomingSeqNumber) {
-            qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: Disregarding Ack due to incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-            return;
-        }
-
         qCDebug(FTPManagerLog) << QString("_burstReadFileAckOrNak: Ack offset(%1) size(%2) burstComplete(%3)").arg(ackOrNak->hdr.offset).arg(ackOrNak->hdr.size).arg(ackOrNak->hdr.burstComplete);
 
         if (ackOrNak->hdr.offset != _downloadState.expectedOffset) {
@@ -407,8 +784,7 @@ void FTPManager::_burstReadFileAckOrNak(const MavlinkFTP::Request* ackOrNak)
                 _downloadState.rgMissingData.append(missingData);
                 qCDebug(FTPManagerLog) << "_handleBurstReadFileAck: adding missing data offset:cBytesMissing" << missingData.offset << missingData.cBytesMissing;
             } else {
-                // Offset is past what we have already seen, disregard and wait for something usefule
-                _ackOrNakTimeoutTimer.start();
+                // Offset is before what we have already seen, disregard and wait for something useful
                 qCDebug(FTPManagerLog) << "_handleBurstReadFileAck: received offset less than expected offset received:expected" << ackOrNak->hdr.offset << _downloadState.expectedOffset;
                 return;
             }
@@ -420,17 +796,20 @@ void FTPManager::_burstReadFileAckOrNak(const MavlinkFTP::Request* ackOrNak)
             _downloadComplete(tr("Download failed: Error saving file"));
             return;
         }
-        _downloadState.bytesWritten += ackOrNak->hdr.size;
-        _downloadState.expectedOffset = ackOrNak->hdr.offset + ackOrNak->hdr.size;
+        _downloadState.bytesWritten         += ackOrNak->hdr.size;
+        _downloadState.expectedOffset       = ackOrNak->hdr.offset + ackOrNak->hdr.size;
+        _downloadState.lastBurstSeqNumber   = ackOrNak->hdr.seqNumber;
 
         if (ackOrNak->hdr.burstComplete) {
             // The current burst is done, request next one in offset sequence
-            _expectedIncomingSeqNumber = ackOrNak->hdr.seqNumber;
             _burstReadFileWorker(true /* firstRequest */);
         } else {
-            // Still within a burst, next ack should come automatically
-            _expectedIncomingSeqNumber = ackOrNak->hdr.seqNumber + 1;
-            _ackOrNakTimeoutTimer.start();
+            // Still within a burst, next ack should come automatically. The timeout counts from the latest packet.
+            auto it = _pendingRequests.find(_downloadState.burstSeqNumber);
+            if (it != _pendingRequests.end()) {
+                it->sentTimer.start();
+            }
+            _armAckOrNakTimeoutTimer();
         }
 
         // Emit progress last, as cancel could be called in there
@@ -440,18 +819,27 @@ void FTPManager::_burstReadFileAckOrNak(const MavlinkFTP::Request* ackOrNak)
     } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
         MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(ackOrNak->data[0]);
 
+        _removePendingRequest(_downloadState.burstSeqNumber);
+        _armAckOrNakTimeoutTimer();
+
         if (errorCode == MavlinkFTP::kErrEOF) {
             // Burst sequence has gone through the whole file
-            if (ackOrNak->hdr.seqNumber != _expectedIncomingSeqNumber) {
-                qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: EOF Nak"
-                    "with incorrect sequence nr actual:expected"
-                    << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-                /* We have received the EOF Nak but out of sequence, i.e. data is missing */
-                _expectedIncomingSeqNumber = ackOrNak->hdr.seqNumber;
-                _burstReadFileWorker(true); /* Retry from last expected offset */
+            if (_downloadState.checksize) {
+                // Anything lost at the end of the burst is read with the rest of the missing data
+                if (_downloadState.expectedOffset < _downloadState.fileSize) {
+                    _downloadState.rgMissingData.append({ _downloadState.expectedOffset, _downloadState.fileSize - _downloadState.expectedOffset });
+                }
+                qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak EOF";
+                _advanceStateMachine(_downloadState);
+            } else if (ackOrNak->hdr.seqNumber != static_cast<uint16_t>(_downloadState.lastBurstSeqNumber + 1)) {
+                // We have received the EOF Nak but out of sequence, i.e. data is missing. With no known file size
+                // we can't tell how much, so burst again from the last expected offset.
+                qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: EOF Nak with incorrect sequence nr actual:expected"
+                                       << ackOrNak->hdr.seqNumber << static_cast<uint16_t>(_downloadState.lastBurstSeqNumber + 1);
+                _burstReadFileWorker(true);
             } else {
                 qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak EOF";
-                _advanceStateMachine();
+                _advanceStateMachine(_downloadState);
             }
         } else { /* Don't care is this is out of sequence */
             qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
@@ -472,49 +860,27 @@ void FTPManager::_burstReadFileTimeout(void)
     }
 }
 
-void FTPManager::_listDirectoryWorker(bool firstRequest)
+void FTPManager::_listDirectoryWorker(void)
 {
-    qCDebug(FTPManagerLog) << "_listDirectoryWorker: offset:firstRequest:retryCount" << _listDirectoryState.expectedOffset << firstRequest << _listDirectoryState.retryCount;
+    qCDebug(FTPManagerLog) << "_listDirectoryWorker: offset" << _listDirectoryState.expectedOffset;
 
     MavlinkFTP::Request request{};
-    request.hdr.session = _downloadState.sessionId;
+    request.hdr.session = 0;
     request.hdr.opcode  = MavlinkFTP::kCmdListDirectory;
     request.hdr.offset  = _listDirectoryState.expectedOffset;
     request.hdr.size    = sizeof(request.data);
     _fillRequestDataWithString(&request, _listDirectoryState.fullPathOnVehicle);
-    
-    if (firstRequest) {
-        _listDirectoryState.retryCount = 0;
-    } else {
-        // Must used same sequence number as previous request
-        _expectedIncomingSeqNumber -= 2;
-    }
-
-    _sendRequestExpectAck(&request);
+    _sendRequestExpectAck(_listDirectoryState, &request);
 }
 
 void FTPManager::_listDirectoryBegin(void)
 {
-    _listDirectoryWorker(true /* firstRequest */);
+    _listDirectoryWorker();
 }
 
-void FTPManager::_listDirectoryAckOrNak(const MavlinkFTP::Request* ackOrNak)
+void FTPManager::_listDirectoryAckOrNak(const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* /*request*/)
 {
-    MavlinkFTP::OpCode_t requestOpCode = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
-
-    if (requestOpCode != MavlinkFTP::kCmdListDirectory) {
-        qCDebug(FTPManagerLog) << "_listDirectoryAckOrNak: Disregarding due to incorrect requestOpCode" << MavlinkFTP::opCodeToString(requestOpCode);
-        return;
-    }
-
-    _ackOrNakTimeoutTimer.stop();
-
     if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
-        if (ackOrNak->hdr.seqNumber < _expectedIncomingSeqNumber) {
-            qCDebug(FTPManagerLog) << "_listDirectoryAckOrNak: Disregarding Ack due to incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-            return;
-        }
-
         qCDebug(FTPManagerLog) << QString("_listDirectoryAckOrNak: Ack size(%1)").arg(ackOrNak->hdr.size);
 
         // Parse entries in ackOrNak->data into _listDirectoryState.rgDirectoryList
@@ -527,22 +893,15 @@ void FTPManager::_listDirectoryAckOrNak(const MavlinkFTP::Request* ackOrNak)
         }
 
         // Request next set of directory entries
-        _expectedIncomingSeqNumber = ackOrNak->hdr.seqNumber;
-        _listDirectoryWorker(true /* firstRequest */);
+        _listDirectoryWorker();
     } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
         MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(ackOrNak->data[0]);
 
         if (errorCode == MavlinkFTP::kErrEOF) {
             // All entries returned
-            if (ackOrNak->hdr.seqNumber != _expectedIncomingSeqNumber) {
-                qCDebug(FTPManagerLog) << "_listDirectoryAckOrNak: Disregarding Nak due to incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-                _ackOrNakTimeoutTimer.start();
-                return;
-            } else {
-                qCDebug(FTPManagerLog) << "_listDirectoryAckOrNak EOF";
-                _advanceStateMachine();
-            }
-        } else { /* Don't care is this is out of sequence */
+            qCDebug(FTPManagerLog) << "_listDirectoryAckOrNak EOF";
+            _advanceStateMachine(_listDirectoryState);
+        } else {
             qCDebug(FTPManagerLog) << "_listDirectoryAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
             _listDirectoryComplete(tr("List directory failed"));
         }
@@ -551,44 +910,55 @@ void FTPManager::_listDirectoryAckOrNak(const MavlinkFTP::Request* ackOrNak)
 
 void FTPManager::_listDirectoryTimeout(void)
 {
-    if (++_listDirectoryState.retryCount > _maxRetry) {
-        qCDebug(FTPManagerLog) << QString("_listDirectoryTimeout retries exceeded");
-        _listDirectoryComplete(tr("List directory failed"));
-    } else {
-        // Try again
-        qCDebug(FTPManagerLog) << QString("_listDirectoryTimeout: retrying - retryCount(%1) offset(%2)").arg(_listDirectoryState.retryCount).arg(_listDirectoryState.expectedOffset);
-        _listDirectoryWorker(false /* firstReqeust */);
-    }
+    qCDebug(FTPManagerLog) << QString("_listDirectoryTimeout retries exceeded");
+    _listDirectoryComplete(tr("List directory failed"));
 }
 
-void FTPManager::_fillMissingBlocksWorker(bool firstRequest)
+/// Takes the next piece of at most one packet of data off the front of the missing ranges
+///     @return false: nothing missing
+bool FTPManager::_takeMissingChunk(QList<MissingData_t>& rgMissingData, uint32_t& offset, uint8_t& size)
 {
-    if (_downloadState.rgMissingData.count()) {
-        MavlinkFTP::Request request{};
-        MissingData_t&      missingData = _downloadState.rgMissingData.first();
+    if (rgMissingData.isEmpty()) {
+        return false;
+    }
 
-        uint32_t cBytesToRead = qMin((uint32_t)sizeof(request.data), missingData.cBytesMissing);
+    MissingData_t& missingData = rgMissingData.first();
+    offset  = missingData.offset;
+    size    = static_cast<uint8_t>(qMin(static_cast<uint32_t>(sizeof(MavlinkFTP::Request::data)), missingData.cBytesMissing));
 
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksBegin: offset:cBytesToRead" << missingData.offset << cBytesToRead;
+    missingData.offset          += size;
+    missingData.cBytesMissing   -= size;
+    if (missingData.cBytesMissing == 0) {
+        rgMissingData.removeFirst();
+    }
 
-        request.hdr.session                 = _downloadState.sessionId;
-        request.hdr.opcode                  = MavlinkFTP::kCmdReadFile;
-        request.hdr.offset                  = missingData.offset;
-        request.hdr.size                    = cBytesToRead;
+    return true;
+}
 
-        if (firstRequest) {
-            _downloadState.retryCount = 0;
-        } else {
-            // Must used same sequence number as previous request
-            _expectedIncomingSeqNumber -= 2;
+/// Keeps the read window full with requests for missing data. Moves on once all of it has arrived.
+void FTPManager::_fillMissingBlocksWorker(void)
+{
+    while (_downloadState.cRequestsInFlight < _windowSize) {
+        uint32_t    offset;
+        uint8_t     cBytesToRead;
+        if (!_takeMissingChunk(_downloadState.rgMissingData, offset, cBytesToRead)) {
+            break;
         }
-        _downloadState.expectedOffset = request.hdr.offset;
 
-        _sendRequestExpectAck(&request);
-    } else {
+        qCDebug(FTPManagerLog) << "_fillMissingBlocksWorker: offset:cBytesToRead" << offset << cBytesToRead;
+
+        MavlinkFTP::Request request{};
+        request.hdr.session = _downloadState.sessionId;
+        request.hdr.opcode  = MavlinkFTP::kCmdReadFile;
+        request.hdr.offset  = offset;
+        request.hdr.size    = cBytesToRead;
+        _sendRequestExpectAck(_downloadState, &request, true /* retransmit */, _maxDataRetry + 1);
+    }
+
+    if (_downloadState.cRequestsInFlight == 0) {
         // We should have the full file now
         if (_downloadState.checksize == false || _downloadState.bytesWritten == _downloadState.fileSize) {
-            _advanceStateMachine();
+            _advanceStateMachine(_downloadState);
         } else {
             qCDebug(FTPManagerLog) << "_fillMissingBlocksWorker: no missing blocks but file still incomplete - bytesWritten:fileSize" << _downloadState.bytesWritten << _downloadState.fileSize;
             _downloadComplete(tr("Download failed"));
@@ -598,158 +968,419 @@ void FTPManager::_fillMissingBlocksWorker(bool firstRequest)
 
 void FTPManager::_fillMissingBlocksBegin(void)
 {
-    _fillMissingBlocksWorker(true /* firstRequest */);
+    _downloadState.retryCount = 0;
+    _fillMissingBlocksWorker();
 }
 
-void FTPManager::_fillMissingBlocksAckOrNak(const MavlinkFTP::Request* ackOrNak)
+void FTPManager::_fillMissingBlocksAckOrNak(const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request)
 {
-    MavlinkFTP::OpCode_t requestOpCode = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
-
-    if (requestOpCode != MavlinkFTP::kCmdReadFile) {
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Disregarding due to incorrect requestOpCode" << MavlinkFTP::opCodeToString(requestOpCode);
-        return;
-    }
-    if (ackOrNak->hdr.seqNumber != _expectedIncomingSeqNumber) {
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Disregarding due to incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-        return;
-    }
-    if (ackOrNak->hdr.session != _downloadState.sessionId) {
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Disregarding due to incorrect session id actual:expected" << ackOrNak->hdr.session << _downloadState.sessionId;
-        return;
-    }
-
-    _ackOrNakTimeoutTimer.stop();
-
     if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
         qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Ack offset:size" << ackOrNak->hdr.offset << ackOrNak->hdr.size;
 
-        if (ackOrNak->hdr.offset != _downloadState.expectedOffset) {
+        if ((ackOrNak->hdr.session != _downloadState.sessionId) || (ackOrNak->hdr.offset != request->hdr.offset) ||
+                (ackOrNak->hdr.size == 0) || (ackOrNak->hdr.size > request->hdr.size)) {
             if (++_downloadState.retryCount > _maxRetry) {
                 qCDebug(FTPManagerLog) << QString("_fillMissingBlocksAckOrNak: offset mismatch, retries exceeded");
                 _downloadComplete(tr("Download failed"));
                 return;
             }
 
-            // Ask for current offset again
-            qCDebug(FTPManagerLog) << QString("_fillMissingBlocksAckOrNak: Ack offset mismatch retry, retryCount(%1) offset(%2)").arg(_downloadState.retryCount).arg(_downloadState.expectedOffset);
-            _fillMissingBlocksWorker(false /* firstReqeust */);
-            return;
+            // Ask for the same data again
+            qCDebug(FTPManagerLog) << QString("_fillMissingBlocksAckOrNak: Ack mismatch retry, retryCount(%1) offset(%2)").arg(_downloadState.retryCount).arg(request->hdr.offset);
+            _downloadState.rgMissingData.prepend({ request->hdr.offset, request->hdr.size });
+        } else {
+            _downloadState.file.seek(ackOrNak->hdr.offset);
+            int bytesWritten = _downloadState.file.write((const char*)ackOrNak->data, ackOrNak->hdr.size);
+            if (bytesWritten != ackOrNak->hdr.size) {
+                _downloadComplete(tr("Download failed: Error saving file"));
+                return;
+            }
+            _downloadState.bytesWritten += ackOrNak->hdr.size;
+
+            if (ackOrNak->hdr.size < request->hdr.size) {
+                // Short read, the rest is requested separately
+                _downloadState.rgMissingData.prepend({ request->hdr.offset + ackOrNak->hdr.size, static_cast<uint32_t>(request->hdr.size - ackOrNak->hdr.size) });
+            }
         }
+    } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
+        MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(ackOrNak->data[0]);
 
-        _downloadState.file.seek(ackOrNak->hdr.offset);
-        int bytesWritten = _downloadState.file.write((const char*)ackOrNak->data, ackOrNak->hdr.size);
-        if (bytesWritten != ackOrNak->hdr.size) {
-            _downloadComplete(tr("Download failed: Error saving file"));
+        if (errorCode != MavlinkFTP::kErrEOF) {
+            qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
+            _downloadComplete(tr("Download failed"));
             return;
         }
-        _downloadState.bytesWritten += ackOrNak->hdr.size;
 
-        MissingData_t& missingData = _downloadState.rgMissingData.first();
-        missingData.offset += ackOrNak->hdr.size;
-        missingData.cBytesMissing -= ackOrNak->hdr.size;
-        if (missingData.cBytesMissing == 0) {
-            // This block is finished, remove it
-            _downloadState.rgMissingData.takeFirst();
-        }
+        // Nothing to read there. Whether the file is complete is checked once all requests are done.
+        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak EOF offset" << request->hdr.offset;
+    }
 
-        // Move on to fill in possible next hole
-        _fillMissingBlocksWorker(true /* firstReqeust */);
+    // Move on to fill in possible next hole
+    _fillMissingBlocksWorker();
 
-        // Emit progress last, as cancel could be called in there
-        if (_downloadState.fileSize != 0) {
-            emit commandProgress((float)(_downloadState.bytesWritten) / (float)_downloadState.fileSize);
+    // Emit progress last, as cancel could be called in there
+    if (_downloadState.active() && (_downloadState.fileSize != 0)) {
+        emit commandProgress((float)(_downloadState.bytesWritten) / (float)_downloadState.fileSize);
+    }
+}
+
+void FTPManager::_fillMissingBlocksTimeout(void)
+{
+    qCDebug(FTPManagerLog) << QString("_fillMissingBlocksTimeout retries exceeded");
+    _downloadComplete(tr("Download failed"));
+}
+
+void FTPManager::_createFileBegin(void)
+{
+    MavlinkFTP::Request request{};
+    request.hdr.session = 0;
+    request.hdr.opcode  = MavlinkFTP::kCmdCreateFile;
+    _fillRequestDataWithString(&request, _uploadState.fullPathOnVehicle);
+    _sendRequestExpectAck(_uploadState, &request);
+}
+
+void FTPManager::_createFileAckOrNak(const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request)
+{
+    if (request->hdr.opcode == MavlinkFTP::kCmdRemoveFile) {
+        // Response to removing the existing file
+        if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
+            _createFileBegin();
+        } else {
+            qCDebug(FTPManagerLog) << "_createFileAckOrNak: remove existing file Nak -" << _errorMsgFromNak(ackOrNak);
+            _uploadComplete(tr("Upload failed") + ": " + _errorMsgFromNak(ackOrNak));
         }
+        return;
+    }
+
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
+        qCDebug(FTPManagerLog) << "_createFileAckOrNak: Ack - sessionId" << ackOrNak->hdr.session;
+
+        _uploadState.sessionId      = ackOrNak->hdr.session;
+        _uploadState.sessionOpen    = true;
+        _advanceStateMachine(_uploadState);
     } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
         MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(ackOrNak->data[0]);
 
-        if (errorCode == MavlinkFTP::kErrEOF) {
-            qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak EOF";
-            if (_downloadState.checksize == false || _downloadState.bytesWritten == _downloadState.fileSize) {
-                // We've successfully complete filling in all missing blocks
-                _advanceStateMachine();
+        qCDebug(FTPManagerLog) << "_createFileAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
+
+        if ((errorCode == MavlinkFTP::kErrFailFileExists) && !_uploadState.removedExisting) {
+            // Some servers refuse to create a file which exists already
+            _uploadState.removedExisting = true;
+
+            MavlinkFTP::Request removeRequest{};
+            removeRequest.hdr.opcode = MavlinkFTP::kCmdRemoveFile;
+            _fillRequestDataWithString(&removeRequest, _uploadState.fullPathOnVehicle);
+            _sendRequestExpectAck(_uploadState, &removeRequest);
+            return;
+        }
+
+        if ((errorCode == MavlinkFTP::kErrNoSessionsAvailable) && _waitForSession(_uploadState)) {
+            qCDebug(FTPManagerLog) << "_createFileAckOrNak: waiting for download to release its session";
+            return;
+        }
+
+        _uploadComplete(tr("Upload failed") + ": " + _errorMsgFromNak(ackOrNak));
+    }
+}
+
+void FTPManager::_createFileTimeout(void)
+{
+    qCDebug(FTPManagerLog) << "_createFileTimeout";
+    _uploadComplete(tr("Upload failed"));
+}
+
+/// Keeps the write window full. Moves on once all data has been acknowledged.
+void FTPManager::_writeFileWorker(void)
+{
+    while (_uploadState.cRequestsInFlight < _windowSize) {
+        uint32_t    offset;
+        uint8_t     cBytesToWrite;
+        if (!_takeMissingChunk(_uploadState.rgMissingData, offset, cBytesToWrite)) {
+            break;
+        }
+
+        MavlinkFTP::Request request{};
+        if (!_uploadState.file.seek(offset) || (_uploadState.file.read(reinterpret_cast<char*>(request.data), cBytesToWrite) != cBytesToWrite)) {
+            qCDebug(FTPManagerLog) << "_writeFileWorker: read failed" << _uploadState.file.errorString();
+            _uploadComplete(tr("Upload failed: Error reading file"));
+            return;
+        }
+
+        qCDebug(FTPManagerLog) << "_writeFileWorker: offset:cBytesToWrite" << offset << cBytesToWrite;
+
+        request.hdr.session = _uploadState.sessionId;
+        request.hdr.opcode  = MavlinkFTP::kCmdWriteFile;
+        request.hdr.offset  = offset;
+        request.hdr.size    = cBytesToWrite;
+        _sendRequestExpectAck(_uploadState, &request, true /* retransmit */, _maxDataRetry + 1);
+    }
+
+    if ((_uploadState.cRequestsInFlight == 0) && _uploadState.rgMissingData.isEmpty()) {
+        _advanceStateMachine(_uploadState);
+    }
+}
+
+void FTPManager::_writeFileBegin(void)
+{
+    _uploadState.retryCount = 0;
+    _writeFileWorker();
+}
+
+void FTPManager::_writeFileAckOrNak(const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request)
+{
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
+        // Servers either report the number of bytes written or nothing at all
+        const uint32_t cBytesWritten = (ackOrNak->hdr.size == sizeof(uint32_t)) ? qMin<uint32_t>(ackOrNak->writeFileLength, request->hdr.size) : request->hdr.size;
+
+        qCDebug(FTPManagerLog) << "_writeFileAckOrNak: Ack offset:size" << request->hdr.offset << cBytesWritten;
+
+        if ((ackOrNak->hdr.session != _uploadState.sessionId) || (cBytesWritten == 0)) {
+            if (++_uploadState.retryCount > _maxRetry) {
+                qCDebug(FTPManagerLog) << "_writeFileAckOrNak: nothing written, retries exceeded";
+                _uploadComplete(tr("Upload failed"));
                 return;
             }
+            _uploadState.rgMissingData.prepend({ request->hdr.offset, request->hdr.size });
+        } else {
+            _uploadState.bytesAcked += cBytesWritten;
+            if (cBytesWritten < request->hdr.size) {
+                // Short write, the rest is sent separately
+                _uploadState.rgMissingData.prepend({ request->hdr.offset + cBytesWritten, request->hdr.size - cBytesWritten });
+            }
         }
+    } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
+        qCDebug(FTPManagerLog) << "_writeFileAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
+        _uploadComplete(tr("Upload failed") + ": " + _errorMsgFromNak(ackOrNak));
+        return;
+    }
 
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
-        _downloadComplete(tr("Download failed"));
+    _writeFileWorker();
+
+    // Emit progress last, as cancel could be called in there
+    if (_uploadState.active() && (_uploadState.fileSize != 0)) {
+        emit uploadProgress((float)(_uploadState.bytesAcked) / (float)_uploadState.fileSize);
     }
 }
 
-void FTPManager::_fillMissingBlocksTimeout(void)
+void FTPManager::_writeFileTimeout(void)
 {
-    if (++_downloadState.retryCount > _maxRetry) {
-        qCDebug(FTPManagerLog) << QString("_fillMissingBlocksTimeout retries exceeded");
-        _downloadComplete(tr("Download failed"));
-    } else {
-        // Ask for current offset again
-        qCDebug(FTPManagerLog) << QString("_fillMissingBlocksTimeout: retrying - retryCount(%1) offset(%2)").arg(_downloadState.retryCount).arg(_downloadState.expectedOffset);
-        _fillMissingBlocksWorker(false /* firstReqeust */);
-    }
+    qCDebug(FTPManagerLog) << "_writeFileTimeout retries exceeded";
+    _uploadComplete(tr("Upload failed"));
 }
 
-void FTPManager::_resetSessionsBegin(void)
+void FTPManager::_verifyUploadBegin(void)
 {
     MavlinkFTP::Request request{};
-    request.hdr.opcode  = MavlinkFTP::kCmdResetSessions;
-    request.hdr.size    = 0;
-    _sendRequestExpectAck(&request);
+    request.hdr.opcode = MavlinkFTP::kCmdCalcFileCRC32;
+    _fillRequestDataWithString(&request, _uploadState.fullPathOnVehicle);
+    _sendRequestExpectAck(_uploadState, &request);
 }
 
-void FTPManager::_resetSessionsAckOrNak(const MavlinkFTP::Request* ackOrNak)
+void FTPManager::_verifyUploadAckOrNak(const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* /*request*/)
 {
-    MavlinkFTP::OpCode_t requestOpCode = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
+        if (ackOrNak->hdr.size != sizeof(uint32_t)) {
+            qCDebug(FTPManagerLog) << "_verifyUploadAckOrNak: Ack ack->hdr.size != sizeof(uint32_t)" << ackOrNak->hdr.size;
+            _uploadComplete(tr("Upload failed: Unable to verify file"));
+            return;
+        }
 
-    if (requestOpCode != MavlinkFTP::kCmdResetSessions) {
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Disregarding due to incorrect requestOpCode" << MavlinkFTP::opCodeToString(requestOpCode);
-        return;
+        const quint32 crc32 = qFromLittleEndian<quint32>(ackOrNak->data);
+        if (crc32 != _uploadState.fileCrc32) {
+            qCWarning(FTPManagerLog) << "Upload CRC32 mismatch vehicle:local" << Qt::hex << crc32 << _uploadState.fileCrc32;
+            _uploadComplete(tr("Upload failed: CRC mismatch"));
+            return;
+        }
+
+        qCDebug(FTPManagerLog) << "_verifyUploadAckOrNak: CRC32 matches" << Qt::hex << crc32;
+        _advanceStateMachine(_uploadState);
+    } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
+        MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(ackOrNak->data[0]);
+
+        if (errorCode == MavlinkFTP::kErrUnknownCommand) {
+            qCDebug(FTPManagerLog) << "_verifyUploadAckOrNak: kCmdCalcFileCRC32 not supported, upload not verified";
+            _advanceStateMachine(_uploadState);
+            return;
+        }
+
+        qCDebug(FTPManagerLog) << "_verifyUploadAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
+        _uploadComplete(tr("Upload failed: Unable to verify file") + ": " + _errorMsgFromNak(ackOrNak));
     }
-    if (ackOrNak->hdr.seqNumber != _expectedIncomingSeqNumber) {
-        qCDebug(FTPManagerLog) << "_resetSessionsAckOrNak: Disregarding due to incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-        return;
+}
+
+void FTPManager::_verifyUploadTimeout(void)
+{
+    qCDebug(FTPManagerLog) << "_verifyUploadTimeout";
+    _uploadComplete(tr("Upload failed: Unable to verify file"));
+}
+
+void FTPManager::_removeFileBegin(void)
+{
+    MavlinkFTP::Request request{};
+    request.hdr.opcode = MavlinkFTP::kCmdRemoveFile;
+    _fillRequestDataWithString(&request, _removeFileState.fullPathOnVehicle);
+    _sendRequestExpectAck(_removeFileState, &request);
+}
+
+void FTPManager::_removeFileAckOrNak(const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* /*request*/)
+{
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
+        qCDebug(FTPManagerLog) << "_removeFileAckOrNak: Ack";
+        _advanceStateMachine(_removeFileState);
+    } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
+        qCDebug(FTPManagerLog) << "_removeFileAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
+        _removeFileComplete(tr("Remove file failed") + ": " + _errorMsgFromNak(ackOrNak));
+    }
+}
+
+void FTPManager::_removeFileTimeout(void)
+{
+    qCDebug(FTPManagerLog) << "_removeFileTimeout";
+    _removeFileComplete(tr("Remove file failed"));
+}
+
+void FTPManager::_createDirectoryBegin(void)
+{
+    MavlinkFTP::Request request{};
+    request.hdr.opcode = MavlinkFTP::kCmdCreateDirectory;
+    _fillRequestDataWithString(&request, _createDirectoryState.fullPathOnVehicle);
+    _sendRequestExpectAck(_createDirectoryState, &request);
+}
+
+void FTPManager::_createDirectoryAckOrNak(const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* /*request*/)
+{
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
+        qCDebug(FTPManagerLog) << "_createDirectoryAckOrNak: Ack";
+        _advanceStateMachine(_createDirectoryState);
+    } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
+        qCDebug(FTPManagerLog) << "_createDirectoryAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
+        _createDirectoryComplete(tr("Create directory failed") + ": " + _errorMsgFromNak(ackOrNak));
     }
+}
 
-    _ackOrNakTimeoutTimer.stop();
+void FTPManager::_createDirectoryTimeout(void)
+{
+    qCDebug(FTPManagerLog) << "_createDirectoryTimeout";
+    _createDirectoryComplete(tr("Create directory failed"));
+}
+
+void FTPManager::_calcFileCrc32Begin(void)
+{
+    MavlinkFTP::Request request{};
+    request.hdr.opcode = MavlinkFTP::kCmdCalcFileCRC32;
+    _fillRequestDataWithString(&request, _calcFileCrc32State.fullPathOnVehicle);
+    _sendRequestExpectAck(_calcFileCrc32State, &request);
+}
 
+void FTPManager::_calcFileCrc32AckOrNak(const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* /*request*/)
+{
     if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
-        qCDebug(FTPManagerLog) << "_resetSessionsAckOrNak: Ack";
-        _advanceStateMachine();
+        if (ackOrNak->hdr.size != sizeof(uint32_t)) {
+            qCDebug(FTPManagerLog) << "_calcFileCrc32AckOrNak: Ack ack->hdr.size != sizeof(uint32_t)" << ackOrNak->hdr.size;
+            _calcFileCrc32Complete(tr("Calc file CRC32 failed"));
+            return;
+        }
+
+        _calcFileCrc32State.crc32 = qFromLittleEndian<quint32>(ackOrNak->data);
+        _advanceStateMachine(_calcFileCrc32State);
     } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
-        qCDebug(FTPManagerLog) << "_resetSessionsAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
-        _downloadComplete(QString());
+        qCDebug(FTPManagerLog) << "_calcFileCrc32AckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
+        _calcFileCrc32Complete(tr("Calc file CRC32 failed") + ": " + _errorMsgFromNak(ackOrNak));
     }
 }
 
-void FTPManager::_resetSessionsTimeout(void)
+void FTPManager::_calcFileCrc32Timeout(void)
 {
-    qCDebug(FTPManagerLog) << "_resetSessionsTimeout";
-    _downloadComplete(QString());
+    qCDebug(FTPManagerLog) << "_calcFileCrc32Timeout";
+    _calcFileCrc32Complete(tr("Calc file CRC32 failed"));
+}
+
+/// Sends a request and keeps track of it until its response arrives
+///     @param retransmit   false: The state's timeout function is called instead of resending the request
+///     @param maxTries     Number of times the request is sent before giving up
+/// @return Sequence number of the request
+uint16_t FTPManager::_sendRequestExpectAck(OperationState_t& operation, MavlinkFTP::Request* request, bool retransmit, int maxTries)
+{
+    if ((&operation != &_downloadState) && _downloadState.active() && _downloadState.checksize && (_downloadState.compId == operation.compId) &&
+            (_downloadState.rgStateMachine[_downloadState.currentStateIndex].ackNakFn == &FTPManager::_burstReadFileAckOrNak)) {
+        _abandonBurst();
+    }
+
+    const uint16_t seqNumber = _nextSeqNumber;
+    _nextSeqNumber += 2;    // Outgoing is 1 past the response to the previous request
+    request->hdr.seqNumber = seqNumber;
+
+    PendingRequest_t pending;
+    pending.operation       = &operation;
+    pending.request         = *request;
+    pending.timeoutMSecs    = _defaultTimeoutMSecs;
+    // Requests which aren't resent are retried by their state, which keeps count so the timeout still backs off
+    pending.tryCount        = retransmit ? 0 : operation.retryCount;
+    pending.maxTries        = maxTries;
+    pending.retransmit      = retransmit;
+
+    auto it = _pendingRequests.insert(seqNumber, pending);
+    operation.cRequestsInFlight++;
+
+    _sendPendingRequest(it.value());
+    _armAckOrNakTimeoutTimer();
+
+    return seqNumber;
 }
 
-void FTPManager::_sendRequestExpectAck(MavlinkFTP::Request* request)
+void FTPManager::_sendPendingRequest(PendingRequest_t& pending)
+{
+    pending.tryCount++;
+    pending.timeoutMSecs = _rttEstimator.backoffTimeoutMSecs(pending.tryCount, _defaultTimeoutMSecs, _minTimeoutMSecs, _maxTimeoutMSecs);
+    pending.sentTimer.start();
+
+    qCDebug(FTPManagerLog) << "_sendRequestExpectAck opcode:" << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(pending.request.hdr.opcode))
+                           << "seqNumber:" << pending.request.hdr.seqNumber << "tryCount:" << pending.tryCount << "timeout:" << pending.timeoutMSecs;
+
+    _sendRequest(pending.operation->compId, &pending.request);
+}
+
+void FTPManager::_sendRequest(uint8_t compId, MavlinkFTP::Request* request)
 {
-    _ackOrNakTimeoutTimer.start();
-    
     SharedLinkInterfacePtr sharedLink = _vehicle->vehicleLinkManager()->primaryLink().lock();
-    if (sharedLink) {
-        request->hdr.seqNumber = _expectedIncomingSeqNumber + 1;    // Outgoing is 1 past last incoming
-        _expectedIncomingSeqNumber += 2;
-
-        qCDebug(FTPManagerLog) << "_sendRequestExpectAck opcode:" << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(request->hdr.opcode)) << "seqNumber:" << request->hdr.seqNumber;
-
-        mavlink_message_t message;
-        mavlink_msg_file_transfer_protocol_pack_chan(MAVLinkProtocol::instance()->getSystemId(),
-                                                     MAVLinkProtocol::getComponentId(),
-                                                     sharedLink->mavlinkChannel(),
-                                                     &message,
-                                                     0,                                                     // Target network, 0=broadcast?
-                                                     _vehicle->id(),
-                                                     _ftpCompId,
-                                                     (uint8_t*)request);                                    // Payload
-        _vehicle->sendMessageOnLinkThreadSafe(sharedLink.get(), message);
-    } else {
-        qCDebug(FTPManagerLog) << "_sendRequestExpectAck No primary link. Allowing timeout to fail sequence.";
+    if (!sharedLink) {
+        qCDebug(FTPManagerLog) << "_sendRequest No primary link. Allowing timeout to fail sequence.";
+        return;
     }
+
+    mavlink_message_t message;
+    mavlink_msg_file_transfer_protocol_pack_chan(MAVLinkProtocol::instance()->getSystemId(),
+                                                 MAVLinkProtocol::getComponentId(),
+                                                 sharedLink->mavlinkChannel(),
+                                                 &message,
+                                                 0,                                                     // Target network, 0=broadcast?
+                                                 _vehicle->id(),
+                                                 compId,
+                                                 (uint8_t*)request);                                    // Payload
+    _vehicle->sendMessageOnLinkThreadSafe(sharedLink.get(), message);
+}
+
+void FTPManager::_removePendingRequest(uint16_t seqNumber)
+{
+    auto it = _pendingRequests.find(seqNumber);
+    if (it != _pendingRequests.end()) {
+        it->operation->cRequestsInFlight--;
+        _pendingRequests.erase(it);
+    }
+}
+
+void FTPManager::_cancelPendingRequests(OperationState_t& operation)
+{
+    for (auto it = _pendingRequests.begin(); it != _pendingRequests.end(); ) {
+        if (it->operation == &operation) {
+            it = _pendingRequests.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    operation.cRequestsInFlight = 0;
+
+    _armAckOrNakTimeoutTimer();
 }
 
 bool FTPManager::_parseURI(uint8_t fromCompId, const QString& uri, QString& parsedURI, uint8_t& compId)
@@ -784,20 +1415,3 @@ bool FTPManager::_parseURI(uint8_t fromCompId, const QString& uri, QString& pars
 
     return true;
 }
-
-bool FTPManager::_isListDirectoryStateMachine(void)
-{
-    if (_rgStateMachine.isEmpty()) {
-        qCWarning(FTPManagerLog) << "INTERNAL ERROR: _isListDirectoryStateMachine called with empty state machine";
-        return false;
-    }
-
-    if (_rgStateMachine[0].beginFn == &FTPManager::_listDirectoryBegin) {
-        return true;
-    } else if (_rgStateMachine[0].beginFn == &FTPManager::_openFileROBegin) {
-        return false;
-    } else {
-        qCWarning(FTPManagerLog) << "INTERNAL ERROR: _isListDirectoryStateMachine called with invalid state machine";
-        return false;
-    }
-}
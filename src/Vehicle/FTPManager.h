@@ -10,9 +10,13 @@
 #pragma once
 
 #include "MAVLinkFTP.h"
+#include "RttEstimator.h"
 
 #include <QtCore/QObject>
 #include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
 #include <QtCore/QTimer>
 #include <QtCore/QLoggingCategory>
 
@@ -20,12 +24,19 @@ Q_DECLARE_LOGGING_CATEGORY(FTPManagerLog)
 
 class Vehicle;
 
+/// MAVLink FTP client.
+///
+/// Operations of different kinds (download, upload, list directory, remove file, create directory, crc) run concurrently,
+/// file transfers each in their own server session. Only one operation of each kind can be active at a time since the
+/// completion signals identify the operation by its kind. File data is moved with several read or write requests in flight,
+/// and requests whose response got lost are resent individually.
 class FTPManager : public QObject
 {
     Q_OBJECT
 
     friend class Vehicle;
-    
+    friend class FTPManagerTest;
+
 public:
     FTPManager(Vehicle* vehicle);
 
@@ -44,6 +55,17 @@ class FTPManager : public QObject
     /// Signals downloadComplete, commandProgress
     bool download(uint8_t fromCompId, const QString& fromURI, const QString& toDir, const QString& fileName="", bool checksize = true);
 
+    /// Uploads the specified file. An existing file on the component is replaced.
+    ///     @param toCompId   Component id of the component to upload to. If toCompId is MAV_COMP_ID_ALL, then MAV_COMP_ID_AUTOPILOT1 is used.
+    ///     @param localFile  Local file to upload
+    ///     @param toURI      File to create on the component, fully qualified path. May be in the format "mftp://[;comp=<id>]..." where the component id
+    ///                       is specified. If component id is not specified, then the id set via toCompId is used.
+    ///     @param verifyCrc  (optional, default true) If true the CRC32 of the file as calculated by the component is compared with the
+    ///                       local file once the upload is done. Components which don't support kCmdCalcFileCRC32 skip the check.
+    /// @return true: upload has started, false: error, no upload
+    /// Signals uploadComplete, uploadProgress
+    bool upload(uint8_t toCompId, const QString& localFile, const QString& toURI, bool verifyCrc = true);
+
 	/// Get the directory listing of the specified directory.
     ///     @param fromCompId Component id of the component to download from. If fromCompId is MAV_COMP_ID_ALL, then MAV_COMP_ID_AUTOPILOT1 is used.
     ///     @param fromURI    Directory path to list from component. May be in the format "mftp://[;comp=<id>]..." where the component id
@@ -52,32 +74,70 @@ class FTPManager : public QObject
     /// Signals listDirectoryComplete
     bool listDirectory(uint8_t fromCompId, const QString& fromURI);
 
+    /// Removes the specified file.
+    ///     @param compId Component id of the component to remove the file from. If compId is MAV_COMP_ID_ALL, then MAV_COMP_ID_AUTOPILOT1 is used.
+    ///     @param uri    File to remove, same format as for download
+    /// @return true: process has started, false: error
+    /// Signals removeFileComplete
+    bool removeFile(uint8_t compId, const QString& uri);
+
+    /// Creates the specified directory.
+    ///     @param compId Component id of the component to create the directory on. If compId is MAV_COMP_ID_ALL, then MAV_COMP_ID_AUTOPILOT1 is used.
+    ///     @param uri    Directory to create, same format as for download
+    /// @return true: process has started, false: error
+    /// Signals createDirectoryComplete
+    bool createDirectory(uint8_t compId, const QString& uri);
+
+    /// Asks the component for the CRC32 of the specified file. The value matches QGC::crc32 of the file contents with an initial state of 0.
+    ///     @param compId Component id of the component holding the file. If compId is MAV_COMP_ID_ALL, then MAV_COMP_ID_AUTOPILOT1 is used.
+    ///     @param uri    File to calculate the CRC32 for, same format as for download
+    /// @return true: process has started, false: error
+    /// Signals calcFileCrc32Complete
+    bool calcFileCrc32(uint8_t compId, const QString& uri);
+
     /// Cancel the download operation
     /// This will emit downloadComplete() when done, and if there's currently a download in progress
     void cancelDownload();
 
+    /// Cancel the upload operation
+    /// This will emit uploadComplete() when done, and if there's currently an upload in progress
+    void cancelUpload();
+
+    /// Sets the number of read or write requests a file transfer keeps in flight
+    void setWindowSize(int windowSize) { _windowSize = qMax(1, windowSize); }
+    int windowSize() const { return _windowSize; }
+
     static constexpr const char* mavlinkFTPScheme = "mftp";
+    static constexpr int defaultWindowSize = 4;     ///< ArduPilot queues at most 5 incoming FTP requests
 
 signals:
     void downloadComplete       (const QString& file, const QString& errorMsg);
+    void uploadComplete         (const QString& uri, const QString& errorMsg);
     void listDirectoryComplete  (const QStringList& dirList, const QString& errorMsg);
+    void removeFileComplete     (const QString& uri, const QString& errorMsg);
+    void createDirectoryComplete(const QString& uri, const QString& errorMsg);
+    void calcFileCrc32Complete  (const QString& uri, quint32 crc32, const QString& errorMsg);
 
-    /// Signalled during a lengthy command to show progress
+    /// Signalled during a lengthy download to show progress
     ///     @param value Amount of progress: 0.0 = none, 1.0 = complete
     void commandProgress(float value);
-	
+
+    /// Signalled during an upload to show progress
+    ///     @param value Amount of progress: 0.0 = none, 1.0 = complete
+    void uploadProgress(float value);
+
 private slots:
     void _ackOrNakTimeout(void);
 
 private:
     typedef void (FTPManager::*StateBeginFn)    (void);
-    typedef void (FTPManager::*StateAckNakFn)   (const MavlinkFTP::Request* ackOrNak);
+    typedef void (FTPManager::*StateAckNakFn)   (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
     typedef void (FTPManager::*StateTimeoutFn)  (void);
 
     struct StateFunctions_t {
         StateBeginFn    beginFn;
         StateAckNakFn   ackNakFn;
-        StateTimeoutFn  timeoutFn;
+        StateTimeoutFn  timeoutFn;      ///< Called once the request of the state has run out of retries
     };
 
     struct MissingData_t {
@@ -85,98 +145,207 @@ private slots:
         uint32_t cBytesMissing;
     };
 
-    struct DownloadState_t {
-        uint8_t                 sessionId;
+    /// State shared by all kinds of operations
+    struct OperationState_t {
+        QList<StateFunctions_t> rgStateMachine;
+        int                     currentStateIndex   = -1;
+        uint8_t                 compId              = MAV_COMP_ID_AUTOPILOT1;
+        QString                 uri;                    ///< uri as specified by the caller
+        QString                 fullPathOnVehicle;      ///< Fully qualified path to file on vehicle
+        uint8_t                 sessionId           = 0;
+        bool                    sessionOpen         = false;
+        bool                    waitingForSession   = false;
+        int                     cRequestsInFlight   = 0;
+        int                     retryCount          = 0;
+
+        bool active() const { return !rgStateMachine.isEmpty(); }
+
+        void resetOperation() {
+            rgStateMachine.clear();
+            currentStateIndex   = -1;
+            uri.clear();
+            fullPathOnVehicle.clear();
+            sessionId           = 0;
+            sessionOpen         = false;
+            waitingForSession   = false;
+            retryCount          = 0;
+        }
+    };
+
+    struct DownloadState_t : OperationState_t {
         uint32_t                expectedOffset;         ///< offset which should be coming next
         uint32_t                bytesWritten;
         QList<MissingData_t>    rgMissingData;
-        QString                 fullPathOnVehicle;      ///< Fully qualified path to file on vehicle
         QDir                    toDir;                  ///< Directory to download file to
         QString                 fileName;               ///< Filename (no path) for download file
         uint32_t                fileSize;               ///< Size of file being downloaded
         QFile                   file;
-        int                     retryCount;
         bool                    checksize;
+        uint16_t                burstSeqNumber;         ///< Sequence number of the burst read request in flight
+        uint16_t                lastBurstSeqNumber;     ///< Sequence number of the last burst packet received
 
         bool inProgress() const { return fileSize > 0; }
 
         void reset() {
-            sessionId       = 0;
-            expectedOffset  = 0;
-            bytesWritten    = 0;
-            retryCount      = 0;
-            fileSize        = 0;
-            fullPathOnVehicle.clear();
+            resetOperation();
+            expectedOffset      = 0;
+            bytesWritten        = 0;
+            fileSize            = 0;
+            burstSeqNumber      = 0;
+            lastBurstSeqNumber  = 0;
             fileName.clear();
             rgMissingData.clear();
             file.close();
         }
     };
 
-    struct ListDirectoryState_t {
-        uint8_t     sessionId;
+    struct UploadState_t : OperationState_t {
+        QList<MissingData_t>    rgMissingData;          ///< Ranges of the file not written yet
+        QFile                   file;
+        uint32_t                fileSize;
+        uint32_t                bytesAcked;
+        quint32                 fileCrc32;
+        bool                    verifyCrc;
+        bool                    removedExisting;        ///< An existing file was removed to make room for the upload
+
+        void reset() {
+            resetOperation();
+            rgMissingData.clear();
+            file.close();
+            fileSize        = 0;
+            bytesAcked      = 0;
+            fileCrc32       = 0;
+            verifyCrc       = false;
+            removedExisting = false;
+        }
+    };
+
+    struct ListDirectoryState_t : OperationState_t {
         uint32_t    expectedOffset;         ///< offset which should be coming next
-        QString     fullPathOnVehicle;      ///< Fully qualified path to file on vehicle
         QStringList rgDirectoryList;
-        int         retryCount;
 
         bool inProgress() const { return rgDirectoryList.count() > 0; }
 
         void reset() {
-            sessionId       = 0;
+            resetOperation();
             expectedOffset  = 0;
-            fullPathOnVehicle.clear();
             rgDirectoryList.clear();
-            retryCount      = 0;
         }
     };
 
+    /// Remove file, create directory and calc crc all consist of a single request
+    struct CommandState_t : OperationState_t {
+        quint32 crc32;
+
+        void reset() {
+            resetOperation();
+            crc32 = 0;
+        }
+    };
+
+    struct PendingRequest_t {
+        OperationState_t*   operation;
+        MavlinkFTP::Request request;
+        QElapsedTimer       sentTimer;
+        int                 timeoutMSecs;
+        int                 tryCount;
+        int                 maxTries;
+        bool                retransmit;     ///< false: Instead of resending, the state's timeout function is called
+    };
+
     void    _mavlinkMessageReceived     (const mavlink_message_t& message);
-    void    _startStateMachine          (void);
-    void    _advanceStateMachine        (void);
+    void    _startStateMachine          (OperationState_t& operation);
+    void    _advanceStateMachine        (OperationState_t& operation);
+    void    _operationComplete          (OperationState_t& operation);
+    bool    _startOperation             (OperationState_t& operation, uint8_t compId, const QString& uri, const StateFunctions_t* rgStateMachine, size_t cStates);
+    bool    _waitForSession             (OperationState_t& operation);
+    bool    _otherOperationActive       (const OperationState_t& operation) const;
+    void    _abandonBurst               (void);
     void    _listDirectoryBegin         (void);
-    void    _listDirectoryAckOrNak      (const MavlinkFTP::Request* ackOrNak);
+    void    _listDirectoryAckOrNak      (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
     void    _listDirectoryTimeout       (void);
     void    _openFileROBegin            (void);
-    void    _openFileROAckOrNak         (const MavlinkFTP::Request* ackOrNak);
+    void    _openFileROAckOrNak         (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
     void    _openFileROTimeout          (void);
     void    _burstReadFileBegin         (void);
-    void    _burstReadFileAckOrNak      (const MavlinkFTP::Request* ackOrNak);
+    void    _burstReadFileAckOrNak      (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
     void    _burstReadFileTimeout       (void);
     void    _fillMissingBlocksBegin     (void);
-    void    _fillMissingBlocksAckOrNak  (const MavlinkFTP::Request* ackOrNak);
+    void    _fillMissingBlocksAckOrNak  (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
     void    _fillMissingBlocksTimeout   (void);
-    void    _resetSessionsBegin         (void);
-    void    _resetSessionsAckOrNak      (const MavlinkFTP::Request* ackOrNak);
-    void    _resetSessionsTimeout       (void);
+    void    _createFileBegin            (void);
+    void    _createFileAckOrNak         (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
+    void    _createFileTimeout          (void);
+    void    _writeFileBegin             (void);
+    void    _writeFileAckOrNak          (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
+    void    _writeFileTimeout           (void);
+    void    _verifyUploadBegin          (void);
+    void    _verifyUploadAckOrNak       (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
+    void    _verifyUploadTimeout        (void);
+    void    _removeFileBegin            (void);
+    void    _removeFileAckOrNak         (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
+    void    _removeFileTimeout          (void);
+    void    _createDirectoryBegin       (void);
+    void    _createDirectoryAckOrNak    (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
+    void    _createDirectoryTimeout     (void);
+    void    _calcFileCrc32Begin         (void);
+    void    _calcFileCrc32AckOrNak      (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
+    void    _calcFileCrc32Timeout       (void);
     QString _errorMsgFromNak            (const MavlinkFTP::Request* nak);
-    void    _sendRequestExpectAck       (MavlinkFTP::Request* request);
+    uint16_t _sendRequestExpectAck      (OperationState_t& operation, MavlinkFTP::Request* request, bool retransmit = true, int maxTries = _maxRetry + 1);
+    void    _sendPendingRequest         (PendingRequest_t& pending);
+    void    _sendRequest                (uint8_t compId, MavlinkFTP::Request* request);
+    void    _removePendingRequest       (uint16_t seqNumber);
+    void    _cancelPendingRequests      (OperationState_t& operation);
+    void    _armAckOrNakTimeoutTimer    (void);
     void    _downloadCompleteNoError    (void) { _downloadComplete(QString()); }
     void    _downloadComplete           (const QString& errorMsg);
+    void    _uploadCompleteNoError      (void) { _uploadComplete(QString()); }
+    void    _uploadComplete             (const QString& errorMsg);
     void    _fillRequestDataWithString(MavlinkFTP::Request* request, const QString& str);
-    void    _fillMissingBlocksWorker    (bool firstRequest);
+    void    _fillMissingBlocksWorker    (void);
+    void    _writeFileWorker            (void);
     void    _burstReadFileWorker        (bool firstRequest);
-    void    _listDirectoryWorker        (bool firstRequest);
+    void    _listDirectoryWorker        (void);
     bool    _parseURI                   (uint8_t fromCompId, const QString& uri, QString& parsedURI, uint8_t& compId);
-    bool    _isListDirectoryStateMachine(void);
     void    _listDirectoryCompleteNoError(void) { _listDirectoryComplete(QString()); }
     void    _listDirectoryComplete      (const QString& errorMsg);
+    void    _removeFileCompleteNoError  (void) { _removeFileComplete(QString()); }
+    void    _removeFileComplete         (const QString& errorMsg);
+    void    _createDirectoryCompleteNoError(void) { _createDirectoryComplete(QString()); }
+    void    _createDirectoryComplete    (const QString& errorMsg);
+    void    _calcFileCrc32CompleteNoError(void) { _calcFileCrc32Complete(QString()); }
+    void    _calcFileCrc32Complete      (const QString& errorMsg);
 
     void    _terminateSessionBegin      (void);
-    void    _terminateSessionAckOrNak   (const MavlinkFTP::Request* ackOrNak);
+    void    _terminateSessionAckOrNak   (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
     void    _terminateSessionTimeout    (void);
     void    _terminateComplete          (void);
+    void    _terminateUploadBegin       (void);
+    void    _terminateUploadAckOrNak    (const MavlinkFTP::Request* ackOrNak, const MavlinkFTP::Request* request);
+    void    _terminateUploadTimeout     (void);
+    void    _terminateUploadComplete    (void);
+
+    static bool _takeMissingChunk       (QList<MissingData_t>& rgMissingData, uint32_t& offset, uint8_t& size);
+
+    Vehicle*                            _vehicle;
+    DownloadState_t                     _downloadState;
+    UploadState_t                       _uploadState;
+    ListDirectoryState_t                _listDirectoryState;
+    CommandState_t                      _removeFileState;
+    CommandState_t                      _createDirectoryState;
+    CommandState_t                      _calcFileCrc32State;
+    QHash<uint16_t, PendingRequest_t>   _pendingRequests;           ///< Requests waiting for their response, by sequence number
+    QTimer                              _ackOrNakTimeoutTimer;
+    RttEstimator                        _rttEstimator;
+    uint16_t                            _nextSeqNumber              = 1;
+    int                                 _windowSize                 = defaultWindowSize;
+    int                                 _defaultTimeoutMSecs;       ///< Response timeout used until the first round trip has been measured
+    int                                 _minTimeoutMSecs;
+    int                                 _maxTimeoutMSecs;
 
-    Vehicle*                _vehicle;
-    uint8_t                 _ftpCompId = MAV_COMP_ID_AUTOPILOT1;
-    QList<StateFunctions_t> _rgStateMachine;
-    DownloadState_t         _downloadState;
-    ListDirectoryState_t    _listDirectoryState;
-    QTimer                  _ackOrNakTimeoutTimer;
-    int                     _currentStateMachineIndex   = -1;
-    uint16_t                _expectedIncomingSeqNumber  = 0;
-    
     static const int _ackOrNakTimeoutMsecs  = 1000;
     static const int _maxRetry              = 3;
+    static const int _maxDataRetry          = 10;   ///< Read and write requests of a transfer in progress may be resent more often
+    static const int _burstSeqNumberGap     = 1024; ///< Sequence numbers skipped after abandoning a burst, past packets still on their way
 };
-
@@ -18,6 +18,7 @@
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
 #include <QtCore/QSettings>
+#include <QtCore/QThread>
 #include <QtNetwork/QNetworkProxy>
 #include <QtNetwork/QNetworkReply>
 
@@ -98,6 +99,71 @@ void MAVLinkLogFiles::setUploaded(bool uploaded)
 
 /*===========================================================================*/
 
+MAVLinkLogWriter::MAVLinkLogWriter(QObject *parent)
+    : QObject(parent)
+    , _file(new QFile(this))
+{
+    // qCDebug(MAVLinkLogManagerLog) << Q_FUNC_INFO << this;
+}
+
+MAVLinkLogWriter::~MAVLinkLogWriter()
+{
+    // qCDebug(MAVLinkLogManagerLog) << Q_FUNC_INFO << this;
+}
+
+bool MAVLinkLogWriter::open(const QString &fileName)
+{
+    _file->setFileName(fileName);
+    // Unbuffered since we only ever write large blocks
+    return _file->open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
+
+bool MAVLinkLogWriter::push(QByteArray &buffer)
+{
+    const int head = _head.load(std::memory_order_relaxed);
+    const int next = (head + 1) % kQueueSize;
+    if (next == _tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    _queue[head].swap(buffer);
+    _head.store(next, std::memory_order_release);
+
+    (void) QMetaObject::invokeMethod(this, &MAVLinkLogWriter::drain, Qt::QueuedConnection);
+    return true;
+}
+
+int MAVLinkLogWriter::pendingCount() const
+{
+    const int head = _head.load(std::memory_order_acquire);
+    const int tail = _tail.load(std::memory_order_acquire);
+    return (head - tail + kQueueSize) % kQueueSize;
+}
+
+void MAVLinkLogWriter::drain()
+{
+    int tail = _tail.load(std::memory_order_relaxed);
+    while (tail != _head.load(std::memory_order_acquire)) {
+        QByteArray &buffer = _queue[tail];
+        if (!_error.load(std::memory_order_relaxed) && (_file->write(buffer) != buffer.size())) {
+            qCWarning(MAVLinkLogManagerLog) << "File IO error:" << _file->errorString() << _file->fileName();
+            _error.store(true, std::memory_order_relaxed);
+        }
+        buffer.clear();
+
+        tail = (tail + 1) % kQueueSize;
+        _tail.store(tail, std::memory_order_release);
+    }
+}
+
+void MAVLinkLogWriter::finish()
+{
+    drain();
+    _file->close();
+}
+
+/*===========================================================================*/
+
 MAVLinkLogProcessor::MAVLinkLogProcessor()
 {
     // qCDebug(MAVLinkLogManagerLog) << Q_FUNC_INFO << this;
@@ -112,9 +178,29 @@ MAVLinkLogProcessor::~MAVLinkLogProcessor()
 
 void MAVLinkLogProcessor::close()
 {
-    if (_file.isOpen()) {
-        _file.close();
+    if (!_writer) {
+        return;
     }
+
+    if (_numBacklogDrops > 0) {
+        qCWarning(MAVLinkLogManagerLog) << "Dropped" << _numBacklogDrops << "log packets because the writer could not keep up:" << _fileName;
+    }
+
+    // Hand over whatever is left, waiting on the writer if its queue is full
+    while (!_buffer.isEmpty() && !_writer->push(_buffer)) {
+        QThread::msleep(1);
+    }
+
+    (void) QMetaObject::invokeMethod(_writer, &MAVLinkLogWriter::finish, Qt::BlockingQueuedConnection);
+    _writerThread->quit();
+    if (!_writerThread->wait()) {
+        qCWarning(MAVLinkLogManagerLog) << "Failed to wait for log writer thread to close";
+    }
+
+    delete _writer;
+    _writer = nullptr;
+    delete _writerThread;
+    _writerThread = nullptr;
 }
 
 bool MAVLinkLogProcessor::create(MAVLinkLogManager *manager, QStringView path, uint8_t id)
@@ -127,12 +213,22 @@ bool MAVLinkLogProcessor::create(MAVLinkLogManager *manager, QStringView path, u
         manager->logExtension().toLocal8Bit().constData()
     );
 
-    _file.setFileName(_fileName);
-    if (!_file.open(QIODevice::WriteOnly)) {
-        qCWarning(MAVLinkLogManagerLog) << "Failed to open file for writing:" << _file.errorString();
+    MAVLinkLogWriter *const writer = new MAVLinkLogWriter();
+    if (!writer->open(_fileName)) {
+        qCWarning(MAVLinkLogManagerLog) << "Failed to open file for writing:" << writer->errorString();
+        delete writer;
         return false;
     }
 
+    _writer = writer;
+    _writerThread = new QThread();
+    _writerThread->setObjectName(QStringLiteral("MAVLinkLogWriter"));
+    _writer->moveToThread(_writerThread);
+    _writerThread->start();
+
+    _buffer.reserve(kWriteBufferSize);
+    _lastHandOff.start();
+
     _record = new MAVLinkLogFiles(manager, _fileName, true);
     _record->setWriting(true);
     _sequence = -1;
@@ -146,6 +242,7 @@ bool MAVLinkLogProcessor::_checkSequence(uint16_t seq, int &num_drops)
     //-- Check if a sequence is newer than the one previously received and if
     //   there were dropped messages between the last one and this.
     if (_sequence == -1) {
+        _updateDropStats(0);
         _sequence = seq;
         return true;
     }
@@ -163,6 +260,7 @@ bool MAVLinkLogProcessor::_checkSequence(uint16_t seq, int &num_drops)
         num_drops = seq - _sequence - 1;
         _numDrops += num_drops;
         _sequence = seq;
+        _updateDropStats(num_drops);
         return true;
     }
 
@@ -170,9 +268,53 @@ bool MAVLinkLogProcessor::_checkSequence(uint16_t seq, int &num_drops)
         num_drops = (1 << 16) - _sequence - 1 + seq;
         _numDrops += num_drops;
         _sequence = seq;
+        _updateDropStats(num_drops);
+        return true;
+    }
+
+    return false;
+}
+
+void MAVLinkLogProcessor::_updateDropStats(int num_drops)
+{
+    _windowPackets += 1 + num_drops;
+    _windowDrops += num_drops;
+    if (_windowPackets >= kDropWindowPackets) {
+        _dropRatio = static_cast<double>(_windowDrops) / _windowPackets;
+        if (_windowDrops > 0) {
+            qCDebug(MAVLinkLogManagerLog) << "Dropped" << _windowDrops << "of" << _windowPackets << "log packets, total drops:" << _numDrops;
+        }
+        _windowPackets = 0;
+        _windowDrops = 0;
+    }
+}
+
+bool MAVLinkLogProcessor::acceptAckedData() const
+{
+    if (!_writer) {
+        return true;
+    }
+
+    const int pending = _writer->pendingCount();
+    if (pending >= kAckHighWater) {
+        return false;
+    }
+
+    // Losing packets while the writer still has a backlog means we are the bottleneck
+    if ((pending > 0) && (_dropRatio > kDropRatioThreshold)) {
+        return false;
+    }
+
+    return true;
+}
+
+bool MAVLinkLogProcessor::acceptUnackedData()
+{
+    if (!_writer || (_buffer.size() < kWriteBufferSize) || !_writer->isFull()) {
         return true;
     }
 
+    _numBacklogDrops++;
     return false;
 }
 
@@ -182,12 +324,7 @@ void MAVLinkLogProcessor::_writeData(const void *data, int len)
         return;
     }
 
-    const qint64 bytesWritten = _file.write(reinterpret_cast<const char*>(data), len);
-    if (bytesWritten != len) {
-        _error = true;
-        qCDebug(MAVLinkLogManagerLog) << "File IO error:" << len << "bytes into" << _fileName;
-        return;
-    }
+    (void) _buffer.append(reinterpret_cast<const char*>(data), len);
 
     _written += len;
     if (_record) {
@@ -195,6 +332,23 @@ void MAVLinkLogProcessor::_writeData(const void *data, int len)
     }
 }
 
+void MAVLinkLogProcessor::_handOffBuffer(bool force)
+{
+    if (_buffer.isEmpty() || !_writer) {
+        return;
+    }
+
+    if (!force && (_buffer.size() < kWriteBufferSize) && (_lastHandOff.elapsed() < kMaxHandOffDelayMSecs)) {
+        return;
+    }
+
+    // If the writer queue is full the data stays in our buffer and goes out with the next hand off
+    if (_writer->push(_buffer)) {
+        _buffer.reserve(kWriteBufferSize);
+        _lastHandOff.start();
+    }
+}
+
 QByteArray MAVLinkLogProcessor::_writeUlogMessage(QByteArray &data)
 {
     // Write ulog data w/o integrity checking, assuming data starts with a
@@ -216,7 +370,10 @@ QByteArray MAVLinkLogProcessor::_writeUlogMessage(QByteArray &data)
 bool MAVLinkLogProcessor::processStreamData(uint16_t sequence, uint8_t first_message, const QByteArray &in)
 {
     int num_drops = 0;
-    _error = false;
+    _error = !_writer || _writer->error();
+    if (_error) {
+        return false;
+    }
 
     QByteArray data(in);
     while (_checkSequence(sequence, num_drops)) {
@@ -279,6 +436,8 @@ bool MAVLinkLogProcessor::processStreamData(uint16_t sequence, uint8_t first_mes
         break;
     }
 
+    _handOffBuffer(false);
+
     return !_error;
 }
 
@@ -805,14 +964,29 @@ void MAVLinkLogManager::_uploadProgress(qint64 bytesSent, qint64 bytesTotal)
     qCDebug(MAVLinkLogManagerLog) << bytesSent << "of" << bytesTotal;
 }
 
-void MAVLinkLogManager::_mavlinkLogData(Vehicle* /*vehicle*/, uint8_t /*target_system*/, uint8_t /*target_component*/, uint16_t sequence, uint8_t first_message, const QByteArray &data, bool /*acked*/)
+void MAVLinkLogManager::_mavlinkLogData(Vehicle* /*vehicle*/, uint8_t /*target_system*/, uint8_t /*target_component*/, uint16_t sequence, uint8_t first_message, const QByteArray &data, bool acked)
 {
     if (!_logProcessor || !_logProcessor->valid()) {
         qCDebug(MAVLinkLogManagerLog) << "MAVLink log data received when not expected.";
         return;
     }
 
+    if (acked && !_logProcessor->acceptAckedData()) {
+        // Not acking makes the vehicle resend the data later, which throttles the stream until we catch up
+        qCDebug(MAVLinkLogManagerLog) << "Deferring acked log data, writer backlog - sequence:" << sequence;
+        return;
+    }
+
+    if (!acked && !_logProcessor->acceptUnackedData()) {
+        qCDebug(MAVLinkLogManagerLog) << "Dropping log data, writer backlog - sequence:" << sequence << "total:" << _logProcessor->numBacklogDrops();
+        return;
+    }
+
     if (_logProcessor->processStreamData(sequence, first_message, data)) {
+        if (acked) {
+            // Also acks resends of data which we already have, in case our previous ack was lost
+            _vehicle->ackMavlinkLogData(sequence);
+        }
         return;
     }
 
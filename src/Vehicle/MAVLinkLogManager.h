@@ -10,16 +10,21 @@
 
 #pragma once
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QFile>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QObject>
 #include <QtNetwork/QHttpPart>
 #include <QtQmlIntegration/QtQmlIntegration>
 
+#include <array>
+#include <atomic>
+
 Q_DECLARE_LOGGING_CATEGORY(MAVLinkLogManagerLog)
 
 class QmlObjectListModel;
 class QNetworkAccessManager;
+class QThread;
 class MAVLinkLogManager;
 class Vehicle;
 
@@ -74,6 +79,49 @@ class MAVLinkLogFiles : public QObject
 
 /*===========================================================================*/
 
+/// Writes streamed log data to disk from its own thread. Filled buffers are handed over through a
+/// single producer/single consumer lock-free queue so the main thread never waits on file IO.
+class MAVLinkLogWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MAVLinkLogWriter(QObject *parent = nullptr);
+    ~MAVLinkLogWriter();
+
+    /// Must be called before the writer is moved to its thread
+    bool open(const QString &fileName);
+    QString errorString() const { return _file->errorString(); }
+
+    /// Producer side. Takes ownership of the buffer contents on success.
+    ///     @return false: Queue is full, buffer is left untouched
+    bool push(QByteArray &buffer);
+
+    /// @return Number of buffers waiting to be written
+    int pendingCount() const;
+    bool isFull() const { return (pendingCount() == (kQueueSize - 1)); }
+
+    bool error() const { return _error.load(std::memory_order_relaxed); }
+
+    static constexpr int kQueueSize = 16;
+
+public slots:
+    /// Writes all queued buffers
+    void drain();
+
+    /// Writes all queued buffers and closes the file
+    void finish();
+
+private:
+    QFile *_file = nullptr;
+    std::array<QByteArray, kQueueSize> _queue;
+    std::atomic<int> _head = 0;     ///< Next slot to fill, only written by producer
+    std::atomic<int> _tail = 0;     ///< Next slot to write, only written by consumer
+    std::atomic<bool> _error = false;
+};
+
+/*===========================================================================*/
+
 class MAVLinkLogProcessor
 {
 public:
@@ -81,29 +129,56 @@ class MAVLinkLogProcessor
     ~MAVLinkLogProcessor();
 
     void close();
-    bool valid() const { return ((_file.exists()) && (_record != nullptr)); }
+    bool valid() const { return ((_writer != nullptr) && (_record != nullptr)); }
     bool create(MAVLinkLogManager *manager, QStringView path, uint8_t id);
     MAVLinkLogFiles *record() { return _record; }
     QString fileName() const { return _fileName; }
     bool processStreamData(uint16_t _sequence, uint8_t first_message, const QByteArray &in);
 
+    /// Decides whether LOGGING_DATA_ACKED should be accepted (and acked) now or left for the vehicle to
+    /// resend. Refusing it throttles the vehicle when the writer is backed up or we are losing packets
+    /// because we can't keep up.
+    bool acceptAckedData() const;
+
+    /// Decides whether LOGGING_DATA, which the vehicle never resends, should be processed. Once the writer queue
+    /// is full and a whole write buffer is waiting on it, the data is dropped and counted. The sequence gap makes
+    /// the next packet resync the ULog stream the same way as a packet lost on the link.
+    bool acceptUnackedData();
+
+    int numDrops() const { return _numDrops; }
+    int numBacklogDrops() const { return _numBacklogDrops; }
+
 private:
     bool _checkSequence(uint16_t seq, int &num_drops);
+    void _updateDropStats(int num_drops);
     QByteArray _writeUlogMessage(QByteArray &data);
     void _writeData(const void* data, int len);
+    void _handOffBuffer(bool force);
 
     bool _error = false;
     bool _gotHeader = false;
     int _numDrops = 0;
+    int _numBacklogDrops = 0;       ///< Unacked packets dropped because the writer could not keep up
     int _sequence = -1;
+    int _windowPackets = 0;
+    int _windowDrops = 0;
+    double _dropRatio = 0;          ///< Ratio of dropped packets over the last completed window
     MAVLinkLogFiles *_record = nullptr;
     QByteArray _ulogMessage;
-    QFile _file;
+    QByteArray _buffer;             ///< Data waiting to be handed to the writer
+    QElapsedTimer _lastHandOff;
+    MAVLinkLogWriter *_writer = nullptr;
+    QThread *_writerThread = nullptr;
     QString _fileName;
     quint32 _written = 0;
 
     static constexpr int kUlogMessageHeader = 3;
     static constexpr int kSequenceSize = 1 << 15;
+    static constexpr int kWriteBufferSize = 256 * 1024;     ///< Multiple of the file system block size
+    static constexpr int kMaxHandOffDelayMSecs = 1000;
+    static constexpr int kAckHighWater = MAVLinkLogWriter::kQueueSize / 2;
+    static constexpr int kDropWindowPackets = 256;
+    static constexpr double kDropRatioThreshold = 0.05;
 };
 
 /*===========================================================================*/
@@ -10,45 +10,199 @@
 #include "TrajectoryPoints.h"
 #include "Vehicle.h"
 
+#include <QtCore/QtMath>
+
+#include <cmath>
+
 TrajectoryPoints::TrajectoryPoints(Vehicle* vehicle, QObject* parent)
     : QObject       (parent)
     , _vehicle      (vehicle)
-    , _lastAzimuth  (qQNaN())
 {
+    _points.reserve(_maxPoints + 1);
+}
+
+QVariantList TrajectoryPoints::list(void) const
+{
+    QVariantList points;
+    points.reserve(_points.count());
+    for (const Point &point : _points) {
+        points.append(QVariant::fromValue(_toCoordinate(point)));
+    }
+    return points;
+}
+
+void TrajectoryPoints::setMaxPoints(int maxPoints)
+{
+    // Compaction keeps both ends and needs room for at least one vertex in between
+    _maxPoints = qMax(maxPoints, 8);
+    _points.reserve(_maxPoints + 1);
+    if (_points.count() > _maxPoints) {
+        _compact();
+    }
+}
+
+void TrajectoryPoints::setTolerance(double meters)
+{
+    _tolerance = qMax(meters, 0.1);
 }
 
 void TrajectoryPoints::_vehicleCoordinateChanged(QGeoCoordinate coordinate)
 {
-    // The goal of this algorithm is to limit the number of trajectory points whic represent the vehicle path.
+    // The goal of this algorithm is to limit the number of trajectory points which represent the vehicle path.
     // Fewer points means higher performance of map display.
 
-    if (_lastPoint.isValid()) {
-        double distance = _lastPoint.distanceTo(coordinate);
-        if (distance > _distanceTolerance) {
-            //-- Update flight distance
+    if (_lastPosition.isValid()) {
+        const double distance = _lastPosition.distanceTo(coordinate);
+        if (distance <= _distanceTolerance) {
+            return;
+        }
+
+        //-- Update flight distance
+        if (_vehicle) {
             _vehicle->updateFlightDistance(distance);
-            // Vehicle has moved far enough from previous point for an update
-            double newAzimuth = _lastPoint.azimuthTo(coordinate);
-            if (qIsNaN(_lastAzimuth) || qAbs(newAzimuth - _lastAzimuth) > _azimuthTolerance) {
-                // The new position IS NOT colinear with the last segment. Append the new position to the list.
-                _lastAzimuth = _lastPoint.azimuthTo(coordinate);
-                _lastPoint = coordinate;
-                _points.append(QVariant::fromValue(coordinate));
-                emit pointAdded(coordinate);
-            } else {
-                // The new position IS colinear with the last segment. Don't add a new point, just update
-                // the last point to be the new position.
-                _lastPoint = coordinate;
-                _points[_points.count() - 1] = QVariant::fromValue(coordinate);
-                emit updateLastPoint(coordinate);
+        }
+    }
+
+    _lastPosition = coordinate;
+    _addPosition(Point{ coordinate.latitude(), coordinate.longitude(), static_cast<float>(_tolerance) });
+}
+
+void TrajectoryPoints::_addPosition(const Point &point)
+{
+    if (_floating && (_pending.count() < _maxPending) && _withinTolerance(_points.at(_points.count() - 2), point, _tolerance)) {
+        // Everything since the previous vertex is still represented by a single segment, just move its end
+        _pending.append(_points.last());
+        _points.last() = point;
+        emit updateLastPoint(_toCoordinate(point));
+        return;
+    }
+
+    // The floating end becomes a fixed vertex and a new segment starts from there
+    _pending.clear();
+    _points.append(point);
+    _floating = (_points.count() > 1);
+    emit pointAdded(_toCoordinate(point));
+
+    if (_points.count() > _maxPoints) {
+        _compact();
+    }
+}
+
+bool TrajectoryPoints::_withinTolerance(const Point &anchor, const Point &end, double tolerance) const
+{
+    if (_segmentDistance(_points.last(), anchor, end) > tolerance) {
+        return false;
+    }
+
+    for (const Point &point : _pending) {
+        if (_segmentDistance(point, anchor, end) > tolerance) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+double TrajectoryPoints::_segmentDistance(const Point &point, const Point &start, const Point &end)
+{
+    // Local flat projection around the segment start, plenty accurate for breadcrumb distances
+    constexpr double metersPerDegree = 111319.49;
+    const double lonScale = metersPerDegree * std::cos(qDegreesToRadians(start.latitude));
+
+    const auto deltaLongitude = [](double from, double to) {
+        double delta = to - from;
+        if (delta > 180.) {
+            delta -= 360.;
+        } else if (delta < -180.) {
+            delta += 360.;
+        }
+        return delta;
+    };
+
+    const double px = deltaLongitude(start.longitude, point.longitude) * lonScale;
+    const double py = (point.latitude - start.latitude) * metersPerDegree;
+    const double ex = deltaLongitude(start.longitude, end.longitude) * lonScale;
+    const double ey = (end.latitude - start.latitude) * metersPerDegree;
+
+    const double lengthSquared = (ex * ex) + (ey * ey);
+    double t = 0;
+    if (lengthSquared > 0) {
+        t = qBound(0., ((px * ex) + (py * ey)) / lengthSquared, 1.);
+    }
+
+    return std::hypot(px - (t * ex), py - (t * ey));
+}
+
+QList<TrajectoryPoints::Point> TrajectoryPoints::_simplify(const QList<Point> &points, double tolerance)
+{
+    // Error of the segment ending at each kept vertex, negative for vertices which are dropped
+    QList<float> segmentError(points.count(), -1.f);
+    segmentError.first() = 0.f;
+
+    QList<QPair<int, int>> ranges;
+    ranges.append(qMakePair(0, static_cast<int>(points.count() - 1)));
+
+    while (!ranges.isEmpty()) {
+        const QPair<int, int> range = ranges.takeLast();
+
+        double maxDistance = 0;
+        int maxIndex = -1;
+        float maxError = points.at(range.second).error;
+        for (int i = range.first + 1; i < range.second; i++) {
+            const double distance = _segmentDistance(points.at(i), points.at(range.first), points.at(range.second));
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                maxIndex = i;
             }
+            maxError = qMax(maxError, points.at(i).error);
+        }
+
+        if (maxDistance > tolerance) {
+            ranges.append(qMakePair(range.first, maxIndex));
+            ranges.append(qMakePair(maxIndex, range.second));
+        } else {
+            // A position was within its old segment's error of that segment, and every point of an old segment
+            // is within maxDistance of the new one
+            segmentError[range.second] = maxError + static_cast<float>(maxDistance);
+        }
+    }
+
+    QList<Point> simplified;
+    for (int i = 0; i < points.count(); i++) {
+        if (segmentError.at(i) >= 0) {
+            Point point = points.at(i);
+            point.error = segmentError.at(i);
+            simplified.append(point);
         }
-    } else {
-        // Add the very first trajectory point to the list
-        _lastPoint = coordinate;
-        _points.append(QVariant::fromValue(coordinate));
-        emit pointAdded(coordinate);
     }
+
+    return simplified;
+}
+
+void TrajectoryPoints::_compact(void)
+{
+    // Simplify with a coarser tolerance until there is room for new vertices again
+    const int target = (_maxPoints * 3) / 4;
+    double tolerance = qMax(_compactTolerance, _tolerance * 2);
+
+    QList<Point> simplified = _simplify(_points, tolerance);
+    while (simplified.count() > target) {
+        tolerance *= 1.5;
+        simplified = _simplify(_points, tolerance);
+    }
+
+    _compactTolerance = tolerance;
+    for (const Point &point : simplified) {
+        _maxSegmentError = qMax(_maxSegmentError, static_cast<double>(point.error));
+    }
+
+    _points = std::move(simplified);
+    _points.reserve(_maxPoints + 1);
+    _pending.clear();
+    // Moving the last vertex now would invalidate the simplification of the segments before it
+    _floating = false;
+
+    emit pathReplaced();
 }
 
 void TrajectoryPoints::start(void)
@@ -65,7 +219,10 @@ void TrajectoryPoints::stop(void)
 void TrajectoryPoints::clear(void)
 {
     _points.clear();
-    _lastPoint = QGeoCoordinate();
-    _lastAzimuth = qQNaN();
+    _pending.clear();
+    _floating = false;
+    _lastPosition = QGeoCoordinate();
+    _compactTolerance = 0;
+    _maxSegmentError = 0;
     emit pointsCleared();
 }
@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <QtCore/QList>
 #include <QtCore/QObject>
 #include <QtCore/QVariantList>
 #include <QtPositioning/QGeoCoordinate>
@@ -16,19 +17,40 @@
 
 class Vehicle;
 
+/// Breadcrumb trail of the vehicle for the map.
+///
+/// Positions are simplified while they arrive: the last point keeps moving as long as every position since the
+/// previous vertex stays within tolerance() of the segment, otherwise a new vertex is started. This is Douglas-Peucker
+/// applied online, so straight legs collapse to two points while turns and orbits keep their shape. The number of
+/// vertices is capped by maxPoints(). When the cap is reached the whole trail is simplified again with a coarser
+/// tolerance, which is signalled through pathReplaced().
 class TrajectoryPoints : public QObject
 {
     Q_OBJECT
     QML_ELEMENT
     QML_UNCREATABLE("")
+
+    friend class TrajectoryPointsTest;
+
 public:
     TrajectoryPoints(Vehicle* vehicle, QObject* parent = nullptr);
 
-    Q_INVOKABLE QVariantList list(void) const { return _points; }
+    Q_INVOKABLE QVariantList list(void) const;
 
     void start  (void);
     void stop   (void);
 
+    int     count       (void) const { return _points.count(); }
+    int     maxPoints   (void) const { return _maxPoints; }
+    void    setMaxPoints(int maxPoints);
+    double  tolerance   (void) const { return _tolerance; }
+    void    setTolerance(double meters);
+
+    /// Upper bound for the distance between any reported position and the trail, in meters
+    double  errorBound  (void) const { return _distanceTolerance + qMax(_tolerance, _maxSegmentError); }
+
+    static constexpr int kDefaultMaxPoints = 5000;
+
 public slots:
     void clear  (void);
 
@@ -36,16 +58,37 @@ public slots:
     void pointAdded     (QGeoCoordinate coordinate);
     void updateLastPoint(QGeoCoordinate coordinate);
     void pointsCleared  (void);
+    /// The trail was simplified again, list() has to be read again
+    void pathReplaced   (void);
 
 private slots:
     void _vehicleCoordinateChanged(QGeoCoordinate coordinate);
 
 private:
+    struct Point {
+        double latitude;
+        double longitude;
+        float  error = 0;   ///< Bound for the distance of the positions represented by the segment ending here
+    };
+
+    void    _addPosition    (const Point &point);
+    bool    _withinTolerance(const Point &anchor, const Point &end, double tolerance) const;
+    void    _compact        (void);
+    /// Douglas-Peucker over all vertices, the error of the merged segments is carried over
+    static QList<Point> _simplify(const QList<Point> &points, double tolerance);
+    static double _segmentDistance(const Point &point, const Point &start, const Point &end);
+    static QGeoCoordinate _toCoordinate(const Point &point) { return QGeoCoordinate(point.latitude, point.longitude); }
+
     Vehicle*        _vehicle;
-    QVariantList    _points;
-    QGeoCoordinate  _lastPoint;
-    double          _lastAzimuth;
+    QList<Point>    _points;            ///< Vertices, the last one moves while it is floating
+    QList<Point>    _pending;           ///< Positions covered by the floating segment
+    bool            _floating = false;  ///< Last vertex still moves with the vehicle
+    QGeoCoordinate  _lastPosition;      ///< Last position which moved far enough, for flight distance
+    int             _maxPoints = kDefaultMaxPoints;
+    double          _tolerance = _distanceTolerance;
+    double          _compactTolerance = 0;  ///< Tolerance of the last compaction
+    double          _maxSegmentError = 0;   ///< Largest error of a segment after compaction
 
-    static constexpr double _distanceTolerance = 2.0;
-    static constexpr double _azimuthTolerance = 1.5;
+    static constexpr double _distanceTolerance = 2.0;   ///< Positions closer than this to the previous one are ignored
+    static constexpr int    _maxPending = 1000;         ///< Longest run of positions a single segment may cover
 };
@@ -158,10 +158,8 @@ Vehicle::Vehicle(LinkInterface*             link,
     _prearmErrorTimer.setInterval(_prearmErrorTimeoutMSecs);
     _prearmErrorTimer.setSingleShot(true);
 
-    // Send MAV_CMD ack timer
-    _mavCommandResponseCheckTimer.setSingleShot(false);
-    _mavCommandResponseCheckTimer.setInterval(_mavCommandResponseCheckTimeoutMSecs);
-    _mavCommandResponseCheckTimer.start();
+    // Send MAV_CMD ack timer. Only runs while commands are waiting for an ack.
+    _mavCommandResponseCheckTimer.setSingleShot(true);
     connect(&_mavCommandResponseCheckTimer, &QTimer::timeout, this, &Vehicle::_sendMavCommandResponseTimeoutCheck);
 
     // MAV_TYPE_GENERIC is used by unit test for creating a vehicle which doesn't do the connect sequence. This
@@ -2608,6 +2606,30 @@ bool Vehicle::_sendMavCommandShouldRetry(MAV_CMD command)
     }
 }
 
+/// Only requests which the vehicle answers right away are timed from the link rtt, and only their response times are
+/// fed into the rtt estimate. Other commands ack after executing, which can take seconds, so they keep the fixed timeout.
+bool Vehicle::_mavCommandUsesRttTimeout(MAV_CMD command)
+{
+    switch (command) {
+#ifdef QT_DEBUG
+    case MockLink::MAV_CMD_MOCKLINK_ALWAYS_RESULT_ACCEPTED:
+    case MockLink::MAV_CMD_MOCKLINK_ALWAYS_RESULT_FAILED:
+    case MockLink::MAV_CMD_MOCKLINK_SECOND_ATTEMPT_RESULT_ACCEPTED:
+    case MockLink::MAV_CMD_MOCKLINK_SECOND_ATTEMPT_RESULT_FAILED:
+    case MockLink::MAV_CMD_MOCKLINK_NO_RESPONSE:
+    case MockLink::MAV_CMD_MOCKLINK_RESULT_IN_PROGRESS_NO_ACK:
+        return true;
+#endif
+    case MAV_CMD_REQUEST_AUTOPILOT_CAPABILITIES:
+    case MAV_CMD_REQUEST_PROTOCOL_VERSION:
+    case MAV_CMD_REQUEST_MESSAGE:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
 bool Vehicle::_commandCanBeDuplicated(MAV_CMD command)
 {
     // For some commands we don't care about response as much as we care about sending them regularly.
@@ -2682,13 +2704,15 @@ void Vehicle::_sendMavCommandWorker(
     entry.rgParam6          = param6;
     entry.rgParam7          = param7;
     entry.maxTries          = _sendMavCommandShouldRetry(command) ? _mavCommandMaxRetryCount : 1;
-    entry.ackTimeoutMSecs   = sharedLink->linkConfiguration()->isHighLatency() ? _mavCommandAckTimeoutMSecsHighLatency : _mavCommandAckTimeoutMSecs;
     entry.elapsedTimer.start();
 
     qCDebug(VehicleLog) << Q_FUNC_INFO << "command:param1-7" << command << param1 << param2 << param3 << param4 << param5 << param6 << param7;
 
+    _mavCommandLatencyStats[command].sendCount++;
+
     _mavCommandList.append(entry);
     _sendMavCommandFromList(_mavCommandList.count() - 1);
+    _armMavCommandResponseCheckTimer();
 }
 
 void Vehicle::_sendMavCommandFromList(int index)
@@ -2700,6 +2724,7 @@ void Vehicle::_sendMavCommandFromList(int index)
 
     if (++_mavCommandList[index].tryCount > commandEntry.maxTries) {
         qCDebug(VehicleLog) << Q_FUNC_INFO << "giving up after max retries" << rawCommandName;
+        _mavCommandLatencyStats[commandEntry.command].noResponseCount++;
         _mavCommandList.removeAt(index);
         if (commandEntry.ackHandlerInfo.resultHandler) {
             mavlink_command_ack_t ack = {};
@@ -2714,15 +2739,32 @@ void Vehicle::_sendMavCommandFromList(int index)
         return;
     }
 
+    SharedLinkInterfacePtr sharedLink = vehicleLinkManager()->primaryLink().lock();
+
+    // Each try gets a fresh deadline based on the round trip time of the link it goes out on, backing off for each retry
+    MavCommandListEntry_t& commandEntryRef = _mavCommandList[index];
+    commandEntryRef.link = sharedLink;
+    if (sharedLink && sharedLink->linkConfiguration()->isHighLatency()) {
+        commandEntryRef.ackTimeoutMSecs = _mavCommandAckTimeoutMSecsHighLatency;
+    } else if (sharedLink && _mavCommandUsesRttTimeout(commandEntryRef.command)) {
+        commandEntryRef.ackTimeoutMSecs = sharedLink->commandRttEstimator().backoffTimeoutMSecs(commandEntryRef.tryCount, _mavCommandAckTimeoutMSecs, _mavCommandAckTimeoutMinMSecs, _mavCommandAckTimeoutMaxMSecs);
+    } else {
+        commandEntryRef.ackTimeoutMSecs = _mavCommandAckTimeoutMSecs;
+    }
+    commandEntryRef.elapsedTimer.start();
+    if (commandEntryRef.tryCount > 1) {
+        _mavCommandLatencyStats[commandEntryRef.command].retryCount++;
+    }
+    commandEntry = commandEntryRef;
+
     if (commandEntry.tryCount > 1 && !px4Firmware() && commandEntry.command == MAV_CMD_START_RX_PAIR) {
         // The implementation of this command comes from the IO layer and is shared across stacks. So for other firmwares
         // we aren't really sure whether they are correct or not.
         return;
     }
 
-    qCDebug(VehicleLog) << Q_FUNC_INFO << "command:tryCount:param1-7" << rawCommandName << commandEntry.tryCount << commandEntry.rgParam1 << commandEntry.rgParam2 << commandEntry.rgParam3 << commandEntry.rgParam4 << commandEntry.rgParam5 << commandEntry.rgParam6 << commandEntry.rgParam7;
+    qCDebug(VehicleLog) << Q_FUNC_INFO << "command:tryCount:ackTimeout:param1-7" << rawCommandName << commandEntry.tryCount << commandEntry.ackTimeoutMSecs << commandEntry.rgParam1 << commandEntry.rgParam2 << commandEntry.rgParam3 << commandEntry.rgParam4 << commandEntry.rgParam5 << commandEntry.rgParam6 << commandEntry.rgParam7;
 
-    SharedLinkInterfacePtr sharedLink = vehicleLinkManager()->primaryLink().lock();
     if (!sharedLink) {
         qCDebug(VehicleLog) << "_sendMavCommandFromList: primary link gone!";
         return;
@@ -2777,18 +2819,94 @@ void Vehicle::_sendMavCommandFromList(int index)
 
 void Vehicle::_sendMavCommandResponseTimeoutCheck(void)
 {
-    if (_mavCommandList.isEmpty()) {
-        return;
-    }
-
     // Walk the list backwards since _sendMavCommandFromList can remove entries
     for (int i=_mavCommandList.count()-1; i>=0; i--) {
         MavCommandListEntry_t& commandEntry = _mavCommandList[i];
-        if (commandEntry.elapsedTimer.elapsed() > commandEntry.ackTimeoutMSecs) {
+        if (commandEntry.elapsedTimer.elapsed() >= commandEntry.ackTimeoutMSecs) {
             // Try sending command again
             _sendMavCommandFromList(i);
         }
     }
+
+    _armMavCommandResponseCheckTimer();
+}
+
+/// Arms the response check timer for the earliest ack deadline. The timer is left stopped while there is nothing to wait for.
+/// Entries removed in the meantime just lead to a harmless early wakeup which re-arms the timer.
+void Vehicle::_armMavCommandResponseCheckTimer()
+{
+    if (_mavCommandList.isEmpty()) {
+        _mavCommandResponseCheckTimer.stop();
+        return;
+    }
+
+    qint64 nextDeadlineMSecs = std::numeric_limits<qint64>::max();
+    for (const MavCommandListEntry_t& commandEntry: _mavCommandList) {
+        nextDeadlineMSecs = qMin(nextDeadlineMSecs, commandEntry.ackTimeoutMSecs - commandEntry.elapsedTimer.elapsed());
+    }
+
+    _mavCommandResponseCheckTimer.start(static_cast<int>(qMax<qint64>(nextDeadlineMSecs, 0)));
+}
+
+/// Feeds the response time of a command into the rtt estimate of the link it was sent on. Retried commands are not
+/// sampled since we can't tell which transmission the response belongs to.
+void Vehicle::_recordMavCommandResponseTime(MavCommandListEntry_t& commandEntry)
+{
+    if (commandEntry.rttSampled || (commandEntry.tryCount != 1)) {
+        return;
+    }
+    commandEntry.rttSampled = true;
+
+    const qint64 responseMSecs = commandEntry.elapsedTimer.elapsed();
+
+    MavCommandLatencyStats_t& stats = _mavCommandLatencyStats[commandEntry.command];
+    stats.minMSecs = (stats.sampleCount == 0) ? responseMSecs : qMin(stats.minMSecs, responseMSecs);
+    stats.maxMSecs = qMax(stats.maxMSecs, responseMSecs);
+    stats.totalMSecs += responseMSecs;
+    stats.sampleCount++;
+
+    SharedLinkInterfacePtr sharedLink = commandEntry.link.lock();
+    if (sharedLink && !sharedLink->linkConfiguration()->isHighLatency() && _mavCommandUsesRttTimeout(commandEntry.command)) {
+        RttEstimator& estimator = sharedLink->commandRttEstimator();
+        estimator.addSample(responseMSecs);
+        qCDebug(VehicleLog) << Q_FUNC_INFO << MissionCommandTree::instance()->rawName(commandEntry.command) << "rtt:srtt:rttvar:rto" << responseMSecs << estimator.srttMSecs() << estimator.rttVarMSecs()
+                            << estimator.timeoutMSecs(_mavCommandAckTimeoutMSecs, _mavCommandAckTimeoutMinMSecs, _mavCommandAckTimeoutMaxMSecs);
+    }
+}
+
+QVariantMap Vehicle::mavCommandLatencyStats() const
+{
+    QVariantMap result;
+
+    QVariantList commands;
+    for (auto it = _mavCommandLatencyStats.constBegin(); it != _mavCommandLatencyStats.constEnd(); ++it) {
+        const MavCommandLatencyStats_t& stats = it.value();
+
+        QVariantMap command;
+        command[QStringLiteral("command")]          = MissionCommandTree::instance()->rawName(static_cast<MAV_CMD>(it.key()));
+        command[QStringLiteral("sendCount")]        = stats.sendCount;
+        command[QStringLiteral("retryCount")]       = stats.retryCount;
+        command[QStringLiteral("noResponseCount")]  = stats.noResponseCount;
+        command[QStringLiteral("sampleCount")]      = stats.sampleCount;
+        command[QStringLiteral("minMSecs")]         = stats.minMSecs;
+        command[QStringLiteral("maxMSecs")]         = stats.maxMSecs;
+        command[QStringLiteral("avgMSecs")]         = (stats.sampleCount > 0) ? (static_cast<double>(stats.totalMSecs) / stats.sampleCount) : 0.0;
+        commands.append(command);
+    }
+    result[QStringLiteral("commands")] = commands;
+
+    SharedLinkInterfacePtr sharedLink = _vehicleLinkManager->primaryLink().lock();
+    if (sharedLink) {
+        const RttEstimator& estimator = sharedLink->commandRttEstimator();
+        result[QStringLiteral("linkSampleCount")]   = estimator.sampleCount();
+        result[QStringLiteral("linkSrttMSecs")]     = estimator.srttMSecs();
+        result[QStringLiteral("linkRttVarMSecs")]   = estimator.rttVarMSecs();
+        result[QStringLiteral("linkAckTimeoutMSecs")] = sharedLink->linkConfiguration()->isHighLatency() ?
+                    _mavCommandAckTimeoutMSecsHighLatency :
+                    estimator.timeoutMSecs(_mavCommandAckTimeoutMSecs, _mavCommandAckTimeoutMinMSecs, _mavCommandAckTimeoutMaxMSecs);
+    }
+
+    return result;
 }
 
 void Vehicle::showCommandAckError(const mavlink_command_ack_t& ack)
@@ -2849,6 +2967,8 @@ void Vehicle::_handleCommandAck(mavlink_message_t& message)
 
     int entryIndex = _findMavCommandListEntryIndex(message.compid, static_cast<MAV_CMD>(ack.command));
     if (entryIndex != -1) {
+        _recordMavCommandResponseTime(_mavCommandList[entryIndex]);
+
         if (ack.result == MAV_RESULT_IN_PROGRESS) {
             MavCommandListEntry_t commandEntry;
             if (px4Firmware() && ack.command == MAV_CMD_DO_AUTOTUNE_ENABLE) {
@@ -2859,7 +2979,12 @@ void Vehicle::_handleCommandAck(mavlink_message_t& message)
                 MavCommandListEntry_t& commandEntryRef = _mavCommandList[entryIndex];
                 commandEntryRef.maxTries = 1;         // Vehicle responsed to command so don't retry
                 commandEntryRef.elapsedTimer.start(); // We've heard from vehicle, restart elapsed timer for no ack received timeout
+                if (commandEntryRef.ackTimeoutMSecs < _mavCommandAckTimeoutMSecs) {
+                    // Time to completion depends on the vehicle, not the link, so don't use the rtt based timeout
+                    commandEntryRef.ackTimeoutMSecs = _mavCommandAckTimeoutMSecs;
+                }
                 commandEntry = commandEntryRef;
+                _armMavCommandResponseCheckTimer();
             }
 
             if (commandEntry.ackHandlerInfo.progressHandler) {
@@ -2911,6 +3036,8 @@ void Vehicle::_waitForMavlinkMessageMessageReceivedHandler(const mavlink_message
             qCDebug(VehicleLog) << Q_FUNC_INFO << "message received before ack came back.";
             int entryIndex = _findMavCommandListEntryIndex(message.compid, MAV_CMD_REQUEST_MESSAGE);
             if (entryIndex != -1) {
+                // The requested message is the response, use it as the rtt sample
+                _recordMavCommandResponseTime(_mavCommandList[entryIndex]);
                 _mavCommandList.takeAt(entryIndex);
             } else {
                 qWarning() << Q_FUNC_INFO << "Removing request message command from list failed - not found in list";
@@ -3251,11 +3378,11 @@ void Vehicle::stopMavlinkLog()
     sendMavCommand(_defaultComponentId, MAV_CMD_LOGGING_STOP, false /* showError */);
 }
 
-void Vehicle::_ackMavlinkLogData(uint16_t sequence)
+void Vehicle::ackMavlinkLogData(uint16_t sequence)
 {
     SharedLinkInterfacePtr  sharedLink = vehicleLinkManager()->primaryLink().lock();
     if (!sharedLink) {
-        qCDebug(VehicleLog) << "_ackMavlinkLogData: primary link gone!";
+        qCDebug(VehicleLog) << "ackMavlinkLogData: primary link gone!";
         return;
     }
 
@@ -3291,12 +3418,22 @@ void Vehicle::_handleMavlinkLoggingDataAcked(mavlink_message_t& message)
 {
     mavlink_logging_data_acked_t log;
     mavlink_msg_logging_data_acked_decode(&message, &log);
-    _ackMavlinkLogData(log.sequence);
+
+    // While a log is being written the log manager acks once the data has been accepted. That allows it to
+    // apply backpressure to the vehicle.
+    const bool managerAcks = _mavlinkLogManager && _mavlinkLogManager->logRunning();
+    if (!managerAcks) {
+        ackMavlinkLogData(log.sequence);
+    }
+
     if (static_cast<size_t>(log.length) > sizeof(log.data)) {
         qWarning() << "Invalid length for LOGGING_DATA_ACKED, discarding." << log.length;
+        if (managerAcks) {
+            ackMavlinkLogData(log.sequence);
+        }
     } else {
         emit mavlinkLogData(this, log.target_system, log.target_component, log.sequence,
-                            log.first_message_offset, QByteArray((const char*)log.data, log.length), false);
+                            log.first_message_offset, QByteArray((const char*)log.data, log.length), managerAcks);
     }
 }
 
@@ -16,6 +16,7 @@
 #include <QtCore/QTime>
 #include <QtCore/QTimer>
 #include <QtCore/QVariantList>
+#include <QtCore/QVariantMap>
 #include <QtPositioning/QGeoCoordinate>
 #include <QtQmlIntegration/QtQmlIntegration>
 
@@ -108,6 +109,7 @@ class Vehicle : public VehicleFactGroup
     friend class SendMavCommandWithSignallingTest;  // Unit test
     friend class SendMavCommandWithHandlerTest;     // Unit test
     friend class RequestMessageTest;                // Unit test
+    friend class MavCommandRetryTest;               // Unit test
     friend class GimbalController;                  // Allow GimbalController to call _addFactGroup
 
 public:
@@ -418,6 +420,9 @@ class Vehicle : public VehicleFactGroup
 
     Q_INVOKABLE QVariant expandedToolbarIndicatorSource(const QString& indicatorName);
 
+    /// Returns per command response time statistics plus the current rtt estimate of the primary link. Used for tuning command timeouts.
+    Q_INVOKABLE QVariantMap mavCommandLatencyStats() const;
+
     bool    isInitialConnectComplete() const;
     bool    guidedModeSupported     () const;
     bool    pauseVehicleSupported   () const;
@@ -510,6 +515,9 @@ class Vehicle : public VehicleFactGroup
     void startMavlinkLog();
     void stopMavlinkLog();
 
+    /// Sends LOGGING_ACK for LOGGING_DATA_ACKED. While a log is running this is left to MAVLinkLogManager.
+    void ackMavlinkLogData(uint16_t sequence);
+
     /// Requests the specified data stream from the vehicle
     ///     @param stream Stream which is being requested
     ///     @param rate Rate at which to send stream in Hz
@@ -978,7 +986,6 @@ private slots:
     QString _vehicleIdSpeech            ();
     void _handleMavlinkLoggingData      (mavlink_message_t& message);
     void _handleMavlinkLoggingDataAcked (mavlink_message_t& message);
-    void _ackMavlinkLogData             (uint16_t sequence);
     void _commonInit                    (LinkInterface* link);
     void _setupAutoDisarmSignalling     ();
     void _setCapabilities               (uint64_t capabilityBits);
@@ -1195,15 +1202,29 @@ private slots:
         MavCmdAckHandlerInfo_t  ackHandlerInfo;
         int                     maxTries            = _mavCommandMaxRetryCount;
         int                     tryCount            = 0;
-        QElapsedTimer           elapsedTimer;
+        QElapsedTimer           elapsedTimer;                                   ///< Restarted on each transmission
         int                     ackTimeoutMSecs     = _mavCommandAckTimeoutMSecs;
+        WeakLinkInterfacePtr    link;                                           ///< Link the command was last sent on, owner of the rtt estimate
+        bool                    rttSampled          = false;                    ///< true: Response time has already been recorded
     } MavCommandListEntry_t;
 
+    typedef struct MavCommandLatencyStats {
+        int     sendCount       = 0;    ///< Number of commands sent (not counting retries)
+        int     retryCount      = 0;
+        int     noResponseCount = 0;    ///< Number of commands which failed after exhausting all retries
+        int     sampleCount     = 0;    ///< Number of response time samples (first try responses only)
+        qint64  minMSecs        = 0;
+        qint64  maxMSecs        = 0;
+        qint64  totalMSecs      = 0;
+    } MavCommandLatencyStats_t;
+
     QList<MavCommandListEntry_t>    _mavCommandList;
-    QTimer                          _mavCommandResponseCheckTimer;
+    QTimer                          _mavCommandResponseCheckTimer;              ///< Single shot, armed for the earliest pending ack deadline
+    QMap<int /* MAV_CMD */, MavCommandLatencyStats_t> _mavCommandLatencyStats;
     static const int                _mavCommandMaxRetryCount                = 3;
-    static const int                _mavCommandResponseCheckTimeoutMSecs    = 500;
-    static const int                _mavCommandAckTimeoutMSecs              = 3000;
+    static const int                _mavCommandAckTimeoutMSecs              = 3000;     ///< Used until a link has an rtt estimate, while commands are in progress and for commands which execute before acking
+    static const int                _mavCommandAckTimeoutMinMSecs           = 300;
+    static const int                _mavCommandAckTimeoutMaxMSecs           = _mavCommandAckTimeoutMSecs;  ///< Keeps each try, and so all tries together, within the fixed timeout budget
     static const int                _mavCommandAckTimeoutMSecsHighLatency   = 120000;
 
     void _sendMavCommandWorker  (
@@ -1212,8 +1233,11 @@ private slots:
             int compId, MAV_CMD command, MAV_FRAME frame, 
             float param1, float param2, float param3, float param4, double param5, double param6, float param7);
     void _sendMavCommandFromList(int index);
+    void _armMavCommandResponseCheckTimer();
+    void _recordMavCommandResponseTime(MavCommandListEntry_t& commandEntry);
     int  _findMavCommandListEntryIndex(int targetCompId, MAV_CMD command);
     bool _sendMavCommandShouldRetry(MAV_CMD command);
+    bool _mavCommandUsesRttTimeout(MAV_CMD command);
     bool _commandCanBeDuplicated(MAV_CMD command);
 
     QMap<uint8_t /* batteryId */, uint8_t /* MAV_BATTERY_CHARGE_STATE_OK */> _lowestBatteryChargeStateAnnouncedMap;
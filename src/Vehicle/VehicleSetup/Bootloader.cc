@@ -12,8 +12,10 @@
 #include "FirmwareImage.h"
 #include "QGC.h"
 
+#include <QtCore/QDeadlineTimer>
 #include <QtCore/QElapsedTimer>
 #include <QtCore/QFile>
+#include <QtCore/QQueue>
 #include <QtCore/QThread>
 
 QGC_LOGGING_CATEGORY(FirmwareUpgradeLog, "VehicleSetup.FirmwareUpgrade")
@@ -47,9 +49,29 @@ bool Bootloader::open(const QString portName)
         // Radios are slow to start up
         QThread::msleep(1000);
     }
+    _device = &_port;
     return true;
 }
 
+bool Bootloader::open(QIODevice* device)
+{
+    if (!device || !device->isOpen()) {
+        _errorString = tr("Open failed: device not open");
+        return false;
+    }
+
+    _device = device;
+    return true;
+}
+
+void Bootloader::close(void)
+{
+    if (_device == &_port) {
+        _port.close();
+    }
+    _device = &_port;
+}
+
 QString Bootloader::_getNextLine(int timeoutMsecs)
 {
     QString         line;
@@ -59,8 +81,8 @@ QString Bootloader::_getNextLine(int timeoutMsecs)
     timeout.start();
     while (timeout.elapsed() < timeoutMsecs) {
         char oneChar;
-        _port.waitForReadyRead(100);
-        if (_port.read(&oneChar, 1) > 0) {
+        _device->waitForReadyRead(100);
+        if (_device->read(&oneChar, 1) > 0) {
             if (oneChar == '\r') {
                 foundCR = true;
                 continue;
@@ -86,15 +108,15 @@ bool Bootloader::getBoardInfo(uint32_t& bootloaderVersion, uint32_t& boardID, ui
             }
         } else {
             qCDebug(FirmwareUpgradeLog) << "Radio in normal mode";
-            _port.readAll();
+            _device->readAll();
             _port.setBaudRate(QSerialPort::Baud57600);
             // Put radio into command mode
             _write("+++");
-            if (!_port.waitForReadyRead(2000)) {
+            if (!_device->waitForReadyRead(2000)) {
                 _errorString = tr("Unable to put radio into command mode +++");
                 goto Error;
             }
-            QByteArray bytes = _port.readAll();
+            QByteArray bytes = _device->readAll();
             if (!bytes.contains("OK")) {
                 _errorString = tr("Radio did not respond to command mode");
                 goto Error;
@@ -163,7 +185,7 @@ bool Bootloader::initFlashSequence(void)
 {
     if (_sikRadio && !_inBootloaderMode) {
         _write("AT&UPDATE\r\n");
-        if (!_port.waitForReadyRead(1500)) {
+        if (!_device->waitForReadyRead(1500)) {
             _errorString = tr("Unable to reboot radio (ready read)");
             return false;
         }
@@ -209,14 +231,16 @@ bool Bootloader::reboot(void)
     bool success;
     if (_sikRadio && !_inBootloaderMode) {
         qCDebug(FirmwareUpgradeLog) << "reboot ATZ";
-        _port.readAll();
+        _device->readAll();
         success = _write("ATZ\r\n");
     } else {
         qCDebug(FirmwareUpgradeLog) << "reboot";
-        success = _write(PROTO_BOOT) && _write(PROTO_EOC);
+        const uint8_t buf[2] = { PROTO_BOOT, PROTO_EOC };
+        success = _write(buf, sizeof(buf));
     }
-    _port.flush();
-    if (success) {
+    _flush();
+    // Give the board time to drop off the bus, an emulated device goes away immediately
+    if (success && (_device == &_port)) {
         QThread::msleep(1000);
     }
     return success;
@@ -227,11 +251,16 @@ bool Bootloader::_write(const char* data)
     return _write((uint8_t*)data, qstrlen(data));
 }
 
+bool Bootloader::_write(const QByteArray& data)
+{
+    return _write((const uint8_t*)data.constData(), data.size());
+}
+
 bool Bootloader::_write(const uint8_t* data, qint64 maxSize)
 {
-    qint64 bytesWritten = _port.write((const char*)data, maxSize);
+    qint64 bytesWritten = _device->write((const char*)data, maxSize);
     if (bytesWritten == -1) {
-        _errorString = tr("Write failed: %1").arg(_port.errorString());
+        _errorString = tr("Write failed: %1").arg(_device->errorString());
         qWarning() << _errorString;
         return false;
     }
@@ -244,30 +273,33 @@ bool Bootloader::_write(const uint8_t* data, qint64 maxSize)
     return true;
 }
 
-bool Bootloader::_write(const uint8_t byte)
+void Bootloader::_flush(void)
 {
-    uint8_t buf[1] = { byte };
-    return _write(buf, 1);
+    if (_device == &_port) {
+        _port.flush();
+    }
 }
 
 bool Bootloader::_read(uint8_t* data, qint64 cBytesExpected, int readTimeout)
 {
-    QElapsedTimer timeout;
+    const QDeadlineTimer deadline(readTimeout);
 
-    timeout.start();
-    while (_port.bytesAvailable() < cBytesExpected) {
-        if (timeout.elapsed() > readTimeout) {
+    // Sleep until the device reports new data instead of polling bytesAvailable
+    while (_device->bytesAvailable() < cBytesExpected) {
+        if (deadline.hasExpired() || !_device->waitForReadyRead(static_cast<int>(deadline.remainingTime()))) {
+            if (_device->bytesAvailable() >= cBytesExpected) {
+                break;
+            }
             _errorString = tr("Timeout waiting for bytes to be available");
             return false;
         }
-        _port.waitForReadyRead(100);
     }
 
     qint64 bytesRead;
-    bytesRead = _port.read((char *)data, cBytesExpected);
+    bytesRead = _device->read((char *)data, cBytesExpected);
 
     if (bytesRead != cBytesExpected) {
-        _errorString = tr("Read failed: error: %1").arg(_port.errorString());
+        _errorString = tr("Read failed: error: %1").arg(_device->errorString());
         return false;
     }
 
@@ -340,7 +372,7 @@ bool Bootloader::_sendCommand(const uint8_t cmd, int responseTimeout)
     if (!_write(buf, 2)) {
         goto Error;
     }
-    _port.flush();
+    _flush();
 
     if (!_getCommandResponse(responseTimeout)) {
         goto Error;
@@ -364,54 +396,74 @@ bool Bootloader::_binProgram(const FirmwareImage* image)
     
     uint8_t imageBuf[PROG_MULTI_MAX];
     uint32_t bytesSent = 0;
+    uint32_t bytesAcked = 0;
     _imageCRC = 0;
+
+    // Address and size of each chunk which was sent but not acknowledged yet
+    QQueue<QPair<uint32_t, int>> chunksInFlight;
+
+    // Opcode, length, payload and EOC go out in a single write
+    QByteArray frame;
+    frame.reserve(PROG_MULTI_MAX + 3);
     
     Q_ASSERT(PROG_MULTI_MAX <= 0x8F);
     
-    while (bytesSent < imageSize) {
-        int bytesToSend = imageSize - bytesSent;
-        if (bytesToSend > (int)sizeof(imageBuf)) {
-            bytesToSend = (int)sizeof(imageBuf);
-        }
-        
-        Q_ASSERT((bytesToSend % 4) == 0);
-        
-        int bytesRead = firmwareFile.read((char *)imageBuf, bytesToSend);
-        if (bytesRead == -1 || bytesRead != bytesToSend) {
-            _errorString = tr("Firmware file read failed: %1").arg(firmwareFile.errorString());
-            return false;
-        }
-        
-        Q_ASSERT(bytesToSend <= 0x8F);
-        
-        bool failed = true;
-        if (_write(PROTO_PROG_MULTI) &&
-                _write((uint8_t)bytesToSend) &&
-                _write(imageBuf, bytesToSend) &&
-                _write(PROTO_EOC)) {
-            if (_getCommandResponse()) {
-                failed = false;
+    while (bytesAcked < imageSize) {
+        if ((bytesSent < imageSize) && (chunksInFlight.count() < _programPipelineDepth)) {
+            int bytesToSend = imageSize - bytesSent;
+            if (bytesToSend > (int)sizeof(imageBuf)) {
+                bytesToSend = (int)sizeof(imageBuf);
+            }
+
+            Q_ASSERT((bytesToSend % 4) == 0);
+
+            int bytesRead = firmwareFile.read((char *)imageBuf, bytesToSend);
+            if (bytesRead == -1 || bytesRead != bytesToSend) {
+                _errorString = tr("Firmware file read failed: %1").arg(firmwareFile.errorString());
+                return false;
             }
+
+            Q_ASSERT(bytesToSend <= 0x8F);
+
+            frame.clear();
+            frame.append(static_cast<char>(PROTO_PROG_MULTI));
+            frame.append(static_cast<char>(bytesToSend));
+            frame.append(reinterpret_cast<const char*>(imageBuf), bytesToSend);
+            frame.append(static_cast<char>(PROTO_EOC));
+            if (!_write(frame)) {
+                _errorString = tr("Flash failed: %1 at address 0x%2").arg(_errorString).arg(bytesSent, 8, 16, QLatin1Char('0'));
+                return false;
+            }
+
+            chunksInFlight.enqueue(qMakePair(bytesSent, bytesToSend));
+            bytesSent += bytesToSend;
+
+            // Calculate the CRC now so we can test it after the board is flashed.
+            _imageCRC = QGC::crc32((uint8_t *)imageBuf, bytesToSend, _imageCRC);
+            continue;
         }
-        if (failed) {
-            _errorString = tr("Flash failed: %1 at address 0x%2").arg(_errorString).arg(bytesSent, 8, 16, QLatin1Char('0'));
+
+        // Pipeline is full or everything is sent, wait for the oldest chunk. Responses arrive in order.
+        _flush();
+        const QPair<uint32_t, int> chunk = chunksInFlight.dequeue();
+        if (!_getCommandResponse()) {
+            _errorString = tr("Flash failed: %1 at address 0x%2").arg(_errorString).arg(chunk.first, 8, 16, QLatin1Char('0'));
             return false;
         }
 
-        bytesSent += bytesToSend;
-
-        // Calculate the CRC now so we can test it after the board is flashed.
-        _imageCRC = QGC::crc32((uint8_t *)imageBuf, bytesToSend, _imageCRC);
+        bytesAcked += chunk.second;
 
-        emit updateProgress(bytesSent, imageSize);
+        emit updateProgress(bytesAcked, imageSize);
     }
     firmwareFile.close();
 
     // We calculate the CRC using the entire flash size, filling the remainder with 0xFF.
+    uint8_t fill[256];
+    memset(fill, 0xFF, sizeof(fill));
     while (bytesSent < _boardFlashSize) {
-        const uint8_t fill = 0xFF;
-        _imageCRC = QGC::crc32(&fill, 1, _imageCRC);
-        bytesSent++;
+        const uint32_t fillBytes = qMin<uint32_t>(sizeof(fill), _boardFlashSize - bytesSent);
+        _imageCRC = QGC::crc32(fill, fillBytes, _imageCRC);
+        bytesSent += fillBytes;
     }
 
     return true;
@@ -437,11 +489,9 @@ bool Bootloader::_ihxProgram(const FirmwareImage* image)
         // Set flash address
         
         failed = true;
-        if (_write(PROTO_LOAD_ADDRESS) &&
-                _write(flashAddress & 0xFF) &&
-                _write((flashAddress >> 8) & 0xFF) &&
-                _write(PROTO_EOC)) {
-            _port.flush();
+        const uint8_t loadAddress[4] = { PROTO_LOAD_ADDRESS, (uint8_t)(flashAddress & 0xFF), (uint8_t)((flashAddress >> 8) & 0xFF), PROTO_EOC };
+        if (_write(loadAddress, sizeof(loadAddress))) {
+            _flush();
             if (_getCommandResponse()) {
                 failed = false;
             }
@@ -466,12 +516,16 @@ bool Bootloader::_ihxProgram(const FirmwareImage* image)
                 bytesToWrite = bytesLeftToWrite;
             }
 
+            QByteArray frame;
+            frame.reserve(bytesToWrite + 3);
+            frame.append(static_cast<char>(PROTO_PROG_MULTI));
+            frame.append(static_cast<char>(bytesToWrite));
+            frame.append(bytes.constData() + bytesIndex, bytesToWrite);
+            frame.append(static_cast<char>(PROTO_EOC));
+
             failed = true;
-            if (_write(PROTO_PROG_MULTI) &&
-                    _write(bytesToWrite) &&
-                    _write(&((uint8_t *)bytes.data())[bytesIndex], bytesToWrite) &&
-                    _write(PROTO_EOC)) {
-                _port.flush();
+            if (_write(frame)) {
+                _flush();
                 if (_getCommandResponse()) {
                     failed = false;
                 }
@@ -555,10 +609,9 @@ bool Bootloader::_binVerifyBytes(const FirmwareImage* image)
         Q_ASSERT(bytesToRead <= 0x8F);
         
         bool failed = true;
-        if (_write(PROTO_READ_MULTI) &&
-                _write((uint8_t)bytesToRead) &&
-                _write(PROTO_EOC)) {
-            _port.flush();
+        const uint8_t readMulti[3] = { PROTO_READ_MULTI, (uint8_t)bytesToRead, PROTO_EOC };
+        if (_write(readMulti, sizeof(readMulti))) {
+            _flush();
             if (_read(readBuf, bytesToRead)) {
                 if (_getCommandResponse()) {
                     failed = false;
@@ -609,11 +662,9 @@ bool Bootloader::_ihxVerifyBytes(const FirmwareImage* image)
         // Set read address
         
         failed = true;
-        if (_write(PROTO_LOAD_ADDRESS) &&
-                _write(readAddress & 0xFF) &&
-                _write((readAddress >> 8) & 0xFF) &&
-                _write(PROTO_EOC)) {
-            _port.flush();
+        const uint8_t loadAddress[4] = { PROTO_LOAD_ADDRESS, (uint8_t)(readAddress & 0xFF), (uint8_t)((readAddress >> 8) & 0xFF), PROTO_EOC };
+        if (_write(loadAddress, sizeof(loadAddress))) {
+            _flush();
             if (_getCommandResponse()) {
                 failed = false;
             }
@@ -640,10 +691,9 @@ bool Bootloader::_ihxVerifyBytes(const FirmwareImage* image)
             }
 
             failed = true;
-            if (_write(PROTO_READ_MULTI) &&
-                    _write(bytesToRead) &&
-                    _write(PROTO_EOC)) {
-                _port.flush();
+            const uint8_t readMulti[3] = { PROTO_READ_MULTI, bytesToRead, PROTO_EOC };
+            if (_write(readMulti, sizeof(readMulti))) {
+                _flush();
                 if (_read(readBuf, bytesToRead)) {
                     if (_getCommandResponse()) {
                         failed = false;
@@ -687,7 +737,7 @@ bool Bootloader::_verifyCRC(void)
     
     bool failed = true;
     if (_write(buf, 2)) {
-        _port.flush();
+        _flush();
         if (_read((uint8_t*)&flashCRC, sizeof(flashCRC), _verifyTimeout)) {
             if (_getCommandResponse()) {
                 failed = false;
@@ -721,7 +771,7 @@ bool Bootloader::_syncWorker(void)
 bool Bootloader::_sync(void)
 {
     // Sometimes getting sync is flaky, try 3 times
-    _port.readAll();
+    _device->readAll();
     bool success = false;
     for (int i=0; i<3; i++) {
         success = _syncWorker();
@@ -740,7 +790,7 @@ bool Bootloader::_get3DRRadioBoardId(uint32_t& boardID)
     if (!_write(buf, sizeof(buf))) {
         goto Error;
     }
-    _port.flush();
+    _flush();
 
     if (!_read((uint8_t*)buf, 2)) {
         goto Error;
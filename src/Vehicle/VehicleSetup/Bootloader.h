@@ -34,7 +34,9 @@ class Bootloader : public QObject
     QString errorString(void) { return _errorString; }
     
     bool open               (const QString portName);
-    void close              (void) { _port.close(); }
+    /// Uses an already open device instead of a serial port, e.g. a bootloader emulator. Not supported for SiK radios.
+    bool open               (QIODevice* device);
+    void close              (void);
     bool getBoardInfo       (uint32_t& bootloaderVersion, uint32_t& boardID, uint32_t& flashSize);
     bool initFlashSequence  (void);
     bool erase              (void);
@@ -42,6 +44,11 @@ class Bootloader : public QObject
     bool verify             (const FirmwareImage* image);
     bool reboot             (void);
 
+    /// Number of PROG_MULTI chunks sent ahead before waiting for their responses. The bootloader handles commands
+    /// in order, so this is only safe on links with flow control such as USB CDC. 1 disables pipelining.
+    void setProgramPipelineDepth(int depth) { _programPipelineDepth = qMax(1, depth); }
+    int  programPipelineDepth   (void) const { return _programPipelineDepth; }
+
     static const int boardIDSiKRadio1000    = 78;       ///< Original radio based on SI1000 chip
     static const int boardIDSiKRadio1060    = 80;       ///< Newer radio based on SI1060 chip
 
@@ -50,6 +57,8 @@ class Bootloader : public QObject
     static const int boardIDPX4FMUV2 = 9;        ///< PX4 V2 board, as from USB PID
     static const int boardIDPX4FMUV3 = 255;
 
+    static constexpr int defaultUsbPipelineDepth = 4;  ///< PROG_MULTI chunks in flight on USB connected PX4 bootloaders
+
 signals:
     /// @brief Signals progress indicator for long running bootloader utility routines
     void updateProgress(int curr, int total);
@@ -60,8 +69,9 @@ class Bootloader : public QObject
     bool    _binProgram         (const FirmwareImage* image);
     bool    _ihxProgram         (const FirmwareImage* image);
     bool    _write              (const uint8_t* data, qint64 maxSize);
-    bool    _write              (const uint8_t byte);
     bool    _write              (const char* data);
+    bool    _write              (const QByteArray& data);
+    void    _flush              (void);
     bool    _read               (uint8_t* data, qint64 cBytesExpected, int readTimeout = _readTimout);
     bool    _sendCommand        (uint8_t cmd, int responseTimeout = _responseTimeout);
     bool    _getCommandResponse (const int responseTimeout = _responseTimeout);
@@ -109,6 +119,8 @@ class Bootloader : public QObject
     };
     
     QSerialPort _port;
+    QIODevice*  _device             = &_port;   ///< Device all protocol traffic goes through
+    int         _programPipelineDepth = 1;
     bool        _sikRadio           = false;
     bool        _inBootloaderMode   = false;    ///< true: board is in bootloader mode, false: special case for SiK Radio, board is in command mode
     uint32_t    _boardID            = 0;        ///< board id for currently connected board
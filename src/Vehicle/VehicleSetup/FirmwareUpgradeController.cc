@@ -661,15 +661,16 @@ void FirmwareUpgradeController::_ardupilotManifestDownloadComplete(QString remot
 
         qCDebug(FirmwareUpgradeLog) << "_ardupilotManifestDownloadFinished" << remoteFile << localFile;
 
-        QString jsonFileName(QDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation)).absoluteFilePath("ArduPilot.Manifest.json"));
-        if (!QGCZlib::inflateGzipFile(localFile, jsonFileName)) {
+        QByteArray jsonBytes;
+        QFile gzippedFile(localFile);
+        if (!gzippedFile.open(QIODevice::ReadOnly) || !QGCZlib::inflateGzip(gzippedFile.readAll(), jsonBytes)) {
             qCWarning(FirmwareUpgradeLog) << "Inflate of compressed manifest failed" << localFile;
             return;
         }
 
         QString         errorString;
         QJsonDocument   doc;
-        if (!JsonHelper::isJsonFile(jsonFileName, doc, errorString)) {
+        if (!JsonHelper::isJsonFile(jsonBytes, doc, errorString)) {
             qCWarning(FirmwareUpgradeLog) << "Json file read failed" << errorString;
             return;
         }
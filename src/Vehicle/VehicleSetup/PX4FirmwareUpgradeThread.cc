@@ -79,6 +79,10 @@ void PX4FirmwareUpgradeThreadWorker::_findBoardOnce(void)
             if (!_findBoardFirstAttempt) {
 
                 _bootloader = new Bootloader(boardType == QGCSerialPortInfo::BoardTypeSiKRadio, this);
+                if (boardType != QGCSerialPortInfo::BoardTypeSiKRadio) {
+                    // Boards are flashed over USB CDC, which provides the flow control pipelining relies on
+                    _bootloader->setProgramPipelineDepth(Bootloader::defaultUsbPipelineDepth);
+                }
                 connect(_bootloader, &Bootloader::updateProgress, this, &PX4FirmwareUpgradeThreadWorker::_updateProgress);
 
                 if (_bootloader->open(portInfo.portName())) {
@@ -0,0 +1,248 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "VideoLatencyStats.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QTextStream>
+
+#include <algorithm>
+
+QGC_LOGGING_CATEGORY(VideoLatencyStatsLog, "Video.VideoLatencyStats")
+
+void VideoLatencyStats::RollingWindow::add(qint64 value)
+{
+    _values[_next] = value;
+    _next = (_next + 1) % windowSize;
+    _count = std::min(_count + 1, windowSize);
+}
+
+double VideoLatencyStats::RollingWindow::meanMs() const
+{
+    if (_count == 0) {
+        return 0;
+    }
+
+    qint64 sum = 0;
+    for (int i = 0; i < _count; i++) {
+        sum += _values[i];
+    }
+    return (static_cast<double>(sum) / _count) / 1000.;
+}
+
+double VideoLatencyStats::RollingWindow::maxMs() const
+{
+    if (_count == 0) {
+        return 0;
+    }
+
+    return static_cast<double>(*std::max_element(_values.cbegin(), _values.cbegin() + _count)) / 1000.;
+}
+
+/*===========================================================================*/
+
+VideoLatencyStats::VideoLatencyStats(QObject *parent)
+    : QObject(parent)
+{
+    // qCDebug(VideoLatencyStatsLog) << Q_FUNC_INFO << this;
+}
+
+VideoLatencyStats::~VideoLatencyStats()
+{
+    setLogFileName(QString());
+
+    // qCDebug(VideoLatencyStatsLog) << Q_FUNC_INFO << this;
+}
+
+void VideoLatencyStats::recordFrame(Stage stage, quint64 pts, qint64 timeUSecs)
+{
+    QMutexLocker lock(&_mutex);
+
+    if (stage == StageSource) {
+        FrameTimes &frame = _frames[_nextFrame];
+        _nextFrame = (_nextFrame + 1) % static_cast<int>(_frames.size());
+        frame.pts = pts;
+        frame.timeUSecs.fill(0);
+        frame.timeUSecs[StageSource] = timeUSecs;
+        return;
+    }
+
+    if (stage == StageSink) {
+        _framesRendered++;
+    }
+
+    // Decoders and parsers keep the PTS, so it identifies the frame in later stages. Search newest first.
+    const int frameCount = static_cast<int>(_frames.size());
+    for (int i = 1; i <= frameCount; i++) {
+        FrameTimes &frame = _frames[(_nextFrame - i + frameCount) % frameCount];
+        if ((frame.pts != pts) || (frame.timeUSecs[StageSource] == 0)) {
+            continue;
+        }
+        if (frame.timeUSecs[stage] != 0) {
+            // Already seen, e.g. a frame which is displayed again
+            return;
+        }
+
+        frame.timeUSecs[stage] = timeUSecs;
+        const qint64 previous = frame.timeUSecs[stage - 1];
+        switch (stage) {
+        case StageDecoderInput:
+            _queue.add(timeUSecs - previous);
+            break;
+        case StageDecoderOutput:
+            if (previous != 0) {
+                _decode.add(timeUSecs - previous);
+            }
+            break;
+        case StageSink:
+            if (previous != 0) {
+                _sink.add(timeUSecs - previous);
+            }
+            _pipeline.add(timeUSecs - frame.timeUSecs[StageSource]);
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+}
+
+void VideoLatencyStats::recordJitterBufferPacket(bool input, quint16 seqnum, qint64 timeUSecs)
+{
+    QMutexLocker lock(&_mutex);
+
+    if (input) {
+        _packets[_nextPacket] = { seqnum, timeUSecs };
+        _nextPacket = (_nextPacket + 1) % static_cast<int>(_packets.size());
+        return;
+    }
+
+    const int packetCount = static_cast<int>(_packets.size());
+    for (int i = 1; i <= packetCount; i++) {
+        PacketTime &packet = _packets[(_nextPacket - i + packetCount) % packetCount];
+        if ((packet.seqnum == seqnum) && (packet.timeUSecs != 0)) {
+            _jitterBuffer.add(timeUSecs - packet.timeUSecs);
+            packet.timeUSecs = 0;
+            return;
+        }
+    }
+}
+
+void VideoLatencyStats::recordSinkLateness(qint64 latenessUSecs)
+{
+    QMutexLocker lock(&_mutex);
+    _sinkLateness.add(latenessUSecs);
+}
+
+void VideoLatencyStats::setQueueDepth(int buffers)
+{
+    QMutexLocker lock(&_mutex);
+    _queueDepth = buffers;
+}
+
+void VideoLatencyStats::setFramesDroppedLate(quint64 dropped)
+{
+    QMutexLocker lock(&_mutex);
+    _framesDroppedLate = dropped;
+}
+
+void VideoLatencyStats::reset()
+{
+    QMutexLocker lock(&_mutex);
+
+    _frames.fill(FrameTimes());
+    _nextFrame = 0;
+    _packets.fill(PacketTime());
+    _nextPacket = 0;
+    _jitterBuffer.clear();
+    _queue.clear();
+    _decode.clear();
+    _sink.clear();
+    _pipeline.clear();
+    _sinkLateness.clear();
+    _queueDepth = 0;
+    _framesRendered = 0;
+    _framesDroppedLate = 0;
+}
+
+VideoLatencyStats::Snapshot VideoLatencyStats::snapshot() const
+{
+    QMutexLocker lock(&_mutex);
+
+    Snapshot snapshot;
+    snapshot.valid = !_pipeline.isEmpty() || !_queue.isEmpty();
+    snapshot.jitterBufferMs = _jitterBuffer.meanMs();
+    snapshot.queueMs = _queue.meanMs();
+    snapshot.decodeMs = _decode.meanMs();
+    snapshot.decodeMaxMs = _decode.maxMs();
+    snapshot.sinkMs = _sink.meanMs();
+    snapshot.pipelineMs = _pipeline.meanMs();
+    snapshot.pipelineMaxMs = _pipeline.maxMs();
+    snapshot.sinkLatenessMs = _sinkLateness.meanMs();
+    snapshot.queueDepth = _queueDepth;
+    snapshot.framesRendered = _framesRendered;
+    snapshot.framesDroppedLate = _framesDroppedLate;
+    return snapshot;
+}
+
+void VideoLatencyStats::publish()
+{
+    const Snapshot current = snapshot();
+
+    _writeLogLine(current);
+
+    (void) QMetaObject::invokeMethod(this, [this, current]() {
+        _published = current;
+        emit statsChanged();
+    }, Qt::QueuedConnection);
+}
+
+void VideoLatencyStats::setLogFileName(const QString &fileName)
+{
+    QMutexLocker lock(&_logMutex);
+
+    if (_logFile.isOpen()) {
+        _logFile.close();
+    }
+
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    _logFile.setFileName(fileName);
+    if (!_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qCWarning(VideoLatencyStatsLog) << "Failed to open" << fileName << _logFile.errorString();
+        return;
+    }
+
+    if (_logFile.size() == 0) {
+        // Columns are named like the QML properties
+        (void) _logFile.write("time,jitterBufferMs,queueMs,decodeMs,decodeMaxMs,sinkMs,pipelineMs,pipelineMaxMs,"
+                              "sinkLatenessMs,queueDepth,framesRendered,framesDroppedLate\n");
+    }
+    qCDebug(VideoLatencyStatsLog) << "Logging to" << fileName;
+}
+
+void VideoLatencyStats::_writeLogLine(const Snapshot &snapshot)
+{
+    QMutexLocker lock(&_logMutex);
+
+    if (!_logFile.isOpen() || !snapshot.valid) {
+        return;
+    }
+
+    QTextStream stream(&_logFile);
+    stream << QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs)
+           << ',' << snapshot.jitterBufferMs << ',' << snapshot.queueMs
+           << ',' << snapshot.decodeMs << ',' << snapshot.decodeMaxMs << ',' << snapshot.sinkMs
+           << ',' << snapshot.pipelineMs << ',' << snapshot.pipelineMaxMs << ',' << snapshot.sinkLatenessMs
+           << ',' << snapshot.queueDepth << ',' << snapshot.framesRendered << ',' << snapshot.framesDroppedLate << '\n';
+    stream.flush();
+}
@@ -0,0 +1,156 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QFile>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtQmlIntegration/QtQmlIntegration>
+
+#include <array>
+
+Q_DECLARE_LOGGING_CATEGORY(VideoLatencyStatsLog)
+
+/// Per stage latency statistics of a video receiver pipeline.
+///
+/// The receiver reports when a frame passes each stage, identified by its PTS, from the streaming threads.
+/// Stage times are measured against the monotonic wall clock, sink lateness against the pipeline clock.
+/// Samples are kept in rolling windows; publish() turns them into the values exposed to QML and, if a log
+/// file is set, appends one CSV line per call.
+class VideoLatencyStats : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("")
+
+    Q_PROPERTY(bool     valid               READ valid              NOTIFY statsChanged)
+    Q_PROPERTY(double   jitterBufferMs      READ jitterBufferMs     NOTIFY statsChanged)
+    Q_PROPERTY(double   queueMs             READ queueMs            NOTIFY statsChanged)
+    Q_PROPERTY(double   decodeMs            READ decodeMs           NOTIFY statsChanged)
+    Q_PROPERTY(double   decodeMaxMs         READ decodeMaxMs        NOTIFY statsChanged)
+    Q_PROPERTY(double   sinkMs              READ sinkMs             NOTIFY statsChanged)
+    Q_PROPERTY(double   pipelineMs          READ pipelineMs         NOTIFY statsChanged)
+    Q_PROPERTY(double   pipelineMaxMs       READ pipelineMaxMs      NOTIFY statsChanged)
+    Q_PROPERTY(double   sinkLatenessMs      READ sinkLatenessMs     NOTIFY statsChanged)
+    Q_PROPERTY(int      queueDepth          READ queueDepth         NOTIFY statsChanged)
+    Q_PROPERTY(quint64  framesRendered      READ framesRendered     NOTIFY statsChanged)
+    Q_PROPERTY(quint64  framesDroppedLate   READ framesDroppedLate  NOTIFY statsChanged)
+
+public:
+    explicit VideoLatencyStats(QObject *parent = nullptr);
+    ~VideoLatencyStats();
+
+    enum Stage {
+        StageSource = 0,        ///< Leaves the source bin (after jitter buffer and parser)
+        StageDecoderInput,      ///< Leaves the decoder queue
+        StageDecoderOutput,     ///< Leaves the decoder
+        StageSink,              ///< Arrives at the video sink
+        StageCount
+    };
+
+    struct Snapshot {
+        bool valid = false;
+        double jitterBufferMs = 0;
+        double queueMs = 0;
+        double decodeMs = 0;
+        double decodeMaxMs = 0;
+        double sinkMs = 0;
+        double pipelineMs = 0;
+        double pipelineMaxMs = 0;
+        double sinkLatenessMs = 0;
+        int queueDepth = 0;
+        quint64 framesRendered = 0;
+        quint64 framesDroppedLate = 0;
+    };
+
+    // Thread safe, called from the streaming threads
+    void recordFrame(Stage stage, quint64 pts, qint64 timeUSecs);
+    void recordJitterBufferPacket(bool input, quint16 seqnum, qint64 timeUSecs);
+    void recordSinkLateness(qint64 latenessUSecs);
+    void setQueueDepth(int buffers);
+    void setFramesDroppedLate(quint64 dropped);
+    void reset();
+
+    /// Thread safe. Summarizes the rolling windows and updates the properties from the object's thread.
+    void publish();
+
+    /// Thread safe. Empty file name stops logging.
+    void setLogFileName(const QString &fileName);
+
+    /// Summary of the current rolling windows
+    Snapshot snapshot() const;
+
+    bool valid() const { return _published.valid; }
+    double jitterBufferMs() const { return _published.jitterBufferMs; }
+    double queueMs() const { return _published.queueMs; }
+    double decodeMs() const { return _published.decodeMs; }
+    double decodeMaxMs() const { return _published.decodeMaxMs; }
+    double sinkMs() const { return _published.sinkMs; }
+    double pipelineMs() const { return _published.pipelineMs; }
+    double pipelineMaxMs() const { return _published.pipelineMaxMs; }
+    double sinkLatenessMs() const { return _published.sinkLatenessMs; }
+    int queueDepth() const { return _published.queueDepth; }
+    quint64 framesRendered() const { return _published.framesRendered; }
+    quint64 framesDroppedLate() const { return _published.framesDroppedLate; }
+
+    static constexpr int windowSize = 120;  ///< Samples per rolling window, a few seconds of video
+
+signals:
+    void statsChanged();
+
+private:
+    class RollingWindow
+    {
+    public:
+        void add(qint64 value);
+        void clear() { _count = 0; _next = 0; }
+        bool isEmpty() const { return (_count == 0); }
+        double meanMs() const;
+        double maxMs() const;
+
+    private:
+        std::array<qint64, windowSize> _values{};
+        int _count = 0;
+        int _next = 0;
+    };
+
+    struct FrameTimes {
+        quint64 pts = 0;
+        std::array<qint64, StageCount> timeUSecs{};
+    };
+
+    struct PacketTime {
+        quint16 seqnum = 0;
+        qint64 timeUSecs = 0;
+    };
+
+    void _writeLogLine(const Snapshot &snapshot);
+
+    mutable QMutex _mutex;
+    std::array<FrameTimes, 64> _frames{};
+    int _nextFrame = 0;
+    std::array<PacketTime, 256> _packets{};
+    int _nextPacket = 0;
+    RollingWindow _jitterBuffer;
+    RollingWindow _queue;
+    RollingWindow _decode;
+    RollingWindow _sink;
+    RollingWindow _pipeline;
+    RollingWindow _sinkLateness;
+    int _queueDepth = 0;
+    quint64 _framesRendered = 0;
+    quint64 _framesDroppedLate = 0;
+
+    QMutex _logMutex;
+    QFile _logFile;
+
+    Snapshot _published;
+};
@@ -18,6 +18,7 @@
 #include "SettingsManager.h"
 #include "SubtitleWriter.h"
 #include "Vehicle.h"
+#include "VideoLatencyStats.h"
 #include "VideoReceiver.h"
 #include "VideoSettings.h"
 #ifdef QGC_GST_STREAMING
@@ -30,6 +31,7 @@
 
 #include <QtCore/QApplicationStatic>
 #include <QtCore/QDir>
+#include <QtCore/QFileInfo>
 #include <QtQml/QQmlEngine>
 #include <QtQuick/QQuickItem>
 #include <QtQuick/QQuickWindow>
@@ -93,6 +95,12 @@ void VideoManager::init(QQuickWindow *mainWindow)
     (void) connect(_videoSettings->tcpUrl(), &Fact::rawValueChanged, this, &VideoManager::_videoSourceChanged);
     (void) connect(_videoSettings->aspectRatio(), &Fact::rawValueChanged, this, &VideoManager::aspectRatioChanged);
     (void) connect(_videoSettings->lowLatencyMode(), &Fact::rawValueChanged, this, [this](const QVariant &value) { Q_UNUSED(value); _restartAllVideos(); });
+    (void) connect(_videoSettings->logLatencyStats(), &Fact::rawValueChanged, this, &VideoManager::_updateLatencyLogging);
+    (void) connect(_videoSettings->preRecordSeconds(), &Fact::rawValueChanged, this, [this](const QVariant &value) {
+        for (VideoReceiver *receiver : std::as_const(_videoReceivers)) {
+            receiver->setPreRecordSeconds(value.toUInt());
+        }
+    });
     (void) connect(MultiVehicleManager::instance(), &MultiVehicleManager::activeVehicleChanged, this, &VideoManager::_setActiveVehicle);
 
     (void) connect(this, &VideoManager::autoStreamConfiguredChanged, this, &VideoManager::_videoSourceChanged);
@@ -129,6 +137,39 @@ void VideoManager::_initAfterQmlIsReady()
 
         _initVideoReceiver(receiver, _mainWindow);
     }
+
+    emit latencyStatsChanged();
+}
+
+VideoLatencyStats *VideoManager::latencyStats() const
+{
+    for (VideoReceiver *receiver : _videoReceivers) {
+        if (!receiver->isThermal()) {
+            return receiver->latencyStats();
+        }
+    }
+
+    return nullptr;
+}
+
+void VideoManager::_updateLatencyLogging()
+{
+    const bool enabled = _videoSettings->logLatencyStats()->rawValue().toBool();
+    const QString logPath = SettingsManager::instance()->appSettings()->logSavePath();
+    const QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd_hh.mm.ss");
+
+    for (VideoReceiver *receiver : std::as_const(_videoReceivers)) {
+        VideoLatencyStats *const stats = receiver->latencyStats();
+        if (!stats) {
+            continue;
+        }
+
+        if (enabled && receiver->started() && !logPath.isEmpty()) {
+            stats->setLogFileName(QStringLiteral("%1/%2_%3_latency.csv").arg(logPath, timestamp, receiver->name()));
+        } else {
+            stats->setLogFileName(QString());
+        }
+    }
 }
 
 void VideoManager::cleanup()
@@ -225,9 +266,14 @@ void VideoManager::grabImage(const QString &imageFile)
 
     emit imageFileChanged(_imageFile);
 
+    // Receivers only queue the request, the frame is converted and encoded off the GUI thread
     for (VideoReceiver *receiver : std::as_const(_videoReceivers)) {
-        receiver->takeScreenshot(_imageFile);
-        // QSharedPointer<QQuickItemGrabResult> result = receiver->widget()->grabToImage(const QSize &targetSize = QSize())
+        if (receiver->isThermal()) {
+            const QFileInfo imageInfo(_imageFile);
+            receiver->takeScreenshot(imageInfo.dir().filePath(imageInfo.completeBaseName() + QStringLiteral("_thermal.") + imageInfo.suffix()));
+        } else {
+            receiver->takeScreenshot(_imageFile);
+        }
     }
 }
 
@@ -515,6 +561,9 @@ bool VideoManager::_updateSettings(VideoReceiver *receiver)
         settingsChanged = true;
     }
 
+    // Applied while running, no restart needed
+    receiver->setPreRecordSeconds(_videoSettings->preRecordSeconds()->rawValue().toUInt());
+
     if (receiver->isThermal()) {
         return settingsChanged;
     }
@@ -739,6 +788,7 @@ void VideoManager::_initVideoReceiver(VideoReceiver *receiver, QQuickWindow *win
             _streaming = active;
             emit streamingChanged();
         }
+        _updateLatencyLogging();
     });
 
     (void) connect(receiver, &VideoReceiver::decodingChanged, this, [this, receiver](bool active) {
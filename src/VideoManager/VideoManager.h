@@ -21,6 +21,7 @@ class QQuickWindow;
 class FinishVideoInitialization;
 class SubtitleWriter;
 class Vehicle;
+class VideoLatencyStats;
 class VideoReceiver;
 class VideoSettings;
 
@@ -30,6 +31,7 @@ class VideoManager : public QObject
     QML_ELEMENT
     QML_UNCREATABLE("")
     Q_MOC_INCLUDE("Vehicle.h")
+    Q_MOC_INCLUDE("VideoLatencyStats.h")
 
     Q_PROPERTY(bool     gstreamerEnabled        READ gstreamerEnabled                           CONSTANT)
     Q_PROPERTY(bool     qtmultimediaEnabled     READ qtmultimediaEnabled                        CONSTANT)
@@ -50,6 +52,7 @@ class VideoManager : public QObject
     Q_PROPERTY(QSize    videoSize               READ videoSize                                  NOTIFY videoSizeChanged)
     Q_PROPERTY(QString  imageFile               READ imageFile                                  NOTIFY imageFileChanged)
     Q_PROPERTY(QString  uvcVideoSourceID        READ uvcVideoSourceID                           NOTIFY uvcVideoSourceIDChanged)
+    Q_PROPERTY(VideoLatencyStats *latencyStats  READ latencyStats                               NOTIFY latencyStatsChanged)
 
 public:
     explicit VideoManager(QObject *parent = nullptr);
@@ -83,6 +86,8 @@ class VideoManager : public QObject
     QSize videoSize() const { return _videoSize; }
     QString imageFile() const { return _imageFile; }
     QString uvcVideoSourceID() const { return _uvcVideoSourceID; }
+    /// @return Latency statistics of the primary (non thermal) stream, nullptr if not available
+    VideoLatencyStats *latencyStats() const;
     void setfullScreen(bool on);
     static bool gstreamerEnabled();
     static bool qtmultimediaEnabled();
@@ -98,6 +103,7 @@ class VideoManager : public QObject
     void isAutoStreamChanged();
     void isStreamSourceChanged();
     void isUvcChanged();
+    void latencyStatsChanged();
     void recordingChanged(bool recording);
     void recordingStarted(const QString &filename);
     void streamingChanged();
@@ -108,6 +114,7 @@ private slots:
     void _communicationLostChanged(bool communicationLost);
     void _setActiveVehicle(Vehicle *vehicle);
     void _videoSourceChanged();
+    void _updateLatencyLogging();
 
 private:
     void _initAfterQmlIsReady();
@@ -0,0 +1,164 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "GstPreRecordBuffer.h"
+#include "QGCLoggingCategory.h"
+
+QGC_LOGGING_CATEGORY(GstPreRecordBufferLog, "Video.GstPreRecordBuffer")
+
+GstPreRecordBuffer::~GstPreRecordBuffer()
+{
+    _clear();
+}
+
+void GstPreRecordBuffer::setDuration(GstClockTime duration)
+{
+    QMutexLocker locker(&_mutex);
+
+    _duration = duration;
+    if (_duration == 0) {
+        _clear();
+    } else {
+        _evict();
+    }
+}
+
+void GstPreRecordBuffer::setMaxBytes(gsize maxBytes)
+{
+    QMutexLocker locker(&_mutex);
+
+    _maxBytes = maxBytes;
+    _evict();
+}
+
+bool GstPreRecordBuffer::enabled() const
+{
+    QMutexLocker locker(&_mutex);
+    return (_duration > 0);
+}
+
+void GstPreRecordBuffer::push(GstBuffer *buffer)
+{
+    if (!buffer) {
+        return;
+    }
+
+    QMutexLocker locker(&_mutex);
+
+    if (_duration == 0) {
+        return;
+    }
+
+    const bool keyframe = !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    if (!keyframe && _gops.empty()) {
+        // A recording has to start with a keyframe
+        return;
+    }
+
+    const GstClockTime time = GST_BUFFER_DTS_OR_PTS(buffer);
+    if (GST_CLOCK_TIME_IS_VALID(time)) {
+        _lastTime = time;
+    }
+
+    if (keyframe) {
+        Gop gop;
+        gop.start = time;
+        _gops.push_back(gop);
+    }
+
+    Gop &gop = _gops.back();
+    gop.buffers.append(gst_buffer_ref(buffer));
+    const gsize size = gst_buffer_get_size(buffer);
+    gop.bytes += size;
+    _bytes += size;
+
+    _evict();
+}
+
+QList<GstBuffer*> GstPreRecordBuffer::take()
+{
+    QMutexLocker locker(&_mutex);
+
+    QList<GstBuffer*> buffers;
+    for (const Gop &gop : _gops) {
+        buffers.append(gop.buffers);
+    }
+
+    qCDebug(GstPreRecordBufferLog) << "Taking" << _gops.size() << "GOPs," << buffers.size() << "buffers," << _bytes << "bytes";
+
+    _gops.clear();
+    _bytes = 0;
+    _lastTime = GST_CLOCK_TIME_NONE;
+
+    return buffers;
+}
+
+void GstPreRecordBuffer::clear()
+{
+    QMutexLocker locker(&_mutex);
+    _clear();
+}
+
+gsize GstPreRecordBuffer::bytes() const
+{
+    QMutexLocker locker(&_mutex);
+    return _bytes;
+}
+
+GstClockTime GstPreRecordBuffer::duration() const
+{
+    QMutexLocker locker(&_mutex);
+
+    if (_gops.empty() || !GST_CLOCK_TIME_IS_VALID(_gops.front().start) || !GST_CLOCK_TIME_IS_VALID(_lastTime) || (_lastTime < _gops.front().start)) {
+        return 0;
+    }
+
+    return (_lastTime - _gops.front().start);
+}
+
+void GstPreRecordBuffer::_evict()
+{
+    // Drop the oldest GOP as long as the following ones still cover the requested duration
+    while ((_gops.size() > 1) && GST_CLOCK_TIME_IS_VALID(_lastTime)) {
+        const GstClockTime secondStart = _gops[1].start;
+        if (!GST_CLOCK_TIME_IS_VALID(secondStart) || (secondStart > _lastTime) || ((_lastTime - secondStart) < _duration)) {
+            break;
+        }
+        _popFront();
+    }
+
+    while ((_bytes > _maxBytes) && (_gops.size() > 1)) {
+        _popFront();
+    }
+
+    if (_bytes > _maxBytes) {
+        // A single GOP above the limit, start over at the next keyframe
+        qCDebug(GstPreRecordBufferLog) << "GOP exceeds" << _maxBytes << "bytes, discarding";
+        _clear();
+    }
+}
+
+void GstPreRecordBuffer::_popFront()
+{
+    Gop &gop = _gops.front();
+    for (GstBuffer *buffer : std::as_const(gop.buffers)) {
+        gst_buffer_unref(buffer);
+    }
+    _bytes -= gop.bytes;
+    _gops.pop_front();
+}
+
+void GstPreRecordBuffer::_clear()
+{
+    while (!_gops.empty()) {
+        _popFront();
+    }
+    _bytes = 0;
+    _lastTime = GST_CLOCK_TIME_NONE;
+}
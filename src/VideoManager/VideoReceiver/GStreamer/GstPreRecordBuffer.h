@@ -0,0 +1,69 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QMutex>
+
+#include <deque>
+
+#include <gst/gstbuffer.h>
+
+Q_DECLARE_LOGGING_CATEGORY(GstPreRecordBufferLog)
+
+/// In-memory ring of the most recent encoded buffers of the recording branch.
+///
+/// Buffers are grouped by GOP, so the ring always starts with a keyframe and can be handed to a muxer as is.
+/// The oldest GOP is evicted once the remaining ones still cover the configured duration, or when the ring
+/// grows beyond its byte limit. Thread safe: buffers are pushed from the streaming thread while the ring is
+/// configured and taken from the receiver's worker thread.
+class GstPreRecordBuffer
+{
+public:
+    GstPreRecordBuffer() = default;
+    ~GstPreRecordBuffer();
+
+    /// @param duration Amount of stream to keep, 0 disables the ring and releases all buffers
+    void setDuration(GstClockTime duration);
+    void setMaxBytes(gsize maxBytes);
+    bool enabled() const;
+
+    /// Adds a reference to the buffer. Delta units are skipped until the first keyframe.
+    void push(GstBuffer *buffer);
+
+    /// Empties the ring. The caller owns the references of the returned buffers, oldest first.
+    QList<GstBuffer*> take();
+
+    void clear();
+
+    gsize bytes() const;
+    GstClockTime duration() const;
+
+    static constexpr gsize defaultMaxBytes = 64 * 1024 * 1024;
+
+private:
+    struct Gop {
+        GstClockTime start = GST_CLOCK_TIME_NONE;
+        gsize bytes = 0;
+        QList<GstBuffer*> buffers;
+    };
+
+    void _evict();
+    void _popFront();
+    void _clear();
+
+    mutable QMutex _mutex;
+    std::deque<Gop> _gops;
+    GstClockTime _duration = 0;
+    GstClockTime _lastTime = GST_CLOCK_TIME_NONE;
+    gsize _bytes = 0;
+    gsize _maxBytes = defaultMaxBytes;
+};
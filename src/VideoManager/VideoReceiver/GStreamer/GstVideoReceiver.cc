@@ -15,17 +15,29 @@
 // _source-->_tee
 //              |
 //              +-->queue-->_recorderValve[-->_fileSink]
+//
+// Latency probes: rtpjitterbuffer sink/src (when present), _tee sink, _decoderValve src,
+// _decoder src and _videoSink sink.
+//
+// While not recording, a probe on the _recorderValve sink keeps the last seconds of the
+// encoded stream in _preRecordBuffer. Starting a recording pushes them past the valve first.
+//
+// Screenshots reference the next buffer reaching _videoSink and are converted and encoded
+// on _screenshotPool.
 //-----------------------------------------------------------------------------
 
 #include "GstVideoReceiver.h"
 #include "GStreamerHelpers.h"
 #include "QGCLoggingCategory.h"
+#include "VideoLatencyStats.h"
 
 #include <QtCore/QDateTime>
 #include <QtCore/QUrl>
+#include <QtGui/QImage>
 #include <QtQuick/QQuickItem>
 
 #include <gst/gst.h>
+#include <gst/video/video.h>
 
 QGC_LOGGING_CATEGORY(GstVideoReceiverLog, "Video.GstVideoReceiver")
 
@@ -35,6 +47,15 @@ GstVideoReceiver::GstVideoReceiver(QObject *parent)
 {
     // qCDebug(GstVideoReceiverLog) << this;
 
+    _latencyStats = new VideoLatencyStats(this);
+
+    (void) connect(this, &VideoReceiver::preRecordSecondsChanged, this, [this](uint32_t seconds) {
+        _preRecordBuffer.setDuration(seconds * GST_SECOND);
+    });
+
+    // Conversion and encoding of screenshots, kept off the GUI and streaming threads
+    _screenshotPool.setMaxThreadCount(2);
+
     _worker->start();
     (void) connect(&_watchdogTimer, &QTimer::timeout, this, &GstVideoReceiver::_watchdog);
     _watchdogTimer.start(1000);
@@ -44,6 +65,7 @@ GstVideoReceiver::~GstVideoReceiver()
 {
     stop();
     _worker->shutdown();
+    (void) _screenshotPool.waitForDone();
 
     // qCDebug(GstVideoReceiverLog) << this;
 }
@@ -94,6 +116,7 @@ void GstVideoReceiver::start(uint32_t timeout)
         }
 
         _lastSourceFrameTime = 0;
+        _latencyStats->reset();
 
         _teeProbeId = gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, _teeProbe, this, nullptr);
         gst_clear_object(&pad);
@@ -114,6 +137,12 @@ void GstVideoReceiver::start(uint32_t timeout)
                      "drop", TRUE,
                      nullptr);
 
+        GstPad *valveSrcPad = gst_element_get_static_pad(_decoderValve, "src");
+        if (valveSrcPad) {
+            (void) gst_pad_add_probe(valveSrcPad, GST_PAD_PROBE_TYPE_BUFFER, _decoderInputProbe, this, nullptr);
+            gst_clear_object(&valveSrcPad);
+        }
+
         recorderQueue = gst_element_factory_make("queue", nullptr);
         if (!recorderQueue)  {
             qCCritical(GstVideoReceiverLog) << "gst_element_factory_make('queue') failed";
@@ -130,6 +159,14 @@ void GstVideoReceiver::start(uint32_t timeout)
                      "drop", TRUE,
                      nullptr);
 
+        GstPad *recorderValveSinkPad = gst_element_get_static_pad(_recorderValve, "sink");
+        if (recorderValveSinkPad) {
+            _preRecordBuffer.clear();
+            _preRecordState = PreRecordState::Capturing;
+            (void) gst_pad_add_probe(recorderValveSinkPad, static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM), _recorderValveProbe, this, nullptr);
+            gst_clear_object(&recorderValveSinkPad);
+        }
+
         _pipeline = gst_pipeline_new("receiver");
         if (!_pipeline) {
             qCCritical(GstVideoReceiverLog) << "gst_pipeline_new() failed";
@@ -149,6 +186,7 @@ void GstVideoReceiver::start(uint32_t timeout)
         gst_bin_add_many(GST_BIN(_pipeline), _source, _tee, decoderQueue, _decoderValve, recorderQueue, _recorderValve, nullptr);
 
         pipelineUp = true;
+        _decoderQueue = decoderQueue;
 
         GstPad *srcPad = nullptr;
         GstIterator *it = gst_element_iterate_src_pads(_source);
@@ -299,8 +337,12 @@ void GstVideoReceiver::stop()
         gst_clear_object(&_pipeline);
         _pipeline = nullptr;
 
+        _preRecordState = PreRecordState::Idle;
+        _preRecordBuffer.clear();
+
         _recorderValve = nullptr;
         _decoderValve = nullptr;
+        _decoderQueue = nullptr;
         _tee = nullptr;
         _source = nullptr;
 
@@ -477,6 +519,9 @@ void GstVideoReceiver::startRecording(const QString &videoFile, FILE_FORMAT form
     (void) gst_pad_add_probe(probepad, GST_PAD_PROBE_TYPE_BUFFER, _keyframeWatch, this, nullptr); // to drop the buffers until key frame is received
     gst_clear_object(&probepad);
 
+    // The pre-record ring starts with a keyframe, so the watch above takes its first buffer as the file's t=0
+    _preRecordState = _preRecordBuffer.enabled() ? PreRecordState::FlushPending : PreRecordState::Recording;
+
     g_object_set(_recorderValve,
                  "drop", FALSE,
                  nullptr);
@@ -510,6 +555,7 @@ void GstVideoReceiver::stopRecording()
                  nullptr);
 
     _removingRecorder = true;
+    _preRecordState = PreRecordState::Capturing;
 
     const bool ret = _unlinkBranch(_recorderValve);
 
@@ -526,10 +572,26 @@ void GstVideoReceiver::takeScreenshot(const QString &imageFile)
         return;
     }
 
-    qCDebug(GstVideoReceiverLog) << "taking screenshot" << _uri;
+    qCDebug(GstVideoReceiverLog) << "taking screenshot" << imageFile << _uri;
+
+    if (!_pipeline || !_decoding) {
+        qCDebug(GstVideoReceiverLog) << "Not decoding!" << _uri;
+        _dispatchSignal([this]() { emit onTakeScreenshotComplete(STATUS_INVALID_STATE); });
+        return;
+    }
+
+    if (_pendingScreenshots >= _kMaxPendingScreenshots) {
+        qCWarning(GstVideoReceiverLog) << "Too many screenshots pending, dropping" << imageFile << _uri;
+        _dispatchSignal([this]() { emit onTakeScreenshotComplete(STATUS_FAIL); });
+        return;
+    }
 
-    // FIXME: record screenshot here
-    _dispatchSignal([this]() { emit onTakeScreenshotComplete(STATUS_NOT_IMPLEMENTED); });
+    // The next frame reaching the video sink is taken for all pending files
+    _pendingScreenshots++;
+    _screenshotMutex.lock();
+    _screenshotFiles.append(imageFile);
+    _screenshotMutex.unlock();
+    _screenshotRequested = true;
 }
 
 void GstVideoReceiver::_watchdog()
@@ -539,6 +601,13 @@ void GstVideoReceiver::_watchdog()
             return;
         }
 
+        if (_decoderQueue) {
+            guint queuedBuffers = 0;
+            g_object_get(_decoderQueue, "current-level-buffers", &queuedBuffers, nullptr);
+            _latencyStats->setQueueDepth(static_cast<int>(queuedBuffers));
+        }
+        _latencyStats->publish();
+
         const qint64 now = QDateTime::currentSecsSinceEpoch();
         if (_lastSourceFrameTime == 0) {
             _lastSourceFrameTime = now;
@@ -767,6 +836,14 @@ GstElement *GstVideoReceiver::_makeSource(const QString &input)
 
                 (void) gst_bin_add(GST_BIN(bin), buffer);
 
+                for (const char *padName : { "sink", "src" }) {
+                    GstPad *bufferPad = gst_element_get_static_pad(buffer, padName);
+                    if (bufferPad) {
+                        (void) gst_pad_add_probe(bufferPad, GST_PAD_PROBE_TYPE_BUFFER, _jitterBufferProbe, this, nullptr);
+                        gst_clear_object(&bufferPad);
+                    }
+                }
+
                 if (!gst_element_link_many(source, buffer, parser, nullptr)) {
                     qCCritical(GstVideoReceiverLog) << "gst_element_link() failed";
                     break;
@@ -962,6 +1039,8 @@ void GstVideoReceiver::_onNewDecoderPad(GstPad *pad)
     // We should now know what codec decodebin3 selected.
     _logDecodebin3SelectedCodec(_decoder);
 
+    (void) gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, _decoderOutputProbe, this, nullptr);
+
     if (!_addVideoSink(pad)) {
         qCCritical(GstVideoReceiverLog) << "_addVideoSink() failed";
     }
@@ -1120,6 +1199,36 @@ void GstVideoReceiver::_noteEndOfStream()
     _endOfStream = true;
 }
 
+void GstVideoReceiver::_noteSinkLateness(GstPad *pad, GstBuffer *buffer)
+{
+    if (!GST_BUFFER_PTS_IS_VALID(buffer)) {
+        return;
+    }
+
+    GstEvent *segmentEvent = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+    if (!segmentEvent) {
+        return;
+    }
+
+    const GstSegment *segment = nullptr;
+    gst_event_parse_segment(segmentEvent, &segment);
+    const guint64 bufferRunningTime = segment ? gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer)) : GST_CLOCK_TIME_NONE;
+    gst_event_unref(segmentEvent);
+
+    GstElement *sink = gst_pad_get_parent_element(pad);
+    if (!sink) {
+        return;
+    }
+
+    // Positive: the frame arrives after the pipeline clock already reached its running time
+    const GstClockTime now = gst_element_get_current_running_time(sink);
+    if (GST_CLOCK_TIME_IS_VALID(now) && GST_CLOCK_TIME_IS_VALID(bufferRunningTime)) {
+        _latencyStats->recordSinkLateness(GST_CLOCK_DIFF(bufferRunningTime, now) / GST_USECOND);
+    }
+
+    gst_object_unref(sink);
+}
+
 bool GstVideoReceiver::_unlinkBranch(GstElement *from)
 {
     GstPad *src = gst_element_get_static_pad(from, "src");
@@ -1161,6 +1270,8 @@ bool GstVideoReceiver::_unlinkBranch(GstElement *from)
 
 void GstVideoReceiver::_shutdownDecodingBranch()
 {
+    _failPendingScreenshots();
+
     if (_decoder) {
         GstObject *parent = gst_element_get_parent(_decoder);
         if (parent) {
@@ -1220,6 +1331,126 @@ void GstVideoReceiver::_shutdownRecordingBranch()
     GST_DEBUG_BIN_TO_DOT_FILE(GST_BIN(_pipeline), GST_DEBUG_GRAPH_SHOW_ALL, "pipeline-recording-stopped");
 }
 
+void GstVideoReceiver::_noteScreenshotFrame(GstPad *pad, GstBuffer *buffer)
+{
+    if (!_screenshotRequested.exchange(false)) {
+        return;
+    }
+
+    QStringList imageFiles;
+    _screenshotMutex.lock();
+    imageFiles.swap(_screenshotFiles);
+    _screenshotMutex.unlock();
+
+    if (imageFiles.isEmpty()) {
+        return;
+    }
+
+    // The sample only references the decoded buffer, it is neither copied nor converted here
+    GstCaps *caps = gst_pad_get_current_caps(pad);
+    GstSample *sample = gst_sample_new(buffer, caps, nullptr, nullptr);
+    gst_clear_caps(&caps);
+
+    for (const QString &imageFile : std::as_const(imageFiles)) {
+        GstSample *taskSample = gst_sample_ref(sample);
+        _screenshotPool.start([this, taskSample, imageFile]() {
+            const bool ok = _saveScreenshot(taskSample, imageFile);
+            gst_sample_unref(taskSample);
+            _pendingScreenshots--;
+
+            if (ok) {
+                qCDebug(GstVideoReceiverLog) << "Screenshot saved" << imageFile;
+            }
+
+            // Emitted from the pool thread, receivers get it queued
+            emit onTakeScreenshotComplete(ok ? STATUS_OK : STATUS_FAIL);
+        });
+    }
+
+    gst_sample_unref(sample);
+}
+
+void GstVideoReceiver::_failPendingScreenshots()
+{
+    _screenshotRequested = false;
+
+    QStringList imageFiles;
+    _screenshotMutex.lock();
+    imageFiles.swap(_screenshotFiles);
+    _screenshotMutex.unlock();
+
+    for (const QString &imageFile : std::as_const(imageFiles)) {
+        qCDebug(GstVideoReceiverLog) << "Decoding stopped, screenshot dropped" << imageFile;
+        _pendingScreenshots--;
+        _dispatchSignal([this]() { emit onTakeScreenshotComplete(STATUS_FAIL); });
+    }
+}
+
+bool GstVideoReceiver::_saveScreenshot(GstSample *sample, const QString &imageFile)
+{
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstCaps *caps = gst_sample_get_caps(sample);
+
+    GstVideoInfo inInfo;
+    if (!buffer || !caps || !gst_video_info_from_caps(&inInfo, caps)) {
+        qCWarning(GstVideoReceiverLog) << "Invalid screenshot sample" << imageFile;
+        return false;
+    }
+
+    const int width = GST_VIDEO_INFO_WIDTH(&inInfo);
+    const int height = GST_VIDEO_INFO_HEIGHT(&inInfo);
+
+    QImage image(width, height, QImage::Format_RGBX8888);
+    GstVideoInfo outInfo;
+    if (image.isNull() || !gst_video_info_set_format(&outInfo, GST_VIDEO_FORMAT_RGBx, width, height)) {
+        qCWarning(GstVideoReceiverLog) << "Unsupported screenshot size" << width << "x" << height;
+        return false;
+    }
+
+    // Convert straight into the image memory
+    outInfo.stride[0] = static_cast<gint>(image.bytesPerLine());
+    outInfo.size = static_cast<gsize>(image.sizeInBytes());
+
+    GstVideoFrame inFrame;
+    if (!gst_video_frame_map(&inFrame, &inInfo, buffer, GST_MAP_READ)) {
+        qCWarning(GstVideoReceiverLog) << "Unable to map screenshot frame" << imageFile;
+        return false;
+    }
+
+    bool converted = false;
+    GstBuffer *outBuffer = gst_buffer_new_wrapped_full(static_cast<GstMemoryFlags>(0), image.bits(), outInfo.size, 0, outInfo.size, nullptr, nullptr);
+    GstVideoFrame outFrame;
+    if (gst_video_frame_map(&outFrame, &outInfo, outBuffer, GST_MAP_WRITE)) {
+        GstVideoConverter *converter = gst_video_converter_new(&inInfo, &outInfo, nullptr);
+        if (converter) {
+            gst_video_converter_frame(converter, &inFrame, &outFrame);
+            gst_video_converter_free(converter);
+            converted = true;
+        }
+        gst_video_frame_unmap(&outFrame);
+    }
+    gst_buffer_unref(outBuffer);
+    gst_video_frame_unmap(&inFrame);
+
+    if (!converted) {
+        qCWarning(GstVideoReceiverLog) << "Unable to convert screenshot frame" << imageFile;
+        return false;
+    }
+
+    const int parN = GST_VIDEO_INFO_PAR_N(&inInfo);
+    const int parD = GST_VIDEO_INFO_PAR_D(&inInfo);
+    if ((parN > 0) && (parD > 0) && (parN != parD)) {
+        image = image.scaled((width * parN) / parD, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    if (!image.save(imageFile)) {
+        qCWarning(GstVideoReceiverLog) << "Unable to write screenshot" << imageFile;
+        return false;
+    }
+
+    return true;
+}
+
 bool GstVideoReceiver::_needDispatch()
 {
     return _worker->needDispatch();
@@ -1276,6 +1507,22 @@ gboolean GstVideoReceiver::_onBusMessage(GstBus * /* bus */, GstMessage *msg, gp
             pThis->_handleEOS();
         });
         break;
+    case GST_MESSAGE_QOS: {
+        // Posted when the video sink drops a frame which arrived too late to be rendered
+        GstObject *videoSink = pThis->_videoSink ? GST_OBJECT(pThis->_videoSink) : nullptr;
+        if (!videoSink || ((GST_MESSAGE_SRC(msg) != videoSink) && !gst_object_has_as_ancestor(GST_MESSAGE_SRC(msg), videoSink))) {
+            break;
+        }
+
+        GstFormat format = GST_FORMAT_UNDEFINED;
+        guint64 processed = 0;
+        guint64 dropped = 0;
+        gst_message_parse_qos_stats(msg, &format, &processed, &dropped);
+        if (format == GST_FORMAT_BUFFERS) {
+            pThis->_latencyStats->setFramesDroppedLate(dropped);
+        }
+        break;
+    }
     case GST_MESSAGE_ELEMENT: {
         const GstStructure *structure = gst_message_get_structure(msg);
         if (!gst_structure_has_name(structure, "GstBinForwarded")) {
@@ -1385,11 +1632,16 @@ gboolean GstVideoReceiver::_padProbe(GstElement *element, GstPad *pad, gpointer
 
 GstPadProbeReturn GstVideoReceiver::_teeProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
 {
-    Q_UNUSED(pad); Q_UNUSED(info)
+    Q_UNUSED(pad)
 
     if (user_data) {
         GstVideoReceiver *pThis = static_cast<GstVideoReceiver*>(user_data);
         pThis->_noteTeeFrame();
+
+        const GstBuffer *buf = gst_pad_probe_info_get_buffer(info);
+        if (buf && GST_BUFFER_PTS_IS_VALID(buf)) {
+            pThis->_latencyStats->recordFrame(VideoLatencyStats::StageSource, GST_BUFFER_PTS(buf), g_get_monotonic_time());
+        }
     }
 
     return GST_PAD_PROBE_OK;
@@ -1397,11 +1649,19 @@ GstPadProbeReturn GstVideoReceiver::_teeProbe(GstPad *pad, GstPadProbeInfo *info
 
 GstPadProbeReturn GstVideoReceiver::_videoSinkProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
 {
-    Q_UNUSED(pad); Q_UNUSED(info)
-
     if (user_data) {
         GstVideoReceiver *pThis = static_cast<GstVideoReceiver*>(user_data);
 
+        GstBuffer *buf = gst_pad_probe_info_get_buffer(info);
+        if (buf && GST_BUFFER_PTS_IS_VALID(buf)) {
+            pThis->_latencyStats->recordFrame(VideoLatencyStats::StageSink, GST_BUFFER_PTS(buf), g_get_monotonic_time());
+            pThis->_noteSinkLateness(pad, buf);
+        }
+
+        if (buf && pThis->_screenshotRequested) {
+            pThis->_noteScreenshotFrame(pad, buf);
+        }
+
         if (pThis->_resetVideoSink) {
             pThis->_resetVideoSink = false;
 
@@ -1476,6 +1736,166 @@ GstPadProbeReturn GstVideoReceiver::_keyframeWatch(GstPad *pad, GstPadProbeInfo
     return GST_PAD_PROBE_REMOVE;
 }
 
+GstPadProbeReturn GstVideoReceiver::_recorderValveProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    if (!info || !user_data) {
+        qCCritical(GstVideoReceiverLog) << "Invalid arguments";
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstVideoReceiver *pThis = static_cast<GstVideoReceiver*>(user_data);
+
+    if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent *event = gst_pad_probe_info_get_event(info);
+        switch (GST_EVENT_TYPE(event)) {
+        case GST_EVENT_CAPS: {
+            // Buffered data belongs to the previous caps, the muxer only gets the new ones
+            GstCaps *caps = nullptr;
+            gst_event_parse_caps(event, &caps);
+            GstCaps *currentCaps = gst_pad_get_current_caps(pad);
+            if (currentCaps && !gst_caps_is_equal(caps, currentCaps)) {
+                pThis->_preRecordBuffer.clear();
+            }
+            gst_clear_caps(&currentCaps);
+            break;
+        }
+        case GST_EVENT_FLUSH_STOP:
+        case GST_EVENT_STREAM_START:
+            pThis->_preRecordBuffer.clear();
+            break;
+        default:
+            break;
+        }
+
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer *buf = gst_pad_probe_info_get_buffer(info);
+    if (!buf) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    PreRecordState state = pThis->_preRecordState.load();
+    if (state == PreRecordState::Capturing) {
+        pThis->_preRecordBuffer.push(buf);
+    } else if ((state == PreRecordState::FlushPending) && pThis->_preRecordState.compare_exchange_strong(state, PreRecordState::Recording)) {
+        if (pThis->_flushPreRecordBuffer(pad, buf)) {
+            // Already pushed along with the ring
+            return GST_PAD_PROBE_DROP;
+        }
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+bool GstVideoReceiver::_flushPreRecordBuffer(GstPad *valveSinkPad, GstBuffer *buffer)
+{
+    QList<GstBuffer*> buffers = _preRecordBuffer.take();
+    if (buffers.isEmpty()) {
+        return false;
+    }
+
+    GstElement *valve = gst_pad_get_parent_element(valveSinkPad);
+    GstPad *valveSrcPad = nullptr;
+    if (valve) {
+        // Open the valve from here as well, the following buffers must not be dropped while the worker catches up
+        g_object_set(valve,
+                     "drop", FALSE,
+                     nullptr);
+        valveSrcPad = gst_element_get_static_pad(valve, "src");
+        gst_clear_object(&valve);
+    }
+    if (!valveSrcPad) {
+        qCCritical(GstVideoReceiverLog) << "gst_element_get_static_pad() failed" << _uri;
+        for (GstBuffer *buf : std::as_const(buffers)) {
+            gst_buffer_unref(buf);
+        }
+        return false;
+    }
+
+    // The closed valve swallowed the sticky events, the muxer needs stream-start, caps and segment first
+    gst_pad_sticky_events_foreach(valveSinkPad, _forwardStickyEvent, valveSrcPad);
+
+    buffers.append(gst_buffer_ref(buffer));
+
+    qsizetype pushed = 0;
+    GstFlowReturn ret = GST_FLOW_OK;
+    for (GstBuffer *buf : std::as_const(buffers)) {
+        if (ret == GST_FLOW_OK) {
+            // gst_pad_push() takes ownership of the buffer
+            ret = gst_pad_push(valveSrcPad, buf);
+            pushed++;
+        } else {
+            gst_buffer_unref(buf);
+        }
+    }
+
+    gst_clear_object(&valveSrcPad);
+
+    if (ret != GST_FLOW_OK) {
+        qCWarning(GstVideoReceiverLog) << "Pre-record flush stopped:" << gst_flow_get_name(ret) << _uri;
+    }
+
+    qCDebug(GstVideoReceiverLog) << "Flushed" << (pushed - 1) << "pre-record buffers" << _uri;
+
+    return true;
+}
+
+gboolean GstVideoReceiver::_forwardStickyEvent(GstPad *pad, GstEvent **event, gpointer user_data)
+{
+    Q_UNUSED(pad)
+
+    if (GST_EVENT_TYPE(*event) != GST_EVENT_EOS) {
+        (void) gst_pad_push_event(GST_PAD(user_data), gst_event_ref(*event));
+    }
+
+    return TRUE;
+}
+
+GstPadProbeReturn GstVideoReceiver::_decoderInputProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    Q_UNUSED(pad)
+
+    const GstBuffer *buf = gst_pad_probe_info_get_buffer(info);
+    if (user_data && buf && GST_BUFFER_PTS_IS_VALID(buf)) {
+        GstVideoReceiver *pThis = static_cast<GstVideoReceiver*>(user_data);
+        pThis->_latencyStats->recordFrame(VideoLatencyStats::StageDecoderInput, GST_BUFFER_PTS(buf), g_get_monotonic_time());
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn GstVideoReceiver::_decoderOutputProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    Q_UNUSED(pad)
+
+    const GstBuffer *buf = gst_pad_probe_info_get_buffer(info);
+    if (user_data && buf && GST_BUFFER_PTS_IS_VALID(buf)) {
+        GstVideoReceiver *pThis = static_cast<GstVideoReceiver*>(user_data);
+        pThis->_latencyStats->recordFrame(VideoLatencyStats::StageDecoderOutput, GST_BUFFER_PTS(buf), g_get_monotonic_time());
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn GstVideoReceiver::_jitterBufferProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    GstBuffer *buf = gst_pad_probe_info_get_buffer(info);
+    if (!user_data || !buf) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    // RTP packets are matched by sequence number, the jitter buffer rewrites their timestamps
+    guint8 seqnum[2];
+    if (gst_buffer_extract(buf, 2, seqnum, sizeof(seqnum)) == sizeof(seqnum)) {
+        GstVideoReceiver *pThis = static_cast<GstVideoReceiver*>(user_data);
+        const bool input = (GST_PAD_DIRECTION(pad) == GST_PAD_SINK);
+        pThis->_latencyStats->recordJitterBufferPacket(input, static_cast<quint16>((seqnum[0] << 8) | seqnum[1]), g_get_monotonic_time());
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
 GstVideoWorker::GstVideoWorker(QObject *parent)
     : QThread(parent)
 {
@@ -12,14 +12,20 @@
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QMutex>
 #include <QtCore/QQueue>
+#include <QtCore/QStringList>
 #include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <QtCore/QTimer>
 #include <QtCore/QWaitCondition>
 
+#include <atomic>
+
 #include <glib.h>
 #include <gst/gstelement.h>
 #include <gst/gstpad.h>
+#include <gst/gstsample.h>
 
+#include "GstPreRecordBuffer.h"
 #include "VideoReceiver.h"
 
 Q_DECLARE_LOGGING_CATEGORY(GstVideoReceiverLog)
@@ -85,6 +91,12 @@ private slots:
     void _noteTeeFrame();
     void _noteVideoSinkFrame();
     void _noteEndOfStream();
+    void _noteSinkLateness(GstPad *pad, GstBuffer *buffer);
+    /// Pushes the pre-record ring and the current buffer past the recorder valve, from its streaming thread
+    bool _flushPreRecordBuffer(GstPad *valveSinkPad, GstBuffer *buffer);
+    /// Hands the buffer to the screenshot pool if screenshots are pending, from the video sink's streaming thread
+    void _noteScreenshotFrame(GstPad *pad, GstBuffer *buffer);
+    void _failPendingScreenshots();
     /// -Unlink the branch from the src pad
     /// -Send an EOS event at the beginning of that branch
     bool _unlinkBranch(GstElement *from);
@@ -105,8 +117,22 @@ private slots:
     static GstPadProbeReturn _videoSinkProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
     static GstPadProbeReturn _eosProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
     static GstPadProbeReturn _keyframeWatch(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+    static GstPadProbeReturn _decoderInputProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+    static GstPadProbeReturn _decoderOutputProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+    static GstPadProbeReturn _jitterBufferProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+    static GstPadProbeReturn _recorderValveProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+    static gboolean _forwardStickyEvent(GstPad *pad, GstEvent **event, gpointer user_data);
+    static bool _saveScreenshot(GstSample *sample, const QString &imageFile);
+
+    enum class PreRecordState {
+        Idle,           ///< No pipeline
+        Capturing,      ///< Recorder valve closed, buffers go to the pre-record ring
+        FlushPending,   ///< Recording requested, the next buffer flushes the ring
+        Recording       ///< Recorder valve open
+    };
 
     GstElement *_decoder = nullptr;
+    GstElement *_decoderQueue = nullptr;
     GstElement *_decoderValve = nullptr;
     GstElement *_fileSink = nullptr;
     GstElement *_pipeline = nullptr;
@@ -117,6 +143,15 @@ private slots:
     GstVideoWorker *_worker = nullptr;
     gulong _teeProbeId = 0;
     gulong _videoSinkProbeId = 0;
+    GstPreRecordBuffer _preRecordBuffer;
+    std::atomic<PreRecordState> _preRecordState = PreRecordState::Idle;
+    QThreadPool _screenshotPool;
+    QMutex _screenshotMutex;
+    QStringList _screenshotFiles;
+    std::atomic<bool> _screenshotRequested = false;
+    std::atomic<int> _pendingScreenshots = 0;
+
+    static constexpr int _kMaxPendingScreenshots = 8;
 
     static constexpr const char *_kFileMux[FILE_FORMAT_MAX + 1] = {
         "matroskamux",
@@ -16,6 +16,7 @@
 
 class QGCVideoStreamInfo;
 class QQuickItem;
+class VideoLatencyStats;
 
 class VideoReceiver : public QObject
 {
@@ -35,8 +36,11 @@ class VideoReceiver : public QObject
     QString uri() const { return _uri; }
     bool started() const { return _started; }
     bool lowLatency() const { return _lowLatency; }
+    uint32_t preRecordSeconds() const { return _preRecordSeconds; }
     QGCVideoStreamInfo *videoStreamInfo() { return _videoStreamInfo; }
     QString recordingOutput() const { return _recordingOutput; }
+    /// @return Pipeline latency statistics, nullptr if the receiver does not provide them
+    VideoLatencyStats *latencyStats() { return _latencyStats; }
 
     virtual void setSink(void *sink) { if (sink != _sink) { _sink = sink; emit sinkChanged(_sink); } }
     virtual void setWidget(QQuickItem *widget) { if (widget != _widget) { _widget = widget; emit widgetChanged(_widget); } }
@@ -44,6 +48,7 @@ class VideoReceiver : public QObject
     void setUri(const QString &uri) { if (uri != _uri) { _uri = uri; emit uriChanged(_uri); } }
     void setStarted(bool started) { if (started != _started) { _started = started; emit startedChanged(_started); } }
     void setLowLatency(bool lowLatency) { if (lowLatency != _lowLatency) { _lowLatency = lowLatency; emit lowLatencyChanged(_lowLatency); } }
+    void setPreRecordSeconds(uint32_t seconds) { if (seconds != _preRecordSeconds) { _preRecordSeconds = seconds; emit preRecordSecondsChanged(_preRecordSeconds); } }
     void setVideoStreamInfo(QGCVideoStreamInfo *videoStreamInfo) { if (videoStreamInfo != _videoStreamInfo) { _videoStreamInfo = videoStreamInfo; emit videoStreamInfoChanged(); } }
 
     // QMediaFormat::FileFormat
@@ -82,6 +87,7 @@ class VideoReceiver : public QObject
     void uriChanged(const QString &uri);
     void startedChanged(bool started);
     void lowLatencyChanged(bool lowLatency);
+    void preRecordSecondsChanged(uint32_t seconds);
     void videoStreamInfoChanged();
     void widgetChanged(QQuickItem *widget);
 
@@ -106,6 +112,7 @@ public slots:
     void *_sink = nullptr;
     QQuickItem *_widget = nullptr;
     QGCVideoStreamInfo *_videoStreamInfo = nullptr;
+    VideoLatencyStats *_latencyStats = nullptr;
     QString _name;
     QString _uri;
     bool _started = false;
@@ -113,6 +120,8 @@ public slots:
     bool _recording = false;
     bool _streaming = false;
     bool _lowLatency = false;
+    // Seconds of encoded stream kept in memory and written ahead of a new recording, 0 - disabled
+    uint32_t _preRecordSeconds = 0;
     bool _resetVideoSink = false;
     bool _endOfStream = false;
     bool _removingDecoder = false;
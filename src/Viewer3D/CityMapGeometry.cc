@@ -8,21 +8,15 @@
  ****************************************************************************/
 
 #include "CityMapGeometry.h"
-#include "SettingsManager.h"
-#include "Viewer3DSettings.h"
 #include "OsmParser.h"
 
+#include <algorithm>
+#include <limits>
+
 CityMapGeometry::CityMapGeometry()
 {
     _osmParser = nullptr;
     _modelName = "city_map_defualt_name";
-    _vertexData.clear();
-    _mapLoadedFlag = 0;
-
-    _viewer3DSettings = SettingsManager::instance()->viewer3DSettings();
-
-    setOsmFilePath(_viewer3DSettings->osmFilePath()->rawValue());
-    connect(_viewer3DSettings->osmFilePath(), &Fact::rawValueChanged, this, &CityMapGeometry::setOsmFilePath);
 }
 
 void CityMapGeometry::setModelName(QString modelName)
@@ -33,66 +27,81 @@ void CityMapGeometry::setModelName(QString modelName)
     emit modelNameChanged();
 }
 
-void CityMapGeometry::setOsmFilePath(QVariant value)
-{
-    clearViewer();
-    _mapLoadedFlag = 0;
-    _osmFilePath = value.toString();
-    emit osmFilePathChanged();
-    loadOsmMap();
-}
-
 void CityMapGeometry::setOsmParser(OsmParser *newOsmParser)
 {
+    if(_osmParser == newOsmParser){
+        return;
+    }
+
+    if(_osmParser){
+        disconnect(_osmParser, nullptr, this, nullptr);
+    }
     _osmParser = newOsmParser;
 
     if(_osmParser){
-        connect(_osmParser, &OsmParser::buildingLevelHeightChanged, this, &CityMapGeometry::updateViewer);
-        connect(_osmParser, &OsmParser::mapChanged, this, &CityMapGeometry::updateViewer);
+        connect(_osmParser, &OsmParser::meshChanged, this, &CityMapGeometry::updateViewer);
     }
     emit osmParserChanged();
-    loadOsmMap();
+    updateViewer();
 }
 
-bool CityMapGeometry::loadOsmMap()
+void CityMapGeometry::setChunkIndex(int chunkIndex)
 {
-    if(!_osmParser){
-        return false;
+    if(_chunkIndex == chunkIndex){
+        return;
     }
 
-    _osmParser->parseOsmFile(_osmFilePath);
-    return false;
+    _chunkIndex = chunkIndex;
+    emit chunkIndexChanged();
+    updateViewer();
 }
 
 void CityMapGeometry::updateViewer()
 {
     clear();
 
-    if(!_osmParser){
+    if(!_osmParser || (_chunkIndex >= _osmParser->meshChunkCount())){
+        update();
         return;
     }
 
-    if(_osmParser->mapLoaded()){
-        _vertexData = _osmParser->buildingToMesh();
+    OsmParser::MeshChunk mesh;
+    if(_chunkIndex >= 0){
+        mesh = _osmParser->meshChunk(_chunkIndex);
+    }else{
+        // Merge all chunks, indices are offset by the vertices of the preceding chunks
+        mesh.boundsMin = QVector3D(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        mesh.boundsMax = QVector3D(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+        for(int i = 0; i < _osmParser->meshChunkCount(); i++){
+            const OsmParser::MeshChunk chunk = _osmParser->meshChunk(i);
+            const uint32_t vertexOffset = static_cast<uint32_t>(mesh.vertexData.size() / (3 * sizeof(float)));
+            const qsizetype indexStart = mesh.indexData.size();
+            mesh.vertexData.append(chunk.vertexData);
+            mesh.indexData.append(chunk.indexData);
+            uint32_t *index = reinterpret_cast<uint32_t*>(mesh.indexData.data() + indexStart);
+            uint32_t *indexEnd = reinterpret_cast<uint32_t*>(mesh.indexData.data() + mesh.indexData.size());
+            for(; index != indexEnd; ++index){
+                *index += vertexOffset;
+            }
+            mesh.boundsMin = QVector3D(std::min(mesh.boundsMin.x(), chunk.boundsMin.x()), std::min(mesh.boundsMin.y(), chunk.boundsMin.y()), std::min(mesh.boundsMin.z(), chunk.boundsMin.z()));
+            mesh.boundsMax = QVector3D(std::max(mesh.boundsMax.x(), chunk.boundsMax.x()), std::max(mesh.boundsMax.y(), chunk.boundsMax.y()), std::max(mesh.boundsMax.z(), chunk.boundsMax.z()));
+        }
+    }
 
-        int stride = 3 * sizeof(float);
-        if(!_vertexData.isEmpty()){
-            setVertexData(_vertexData);
-            setStride(stride);
+    if(!mesh.indexData.isEmpty()){
+        setVertexData(mesh.vertexData);
+        setIndexData(mesh.indexData);
+        setStride(3 * sizeof(float));
+        setBounds(mesh.boundsMin, mesh.boundsMax);
 
-            setPrimitiveType(QQuick3DGeometry::PrimitiveType::Triangles);
+        setPrimitiveType(QQuick3DGeometry::PrimitiveType::Triangles);
 
-            addAttribute(QQuick3DGeometry::Attribute::PositionSemantic,
-                         0,
-                         QQuick3DGeometry::Attribute::F32Type);
-        }
-        update();
+        addAttribute(QQuick3DGeometry::Attribute::PositionSemantic,
+                     0,
+                     QQuick3DGeometry::Attribute::F32Type);
+        addAttribute(QQuick3DGeometry::Attribute::IndexSemantic,
+                     0,
+                     QQuick3DGeometry::Attribute::U32Type);
     }
-}
-
-void CityMapGeometry::clearViewer()
-{
-    clear();
-    _vertexData.clear();
     update();
 }
@@ -15,7 +15,6 @@
 
 ///     @author Omid Esrafilian <esrafilian.omid@gmail.com>
 
-class Viewer3DSettings;
 class OsmParser;
 
 class CityMapGeometry : public QQuick3DGeometry
@@ -26,6 +25,7 @@ class CityMapGeometry : public QQuick3DGeometry
 
     Q_PROPERTY(QString modelName READ modelName WRITE setModelName NOTIFY modelNameChanged)
     Q_PROPERTY(OsmParser* osmParser READ osmParser WRITE setOsmParser NOTIFY osmParserChanged)
+    Q_PROPERTY(int chunkIndex READ chunkIndex WRITE setChunkIndex NOTIFY chunkIndexChanged)
 
 public:
 
@@ -34,29 +34,22 @@ class CityMapGeometry : public QQuick3DGeometry
     QString modelName() const { return _modelName; }
     void setModelName(QString modelName);
 
-    QString osmFilePath() const {return _osmFilePath;}
-
     OsmParser* osmParser(){ return _osmParser;}
     void setOsmParser(OsmParser* newOsmParser);
 
-    bool loadOsmMap();
+    /// Mesh chunk of the osm parser which is shown, -1 shows all chunks as a single geometry
+    int chunkIndex() const { return _chunkIndex; }
+    void setChunkIndex(int chunkIndex);
 
 signals:
     void modelNameChanged();
-    void osmFilePathChanged();
     void osmParserChanged();
+    void chunkIndexChanged();
 
 private:
     void updateViewer();
-    void clearViewer();
 
     QString _modelName;
-    QString _osmFilePath;
-    QByteArray _vertexData;
     OsmParser *_osmParser;
-    bool _mapLoadedFlag;
-    Viewer3DSettings* _viewer3DSettings = nullptr;
-
-private slots:
-    void setOsmFilePath(QVariant value);
+    int _chunkIndex = -1;
 };
@@ -0,0 +1,351 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "OsmMeshCache.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+
+QGC_LOGGING_CATEGORY(OsmMeshCacheLog, "Viewer3D.OsmMeshCache")
+
+namespace {
+
+constexpr const char buildingsMagic[] = "QGC3DBLD";
+constexpr const char meshMagic[] = "QGC3DMSH";
+constexpr int magicSize = 8;
+
+void writeCoordinates(QDataStream &stream, const std::vector<QGeoCoordinate> &coordinates)
+{
+    stream << static_cast<quint64>(coordinates.size());
+    for (const QGeoCoordinate &coordinate : coordinates) {
+        stream << coordinate;
+    }
+}
+
+bool readCoordinates(QDataStream &stream, std::vector<QGeoCoordinate> &coordinates)
+{
+    quint64 count = 0;
+    stream >> count;
+    if ((stream.status() != QDataStream::Ok) || (count > static_cast<quint64>(stream.device()->bytesAvailable()))) {
+        return false;
+    }
+
+    coordinates.resize(count);
+    for (QGeoCoordinate &coordinate : coordinates) {
+        stream >> coordinate;
+    }
+    return (stream.status() == QDataStream::Ok);
+}
+
+// Arrays of plain values are stored as raw blobs so loading them is a single copy out of the mapped file.
+// All supported platforms are little endian.
+template<typename T>
+void writeBlob(QDataStream &stream, const T *data, size_t count)
+{
+    stream << static_cast<quint64>(count * sizeof(T));
+    (void) stream.writeRawData(reinterpret_cast<const char*>(data), static_cast<int>(count * sizeof(T)));
+}
+
+template<typename T>
+bool readBlob(QDataStream &stream, std::vector<T> &values)
+{
+    quint64 size = 0;
+    stream >> size;
+    if ((stream.status() != QDataStream::Ok) || (size % sizeof(T)) || (size > static_cast<quint64>(stream.device()->bytesAvailable()))) {
+        return false;
+    }
+
+    values.resize(size / sizeof(T));
+    return (stream.readRawData(reinterpret_cast<char*>(values.data()), static_cast<int>(size)) == static_cast<int>(size));
+}
+
+bool readBlob(QDataStream &stream, QByteArray &data)
+{
+    quint64 size = 0;
+    stream >> size;
+    if ((stream.status() != QDataStream::Ok) || (size > static_cast<quint64>(stream.device()->bytesAvailable()))) {
+        return false;
+    }
+
+    data.resize(static_cast<qsizetype>(size));
+    return (stream.readRawData(data.data(), static_cast<int>(size)) == static_cast<int>(size));
+}
+
+void initStream(QDataStream &stream)
+{
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+}
+
+/// Maps the file and validates its header
+/// @return Mapped file content following the header, empty if the file is missing or invalid
+QByteArray mapCacheFile(QFile &file, const char *magic)
+{
+    if (!file.open(QIODevice::ReadOnly) || (file.size() < (magicSize + 4))) {
+        return QByteArray();
+    }
+
+    const uchar *mapped = file.map(0, file.size());
+    if (!mapped) {
+        qCWarning(OsmMeshCacheLog) << "Failed to map" << file.fileName() << file.errorString();
+        return QByteArray();
+    }
+
+    const QByteArray content = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), static_cast<qsizetype>(file.size()));
+    if (!content.startsWith(QByteArrayView(magic, magicSize))) {
+        qCDebug(OsmMeshCacheLog) << "Invalid header" << file.fileName();
+        return QByteArray();
+    }
+
+    QDataStream stream(content);
+    initStream(stream);
+    (void) stream.skipRawData(magicSize);
+    quint32 fileVersion = 0;
+    stream >> fileVersion;
+    if (fileVersion != OsmMeshCache::version) {
+        qCDebug(OsmMeshCacheLog) << "Version mismatch" << file.fileName() << fileVersion;
+        return QByteArray();
+    }
+
+    // Mark as recently used for pruning
+    (void) file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+
+    return QByteArray::fromRawData(content.constData() + magicSize + 4, content.size() - magicSize - 4);
+}
+
+QByteArray fileHeader(const char *magic)
+{
+    QByteArray header(magic, magicSize);
+    QDataStream stream(&header, QIODevice::Append);
+    initStream(stream);
+    stream << OsmMeshCache::version;
+    return header;
+}
+
+}
+
+OsmMeshCache::OsmMeshCache(const QString &cacheDir, int maxNumFiles)
+    : _cacheDir(cacheDir)
+    , _maxNumFiles(maxNumFiles)
+{
+    // qCDebug(OsmMeshCacheLog) << Q_FUNC_INFO << this;
+}
+
+QString OsmMeshCache::defaultCacheDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/QGCViewer3DCache");
+}
+
+QByteArray OsmMeshCache::hashFile(QIODevice &device)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!hash.addData(&device)) {
+        return QByteArray();
+    }
+
+    return hash.result().toHex();
+}
+
+QString OsmMeshCache::_buildingsFileName(const QByteArray &fileHash) const
+{
+    return QStringLiteral("%1/%2.buildings").arg(_cacheDir, QString::fromLatin1(fileHash));
+}
+
+QString OsmMeshCache::_meshFileName(const QByteArray &fileHash, float buildingLevelHeight, float chunkSize) const
+{
+    return QStringLiteral("%1/%2_%3_%4.mesh").arg(_cacheDir, QString::fromLatin1(fileHash))
+        .arg(buildingLevelHeight, 0, 'f', 3).arg(chunkSize, 0, 'f', 1);
+}
+
+bool OsmMeshCache::loadBuildings(const QByteArray &fileHash, QHash<uint64_t, OsmParserThread::BuildingType_t> &buildings, QGeoCoordinate &coordinateMin, QGeoCoordinate &coordinateMax, QGeoCoordinate &gpsRef) const
+{
+    if (fileHash.isEmpty()) {
+        return false;
+    }
+
+    QFile file(_buildingsFileName(fileHash));
+    const QByteArray content = mapCacheFile(file, buildingsMagic);
+    if (content.isEmpty()) {
+        return false;
+    }
+
+    QDataStream stream(content);
+    initStream(stream);
+
+    quint32 count = 0;
+    stream >> coordinateMin >> coordinateMax >> gpsRef >> count;
+    if (count > static_cast<quint32>(content.size())) {
+        return false;
+    }
+
+    QHash<uint64_t, OsmParserThread::BuildingType_t> loaded;
+    loaded.reserve(count);
+    for (quint32 i = 0; i < count; i++) {
+        quint64 id = 0;
+        OsmParserThread::BuildingType_t building;
+        stream >> id >> building.height >> building.levels;
+
+        float bb[4] = {};
+        stream >> bb[0] >> bb[1] >> bb[2] >> bb[3];
+        building.bb_min = QVector2D(bb[0], bb[1]);
+        building.bb_max = QVector2D(bb[2], bb[3]);
+
+        if (!readCoordinates(stream, building.points_gps) || !readCoordinates(stream, building.points_gps_inner) ||
+            !readBlob(stream, building.points_local) || !readBlob(stream, building.points_local_inner)) {
+            qCWarning(OsmMeshCacheLog) << "Corrupt buildings cache" << file.fileName();
+            return false;
+        }
+        loaded.insert(id, std::move(building));
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(OsmMeshCacheLog) << "Corrupt buildings cache" << file.fileName();
+        return false;
+    }
+
+    buildings = std::move(loaded);
+    qCDebug(OsmMeshCacheLog) << "Loaded" << buildings.count() << "buildings from" << file.fileName();
+    return true;
+}
+
+bool OsmMeshCache::saveBuildings(const QByteArray &fileHash, const QHash<uint64_t, OsmParserThread::BuildingType_t> &buildings, const QGeoCoordinate &coordinateMin, const QGeoCoordinate &coordinateMax, const QGeoCoordinate &gpsRef) const
+{
+    if (fileHash.isEmpty()) {
+        return false;
+    }
+
+    QByteArray data = fileHeader(buildingsMagic);
+    QDataStream stream(&data, QIODevice::Append);
+    initStream(stream);
+
+    stream << coordinateMin << coordinateMax << gpsRef << static_cast<quint32>(buildings.count());
+    for (auto it = buildings.cbegin(), end = buildings.cend(); it != end; ++it) {
+        const OsmParserThread::BuildingType_t &building = it.value();
+        stream << static_cast<quint64>(it.key()) << building.height << building.levels;
+        stream << building.bb_min.x() << building.bb_min.y() << building.bb_max.x() << building.bb_max.y();
+        writeCoordinates(stream, building.points_gps);
+        writeCoordinates(stream, building.points_gps_inner);
+        writeBlob(stream, building.points_local.data(), building.points_local.size());
+        writeBlob(stream, building.points_local_inner.data(), building.points_local_inner.size());
+    }
+
+    return _writeFile(_buildingsFileName(fileHash), data);
+}
+
+bool OsmMeshCache::loadMesh(const QByteArray &fileHash, float buildingLevelHeight, float chunkSize, QList<OsmParser::MeshChunk> &chunks) const
+{
+    if (fileHash.isEmpty()) {
+        return false;
+    }
+
+    QFile file(_meshFileName(fileHash, buildingLevelHeight, chunkSize));
+    const QByteArray content = mapCacheFile(file, meshMagic);
+    if (content.isEmpty()) {
+        return false;
+    }
+
+    QDataStream stream(content);
+    initStream(stream);
+
+    float storedLevelHeight = 0, storedChunkSize = 0;
+    quint32 count = 0;
+    stream >> storedLevelHeight >> storedChunkSize >> count;
+    if ((storedLevelHeight != buildingLevelHeight) || (storedChunkSize != chunkSize) || (count > static_cast<quint32>(content.size()))) {
+        return false;
+    }
+
+    QList<OsmParser::MeshChunk> loaded;
+    loaded.reserve(count);
+    for (quint32 i = 0; i < count; i++) {
+        OsmParser::MeshChunk chunk;
+        float bounds[6] = {};
+        for (float &value : bounds) {
+            stream >> value;
+        }
+        chunk.boundsMin = QVector3D(bounds[0], bounds[1], bounds[2]);
+        chunk.boundsMax = QVector3D(bounds[3], bounds[4], bounds[5]);
+
+        if (!readBlob(stream, chunk.vertexData) || !readBlob(stream, chunk.indexData)) {
+            qCWarning(OsmMeshCacheLog) << "Corrupt mesh cache" << file.fileName();
+            return false;
+        }
+        loaded.append(chunk);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(OsmMeshCacheLog) << "Corrupt mesh cache" << file.fileName();
+        return false;
+    }
+
+    chunks = std::move(loaded);
+    qCDebug(OsmMeshCacheLog) << "Loaded" << chunks.count() << "mesh chunks from" << file.fileName();
+    return true;
+}
+
+bool OsmMeshCache::saveMesh(const QByteArray &fileHash, float buildingLevelHeight, float chunkSize, const QList<OsmParser::MeshChunk> &chunks) const
+{
+    if (fileHash.isEmpty()) {
+        return false;
+    }
+
+    qsizetype size = 0;
+    for (const OsmParser::MeshChunk &chunk : chunks) {
+        size += chunk.vertexData.size() + chunk.indexData.size() + 64;
+    }
+
+    QByteArray data = fileHeader(meshMagic);
+    data.reserve(data.size() + size + 16);
+    QDataStream stream(&data, QIODevice::Append);
+    initStream(stream);
+
+    stream << buildingLevelHeight << chunkSize << static_cast<quint32>(chunks.count());
+    for (const OsmParser::MeshChunk &chunk : chunks) {
+        stream << chunk.boundsMin.x() << chunk.boundsMin.y() << chunk.boundsMin.z();
+        stream << chunk.boundsMax.x() << chunk.boundsMax.y() << chunk.boundsMax.z();
+        writeBlob(stream, chunk.vertexData.constData(), static_cast<size_t>(chunk.vertexData.size()));
+        writeBlob(stream, chunk.indexData.constData(), static_cast<size_t>(chunk.indexData.size()));
+    }
+
+    return _writeFile(_meshFileName(fileHash, buildingLevelHeight, chunkSize), data);
+}
+
+bool OsmMeshCache::_writeFile(const QString &fileName, const QByteArray &data) const
+{
+    if (!QDir().mkpath(_cacheDir)) {
+        qCWarning(OsmMeshCacheLog) << "Failed to create cache directory" << _cacheDir;
+        return false;
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || (file.write(data) != data.size()) || !file.commit()) {
+        qCWarning(OsmMeshCacheLog) << "Failed to write" << fileName << file.errorString();
+        return false;
+    }
+
+    qCDebug(OsmMeshCacheLog) << "Saved" << fileName << data.size() << "bytes";
+    _prune();
+    return true;
+}
+
+void OsmMeshCache::_prune() const
+{
+    const QDir dir(_cacheDir);
+    const QFileInfoList files = dir.entryInfoList({ QStringLiteral("*.buildings"), QStringLiteral("*.mesh") }, QDir::Files, QDir::Time);
+    for (qsizetype i = _maxNumFiles; i < files.count(); i++) {
+        qCDebug(OsmMeshCacheLog) << "Pruning" << files[i].fileName();
+        (void) QFile::remove(files[i].absoluteFilePath());
+    }
+}
@@ -0,0 +1,61 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QString>
+
+#include "OsmParser.h"
+#include "OsmParserThread.h"
+
+class QIODevice;
+
+Q_DECLARE_LOGGING_CATEGORY(OsmMeshCacheLog)
+
+/// On-disk cache for the 3D viewer. Parsed buildings are keyed by the hash of the OSM file content, the
+/// generated mesh chunks additionally by the mesh parameters. Reopening the viewer for a known map then
+/// skips both parsing and triangulation.
+///
+/// Files are versioned binary (little endian) and are memory mapped when loaded. Any file which does not
+/// match the expected magic, version or size is treated as a cache miss and replaced by the next save.
+/// Writes are atomic so the cache can be used from several threads at once.
+class OsmMeshCache
+{
+public:
+    explicit OsmMeshCache(const QString &cacheDir = defaultCacheDir(), int maxNumFiles = defaultMaxNumFiles);
+
+    static QString defaultCacheDir();
+
+    /// @return Hex encoded hash of the remaining content of the device, empty on read error
+    static QByteArray hashFile(QIODevice &device);
+
+    bool loadBuildings(const QByteArray &fileHash, QHash<uint64_t, OsmParserThread::BuildingType_t> &buildings, QGeoCoordinate &coordinateMin, QGeoCoordinate &coordinateMax, QGeoCoordinate &gpsRef) const;
+    bool saveBuildings(const QByteArray &fileHash, const QHash<uint64_t, OsmParserThread::BuildingType_t> &buildings, const QGeoCoordinate &coordinateMin, const QGeoCoordinate &coordinateMax, const QGeoCoordinate &gpsRef) const;
+
+    bool loadMesh(const QByteArray &fileHash, float buildingLevelHeight, float chunkSize, QList<OsmParser::MeshChunk> &chunks) const;
+    bool saveMesh(const QByteArray &fileHash, float buildingLevelHeight, float chunkSize, const QList<OsmParser::MeshChunk> &chunks) const;
+
+    static constexpr quint32 version = 1;
+    static constexpr int defaultMaxNumFiles = 32;
+
+private:
+    QString _buildingsFileName(const QByteArray &fileHash) const;
+    QString _meshFileName(const QByteArray &fileHash, float buildingLevelHeight, float chunkSize) const;
+    bool _writeFile(const QString &fileName, const QByteArray &data) const;
+
+    /// Removes the least recently modified files above the maximum file count
+    void _prune() const;
+
+    QString _cacheDir;
+    int _maxNumFiles;
+};
@@ -8,33 +8,28 @@
  ****************************************************************************/
 
 #include "OsmParser.h"
+#include "OsmMeshCache.h"
 #include "SettingsManager.h"
 #include "Viewer3DSettings.h"
 #include "OsmParserThread.h"
+#include "QGCLoggingCategory.h"
 #include "earcut.hpp"
 
-typedef union {
-    uint array[3];
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QThreadPool>
 
-    struct {
-        uint x;
-        uint y;
-        uint z;
-    } axis;
-} vec3i;
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+QGC_LOGGING_CATEGORY(OsmParserLog, "Viewer3D.OsmParser")
 
 OsmParser::OsmParser(QObject *parent)
     : QObject{parent}
 {
     _osmParserWorker = new OsmParserThread();
-    _singleStoreyBuildings.append("bungalow");
-    _singleStoreyBuildings.append("shed");
-    _singleStoreyBuildings.append("kiosk");
-    _singleStoreyBuildings.append("cabin");
-
-    _doubleStoreyLeisure.append("stadium");
-    _doubleStoreyLeisure.append("sports_hall");
-    _doubleStoreyLeisure.append("sauna");
 
     _viewer3DSettings = SettingsManager::instance()->viewer3DSettings();
 
@@ -44,6 +39,16 @@ OsmParser::OsmParser(QObject *parent)
     setBuildingLevelHeight(_viewer3DSettings->buildingLevelHeight()->rawValue()); // meters
     connect(_viewer3DSettings->buildingLevelHeight(), &Fact::rawValueChanged, this, &OsmParser::setBuildingLevelHeight);
     connect(_osmParserWorker, &OsmParserThread::fileParsed, this, &OsmParser::osmParserFinished);
+    connect(_osmParserWorker, &OsmParserThread::parseProgress, this, &OsmParser::mapLoadingProgress);
+
+    // The mesh is regenerated off the main thread whenever the map or the building height changes
+    connect(this, &OsmParser::mapChanged, this, &OsmParser::updateMesh);
+    connect(this, &OsmParser::buildingLevelHeightChanged, this, &OsmParser::updateMesh);
+    connect(&_meshWatcher, &QFutureWatcher<QList<MeshChunk>>::finished, this, &OsmParser::meshGenerationFinished);
+
+    // The map is loaded here rather than by the geometries, since every mesh chunk has its own geometry
+    connect(_viewer3DSettings->osmFilePath(), &Fact::rawValueChanged, this, &OsmParser::setOsmFilePath);
+    setOsmFilePath(_viewer3DSettings->osmFilePath()->rawValue());
 }
 
 void OsmParser::setGpsRef(QGeoCoordinate gpsRef)
@@ -66,6 +71,11 @@ void OsmParser::setBuildingLevelHeight(QVariant value)
     emit buildingLevelHeightChanged();
 }
 
+void OsmParser::setOsmFilePath(QVariant value)
+{
+    parseOsmFile(value.toString());
+}
+
 void OsmParser::osmParserFinished(bool isValid)
 {
     if(isValid){
@@ -83,142 +93,179 @@ void OsmParser::osmParserFinished(bool isValid)
 
 void OsmParser::parseOsmFile(QString filePath)
 {
-    _osmParserWorker->mapNodes.clear();
     _osmParserWorker->mapBuildings.clear();
     _gpsRefSet = false;
     _mapLoadedFlag = false;
     resetGpsRef();
+    updateMesh();
 
     _osmParserWorker->start(filePath);
 }
 
-QByteArray OsmParser::buildingToMesh()
+void OsmParser::updateMesh()
 {
-    QByteArray vertexData;
+    if(!_mapLoadedFlag){
+        // Any generation still running is for the previous map, its result must not be published
+        _meshWatcher.setFuture(QFuture<QList<MeshChunk>>());
+        if(!_meshChunks.isEmpty()){
+            _meshChunks.clear();
+            emit meshChanged();
+        }
+        return;
+    }
 
-    for (auto ii = _osmParserWorker->mapBuildings.begin(), end = _osmParserWorker->mapBuildings.end(); ii != end; ++ii) {
-        float bld_height = 0;
-        // std::vector<std::array<float, 2> > bld_points;
-        // std::vector<std::vector<std::array<float, 2> > > polygon;
+    // A previous generation which is still running is superseded, the watcher only reports the latest one
+    const QHash<uint64_t, OsmParserThread::BuildingType_t> buildings = _osmParserWorker->mapBuildings;
+    const QByteArray fileHash = _osmParserWorker->fileHash;
+    const float levelHeight = _buildingLevelHeight;
+    _meshWatcher.setFuture(QtConcurrent::run([buildings, fileHash, levelHeight]() {
+        const OsmMeshCache cache;
+        QList<MeshChunk> chunks;
+        if(!cache.loadMesh(fileHash, levelHeight, defaultMeshChunkSize, chunks)){
+            chunks = buildMeshChunks(buildings, levelHeight);
+            (void) cache.saveMesh(fileHash, levelHeight, defaultMeshChunkSize, chunks);
+        }
+        return chunks;
+    }));
+}
 
-        std::vector<std::array<float, 2> > all_bld_points;
-        std::vector<std::array<float, 2> > bld_points;
-        std::vector<std::vector<std::array<float, 2> > > polygon;
-        std::vector<QVector3D> triangulated_mesh;
+void OsmParser::meshGenerationFinished()
+{
+    if(_meshWatcher.future().resultCount() == 0){
+        return;
+    }
+
+    _meshChunks = _meshWatcher.result();
+
+    qsizetype indexCount = 0;
+    for(const MeshChunk &chunk : std::as_const(_meshChunks)){
+        indexCount += chunk.indexData.size() / static_cast<qsizetype>(sizeof(uint32_t));
+    }
+    qCDebug(OsmParserLog) << _meshChunks.size() << "mesh chunks," << indexCount / 3 << "triangles";
 
-        //        bld_height = (ii.value().height >= ii.value().levels * _buildingLevelHeight)?(ii.value().height):(ii.value().levels * _buildingLevelHeight);
+    emit meshChanged();
+}
+
+namespace {
+
+using BuildingList = QList<const OsmParserThread::BuildingType_t*>;
+
+float buildingHeight(const OsmParserThread::BuildingType_t &building, float buildingLevelHeight)
+{
+    if(building.height > 0){
+        return building.height;
+    }
+    if(building.levels > 0){
+        return building.levels * buildingLevelHeight;
+    }
+    return 0;
+}
 
-        if(ii.value().height > 0){
-            bld_height = ii.value().height;
-        }else if(ii.value().levels > 0){
-            bld_height = (float)(ii.value().levels) * _buildingLevelHeight;
-        }else{
+/// Adds the walls of one ring. Wall quads use the shared roof and floor vertices and are emitted with both
+/// windings so they are visible from either side, like the rest of the building.
+void appendWalls(std::vector<uint32_t> &indices, uint32_t top, uint32_t bottom, const std::vector<QVector2D> &ring)
+{
+    const uint32_t count = static_cast<uint32_t>(ring.size());
+    for(uint32_t i = 0; i < count; i++){
+        const uint32_t j = (i + 1 < count) ? (i + 1) : 0;
+        if(ring[i] == ring[j]){
+            // OSM closed ways repeat the first node at the end
             continue;
         }
 
-        for(unsigned int jj=0; jj<ii.value().points_local.size(); jj++) {
-            bld_points.push_back({ii.value().points_local[jj].x(), ii.value().points_local[jj].y()});
-            all_bld_points.push_back({ii.value().points_local[jj].x(), ii.value().points_local[jj].y()});
+        const uint32_t ti = top + i, tj = top + j, bi = bottom + i, bj = bottom + j;
+        indices.insert(indices.end(), { bi, bj, ti,   bj, tj, ti });
+        indices.insert(indices.end(), { bj, bi, tj,   bi, ti, tj });
+    }
+}
+
+OsmParser::MeshChunk triangulateChunk(const BuildingList &buildings, float buildingLevelHeight)
+{
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<std::vector<std::array<float, 2>>> polygon;
+    QVector3D boundsMin(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), 0);
+    QVector3D boundsMax(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), 0);
+
+    for(const OsmParserThread::BuildingType_t *building : buildings){
+        const float height = buildingHeight(*building, buildingLevelHeight);
+        if(height <= 0 || building->points_local.size() < 3){
+            continue;
         }
-        polygon.push_back(bld_points);
 
-        bld_points.clear();
-        for(unsigned int jj=0; jj<ii.value().points_local_inner.size(); jj++) {
-            bld_points.push_back({ii.value().points_local_inner[jj].x(), ii.value().points_local_inner[jj].y()});
-            all_bld_points.push_back({ii.value().points_local_inner[jj].x(), ii.value().points_local_inner[jj].y()});
+        polygon.clear();
+        polygon.emplace_back();
+        for(const QVector2D &point : building->points_local){
+            polygon.back().push_back({point.x(), point.y()});
         }
-        if(bld_points.size() > 0){
-            polygon.push_back(bld_points);
+        if(!building->points_local_inner.empty()){
+            polygon.emplace_back();
+            for(const QVector2D &point : building->points_local_inner){
+                polygon.back().push_back({point.x(), point.y()});
+            }
         }
 
-        std::vector<uint32_t> indices = mapbox::earcut<uint32_t>(polygon);
-
-        for(uint i_i=0; i_i<indices.size(); i_i+=3) {
-            // mesh for roof
-            uint n_idx = indices[i_i];
-            triangulated_mesh.push_back(QVector3D(all_bld_points[n_idx][0], all_bld_points[n_idx][1], bld_height));
-            n_idx = indices[i_i+1];
-            triangulated_mesh.push_back(QVector3D(all_bld_points[n_idx][0], all_bld_points[n_idx][1], bld_height));
-            n_idx = indices[i_i+2];
-            triangulated_mesh.push_back(QVector3D(all_bld_points[n_idx][0], all_bld_points[n_idx][1], bld_height));
-
-            // mesh for floor
-            n_idx = indices[i_i+2];
-            triangulated_mesh.push_back(QVector3D(all_bld_points[n_idx][0], all_bld_points[n_idx][1], 0));
-            n_idx = indices[i_i+1];
-            triangulated_mesh.push_back(QVector3D(all_bld_points[n_idx][0], all_bld_points[n_idx][1], 0));
-            n_idx = indices[i_i];
-            triangulated_mesh.push_back(QVector3D(all_bld_points[n_idx][0], all_bld_points[n_idx][1], 0));
+        const std::vector<uint32_t> roof = mapbox::earcut<uint32_t>(polygon);
+        if(roof.empty()){
+            continue;
         }
 
-        if(bld_height > 0) {
-            trianglateWallsExtrudedPolygon(triangulated_mesh, ii.value().points_local, bld_height, 0, 0); // mesh for wall outside
-            trianglateWallsExtrudedPolygon(triangulated_mesh, ii.value().points_local, bld_height, 1, 0);// mesh for wall inside
-
-            trianglateWallsExtrudedPolygon(triangulated_mesh, ii.value().points_local_inner, bld_height, 0, 0); // mesh for wall outside
-            trianglateWallsExtrudedPolygon(triangulated_mesh, ii.value().points_local_inner, bld_height, 1, 0);// mesh for wall inside
+        // Vertices [top, top + n) are the roof outline (outer then inner ring), [bottom, bottom + n) the floor
+        const uint32_t outerCount = static_cast<uint32_t>(building->points_local.size());
+        const uint32_t pointCount = outerCount + static_cast<uint32_t>(building->points_local_inner.size());
+        const uint32_t top = static_cast<uint32_t>(vertices.size() / 3);
+        const uint32_t bottom = top + pointCount;
+
+        for(const float z : { height, 0.0f }){
+            for(const auto &ring : polygon){
+                for(const auto &point : ring){
+                    vertices.insert(vertices.end(), { point[0], point[1], z });
+                    boundsMin.setX(std::min(boundsMin.x(), point[0]));
+                    boundsMin.setY(std::min(boundsMin.y(), point[1]));
+                    boundsMax.setX(std::max(boundsMax.x(), point[0]));
+                    boundsMax.setY(std::max(boundsMax.y(), point[1]));
+                }
+            }
         }
+        boundsMax.setZ(std::max(boundsMax.z(), height));
 
-        QByteArray vertexData_tmp(triangulated_mesh.size() * 3 * sizeof(float), Qt::Initialization::Uninitialized);
-        float *p = reinterpret_cast<float *>(vertexData_tmp.data());
-
-        for(uint i_m=0; i_m<triangulated_mesh.size(); i_m++) {
-            *p++ =  (float)triangulated_mesh[i_m].x(); *p++ =  (float)triangulated_mesh[i_m].y(); *p++ =  (float)triangulated_mesh[i_m].z();
+        for(size_t i = 0; i < roof.size(); i += 3){
+            indices.insert(indices.end(), { top + roof[i], top + roof[i + 1], top + roof[i + 2] });
+            indices.insert(indices.end(), { bottom + roof[i + 2], bottom + roof[i + 1], bottom + roof[i] });
         }
 
-        ii.value().triangulated_mesh.insert(ii.value().triangulated_mesh.begin(), triangulated_mesh.begin(), triangulated_mesh.end());
-        vertexData.append(vertexData_tmp);
+        appendWalls(indices, top, bottom, building->points_local);
+        appendWalls(indices, top + outerCount, bottom + outerCount, building->points_local_inner);
     }
-    return vertexData;
-}
 
-void OsmParser::trianglateWallsExtrudedPolygon(std::vector<QVector3D>& triangulatedMesh, std::vector<QVector2D> verticesCcw, float h, bool inverseOrder, bool duplicateStartEndPoint)
-{
-    std::vector<QVector3D> tmp_rec_ccw(4);
-    uint vertices_size = verticesCcw.size() - (uint)(duplicateStartEndPoint);
-
-    if(inverseOrder) {
-        for(uint i_p=0; i_p<vertices_size; i_p++) {
-            int i_p_p = (i_p < vertices_size-1)?(i_p+1):(0);
-            tmp_rec_ccw[0] = QVector3D(verticesCcw[i_p_p].x(), verticesCcw[i_p_p].y(), 0);
-            tmp_rec_ccw[1] = QVector3D(verticesCcw[i_p].x(), verticesCcw[i_p].y(), 0);
-            tmp_rec_ccw[2] = QVector3D(verticesCcw[i_p].x(), verticesCcw[i_p].y(), h);
-            tmp_rec_ccw[3] = QVector3D(verticesCcw[i_p_p].x(), verticesCcw[i_p_p].y(), h);
-            trianglateRectangle(triangulatedMesh, tmp_rec_ccw, 0);
-        }
-        trianglateRectangle(triangulatedMesh, tmp_rec_ccw, 1);
-    } else {
-        for(uint i_p=0; i_p<vertices_size; i_p++) {
-            int i_p_p = (i_p < vertices_size-1)?(i_p+1):(0);
-            tmp_rec_ccw[0] = QVector3D(verticesCcw[i_p].x(), verticesCcw[i_p].y(), 0);
-            tmp_rec_ccw[1] = QVector3D(verticesCcw[i_p_p].x(), verticesCcw[i_p_p].y(), 0);
-            tmp_rec_ccw[2] = QVector3D(verticesCcw[i_p_p].x(), verticesCcw[i_p_p].y(), h);
-            tmp_rec_ccw[3] = QVector3D(verticesCcw[i_p].x(), verticesCcw[i_p].y(), h);
-            trianglateRectangle(triangulatedMesh, tmp_rec_ccw, 0);
-        }
-        trianglateRectangle(triangulatedMesh, tmp_rec_ccw, 1);
+    OsmParser::MeshChunk chunk;
+    if(indices.empty()){
+        return chunk;
     }
+
+    chunk.vertexData = QByteArray(reinterpret_cast<const char*>(vertices.data()), static_cast<qsizetype>(vertices.size() * sizeof(float)));
+    chunk.indexData = QByteArray(reinterpret_cast<const char*>(indices.data()), static_cast<qsizetype>(indices.size() * sizeof(uint32_t)));
+    chunk.boundsMin = boundsMin;
+    chunk.boundsMax = boundsMax;
+    return chunk;
 }
 
-void OsmParser::trianglateRectangle(std::vector<QVector3D>& triangulatedMesh, std::vector<QVector3D> verticesCcw, bool invertNormal)
+} // namespace
+
+QList<OsmParser::MeshChunk> OsmParser::buildMeshChunks(const QHash<uint64_t, OsmParserThread::BuildingType_t> &buildings, float buildingLevelHeight, float chunkSize, QThreadPool *threadPool)
 {
-    std::vector<vec3i> mesh_set_idx;
-    mesh_set_idx.resize(2);
-
-    if(invertNormal) {
-        mesh_set_idx[0] = {{3, 1, 0}};
-        mesh_set_idx[1] = {{3, 2, 1}};
-    } else {
-        mesh_set_idx[0] = {{0, 1, 3}};
-        mesh_set_idx[1] = {{1, 2, 3}};
+    QHash<quint64, BuildingList> grouped;
+    for(auto it = buildings.cbegin(), end = buildings.cend(); it != end; ++it){
+        const QVector2D center = (it.value().bb_min + it.value().bb_max) / 2;
+        const qint32 cellX = static_cast<qint32>(std::floor(center.x() / chunkSize));
+        const qint32 cellY = static_cast<qint32>(std::floor(center.y() / chunkSize));
+        grouped[(static_cast<quint64>(static_cast<quint32>(cellX)) << 32) | static_cast<quint32>(cellY)].append(&it.value());
     }
 
-    uint idx_tmp;
-
-    for(uint i_m=0; i_m<mesh_set_idx.size(); i_m++) {
-        for(uint i_v=0; i_v<3; i_v++) {
-            idx_tmp = mesh_set_idx[i_m].array[i_v];
-            triangulatedMesh.push_back(QVector3D(verticesCcw[idx_tmp].x(), verticesCcw[idx_tmp].y(), verticesCcw[idx_tmp].z()));
-        }
-    }
+    const QList<BuildingList> groups = grouped.values();
+    QList<MeshChunk> chunks = QtConcurrent::blockingMapped<QList<MeshChunk>>(threadPool ? threadPool : QThreadPool::globalInstance(), groups, [buildingLevelHeight](const BuildingList &group) {
+        return triangulateChunk(group, buildingLevelHeight);
+    });
+    chunks.removeIf([](const MeshChunk &chunk) { return chunk.indexData.isEmpty(); });
+    return chunks;
 }
@@ -10,16 +10,25 @@
 #pragma once
 
 #include <QtCore/QObject>
+#include <QtCore/QByteArray>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
 #include <QtGui/QVector3D>
 #include <QtGui/QVector2D>
 #include <QtPositioning/QGeoCoordinate>
 #include <QtCore/QVariant>
 #include <QtQmlIntegration/QtQmlIntegration>
 
+#include "OsmParserThread.h"
+
 ///     @author Omid Esrafilian <esrafilian.omid@gmail.com>
 
+Q_DECLARE_LOGGING_CATEGORY(OsmParserLog)
+
+class QThreadPool;
 class Viewer3DSettings;
-class OsmParserThread;
 
 class OsmParser : public QObject
 {
@@ -28,8 +37,20 @@ class OsmParser : public QObject
     QML_UNCREATABLE("")
 
     // Q_PROPERTY(float buildingLevelHeight READ buildingLevelHeight WRITE setBuildingLevelHeight NOTIFY buildingLevelHeightChanged)
+    Q_PROPERTY(int meshChunkCount READ meshChunkCount NOTIFY meshChanged)
 
 public:
+    /// Indexed triangle mesh of the buildings which fall into one square area of the map. Vertices are
+    /// three floats (x, y, z) in local coordinates, indices are uint32.
+    struct MeshChunk {
+        QByteArray vertexData;
+        QByteArray indexData;
+        QVector3D boundsMin;
+        QVector3D boundsMax;
+    };
+
+    static constexpr float defaultMeshChunkSize = 500.0f; ///< Edge length of a mesh chunk in meters
+
     explicit OsmParser(QObject *parent = nullptr);
 
     bool mapLoaded(){return _mapLoadedFlag;}
@@ -40,34 +61,42 @@ class OsmParser : public QObject
     float buildingLevelHeight(void){return _buildingLevelHeight;}
     void parseOsmFile(QString filePath);
 
-    QByteArray buildingToMesh();
+    int meshChunkCount() const { return _meshChunks.count(); }
+    MeshChunk meshChunk(int index) const { return _meshChunks.value(index); }
+
+    /// Groups the buildings into square chunks by the center of their bounding box and triangulates the
+    /// chunks in parallel on threadPool, the global one by default. Empty chunks are not returned.
+    static QList<MeshChunk> buildMeshChunks(const QHash<uint64_t, OsmParserThread::BuildingType_t> &buildings, float buildingLevelHeight, float chunkSize = defaultMeshChunkSize, QThreadPool *threadPool = nullptr);
 
-    void trianglateWallsExtrudedPolygon(std::vector<QVector3D>& triangulatedMesh, std::vector<QVector2D> verticesCcw, float h, bool inverseOrder=0, bool duplicateStartEndPoint=0);
-    void trianglateRectangle(std::vector<QVector3D>& triangulatedMesh, std::vector<QVector3D> verticesCcw, bool invertNormal);
     std::pair<QGeoCoordinate, QGeoCoordinate> getMapBoundingBoxCoordinate(){ return std::pair(_coordinateMin, _coordinateMax);}
 
 private:
     OsmParserThread* _osmParserWorker;
     QGeoCoordinate _gpsRefPoint;
     QGeoCoordinate _coordinateMin, _coordinateMax; //Osm map bounding boxes in global coordinate
+    QList<MeshChunk> _meshChunks;
+    QFutureWatcher<QList<MeshChunk>> _meshWatcher;
 
 
     bool _gpsRefSet;
     float _buildingLevelHeight;
     bool _mapLoadedFlag;
     Viewer3DSettings* _viewer3DSettings = nullptr;
-    QList<QString> _singleStoreyBuildings;
-    QList<QString> _doubleStoreyLeisure;
 
 
 signals:
     void gpsRefChanged(QGeoCoordinate newGpsRef, bool isRefSet);
     void mapChanged();
+    void mapLoadingProgress(int percent);
     void buildingLevelHeightChanged(void);
+    void meshChanged();
 
 private slots:
     void setBuildingLevelHeight(QVariant value);
     void osmParserFinished(bool isValid);
+    void setOsmFilePath(QVariant value);
+    void updateMesh();
+    void meshGenerationFinished();
 
 
 };
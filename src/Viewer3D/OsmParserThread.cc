@@ -8,22 +8,153 @@
  ****************************************************************************/
 
 #include "OsmParserThread.h"
+#include "OsmMeshCache.h"
 #include "QGCGeo.h"
 
 #include <QtCore/QFile>
+#include <QtCore/QXmlStreamReader>
+
+#include <algorithm>
+
+namespace {
+
+const QStringList singleStoreyBuildings = {
+    QStringLiteral("bungalow"),
+    QStringLiteral("shed"),
+    QStringLiteral("kiosk"),
+    QStringLiteral("cabin"),
+};
+
+const QStringList doubleStoreyLeisure = {
+    QStringLiteral("stadium"),
+    QStringLiteral("sports_hall"),
+    QStringLiteral("sauna"),
+};
+
+/// Compact node coordinate storage. OSM extracts list nodes in id order, so lookups are a binary search over
+/// flat arrays. A hash index is only built if the file turns out not to be sorted.
+class NodeStore
+{
+public:
+    struct Coordinate {
+        double latitude;
+        double longitude;
+    };
+
+    void append(uint64_t id, double latitude, double longitude)
+    {
+        if (!_ids.empty() && (id <= _ids.back())) {
+            _sorted = false;
+        }
+        if (!_sorted && !_index.isEmpty()) {
+            // Ways may come before all nodes are read, keep an index built by an earlier lookup complete
+            _index.insert(id, _ids.size());
+        }
+        _ids.push_back(id);
+        _coordinates.push_back({latitude, longitude});
+    }
+
+    const Coordinate *find(uint64_t id)
+    {
+        if (_sorted) {
+            const auto it = std::lower_bound(_ids.cbegin(), _ids.cend(), id);
+            if ((it == _ids.cend()) || (*it != id)) {
+                return nullptr;
+            }
+            return &_coordinates[static_cast<size_t>(std::distance(_ids.cbegin(), it))];
+        }
+
+        if (_index.isEmpty()) {
+            _index.reserve(static_cast<qsizetype>(_ids.size()));
+            for (size_t i = 0; i < _ids.size(); i++) {
+                _index.insert(_ids[i], i);
+            }
+        }
+
+        const auto it = _index.constFind(id);
+        return (it == _index.cend()) ? nullptr : &_coordinates[it.value()];
+    }
+
+private:
+    std::vector<uint64_t> _ids;
+    std::vector<Coordinate> _coordinates;
+    QHash<uint64_t, size_t> _index;
+    bool _sorted = true;
+};
+
+/// Node references of closed ways without building tags. These can still become part of a building through a
+/// multipolygon relation, which is only known once relations are read at the end of the file.
+class PendingWays
+{
+public:
+    void append(uint64_t wayId, const std::vector<uint64_t> &refs)
+    {
+        _ways.insert(wayId, {_refs.size(), refs.size()});
+        _refs.insert(_refs.end(), refs.cbegin(), refs.cend());
+    }
+
+    bool take(uint64_t wayId, std::vector<uint64_t> &refs)
+    {
+        const auto it = _ways.constFind(wayId);
+        if (it == _ways.cend()) {
+            return false;
+        }
+        const auto first = _refs.cbegin() + static_cast<std::ptrdiff_t>(it.value().first);
+        refs.assign(first, first + static_cast<std::ptrdiff_t>(it.value().second));
+        _ways.erase(it);
+        return true;
+    }
+
+private:
+    std::vector<uint64_t> _refs;
+    QHash<uint64_t, std::pair<size_t, size_t>> _ways;
+};
+
+/// Resolves way node references into a building outline
+bool makeBuilding(const std::vector<uint64_t> &refs, NodeStore &nodes, const QGeoCoordinate &gpsRef, OsmParserThread::BuildingType_t &bld, double &latMin, double &latMax, double &lonMin, double &lonMax)
+{
+    double bld_x_max = -1e10, bld_y_max = -1e10;
+    double bld_x_min = 1e10, bld_y_min = 1e10;
+    latMax = lonMax = -1e10;
+    latMin = lonMin = 1e10;
+
+    bld.points_gps.reserve(refs.size());
+    bld.points_local.reserve(refs.size());
+
+    for (const uint64_t ref : refs) {
+        const NodeStore::Coordinate *const node = nodes.find(ref);
+        if (!node) {
+            continue;
+        }
+
+        const QGeoCoordinate gps_pt_tmp(node->latitude, node->longitude, 0);
+        const QVector3D local_pt_tmp = QGCGeo::convertGpsToEnu(gps_pt_tmp, gpsRef);
+        bld.points_gps.push_back(gps_pt_tmp);
+        bld.points_local.push_back(QVector2D(local_pt_tmp.x(), local_pt_tmp.y()));
+
+        bld_x_max = fmax(bld_x_max, local_pt_tmp.x());
+        bld_y_max = fmax(bld_y_max, local_pt_tmp.y());
+        bld_x_min = fmin(bld_x_min, local_pt_tmp.x());
+        bld_y_min = fmin(bld_y_min, local_pt_tmp.y());
+
+        lonMax = fmax(lonMax, node->longitude);
+        latMax = fmax(latMax, node->latitude);
+        lonMin = fmin(lonMin, node->longitude);
+        latMin = fmin(latMin, node->latitude);
+    }
+
+    bld.bb_max = QVector2D(bld_x_max, bld_y_max);
+    bld.bb_min = QVector2D(bld_x_min, bld_y_min);
+
+    return (bld.points_local.size() > 2);
+}
+
+} // namespace
 
 OsmParserThread::OsmParserThread(QObject *parent)
     : QThread{parent}
 {
     _mainThread = new QThread();
-    _singleStoreyBuildings.append("bungalow");
-    _singleStoreyBuildings.append("shed");
-    _singleStoreyBuildings.append("kiosk");
-    _singleStoreyBuildings.append("cabin");
-
-    _doubleStoreyLeisure.append("stadium");
-    _doubleStoreyLeisure.append("sports_hall");
-    _doubleStoreyLeisure.append("sauna");
 
     connect(this, &OsmParserThread::startThread, this, &OsmParserThread::startThreadEvent);
 
@@ -38,8 +169,8 @@ void OsmParserThread::start(QString filePath)
 
 void OsmParserThread::parseOsmFile(QString filePath)
 {
-    mapNodes.clear();
     mapBuildings.clear();
+    fileHash.clear();
     _mapLoadedFlag = false;
 
 
@@ -52,8 +183,6 @@ void OsmParserThread::parseOsmFile(QString filePath)
         return;
     }
 
-    //The QDomDocument class represents an XML document.
-    QDomDocument xml_content;
 // Load xml file as raw data
 #ifdef __unix__
     filePath = QString("/") + filePath;
@@ -65,11 +194,25 @@ void OsmParserThread::parseOsmFile(QString filePath)
         return;
     }
     qDebug("Loading the OSM file!!!");
-    // Set data into the QDomDocument before processing
-    xml_content.setContent(&f);
+
+    // Buildings of a known file are restored from the cache instead of parsing the file again
+    const OsmMeshCache cache;
+    fileHash = OsmMeshCache::hashFile(f);
+    bool valid = cache.loadBuildings(fileHash, mapBuildings, coordinateMin, coordinateMax, gpsRefPoint);
+    if(valid){
+        emit parseProgress(100);
+    }else{
+        (void) f.seek(0);
+        valid = decodeStream(f, mapBuildings, coordinateMin, coordinateMax, gpsRefPoint, [this](int percent) {
+            emit parseProgress(percent);
+        });
+        if(valid){
+            (void) cache.saveBuildings(fileHash, mapBuildings, coordinateMin, coordinateMax, gpsRefPoint);
+        }
+    }
     f.close();
 
-    if(decodeFile(xml_content, mapBuildings, mapNodes, coordinateMin, coordinateMax, gpsRefPoint)){
+    if(valid){
         _mapLoadedFlag = true;
         emit fileParsed(true);
         return;
@@ -78,219 +221,197 @@ void OsmParserThread::parseOsmFile(QString filePath)
     emit fileParsed(false);
 }
 
-bool OsmParserThread::decodeFile(QDomDocument &xml_content, QMap<uint64_t, OsmParserThread::BuildingType_t> &buildingMap, QMap<uint64_t, QGeoCoordinate> &nodeMap, QGeoCoordinate &coordinateMin, QGeoCoordinate &coordinateMax, QGeoCoordinate &gpsRef)
-{
-    QDomElement root = xml_content.documentElement();
-    QDomElement xmlComponent = root.firstChild().toElement();
-    QGeoCoordinate tmpGpsRef;
-    bool gpsRefIsSet = false;
-    while(!xmlComponent.isNull()) {
-        if(decodeNodeTags(xmlComponent, nodeMap, coordinateMin, coordinateMax, tmpGpsRef)){
-            gpsRefIsSet = true;
-            gpsRef = tmpGpsRef;
-        }
-        decodeBuildings(xmlComponent, buildingMap, nodeMap, coordinateMin, coordinateMax, gpsRef);
-        decodeRelations(xmlComponent, buildingMap, nodeMap, gpsRef);
-
-        xmlComponent = xmlComponent.nextSibling().toElement();
-    }
-    return gpsRefIsSet;
-}
-
-bool OsmParserThread::decodeNodeTags(QDomElement &xmlComponent, QMap<uint64_t, QGeoCoordinate> &nodeMap, QGeoCoordinate &coordMin, QGeoCoordinate &coordMax, QGeoCoordinate &gpsRef)
+bool OsmParserThread::decodeStream(QIODevice &device, QHash<uint64_t, BuildingType_t> &buildingMap, QGeoCoordinate &coordinateMin, QGeoCoordinate &coordinateMax, QGeoCoordinate &gpsRef, const std::function<void(int)> &progressCallback)
 {
-    int64_t id_tmp=0;
-    QGeoCoordinate gps_tmp;
-    QString attribute;
+    NodeStore nodes;
+    PendingWays pendingWays;
     bool gpsRefIsSet = false;
 
-    if (xmlComponent.tagName()=="node") {
-
-        attribute = xmlComponent.attribute("id","-1");
-        id_tmp = attribute.toLongLong();
-
-        attribute = xmlComponent.attribute("lat","0");
-        gps_tmp.setLatitude(attribute.toDouble());
+    // State of the way or relation currently being read
+    enum { ElementNone, ElementWay, ElementRelation } element = ElementNone;
+    int64_t elementId = 0;
+    float levels = 0;
+    float height = 0;
+    std::vector<uint64_t> wayRefs;
+    std::vector<std::pair<uint64_t, bool>> relationMembers;     ///< way id, inner role
+    bool isBuilding = false;
+    bool isMultipolygon = false;
 
-        attribute = xmlComponent.attribute("lon","0");
-        gps_tmp.setLongitude(attribute.toDouble());
+    const qint64 deviceSize = device.size();
+    int lastPercent = -1;
+    uint32_t elementCount = 0;
 
-        gps_tmp.setAltitude(0);
+    QXmlStreamReader xml(&device);
+    while (!xml.atEnd()) {
+        const QXmlStreamReader::TokenType token = xml.readNext();
 
-        if(id_tmp > 0) {
-            nodeMap.insert((uint64_t)id_tmp, gps_tmp);
-        }
-    }else if(xmlComponent.tagName() == "bounds") {
-        coordMin.setLatitude(xmlComponent.attribute("minlat","0").toFloat());
-        coordMin.setLongitude(xmlComponent.attribute("minlon","0").toFloat());
-        coordMin.setAltitude(0);
-        coordMax.setLatitude(xmlComponent.attribute("maxlat","0").toFloat());
-        coordMax.setLongitude(xmlComponent.attribute("maxlon","0").toFloat());
-        coordMax.setAltitude(0);
-
-        gpsRefIsSet = true;
-        gps_tmp.setLatitude(0.5 * (coordMin.latitude() + coordMax.latitude()));
-        gps_tmp.setLongitude(0.5 * (coordMin.longitude() + coordMax.longitude()));
-        gps_tmp.setAltitude(0);
-        gpsRef = gps_tmp;
-    }
-    return gpsRefIsSet;
-}
+        if (token == QXmlStreamReader::StartElement) {
+            const QStringView name = xml.name();
+            const QXmlStreamAttributes attributes = xml.attributes();
 
-void OsmParserThread::decodeBuildings(QDomElement &xmlComponent, QMap<uint64_t, OsmParserThread::BuildingType_t> &bldMap, QMap<uint64_t, QGeoCoordinate> &nodeMap, QGeoCoordinate &coordMin, QGeoCoordinate &coordMax, QGeoCoordinate gpsRef)
-{
-    if (xmlComponent.tagName()!="way"){
-        return;
-    }
-
-    int64_t id_tmp = xmlComponent.attribute("id","0").toLongLong();
-    if(id_tmp == 0) {
-        return;
-    }
-    OsmParserThread::BuildingType_t bld_tmp;
-    QGeoCoordinate gps_pt_tmp;
-    QVector3D local_pt_tmp;
-    std::vector<QGeoCoordinate> bld_points;
-    std::vector<QVector2D> bld_points_local;
-    double bld_lon_max, bld_lon_min, bld_lat_max, bld_lat_min;
-    double bld_x_max, bld_x_min, bld_y_max, bld_y_min;
-    bld_x_max = bld_y_max = -1e10;
-    bld_x_min = bld_y_min = 1e10;
-    bld_lon_max = bld_lat_max = -1e10;
-    bld_lon_min = bld_lat_min = 1e10;
-
-    int64_t ref_id;
-    QDomElement Child = xmlComponent.firstChild().toElement();
-    QString attribute;
-
-    bld_tmp.height = 0;
-    bld_tmp.levels = 0;
-
-    while (!Child.isNull()) {
-        if (Child.tagName()=="nd") {
-            ref_id = Child.attribute("ref","0").toLongLong();
-
-            if(ref_id > 0) {
-                gps_pt_tmp = nodeMap[ref_id];
-                bld_points.push_back(gps_pt_tmp);
-                local_pt_tmp = QGCGeo::convertGpsToEnu(gps_pt_tmp, gpsRef);
-                bld_points_local.push_back(QVector2D(local_pt_tmp.x(), local_pt_tmp.y()));
-
-                bld_x_max = (bld_x_max < local_pt_tmp.x())?(local_pt_tmp.x()):(bld_x_max);
-                bld_y_max = (bld_y_max < local_pt_tmp.y())?(local_pt_tmp.y()):(bld_y_max);
-                bld_x_min = (bld_x_min > local_pt_tmp.x())?(local_pt_tmp.x()):(bld_x_min);
-                bld_y_min = (bld_y_min > local_pt_tmp.y())?(local_pt_tmp.y()):(bld_y_min);
-
-                bld_lon_max = fmax(bld_lon_max, gps_pt_tmp.longitude());
-                bld_lat_max = fmax(bld_lat_max, gps_pt_tmp.latitude());
-                bld_lon_min = fmin(bld_lon_min, gps_pt_tmp.longitude());
-                bld_lat_min = fmin(bld_lat_min, gps_pt_tmp.latitude());
+            if (progressCallback && (deviceSize > 0) && ((++elementCount % 4096) == 0)) {
+                const int percent = static_cast<int>((device.pos() * 100) / deviceSize);
+                if (percent != lastPercent) {
+                    lastPercent = percent;
+                    progressCallback(percent);
+                }
             }
-        }else if (Child.tagName()=="tag") {
-            attribute = Child.attribute("k","0");
-            if(attribute == "building:levels") {
-                bld_tmp.levels = Child.attribute("v","0").toFloat();
-            }else if(attribute == "height") {
-                bld_tmp.height = Child.attribute("v","0").toFloat();
-            }else if(attribute == "building" && bld_tmp.levels == 0 && bld_tmp.height == 0){
-                QString attribute_2 = Child.attribute("v","0");
-                if(_singleStoreyBuildings.contains(attribute_2)){
-                    bld_tmp.levels = 1;
-                }else{
-                    bld_tmp.levels = 2;
+
+            if (name == u"node") {
+                const int64_t id = attributes.value(u"id").toLongLong();
+                if (id > 0) {
+                    nodes.append(static_cast<uint64_t>(id), attributes.value(u"lat").toDouble(), attributes.value(u"lon").toDouble());
                 }
-            }else if(attribute == "leisure" && bld_tmp.levels == 0 && bld_tmp.height == 0){
-                QString attribute_2 = Child.attribute("v","0");
-                if(_doubleStoreyLeisure.contains(attribute_2)){
-                    bld_tmp.levels = 2;
+            } else if (name == u"nd") {
+                if (element == ElementWay) {
+                    const int64_t ref = attributes.value(u"ref").toLongLong();
+                    if (ref > 0) {
+                        wayRefs.push_back(static_cast<uint64_t>(ref));
+                    }
                 }
+            } else if (name == u"tag") {
+                const QStringView key = attributes.value(u"k");
+                if (element == ElementWay) {
+                    if (key == u"building:levels") {
+                        levels = attributes.value(u"v").toFloat();
+                    } else if (key == u"height") {
+                        height = attributes.value(u"v").toFloat();
+                    } else if ((key == u"building") && (levels == 0) && (height == 0)) {
+                        levels = singleStoreyBuildings.contains(attributes.value(u"v")) ? 1 : 2;
+                    } else if ((key == u"leisure") && (levels == 0) && (height == 0)) {
+                        if (doubleStoreyLeisure.contains(attributes.value(u"v"))) {
+                            levels = 2;
+                        }
+                    }
+                } else if (element == ElementRelation) {
+                    if (key == u"type") {
+                        if (attributes.value(u"v") == u"multipolygon") {
+                            isMultipolygon = true;
+                        }
+                    } else if (key == u"building") {
+                        isBuilding = true;
+                    }
+                }
+            } else if (name == u"member") {
+                if (element == ElementRelation) {
+                    const int64_t ref = attributes.value(u"ref").toLongLong();
+                    if (ref > 0) {
+                        relationMembers.emplace_back(static_cast<uint64_t>(ref), attributes.value(u"role") == u"inner");
+                    }
+                }
+            } else if (name == u"way") {
+                element = ElementWay;
+                elementId = attributes.value(u"id").toLongLong();
+                levels = 0;
+                height = 0;
+                wayRefs.clear();
+            } else if (name == u"relation") {
+                element = ElementRelation;
+                elementId = attributes.value(u"id").toLongLong();
+                relationMembers.clear();
+                isBuilding = false;
+                isMultipolygon = false;
+            } else if (name == u"bounds") {
+                coordinateMin.setLatitude(attributes.value(u"minlat").toFloat());
+                coordinateMin.setLongitude(attributes.value(u"minlon").toFloat());
+                coordinateMin.setAltitude(0);
+                coordinateMax.setLatitude(attributes.value(u"maxlat").toFloat());
+                coordinateMax.setLongitude(attributes.value(u"maxlon").toFloat());
+                coordinateMax.setAltitude(0);
+
+                gpsRefIsSet = true;
+                gpsRef = QGeoCoordinate(0.5 * (coordinateMin.latitude() + coordinateMax.latitude()),
+                                        0.5 * (coordinateMin.longitude() + coordinateMax.longitude()),
+                                        0);
             }
-        }
-
-        Child = Child.nextSibling().toElement();
-    }
+        } else if (token == QXmlStreamReader::EndElement) {
+            const QStringView name = xml.name();
 
-    if(bld_points.size() > 2) {
-        //        float bld_height = (bld_tmp.height >= bld_tmp.levels * _buildingLevelHeight)?(bld_tmp.height):(bld_tmp.levels * _buildingLevelHeight);
-        //        bld_tmp.height = bld_height;
-        if(bld_tmp.levels > 0 || bld_tmp.height > 0){
-            coordMin.setLatitude(fmin(coordMin.latitude(), bld_lat_min));
-            coordMin.setLongitude(fmin(coordMin.longitude(), bld_lon_min));
-            coordMax.setLatitude(fmax(coordMax.latitude(), bld_lat_max));
-            coordMax.setLongitude(fmax(coordMax.longitude(), bld_lon_max));
-        }
-        bld_tmp.points_gps = bld_points;
-        bld_tmp.points_local = bld_points_local;
-        bld_tmp.bb_max = QVector2D(bld_x_max, bld_y_max);
-        bld_tmp.bb_min = QVector2D(bld_x_min, bld_y_min);
-        bldMap.insert(id_tmp, bld_tmp);
-    }
-}
-
-void OsmParserThread::decodeRelations(QDomElement &xmlComponent, QMap<uint64_t, OsmParserThread::BuildingType_t> &bldMap, QMap<uint64_t, QGeoCoordinate> &nodeMap, QGeoCoordinate gpsRef)
-{
-    if (xmlComponent.tagName()!="relation"){
-        return;
-    }
-
-    int64_t id_tmp = xmlComponent.attribute("id","0").toLongLong();
-    if(id_tmp == 0) {
-        return;
-    }
+            if ((name == u"way") && (element == ElementWay)) {
+                element = ElementNone;
+                if ((elementId <= 0) || (wayRefs.size() <= 2)) {
+                    continue;
+                }
 
-    OsmParserThread::BuildingType_t bld_tmp;
-    int64_t ref_id;
-    QDomElement Child = xmlComponent.firstChild().toElement();
-    QString attribute;
-    QString role;
+                if ((levels > 0) || (height > 0)) {
+                    BuildingType_t bld_tmp;
+                    bld_tmp.levels = levels;
+                    bld_tmp.height = height;
+                    double latMin, latMax, lonMin, lonMax;
+                    if (makeBuilding(wayRefs, nodes, gpsRef, bld_tmp, latMin, latMax, lonMin, lonMax)) {
+                        coordinateMin.setLatitude(fmin(coordinateMin.latitude(), latMin));
+                        coordinateMin.setLongitude(fmin(coordinateMin.longitude(), lonMin));
+                        coordinateMax.setLatitude(fmax(coordinateMax.latitude(), latMax));
+                        coordinateMax.setLongitude(fmax(coordinateMax.longitude(), lonMax));
+                        buildingMap.insert(static_cast<uint64_t>(elementId), std::move(bld_tmp));
+                    }
+                } else if (wayRefs.front() == wayRefs.back()) {
+                    // Untagged closed ways may still be the outline of a multipolygon building
+                    pendingWays.append(static_cast<uint64_t>(elementId), wayRefs);
+                }
+            } else if ((name == u"relation") && (element == ElementRelation)) {
+                element = ElementNone;
+                if ((elementId == 0) || !isMultipolygon) {
+                    continue;
+                }
 
-    bld_tmp.height = 0;
-    bld_tmp.levels = 0;
-    std::vector<int64_t> bldToBeRemoved;
-    bool isBuilding = false;
-    bool isMultipolygon = false;
+                BuildingType_t bld_tmp;
+                bld_tmp.height = 0;
+                bld_tmp.levels = 0;
+                std::vector<uint64_t> memberIds;
+                std::vector<uint64_t> memberRefs;
+
+                for (const auto &[ref, inner] : relationMembers) {
+                    BuildingType_t member;
+                    auto bldItem = buildingMap.find(ref);
+                    if (bldItem != buildingMap.end()) {
+                        member = std::move(bldItem.value());
+                        buildingMap.erase(bldItem);
+                    } else if (pendingWays.take(ref, memberRefs)) {
+                        member.height = 0;
+                        member.levels = 0;
+                        double latMin, latMax, lonMin, lonMax;
+                        if (!makeBuilding(memberRefs, nodes, gpsRef, member, latMin, latMax, lonMin, lonMax)) {
+                            continue;
+                        }
+                    } else {
+                        continue;
+                    }
+
+                    bld_tmp.append(member.points_local, inner);
+                    bld_tmp.append(member.points_gps, inner);
+                    bld_tmp.levels = fmax(bld_tmp.levels, member.levels);
+                    bld_tmp.height = fmax(bld_tmp.height, member.height);
+
+                    bld_tmp.bb_max[0] = fmax(bld_tmp.bb_max[0], member.bb_max[0]);
+                    bld_tmp.bb_max[1] = fmax(bld_tmp.bb_max[1], member.bb_max[1]);
+                    bld_tmp.bb_min[0] = fmin(bld_tmp.bb_min[0], member.bb_min[0]);
+                    bld_tmp.bb_min[1] = fmin(bld_tmp.bb_min[1], member.bb_min[1]);
+                    memberIds.push_back(ref);
+                }
 
-    while (!Child.isNull()) {
-        if (Child.tagName()=="member") {
-            ref_id = Child.attribute("ref","0").toLongLong();
-            role = Child.attribute("role","0");
-            auto bldItem = bldMap.find(ref_id);
-            if(bldItem != bldMap.end()) {
-                bld_tmp.append(bldItem.value().points_local, role == "inner");
-                bld_tmp.append(bldItem.value().points_gps, role == "inner");
-                bld_tmp.levels = fmax(bld_tmp.levels, bldItem.value().levels);
-                bld_tmp.height = fmax(bld_tmp.height, bldItem.value().height);
-
-                bld_tmp.bb_max[0] = fmax(bld_tmp.bb_max[0], bldItem.value().bb_max[0]);
-                bld_tmp.bb_max[1] = fmax(bld_tmp.bb_max[1], bldItem.value().bb_max[1]);
-                bld_tmp.bb_min[0] = fmin(bld_tmp.bb_min[0], bldItem.value().bb_min[0]);
-                bld_tmp.bb_min[1] = fmin(bld_tmp.bb_min[1], bldItem.value().bb_min[1]);
-                bldToBeRemoved.push_back(ref_id);
-            }
-        }else if (Child.tagName()=="tag") {
-            attribute = Child.attribute("k","0");
-            if(attribute == "type") {
-                if(Child.attribute("v","0") == "multipolygon"){
-                    isMultipolygon = true;
+                if(isBuilding){
+                    if(bld_tmp.height == 0){
+                        bld_tmp.levels = (bld_tmp.levels == 0)?(2):(bld_tmp.levels);
+                    }
+                }
+                if(memberIds.size() > 0){
+                    buildingMap.insert(memberIds[0], std::move(bld_tmp));
                 }
-            }else if(attribute == "building"){
-                isBuilding = true;
             }
         }
-        Child = Child.nextSibling().toElement();
     }
 
-    if(isBuilding){
-        if(bld_tmp.height == 0){
-            bld_tmp.levels = (bld_tmp.levels == 0)?(2):(bld_tmp.levels);
-        }
+    if (xml.hasError()) {
+        qWarning() << "Error while parsing OSM file" << xml.errorString() << "line" << xml.lineNumber();
+        return false;
     }
-    if(isMultipolygon && (bldToBeRemoved.size() > 0)){
-        for(uint i_id=0; i_id<bldToBeRemoved.size(); i_id++){
-            bldMap.remove(bldToBeRemoved[i_id]);
-        }
-        bldMap.insert(bldToBeRemoved[0], bld_tmp);
+
+    if (progressCallback) {
+        progressCallback(100);
     }
+
+    return gpsRefIsSet;
 }
 
 void OsmParserThread::startThreadEvent(QString filePath)
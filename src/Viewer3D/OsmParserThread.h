@@ -11,12 +11,15 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QThread>
-#include <QtXml/QDomDocument>
-#include <QtCore/QMap>
+#include <QtCore/QHash>
 #include <QtGui/QVector3D>
 #include <QtGui/QVector2D>
 #include <QtPositioning/QGeoCoordinate>
 
+#include <functional>
+
+class QIODevice;
+
 ///     @author Omid Esrafilian <esrafilian.omid@gmail.com>
 
 
@@ -30,7 +33,6 @@ class OsmParserThread : public QThread
         std::vector<QGeoCoordinate> points_gps_inner;
         std::vector<QVector2D> points_local;
         std::vector<QVector2D> points_local_inner;
-        std::vector<QVector3D> triangulated_mesh;
         QVector2D bb_max = QVector2D(-1e6, -1e6); //bounding boxes
         QVector2D bb_min = QVector2D(1e6, 1e6); //bounding boxes
         float height;
@@ -62,27 +64,27 @@ class OsmParserThread : public QThread
     explicit OsmParserThread(QObject *parent = nullptr);
 
     QGeoCoordinate gpsRefPoint;
-    QMap<uint64_t, QGeoCoordinate> mapNodes;
-    QMap<uint64_t, BuildingType_t> mapBuildings;
+    QHash<uint64_t, BuildingType_t> mapBuildings;
     QGeoCoordinate coordinateMin, coordinateMax;
+    QByteArray fileHash; ///< Content hash of the loaded file, used as OsmMeshCache key
 
     void start(QString filePath);
 
+    /// Decodes an OSM xml document in a single streaming pass. Node coordinates are only held until the
+    /// document has been read, ways which can not be part of a building are dropped as soon as they end.
+    ///     @param progressCallback Called with the percentage of the device which has been read
+    /// @return true: document contained bounds, so the gps reference is valid
+    static bool decodeStream(QIODevice& device, QHash<uint64_t, BuildingType_t> &buildingMap, QGeoCoordinate& coordinateMin, QGeoCoordinate& coordinateMax, QGeoCoordinate& gpsRef, const std::function<void(int)>& progressCallback = nullptr);
+
 private:
     QThread* _mainThread;
     bool _mapLoadedFlag;
-    QList<QString> _singleStoreyBuildings;
-    QList<QString> _doubleStoreyLeisure;
 
     void parseOsmFile(QString filePath);
-    bool decodeFile(QDomDocument& xml_content, QMap<uint64_t, BuildingType_t > &buildingMap, QMap<uint64_t, QGeoCoordinate> &nodeMap, QGeoCoordinate& coordinateMin, QGeoCoordinate& coordinateMax, QGeoCoordinate& gpsRef);
-    bool decodeNodeTags(QDomElement& xmlComponent, QMap<uint64_t, QGeoCoordinate> &nodeMap, QGeoCoordinate& coordMin, QGeoCoordinate& coordMax, QGeoCoordinate& gpsRef);
-    void decodeBuildings(QDomElement& xmlComponent, QMap<uint64_t, BuildingType_t > &bldMap, QMap<uint64_t, QGeoCoordinate> &nodeMap, QGeoCoordinate& coordMin, QGeoCoordinate& coordMax, QGeoCoordinate gpsRef);
-    void decodeRelations(QDomElement& xmlComponent, QMap<uint64_t, BuildingType_t > &bldMap, QMap<uint64_t, QGeoCoordinate> &nodeMap, QGeoCoordinate gpsRef);
-
 
 signals:
     void fileParsed(bool isValid);
+    void parseProgress(int percent);
     void startThread(QString filePath);
 
 private slots:
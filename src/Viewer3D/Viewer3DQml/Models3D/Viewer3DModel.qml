@@ -123,26 +123,32 @@ View3D {
         Node{
             property real textureDownloadProgress: _terrainTextureManager.textureDownloadProgress
 
-            Model {
-                id: cityMapModel
-                visible: true
-                scale: Qt.vector3d(10, 10, 10)
-                geometry: CityMapGeometry {
-                    id: cityMapGeometry
-                    modelName: "city_map"
-                    osmParser: (viewer3DManager)?(viewer3DManager.osmParser):(null)
+            // One model per mesh chunk, so chunks outside of the view can be culled
+            Repeater3D {
+                id: cityMapChunks
+                model: (viewer3DManager)?(viewer3DManager.osmParser.meshChunkCount):(0)
+
+                delegate: Model {
+                    visible: true
+                    scale: Qt.vector3d(10, 10, 10)
+                    geometry: CityMapGeometry {
+                        modelName: "city_map_" + index
+                        chunkIndex: index
+                        osmParser: (viewer3DManager)?(viewer3DManager.osmParser):(null)
+                    }
+
+                    materials: [ cityMapMaterial ]
                 }
+            }
 
-                materials: [
-                    PrincipledMaterial {
-                        baseColor: "gray"
-                        metalness: 0.1
-                        roughness: 0.5
-                        specularAmount: 1.0
-                        indexOfRefraction: 4.0
-                        opacity: 1.0
-                    }
-                ]
+            PrincipledMaterial {
+                id: cityMapMaterial
+                baseColor: "gray"
+                metalness: 0.1
+                roughness: 0.5
+                specularAmount: 1.0
+                indexOfRefraction: 4.0
+                opacity: 1.0
             }
 
             Model {
@@ -2,12 +2,74 @@
 #include "ADSBVehicleManager.h"
 #include "ADSBVehicle.h"
 #include "ADSBTCPLink.h"
+#include "ADSBSpatialGrid.h"
+#include "ADSBStreamParser.h"
 #include "QmlObjectListModel.h"
+#include "SettingsManager.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
 #include <QtNetwork/QTcpServer>
+#include <QtPositioning/QGeoRectangle>
 #include <QtTest/QTest>
 #include <QtTest/QSignalSpy>
 
+namespace {
+    /// Beast frame of a 112 bit Mode S message given as hex, with the escapes the receiver would add
+    QByteArray beastFrame(const char *modeSHex)
+    {
+        const QByteArray body = QByteArray::fromHex("001a02030405") + QByteArray(1, '\x10') + QByteArray::fromHex(modeSHex);
+
+        QByteArray frame("\x1a" "3");
+        for (const char byte : body) {
+            frame.append(byte);
+            if (static_cast<uint8_t>(byte) == ADSBStreamParser::kBeastEscape) {
+                frame.append(byte);
+            }
+        }
+        return frame;
+    }
+
+    /// SBS-1 traffic for @p aircraftCount aircraft spread over Europe, @p rounds position and velocity reports each
+    QByteArray syntheticSbsStream(int aircraftCount, int rounds)
+    {
+        QByteArray stream;
+        stream.reserve(static_cast<qsizetype>(aircraftCount) * rounds * 180);
+
+        for (int round = 0; round < rounds; round++) {
+            for (int aircraft = 0; aircraft < aircraftCount; aircraft++) {
+                const QByteArray icao = QByteArray::number(0x400000 + aircraft, 16).toUpper();
+                const double lat = 40. + ((aircraft % 100) * 0.2) + (round * 0.001);
+                const double lon = -10. + ((aircraft / 100) * 1.3) + (round * 0.001);
+
+                if (round == 0) {
+                    stream += "MSG,1,1,1," + icao + ",1,,,,,QGC" + QByteArray::number(aircraft) + ",,,,,,,,,,,\r\n";
+                }
+                stream += "MSG,3,1,1," + icao + ",1,,,,,," + QByteArray::number(30000 + aircraft) + ",,,"
+                        + QByteArray::number(lat, 'f', 5) + "," + QByteArray::number(lon, 'f', 5) + ",,,0,0,0,0\r\n";
+                stream += "MSG,4,1,1," + icao + ",1,,,,,,,450.0," + QByteArray::number(aircraft % 360) + ".0,,,-640,,,,,\r\n";
+            }
+        }
+
+        return stream;
+    }
+
+    /// A recorded SBS-1 or Beast stream given with QGC_ADSB_REPLAY_FILE, synthetic traffic otherwise. Empty if the file can't be read.
+    QByteArray replayStream()
+    {
+        const QString replayFile = qEnvironmentVariable("QGC_ADSB_REPLAY_FILE");
+        if (replayFile.isEmpty()) {
+            return syntheticSbsStream(5000, 10);
+        }
+
+        QFile file(replayFile);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return QByteArray();
+        }
+        return file.readAll();
+    }
+}
+
 void ADSBTest::_adsbVehicleTest()
 {
     ADSB::VehicleInfo_t vehicleInfo;
@@ -51,7 +113,7 @@ void ADSBTest::_adsbTcpLinkTest()
     ADSBTCPLink* const adsbLink = new ADSBTCPLink(QHostAddress::LocalHost, 30003, this);
     QVERIFY(adsbLink);
     QVERIFY(adsbLink->init());
-    // QSignalSpy spy(adsbLink, &ADSBTCPLink::adsbVehicleUpdate);
+    QSignalSpy spy(adsbLink, &ADSBTCPLink::adsbVehicleUpdates);
 
     bool timeout = false;
     QVERIFY(server->waitForNewConnection(1000, &timeout));
@@ -63,8 +125,23 @@ void ADSBTest::_adsbTcpLinkTest()
     for (uint8_t i = 0; i < 50; i++) {
         (void) clientSocket->write(message);
     }
+    (void) clientSocket->write("\r\n" "MSG,1,1,1,4CA2BF,1,,,,,RYR123,,,,,,,,,,,\r\n");
+    (void) clientSocket->write(beastFrame("8D4840D6202CC371C32CE0576098"));
 
-    // QVERIFY(spy.wait(5000));
+    // The link may deliver both in one batch or in two
+    const auto receivedUpdates = [&spy]() {
+        QList<ADSB::VehicleInfo_t> updates;
+        for (const QList<QVariant> &arguments : std::as_const(spy)) {
+            updates.append(arguments.at(0).value<QList<ADSB::VehicleInfo_t>>());
+        }
+        return updates;
+    };
+    QTRY_COMPARE_WITH_TIMEOUT(receivedUpdates().count(), 2, 5000);
+
+    const QList<ADSB::VehicleInfo_t> updates = receivedUpdates();
+    QCOMPARE(updates.count(), 2);
+    QCOMPARE(updates.at(0).callsign, QStringLiteral("RYR123"));
+    QCOMPARE(updates.at(1).callsign, QStringLiteral("KLM1023"));
 
     server->close();
 }
@@ -85,5 +162,239 @@ void ADSBTest::_adsbVehicleManagerTest()
     vehicleInfo.availableFlags = ADSB::LocationAvailable;
 
     manager->adsbVehicleUpdate(vehicleInfo);
-    QCOMPARE(manager->adsbVehicles()->count(), 1);
+    // Updates reach the model at the UI update rate
+    QCOMPARE(manager->adsbVehicles()->count(), 0);
+    QTRY_COMPARE(manager->adsbVehicles()->count(), 1);
+}
+
+void ADSBTest::_sbsParserTest()
+{
+    ADSB::VehicleInfo_t vehicleInfo;
+    QVERIFY(ADSBStreamParser::parseSbsLine("MSG,3,1,1,4CA2BF,1,2024/01/01,00:00:00.000,2024/01/01,00:00:00.000,,35000,,,53.10000,-6.20000,,,0,0,0,1", vehicleInfo));
+    QCOMPARE(vehicleInfo.icaoAddress, 0x4CA2BFu);
+    QVERIFY(vehicleInfo.availableFlags == (ADSB::LocationAvailable | ADSB::AltitudeAvailable | ADSB::AlertAvailable));
+    QCOMPARE(vehicleInfo.location.latitude(), 53.1);
+    QCOMPARE(vehicleInfo.location.longitude(), -6.2);
+    QCOMPARE(vehicleInfo.location.altitude(), 35000 * 0.3048);
+    QVERIFY(vehicleInfo.alert);
+
+    vehicleInfo = ADSB::VehicleInfo_t();
+    QVERIFY(ADSBStreamParser::parseSbsLine("MSG,4,1,1,4CA2BF,1,,,,,,,450.5,271.2,,,-640,,,,,", vehicleInfo));
+    QVERIFY(vehicleInfo.availableFlags == (ADSB::HeadingAvailable | ADSB::VelocityAvailable | ADSB::VerticalVelAvailable));
+    QCOMPARE(vehicleInfo.heading, 271.2);
+    QCOMPARE(vehicleInfo.velocity, 450.5 * 0.514444);
+    QCOMPARE(vehicleInfo.verticalVel, -640 * 0.00508);
+
+    vehicleInfo = ADSB::VehicleInfo_t();
+    QVERIFY(!ADSBStreamParser::parseSbsLine("MSG,1,1,1,4CA2BF,1,,,,,   ,,,,,,,,,,,", vehicleInfo));
+    QVERIFY(!ADSBStreamParser::parseSbsLine("MSG,2,1,1,4CA2BF,1,,,,,,0,0,0,53.1,-6.2,,,0,0,0,0", vehicleInfo));
+    QVERIFY(!ADSBStreamParser::parseSbsLine("MSG,3,1,1,ZZZZZZ,1,,,,,,35000,,,53.1,-6.2,,,0,0,0,0", vehicleInfo));
+    QVERIFY(!ADSBStreamParser::parseSbsLine("STA,,5,179,400AE7,10103,2008/11/28,14:58:51.153,2008/11/28,14:58:51.153,RM", vehicleInfo));
+
+    // Lines split over several reads
+    const QByteArray stream("MSG,1,1,1,4CA2BF,1,,,,,RYR123  ,,,,,,,,,,,\r\nMSG,3,1,1,4CA2BF,1,,,,,,35000,,,53.1,-6.2,,,0,0,0,0\n");
+    ADSBStreamParser parser;
+    QList<ADSB::VehicleInfo_t> updates;
+    QByteArray buffer;
+    for (const char byte : stream) {
+        buffer.append(byte);
+        (void) buffer.remove(0, parser.parse(buffer, updates));
+    }
+    QVERIFY(buffer.isEmpty());
+    QCOMPARE(parser.messageCount(), 2ULL);
+    QCOMPARE(updates.count(), 2);
+    QCOMPARE(updates.at(0).callsign, QStringLiteral("RYR123"));
+    QCOMPARE(updates.at(1).location.latitude(), 53.1);
+}
+
+void ADSBTest::_beastParserTest()
+{
+    // Reference messages from "The 1090 Megahertz Riddle" (Junzi Sun)
+    const QByteArray stream = beastFrame("8D4840D6202CC371C32CE0576098")
+                            + beastFrame("8D40621D58C386435CC412692AD6")
+                            + beastFrame("8D40621D58C382D690C8AC2863A7")
+                            + beastFrame("8D485020994409940838175B284F");
+
+    QByteArray corrupted = QByteArray::fromHex("8D4840D6202CC371C32CE0576098");
+    QCOMPARE(ADSBStreamParser::modeSChecksum(reinterpret_cast<const uint8_t*>(corrupted.constData()), ADSBStreamParser::kModeSLongBytes), 0u);
+    corrupted[5] = static_cast<char>(corrupted.at(5) ^ 0x01);
+    QVERIFY(ADSBStreamParser::modeSChecksum(reinterpret_cast<const uint8_t*>(corrupted.constData()), ADSBStreamParser::kModeSLongBytes) != 0);
+
+    ADSBStreamParser parser;
+    QList<ADSB::VehicleInfo_t> updates;
+    QByteArray buffer;
+    for (const char byte : stream) {
+        buffer.append(byte);
+        (void) buffer.remove(0, parser.parse(buffer, updates));
+    }
+    QVERIFY(buffer.isEmpty());
+    QCOMPARE(parser.messageCount(), 4ULL);
+    QCOMPARE(updates.count(), 4);
+
+    QCOMPARE(updates.at(0).icaoAddress, 0x4840D6u);
+    QVERIFY(updates.at(0).availableFlags == ADSB::CallsignAvailable);
+    QCOMPARE(updates.at(0).callsign, QStringLiteral("KLM1023"));
+
+    // First position frame only carries the altitude, the second one completes the CPR pair
+    QVERIFY(updates.at(1).availableFlags == ADSB::AltitudeAvailable);
+    QCOMPARE(updates.at(2).icaoAddress, 0x40621Du);
+    QVERIFY(updates.at(2).availableFlags == (ADSB::LocationAvailable | ADSB::AltitudeAvailable));
+    QVERIFY(qAbs(updates.at(2).location.latitude() - 52.25720) < 1e-5);
+    QVERIFY(qAbs(updates.at(2).location.longitude() - 3.91937) < 1e-5);
+    QCOMPARE(updates.at(2).location.altitude(), 38000 * 0.3048);
+
+    QVERIFY(updates.at(3).availableFlags == (ADSB::HeadingAvailable | ADSB::VelocityAvailable | ADSB::VerticalVelAvailable));
+    QVERIFY(qAbs(updates.at(3).heading - 182.88) < 0.01);
+    QVERIFY(qAbs((updates.at(3).velocity / 0.514444) - 159.20) < 0.01);
+    QCOMPARE(updates.at(3).verticalVel, -832 * 0.00508);
+
+    // A frame with a bad CRC is consumed but produces nothing
+    updates.clear();
+    QCOMPARE(parser.parse(beastFrame(corrupted.toHex().constData()), updates), beastFrame(corrupted.toHex().constData()).size());
+    QVERIFY(updates.isEmpty());
+}
+
+void ADSBTest::_spatialGridTest()
+{
+    ADSBSpatialGrid grid;
+    grid.update(1, QGeoCoordinate(47.5, 8.5));
+    grid.update(2, QGeoCoordinate(-33.9, 151.2));
+    grid.update(3, QGeoCoordinate(60.1, 179.9));
+    grid.update(4, QGeoCoordinate(60.1, -179.9));
+    QCOMPARE(grid.count(), 4);
+
+    QList<uint32_t> result;
+    grid.query(QGeoRectangle(QGeoCoordinate(48., 8.), QGeoCoordinate(47., 9.)), result);
+    QCOMPARE(result, QList<uint32_t>({ 1 }));
+
+    // Moving between cells
+    grid.update(1, QGeoCoordinate(-33.8, 151.1));
+    result.clear();
+    grid.query(QGeoRectangle(QGeoCoordinate(48., 8.), QGeoCoordinate(47., 9.)), result);
+    QVERIFY(result.isEmpty());
+    grid.query(QGeoRectangle(QGeoCoordinate(-33., 151.), QGeoCoordinate(-34., 152.)), result);
+    std::sort(result.begin(), result.end());
+    QCOMPARE(result, QList<uint32_t>({ 1, 2 }));
+
+    // Across the antimeridian
+    result.clear();
+    grid.query(QGeoRectangle(QGeoCoordinate(61., 179.), QGeoCoordinate(59., -179.)), result);
+    std::sort(result.begin(), result.end());
+    QCOMPARE(result, QList<uint32_t>({ 3, 4 }));
+
+    // Whole world takes the occupied cell path
+    result.clear();
+    grid.query(QGeoRectangle(QGeoCoordinate(90., -180.), QGeoCoordinate(-90., 180.)), result);
+    QCOMPARE(result.count(), 4);
+
+    grid.remove(2);
+    QCOMPARE(grid.count(), 3);
+    grid.clear();
+    QCOMPARE(grid.count(), 0);
+}
+
+void ADSBTest::_viewportTest()
+{
+    ADSBVehicleManager manager(SettingsManager::instance()->adsbVehicleManagerSettings());
+
+    const auto aircraft = [](uint32_t icaoAddress, double lat, double lon) {
+        ADSB::VehicleInfo_t vehicleInfo;
+        vehicleInfo.icaoAddress = icaoAddress;
+        vehicleInfo.location = QGeoCoordinate(lat, lon, 1000.);
+        vehicleInfo.availableFlags = ADSB::LocationAvailable | ADSB::AltitudeAvailable;
+        return vehicleInfo;
+    };
+
+    manager.adsbVehicleUpdates({ aircraft(1, 47.5, 8.5), aircraft(2, 47.6, 8.6), aircraft(3, -33.9, 151.2) });
+    manager._processPendingUpdates();
+    QCOMPARE(manager.trackedCount(), 3);
+    QCOMPARE(manager.adsbVehicles()->count(), 3);
+
+    manager.setViewport(QGeoRectangle(QGeoCoordinate(48., 8.), QGeoCoordinate(47., 9.)));
+    manager._processPendingUpdates();
+    QCOMPARE(manager.trackedCount(), 3);
+    QCOMPARE(manager.adsbVehicles()->count(), 2);
+
+    // Leaving the viewport (and its margin) removes the aircraft from the model only
+    manager.adsbVehicleUpdate(aircraft(2, 40., 8.6));
+    manager.adsbVehicleUpdate(aircraft(3, 47.4, 8.4));
+    manager._processPendingUpdates();
+    QCOMPARE(manager.trackedCount(), 3);
+    QCOMPARE(manager.adsbVehicles()->count(), 2);
+    QList<uint32_t> displayed;
+    for (int i = 0; i < manager.adsbVehicles()->count(); i++) {
+        displayed.append(manager.adsbVehicles()->value<ADSBVehicle*>(i)->icaoAddress());
+    }
+    std::sort(displayed.begin(), displayed.end());
+    QCOMPARE(displayed, QList<uint32_t>({ 1, 3 }));
+
+    // Several updates for the same aircraft between two UI updates are merged
+    ADSB::VehicleInfo_t callsign;
+    callsign.icaoAddress = 1;
+    callsign.callsign = QStringLiteral("QGC1");
+    callsign.availableFlags = ADSB::CallsignAvailable;
+    manager.adsbVehicleUpdate(callsign);
+    manager.adsbVehicleUpdate(aircraft(1, 47.7, 8.7));
+    manager._processPendingUpdates();
+    const ADSBVehicle *const adsbVehicle = manager._adsbICAOMap.value(1);
+    QCOMPARE(adsbVehicle->callsign(), QStringLiteral("QGC1"));
+    QCOMPARE(adsbVehicle->coordinate().latitude(), 47.7);
+
+    manager.setViewport(QGeoRectangle());
+    manager._processPendingUpdates();
+    QCOMPARE(manager.adsbVehicles()->count(), 3);
+}
+
+void ADSBTest::_benchmarkReplayParse()
+{
+    const QByteArray stream = replayStream();
+    QVERIFY(!stream.isEmpty());
+
+    ADSBStreamParser parser;
+    QList<ADSB::VehicleInfo_t> updates;
+    QElapsedTimer timer;
+    timer.start();
+    const qsizetype consumed = parser.parse(stream, updates);
+    const qint64 parseNs = qMax<qint64>(1, timer.nsecsElapsed());
+    QVERIFY(consumed > 0);
+    QVERIFY(!updates.isEmpty());
+
+    const double messagesPerSecond = (parser.messageCount() * 1e9) / parseNs;
+    QTest::setBenchmarkResult(messagesPerSecond, QTest::Events);
+}
+
+void ADSBTest::_benchmarkReplayFlush()
+{
+    const QByteArray stream = replayStream();
+    QVERIFY(!stream.isEmpty());
+
+    ADSBStreamParser parser;
+    QList<ADSB::VehicleInfo_t> updates;
+    (void) parser.parse(stream, updates);
+    QVERIFY(!updates.isEmpty());
+
+    // GUI thread work per UI update at a busy receiver rate, with the map showing part of the traffic
+    constexpr qsizetype messagesPerUpdate = 5000;
+    constexpr qint64 maxAverageUpdateNs = 16 * 1000 * 1000;    // One frame
+    ADSBVehicleManager manager(SettingsManager::instance()->adsbVehicleManagerSettings());
+    manager.setViewport(QGeoRectangle(QGeoCoordinate(50., 0.), QGeoCoordinate(45., 10.)));
+
+    QElapsedTimer timer;
+    qint64 totalNs = 0;
+    int flushes = 0;
+    for (qsizetype start = 0; start < updates.count(); start += messagesPerUpdate) {
+        manager.adsbVehicleUpdates(updates.mid(start, messagesPerUpdate));
+        timer.start();
+        manager._processPendingUpdates();
+        totalNs += timer.nsecsElapsed();
+        flushes++;
+    }
+    QVERIFY(manager.trackedCount() > 0);
+    QVERIFY(manager.adsbVehicles()->count() < manager.trackedCount());
+
+    const qint64 averageUpdateNs = totalNs / flushes;
+    QVERIFY2(averageUpdateNs <= maxAverageUpdateNs,
+             qPrintable(QStringLiteral("GUI thread update for %1 aircraft took %2 us").arg(manager.trackedCount()).arg(averageUpdateNs / 1000)));
+
+    QTest::setBenchmarkResult(averageUpdateNs / 1e6, QTest::WalltimeMilliseconds);
 }
@@ -10,4 +10,10 @@ private slots:
     void _adsbVehicleTest();
     void _adsbTcpLinkTest();
     void _adsbVehicleManagerTest();
+    void _sbsParserTest();
+    void _beastParserTest();
+    void _spatialGridTest();
+    void _viewportTest();
+    void _benchmarkReplayParse();
+    void _benchmarkReplayFlush();
 };
@@ -18,6 +18,7 @@
 #include "MAVLinkProtocol.h"
 
 #include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
 #include <QtTest/QTest>
 
 void LogDownloadTest::_downloadTest()
@@ -59,3 +60,79 @@ void LogDownloadTest::_downloadTest()
 
     (void) QFile::remove(downloadFile);
 }
+
+qint64 LogDownloadTest::_downloadFirstLog(LogDownloadController *controller, MultiSignalSpyV2 *multiSpy, const QString &downloadTo)
+{
+    controller->_getModel()->value<QGCLogEntry*>(0)->setSelected(true);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    multiSpy->clearAllSignals();
+    controller->download(downloadTo);
+    if (!multiSpy->waitForSignal("downloadingLogsChanged", 30000)) {
+        return -1;
+    }
+    multiSpy->clearAllSignals();
+    if (controller->_getDownloadingLogs()) {
+        if (!multiSpy->waitForSignal("downloadingLogsChanged", 30000)) {
+            return -1;
+        }
+    }
+    multiSpy->clearAllSignals();
+
+    return timer.elapsed();
+}
+
+void LogDownloadTest::_lossyDownloadTest()
+{
+    static constexpr uint32_t kLogSize = 32 * 1024;
+
+    _connectMockLink(MAV_AUTOPILOT_PX4);
+    _mockLink->setLogDownloadFileSize(kLogSize);
+
+    LogDownloadController *const controller = new LogDownloadController(this);
+    MultiSignalSpyV2 *multiSpyLogDownloadController = new MultiSignalSpyV2(this);
+    QVERIFY(multiSpyLogDownloadController->init(controller));
+
+    controller->refresh();
+    QVERIFY(multiSpyLogDownloadController->waitForSignal("requestingListChanged", 10000));
+    multiSpyLogDownloadController->clearAllSignals();
+    if (controller->_getRequestingList()) {
+        QVERIFY(multiSpyLogDownloadController->waitForSignal("requestingListChanged", 10000));
+    }
+    QCOMPARE(controller->_getModel()->value<QGCLogEntry*>(0)->size(), kLogSize);
+
+    const QString downloadTo = QDir::currentPath();
+    const QString downloadFile = QDir(downloadTo).filePath("log_0_UnknownDate.ulg");
+
+    // Lossless baseline
+    _mockLink->setLogDownloadErrors(0, 0);
+    const qint64 losslessMSecs = _downloadFirstLog(controller, multiSpyLogDownloadController, downloadTo);
+    QVERIFY(losslessMSecs >= 0);
+    QCOMPARE(controller->_getDownloadingLogs(), false);
+    QVERIFY(UnitTest::fileCompare(downloadFile, _mockLink->logDownloadFile()));
+    QVERIFY(QFile::remove(downloadFile));
+    const int losslessRequests = _mockLink->logDownloadRequestCount();
+
+    // Lost and reordered packets must still produce an identical file
+    _mockLink->setLogDownloadErrors(kPacketLoss, kPacketReorder);
+    const qint64 lossyMSecs = _downloadFirstLog(controller, multiSpyLogDownloadController, downloadTo);
+    QVERIFY(lossyMSecs >= 0);
+    QCOMPARE(controller->_getDownloadingLogs(), false);
+    QVERIFY(UnitTest::fileCompare(downloadFile, _mockLink->logDownloadFile()));
+    (void) QFile::remove(downloadFile);
+
+    // Each lost packet should cost at most a few gap requests. Requests repeated for stale, duplicate or reordered
+    // packets would push this well past the bound.
+    const int lossyRequests = _mockLink->logDownloadRequestCount() - losslessRequests;
+    const int numBins = (kLogSize + MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN - 1) / MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
+    const int maxLossyRequests = losslessRequests + static_cast<int>(numBins * kPacketLoss * kMaxRequestsPerLostPacket);
+    QVERIFY2(lossyRequests <= maxLossyRequests, qPrintable(QStringLiteral("%1 > %2").arg(lossyRequests).arg(maxLossyRequests)));
+
+    // Timing depends on the machine running the test, so instead of checking the throughput the share of the lossless
+    // throughput which remains under loss is reported. Both downloads move the same log over the same link.
+    const double losslessBytesPerSecond = kLogSize * 1000.0 / qMax<qint64>(losslessMSecs, 1);
+    const double lossyBytesPerSecond = kLogSize * 1000.0 / qMax<qint64>(lossyMSecs, 1);
+    QTest::setBenchmarkResult(lossyBytesPerSecond / losslessBytesPerSecond, QTest::Events);
+}
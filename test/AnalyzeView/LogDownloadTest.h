@@ -2,10 +2,23 @@
 
 #include "UnitTest.h"
 
+class LogDownloadController;
+class MultiSignalSpyV2;
+
 class LogDownloadTest : public UnitTest
 {
     Q_OBJECT
 
 private slots:
     void _downloadTest();
+    void _lossyDownloadTest();
+
+private:
+    /// Downloads the first log to downloadTo and waits for the download to finish
+    /// @return Time taken in msecs, -1 on timeout
+    static qint64 _downloadFirstLog(LogDownloadController *controller, MultiSignalSpyV2 *multiSpy, const QString &downloadTo);
+
+    static constexpr double kPacketLoss = 0.1;
+    static constexpr double kPacketReorder = 0.1;
+    static constexpr int kMaxRequestsPerLostPacket = 3;
 };
@@ -0,0 +1,137 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "CompressedTelemetryLogTest.h"
+#include "CompressedTelemetryLog.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QtEndian>
+#include <QtTest/QTest>
+
+#include <limits>
+
+QByteArray CompressedTelemetryLogTest::_writeLog(const QString &fileName, bool compressed)
+{
+    TelemetryLogWriter writer;
+    if (!writer.open(fileName, compressed)) {
+        return QByteArray();
+    }
+
+    QByteArray stream;
+    quint64 timestamp = kStartTimeUSecs;
+    for (int block = 0; block < kBlockCount; block++) {
+        QByteArray records;
+        const quint64 firstTimestamp = timestamp;
+        for (int record = 0; record < kRecordsPerBlock; record++) {
+            char bytesTime[sizeof(quint64)];
+            qToBigEndian(timestamp, bytesTime);
+            (void) records.append(bytesTime, sizeof(bytesTime));
+
+            const int payloadLength = 10 + (record % 40);
+            for (int i = 0; i < payloadLength; i++) {
+                (void) records.append(static_cast<char>((record * 7 + i) & 0xFF));
+            }
+
+            timestamp += kRecordIntervalUSecs;
+        }
+        writer.write(records, firstTimestamp, timestamp - kRecordIntervalUSecs);
+        (void) stream.append(records);
+    }
+
+    writer.close();
+    if (writer.error()) {
+        return QByteArray();
+    }
+
+    return stream;
+}
+
+void CompressedTelemetryLogTest::_testRoundTrip()
+{
+    const QTemporaryDir tmpDir;
+    const QString fileName = tmpDir.filePath(QStringLiteral("roundtrip.tlogz"));
+
+    const QByteArray expected = _writeLog(fileName, true);
+    QVERIFY(!expected.isEmpty());
+    QVERIFY(CompressedTelemetryLog::isCompressedLog(fileName));
+    QVERIFY(QFile(fileName).size() < static_cast<qint64>(expected.size()));
+
+    CompressedTelemetryLogDevice device(fileName);
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    QCOMPARE(device.blocks().count(), static_cast<qsizetype>(kBlockCount));
+    QCOMPARE(device.size(), static_cast<qint64>(expected.size()));
+    QCOMPARE(device.firstTimestampUSecs(), kStartTimeUSecs);
+    QCOMPARE(device.lastTimestampUSecs(), kStartTimeUSecs + ((kBlockCount * kRecordsPerBlock) - 1) * kRecordIntervalUSecs);
+    QCOMPARE(device.readAll(), expected);
+    QVERIFY(device.atEnd());
+
+    // Random access across block boundaries
+    const qint64 pos = device.blocks()[2].uncompressedOffset - 5;
+    QVERIFY(device.seek(pos));
+    QCOMPARE(device.read(100), expected.mid(pos, 100));
+}
+
+void CompressedTelemetryLogTest::_testSeekToTimestamp()
+{
+    const QTemporaryDir tmpDir;
+    const QString fileName = tmpDir.filePath(QStringLiteral("seek.tlogz"));
+    QVERIFY(!_writeLog(fileName, true).isEmpty());
+
+    CompressedTelemetryLogDevice device(fileName);
+    QVERIFY(device.open(QIODevice::ReadOnly));
+
+    const quint64 blockDurationUSecs = kRecordsPerBlock * kRecordIntervalUSecs;
+    const quint64 target = kStartTimeUSecs + (3 * blockDurationUSecs) + (blockDurationUSecs / 2);
+    QVERIFY(device.seekToTimestamp(target));
+    QCOMPARE(device.pos(), device.blocks()[3].uncompressedOffset);
+    QCOMPARE(qFromBigEndian<quint64>(device.read(sizeof(quint64)).constData()), kStartTimeUSecs + (3 * blockDurationUSecs));
+
+    // Times outside the log clamp to the first/last block
+    QVERIFY(device.seekToTimestamp(0));
+    QCOMPARE(device.pos(), static_cast<qint64>(0));
+    QVERIFY(device.seekToTimestamp(std::numeric_limits<quint64>::max()));
+    QCOMPARE(device.pos(), device.blocks().last().uncompressedOffset);
+}
+
+void CompressedTelemetryLogTest::_testMissingIndex()
+{
+    const QTemporaryDir tmpDir;
+    const QString fileName = tmpDir.filePath(QStringLiteral("crashed.tlogz"));
+    const QByteArray expected = _writeLog(fileName, true);
+    QVERIFY(!expected.isEmpty());
+
+    // Simulate a crash: drop the index plus part of the final block
+    qint64 lastBlockOffset = 0;
+    {
+        CompressedTelemetryLogDevice device(fileName);
+        QVERIFY(device.open(QIODevice::ReadOnly));
+        lastBlockOffset = device.blocks().last().fileOffset;
+    }
+    QFile file(fileName);
+    QVERIFY(file.resize(lastBlockOffset + CompressedTelemetryLog::blockHeaderSize + 10));
+
+    CompressedTelemetryLogDevice device(fileName);
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    QCOMPARE(device.blocks().count(), static_cast<qsizetype>(kBlockCount - 1));
+    QCOMPARE(device.readAll(), expected.left(device.size()));
+}
+
+void CompressedTelemetryLogTest::_testPlainLog()
+{
+    const QTemporaryDir tmpDir;
+    const QString fileName = tmpDir.filePath(QStringLiteral("plain.tlog"));
+    const QByteArray expected = _writeLog(fileName, false);
+    QVERIFY(!expected.isEmpty());
+    QVERIFY(!CompressedTelemetryLog::isCompressedLog(fileName));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), expected);
+}
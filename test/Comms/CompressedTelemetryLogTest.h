@@ -0,0 +1,32 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class CompressedTelemetryLogTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testRoundTrip();
+    void _testSeekToTimestamp();
+    void _testMissingIndex();
+    void _testPlainLog();
+
+private:
+    /// Writes kBlockCount blocks of fake log records, returns the uncompressed stream
+    static QByteArray _writeLog(const QString &fileName, bool compressed);
+
+    static constexpr int kBlockCount = 5;
+    static constexpr int kRecordsPerBlock = 200;
+    static constexpr quint64 kStartTimeUSecs = 1700000000000000ULL;
+    static constexpr quint64 kRecordIntervalUSecs = 10000;
+};
@@ -0,0 +1,222 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MultiVehicleBenchmark.h"
+#include "Fact.h"
+#include "LinkManager.h"
+#include "MAVLinkProtocol.h"
+#include "MockLink.h"
+#include "MultiVehicleManager.h"
+#include "QmlObjectListModel.h"
+#include "Vehicle.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QSysInfo>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtTest/QTest>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+int environmentInt(const char *name, int defaultValue)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+/// Parses "NAME:rateHz,..." into message id to rate
+QMap<uint32_t, int> parseMessageMix(const QString &mix)
+{
+    QMap<uint32_t, int> telemetryLoad;
+    for (const QString &entry : mix.split(',', Qt::SkipEmptyParts)) {
+        const QStringList parts = entry.trimmed().split(':');
+        const mavlink_message_info_t *const info = (parts.count() == 2) ? mavlink_get_message_info_by_name(parts[0].trimmed().toUpper().toLatin1().constData()) : nullptr;
+        if (!info || !MockLink::telemetryLoadMessageIds().contains(info->msgid) || (parts[1].toInt() <= 0)) {
+            qWarning() << "Ignoring unsupported message mix entry" << entry;
+            continue;
+        }
+        telemetryLoad[info->msgid] = parts[1].toInt();
+    }
+
+    return telemetryLoad;
+}
+
+/// @return count, mean, p50, p99 and max of samples
+QJsonObject distribution(QList<qint64> samples)
+{
+    QJsonObject result;
+    result["count"] = samples.count();
+    if (samples.isEmpty()) {
+        return result;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const qsizetype count = samples.count();
+    const qint64 total = std::accumulate(samples.cbegin(), samples.cend(), qint64(0));
+    result["mean"] = static_cast<double>(total) / count;
+    result["p50"] = samples[count / 2];
+    result["p99"] = samples[qMin(count - 1, (count * 99) / 100)];
+    result["max"] = samples.last();
+
+    return result;
+}
+
+} // namespace
+
+void MultiVehicleBenchmark::cleanup()
+{
+    if (LinkManager::instance()->links().count()) {
+        LinkManager::instance()->disconnectAll();
+        QTRY_COMPARE_WITH_TIMEOUT(MultiVehicleManager::instance()->vehicles()->count(), 0, 10000);
+    }
+
+    UnitTest::cleanup();
+}
+
+void MultiVehicleBenchmark::_benchmarkTelemetryLoad()
+{
+    const int vehicleCount = qBound(1, environmentInt("QGC_BENCHMARK_VEHICLES", kDefaultVehicleCount), kMaxVehicleCount);
+    const int linkCount = qBound(1, environmentInt("QGC_BENCHMARK_LINKS", kDefaultLinkCount), qMin(vehicleCount, kMaxLinkCount));
+    const int durationMSecs = qMax(1000, environmentInt("QGC_BENCHMARK_DURATION_MSECS", kDefaultDurationMSecs));
+    const QString messageMix = qEnvironmentVariable("QGC_BENCHMARK_MESSAGES", QString::fromLatin1(kDefaultMessageMix));
+    const QMap<uint32_t, int> telemetryLoad = parseMessageMix(messageMix);
+    QVERIFY(!telemetryLoad.isEmpty());
+
+    int messagesPerVehiclePerSecond = 0;
+    for (const int rateHz : telemetryLoad) {
+        messagesPerVehiclePerSecond += rateHz;
+    }
+
+    // Vehicles are spread across the links, each link carries several system ids the way a shared radio would
+    for (int i = 0; i < linkCount; i++) {
+        const int linkVehicleCount = (vehicleCount / linkCount) + ((i < (vehicleCount % linkCount)) ? 1 : 0);
+        QVERIFY(MockLink::startTelemetryLoadMockLink(linkVehicleCount, telemetryLoad));
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(MultiVehicleManager::instance()->vehicles()->count(), vehicleCount, 30000);
+    QTest::qWait(kWarmupMSecs);
+
+    // Bytes to message latency: time from MockLink emitting the bytes of a HIGHRES_IMU to MAVLinkProtocol having parsed it.
+    // This includes the wait in the GUI thread event queue. Received messages are also captured for the dispatch replay.
+    QList<qint64> latencyUSecs;
+    QList<QPair<LinkInterface*, mavlink_message_t>> capturedMessages;
+    capturedMessages.reserve(kReplayMessageCount);
+    qint64 receivedMessageCount = 0;
+    const QMetaObject::Connection receiveConnection = connect(MAVLinkProtocol::instance(), &MAVLinkProtocol::messageReceived, this,
+        [&](LinkInterface *link, const mavlink_message_t &message) {
+            receivedMessageCount++;
+            if (message.msgid == MAVLINK_MSG_ID_HIGHRES_IMU) {
+                latencyUSecs.append(static_cast<qint64>(MockLink::telemetryLoadTimestampUSecs() - mavlink_msg_highres_imu_get_time_usec(&message)));
+            }
+            if (capturedMessages.count() < kReplayMessageCount) {
+                capturedMessages.append(qMakePair(link, message));
+            }
+        });
+
+    // GUI event loop lag: how late a periodic timer in the GUI thread fires
+    QList<qint64> lagUSecs;
+    QElapsedTimer lagTimer;
+    QTimer lagProbe;
+    lagProbe.setTimerType(Qt::PreciseTimer);
+    lagProbe.setInterval(kLagProbeIntervalMSecs);
+    (void) connect(&lagProbe, &QTimer::timeout, this, [&lagUSecs, &lagTimer]() {
+        lagUSecs.append(qMax<qint64>(0, (lagTimer.nsecsElapsed() / 1000) - (kLagProbeIntervalMSecs * 1000)));
+        lagTimer.restart();
+    });
+
+    QElapsedTimer windowTimer;
+    windowTimer.start();
+    lagTimer.start();
+    lagProbe.start();
+    QTest::qWait(durationMSecs);
+    lagProbe.stop();
+    (void) disconnect(receiveConnection);
+    const qint64 windowMSecs = windowTimer.elapsed();
+
+    QVERIFY(receivedMessageCount > 0);
+    QVERIFY(!capturedMessages.isEmpty());
+
+    // Per message dispatch: everything connected to MAVLinkProtocol::messageReceived, which includes the Vehicle
+    // message handlers and the Fact updates they make
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+    for (const QPair<LinkInterface*, mavlink_message_t> &captured : std::as_const(capturedMessages)) {
+        emit MAVLinkProtocol::instance()->messageReceived(captured.first, captured.second);
+    }
+    const double dispatchNSecs = static_cast<double>(stageTimer.nsecsElapsed()) / capturedMessages.count();
+
+    // Fact update cost in isolation, every update changes the value so valueChanged is always emitted
+    Vehicle *const vehicle = MultiVehicleManager::instance()->vehicles()->value<Vehicle*>(0);
+    QVERIFY(vehicle);
+    QList<Fact*> facts;
+    for (const QString &factName : vehicle->factNames()) {
+        Fact *const fact = vehicle->getFact(factName);
+        if (fact && (fact->type() == FactMetaData::valueTypeDouble)) {
+            facts.append(fact);
+        }
+    }
+    QVERIFY(!facts.isEmpty());
+
+    qint64 factUpdateCount = 0;
+    stageTimer.restart();
+    for (int i = 0; i < kFactUpdateIterations; i++) {
+        for (Fact *const fact : std::as_const(facts)) {
+            fact->setRawValue(static_cast<double>(i));
+            factUpdateCount++;
+        }
+    }
+    const double factUpdateNSecs = static_cast<double>(stageTimer.nsecsElapsed()) / factUpdateCount;
+
+    QJsonObject configuration;
+    configuration["vehicles"] = vehicleCount;
+    configuration["links"] = linkCount;
+    configuration["durationMSecs"] = durationMSecs;
+    configuration["messageMix"] = messageMix;
+    configuration["offeredMessagesPerSecond"] = vehicleCount * messagesPerVehiclePerSecond;
+
+    QJsonObject results;
+    results["receivedMessagesPerSecond"] = (receivedMessageCount * 1000.0) / windowMSecs;
+    results["bytesToMessageLatencyUSecs"] = distribution(latencyUSecs);
+    results["dispatchNSecsPerMessage"] = dispatchNSecs;
+    results["factUpdateNSecs"] = factUpdateNSecs;
+    results["eventLoopLagUSecs"] = distribution(lagUSecs);
+
+    QJsonObject environment;
+    environment["version"] = QCoreApplication::applicationVersion();
+    environment["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    environment["os"] = QSysInfo::prettyProductName();
+    environment["cpuArchitecture"] = QSysInfo::currentCpuArchitecture();
+    environment["idealThreadCount"] = QThread::idealThreadCount();
+
+    QJsonObject report;
+    report["benchmark"] = QStringLiteral("MultiVehicleBenchmark");
+    report["configuration"] = configuration;
+    report["results"] = results;
+    report["environment"] = environment;
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    const QString outputFile = qEnvironmentVariable("QGC_BENCHMARK_OUTPUT");
+    if (outputFile.isEmpty()) {
+        qDebug().noquote() << json;
+    } else {
+        QFile file(outputFile);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        QCOMPARE(file.write(json), json.size());
+        qDebug() << "Benchmark results written to" << outputFile;
+    }
+
+    QTest::setBenchmarkResult(results["receivedMessagesPerSecond"].toDouble(), QTest::Events);
+}
@@ -0,0 +1,44 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// Headless benchmark which connects many MockLink vehicles streaming telemetry and reports the cost of each stage
+/// of the receive path. Runs standalone only (--unittest:MultiVehicleBenchmark or the benchmark build target).
+///
+/// Configured through the environment:
+///     QGC_BENCHMARK_VEHICLES          Number of vehicles (default 50)
+///     QGC_BENCHMARK_LINKS             Number of links the vehicles are spread over (default 4)
+///     QGC_BENCHMARK_DURATION_MSECS    Length of the measurement window (default 10000)
+///     QGC_BENCHMARK_MESSAGES          Message mix streamed by every vehicle, "NAME:rateHz,..."
+///     QGC_BENCHMARK_OUTPUT            File the JSON results are written to, printed when not set
+class MultiVehicleBenchmark : public UnitTest
+{
+    Q_OBJECT
+
+protected:
+    void cleanup() final;
+
+private slots:
+    void _benchmarkTelemetryLoad();
+
+private:
+    static constexpr int kDefaultVehicleCount = 50;
+    static constexpr int kMaxVehicleCount = 100;            ///< MockLink system ids start at 128
+    static constexpr int kDefaultLinkCount = 4;
+    static constexpr int kMaxLinkCount = 6;                 ///< Each MockLink uses two of the 16 mavlink channels
+    static constexpr int kDefaultDurationMSecs = 10000;
+    static constexpr int kWarmupMSecs = 2000;
+    static constexpr int kLagProbeIntervalMSecs = 10;
+    static constexpr int kReplayMessageCount = 20000;
+    static constexpr int kFactUpdateIterations = 10000;
+    static constexpr const char *kDefaultMessageMix = "ATTITUDE:50,HIGHRES_IMU:50,GLOBAL_POSITION_INT:10,VFR_HUD:10,GPS_RAW_INT:5";
+};
@@ -0,0 +1,59 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "RttEstimatorTest.h"
+#include "RttEstimator.h"
+
+#include <QtTest/QTest>
+
+void RttEstimatorTest::_testDefaultTimeout()
+{
+    const RttEstimator estimator;
+
+    QVERIFY(!estimator.hasSamples());
+    QCOMPARE(estimator.timeoutMSecs(3000, 1000, 10000), 3000);
+    QCOMPARE(estimator.backoffTimeoutMSecs(3, 3000, 1000, 10000), 3000);
+}
+
+void RttEstimatorTest::_testConvergence()
+{
+    RttEstimator estimator;
+
+    // First sample: srtt = R, rttvar = R/2
+    estimator.addSample(200);
+    QCOMPARE(estimator.srttMSecs(), 200.0);
+    QCOMPARE(estimator.rttVarMSecs(), 100.0);
+    QCOMPARE(estimator.timeoutMSecs(3000, 0, 10000), 600);
+
+    // A steady link converges on its rtt and the variance decays
+    for (int i = 0; i < 100; i++) {
+        estimator.addSample(50);
+    }
+    QVERIFY(qAbs(estimator.srttMSecs() - 50.0) < 1.0);
+    QVERIFY(estimator.rttVarMSecs() < 1.0);
+
+    // Timeout is clamped to the minimum on fast links
+    QCOMPARE(estimator.timeoutMSecs(3000, 1000, 10000), 1000);
+
+    // And to the maximum on slow links
+    estimator.reset();
+    estimator.addSample(8000);
+    QCOMPARE(estimator.timeoutMSecs(3000, 1000, 10000), 10000);
+}
+
+void RttEstimatorTest::_testBackoff()
+{
+    RttEstimator estimator;
+    estimator.addSample(400);   // rto = 400 + 4 * 200 = 1200
+
+    QCOMPARE(estimator.backoffTimeoutMSecs(1, 3000, 1000, 10000), 1200);
+    QCOMPARE(estimator.backoffTimeoutMSecs(2, 3000, 1000, 10000), 2400);
+    QCOMPARE(estimator.backoffTimeoutMSecs(3, 3000, 1000, 10000), 4800);
+    QCOMPARE(estimator.backoffTimeoutMSecs(5, 3000, 1000, 10000), 10000);
+}
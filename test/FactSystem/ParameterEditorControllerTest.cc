@@ -0,0 +1,150 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterEditorControllerTest.h"
+#include "ParameterEditorController.h"
+#include "ParameterManager.h"
+#include "Vehicle.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+
+#include <algorithm>
+
+namespace {
+    /// The search the editor did before it had an index, except that an invalid regex is matched literally the way the
+    /// index does. The old search replaced it with an empty QRegularExpression, which matched every parameter.
+    QList<Fact*> fullScan(const QList<Fact*> &facts, const QStringList &terms)
+    {
+        QList<Fact*> result;
+        for (Fact *fact : facts) {
+            bool matched = true;
+            for (const QString &term : terms) {
+                const QRegularExpression re(term, QRegularExpression::CaseInsensitiveOption);
+                if (re.isValid()) {
+                    matched = fact->name().contains(re) || fact->shortDescription().contains(re) || fact->longDescription().contains(re);
+                } else {
+                    matched = fact->name().contains(term, Qt::CaseInsensitive) || fact->shortDescription().contains(term, Qt::CaseInsensitive) || fact->longDescription().contains(term, Qt::CaseInsensitive);
+                }
+                if (!matched) {
+                    break;
+                }
+            }
+            if (matched) {
+                result.append(fact);
+            }
+        }
+        return result;
+    }
+
+    /// Search strings as they appear while typing @p text
+    QStringList keystrokes(const QString &text)
+    {
+        QStringList result;
+        for (int i = 1; i <= text.length(); i++) {
+            result.append(text.left(i));
+        }
+        return result;
+    }
+}
+
+QList<Fact*> ParameterEditorControllerTest::_autopilotFacts() const
+{
+    ParameterManager *const parameterManager = _vehicle->parameterManager();
+    const int compId = _vehicle->defaultComponentId();
+
+    QList<Fact*> facts;
+    for (const QString &name : parameterManager->parameterNames(compId)) {
+        facts.append(parameterManager->getParameter(compId, name));
+    }
+    return facts;
+}
+
+void ParameterEditorControllerTest::_testSearchIndexMatchesFullScan()
+{
+    _connectMockLink(MAV_AUTOPILOT_ARDUPILOTMEGA);
+
+    const QList<Fact*> facts = _autopilotFacts();
+    QVERIFY(facts.count() > 500);
+
+    ParameterSearchIndex index;
+    index.build(facts);
+    QCOMPARE(index.count(), facts.count());
+
+    // Typing, deleting, adding terms, regular expressions and invalid ones, in one session so narrowing is exercised
+    QStringList searches = keystrokes(QStringLiteral("battery"));
+    searches << QStringLiteral("batt") << QStringLiteral("batt ") << QStringLiteral("batt v") << QStringLiteral("batt volt")
+             << QStringLiteral("BATT_") << QStringLiteral("^batt_.*mult") << QStringLiteral("^batt_.*multi") << QStringLiteral("(")
+             << QStringLiteral("( gain") << QStringLiteral("rate yaw") << QStringLiteral("rate ya") << QStringLiteral("RATE YAW P")
+             << QStringLiteral("") << QStringLiteral("x") << QStringLiteral("xyzzy") << QStringLiteral("pos|vel") << QStringLiteral("pos|vel z");
+
+    for (const QString &search : searches) {
+        const QStringList terms = search.split(' ', Qt::SkipEmptyParts);
+        QCOMPARE(index.search(terms), fullScan(facts, terms));
+    }
+}
+
+void ParameterEditorControllerTest::_testControllerSearch()
+{
+    _connectMockLink(MAV_AUTOPILOT_ARDUPILOTMEGA);
+
+    ParameterEditorController controller;
+    QSignalSpy spyParameters(&controller, &ParameterEditorController::parametersChanged);
+    QVERIFY(spyParameters.isValid());
+
+    QVERIFY(controller.setProperty("searchText", QStringLiteral("BATT_CAP")));
+    QVERIFY(spyParameters.wait(2000));
+
+    const ParameterTableModel *const model = qobject_cast<ParameterTableModel*>(controller.property("parameters").value<QAbstractTableModel*>());
+    QVERIFY(model);
+    const QList<Fact*> expected = fullScan(_autopilotFacts(), { QStringLiteral("BATT_CAP") });
+    QVERIFY(!expected.isEmpty());
+    QCOMPARE(model->rowCount(), expected.count());
+    for (int row = 0; row < model->rowCount(); row++) {
+        QCOMPARE(model->factAt(row), expected[row]);
+    }
+}
+
+void ParameterEditorControllerTest::_benchmarkKeystrokeSearch()
+{
+    _connectMockLink(MAV_AUTOPILOT_ARDUPILOTMEGA);
+
+    const QList<Fact*> facts = _autopilotFacts();
+    ParameterSearchIndex index;
+    index.build(facts);
+
+    const QStringList typed = keystrokes(QStringLiteral("compass offset"));
+
+    // Median keystroke over many typed phrases, so a single descheduled keystroke does not decide the result
+    QList<qint64> keystrokeNSecs;
+    keystrokeNSecs.reserve(kKeystrokeRounds * (typed.count() + 1));
+    for (int round = 0; round < kKeystrokeRounds; round++) {
+        QElapsedTimer timer;
+        timer.start();
+        (void) index.search({});
+        keystrokeNSecs.append(timer.nsecsElapsed());
+        for (const QString &search : typed) {
+            timer.start();
+            (void) index.search(search.split(' ', Qt::SkipEmptyParts));
+            keystrokeNSecs.append(timer.nsecsElapsed());
+        }
+    }
+    const auto median = keystrokeNSecs.begin() + (keystrokeNSecs.count() / 2);
+    std::nth_element(keystrokeNSecs.begin(), median, keystrokeNSecs.end());
+    QVERIFY2(*median <= (kMaxKeystrokeMSecs * 1000000LL), qPrintable(QStringLiteral("median keystroke over %1 parameters took %2 us").arg(facts.count()).arg(*median / 1000)));
+
+    // The whole phrase, typed one keystroke at a time
+    QBENCHMARK {
+        (void) index.search({});
+        for (const QString &search : typed) {
+            (void) index.search(search.split(' ', Qt::SkipEmptyParts));
+        }
+    }
+}
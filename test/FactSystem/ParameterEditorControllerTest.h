@@ -0,0 +1,30 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class Fact;
+
+class ParameterEditorControllerTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testSearchIndexMatchesFullScan();
+    void _testControllerSearch();
+    void _benchmarkKeystrokeSearch();
+
+private:
+    QList<Fact*> _autopilotFacts() const;
+
+    static constexpr int kMaxKeystrokeMSecs = 1;
+    static constexpr int kKeystrokeRounds = 50;
+};
@@ -0,0 +1,125 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ImageProtocolManagerTest.h"
+#include "ImageProtocolManager.h"
+#include "MAVLinkLib.h"
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+
+namespace {
+    constexpr int kWidth = 40;
+    constexpr int kHeight = 30;
+    constexpr uint8_t kPayload = 100;
+    constexpr uint16_t kPackets = ((kWidth * kHeight) + kPayload - 1) / kPayload;
+
+    QByteArray rawImage()
+    {
+        QByteArray bytes(kWidth * kHeight, Qt::Uninitialized);
+        for (int i = 0; i < bytes.size(); i++) {
+            bytes[i] = static_cast<char>((i * 7) & 0xFF);
+        }
+        return bytes;
+    }
+
+    mavlink_message_t handshakeMessage(uint32_t size, uint16_t packets, uint8_t payload)
+    {
+        mavlink_message_t message;
+        (void) mavlink_msg_data_transmission_handshake_pack(1, MAV_COMP_ID_CAMERA, &message, MAVLINK_DATA_STREAM_IMG_RAW8U, size, kWidth, kHeight, packets, payload, 0);
+        return message;
+    }
+
+    mavlink_message_t packetMessage(const QByteArray &image, uint16_t seqnr)
+    {
+        uint8_t data[MAVLINK_MSG_ENCAPSULATED_DATA_FIELD_DATA_LEN] = {};
+        const qsizetype position = static_cast<qsizetype>(seqnr) * kPayload;
+        (void) memcpy(data, image.constData() + position, static_cast<size_t>(qMin<qsizetype>(kPayload, image.size() - position)));
+
+        mavlink_message_t message;
+        (void) mavlink_msg_encapsulated_data_pack(1, MAV_COMP_ID_CAMERA, &message, seqnr, data);
+        return message;
+    }
+}
+
+void ImageProtocolManagerTest::_testOutOfOrderWithDuplicates()
+{
+    ImageProtocolManager manager;
+    QSignalSpy spyImage(&manager, &ImageProtocolManager::imageReady);
+    QVERIFY(spyImage.isValid());
+
+    const QByteArray image = rawImage();
+    manager.mavlinkMessageReceived(handshakeMessage(image.size(), kPackets, kPayload));
+
+    // Odd packets first, backwards, with a few retransmissions in between
+    for (int seqnr = kPackets - 1; seqnr >= 0; seqnr -= 2) {
+        manager.mavlinkMessageReceived(packetMessage(image, seqnr));
+        manager.mavlinkMessageReceived(packetMessage(image, seqnr));
+    }
+    for (int seqnr = 0; seqnr < kPackets; seqnr += 2) {
+        manager.mavlinkMessageReceived(packetMessage(image, seqnr));
+    }
+
+    QVERIFY(spyImage.wait(5000));
+    QCOMPARE(spyImage.count(), 1);
+    QCOMPARE(manager.flowImageIndex(), 1u);
+
+    const QImage received = spyImage.at(0).at(0).value<QImage>();
+    QCOMPARE(received.size(), QSize(kWidth, kHeight));
+    for (int row = 0; row < kHeight; row++) {
+        QCOMPARE(QByteArray(reinterpret_cast<const char*>(received.constScanLine(row)), kWidth), image.mid(row * kWidth, kWidth));
+    }
+}
+
+void ImageProtocolManagerTest::_testIncompleteWithDuplicates()
+{
+    ImageProtocolManager manager;
+    QSignalSpy spyImage(&manager, &ImageProtocolManager::imageReady);
+    QVERIFY(spyImage.isValid());
+
+    const QByteArray image = rawImage();
+    manager.mavlinkMessageReceived(handshakeMessage(image.size(), kPackets, kPayload));
+
+    // As many packets as the image has, but the last one is missing
+    for (int seqnr = 0; seqnr < (kPackets - 1); seqnr++) {
+        manager.mavlinkMessageReceived(packetMessage(image, seqnr));
+    }
+    manager.mavlinkMessageReceived(packetMessage(image, 0));
+
+    QVERIFY(!spyImage.wait(200));
+    QCOMPARE(manager.flowImageIndex(), 0u);
+
+    // A transfer is still in progress
+    mavlink_message_t request;
+    QVERIFY(!manager.requestImage(255, MAV_COMP_ID_MISSIONPLANNER, 0, request));
+
+    manager.mavlinkMessageReceived(packetMessage(image, kPackets - 1));
+    QVERIFY(spyImage.wait(5000));
+    QVERIFY(manager.requestImage(255, MAV_COMP_ID_MISSIONPLANNER, 0, request));
+}
+
+void ImageProtocolManagerTest::_testInvalidHandshake()
+{
+    ImageProtocolManager manager;
+    QSignalSpy spyImage(&manager, &ImageProtocolManager::imageReady);
+    QVERIFY(spyImage.isValid());
+
+    const QByteArray image = rawImage();
+
+    // The packets can not hold the announced size, nothing is accepted
+    manager.mavlinkMessageReceived(handshakeMessage(image.size(), kPackets - 1, kPayload));
+    for (int seqnr = 0; seqnr < (kPackets - 1); seqnr++) {
+        manager.mavlinkMessageReceived(packetMessage(image, seqnr));
+    }
+
+    QVERIFY(!spyImage.wait(200));
+
+    mavlink_message_t request;
+    QVERIFY(manager.requestImage(255, MAV_COMP_ID_MISSIONPLANNER, 0, request));
+}
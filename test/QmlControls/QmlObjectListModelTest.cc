@@ -0,0 +1,297 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QmlObjectListModelTest.h"
+#include "QmlObjectListModel.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtTest/QAbstractItemModelTester>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+
+#include <algorithm>
+
+namespace {
+
+QObjectList createObjects(int count, QObject *parent)
+{
+    QObjectList objects;
+    objects.reserve(count);
+    for (int i = 0; i < count; i++) {
+        QObject *const object = new QmlObjectListModelTestObject(parent);
+        object->setObjectName(QString::number(i));
+        objects.append(object);
+    }
+    return objects;
+}
+
+QObjectList modelObjects(const QmlObjectListModel &model)
+{
+    QObjectList objects;
+    for (int i = 0; i < model.count(); i++) {
+        objects.append(const_cast<QObject*>(model[i]));
+    }
+    return objects;
+}
+
+/// Counts the model signals a view would react to
+struct ModelSignalCounts
+{
+    explicit ModelSignalCounts(QmlObjectListModel *model)
+        : inserted(model, &QAbstractItemModel::rowsInserted)
+        , removed(model, &QAbstractItemModel::rowsRemoved)
+        , moved(model, &QAbstractItemModel::rowsMoved)
+        , reset(model, &QAbstractItemModel::modelReset)
+        , countChanged(model, &QmlObjectListModel::countChanged)
+    {}
+
+    int rowSignals() const { return inserted.count() + removed.count() + moved.count() + reset.count(); }
+
+    QSignalSpy inserted;
+    QSignalSpy removed;
+    QSignalSpy moved;
+    QSignalSpy reset;
+    QSignalSpy countChanged;
+};
+
+/// @return Number of dirtyChanged signals the model forwards for a dirtyChanged(false) of object, one per connection
+int forwardedDirtyChanges(QmlObjectListModel &model, QObject *object)
+{
+    QSignalSpy spy(&model, &QmlObjectListModel::dirtyChanged);
+    emit static_cast<QmlObjectListModelTestObject*>(object)->dirtyChanged(false);
+    return spy.count();
+}
+
+/// @return true if only the first row is not tracked for dirty and every other row is tracked exactly once
+bool firstItemSkipped(QmlObjectListModel &model)
+{
+    for (int i = 0; i < model.count(); i++) {
+        if (forwardedDirtyChanges(model, model[i]) != ((i == 0) ? 0 : 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+void QmlObjectListModelTest::_testInsertRemoveRange()
+{
+    QmlObjectListModel model;
+    const QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+    const QObjectList objects = createObjects(10, &model);
+
+    model.append(objects.mid(0, 3));
+    model.append(objects.mid(7, 3));
+
+    ModelSignalCounts counts(&model);
+    model.insert(3, objects.mid(3, 4));
+    QCOMPARE(modelObjects(model), objects);
+    QCOMPARE(counts.inserted.count(), 1);
+    QCOMPARE(counts.inserted[0][1].toInt(), 3);
+    QCOMPARE(counts.inserted[0][2].toInt(), 6);
+    QCOMPARE(counts.countChanged.count(), 1);
+    QVERIFY(model.dirty());
+
+    // Dirty tracking is connected for every inserted object
+    model.setDirty(false);
+    emit static_cast<QmlObjectListModelTestObject*>(objects[5])->dirtyChanged(true);
+    QVERIFY(model.dirty());
+
+    model.setDirty(false);
+    QCOMPARE(model.removeRange(2, 5), objects.mid(2, 5));
+    QCOMPARE(model.count(), 5);
+    QCOMPARE(counts.removed.count(), 1);
+    QCOMPARE(counts.removed[0][1].toInt(), 2);
+    QCOMPARE(counts.removed[0][2].toInt(), 6);
+    QCOMPARE(counts.countChanged.count(), 2);
+    QVERIFY(model.dirty());
+
+    // Removed objects are no longer tracked
+    model.setDirty(false);
+    emit static_cast<QmlObjectListModelTestObject*>(objects[5])->dirtyChanged(true);
+    QVERIFY(!model.dirty());
+
+    QVERIFY(model.removeRange(3, 5).isEmpty());
+    QCOMPARE(model.count(), 5);
+    QCOMPARE(counts.removed.count(), 1);
+}
+
+void QmlObjectListModelTest::_testMoveRange()
+{
+    QmlObjectListModel model;
+    const QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+    const QObjectList objects = createObjects(8, &model);
+    model.append(objects);
+
+    ModelSignalCounts counts(&model);
+
+    // Down: 1,2,3 to the end
+    model.moveRange(1, 3, 5);
+    QCOMPARE(modelObjects(model), (QObjectList{ objects[0], objects[4], objects[5], objects[6], objects[7], objects[1], objects[2], objects[3] }));
+
+    // Up: back to where they were
+    model.moveRange(5, 3, 1);
+    QCOMPARE(modelObjects(model), objects);
+
+    // Single item moves, including the adjacent cases
+    model.move(2, 3);
+    QCOMPARE(modelObjects(model), (QObjectList{ objects[0], objects[1], objects[3], objects[2], objects[4], objects[5], objects[6], objects[7] }));
+    model.move(3, 2);
+    model.move(0, 7);
+    QCOMPARE(modelObjects(model), (QObjectList{ objects[1], objects[2], objects[3], objects[4], objects[5], objects[6], objects[7], objects[0] }));
+    model.move(7, 0);
+    QCOMPARE(modelObjects(model), objects);
+
+    QCOMPARE(counts.moved.count(), 6);
+    QCOMPARE(counts.rowSignals(), 6);
+
+    // Out of range moves are ignored
+    model.moveRange(6, 3, 0);
+    model.moveRange(0, 3, 6);
+    model.moveRange(2, 2, 2);
+    QCOMPARE(modelObjects(model), objects);
+    QCOMPARE(counts.moved.count(), 6);
+}
+
+void QmlObjectListModelTest::_testSyncObjectList()
+{
+    QmlObjectListModel model;
+    const QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+    const QObjectList objects = createObjects(20, &model);
+    model.append(objects.mid(0, 10));
+
+    // Remove 2,3,4 and 8, insert 10,11 after 1 and 12 at the end, move 9 to the front
+    const QObjectList newlist = { objects[9], objects[0], objects[1], objects[10], objects[11], objects[5], objects[6], objects[7], objects[12] };
+
+    ModelSignalCounts counts(&model);
+    QObjectList removed = model.syncObjectList(newlist);
+    std::sort(removed.begin(), removed.end(), [](const QObject *a, const QObject *b) { return a->objectName().toInt() < b->objectName().toInt(); });
+    QCOMPARE(removed, (QObjectList{ objects[2], objects[3], objects[4], objects[8] }));
+    QCOMPARE(modelObjects(model), newlist);
+    QCOMPARE(counts.reset.count(), 0);
+    QCOMPARE(counts.removed.count(), 2);
+    QCOMPARE(counts.inserted.count(), 2);
+    QCOMPARE(counts.moved.count(), 1);
+    QCOMPARE(counts.countChanged.count(), 1);
+
+    // Objects which came in are tracked for dirty, objects which went out are not
+    model.setDirty(false);
+    emit static_cast<QmlObjectListModelTestObject*>(objects[8])->dirtyChanged(true);
+    QVERIFY(!model.dirty());
+    emit static_cast<QmlObjectListModelTestObject*>(objects[11])->dirtyChanged(true);
+    QVERIFY(model.dirty());
+
+    // Nothing to do
+    counts.countChanged.clear();
+    QVERIFY(model.syncObjectList(newlist).isEmpty());
+    QCOMPARE(counts.rowSignals(), 5);
+    QCOMPARE(counts.countChanged.count(), 0);
+
+    // Reversed, every object stays so there are only moves
+    QObjectList reversed = newlist;
+    std::reverse(reversed.begin(), reversed.end());
+    QVERIFY(model.syncObjectList(reversed).isEmpty());
+    QCOMPARE(modelObjects(model), reversed);
+    QCOMPARE(counts.removed.count(), 2);
+    QCOMPARE(counts.inserted.count(), 2);
+
+    // To and from empty
+    QCOMPARE(model.syncObjectList(QObjectList()).count(), reversed.count());
+    QCOMPARE(model.count(), 0);
+    QVERIFY(model.syncObjectList(objects).isEmpty());
+    QCOMPARE(modelObjects(model), objects);
+    QCOMPARE(counts.reset.count(), 0);
+}
+
+void QmlObjectListModelTest::_testSkipDirtyFirstItem()
+{
+    QmlObjectListModel model;
+    model._skipDirtyFirstItem = true;
+    const QObjectList objects = createObjects(6, &model);
+
+    model.append(objects.mid(1, 3));
+    QVERIFY(firstItemSkipped(model));
+
+    model.insert(0, objects[0]);
+    QVERIFY(firstItemSkipped(model));
+
+    model.move(0, 2);
+    QVERIFY(firstItemSkipped(model));
+    model.moveRange(2, 2, 0);
+    QVERIFY(firstItemSkipped(model));
+
+    (void) model.removeAt(0);
+    QVERIFY(firstItemSkipped(model));
+    (void) model.removeRange(0, 2);
+    QVERIFY(firstItemSkipped(model));
+
+    // First item removed, moved away and newly inserted
+    model.append(objects.mid(4, 2));
+    const QObjectList current = modelObjects(model);
+    QVERIFY(model.syncObjectList({ current[1], current[2] }).count() == 1);
+    QVERIFY(firstItemSkipped(model));
+    QVERIFY(model.syncObjectList({ current[2], current[1] }).isEmpty());
+    QVERIFY(firstItemSkipped(model));
+    QVERIFY(model.syncObjectList({ current[0], current[1], current[2] }).isEmpty());
+    QVERIFY(firstItemSkipped(model));
+
+    // Items which left the list are not tracked anymore
+    for (QObject *object : objects) {
+        if (!model.contains(object)) {
+            QCOMPARE(forwardedDirtyChanges(model, object), 0);
+        }
+    }
+}
+
+void QmlObjectListModelTest::_benchmarkLoad()
+{
+    QObject parent;
+    const QObjectList objects = createObjects(kBenchmarkObjects, &parent);
+    QElapsedTimer timer;
+
+    // Per item path, the way large lists used to be loaded
+    QmlObjectListModel perItemModel;
+    ModelSignalCounts perItemCounts(&perItemModel);
+    timer.start();
+    for (QObject *const object : objects) {
+        perItemModel.append(object);
+    }
+    const qint64 perItemNSecs = timer.nsecsElapsed();
+    QCOMPARE(perItemModel.count(), kBenchmarkObjects);
+    QCOMPARE(perItemCounts.inserted.count(), kBenchmarkObjects);
+
+    // Range insert
+    QmlObjectListModel rangeModel;
+    ModelSignalCounts rangeCounts(&rangeModel);
+    timer.restart();
+    rangeModel.append(objects);
+    const qint64 rangeNSecs = timer.nsecsElapsed();
+    QCOMPARE(modelObjects(rangeModel), objects);
+    QCOMPARE(rangeCounts.rowSignals(), 1);
+    QCOMPARE(rangeCounts.countChanged.count(), 1);
+    QVERIFY2(rangeNSecs < perItemNSecs, qPrintable(QStringLiteral("range append %1 us, per item append %2 us").arg(rangeNSecs / 1000).arg(perItemNSecs / 1000)));
+
+    // Reload with one percent of the objects replaced, either a reset or a diff
+    QObjectList reloaded = objects;
+    const QObjectList replacements = createObjects(kBenchmarkObjects / 100, &parent);
+    for (int i = 0; i < replacements.count(); i++) {
+        reloaded[i * 100] = replacements[i];
+    }
+
+    (void) perItemModel.swapObjectList(reloaded);
+    QCOMPARE(modelObjects(perItemModel), reloaded);
+
+    const QObjectList removed = rangeModel.syncObjectList(reloaded);
+    QCOMPARE(removed.count(), replacements.count());
+    QCOMPARE(modelObjects(rangeModel), reloaded);
+    QCOMPARE(rangeCounts.reset.count(), 0);
+
+    QTest::setBenchmarkResult(static_cast<double>(perItemNSecs) / qMax<qint64>(1, rangeNSecs), QTest::Events);
+}
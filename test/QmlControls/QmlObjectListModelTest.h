@@ -0,0 +1,39 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// List entry with the dirtyChanged signal QmlObjectListModel tracks
+class QmlObjectListModelTestObject : public QObject
+{
+    Q_OBJECT
+
+public:
+    using QObject::QObject;
+
+signals:
+    void dirtyChanged(bool dirty);
+};
+
+class QmlObjectListModelTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testInsertRemoveRange();
+    void _testMoveRange();
+    void _testSyncObjectList();
+    void _testSkipDirtyFirstItem();
+    void _benchmarkLoad();
+
+private:
+    static constexpr int kBenchmarkObjects = 10000;
+};
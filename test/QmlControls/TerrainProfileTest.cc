@@ -0,0 +1,200 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TerrainProfileTest.h"
+#include "ComplexMissionItem.h"
+#include "FlightPathSegment.h"
+#include "MissionController.h"
+#include "MissionSettingsItem.h"
+#include "PlanMasterController.h"
+#include "QmlObjectListModel.h"
+#include "SimpleMissionItem.h"
+#include "TerrainProfile.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtTest/QTest>
+
+#include <cmath>
+#include <memory>
+
+namespace {
+
+/// @return Flight path segments in the order TerrainProfile lays them out
+QList<FlightPathSegment*> flightPathSegments(QmlObjectListModel *visualItems)
+{
+    QList<FlightPathSegment*> segments;
+    for (int i = 0; i < visualItems->count(); i++) {
+        const ComplexMissionItem *const complexItem = visualItems->value<ComplexMissionItem*>(i);
+        if (complexItem) {
+            for (int j = 0; j < complexItem->flightPathSegments()->count(); j++) {
+                segments.append(complexItem->flightPathSegments()->value<FlightPathSegment*>(j));
+            }
+        }
+
+        FlightPathSegment *const segment = visualItems->value<VisualMissionItem*>(i)->simpleFlightPathSegment();
+        if (segment) {
+            segments.append(segment);
+        }
+    }
+
+    return segments;
+}
+
+/// Stands in for terrain query results with a rolling terrain profile of sampleCount heights per segment
+void setTerrainHeights(const QList<FlightPathSegment*> &segments, int sampleCount)
+{
+    for (FlightPathSegment *const segment : segments) {
+        const double distanceBetween = segment->totalDistance() / (sampleCount - 1);
+        QVariantList amslTerrainHeights;
+        amslTerrainHeights.reserve(sampleCount);
+        for (int i = 0; i < sampleCount; i++) {
+            amslTerrainHeights.append(20.0 + (10.0 * std::sin(i * 0.3)));
+        }
+
+        (void) segment->setProperty("distanceBetween", distanceBetween);
+        (void) segment->setProperty("finalDistanceBetween", distanceBetween);
+        (void) segment->setProperty("amslTerrainHeights", amslTerrainHeights);
+    }
+}
+
+int vertexCount(QSGNode *rootNode, int childIndex)
+{
+    return static_cast<QSGGeometryNode*>(rootNode->childAtIndex(childIndex))->geometry()->vertexCount();
+}
+
+} // namespace
+
+void TerrainProfileTest::init()
+{
+    UnitTest::init();
+
+    // Fly view segments don't query terrain, the tests provide their own terrain heights
+    _masterController = new PlanMasterController(this);
+    _masterController->setFlyView(true);
+    _masterController->start();
+    _masterController->loadFromFile(QStringLiteral(":/unittest/800Waypoints.mission"));
+
+    MissionController *const missionController = _masterController->missionController();
+    QmlObjectListModel *const visualItems = missionController->visualItems();
+    QVERIFY(visualItems->count() > 800);
+
+    // Relative altitudes need a planned home position to become AMSL
+    for (int i = 1; i < visualItems->count(); i++) {
+        const VisualMissionItem *const item = visualItems->value<VisualMissionItem*>(i);
+        if (item->specifiesCoordinate() && item->coordinate().isValid() && (item->coordinate().latitude() != 0)) {
+            QGeoCoordinate homeCoord = item->coordinate();
+            homeCoord.setAltitude(0);
+            visualItems->value<MissionSettingsItem*>(0)->setInitialHomePosition(homeCoord);
+            break;
+        }
+    }
+
+    QTRY_VERIFY(flightPathSegments(visualItems).count() >= 800);
+    QTRY_VERIFY(missionController->missionTotalDistance() > 0);
+}
+
+void TerrainProfileTest::cleanup()
+{
+    delete _masterController;
+    _masterController = nullptr;
+
+    UnitTest::cleanup();
+}
+
+void TerrainProfileTest::_testLevelOfDetail()
+{
+    MissionController *const missionController = _masterController->missionController();
+    const QList<FlightPathSegment*> segments = flightPathSegments(missionController->visualItems());
+    const int segmentCount = segments.count();
+
+    TerrainProfile profile;
+    profile.setHeight(kProfileHeight);
+    (void) profile.setProperty("visibleWidth", kVisibleWidth);
+    profile.setMissionController(missionController);
+
+    // Each segment contributes at most its two end points plus a low and a high point for each one to two pixel wide bucket
+    const int maxTerrainVertices = static_cast<int>(2 * kVisibleWidth) + (4 * segmentCount);
+
+    int flightProfileSegments = 0;
+    for (const FlightPathSegment *const segment : segments) {
+        if (!qIsNaN(segment->coord1AMSLAlt()) && !qIsNaN(segment->coord2AMSLAlt())) {
+            flightProfileSegments++;
+        }
+    }
+
+    for (const int sampleCount : { kTerrainSamplesPerSegment, kTerrainSamplesPerSegment * 4 }) {
+        setTerrainHeights(segments, sampleCount);
+
+        const std::unique_ptr<QSGNode> rootNode(profile.updatePaintNode(nullptr, nullptr));
+        QCOMPARE(profile._tessellatedSegments, segmentCount);
+
+        const int terrainVertices = vertexCount(rootNode.get(), 0);
+        QVERIFY2(terrainVertices <= maxTerrainVertices, qPrintable(QStringLiteral("%1 > %2").arg(terrainVertices).arg(maxTerrainVertices)));
+        QVERIFY(terrainVertices < (sampleCount * segmentCount));
+        QCOMPARE(vertexCount(rootNode.get(), 1), 0);
+        QCOMPARE(vertexCount(rootNode.get(), 2), flightProfileSegments * 2);
+    }
+
+    // A wider view is a different level of detail so everything is re-tessellated, with more vertices
+    const std::unique_ptr<QSGNode> narrowNode(profile.updatePaintNode(nullptr, nullptr));
+    QCOMPARE(profile._tessellatedSegments, 0);
+    (void) profile.setProperty("visibleWidth", kVisibleWidth * 4);
+    const std::unique_ptr<QSGNode> wideNode(profile.updatePaintNode(nullptr, nullptr));
+    QCOMPARE(profile._tessellatedSegments, segmentCount);
+    QVERIFY(vertexCount(wideNode.get(), 0) > vertexCount(narrowNode.get(), 0));
+}
+
+void TerrainProfileTest::_testSingleWaypointEdit()
+{
+    MissionController *const missionController = _masterController->missionController();
+    QmlObjectListModel *const visualItems = missionController->visualItems();
+    const QList<FlightPathSegment*> segments = flightPathSegments(visualItems);
+    setTerrainHeights(segments, kTerrainSamplesPerSegment);
+
+    TerrainProfile profile;
+    profile.setHeight(kProfileHeight);
+    (void) profile.setProperty("visibleWidth", kVisibleWidth);
+    profile.setMissionController(missionController);
+
+    std::unique_ptr<QSGNode> rootNode(profile.updatePaintNode(nullptr, nullptr));
+    QCOMPARE(profile._tessellatedSegments, segments.count());
+    const int terrainVertices = vertexCount(rootNode.get(), 0);
+    const int flightProfileVertices = vertexCount(rootNode.get(), 2);
+
+    // Nothing changed, nothing is re-tessellated
+    rootNode.reset(profile.updatePaintNode(rootNode.release(), nullptr));
+    QCOMPARE(profile._tessellatedSegments, 0);
+
+    // Raise a waypoint from the middle of the mission, only the segments into and out of it change
+    SimpleMissionItem *editItem = nullptr;
+    for (int i = visualItems->count() / 2; i < visualItems->count(); i++) {
+        editItem = visualItems->value<SimpleMissionItem*>(i);
+        if (editItem && editItem->specifiesCoordinate() && editItem->simpleFlightPathSegment()) {
+            break;
+        }
+        editItem = nullptr;
+    }
+    QVERIFY(editItem);
+    const double amslEntryAlt = editItem->amslEntryAlt();
+    editItem->altitude()->setRawValue(editItem->altitude()->rawValue().toDouble() + 50);
+    QCOMPARE(editItem->simpleFlightPathSegment()->coord1AMSLAlt(), amslEntryAlt + 50);
+    QCoreApplication::processEvents();
+
+    QElapsedTimer timer;
+    timer.start();
+    rootNode.reset(profile.updatePaintNode(rootNode.release(), nullptr));
+    const qint64 editRebuildNSecs = timer.nsecsElapsed();
+
+    QVERIFY(profile._tessellatedSegments >= 1);
+    QVERIFY(profile._tessellatedSegments <= 2);
+    QCOMPARE(vertexCount(rootNode.get(), 0), terrainVertices);
+    QCOMPARE(vertexCount(rootNode.get(), 2), flightProfileVertices);
+
+    QTest::setBenchmarkResult(editRebuildNSecs / 1000000.0, QTest::WalltimeMilliseconds);
+}
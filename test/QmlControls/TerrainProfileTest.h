@@ -0,0 +1,33 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class PlanMasterController;
+
+class TerrainProfileTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void init() final;
+    void cleanup() final;
+
+    void _testLevelOfDetail();
+    void _testSingleWaypointEdit();
+
+private:
+    PlanMasterController *_masterController = nullptr;
+
+    static constexpr double kVisibleWidth = 1000;
+    static constexpr double kProfileHeight = 200;
+    static constexpr int kTerrainSamplesPerSegment = 100;
+};
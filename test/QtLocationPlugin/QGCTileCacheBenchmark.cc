@@ -0,0 +1,127 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCTileCacheBenchmark.h"
+#include "QGCMapTasks.h"
+#include "QGCTileCacheTestHelper.h"
+#include "QGCTileCacheWorker.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTemporaryDir>
+#include <QtSql/QSqlDatabase>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+
+using CacheTotals = QGCTileCacheTestHelper::CacheTotals;
+
+void QGCTileCacheBenchmark::_benchmarkTotalsAndPrune()
+{
+    bool ok = false;
+    int tileCount = qEnvironmentVariableIntValue("QGC_TILE_CACHE_BENCHMARK_TILES", &ok);
+    if (!ok || (tileCount <= 0)) {
+        tileCount = kDefaultBenchmarkTiles;
+    }
+    tileCount = qMax(tileCount, kMinBenchmarkTiles);
+
+    const QTemporaryDir tmpDir;
+    QGCCacheWorker worker;
+    worker.setDatabaseFile(tmpDir.filePath("cache.db"));
+    QVERIFY(worker._init());
+    QVERIFY(worker._connectDB());
+    QSqlDatabase &db = *worker._db;
+
+    // Measure at a tenth of the cache size and at the full size, a tenth of the tiles are also in an offline set
+    const quint64 setID = QGCTileCacheTestHelper::createTileSet(db, "Offline");
+    int savedCount = 0;
+    qint64 totalsNs[2] = {};
+    qint64 pruneNs[2] = {};
+    const int sizes[2] = { tileCount / 10, tileCount };
+    for (int step = 0; step < 2; step++) {
+        const int size = sizes[step];
+        QGCTileCacheTestHelper::saveTiles(worker, db, savedCount, size - savedCount, UINT64_MAX, kBenchmarkTileSize);
+        QGCTileCacheTestHelper::addToTileSet(db, savedCount, (size - savedCount) / 10, setID);
+        savedCount = size;
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < kBenchmarkTotalsIterations; i++) {
+            worker._updateTotals();
+        }
+        totalsNs[step] = timer.nsecsElapsed() / kBenchmarkTotalsIterations;
+
+        const CacheTotals before = QGCTileCacheTestHelper::workerTotals(worker);
+        const CacheTotals scanned = QGCTileCacheTestHelper::scannedTotals(db, worker._getDefaultTileSet());
+        QVERIFY2(before == scanned, qPrintable(before.toString()));
+
+        QGCPruneCacheTask task(static_cast<quint64>(kBenchmarkPruneTiles) * kBenchmarkTileSize);
+        timer.restart();
+        worker._pruneCache(&task);
+        pruneNs[step] = timer.nsecsElapsed();
+        QCOMPARE(QGCTileCacheTestHelper::workerTotals(worker).defaultCount, before.defaultCount - kBenchmarkPruneTiles);
+    }
+
+    worker._disconnectDB();
+
+    // Neither may grow with the cache size the way the full scans used to
+    const auto scales = [](const qint64 (&ns)[2]) {
+        return qMax(ns[1], kScalingFloorNs) <= (qMax(ns[0], kScalingFloorNs) * kMaxScalingFactor);
+    };
+    QVERIFY2(scales(totalsNs), qPrintable(QStringLiteral("totals took %1 ns at %2 tiles, %3 ns at %4 tiles").arg(totalsNs[0]).arg(sizes[0]).arg(totalsNs[1]).arg(sizes[1])));
+    QVERIFY2(scales(pruneNs), qPrintable(QStringLiteral("prune took %1 ns at %2 tiles, %3 ns at %4 tiles").arg(pruneNs[0]).arg(sizes[0]).arg(pruneNs[1]).arg(sizes[1])));
+
+    QTest::setBenchmarkResult(static_cast<qreal>(totalsNs[1]), QTest::WalltimeNanoseconds);
+}
+
+void QGCTileCacheBenchmark::_benchmarkExportImport()
+{
+    bool ok = false;
+    int tileCount = qEnvironmentVariableIntValue("QGC_TILE_CACHE_EXPORT_TILES", &ok);
+    if (!ok || (tileCount <= 0)) {
+        tileCount = kDefaultExportTiles;
+    }
+
+    const QTemporaryDir tmpDir;
+    const QString exportPath = tmpDir.filePath("export.db");
+
+    QGCCacheWorker source;
+    source.setDatabaseFile(tmpDir.filePath("source.db"));
+    QVERIFY(source._init());
+    QVERIFY(source._connectDB());
+    QVERIFY(QGCTileCacheTestHelper::generateTileSets(*source._db, tileCount));
+    const QMap<QString, int> sourceCounts = QGCTileCacheTestHelper::setTileCounts(*source._db);
+    const QList<QGCCachedTileSet*> sets = QGCTileCacheTestHelper::fetchTileSets(source, this);
+
+    QGCExportTileTask exportTask(sets, exportPath);
+    QSignalSpy exportErrorSpy(&exportTask, &QGCMapTask::error);
+    QElapsedTimer timer;
+    timer.start();
+    source._exportSets(&exportTask);
+    const qint64 exportMs = qMax<qint64>(1, timer.elapsed());
+    QCOMPARE(exportErrorSpy.count(), 0);
+    source._disconnectDB();
+
+    QGCCacheWorker target;
+    target.setDatabaseFile(tmpDir.filePath("target.db"));
+    QVERIFY(target._init());
+    QVERIFY(target._connectDB());
+
+    QGCImportTileTask importTask(exportPath, false);
+    QSignalSpy importErrorSpy(&importTask, &QGCMapTask::error);
+    timer.restart();
+    target._importSets(&importTask);
+    const qint64 importMs = qMax<qint64>(1, timer.elapsed());
+    QCOMPARE(importErrorSpy.count(), 0);
+    QCOMPARE(QGCTileCacheTestHelper::setTileCounts(*target._db), sourceCounts);
+    target._disconnectDB();
+
+    QVERIFY2(((tileCount * 1000LL) / exportMs) >= kMinCopyTilesPerSecond, qPrintable(QStringLiteral("export of %1 tiles took %2 ms").arg(tileCount).arg(exportMs)));
+    QVERIFY2(((tileCount * 1000LL) / importMs) >= kMinCopyTilesPerSecond, qPrintable(QStringLiteral("import of %1 tiles took %2 ms").arg(tileCount).arg(importMs)));
+
+    QTest::setBenchmarkResult(static_cast<qreal>(exportMs + importMs), QTest::WalltimeMilliseconds);
+}
@@ -0,0 +1,35 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// Tile cache timings on large caches. Runs standalone only (--unittest:QGCTileCacheBenchmark or the benchmark build target).
+class QGCTileCacheBenchmark : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    /// Cache size can be lowered for quick runs with QGC_TILE_CACHE_BENCHMARK_TILES, e.g. 20000
+    void _benchmarkTotalsAndPrune();
+    /// Cache size can be changed with QGC_TILE_CACHE_EXPORT_TILES
+    void _benchmarkExportImport();
+
+private:
+    static constexpr int kDefaultBenchmarkTiles = 1000000;
+    static constexpr int kBenchmarkTileSize = 256;
+    static constexpr int kBenchmarkPruneTiles = 1000;
+    static constexpr int kMinBenchmarkTiles = kBenchmarkPruneTiles * 20;   ///< The tenth size step must still hold the pruned tiles twice
+    static constexpr int kBenchmarkTotalsIterations = 100;
+    static constexpr int kMaxScalingFactor = 3;             ///< Allowed slowdown from a tenth of the cache to the full cache
+    static constexpr qint64 kScalingFloorNs = 200000;       ///< Timings below this are noise and not compared
+    static constexpr int kDefaultExportTiles = 200000;
+    static constexpr int kMinCopyTilesPerSecond = 5000;     ///< Catches a fall back to per row or quadratic copies
+};
@@ -0,0 +1,107 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCTileCacheTestHelper.h"
+#include "QGCCacheTile.h"
+#include "QGCMapTasks.h"
+#include "QGCTileCacheWorker.h"
+
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+
+void QGCTileCacheTestHelper::saveTiles(QGCCacheWorker &worker, QSqlDatabase &db, int first, int count, quint64 tileSet, int size)
+{
+    (void) db.transaction();
+    for (int i = first; i < (first + count); i++) {
+        QGCSaveTileTask task(new QGCCacheTile(QStringLiteral("tile%1").arg(i), QByteArray(size, 'x'), QStringLiteral("png"), QStringLiteral("0"), tileSet));
+        worker._saveTile(&task);
+    }
+    (void) db.commit();
+}
+
+quint64 QGCTileCacheTestHelper::createTileSet(QSqlDatabase &db, const QString &name)
+{
+    QSqlQuery query(db);
+    (void) query.prepare("INSERT INTO TileSets(name, date) VALUES(?, 0)");
+    query.addBindValue(name);
+    return query.exec() ? query.lastInsertId().toULongLong() : 0;
+}
+
+void QGCTileCacheTestHelper::addToTileSet(QSqlDatabase &db, int first, int count, quint64 setID)
+{
+    QSqlQuery query(db);
+    (void) query.exec(QStringLiteral("INSERT INTO SetTiles(tileID, setID) SELECT tileID, %1 FROM Tiles WHERE tileID >= %2 AND tileID < %3")
+        .arg(setID).arg(first + 1).arg(first + count + 1));
+}
+
+QGCTileCacheTestHelper::CacheTotals QGCTileCacheTestHelper::workerTotals(QGCCacheWorker &worker)
+{
+    worker._updateTotals();
+    return CacheTotals{ worker._totalCount, worker._totalSize, worker._defaultCount, worker._defaultSize };
+}
+
+QGCTileCacheTestHelper::CacheTotals QGCTileCacheTestHelper::scannedTotals(QSqlDatabase &db, quint64 defaultSet)
+{
+    CacheTotals totals;
+    QSqlQuery query(db);
+    if (query.exec("SELECT COUNT(size), SUM(size) FROM Tiles") && query.next()) {
+        totals.totalCount = query.value(0).toUInt();
+        totals.totalSize = query.value(1).toULongLong();
+    }
+    const QString s = QStringLiteral("SELECT COUNT(size), SUM(size) FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A join SetTiles B on A.tileID = B.tileID WHERE B.setID = %1 GROUP by A.tileID HAVING COUNT(A.tileID) = 1)").arg(defaultSet);
+    if (query.exec(s) && query.next()) {
+        totals.defaultCount = query.value(0).toUInt();
+        totals.defaultSize = query.value(1).toULongLong();
+    }
+
+    return totals;
+}
+
+bool QGCTileCacheTestHelper::generateTileSets(QSqlDatabase &db, int tileCount)
+{
+    QSqlQuery query(db);
+    (void) db.transaction();
+    const bool result = query.exec(QStringLiteral(
+            "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < %1) "
+            "INSERT INTO Tiles(hash, format, tile, size, type, date) SELECT 'tile' || i, 'png', randomblob(64), 64, 0, 0 FROM n").arg(tileCount)) &&
+        query.exec("INSERT INTO SetTiles(tileID, setID) SELECT tileID, (SELECT setID FROM TileSets WHERE defaultSet = 1) FROM Tiles") &&
+        query.exec("INSERT INTO TileSets(name, date) VALUES('A', 0)") &&
+        query.exec("INSERT INTO SetTiles(tileID, setID) SELECT tileID, (SELECT setID FROM TileSets WHERE name = 'A') FROM Tiles WHERE tileID % 3 = 0") &&
+        query.exec("INSERT INTO TileSets(name, date) VALUES('B', 0)") &&
+        query.exec("INSERT INTO SetTiles(tileID, setID) SELECT tileID, (SELECT setID FROM TileSets WHERE name = 'B') FROM Tiles WHERE tileID % 5 = 0");
+    (void) db.commit();
+
+    return result;
+}
+
+QList<QGCCachedTileSet*> QGCTileCacheTestHelper::fetchTileSets(QGCCacheWorker &worker, QObject *parent)
+{
+    QList<QGCCachedTileSet*> sets;
+    QGCFetchTileSetTask task;
+    (void) QObject::connect(&task, &QGCFetchTileSetTask::tileSetFetched, parent, [&sets, parent](QGCCachedTileSet *set) {
+        set->setParent(parent);
+        sets.append(set);
+    });
+    worker._getTileSets(&task);
+
+    return sets;
+}
+
+QMap<QString, int> QGCTileCacheTestHelper::setTileCounts(QSqlDatabase &db)
+{
+    QMap<QString, int> counts;
+    QSqlQuery query(db);
+    if (query.exec("SELECT S.name, COUNT(T.tileID) FROM TileSets S JOIN SetTiles T ON T.setID = S.setID GROUP BY S.name")) {
+        while (query.next()) {
+            counts[query.value(0).toString()] = query.value(1).toInt();
+        }
+    }
+
+    return counts;
+}
@@ -0,0 +1,51 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QString>
+
+class QGCCacheWorker;
+class QGCCachedTileSet;
+class QObject;
+class QSqlDatabase;
+
+/// Cache setup and inspection shared by QGCTileCacheWorkerTest and QGCTileCacheBenchmark
+class QGCTileCacheTestHelper
+{
+public:
+    struct CacheTotals
+    {
+        quint32 totalCount = 0;
+        quint64 totalSize = 0;
+        quint32 defaultCount = 0;
+        quint64 defaultSize = 0;
+
+        bool operator==(const CacheTotals &other) const = default;
+
+        QString toString() const
+        {
+            return QStringLiteral("total %1 tiles %2 bytes, default %3 tiles %4 bytes").arg(totalCount).arg(totalSize).arg(defaultCount).arg(defaultSize);
+        }
+    };
+
+    static void saveTiles(QGCCacheWorker &worker, QSqlDatabase &db, int first, int count, quint64 tileSet = UINT64_MAX, int size = 100);
+    static quint64 createTileSet(QSqlDatabase &db, const QString &name);
+    static void addToTileSet(QSqlDatabase &db, int first, int count, quint64 setID);
+    static CacheTotals workerTotals(QGCCacheWorker &worker);
+    /// Totals computed from scratch the way they were before CacheTotals
+    static CacheTotals scannedTotals(QSqlDatabase &db, quint64 defaultSet);
+    /// Generates tileCount tiles with random content in the default set, a third of them also in set "A" and a fifth in set "B"
+    static bool generateTileSets(QSqlDatabase &db, int tileCount);
+    static QList<QGCCachedTileSet*> fetchTileSets(QGCCacheWorker &worker, QObject *parent);
+    /// @return Number of tiles in each set, by set name
+    static QMap<QString, int> setTileCounts(QSqlDatabase &db);
+};
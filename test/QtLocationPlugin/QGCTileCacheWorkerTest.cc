@@ -0,0 +1,251 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCTileCacheWorkerTest.h"
+#include "QGCCacheTile.h"
+#include "QGCMapTasks.h"
+#include "QGCTileCacheTestHelper.h"
+#include "QGCTileCacheWorker.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+
+using CacheTotals = QGCTileCacheTestHelper::CacheTotals;
+
+void QGCTileCacheWorkerTest::_testTotals()
+{
+    const QTemporaryDir tmpDir;
+    QGCCacheWorker worker;
+    worker.setDatabaseFile(tmpDir.filePath("cache.db"));
+    QVERIFY(worker._init());
+    QVERIFY(worker._connectDB());
+    QSqlDatabase &db = *worker._db;
+    const quint64 defaultSet = worker._getDefaultTileSet();
+
+    QCOMPARE(QGCTileCacheTestHelper::workerTotals(worker), CacheTotals());
+
+    // 100 browsed tiles, 50 of them also part of an offline set, plus 20 tiles only in the offline set
+    QGCTileCacheTestHelper::saveTiles(worker, db, 0, 100);
+    const quint64 setID = QGCTileCacheTestHelper::createTileSet(db, "Offline");
+    QVERIFY(setID != 0);
+    QGCTileCacheTestHelper::addToTileSet(db, 50, 50, setID);
+    QGCTileCacheTestHelper::saveTiles(worker, db, 100, 20, setID, 200);
+
+    CacheTotals totals = QGCTileCacheTestHelper::workerTotals(worker);
+    QVERIFY2(totals == (CacheTotals{ 120, 14000, 50, 5000 }), qPrintable(totals.toString()));
+    QVERIFY2(totals == QGCTileCacheTestHelper::scannedTotals(db, defaultSet), qPrintable(totals.toString()));
+
+    // Saving an existing tile again changes nothing
+    QGCTileCacheTestHelper::saveTiles(worker, db, 0, 1);
+    QCOMPARE(QGCTileCacheTestHelper::workerTotals(worker), totals);
+
+    // Deleting the offline set keeps the shared tiles, which now belong to the default set only
+    worker._deleteTileSet(setID);
+    totals = QGCTileCacheTestHelper::workerTotals(worker);
+    QVERIFY2(totals == (CacheTotals{ 100, 10000, 100, 10000 }), qPrintable(totals.toString()));
+    QVERIFY2(totals == QGCTileCacheTestHelper::scannedTotals(db, defaultSet), qPrintable(totals.toString()));
+
+    // A tile getting a reused tileID must not inherit SetTiles rows of the deleted tile
+    QSqlQuery query(db);
+    QVERIFY(query.exec("DELETE FROM Tiles WHERE tileID = (SELECT MAX(tileID) FROM Tiles)"));
+    QGCTileCacheTestHelper::saveTiles(worker, db, 1000, 1);
+    totals = QGCTileCacheTestHelper::workerTotals(worker);
+    QVERIFY2(totals == (CacheTotals{ 100, 10000, 100, 10000 }), qPrintable(totals.toString()));
+    QVERIFY(query.exec("SELECT COUNT(*) FROM SetTiles") && query.next());
+    QCOMPARE(query.value(0).toInt(), 100);
+
+    worker._disconnectDB();
+}
+
+void QGCTileCacheWorkerTest::_testPrune()
+{
+    const QTemporaryDir tmpDir;
+    QGCCacheWorker worker;
+    worker.setDatabaseFile(tmpDir.filePath("cache.db"));
+    QVERIFY(worker._init());
+    QVERIFY(worker._connectDB());
+    QSqlDatabase &db = *worker._db;
+
+    QGCTileCacheTestHelper::saveTiles(worker, db, 0, 100);
+    const quint64 setID = QGCTileCacheTestHelper::createTileSet(db, "Offline");
+    QGCTileCacheTestHelper::addToTileSet(db, 0, 10, setID);
+
+    // Fetching tile0 - tile19 makes them the most recently used. tile0 - tile9 are protected by the offline set anyway.
+    QSqlQuery query(db);
+    QVERIFY(query.exec("UPDATE DefaultTiles SET accessed = 0"));
+    int fetchedCount = 0;
+    for (int i = 0; i < 20; i++) {
+        QGCFetchTileTask task(QStringLiteral("tile%1").arg(i));
+        (void) connect(&task, &QGCFetchTileTask::tileFetched, this, [&fetchedCount](QGCCacheTile *tile) {
+            fetchedCount++;
+            delete tile;
+        });
+        worker._getTile(&task);
+    }
+    QCOMPARE(fetchedCount, 20);
+    worker._updateTileAccess();
+
+    // 25 tiles worth is evicted in one go, least recently used first
+    QGCPruneCacheTask pruneTask(2500);
+    worker._pruneCache(&pruneTask);
+    const CacheTotals totals = QGCTileCacheTestHelper::workerTotals(worker);
+    QVERIFY2(totals == (CacheTotals{ 75, 7500, 65, 6500 }), qPrintable(totals.toString()));
+    QVERIFY2(totals == QGCTileCacheTestHelper::scannedTotals(db, worker._getDefaultTileSet()), qPrintable(totals.toString()));
+    QVERIFY(query.exec("SELECT COUNT(*) FROM Tiles WHERE hash IN ('tile0', 'tile19', 'tile20', 'tile44', 'tile45')") && query.next());
+    QCOMPARE(query.value(0).toInt(), 3);
+
+    // Pruning more than there is leaves only the offline set
+    QGCPruneCacheTask pruneAllTask(UINT32_MAX);
+    worker._pruneCache(&pruneAllTask);
+    QCOMPARE(QGCTileCacheTestHelper::workerTotals(worker), (CacheTotals{ 10, 1000, 0, 0 }));
+
+    worker._disconnectDB();
+}
+
+void QGCTileCacheWorkerTest::_testTotalsMigration()
+{
+    const QTemporaryDir tmpDir;
+    QGCCacheWorker worker;
+    worker.setDatabaseFile(tmpDir.filePath("cache.db"));
+    QVERIFY(worker._init());
+    QVERIFY(worker._connectDB());
+    QSqlDatabase &db = *worker._db;
+
+    QGCTileCacheTestHelper::saveTiles(worker, db, 0, 100);
+    const quint64 setID = QGCTileCacheTestHelper::createTileSet(db, "Offline");
+    QGCTileCacheTestHelper::addToTileSet(db, 25, 50, setID);
+    const CacheTotals totals = QGCTileCacheTestHelper::workerTotals(worker);
+
+    // Turn it into a database from before CacheTotals, including a SetTiles row left behind by a deleted tile
+    QSqlQuery query(db);
+    for (const char *const trigger : { "TilesInsertTotals", "TilesDeleteTotals", "SetTilesInsertDefault", "SetTilesDeleteDefault" }) {
+        QVERIFY(query.exec(QStringLiteral("DROP TRIGGER %1").arg(trigger)));
+    }
+    QVERIFY(query.exec("DROP TABLE DefaultTiles"));
+    QVERIFY(query.exec("DROP TABLE CacheTotals"));
+    QVERIFY(query.exec(QStringLiteral("INSERT INTO SetTiles(tileID, setID) VALUES(100000, %1)").arg(worker._getDefaultTileSet())));
+
+    QVERIFY(worker._createCacheTotals(db));
+    QCOMPARE(QGCTileCacheTestHelper::workerTotals(worker), totals);
+
+    worker._disconnectDB();
+}
+
+void QGCTileCacheWorkerTest::_testExportImport()
+{
+    const QTemporaryDir tmpDir;
+    const QString sourcePath = tmpDir.filePath("source.db");
+    const QString exportPath = tmpDir.filePath("export.db");
+
+    QGCCacheWorker source;
+    source.setDatabaseFile(sourcePath);
+    QVERIFY(source._init());
+    QVERIFY(source._connectDB());
+    QVERIFY(QGCTileCacheTestHelper::generateTileSets(*source._db, kExportTiles));
+    const QMap<QString, int> sourceCounts = QGCTileCacheTestHelper::setTileCounts(*source._db);
+    QCOMPARE(sourceCounts.count(), 3);
+
+    const QList<QGCCachedTileSet*> sets = QGCTileCacheTestHelper::fetchTileSets(source, this);
+    QCOMPARE(sets.count(), 3);
+
+    QGCExportTileTask exportTask(sets, exportPath);
+    QSignalSpy exportErrorSpy(&exportTask, &QGCMapTask::error);
+    QSignalSpy exportProgressSpy(&exportTask, &QGCExportTileTask::actionProgress);
+    source._exportSets(&exportTask);
+    QCOMPARE(exportErrorSpy.count(), 0);
+    QVERIFY(!exportProgressSpy.isEmpty());
+    QCOMPARE(exportProgressSpy.last().at(0).toInt(), 100);
+    source._disconnectDB();
+
+    // The target cache already has some of the tiles in its default set, these must not be duplicated
+    QGCCacheWorker target;
+    target.setDatabaseFile(tmpDir.filePath("target.db"));
+    QVERIFY(target._init());
+    QVERIFY(target._connectDB());
+    QSqlDatabase &db = *target._db;
+    QSqlQuery query(db);
+    QVERIFY(target._attachDatabase(sourcePath, QStringLiteral("SourceDB")));
+    QVERIFY(query.exec("INSERT INTO Tiles(hash, format, tile, size, type, date) SELECT hash, format, tile, size, type, date FROM SourceDB.Tiles WHERE tileID <= 1000"));
+    QVERIFY(query.exec(QStringLiteral("INSERT INTO SetTiles(tileID, setID) SELECT tileID, %1 FROM main.Tiles").arg(target._getDefaultTileSet())));
+
+    QGCImportTileTask importTask(exportPath, false);
+    QSignalSpy importErrorSpy(&importTask, &QGCMapTask::error);
+    target._importSets(&importTask);
+    QCOMPARE(importErrorSpy.count(), 0);
+    QCOMPARE(importTask.progress(), 100);
+
+    // Same sets with the same tiles, each tile stored once with the original content
+    QCOMPARE(QGCTileCacheTestHelper::setTileCounts(db), sourceCounts);
+    QVERIFY(query.exec("SELECT COUNT(tileID) FROM Tiles") && query.next());
+    QCOMPARE(query.value(0).toInt(), kExportTiles);
+    QVERIFY(query.exec("SELECT COUNT(*) FROM main.Tiles M JOIN SourceDB.Tiles S ON S.hash = M.hash WHERE M.tile != S.tile") && query.next());
+    QCOMPARE(query.value(0).toInt(), 0);
+    QVERIFY(query.exec(
+        "SELECT COUNT(*) FROM (SELECT S.name, T.hash FROM main.TileSets S JOIN main.SetTiles ST ON ST.setID = S.setID JOIN main.Tiles T ON T.tileID = ST.tileID "
+        "EXCEPT SELECT S.name, T.hash FROM SourceDB.TileSets S JOIN SourceDB.SetTiles ST ON ST.setID = S.setID JOIN SourceDB.Tiles T ON T.tileID = ST.tileID)") && query.next());
+    QCOMPARE(query.value(0).toInt(), 0);
+    query.finish();
+    target._detachDatabase(QStringLiteral("SourceDB"));
+
+    const CacheTotals totals = QGCTileCacheTestHelper::workerTotals(target);
+    QVERIFY2(totals == QGCTileCacheTestHelper::scannedTotals(db, target._getDefaultTileSet()), qPrintable(totals.toString()));
+
+    target._disconnectDB();
+}
+
+void QGCTileCacheWorkerTest::_testExportImportCancel()
+{
+    const QTemporaryDir tmpDir;
+    const QString exportPath = tmpDir.filePath("export.db");
+
+    QGCCacheWorker source;
+    source.setDatabaseFile(tmpDir.filePath("source.db"));
+    QVERIFY(source._init());
+    QVERIFY(source._connectDB());
+    QVERIFY(QGCTileCacheTestHelper::generateTileSets(*source._db, QGCCacheWorker::kCopyBatchSize * 5));
+    const QList<QGCCachedTileSet*> sets = QGCTileCacheTestHelper::fetchTileSets(source, this);
+
+    // Canceling an export removes the partial file
+    QGCExportTileTask canceledExportTask(sets, exportPath);
+    (void) connect(&canceledExportTask, &QGCExportTileTask::actionProgress, this, [&canceledExportTask]() { canceledExportTask.cancel(); });
+    QSignalSpy exportCompletedSpy(&canceledExportTask, &QGCExportTileTask::actionCompleted);
+    source._exportSets(&canceledExportTask);
+    QCOMPARE(exportCompletedSpy.count(), 1);
+    QVERIFY(!QFile::exists(exportPath));
+
+    QGCExportTileTask exportTask(sets, exportPath);
+    source._exportSets(&exportTask);
+    QVERIFY(QFile::exists(exportPath));
+    source._disconnectDB();
+
+    // Canceling an import leaves the cache as it was
+    QGCCacheWorker target;
+    target.setDatabaseFile(tmpDir.filePath("target.db"));
+    QVERIFY(target._init());
+    QVERIFY(target._connectDB());
+    QGCTileCacheTestHelper::saveTiles(target, *target._db, 0, 10);
+    const QMap<QString, int> counts = QGCTileCacheTestHelper::setTileCounts(*target._db);
+    const CacheTotals totals = QGCTileCacheTestHelper::workerTotals(target);
+
+    QGCImportTileTask importTask(exportPath, false);
+    (void) connect(&importTask, &QGCImportTileTask::actionProgress, this, [&importTask]() { importTask.cancel(); });
+    QSignalSpy importErrorSpy(&importTask, &QGCMapTask::error);
+    QSignalSpy importCompletedSpy(&importTask, &QGCImportTileTask::actionCompleted);
+    target._importSets(&importTask);
+    QCOMPARE(importCompletedSpy.count(), 1);
+    QCOMPARE(importErrorSpy.count(), 0);
+    QCOMPARE(QGCTileCacheTestHelper::setTileCounts(*target._db), counts);
+    QCOMPARE(QGCTileCacheTestHelper::workerTotals(target), totals);
+
+    target._disconnectDB();
+}
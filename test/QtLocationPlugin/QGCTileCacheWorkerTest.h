@@ -0,0 +1,27 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class QGCTileCacheWorkerTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testTotals();
+    void _testPrune();
+    void _testTotalsMigration();
+    void _testExportImport();
+    void _testExportImportCancel();
+
+private:
+    static constexpr int kExportTiles = 5000;    ///< Several copy batches, 1000 of them already in the import target
+};
@@ -29,11 +29,15 @@
 #include "QGCCameraManagerTest.h"
 
 // Comms
+#include "CompressedTelemetryLogTest.h"
+#include "MultiVehicleBenchmark.h"
 #include "QGCSerialPortInfoTest.h"
+#include "RttEstimatorTest.h"
 
 // FactSystem
 #include "FactSystemTestGeneric.h"
 #include "FactSystemTestPX4.h"
+#include "ParameterEditorControllerTest.h"
 #include "ParameterManagerTest.h"
 
 // FollowMe
@@ -43,6 +47,7 @@
 #include "GpsTest.h"
 
 // MAVLink
+#include "ImageProtocolManagerTest.h"
 #include "StatusTextHandlerTest.h"
 #include "SigningTest.h"
 
@@ -75,6 +80,12 @@
 #include "ComponentInformationTranslationTest.h"
 
 // QmlControls
+#include "QmlObjectListModelTest.h"
+#include "TerrainProfileTest.h"
+
+// QtLocationPlugin
+#include "QGCTileCacheBenchmark.h"
+#include "QGCTileCacheWorkerTest.h"
 
 // Terrain
 #include "TerrainQueryTest.h"
@@ -83,6 +94,7 @@
 // UI
 
 // Utilities
+#include "QGCCRC32Test.h"
 // Audio
 #include "AudioOutputTest.h"
 // Compression
@@ -101,10 +113,26 @@
 #include "FTPManagerTest.h"
 // #include "InitialConnectTest.h"
 #include "MAVLinkLogManagerTest.h"
+#include "MavCommandRetryTest.h"
 // #include "RequestMessageTest.h"
 // #include "SendMavCommandWithHandlerTest.h"
 // #include "SendMavCommandWithSignalingTest.h"
+#include "TrajectoryPointsTest.h"
 #include "VehicleLinkManagerTest.h"
+// VehicleSetup
+#ifndef QGC_NO_SERIAL_LINK
+#include "BootloaderTest.h"
+#endif
+
+// VideoManager
+#include "VideoLatencyStatsTest.h"
+
+// Viewer3D
+#ifdef QGC_VIEWER3D
+#include "OsmMeshCacheTest.h"
+#include "OsmParserBenchmark.h"
+#include "OsmParserTest.h"
+#endif
 
 // Missing
 // #include "FlightGearUnitTest.h"
@@ -132,11 +160,15 @@ int QGCUnitTest::runTests(bool stress, const QStringList& unitTests)
     UT_REGISTER_TEST(QGCCameraManagerTest)
 
     // Comms
+    UT_REGISTER_TEST(CompressedTelemetryLogTest)
+    UT_REGISTER_TEST_STANDALONE(MultiVehicleBenchmark)
     UT_REGISTER_TEST(QGCSerialPortInfoTest)
+    UT_REGISTER_TEST(RttEstimatorTest)
 
     // FactSystem
     UT_REGISTER_TEST(FactSystemTestGeneric)
     UT_REGISTER_TEST(FactSystemTestPX4)
+    UT_REGISTER_TEST(ParameterEditorControllerTest)
     UT_REGISTER_TEST(ParameterManagerTest)
 
     // FollowMe
@@ -146,6 +178,7 @@ int QGCUnitTest::runTests(bool stress, const QStringList& unitTests)
     // UT_REGISTER_TEST(GpsTest)
 
     // MAVLink
+    UT_REGISTER_TEST(ImageProtocolManagerTest)
     UT_REGISTER_TEST(StatusTextHandlerTest)
     UT_REGISTER_TEST(SigningTest)
 
@@ -176,6 +209,12 @@ int QGCUnitTest::runTests(bool stress, const QStringList& unitTests)
     // qgcunittest
 
     // QmlControls
+    UT_REGISTER_TEST(QmlObjectListModelTest)
+    UT_REGISTER_TEST(TerrainProfileTest)
+
+    // QtLocationPlugin
+    UT_REGISTER_TEST_STANDALONE(QGCTileCacheBenchmark)
+    UT_REGISTER_TEST(QGCTileCacheWorkerTest)
 
     // Terrain
     UT_REGISTER_TEST(TerrainQueryTest)
@@ -184,6 +223,7 @@ int QGCUnitTest::runTests(bool stress, const QStringList& unitTests)
     // UI
 
     // Utilities
+    UT_REGISTER_TEST(QGCCRC32Test)
     // Audio
     UT_REGISTER_TEST(AudioOutputTest)
     // Compression
@@ -202,10 +242,26 @@ int QGCUnitTest::runTests(bool stress, const QStringList& unitTests)
     UT_REGISTER_TEST(FTPManagerTest)
     // UT_REGISTER_TEST(InitialConnectTest)
     UT_REGISTER_TEST(MAVLinkLogManagerTest)
+    UT_REGISTER_TEST(MavCommandRetryTest)
     // UT_REGISTER_TEST(RequestMessageTest)
     // UT_REGISTER_TEST(SendMavCommandWithHandlerTest)
     // UT_REGISTER_TEST(SendMavCommandWithSignalingTest)
+    UT_REGISTER_TEST(TrajectoryPointsTest)
     UT_REGISTER_TEST(VehicleLinkManagerTest)
+    // VehicleSetup
+#ifndef QGC_NO_SERIAL_LINK
+    UT_REGISTER_TEST(BootloaderTest)
+#endif
+
+    // VideoManager
+    UT_REGISTER_TEST(VideoLatencyStatsTest)
+
+    // Viewer3D
+#ifdef QGC_VIEWER3D
+    UT_REGISTER_TEST(OsmMeshCacheTest)
+    UT_REGISTER_TEST_STANDALONE(OsmParserBenchmark)
+    UT_REGISTER_TEST(OsmParserTest)
+#endif
 
     // Missing
     // UT_REGISTER_TEST(FlightGearUnitTest)
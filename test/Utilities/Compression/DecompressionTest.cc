@@ -3,8 +3,19 @@
 #include "QGCZlib.h"
 #include "QGCZip.h"
 
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
 #include <QtTest/QTest>
 
+QByteArray DecompressionTest::_readResource(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
 void DecompressionTest::_testDecompressGzip()
 {
     const QString gzippedFileName = QStringLiteral(":/unittest/manifest.json.gz");
@@ -28,3 +39,118 @@ void DecompressionTest::_testUnzip()
     const bool result = QGCZip::unzipFile(zipFilename, decompressedPath);
     QVERIFY(result);
 }
+
+void DecompressionTest::_testInflateGzipStream()
+{
+    const QTemporaryDir tmpDir;
+    const QString decompressedFilename = tmpDir.filePath(QStringLiteral("manifest.json"));
+    QVERIFY(QGCZlib::inflateGzipFile(QStringLiteral(":/unittest/manifest.json.gz"), decompressedFilename));
+    const QByteArray expected = _readResource(decompressedFilename);
+    QVERIFY(!expected.isEmpty());
+
+    // Buffer to buffer
+    QByteArray decompressed;
+    QVERIFY(QGCZlib::inflateGzip(_readResource(QStringLiteral(":/unittest/manifest.json.gz")), decompressed));
+    QCOMPARE(decompressed, expected);
+
+    // Device to chunked sink
+    QFile input(QStringLiteral(":/unittest/manifest.json.gz"));
+    QVERIFY(input.open(QIODevice::ReadOnly));
+    QByteArray chunked;
+    int chunkCount = 0;
+    QVERIFY(QGCZlib::inflateGzip(&input, [&chunked, &chunkCount](const char *data, qsizetype size) {
+        (void) chunked.append(data, size);
+        chunkCount++;
+        return true;
+    }));
+    QCOMPARE(chunked, expected);
+    QVERIFY(chunkCount > 1);
+
+    // Corrupt input must fail
+    QByteArray corrupt = _readResource(QStringLiteral(":/unittest/manifest.json.gz"));
+    corrupt.truncate(corrupt.size() / 2);
+    QVERIFY(!QGCZlib::inflateGzip(corrupt, decompressed));
+    QVERIFY(decompressed.isEmpty());
+}
+
+void DecompressionTest::_testInflateLZMAStream()
+{
+    const QTemporaryDir tmpDir;
+    const QString decompressedFilename = tmpDir.filePath(QStringLiteral("manifest.json"));
+    QVERIFY(QGCLZMA::inflateLZMAFile(QStringLiteral(":/unittest/manifest.json.xz"), decompressedFilename));
+    const QByteArray expected = _readResource(decompressedFilename);
+    QVERIFY(!expected.isEmpty());
+
+    QByteArray decompressed;
+    QVERIFY(QGCLZMA::inflateLZMA(_readResource(QStringLiteral(":/unittest/manifest.json.xz")), decompressed));
+    QCOMPARE(decompressed, expected);
+
+    QByteArray corrupt = _readResource(QStringLiteral(":/unittest/manifest.json.xz"));
+    corrupt.truncate(corrupt.size() / 2);
+    QVERIFY(!QGCLZMA::inflateLZMA(corrupt, decompressed));
+    QVERIFY(decompressed.isEmpty());
+}
+
+void DecompressionTest::_testSinkAbort()
+{
+    constexpr qsizetype maxBytes = 1000;
+
+    QFile gzipInput(QStringLiteral(":/unittest/manifest.json.gz"));
+    QVERIFY(gzipInput.open(QIODevice::ReadOnly));
+    qsizetype received = 0;
+    QVERIFY(!QGCZlib::inflateGzip(&gzipInput, [&received](const char *, qsizetype size) {
+        received += size;
+        return received < maxBytes;
+    }));
+
+    QFile lzmaInput(QStringLiteral(":/unittest/manifest.json.xz"));
+    QVERIFY(lzmaInput.open(QIODevice::ReadOnly));
+    received = 0;
+    QVERIFY(!QGCLZMA::inflateLZMA(&lzmaInput, [&received](const char *, qsizetype size) {
+        received += size;
+        return received < maxBytes;
+    }));
+}
+
+void DecompressionTest::_benchmarkGzipFile()
+{
+    const QTemporaryDir tmpDir;
+    const QString decompressedFilename = tmpDir.filePath(QStringLiteral("manifest.json"));
+
+    // The legacy path: inflate to a file and read it back before it can be parsed
+    QBENCHMARK {
+        QVERIFY(QGCZlib::inflateGzipFile(QStringLiteral(":/unittest/manifest.json.gz"), decompressedFilename));
+        QVERIFY(!_readResource(decompressedFilename).isEmpty());
+    }
+}
+
+void DecompressionTest::_benchmarkGzipMemory()
+{
+    const QByteArray compressed = _readResource(QStringLiteral(":/unittest/manifest.json.gz"));
+
+    QBENCHMARK {
+        QByteArray decompressed;
+        QVERIFY(QGCZlib::inflateGzip(compressed, decompressed));
+    }
+}
+
+void DecompressionTest::_benchmarkLZMAFile()
+{
+    const QTemporaryDir tmpDir;
+    const QString decompressedFilename = tmpDir.filePath(QStringLiteral("manifest.json"));
+
+    QBENCHMARK {
+        QVERIFY(QGCLZMA::inflateLZMAFile(QStringLiteral(":/unittest/manifest.json.xz"), decompressedFilename));
+        QVERIFY(!_readResource(decompressedFilename).isEmpty());
+    }
+}
+
+void DecompressionTest::_benchmarkLZMAMemory()
+{
+    const QByteArray compressed = _readResource(QStringLiteral(":/unittest/manifest.json.xz"));
+
+    QBENCHMARK {
+        QByteArray decompressed;
+        QVERIFY(QGCLZMA::inflateLZMA(compressed, decompressed));
+    }
+}
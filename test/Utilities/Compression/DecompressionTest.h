@@ -10,4 +10,14 @@ private slots:
     void _testDecompressGzip();
     void _testDecompressLZMA();
     void _testUnzip();
+    void _testInflateGzipStream();
+    void _testInflateLZMAStream();
+    void _testSinkAbort();
+    void _benchmarkGzipFile();
+    void _benchmarkGzipMemory();
+    void _benchmarkLZMAFile();
+    void _benchmarkLZMAMemory();
+
+private:
+    static QByteArray _readResource(const QString &fileName);
 };
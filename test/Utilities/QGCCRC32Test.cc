@@ -0,0 +1,160 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCCRC32Test.h"
+#include "QGC.h"
+#include "QGCCRC32.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+#include <QtTest/QTest>
+
+Q_DECLARE_METATYPE(QGCCRC32::Engine)
+
+namespace {
+    /// Bit at a time reference, independent of any table
+    quint32 referenceCRC(const quint8 *src, size_t len, quint32 crc)
+    {
+        for (size_t i = 0; i < len; i++) {
+            crc ^= src[i];
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? (0xEDB88320 ^ (crc >> 1)) : (crc >> 1);
+            }
+        }
+        return crc;
+    }
+
+    QByteArray randomBytes(QRandomGenerator &generator, qsizetype size)
+    {
+        QByteArray bytes(size, Qt::Uninitialized);
+        for (qsizetype i = 0; i < size; i++) {
+            bytes[i] = static_cast<char>(generator.bounded(256));
+        }
+        return bytes;
+    }
+}
+
+void QGCCRC32Test::_addEngineRows()
+{
+    QTest::addColumn<QGCCRC32::Engine>("engine");
+
+    QTest::newRow("bytewise") << QGCCRC32::Engine::Bytewise;
+    QTest::newRow("slice8") << QGCCRC32::Engine::Slice8;
+    QTest::newRow("slice16") << QGCCRC32::Engine::Slice16;
+    QTest::newRow("hardware") << QGCCRC32::Engine::Hardware;
+}
+
+void QGCCRC32Test::_testKnownValues()
+{
+    // Standard CRC-32 check value, the register is inverted by the caller
+    const QByteArray check("123456789");
+    QCOMPARE(~QGC::crc32(reinterpret_cast<const quint8*>(check.constData()), static_cast<unsigned>(check.size()), 0xFFFFFFFF), 0xCBF43926u);
+
+    // Bootloader usage starts from 0 without inversion
+    QCOMPARE(QGC::crc32(reinterpret_cast<const quint8*>(check.constData()), static_cast<unsigned>(check.size()), 0), referenceCRC(reinterpret_cast<const quint8*>(check.constData()), check.size(), 0));
+
+    // No data leaves the state untouched
+    QCOMPARE(QGC::crc32(nullptr, 0, 0x12345678), 0x12345678u);
+}
+
+void QGCCRC32Test::_testRandomEquivalence_data()
+{
+    _addEngineRows();
+}
+
+void QGCCRC32Test::_testRandomEquivalence()
+{
+    QFETCH(QGCCRC32::Engine, engine);
+
+    if (!QGCCRC32::engineSupported(engine)) {
+        QSKIP("Engine not supported on this CPU");
+    }
+
+    QRandomGenerator generator(0x5eed);
+    const QByteArray bytes = randomBytes(generator, 8192);
+    const quint8 *const data = reinterpret_cast<const quint8*>(bytes.constData());
+
+    // Every length around the block sizes of the engines, from every alignment
+    for (size_t len = 0; len <= 300; len++) {
+        for (size_t offset = 0; offset < 16; offset++) {
+            const quint32 state = generator.generate();
+            QCOMPARE(QGCCRC32::compute(data + offset, len, state, engine), referenceCRC(data + offset, len, state));
+        }
+    }
+
+    // Random lengths, offsets and states
+    for (int i = 0; i < 2000; i++) {
+        const size_t offset = generator.bounded(64);
+        const size_t len = generator.bounded(bytes.size() - 64);
+        const quint32 state = generator.generate();
+        QCOMPARE(QGCCRC32::compute(data + offset, len, state, engine), referenceCRC(data + offset, len, state));
+    }
+}
+
+void QGCCRC32Test::_testChained_data()
+{
+    _addEngineRows();
+}
+
+void QGCCRC32Test::_testChained()
+{
+    QFETCH(QGCCRC32::Engine, engine);
+
+    if (!QGCCRC32::engineSupported(engine)) {
+        QSKIP("Engine not supported on this CPU");
+    }
+
+    QRandomGenerator generator(42);
+    const QByteArray bytes = randomBytes(generator, 64 * 1024);
+    const quint8 *const data = reinterpret_cast<const quint8*>(bytes.constData());
+    const quint32 expected = QGCCRC32::compute(data, bytes.size(), 0, QGCCRC32::Engine::Bytewise);
+
+    // Feeding the data in uneven pieces, the way the bootloader does, gives the same result
+    quint32 crc = 0;
+    size_t pos = 0;
+    while (pos < static_cast<size_t>(bytes.size())) {
+        const size_t len = qMin<size_t>(generator.bounded(1, 700), bytes.size() - pos);
+        crc = QGCCRC32::compute(data + pos, len, crc, engine);
+        pos += len;
+    }
+
+    QCOMPARE(crc, expected);
+}
+
+void QGCCRC32Test::_benchmarkThroughput_data()
+{
+    _addEngineRows();
+}
+
+void QGCCRC32Test::_benchmarkThroughput()
+{
+    QFETCH(QGCCRC32::Engine, engine);
+
+    if (!QGCCRC32::engineSupported(engine)) {
+        QSKIP("Engine not supported on this CPU");
+    }
+
+    // About the size of a flight controller firmware image
+    QRandomGenerator generator(7);
+    const QByteArray bytes = randomBytes(generator, 2 * 1024 * 1024);
+    const quint8 *const data = reinterpret_cast<const quint8*>(bytes.constData());
+
+    quint32 crc = 0;
+    qint64 processed = 0;
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        crc = QGCCRC32::compute(data, bytes.size(), crc, engine);
+        processed += bytes.size();
+    } while (timer.elapsed() < 250);
+    const qint64 nsecs = timer.nsecsElapsed();
+
+    const double bytesPerSecond = (static_cast<double>(processed) * 1e9) / static_cast<double>(nsecs);
+    QTest::setBenchmarkResult(bytesPerSecond, QTest::BytesPerSecond);
+}
@@ -0,0 +1,29 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class QGCCRC32Test : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testKnownValues();
+    void _testRandomEquivalence_data();
+    void _testRandomEquivalence();
+    void _testChained_data();
+    void _testChained();
+    void _benchmarkThroughput_data();
+    void _benchmarkThroughput();
+
+private:
+    static void _addEngineRows();
+};
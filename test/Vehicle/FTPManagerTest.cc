@@ -13,8 +13,11 @@
 #include "MockLink.h"
 #include "FTPManager.h"
 #include "MockLinkFTP.h"
+#include "QGC.h"
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QStandardPaths>
+#include <QtCore/QTemporaryDir>
 #include <QtTest/QTest>
 #include <QtTest/QSignalSpy>
 
@@ -302,3 +305,301 @@ void FTPManagerTest::_testListDirectoryBadSequence(void)
 
     _disconnectMockLink();
 }
+
+/// Writes a file with the same byte pattern as the MockLinkFTP size files
+QByteArray FTPManagerTest::_writeUploadFile(const QString& filename, int fileSize)
+{
+    QByteArray bytes;
+    for (int i=0; i<fileSize; i++) {
+        bytes.append(static_cast<char>(i % 255));
+    }
+
+    QFile file(filename);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate) || (file.write(bytes) != bytes.size())) {
+        return QByteArray();
+    }
+
+    return bytes;
+}
+
+void FTPManagerTest::_testUpload(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager*     ftpManager  = _vehicle->ftpManager();
+    QTemporaryDir   tempDir;
+    const QString   localFile   = tempDir.filePath("upload.bin");
+    const QByteArray bytes      = _writeUploadFile(localFile, 3 * 1024 + 17);
+    QVERIFY(!bytes.isEmpty());
+
+    QSignalSpy spyUploadComplete(ftpManager, &FTPManager::uploadComplete);
+    QSignalSpy spyUploadProgress(ftpManager, &FTPManager::uploadProgress);
+
+    QVERIFY(ftpManager->upload(MAV_COMP_ID_AUTOPILOT1, localFile, "/upload.bin"));
+    // Only one upload at a time
+    QVERIFY(!ftpManager->upload(MAV_COMP_ID_AUTOPILOT1, localFile, "/upload2.bin"));
+
+    QCOMPARE(spyUploadComplete.wait(10000), true);
+    QCOMPARE(spyUploadComplete.count(), 1);
+
+    // void uploadComplete(const QString& uri, const QString& errorMsg);
+    QList<QVariant> arguments = spyUploadComplete.takeFirst();
+    QCOMPARE(arguments[0].toString(), QStringLiteral("/upload.bin"));
+    QVERIFY2(arguments[1].toString().isEmpty(), qPrintable(arguments[1].toString()));
+    QVERIFY(spyUploadProgress.count() > 0);
+    QCOMPARE(spyUploadProgress.last()[0].toFloat(), 1.0f);
+
+    QCOMPARE(_mockLink->mockLinkFTP()->file("/upload.bin"), bytes);
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_testUploadReplacesExistingFile(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager*     ftpManager  = _vehicle->ftpManager();
+    QTemporaryDir   tempDir;
+    const QString   localFile   = tempDir.filePath("upload.bin");
+    const QByteArray bytes      = _writeUploadFile(localFile, 1000);
+    QVERIFY(!bytes.isEmpty());
+
+    // MockLinkFTP refuses to create a file which exists already
+    _mockLink->mockLinkFTP()->setFile("/upload.bin", QByteArray(5000, 'x'));
+
+    QSignalSpy spyUploadComplete(ftpManager, &FTPManager::uploadComplete);
+
+    QVERIFY(ftpManager->upload(MAV_COMP_ID_AUTOPILOT1, localFile, "/upload.bin"));
+
+    QCOMPARE(spyUploadComplete.wait(10000), true);
+    QCOMPARE(spyUploadComplete.count(), 1);
+    QList<QVariant> arguments = spyUploadComplete.takeFirst();
+    QVERIFY2(arguments[1].toString().isEmpty(), qPrintable(arguments[1].toString()));
+
+    QCOMPARE(_mockLink->mockLinkFTP()->file("/upload.bin"), bytes);
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_testUploadLostPackets(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager*     ftpManager  = _vehicle->ftpManager();
+    QTemporaryDir   tempDir;
+    const QString   localFile   = tempDir.filePath("upload.bin");
+    const QByteArray bytes      = _writeUploadFile(localFile, 8 * 1024);
+    QVERIFY(!bytes.isEmpty());
+
+    QSignalSpy spyUploadComplete(ftpManager, &FTPManager::uploadComplete);
+
+    // The contents are compared directly, which catches out of order and repeated writes the CRC check would also catch
+    _mockLink->mockLinkFTP()->setPacketLoss(0.2);
+    QVERIFY(ftpManager->upload(MAV_COMP_ID_AUTOPILOT1, localFile, "/upload.bin", false /* verifyCrc */));
+
+    QCOMPARE(spyUploadComplete.wait(30000), true);
+    QCOMPARE(spyUploadComplete.count(), 1);
+    QList<QVariant> arguments = spyUploadComplete.takeFirst();
+    QVERIFY2(arguments[1].toString().isEmpty(), qPrintable(arguments[1].toString()));
+
+    QCOMPARE(_mockLink->mockLinkFTP()->file("/upload.bin"), bytes);
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_testUploadDownloadRoundTrip(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager*     ftpManager  = _vehicle->ftpManager();
+    QTemporaryDir   tempDir;
+    const QString   localFile   = tempDir.filePath("upload.bin");
+    const int       fileSize    = 5 * 1024 + 3;
+    QVERIFY(!_writeUploadFile(localFile, fileSize).isEmpty());
+
+    QSignalSpy spyUploadComplete(ftpManager, &FTPManager::uploadComplete);
+    QSignalSpy spyDownloadComplete(ftpManager, &FTPManager::downloadComplete);
+
+    QVERIFY(ftpManager->upload(MAV_COMP_ID_AUTOPILOT1, localFile, "/roundtrip.bin"));
+    QCOMPARE(spyUploadComplete.wait(10000), true);
+    QVERIFY(spyUploadComplete.takeFirst()[1].toString().isEmpty());
+
+    QVERIFY(ftpManager->download(MAV_COMP_ID_AUTOPILOT1, "/roundtrip.bin", QStandardPaths::writableLocation(QStandardPaths::TempLocation)));
+    QCOMPARE(spyDownloadComplete.wait(10000), true);
+    QList<QVariant> arguments = spyDownloadComplete.takeFirst();
+    QVERIFY(arguments[1].toString().isEmpty());
+
+    _verifyFileSizeAndDelete(arguments[0].toString(), fileSize);
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_testWindowedTransfer(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager*     ftpManager  = _vehicle->ftpManager();
+    MockLinkFTP*    mockLinkFTP = _mockLink->mockLinkFTP();
+    QTemporaryDir   tempDir;
+    const QString   localFile   = tempDir.filePath("upload.bin");
+    const QByteArray bytes      = _writeUploadFile(localFile, 16 * 1024);
+    QVERIFY(!bytes.isEmpty());
+
+    QSignalSpy spyUploadComplete(ftpManager, &FTPManager::uploadComplete);
+
+    mockLinkFTP->setLatency(5);
+
+    qint64 rgElapsedMSecs[2];
+    const int rgWindowSizes[2] = { 1, FTPManager::defaultWindowSize };
+    for (int i=0; i<2; i++) {
+        ftpManager->setWindowSize(rgWindowSizes[i]);
+
+        const QString uri = QStringLiteral("/window%1.bin").arg(rgWindowSizes[i]);
+        QElapsedTimer elapsed;
+        elapsed.start();
+        QVERIFY(ftpManager->upload(MAV_COMP_ID_AUTOPILOT1, localFile, uri));
+        QCOMPARE(spyUploadComplete.wait(30000), true);
+        rgElapsedMSecs[i] = elapsed.elapsed();
+
+        QList<QVariant> arguments = spyUploadComplete.takeFirst();
+        QVERIFY2(arguments[1].toString().isEmpty(), qPrintable(arguments[1].toString()));
+        QCOMPARE(mockLinkFTP->file(uri), bytes);
+    }
+
+    // The link latency dominates both uploads, so the window must have been used and must have paid off
+    QVERIFY(mockLinkFTP->maxRequestsInFlight() > 1);
+    QVERIFY2(rgElapsedMSecs[1] < rgElapsedMSecs[0], qPrintable(QStringLiteral("stop and wait %1 msecs, window of %2 %3 msecs").arg(rgElapsedMSecs[0]).arg(rgWindowSizes[1]).arg(rgElapsedMSecs[1])));
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_concurrentTransfersWorker(int maxSessions)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager*     ftpManager  = _vehicle->ftpManager();
+    QTemporaryDir   tempDir;
+    const QString   localFile   = tempDir.filePath("upload.bin");
+    const QByteArray bytes      = _writeUploadFile(localFile, 4 * 1024);
+    const int       downloadSize = 3 * 1024;
+    QVERIFY(!bytes.isEmpty());
+
+    _mockLink->mockLinkFTP()->setMaxSessions(maxSessions);
+
+    QSignalSpy spyUploadComplete(ftpManager, &FTPManager::uploadComplete);
+    QSignalSpy spyDownloadComplete(ftpManager, &FTPManager::downloadComplete);
+    QSignalSpy spyListDirectoryComplete(ftpManager, &FTPManager::listDirectoryComplete);
+
+    QVERIFY(ftpManager->download(MAV_COMP_ID_AUTOPILOT1, QStringLiteral("%1%2").arg(MockLinkFTP::sizeFilenamePrefix).arg(downloadSize), QStandardPaths::writableLocation(QStandardPaths::TempLocation)));
+    QVERIFY(ftpManager->upload(MAV_COMP_ID_AUTOPILOT1, localFile, "/concurrent.bin"));
+    QVERIFY(ftpManager->listDirectory(MAV_COMP_ID_AUTOPILOT1, "/"));
+
+    QVERIFY(spyDownloadComplete.count() == 1 || spyDownloadComplete.wait(10000));
+    QVERIFY(spyUploadComplete.count() == 1 || spyUploadComplete.wait(10000));
+    QVERIFY(spyListDirectoryComplete.count() == 1 || spyListDirectoryComplete.wait(10000));
+
+    QList<QVariant> arguments = spyUploadComplete.takeFirst();
+    QVERIFY2(arguments[1].toString().isEmpty(), qPrintable(arguments[1].toString()));
+    QCOMPARE(_mockLink->mockLinkFTP()->file("/concurrent.bin"), bytes);
+
+    arguments = spyListDirectoryComplete.takeFirst();
+    QVERIFY(arguments[1].toString().isEmpty());
+    QCOMPARE(arguments[0].toStringList().count(), 6);
+
+    arguments = spyDownloadComplete.takeFirst();
+    QVERIFY2(arguments[1].toString().isEmpty(), qPrintable(arguments[1].toString()));
+    _verifyFileSizeAndDelete(arguments[0].toString(), downloadSize);
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_testConcurrentTransfers(void)
+{
+    _concurrentTransfersWorker(2);
+}
+
+void FTPManagerTest::_testConcurrentTransfersSingleSession(void)
+{
+    // The second transfer has to wait for the first one to release the only session
+    _concurrentTransfersWorker(1);
+}
+
+void FTPManagerTest::_testRemoveFile(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager* ftpManager = _vehicle->ftpManager();
+
+    _mockLink->mockLinkFTP()->setFile("/remove.bin", QByteArray(100, 'x'));
+
+    QSignalSpy spyRemoveFileComplete(ftpManager, &FTPManager::removeFileComplete);
+
+    QVERIFY(ftpManager->removeFile(MAV_COMP_ID_AUTOPILOT1, "/remove.bin"));
+    QCOMPARE(spyRemoveFileComplete.wait(10000), true);
+    QList<QVariant> arguments = spyRemoveFileComplete.takeFirst();
+    QCOMPARE(arguments[0].toString(), QStringLiteral("/remove.bin"));
+    QVERIFY(arguments[1].toString().isEmpty());
+    QVERIFY(!_mockLink->mockLinkFTP()->fileExists("/remove.bin"));
+
+    // File is gone now
+    QVERIFY(ftpManager->removeFile(MAV_COMP_ID_AUTOPILOT1, "/remove.bin"));
+    QCOMPARE(spyRemoveFileComplete.wait(10000), true);
+    arguments = spyRemoveFileComplete.takeFirst();
+    QVERIFY(!arguments[1].toString().isEmpty());
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_testCreateDirectory(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager* ftpManager = _vehicle->ftpManager();
+
+    QSignalSpy spyCreateDirectoryComplete(ftpManager, &FTPManager::createDirectoryComplete);
+
+    QVERIFY(ftpManager->createDirectory(MAV_COMP_ID_AUTOPILOT1, "/newdir"));
+    QCOMPARE(spyCreateDirectoryComplete.wait(10000), true);
+    QList<QVariant> arguments = spyCreateDirectoryComplete.takeFirst();
+    QCOMPARE(arguments[0].toString(), QStringLiteral("/newdir"));
+    QVERIFY(arguments[1].toString().isEmpty());
+    QVERIFY(_mockLink->mockLinkFTP()->directoryExists("/newdir"));
+
+    // Directory exists now
+    QVERIFY(ftpManager->createDirectory(MAV_COMP_ID_AUTOPILOT1, "/newdir"));
+    QCOMPARE(spyCreateDirectoryComplete.wait(10000), true);
+    arguments = spyCreateDirectoryComplete.takeFirst();
+    QVERIFY(!arguments[1].toString().isEmpty());
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_testCalcFileCrc32(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager* ftpManager = _vehicle->ftpManager();
+
+    QByteArray bytes;
+    for (int i=0; i<1000; i++) {
+        bytes.append(static_cast<char>(i * 7));
+    }
+    _mockLink->mockLinkFTP()->setFile("/crc.bin", bytes);
+    const quint32 expectedCrc32 = QGC::crc32(reinterpret_cast<const quint8*>(bytes.constData()), static_cast<unsigned>(bytes.size()), 0);
+
+    QSignalSpy spyCalcFileCrc32Complete(ftpManager, &FTPManager::calcFileCrc32Complete);
+
+    // void calcFileCrc32Complete(const QString& uri, quint32 crc32, const QString& errorMsg);
+    QVERIFY(ftpManager->calcFileCrc32(MAV_COMP_ID_AUTOPILOT1, "/crc.bin"));
+    QCOMPARE(spyCalcFileCrc32Complete.wait(10000), true);
+    QList<QVariant> arguments = spyCalcFileCrc32Complete.takeFirst();
+    QVERIFY(arguments[2].toString().isEmpty());
+    QCOMPARE(arguments[1].value<quint32>(), expectedCrc32);
+
+    QVERIFY(ftpManager->calcFileCrc32(MAV_COMP_ID_AUTOPILOT1, "/missing.bin"));
+    QCOMPARE(spyCalcFileCrc32Complete.wait(10000), true);
+    arguments = spyCalcFileCrc32Complete.takeFirst();
+    QVERIFY(!arguments[2].toString().isEmpty());
+
+    _disconnectMockLink();
+}
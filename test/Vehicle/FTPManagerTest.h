@@ -24,6 +24,16 @@ private slots:
     void _testListDirectoryNoSecondResponseAllowRetry   (void);
     void _testListDirectoryNakSecondResponse            (void);
     void _testListDirectoryBadSequence                  (void);
+    void _testUpload                                    (void);
+    void _testUploadReplacesExistingFile                (void);
+    void _testUploadLostPackets                         (void);
+    void _testUploadDownloadRoundTrip                   (void);
+    void _testWindowedTransfer                          (void);
+    void _testConcurrentTransfers                       (void);
+    void _testConcurrentTransfersSingleSession          (void);
+    void _testRemoveFile                                (void);
+    void _testCreateDirectory                           (void);
+    void _testCalcFileCrc32                             (void);
 
     // Overrides from UnitTest
     void cleanup(void) override;
@@ -39,6 +49,8 @@ private slots:
     void _testCaseWorker            (const TestCase_t& testCase);
     void _sizeTestCaseWorker        (int fileSize);
     void _verifyFileSizeAndDelete   (const QString& filename, int expectedSize);
+    QByteArray _writeUploadFile     (const QString& filename, int fileSize);
+    void _concurrentTransfersWorker (int maxSessions);
 
     static const TestCase_t _rgTestCases[];
 };
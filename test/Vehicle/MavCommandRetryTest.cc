@@ -0,0 +1,153 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MavCommandRetryTest.h"
+#include "LinkInterface.h"
+#include "MockLink.h"
+#include "RttEstimator.h"
+#include "VehicleLinkManager.h"
+
+#include <QtTest/QTest>
+
+void MavCommandRetryTest::_resultHandler(void *resultHandlerData, int /*compId*/, const mavlink_command_ack_t &ack, Vehicle::MavCmdResultFailureCode_t failureCode)
+{
+    CommandResult *const commandResult = static_cast<CommandResult*>(resultHandlerData);
+    commandResult->result = true;
+    commandResult->resultMSecs = commandResult->timer.elapsed();
+    commandResult->ackResult = static_cast<MAV_RESULT>(ack.result);
+    commandResult->failureCode = failureCode;
+}
+
+void MavCommandRetryTest::_progressHandler(void *progressHandlerData, int /*compId*/, const mavlink_command_ack_t & /*ack*/)
+{
+    CommandResult *const commandResult = static_cast<CommandResult*>(progressHandlerData);
+    commandResult->progress = true;
+    commandResult->progressMSecs = commandResult->timer.elapsed();
+}
+
+void MavCommandRetryTest::_sendCommand(MAV_CMD command, CommandResult &commandResult)
+{
+    Vehicle::MavCmdAckHandlerInfo_t handlerInfo = {};
+    handlerInfo.resultHandler       = _resultHandler;
+    handlerInfo.resultHandlerData   = &commandResult;
+    handlerInfo.progressHandler     = _progressHandler;
+    handlerInfo.progressHandlerData = &commandResult;
+
+    _mockLink->clearReceivedMavCommandCounts();
+    commandResult.timer.start();
+    _vehicle->sendMavCommandWithHandler(&handlerInfo, MAV_COMP_ID_AUTOPILOT1, command);
+}
+
+RttEstimator &MavCommandRetryTest::_estimator()
+{
+    return _vehicle->vehicleLinkManager()->primaryLink().lock()->commandRttEstimator();
+}
+
+void MavCommandRetryTest::_seedRttEstimate()
+{
+    for (int i = 0; i < kSeedCommandCount; i++) {
+        CommandResult commandResult;
+        _sendCommand(MockLink::MAV_CMD_MOCKLINK_ALWAYS_RESULT_ACCEPTED, commandResult);
+        QVERIFY(QTest::qWaitFor([&commandResult]() { return commandResult.result; }, Vehicle::_mavCommandAckTimeoutMSecs));
+        QCOMPARE(commandResult.ackResult, MAV_RESULT_ACCEPTED);
+    }
+    QCOMPARE(_estimator().sampleCount(), kSeedCommandCount);
+}
+
+void MavCommandRetryTest::_testFixedTimeoutWithoutRtt()
+{
+    _connectMockLinkNoInitialConnectSequence();
+    QVERIFY(!_estimator().hasSamples());
+
+    // Nothing is known about the link yet, so every try gets the fixed timeout
+    CommandResult commandResult;
+    _sendCommand(MockLink::MAV_CMD_MOCKLINK_NO_RESPONSE, commandResult);
+    const int index = _vehicle->_findMavCommandListEntryIndex(MAV_COMP_ID_AUTOPILOT1, MockLink::MAV_CMD_MOCKLINK_NO_RESPONSE);
+    QVERIFY(index != -1);
+    QCOMPARE(_vehicle->_mavCommandList[index].ackTimeoutMSecs, Vehicle::_mavCommandAckTimeoutMSecs);
+
+    // A response to a retransmission is not used as a sample
+    CommandResult retriedResult;
+    _sendCommand(MockLink::MAV_CMD_MOCKLINK_SECOND_ATTEMPT_RESULT_ACCEPTED, retriedResult);
+    QVERIFY(QTest::qWaitFor([&retriedResult]() { return retriedResult.result; }, Vehicle::_mavCommandAckTimeoutMSecs + kLateMSecs));
+    QCOMPARE(retriedResult.ackResult, MAV_RESULT_ACCEPTED);
+    QVERIFY(retriedResult.resultMSecs >= (Vehicle::_mavCommandAckTimeoutMSecs * kEarlyFactor));
+    QVERIFY(!_estimator().hasSamples());
+
+    _disconnectMockLink();
+}
+
+void MavCommandRetryTest::_testRttRetransmitTiming()
+{
+    _connectMockLinkNoInitialConnectSequence();
+    _seedRttEstimate();
+
+    const RttEstimator &estimator = _estimator();
+    int expectedSendMSecs[Vehicle::_mavCommandMaxRetryCount + 1] = {};
+    for (int tryCount = 1; tryCount <= Vehicle::_mavCommandMaxRetryCount; tryCount++) {
+        const int timeout = estimator.backoffTimeoutMSecs(tryCount, Vehicle::_mavCommandAckTimeoutMSecs, Vehicle::_mavCommandAckTimeoutMinMSecs, Vehicle::_mavCommandAckTimeoutMaxMSecs);
+        QVERIFY(timeout < Vehicle::_mavCommandAckTimeoutMSecs);
+        expectedSendMSecs[tryCount] = expectedSendMSecs[tryCount - 1] + timeout;
+    }
+    const int expectedFailureMSecs = expectedSendMSecs[Vehicle::_mavCommandMaxRetryCount];
+
+    // Each retransmission waits for the backed off rtt based timeout
+    CommandResult commandResult;
+    _sendCommand(MockLink::MAV_CMD_MOCKLINK_NO_RESPONSE, commandResult);
+    for (int tryCount = 2; tryCount <= Vehicle::_mavCommandMaxRetryCount; tryCount++) {
+        QVERIFY(QTest::qWaitFor([this, tryCount]() { return _mockLink->receivedMavCommandCount(MockLink::MAV_CMD_MOCKLINK_NO_RESPONSE) >= tryCount; }, Vehicle::_mavCommandAckTimeoutMSecs + kLateMSecs));
+        const qint64 sentMSecs = commandResult.timer.elapsed();
+        QVERIFY2((sentMSecs >= (expectedSendMSecs[tryCount - 1] * kEarlyFactor)) && (sentMSecs <= (expectedSendMSecs[tryCount - 1] + kLateMSecs)),
+                 qPrintable(QStringLiteral("try %1 sent after %2 ms, expected %3 ms").arg(tryCount).arg(sentMSecs).arg(expectedSendMSecs[tryCount - 1])));
+    }
+
+    // Giving up takes the sum of the timeouts, which never exceeds the fixed timeout budget of all tries
+    QVERIFY(QTest::qWaitFor([&commandResult]() { return commandResult.result; }, Vehicle::_mavCommandAckTimeoutMSecs + kLateMSecs));
+    QCOMPARE(commandResult.failureCode, Vehicle::MavCmdResultFailureNoResponseToCommand);
+    QCOMPARE(_mockLink->receivedMavCommandCount(MockLink::MAV_CMD_MOCKLINK_NO_RESPONSE), Vehicle::_mavCommandMaxRetryCount);
+    QVERIFY2((commandResult.resultMSecs >= (expectedFailureMSecs * kEarlyFactor)) && (commandResult.resultMSecs <= (expectedFailureMSecs + kLateMSecs)),
+             qPrintable(QStringLiteral("failed after %1 ms, expected %2 ms").arg(commandResult.resultMSecs).arg(expectedFailureMSecs)));
+    QVERIFY(commandResult.resultMSecs < (Vehicle::_mavCommandMaxRetryCount * Vehicle::_mavCommandAckTimeoutMSecs));
+
+    // Failed commands do not change the estimate
+    QCOMPARE(estimator.sampleCount(), kSeedCommandCount);
+
+    _disconnectMockLink();
+}
+
+void MavCommandRetryTest::_testSlowCommandsKeepFixedTimeout()
+{
+    _connectMockLinkNoInitialConnectSequence();
+    _seedRttEstimate();
+
+    // Commands which ack after executing are not timed from the rtt
+    CommandResult noRetryResult;
+    _sendCommand(MockLink::MAV_CMD_MOCKLINK_NO_RESPONSE_NO_RETRY, noRetryResult);
+    QVERIFY(QTest::qWaitFor([&noRetryResult]() { return noRetryResult.result; }, Vehicle::_mavCommandAckTimeoutMSecs + kLateMSecs));
+    QCOMPARE(noRetryResult.failureCode, Vehicle::MavCmdResultFailureNoResponseToCommand);
+    QCOMPARE(_mockLink->receivedMavCommandCount(MockLink::MAV_CMD_MOCKLINK_NO_RESPONSE_NO_RETRY), 1);
+    QVERIFY(noRetryResult.resultMSecs >= (Vehicle::_mavCommandAckTimeoutMSecs * kEarlyFactor));
+
+    // Once a command reports progress its completion depends on the vehicle, so it falls back to the fixed timeout
+    CommandResult inProgressResult;
+    _sendCommand(MockLink::MAV_CMD_MOCKLINK_RESULT_IN_PROGRESS_NO_ACK, inProgressResult);
+    const int index = _vehicle->_findMavCommandListEntryIndex(MAV_COMP_ID_AUTOPILOT1, MockLink::MAV_CMD_MOCKLINK_RESULT_IN_PROGRESS_NO_ACK);
+    QVERIFY(index != -1);
+    QVERIFY(_vehicle->_mavCommandList[index].ackTimeoutMSecs < Vehicle::_mavCommandAckTimeoutMSecs);
+    QVERIFY(QTest::qWaitFor([&inProgressResult]() { return inProgressResult.result; }, Vehicle::_mavCommandAckTimeoutMSecs * 2));
+    QVERIFY(inProgressResult.progress);
+    QCOMPARE(inProgressResult.failureCode, Vehicle::MavCmdResultFailureNoResponseToCommand);
+    QCOMPARE(_mockLink->receivedMavCommandCount(MockLink::MAV_CMD_MOCKLINK_RESULT_IN_PROGRESS_NO_ACK), 1);
+    QVERIFY((inProgressResult.resultMSecs - inProgressResult.progressMSecs) >= (Vehicle::_mavCommandAckTimeoutMSecs * kEarlyFactor));
+
+    // Neither was sampled
+    QCOMPARE(_estimator().sampleCount(), kSeedCommandCount + 1);
+
+    _disconnectMockLink();
+}
@@ -0,0 +1,50 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+#include "Vehicle.h"
+
+#include <QtCore/QElapsedTimer>
+
+class RttEstimator;
+
+/// Checks when Vehicle retransmits MAV_CMDs and gives up on them, depending on the rtt estimate of the link
+class MavCommandRetryTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testFixedTimeoutWithoutRtt();
+    void _testRttRetransmitTiming();
+    void _testSlowCommandsKeepFixedTimeout();
+
+private:
+    struct CommandResult {
+        bool            progress        = false;
+        bool            result          = false;
+        qint64          progressMSecs   = 0;
+        qint64          resultMSecs     = 0;
+        MAV_RESULT      ackResult       = MAV_RESULT_ACCEPTED;
+        Vehicle::MavCmdResultFailureCode_t failureCode = Vehicle::MavCmdResultCommandResultOnly;
+        QElapsedTimer   timer;
+    };
+
+    void _sendCommand(MAV_CMD command, CommandResult &commandResult);
+    void _seedRttEstimate();
+    RttEstimator &_estimator();
+
+    static void _resultHandler(void *resultHandlerData, int compId, const mavlink_command_ack_t &ack, Vehicle::MavCmdResultFailureCode_t failureCode);
+    static void _progressHandler(void *progressHandlerData, int compId, const mavlink_command_ack_t &ack);
+
+    static constexpr int kSeedCommandCount = 5;
+    static constexpr int kLateMSecs = 250;          ///< Allowed timer and polling delay
+    static constexpr double kEarlyFactor = 0.9;     ///< Coarse timers may fire up to 5% early
+};
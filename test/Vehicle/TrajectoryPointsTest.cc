@@ -0,0 +1,176 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TrajectoryPointsTest.h"
+#include "TrajectoryPoints.h"
+
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QtMath>
+#include <QtTest/QTest>
+#include <QtTest/QSignalSpy>
+
+#include <cmath>
+#include <limits>
+
+QList<QGeoCoordinate> TrajectoryPointsTest::_syntheticFlight()
+{
+    constexpr double rateHz = 5.;
+    constexpr double speed = 12.;
+    constexpr int samples = static_cast<int>(4 * 3600 * rateHz);
+    constexpr int phaseSamples = static_cast<int>(600 * rateHz);
+    constexpr int legSamples = static_cast<int>(50 * rateHz);
+    constexpr double orbitRadius = 80.;
+
+    QRandomGenerator random(1234);
+    QList<QGeoCoordinate> positions;
+    positions.reserve(samples);
+
+    QGeoCoordinate position(47.3977, 8.5456);
+    double heading = 0;
+    for (int i = 0; i < samples; i++) {
+        switch ((i / phaseSamples) % 3) {
+        case 0:
+            // Survey legs back and forth with a short crossing leg in between
+            heading = ((i % legSamples) < rateHz) ? 0. : (((i / legSamples) % 2) ? 90. : 270.);
+            break;
+        case 1:
+            heading += (360. * speed) / (rateHz * 2. * M_PI * orbitRadius);
+            break;
+        default:
+            heading += std::sin(i * 0.01) * 2.;
+            break;
+        }
+
+        position = position.atDistanceAndAzimuth(speed / rateHz, std::fmod(heading + 360., 360.));
+        const double noise = random.bounded(0.5);
+        positions.append(position.atDistanceAndAzimuth(noise, random.bounded(360.)));
+    }
+
+    return positions;
+}
+
+int TrajectoryPointsTest::_replay(TrajectoryPoints &trajectoryPoints, const QList<QGeoCoordinate> &positions)
+{
+    // Rebuild the path the way FlyViewMap does
+    QVariantList path;
+    (void) connect(&trajectoryPoints, &TrajectoryPoints::pointAdded, &trajectoryPoints, [&path](QGeoCoordinate coordinate) {
+        path.append(QVariant::fromValue(coordinate));
+    });
+    (void) connect(&trajectoryPoints, &TrajectoryPoints::updateLastPoint, &trajectoryPoints, [&path](QGeoCoordinate coordinate) {
+        path.last() = QVariant::fromValue(coordinate);
+    });
+    (void) connect(&trajectoryPoints, &TrajectoryPoints::pathReplaced, &trajectoryPoints, [&path, &trajectoryPoints]() {
+        path = trajectoryPoints.list();
+    });
+
+    int maxCount = 0;
+    for (const QGeoCoordinate &position : positions) {
+        trajectoryPoints._vehicleCoordinateChanged(position);
+        maxCount = qMax(maxCount, trajectoryPoints.count());
+    }
+
+    (void) trajectoryPoints.disconnect(&trajectoryPoints);
+
+    if (path != trajectoryPoints.list()) {
+        return -1;
+    }
+
+    return maxCount;
+}
+
+double TrajectoryPointsTest::_maxDeviation(const TrajectoryPoints &trajectoryPoints, const QList<QGeoCoordinate> &positions)
+{
+    const QList<TrajectoryPoints::Point> &points = trajectoryPoints._points;
+
+    double maxDeviation = 0;
+    // Every 10th position keeps the brute force search affordable
+    for (qsizetype i = 0; i < positions.count(); i += 10) {
+        const TrajectoryPoints::Point position{ positions.at(i).latitude(), positions.at(i).longitude() };
+
+        double deviation = std::numeric_limits<double>::max();
+        for (qsizetype j = 1; j < points.count(); j++) {
+            deviation = qMin(deviation, TrajectoryPoints::_segmentDistance(position, points.at(j - 1), points.at(j)));
+        }
+        maxDeviation = qMax(maxDeviation, deviation);
+    }
+
+    return maxDeviation;
+}
+
+void TrajectoryPointsTest::_straightLineTest()
+{
+    TrajectoryPoints trajectoryPoints(nullptr);
+    QSignalSpy addedSpy(&trajectoryPoints, &TrajectoryPoints::pointAdded);
+    QSignalSpy updatedSpy(&trajectoryPoints, &TrajectoryPoints::updateLastPoint);
+
+    const QGeoCoordinate start(47.3977, 8.5456);
+    for (int i = 0; i <= 500; i++) {
+        trajectoryPoints._vehicleCoordinateChanged(start.atDistanceAndAzimuth(i * 5., 45.));
+    }
+
+    // A straight flight is a single segment which keeps getting longer
+    QCOMPARE(trajectoryPoints.count(), 2);
+    QCOMPARE(addedSpy.count(), 2);
+    QCOMPARE(updatedSpy.count(), 499);
+
+    // Turning back starts a new segment
+    const QGeoCoordinate end = start.atDistanceAndAzimuth(2500., 45.);
+    for (int i = 1; i <= 100; i++) {
+        trajectoryPoints._vehicleCoordinateChanged(end.atDistanceAndAzimuth(i * 5., 225.));
+    }
+    QCOMPARE(trajectoryPoints.count(), 3);
+
+    // Jitter below the distance tolerance is ignored
+    const QGeoCoordinate last = end.atDistanceAndAzimuth(500., 225.);
+    trajectoryPoints._vehicleCoordinateChanged(last.atDistanceAndAzimuth(1., 90.));
+    QCOMPARE(updatedSpy.count(), 499 + 99);
+
+    trajectoryPoints.clear();
+    QCOMPARE(trajectoryPoints.count(), 0);
+    QVERIFY(trajectoryPoints.list().isEmpty());
+}
+
+void TrajectoryPointsTest::_longFlightTest()
+{
+    const QList<QGeoCoordinate> positions = _syntheticFlight();
+
+    TrajectoryPoints trajectoryPoints(nullptr);
+    trajectoryPoints.setMaxPoints(positions.count());
+    QSignalSpy replacedSpy(&trajectoryPoints, &TrajectoryPoints::pathReplaced);
+
+    const int maxCount = _replay(trajectoryPoints, positions);
+    QVERIFY(maxCount > 0);
+    QCOMPARE(replacedSpy.count(), 0);
+
+    // Without the cap only the online simplification applies
+    QVERIFY(trajectoryPoints.count() < (positions.count() / 10));
+    const double deviation = _maxDeviation(trajectoryPoints, positions);
+    QVERIFY2(deviation <= trajectoryPoints.errorBound(), qPrintable(QStringLiteral("%1 > %2").arg(deviation).arg(trajectoryPoints.errorBound())));
+    QCOMPARE(trajectoryPoints.errorBound(), 4.);
+}
+
+void TrajectoryPointsTest::_memoryCapTest()
+{
+    const QList<QGeoCoordinate> positions = _syntheticFlight();
+    constexpr int maxPoints = 2000;
+
+    TrajectoryPoints trajectoryPoints(nullptr);
+    trajectoryPoints.setMaxPoints(maxPoints);
+    QSignalSpy replacedSpy(&trajectoryPoints, &TrajectoryPoints::pathReplaced);
+
+    const int maxCount = _replay(trajectoryPoints, positions);
+    QVERIFY(maxCount > 0);
+    QVERIFY(maxCount <= maxPoints);
+    QVERIFY(replacedSpy.count() > 0);
+
+    // Compaction trades accuracy for memory, the error has to stay within the reported bound
+    const double deviation = _maxDeviation(trajectoryPoints, positions);
+    QVERIFY2(deviation <= trajectoryPoints.errorBound(), qPrintable(QStringLiteral("%1 > %2").arg(deviation).arg(trajectoryPoints.errorBound())));
+    QVERIFY(trajectoryPoints.errorBound() <= 50.);
+}
@@ -0,0 +1,34 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+#include <QtPositioning/QGeoCoordinate>
+
+class TrajectoryPoints;
+
+class TrajectoryPointsTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _straightLineTest();
+    void _longFlightTest();
+    void _memoryCapTest();
+
+private:
+    /// Four hours at 5 Hz: survey legs, orbits and meandering, with GPS noise
+    static QList<QGeoCoordinate> _syntheticFlight();
+    /// Feeds @p positions and returns the highest vertex count seen, the path built from the signals has to match list()
+    static int _replay(TrajectoryPoints &trajectoryPoints, const QList<QGeoCoordinate> &positions);
+    /// Largest distance from a position to the trail, in meters
+    static double _maxDeviation(const TrajectoryPoints &trajectoryPoints, const QList<QGeoCoordinate> &positions);
+};
@@ -0,0 +1,153 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "BootloaderTest.h"
+#include "Bootloader.h"
+#include "FirmwareImage.h"
+#include "MockBootloader.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QRandomGenerator>
+#include <QtTest/QTest>
+
+void BootloaderTest::init()
+{
+    UnitTest::init();
+
+    _tempDir = new QTemporaryDir();
+    QVERIFY(_tempDir->isValid());
+
+    _imageBytes.resize(_imageSize);
+    QRandomGenerator generator(1234);
+    generator.fillRange(reinterpret_cast<quint32*>(_imageBytes.data()), _imageSize / sizeof(quint32));
+
+    const QString fileName = _tempDir->filePath(QStringLiteral("firmware.bin"));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(_imageBytes), static_cast<qint64>(_imageSize));
+    file.close();
+
+    _image = new FirmwareImage(this);
+    QVERIFY(_image->load(fileName, MockBootloader::boardId));
+}
+
+void BootloaderTest::cleanup()
+{
+    delete _image;
+    _image = nullptr;
+    delete _tempDir;
+    _tempDir = nullptr;
+
+    UnitTest::cleanup();
+}
+
+void BootloaderTest::_testBoardInfo()
+{
+    MockBootloader mockBootloader(_flashSize);
+    QVERIFY(mockBootloader.open(QIODevice::ReadWrite | QIODevice::Unbuffered));
+
+    Bootloader bootloader(false);
+    QVERIFY(bootloader.open(&mockBootloader));
+
+    uint32_t bootloaderVersion = 0;
+    uint32_t boardId = 0;
+    uint32_t flashSize = 0;
+    QVERIFY2(bootloader.getBoardInfo(bootloaderVersion, boardId, flashSize), qPrintable(bootloader.errorString()));
+    QCOMPARE(bootloaderVersion, MockBootloader::bootloaderRev);
+    QCOMPARE(boardId, MockBootloader::boardId);
+    QCOMPARE(flashSize, _flashSize);
+}
+
+void BootloaderTest::_testProgramVerify_data()
+{
+    QTest::addColumn<int>("pipelineDepth");
+
+    QTest::newRow("serial") << 1;
+    QTest::newRow("pipelined") << Bootloader::defaultUsbPipelineDepth;
+}
+
+void BootloaderTest::_testProgramVerify()
+{
+    QFETCH(int, pipelineDepth);
+
+    MockBootloader mockBootloader(_flashSize);
+    mockBootloader.setLinkLatency(50);
+    QVERIFY(mockBootloader.open(QIODevice::ReadWrite | QIODevice::Unbuffered));
+
+    Bootloader bootloader(false);
+    bootloader.setProgramPipelineDepth(pipelineDepth);
+    QVERIFY(bootloader.open(&mockBootloader));
+
+    int lastProgress = 0;
+    (void) connect(&bootloader, &Bootloader::updateProgress, this, [&lastProgress](int curr, int total) {
+        QVERIFY(curr > lastProgress);
+        QVERIFY(curr <= total);
+        lastProgress = curr;
+    });
+
+    uint32_t bootloaderVersion, boardId, flashSize;
+    QVERIFY2(bootloader.getBoardInfo(bootloaderVersion, boardId, flashSize), qPrintable(bootloader.errorString()));
+    QVERIFY2(bootloader.erase(), qPrintable(bootloader.errorString()));
+    QVERIFY2(bootloader.program(_image), qPrintable(bootloader.errorString()));
+    QCOMPARE(lastProgress, _imageSize);
+    QCOMPARE(mockBootloader.maxCommandsInFlight(), pipelineDepth);
+    QCOMPARE(mockBootloader.flash().left(_imageSize), _imageBytes);
+
+    // Verify compares the CRC of the whole flash and reboots the board
+    QVERIFY2(bootloader.verify(_image), qPrintable(bootloader.errorString()));
+    QVERIFY(mockBootloader.booted());
+}
+
+void BootloaderTest::_testProgramFailure()
+{
+    MockBootloader mockBootloader(_flashSize);
+    mockBootloader.setFailAddress(0x1010);
+    QVERIFY(mockBootloader.open(QIODevice::ReadWrite | QIODevice::Unbuffered));
+
+    Bootloader bootloader(false);
+    bootloader.setProgramPipelineDepth(Bootloader::defaultUsbPipelineDepth);
+    QVERIFY(bootloader.open(&mockBootloader));
+
+    uint32_t bootloaderVersion, boardId, flashSize;
+    QVERIFY(bootloader.getBoardInfo(bootloaderVersion, boardId, flashSize));
+    QVERIFY(bootloader.erase());
+
+    // The failure is reported for the chunk which failed, not the last one sent
+    QVERIFY(!bootloader.program(_image));
+    QVERIFY2(bootloader.errorString().contains(QStringLiteral("0x00001000")), qPrintable(bootloader.errorString()));
+}
+
+void BootloaderTest::_benchmarkProgram_data()
+{
+    QTest::addColumn<int>("pipelineDepth");
+
+    QTest::newRow("serial") << 1;
+    QTest::newRow("pipelined") << Bootloader::defaultUsbPipelineDepth;
+}
+
+void BootloaderTest::_benchmarkProgram()
+{
+    QFETCH(int, pipelineDepth);
+
+    QBENCHMARK {
+        // Roughly a full speed USB CDC link: 1 ms frames, and the time the board needs to program a chunk
+        MockBootloader mockBootloader(_flashSize);
+        mockBootloader.setLinkLatency(500);
+        mockBootloader.setProgramTime(150);
+        QVERIFY(mockBootloader.open(QIODevice::ReadWrite | QIODevice::Unbuffered));
+
+        Bootloader bootloader(false);
+        bootloader.setProgramPipelineDepth(pipelineDepth);
+        QVERIFY(bootloader.open(&mockBootloader));
+
+        uint32_t bootloaderVersion, boardId, flashSize;
+        QVERIFY(bootloader.getBoardInfo(bootloaderVersion, boardId, flashSize));
+        QVERIFY(bootloader.program(_image));
+    }
+}
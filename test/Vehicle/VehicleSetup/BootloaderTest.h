@@ -0,0 +1,40 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+#include <QtCore/QTemporaryDir>
+
+class FirmwareImage;
+
+class BootloaderTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void init() final;
+    void cleanup() final;
+
+    void _testBoardInfo();
+    void _testProgramVerify();
+    void _testProgramVerify_data();
+    void _testProgramFailure();
+    void _benchmarkProgram();
+    void _benchmarkProgram_data();
+
+private:
+    QTemporaryDir *_tempDir = nullptr;
+    QByteArray _imageBytes;
+    FirmwareImage *_image = nullptr;
+
+    static constexpr uint32_t _flashSize = 256 * 1024;
+    static constexpr int _imageSize = 128 * 1024;
+};
@@ -0,0 +1,250 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MockBootloader.h"
+#include "QGC.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QThread>
+
+QGC_LOGGING_CATEGORY(MockBootloaderLog, "Test.MockBootloader")
+
+namespace {
+    // Bootloader protocol bytes, see Bootloader.h
+    constexpr uint8_t PROTO_INSYNC = 0x12;
+    constexpr uint8_t PROTO_EOC = 0x20;
+    constexpr uint8_t PROTO_OK = 0x10;
+    constexpr uint8_t PROTO_FAILED = 0x11;
+    constexpr uint8_t PROTO_INVALID = 0x13;
+    constexpr uint8_t PROTO_GET_SYNC = 0x21;
+    constexpr uint8_t PROTO_GET_DEVICE = 0x22;
+    constexpr uint8_t PROTO_CHIP_ERASE = 0x23;
+    constexpr uint8_t PROTO_LOAD_ADDRESS = 0x24;    // Also PROTO_CHIP_VERIFY when followed by EOC
+    constexpr uint8_t PROTO_PROG_MULTI = 0x27;
+    constexpr uint8_t PROTO_READ_MULTI = 0x28;
+    constexpr uint8_t PROTO_GET_CRC = 0x29;
+    constexpr uint8_t PROTO_BOOT = 0x30;
+
+    constexpr uint8_t INFO_BL_REV = 1;
+    constexpr uint8_t INFO_BOARD_ID = 2;
+    constexpr uint8_t INFO_FLASH_SIZE = 4;
+
+    void appendUInt32(QByteArray &bytes, uint32_t value)
+    {
+        for (int i = 0; i < 4; i++) {
+            bytes.append(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+}
+
+MockBootloader::MockBootloader(uint32_t flashSize, QObject *parent)
+    : QIODevice(parent)
+    , _flash(static_cast<qsizetype>(flashSize), static_cast<char>(0xFF))
+{
+    // qCDebug(MockBootloaderLog) << Q_FUNC_INFO << this;
+
+    _clock.start();
+}
+
+qint64 MockBootloader::bytesAvailable() const
+{
+    _deliver();
+    return (_ready.size() + QIODevice::bytesAvailable());
+}
+
+bool MockBootloader::waitForReadyRead(int msecs)
+{
+    _deliver();
+    if (_ready.isEmpty() && !_pending.isEmpty()) {
+        qint64 waitUSecs = _pending.head().readyUSecs - _nowUSecs();
+        if (msecs >= 0) {
+            waitUSecs = qMin(waitUSecs, static_cast<qint64>(msecs) * 1000);
+        }
+        if (waitUSecs > 0) {
+            QThread::usleep(static_cast<unsigned long>(waitUSecs));
+        }
+        _deliver();
+    }
+
+    if (_ready.isEmpty()) {
+        return false;
+    }
+
+    emit readyRead();
+    return true;
+}
+
+qint64 MockBootloader::readData(char *data, qint64 maxSize)
+{
+    _deliver();
+
+    const qint64 count = qMin(maxSize, static_cast<qint64>(_ready.size()));
+    (void) memcpy(data, _ready.constData(), static_cast<size_t>(count));
+    _ready.remove(0, count);
+
+    return count;
+}
+
+qint64 MockBootloader::writeData(const char *data, qint64 maxSize)
+{
+    _rx.append(data, maxSize);
+    _processCommands(_nowUSecs() + _linkLatencyUSecs);
+
+    return maxSize;
+}
+
+void MockBootloader::_processCommands(qint64 arrivalUSecs)
+{
+    while (!_rx.isEmpty()) {
+        QByteArray reply;
+        int costUSecs = 0;
+        const qsizetype consumed = _processCommand(reply, costUSecs);
+        if (consumed == 0) {
+            break;
+        }
+        _rx.remove(0, consumed);
+
+        // The bootloader works through its receive buffer one command at a time
+        const qint64 startUSecs = qMax(arrivalUSecs, _busyUntilUSecs);
+        _busyUntilUSecs = startUSecs + costUSecs;
+
+        Response response;
+        response.readyUSecs = _busyUntilUSecs + _linkLatencyUSecs;
+        response.bytes = reply;
+        _pending.enqueue(response);
+
+        _maxCommandsInFlight = qMax(_maxCommandsInFlight, static_cast<int>(_pending.count()));
+    }
+}
+
+qsizetype MockBootloader::_processCommand(QByteArray &reply, int &costUSecs)
+{
+    const auto byteAt = [this](qsizetype index) { return static_cast<uint8_t>(_rx.at(index)); };
+    const auto invalid = [&reply]() { reply.append(static_cast<char>(PROTO_INSYNC)); reply.append(static_cast<char>(PROTO_INVALID)); };
+    const auto ok = [&reply]() { reply.append(static_cast<char>(PROTO_INSYNC)); reply.append(static_cast<char>(PROTO_OK)); };
+
+    const uint8_t command = byteAt(0);
+    switch (command) {
+    case PROTO_GET_SYNC:
+    case PROTO_CHIP_ERASE:
+    case PROTO_GET_CRC:
+    case PROTO_BOOT:
+        if (_rx.size() < 2) {
+            return 0;
+        }
+        if (byteAt(1) != PROTO_EOC) {
+            invalid();
+            return 1;
+        }
+        if (command == PROTO_CHIP_ERASE) {
+            _flash.fill(static_cast<char>(0xFF));
+            _address = 0;
+        } else if (command == PROTO_GET_CRC) {
+            appendUInt32(reply, QGC::crc32(reinterpret_cast<const quint8*>(_flash.constData()), static_cast<unsigned>(_flash.size()), 0));
+        } else if (command == PROTO_BOOT) {
+            _booted = true;
+        }
+        ok();
+        return 2;
+
+    case PROTO_GET_DEVICE:
+        if (_rx.size() < 3) {
+            return 0;
+        }
+        if (byteAt(2) != PROTO_EOC) {
+            invalid();
+            return 1;
+        }
+        switch (byteAt(1)) {
+        case INFO_BL_REV:
+            appendUInt32(reply, bootloaderRev);
+            break;
+        case INFO_BOARD_ID:
+            appendUInt32(reply, boardId);
+            break;
+        case INFO_FLASH_SIZE:
+            appendUInt32(reply, static_cast<uint32_t>(_flash.size()));
+            break;
+        default:
+            invalid();
+            return 3;
+        }
+        ok();
+        return 3;
+
+    case PROTO_LOAD_ADDRESS:
+        if (_rx.size() < 2) {
+            return 0;
+        }
+        if (byteAt(1) == PROTO_EOC) {
+            // PROTO_CHIP_VERIFY
+            _address = 0;
+            ok();
+            return 2;
+        }
+        if (_rx.size() < 4) {
+            return 0;
+        }
+        _address = byteAt(1) | (byteAt(2) << 8);
+        ok();
+        return 4;
+
+    case PROTO_PROG_MULTI: {
+        if (_rx.size() < 2) {
+            return 0;
+        }
+        const int length = byteAt(1);
+        if (_rx.size() < (length + 3)) {
+            return 0;
+        }
+        if ((byteAt(length + 2) != PROTO_EOC) || ((_address + length) > static_cast<uint32_t>(_flash.size()))) {
+            invalid();
+            return length + 3;
+        }
+        costUSecs = _programUSecs;
+        if ((_failAddress >= _address) && (_failAddress < (_address + length))) {
+            reply.append(static_cast<char>(PROTO_INSYNC));
+            reply.append(static_cast<char>(PROTO_FAILED));
+        } else {
+            (void) _flash.replace(_address, length, _rx.constData() + 2, length);
+            ok();
+        }
+        _address += length;
+        return length + 3;
+    }
+
+    case PROTO_READ_MULTI: {
+        if (_rx.size() < 3) {
+            return 0;
+        }
+        const int length = byteAt(1);
+        if ((byteAt(2) != PROTO_EOC) || ((_address + length) > static_cast<uint32_t>(_flash.size()))) {
+            invalid();
+            return 3;
+        }
+        reply.append(_flash.mid(_address, length));
+        _address += length;
+        ok();
+        return 3;
+    }
+
+    default:
+        qCDebug(MockBootloaderLog) << "Unknown command" << Qt::hex << static_cast<int>(command);
+        invalid();
+        return 1;
+    }
+}
+
+void MockBootloader::_deliver() const
+{
+    const qint64 now = _nowUSecs();
+    while (!_pending.isEmpty() && (_pending.head().readyUSecs <= now)) {
+        _ready.append(_pending.dequeue().bytes);
+    }
+}
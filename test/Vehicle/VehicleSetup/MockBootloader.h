@@ -0,0 +1,84 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QIODevice>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QQueue>
+
+Q_DECLARE_LOGGING_CATEGORY(MockBootloaderLog)
+
+/// Stand-in for a PX4 bootloader (protocol revision 5) on the other end of a serial port.
+///
+/// Commands written to the device are answered like the real bootloader does: one at a time and in order.
+/// The link is modelled with a one way latency and a per command processing time, so the time a flash takes
+/// depends on round trips the same way it does on USB CDC. Reads block until the next response is due.
+class MockBootloader : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit MockBootloader(uint32_t flashSize = 512 * 1024, QObject *parent = nullptr);
+
+    /// One way latency of the link, in microseconds
+    void setLinkLatency(int usecs) { _linkLatencyUSecs = usecs; }
+    /// Time to program one PROG_MULTI chunk, in microseconds
+    void setProgramTime(int usecs) { _programUSecs = usecs; }
+    /// PROG_MULTI fails for the chunk containing this address
+    void setFailAddress(uint32_t address) { _failAddress = address; }
+
+    QByteArray flash() const { return _flash; }
+    bool booted() const { return _booted; }
+    /// Highest number of commands which were waiting for their response at the same time
+    int maxCommandsInFlight() const { return _maxCommandsInFlight; }
+
+    static constexpr uint32_t boardId = 50;
+    static constexpr uint32_t bootloaderRev = 5;
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+    bool waitForReadyRead(int msecs) override;
+    bool waitForBytesWritten(int msecs) override { Q_UNUSED(msecs); return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    struct Response {
+        qint64 readyUSecs = 0;
+        QByteArray bytes;
+    };
+
+    /// Handles all complete commands in the receive buffer
+    void _processCommands(qint64 arrivalUSecs);
+    /// @return Number of bytes consumed, 0 if the command is incomplete
+    qsizetype _processCommand(QByteArray &reply, int &costUSecs);
+    /// Moves responses which are due to the read buffer
+    void _deliver() const;
+    qint64 _nowUSecs() const { return _clock.nsecsElapsed() / 1000; }
+
+    QElapsedTimer _clock;
+    QByteArray _rx;
+    mutable QQueue<Response> _pending;
+    mutable QByteArray _ready;
+    qint64 _busyUntilUSecs = 0;
+
+    QByteArray _flash;
+    uint32_t _address = 0;
+    uint32_t _failAddress = UINT32_MAX;
+    bool _booted = false;
+    int _maxCommandsInFlight = 0;
+
+    int _linkLatencyUSecs = 0;
+    int _programUSecs = 0;
+};
@@ -0,0 +1,148 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "VideoLatencyStatsTest.h"
+#include "VideoLatencyStats.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QMetaProperty>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+
+namespace {
+
+constexpr qint64 kFrameIntervalUSecs = 33333;
+constexpr qint64 kQueueUSecs = 2000;
+constexpr qint64 kDecodeUSecs = 5000;
+constexpr qint64 kSinkUSecs = 1000;
+
+/// Passes frameCount frames through all stages, the decode time of the last frame is doubled
+void feedFrames(VideoLatencyStats &stats, int frameCount)
+{
+    for (int i = 0; i < frameCount; i++) {
+        const quint64 pts = static_cast<quint64>(i) * kFrameIntervalUSecs * 1000;
+        const qint64 decodeUSecs = (i == (frameCount - 1)) ? (2 * kDecodeUSecs) : kDecodeUSecs;
+        qint64 timeUSecs = 1000000 + (i * kFrameIntervalUSecs);
+        stats.recordFrame(VideoLatencyStats::StageSource, pts, timeUSecs);
+        stats.recordFrame(VideoLatencyStats::StageDecoderInput, pts, timeUSecs += kQueueUSecs);
+        stats.recordFrame(VideoLatencyStats::StageDecoderOutput, pts, timeUSecs += decodeUSecs);
+        stats.recordFrame(VideoLatencyStats::StageSink, pts, timeUSecs += kSinkUSecs);
+    }
+}
+
+} // namespace
+
+void VideoLatencyStatsTest::_testStageTimes()
+{
+    VideoLatencyStats stats;
+    QVERIFY(!stats.snapshot().valid);
+
+    constexpr int frameCount = 10;
+    feedFrames(stats, frameCount);
+
+    // A frame displayed again counts as rendered but adds no second set of stage times
+    stats.recordFrame(VideoLatencyStats::StageSink, 0, 5000000);
+
+    // Frames only reach later stages by PTS, an unknown PTS is ignored
+    stats.recordFrame(VideoLatencyStats::StageDecoderInput, 123456789, 5000000);
+
+    VideoLatencyStats::Snapshot snapshot = stats.snapshot();
+    QVERIFY(snapshot.valid);
+    QCOMPARE(snapshot.framesRendered, static_cast<quint64>(frameCount + 1));
+    QCOMPARE(snapshot.queueMs, kQueueUSecs / 1000.);
+    QCOMPARE(snapshot.decodeMs, ((frameCount + 1) * kDecodeUSecs) / (frameCount * 1000.));
+    QCOMPARE(snapshot.decodeMaxMs, (2 * kDecodeUSecs) / 1000.);
+    QCOMPARE(snapshot.sinkMs, kSinkUSecs / 1000.);
+    QCOMPARE(snapshot.pipelineMaxMs, (kQueueUSecs + (2 * kDecodeUSecs) + kSinkUSecs) / 1000.);
+    QVERIFY(snapshot.pipelineMs > ((kQueueUSecs + kDecodeUSecs + kSinkUSecs) / 1000.));
+
+    stats.recordSinkLateness(4000);
+    stats.setQueueDepth(3);
+    stats.setFramesDroppedLate(2);
+
+    // The properties are updated from the object's thread
+    QSignalSpy spyStatsChanged(&stats, &VideoLatencyStats::statsChanged);
+    stats.publish();
+    QVERIFY(spyStatsChanged.wait(1000));
+    QVERIFY(stats.valid());
+    QCOMPARE(stats.pipelineMaxMs(), snapshot.pipelineMaxMs);
+    QCOMPARE(stats.sinkLatenessMs(), 4.);
+    QCOMPARE(stats.queueDepth(), 3);
+    QCOMPARE(stats.framesDroppedLate(), static_cast<quint64>(2));
+
+    stats.reset();
+    snapshot = stats.snapshot();
+    QVERIFY(!snapshot.valid);
+    QCOMPARE(snapshot.framesRendered, static_cast<quint64>(0));
+    QCOMPARE(snapshot.pipelineMs, 0.);
+}
+
+void VideoLatencyStatsTest::_testJitterBuffer()
+{
+    VideoLatencyStats stats;
+
+    // Packets leave out of order, matched by seqnum across the wrap around
+    const quint16 seqnums[3] = { 65534, 65535, 0 };
+    for (int i = 0; i < 3; i++) {
+        stats.recordJitterBufferPacket(true, seqnums[i], 1000 + (i * 100));
+    }
+    stats.recordJitterBufferPacket(false, seqnums[2], 1200 + 3000);
+    stats.recordJitterBufferPacket(false, seqnums[0], 1000 + 3000);
+    stats.recordJitterBufferPacket(false, seqnums[1], 1100 + 3000);
+
+    // A packet which never went in, or leaves twice, is not counted
+    stats.recordJitterBufferPacket(false, 42, 100000);
+    stats.recordJitterBufferPacket(false, seqnums[0], 100000);
+
+    QCOMPARE(stats.snapshot().jitterBufferMs, 3.);
+}
+
+void VideoLatencyStatsTest::_testLogFile()
+{
+    const QTemporaryDir tmpDir;
+    const QString fileName = tmpDir.filePath("latency.csv");
+
+    VideoLatencyStats stats;
+    stats.setLogFileName(fileName);
+
+    // Nothing is logged before there are measurements
+    stats.publish();
+    feedFrames(stats, 3);
+    stats.publish();
+    stats.setLogFileName(QString());
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    const QStringList lines = QString::fromUtf8(file.readAll()).split('\n', Qt::SkipEmptyParts);
+    QCOMPARE(lines.count(), 2);
+
+    // The columns are named like the properties QML sees, in the same order
+    QStringList expectedHeader = { QStringLiteral("time") };
+    const QMetaObject *const metaObject = stats.metaObject();
+    for (int i = metaObject->propertyOffset(); i < metaObject->propertyCount(); i++) {
+        const QString name = QString::fromLatin1(metaObject->property(i).name());
+        if (name != QStringLiteral("valid")) {
+            expectedHeader.append(name);
+        }
+    }
+    QCOMPARE(lines[0].split(','), expectedHeader);
+
+    const QStringList values = lines[1].split(',');
+    QCOMPARE(values.count(), expectedHeader.count());
+    QCOMPARE(values[expectedHeader.indexOf("framesRendered")].toInt(), 3);
+    QCOMPARE(values[expectedHeader.indexOf("queueMs")].toDouble(), kQueueUSecs / 1000.);
+
+    // Appending to an existing file does not repeat the header
+    stats.setLogFileName(fileName);
+    stats.publish();
+    stats.setLogFileName(QString());
+    QVERIFY(file.seek(0));
+    QCOMPARE(QString::fromUtf8(file.readAll()).count(QStringLiteral("time,")), 1);
+}
@@ -0,0 +1,170 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "OsmMeshCacheTest.h"
+#include "OsmMeshCache.h"
+
+#include <QtCore/QBuffer>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QTest>
+
+namespace {
+
+const QByteArray fileHash = "0123456789abcdef";
+
+QHash<uint64_t, OsmParserThread::BuildingType_t> makeBuildings()
+{
+    QHash<uint64_t, OsmParserThread::BuildingType_t> buildings;
+
+    OsmParserThread::BuildingType_t building;
+    building.height = 0;
+    building.levels = 3;
+    building.points_gps = { QGeoCoordinate(47.0, 8.0), QGeoCoordinate(47.0, 8.001), QGeoCoordinate(47.001, 8.001) };
+    building.points_local = { QVector2D(0, 0), QVector2D(75, 0), QVector2D(75, 110) };
+    building.bb_min = QVector2D(0, 0);
+    building.bb_max = QVector2D(75, 110);
+    buildings.insert(42, building);
+
+    building.height = 12.5f;
+    building.levels = 0;
+    building.points_local_inner = { QVector2D(10, 10), QVector2D(20, 10), QVector2D(20, 20) };
+    buildings.insert(0xFFFFFFFF00000001ull, building);
+
+    return buildings;
+}
+
+}
+
+void OsmMeshCacheTest::_testBuildingsRoundTrip()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const OsmMeshCache cache(tempDir.path());
+
+    const QHash<uint64_t, OsmParserThread::BuildingType_t> buildings = makeBuildings();
+    const QGeoCoordinate coordinateMin(47.0, 8.0), coordinateMax(47.01, 8.01), gpsRef(47.005, 8.005);
+
+    QHash<uint64_t, OsmParserThread::BuildingType_t> loaded;
+    QGeoCoordinate loadedMin, loadedMax, loadedRef;
+    QVERIFY(!cache.loadBuildings(fileHash, loaded, loadedMin, loadedMax, loadedRef));
+
+    QVERIFY(cache.saveBuildings(fileHash, buildings, coordinateMin, coordinateMax, gpsRef));
+    QVERIFY(cache.loadBuildings(fileHash, loaded, loadedMin, loadedMax, loadedRef));
+
+    QCOMPARE(loadedMin, coordinateMin);
+    QCOMPARE(loadedMax, coordinateMax);
+    QCOMPARE(loadedRef, gpsRef);
+    QCOMPARE(loaded.count(), buildings.count());
+    for (auto it = buildings.cbegin(); it != buildings.cend(); ++it) {
+        QVERIFY(loaded.contains(it.key()));
+        const OsmParserThread::BuildingType_t &building = loaded[it.key()];
+        QCOMPARE(building.height, it.value().height);
+        QCOMPARE(building.levels, it.value().levels);
+        QCOMPARE(building.bb_min, it.value().bb_min);
+        QCOMPARE(building.bb_max, it.value().bb_max);
+        QVERIFY(building.points_gps == it.value().points_gps);
+        QVERIFY(building.points_gps_inner == it.value().points_gps_inner);
+        QVERIFY(building.points_local == it.value().points_local);
+        QVERIFY(building.points_local_inner == it.value().points_local_inner);
+    }
+
+    // A different file is a miss
+    QVERIFY(!cache.loadBuildings("fedcba9876543210", loaded, loadedMin, loadedMax, loadedRef));
+}
+
+void OsmMeshCacheTest::_testMeshRoundTrip()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const OsmMeshCache cache(tempDir.path());
+
+    const QList<OsmParser::MeshChunk> chunks = OsmParser::buildMeshChunks(makeBuildings(), 3.0f, 100.0f);
+    QVERIFY(!chunks.isEmpty());
+    QVERIFY(cache.saveMesh(fileHash, 3.0f, 100.0f, chunks));
+
+    QList<OsmParser::MeshChunk> loaded;
+    QVERIFY(cache.loadMesh(fileHash, 3.0f, 100.0f, loaded));
+    QCOMPARE(loaded.count(), chunks.count());
+    for (qsizetype i = 0; i < chunks.count(); i++) {
+        QCOMPARE(loaded[i].vertexData, chunks[i].vertexData);
+        QCOMPARE(loaded[i].indexData, chunks[i].indexData);
+        QCOMPARE(loaded[i].boundsMin, chunks[i].boundsMin);
+        QCOMPARE(loaded[i].boundsMax, chunks[i].boundsMax);
+    }
+
+    // Mesh parameters are part of the key
+    QVERIFY(!cache.loadMesh(fileHash, 3.5f, 100.0f, loaded));
+    QVERIFY(!cache.loadMesh(fileHash, 3.0f, 500.0f, loaded));
+}
+
+void OsmMeshCacheTest::_testInvalidFiles()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const OsmMeshCache cache(tempDir.path());
+
+    const QList<OsmParser::MeshChunk> chunks = OsmParser::buildMeshChunks(makeBuildings(), 3.0f, 100.0f);
+    QVERIFY(cache.saveMesh(fileHash, 3.0f, 100.0f, chunks));
+
+    const QStringList files = QDir(tempDir.path()).entryList({ QStringLiteral("*.mesh") }, QDir::Files);
+    QCOMPARE(files.count(), static_cast<qsizetype>(1));
+    QFile file(tempDir.filePath(files.first()));
+
+    // Truncated
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 10));
+    file.close();
+    QList<OsmParser::MeshChunk> loaded;
+    QVERIFY(!cache.loadMesh(fileHash, 3.0f, 100.0f, loaded));
+    QVERIFY(loaded.isEmpty());
+
+    // Future version
+    QVERIFY(cache.saveMesh(fileHash, 3.0f, 100.0f, chunks));
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(8));
+    const char futureVersion[4] = { 99, 0, 0, 0 };
+    QCOMPARE(file.write(futureVersion, sizeof(futureVersion)), static_cast<qint64>(sizeof(futureVersion)));
+    file.close();
+    QVERIFY(!cache.loadMesh(fileHash, 3.0f, 100.0f, loaded));
+
+    // Not a cache file
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    (void) file.write("<osm version=\"0.6\"></osm>");
+    file.close();
+    QVERIFY(!cache.loadMesh(fileHash, 3.0f, 100.0f, loaded));
+
+    // No hash, nothing is cached
+    QVERIFY(!cache.saveMesh(QByteArray(), 3.0f, 100.0f, chunks));
+}
+
+void OsmMeshCacheTest::_testPrune()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const OsmMeshCache cache(tempDir.path(), 3);
+
+    const QList<OsmParser::MeshChunk> chunks = OsmParser::buildMeshChunks(makeBuildings(), 3.0f, 100.0f);
+    for (int i = 0; i < 5; i++) {
+        QVERIFY(cache.saveMesh(fileHash, static_cast<float>(i), 100.0f, chunks));
+    }
+
+    QCOMPARE(QDir(tempDir.path()).entryList(QDir::Files).count(), static_cast<qsizetype>(3));
+
+    // Content hashes are stable
+    QBuffer first, second;
+    first.setData("<osm/>");
+    second.setData("<osm/>");
+    QVERIFY(first.open(QIODevice::ReadOnly));
+    QVERIFY(second.open(QIODevice::ReadOnly));
+    const QByteArray hash = OsmMeshCache::hashFile(first);
+    QVERIFY(!hash.isEmpty());
+    QCOMPARE(hash, OsmMeshCache::hashFile(second));
+}
@@ -0,0 +1,167 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "OsmParserBenchmark.h"
+#include "OsmParser.h"
+#include "OsmParserThread.h"
+
+#include <QtCore/QBuffer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QThreadPool>
+#include <QtTest/QTest>
+
+QByteArray OsmParserBenchmark::_generateOsm(int gridSize)
+{
+    constexpr double originLat = 47.0;
+    constexpr double originLon = 8.0;
+    constexpr double spacing = 0.0002;
+    constexpr double size = 0.0001;
+
+    QByteArray osm;
+    osm.reserve(gridSize * gridSize * 700);
+    osm.append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<osm version=\"0.6\">\n");
+    osm.append(QStringLiteral(" <bounds minlat=\"%1\" minlon=\"%2\" maxlat=\"%3\" maxlon=\"%4\"/>\n")
+        .arg(originLat, 0, 'f', 7).arg(originLon, 0, 'f', 7)
+        .arg(originLat + gridSize * spacing, 0, 'f', 7).arg(originLon + gridSize * spacing, 0, 'f', 7).toUtf8());
+
+    const double cornerLat[4] = { 0, 0, size, size };
+    const double cornerLon[4] = { 0, size, size, 0 };
+
+    uint64_t nodeId = 1;
+    for (int row = 0; row < gridSize; row++) {
+        for (int col = 0; col < gridSize; col++) {
+            for (int corner = 0; corner < 4; corner++) {
+                osm.append(QStringLiteral(" <node id=\"%1\" lat=\"%2\" lon=\"%3\" version=\"1\" timestamp=\"2024-01-01T00:00:00Z\"/>\n")
+                    .arg(nodeId++)
+                    .arg(originLat + row * spacing + cornerLat[corner], 0, 'f', 7)
+                    .arg(originLon + col * spacing + cornerLon[corner], 0, 'f', 7).toUtf8());
+            }
+        }
+    }
+
+    uint64_t wayId = 1;
+    for (int building = 0; building < (gridSize * gridSize); building++) {
+        const uint64_t firstNode = 1 + (building * 4);
+        osm.append(QStringLiteral(" <way id=\"%1\">\n").arg(wayId++).toUtf8());
+        for (int corner = 0; corner < 5; corner++) {
+            osm.append(QStringLiteral("  <nd ref=\"%1\"/>\n").arg(firstNode + (corner % 4)).toUtf8());
+        }
+        osm.append((building % 3) ? "  <tag k=\"building\" v=\"yes\"/>\n" : "  <tag k=\"building:levels\" v=\"4\"/>\n");
+        osm.append(" </way>\n");
+    }
+
+    // Roads along each row, these must not end up as buildings
+    for (int row = 0; row < gridSize; row++) {
+        osm.append(QStringLiteral(" <way id=\"%1\">\n").arg(wayId++).toUtf8());
+        for (int col = 0; col < gridSize; col++) {
+            osm.append(QStringLiteral("  <nd ref=\"%1\"/>\n").arg(1 + ((row * gridSize + col) * 4)).toUtf8());
+        }
+        osm.append("  <tag k=\"highway\" v=\"residential\"/>\n </way>\n");
+    }
+
+    osm.append("</osm>\n");
+    return osm;
+}
+
+qint64 OsmParserBenchmark::_memoryStatusKiB(const QByteArray &field)
+{
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    while (!status.atEnd()) {
+        const QByteArray line = status.readLine();
+        if (line.startsWith(field)) {
+            return line.mid(field.size()).trimmed().split(' ').first().toLongLong();
+        }
+    }
+
+    return 0;
+}
+
+bool OsmParserBenchmark::_resetPeakMemory()
+{
+    // Linux 4.0 and later
+    QFile clearRefs(QStringLiteral("/proc/self/clear_refs"));
+    if (!clearRefs.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return (clearRefs.write("5") == 1);
+}
+
+void OsmParserBenchmark::_benchmarkLargeFile()
+{
+    constexpr int gridSize = 300;
+    constexpr qint64 maxPeakGrowthPerInputByte = 2;     // A DOM of the document alone takes several times its size
+    QBuffer buffer;
+    buffer.setData(_generateOsm(gridSize));
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    // Generating the document and earlier tests raised the peak, so start over from what is resident now
+    const bool peakReset = _resetPeakMemory();
+    const qint64 residentBeforeKiB = _memoryStatusKiB("VmRSS:");
+    QElapsedTimer timer;
+    timer.start();
+
+    QHash<uint64_t, OsmParserThread::BuildingType_t> buildings;
+    QGeoCoordinate coordinateMin, coordinateMax, gpsRef;
+    QVERIFY(OsmParserThread::decodeStream(buffer, buildings, coordinateMin, coordinateMax, gpsRef));
+
+    const qint64 elapsedMSecs = timer.elapsed();
+    const qint64 peakAfterKiB = _memoryStatusKiB("VmHWM:");
+
+    QCOMPARE(buildings.count(), static_cast<qsizetype>(gridSize * gridSize));
+    if (peakReset && (residentBeforeKiB > 0) && (peakAfterKiB > 0)) {
+        const qint64 peakGrowthBytes = (peakAfterKiB - residentBeforeKiB) * 1024;
+        QVERIFY2(peakGrowthBytes <= (buffer.size() * maxPeakGrowthPerInputByte),
+                 qPrintable(QStringLiteral("peak RSS grew by %1 KiB for a %2 KiB document").arg(peakGrowthBytes / 1024).arg(buffer.size() / 1024)));
+    } else {
+        qWarning() << "Peak memory can not be reset on this platform, memory growth not checked";
+    }
+
+    QTest::setBenchmarkResult(static_cast<qreal>(elapsedMSecs), QTest::WalltimeMilliseconds);
+}
+
+void OsmParserBenchmark::_benchmarkMesh()
+{
+    constexpr int gridSize = 200;
+    QBuffer buffer;
+    buffer.setData(_generateOsm(gridSize));
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    QHash<uint64_t, OsmParserThread::BuildingType_t> buildings;
+    QGeoCoordinate coordinateMin, coordinateMax, gpsRef;
+    QVERIFY(OsmParserThread::decodeStream(buffer, buildings, coordinateMin, coordinateMax, gpsRef));
+
+    // The same chunks triangulated one after the other and on the global thread pool
+    QThreadPool serialPool;
+    serialPool.setMaxThreadCount(1);
+    QElapsedTimer timer;
+    timer.start();
+    const QList<OsmParser::MeshChunk> serial = OsmParser::buildMeshChunks(buildings, 3.0f, OsmParser::defaultMeshChunkSize, &serialPool);
+    const qint64 serialNSecs = timer.nsecsElapsed();
+
+    timer.start();
+    const QList<OsmParser::MeshChunk> parallel = OsmParser::buildMeshChunks(buildings, 3.0f);
+    const qint64 parallelNSecs = timer.nsecsElapsed();
+
+    QVERIFY(parallel.count() > 1);
+    QCOMPARE(parallel.count(), serial.count());
+    for (qsizetype i = 0; i < parallel.count(); i++) {
+        QCOMPARE(parallel[i].vertexData, serial[i].vertexData);
+        QCOMPARE(parallel[i].indexData, serial[i].indexData);
+        QCOMPARE(parallel[i].boundsMin, serial[i].boundsMin);
+        QCOMPARE(parallel[i].boundsMax, serial[i].boundsMax);
+    }
+
+    // Speedup of the parallel build over the serial one
+    QTest::setBenchmarkResult(static_cast<qreal>(serialNSecs) / qMax(parallelNSecs, qint64(1)), QTest::Events);
+}
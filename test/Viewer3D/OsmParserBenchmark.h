@@ -0,0 +1,33 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// OSM parsing and building mesh timings on a ~50 MB document. Runs standalone only (--unittest:OsmParserBenchmark or the benchmark build target).
+class OsmParserBenchmark : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _benchmarkLargeFile();
+    void _benchmarkMesh();
+
+private:
+    /// Generates an OSM document with gridSize * gridSize square buildings plus a road network
+    static QByteArray _generateOsm(int gridSize);
+
+    /// @return Value of a /proc/self/status memory field in KiB, 0 if not available
+    static qint64 _memoryStatusKiB(const QByteArray &field);
+
+    /// Resets the peak resident set size to the current one, so the peak only covers what runs afterwards
+    /// @return false: Not supported on this platform
+    static bool _resetPeakMemory();
+};
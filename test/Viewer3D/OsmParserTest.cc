@@ -0,0 +1,211 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "OsmParserTest.h"
+#include "OsmParser.h"
+#include "OsmParserThread.h"
+
+#include <QtCore/QBuffer>
+#include <QtTest/QTest>
+
+namespace {
+
+const QByteArray smallOsm = R"(<?xml version="1.0" encoding="UTF-8"?>
+<osm version="0.6">
+ <bounds minlat="47.0000" minlon="8.0000" maxlat="47.0100" maxlon="8.0100"/>
+ <node id="1" lat="47.0010" lon="8.0010"/>
+ <node id="2" lat="47.0010" lon="8.0020"/>
+ <node id="3" lat="47.0020" lon="8.0020"/>
+ <node id="4" lat="47.0020" lon="8.0010"/>
+ <node id="5" lat="47.0050" lon="8.0050"/>
+ <node id="6" lat="47.0050" lon="8.0080"/>
+ <node id="7" lat="47.0080" lon="8.0080"/>
+ <node id="8" lat="47.0080" lon="8.0050"/>
+ <node id="9" lat="47.0060" lon="8.0060"/>
+ <node id="10" lat="47.0060" lon="8.0070"/>
+ <node id="11" lat="47.0070" lon="8.0070"/>
+ <node id="12" lat="47.0070" lon="8.0060"/>
+ <way id="100">
+  <nd ref="1"/><nd ref="2"/><nd ref="3"/><nd ref="4"/><nd ref="1"/>
+  <tag k="building" v="shed"/>
+ </way>
+ <way id="101">
+  <nd ref="1"/><nd ref="3"/>
+  <tag k="highway" v="residential"/>
+ </way>
+ <way id="102">
+  <nd ref="5"/><nd ref="6"/><nd ref="7"/><nd ref="8"/><nd ref="5"/>
+ </way>
+ <way id="103">
+  <nd ref="9"/><nd ref="10"/><nd ref="11"/><nd ref="12"/><nd ref="9"/>
+ </way>
+ <relation id="200">
+  <member type="way" ref="102" role="outer"/>
+  <member type="way" ref="103" role="inner"/>
+  <tag k="type" v="multipolygon"/>
+  <tag k="building" v="yes"/>
+ </relation>
+</osm>
+)";
+
+}
+
+void OsmParserTest::_testDecodeBuildings()
+{
+    QBuffer buffer;
+    buffer.setData(smallOsm);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    QHash<uint64_t, OsmParserThread::BuildingType_t> buildings;
+    QGeoCoordinate coordinateMin, coordinateMax, gpsRef;
+    QList<int> progress;
+    QVERIFY(OsmParserThread::decodeStream(buffer, buildings, coordinateMin, coordinateMax, gpsRef, [&progress](int percent) {
+        progress.append(percent);
+    }));
+
+    // Bounds are parsed as float
+    QVERIFY(qAbs(gpsRef.latitude() - 47.005) < 1e-5);
+    QVERIFY(qAbs(gpsRef.longitude() - 8.005) < 1e-5);
+    QVERIFY(!progress.isEmpty());
+    QCOMPARE(progress.last(), 100);
+
+    // The road is dropped, the shed is kept
+    QVERIFY(!buildings.contains(101));
+    QVERIFY(buildings.contains(100));
+    const OsmParserThread::BuildingType_t &shed = buildings[100];
+    QCOMPARE(shed.levels, 1.0f);
+    QCOMPARE(shed.points_local.size(), size_t(5));
+    QCOMPARE(shed.points_gps.size(), size_t(5));
+    QVERIFY(shed.bb_max.x() > shed.bb_min.x());
+    QVERIFY(shed.bb_max.y() > shed.bb_min.y());
+}
+
+void OsmParserTest::_testMultipolygon()
+{
+    QBuffer buffer;
+    buffer.setData(smallOsm);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    QHash<uint64_t, OsmParserThread::BuildingType_t> buildings;
+    QGeoCoordinate coordinateMin, coordinateMax, gpsRef;
+    QVERIFY(OsmParserThread::decodeStream(buffer, buildings, coordinateMin, coordinateMax, gpsRef));
+
+    // Untagged member ways are merged into a single building keyed by the first member
+    QCOMPARE(buildings.count(), static_cast<qsizetype>(2));
+    QVERIFY(buildings.contains(102));
+    QVERIFY(!buildings.contains(103));
+    const OsmParserThread::BuildingType_t &building = buildings[102];
+    QCOMPARE(building.levels, 2.0f);
+    QCOMPARE(building.points_local.size(), size_t(5));
+    QCOMPARE(building.points_local_inner.size(), size_t(5));
+}
+
+void OsmParserTest::_testMalformed()
+{
+    QBuffer buffer;
+    buffer.setData(smallOsm.left(smallOsm.size() / 2));
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    QHash<uint64_t, OsmParserThread::BuildingType_t> buildings;
+    QGeoCoordinate coordinateMin, coordinateMax, gpsRef;
+    QVERIFY(!OsmParserThread::decodeStream(buffer, buildings, coordinateMin, coordinateMax, gpsRef));
+}
+
+void OsmParserTest::_testMeshChunks()
+{
+    QBuffer buffer;
+    buffer.setData(smallOsm);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    QHash<uint64_t, OsmParserThread::BuildingType_t> buildings;
+    QGeoCoordinate coordinateMin, coordinateMax, gpsRef;
+    QVERIFY(OsmParserThread::decodeStream(buffer, buildings, coordinateMin, coordinateMax, gpsRef));
+
+    // Both buildings in one chunk: roof and floor share the outline vertices
+    QList<OsmParser::MeshChunk> chunks = OsmParser::buildMeshChunks(buildings, 3.0f, 10000.0f);
+    QCOMPARE(chunks.count(), static_cast<qsizetype>(1));
+
+    const OsmParser::MeshChunk &chunk = chunks.first();
+    const qsizetype vertexCount = chunk.vertexData.size() / static_cast<qsizetype>(3 * sizeof(float));
+    const qsizetype indexCount = chunk.indexData.size() / static_cast<qsizetype>(sizeof(uint32_t));
+    QCOMPARE(vertexCount, static_cast<qsizetype>(2 * (5 + 5 + 5)));
+    QCOMPARE(indexCount % 3, static_cast<qsizetype>(0));
+    const uint32_t *indices = reinterpret_cast<const uint32_t*>(chunk.indexData.constData());
+    for (qsizetype i = 0; i < indexCount; i++) {
+        QVERIFY(indices[i] < static_cast<uint32_t>(vertexCount));
+    }
+
+    // The multipolygon has two levels
+    QCOMPARE(chunk.boundsMin.z(), 0.0f);
+    QCOMPARE(chunk.boundsMax.z(), 6.0f);
+    QVERIFY(chunk.boundsMax.x() > chunk.boundsMin.x());
+    QVERIFY(chunk.boundsMax.y() > chunk.boundsMin.y());
+
+    // The buildings are several hundred meters apart
+    chunks = OsmParser::buildMeshChunks(buildings, 3.0f, 100.0f);
+    QCOMPARE(chunks.count(), static_cast<qsizetype>(2));
+    qsizetype splitIndexCount = 0;
+    for (const OsmParser::MeshChunk &splitChunk : chunks) {
+        splitIndexCount += splitChunk.indexData.size() / static_cast<qsizetype>(sizeof(uint32_t));
+    }
+    QCOMPARE(splitIndexCount, indexCount);
+}
+
+void OsmParserTest::_testOutOfOrderNodes()
+{
+    // Node ids go down and nodes follow ways, so later nodes must still be found after the first way looked one up
+    const QByteArray osm = R"(<?xml version="1.0" encoding="UTF-8"?>
+<osm version="0.6">
+ <bounds minlat="47.0000" minlon="8.0000" maxlat="47.0100" maxlon="8.0100"/>
+ <node id="24" lat="47.0020" lon="8.0010"/>
+ <node id="23" lat="47.0020" lon="8.0020"/>
+ <node id="22" lat="47.0010" lon="8.0020"/>
+ <node id="21" lat="47.0010" lon="8.0010"/>
+ <way id="300">
+  <nd ref="21"/><nd ref="22"/><nd ref="23"/><nd ref="24"/><nd ref="21"/>
+  <tag k="building" v="yes"/>
+ </way>
+ <node id="14" lat="47.0080" lon="8.0050"/>
+ <node id="11" lat="47.0050" lon="8.0050"/>
+ <node id="13" lat="47.0080" lon="8.0080"/>
+ <node id="12" lat="47.0050" lon="8.0080"/>
+ <way id="301">
+  <nd ref="11"/><nd ref="12"/><nd ref="13"/><nd ref="14"/><nd ref="11"/>
+  <tag k="building" v="yes"/>
+ </way>
+ <node id="1" lat="47.0060" lon="8.0010"/>
+ <node id="3" lat="47.0070" lon="8.0020"/>
+ <node id="2" lat="47.0060" lon="8.0020"/>
+ <node id="4" lat="47.0070" lon="8.0010"/>
+ <way id="302">
+  <nd ref="1"/><nd ref="2"/><nd ref="3"/><nd ref="4"/><nd ref="1"/>
+  <tag k="building" v="yes"/>
+ </way>
+</osm>
+)";
+
+    QBuffer buffer;
+    buffer.setData(osm);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    QHash<uint64_t, OsmParserThread::BuildingType_t> buildings;
+    QGeoCoordinate coordinateMin, coordinateMax, gpsRef;
+    QVERIFY(OsmParserThread::decodeStream(buffer, buildings, coordinateMin, coordinateMax, gpsRef));
+
+    QCOMPARE(buildings.count(), static_cast<qsizetype>(3));
+    for (const uint64_t wayId : { 300, 301, 302 }) {
+        QVERIFY(buildings.contains(wayId));
+        QCOMPARE(buildings[wayId].points_local.size(), size_t(5));
+    }
+
+    // The last node read is placed where it belongs
+    const OsmParserThread::BuildingType_t &building = buildings[302];
+    QVERIFY(qAbs(building.points_gps[3].latitude() - 47.007) < 1e-9);
+    QVERIFY(qAbs(building.points_gps[3].longitude() - 8.001) < 1e-9);
+}